@@ -223,13 +223,15 @@ __BEGIN_DECLS
 #define DB_FULL_PATH_MAGIC		0x64626670 /**< dbfp */
 #define DM_MAGIC			0x444d4d4d /**< DMMM */
 #define LIGHT_MAGIC			0xdbddbdb7 /**< ???? */
-#define MF_MAGIC			0x55968058 /**< U??X */
+#define MF_MAGIC			0x55968059 /**< U??Y */
+#define MF_MAGIC_V1			0x55968058 /**< U??X */
 #define PIXEL_EXT_MAGIC 		0x50787400 /**< Pxt  */
 #define PL_MAGIC        		0x0beef00d /**< ???? => mm. bee food. */
 #define PT_HD_MAGIC			0x87687680 /**< ?hv? */
 #define PT_MAGIC			0x87687681 /**< ?hv? */
 #define RESOURCE_MAGIC			0x83651835 /**< ?e?5 */
 #define RTI_MAGIC			0x99101658 /**< ???X */
+#define SHADE_BATCH_MAGIC		0x73686274 /**< shbt */
 #define WDB_METABALLPT_MAGIC		0x6d627074 /**< mbpt */
 #define WDB_PIPESEG_MAGIC		0x9723ffef /**< ?\#?? */
 #define WMEMBER_MAGIC			0x43128912 /**< C??? */
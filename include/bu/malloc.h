@@ -142,6 +142,25 @@ BU_EXPORT extern void *bu_realloc(void *ptr,
  */
 BU_EXPORT extern size_t bu_malloc_len_roundup(size_t nbytes);
 
+/**
+ * Net number of bytes currently held through bu_malloc(),
+ * bu_calloc() and bu_realloc() by the bu_parallel() thread numbered
+ * 'cpu' (see bu_parallel_id()), or by all threads if 'cpu' is
+ * negative.
+ *
+ * Memory released by a different thread than allocated it moves the
+ * count from one thread to the other, so a single thread's count is
+ * only meaningful as a difference taken across work it did itself.
+ * When a bu_parallel() call returns, what each of its threads still
+ * holds is moved to the thread that made the call, so that work
+ * includes any nested bu_parallel() (and bu_numa_run()) it did.
+ * Threads not started by libbu, and parallel IDs of MAX_PSW or more,
+ * share the count of thread 0.
+ * Where the C library cannot report the size of an allocation,
+ * releases are not counted and the result is the total allocated.
+ */
+BU_EXPORT extern ssize_t bu_malloc_bytes(int cpu);
+
 /**
  * really fast heap-based memory allocation intended for "small"
  * allocation sizes (e.g., single structs).
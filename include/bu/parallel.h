@@ -138,9 +138,12 @@ BU_EXPORT extern size_t bu_avail_cpus(void);
  * Threads created with bu_parallel() may specify utilization of
  * affinity locking to keep threads on a given physical CPU core.
  * This behavior can be enabled at runtime by setting the environment
- * variable LIBBU_AFFINITY=1.  Note that this option may increase or
- * even decrease performance, particularly on platforms with advanced
- * scheduling, so testing is recommended.
+ * variable LIBBU_AFFINITY=1.  On NUMA systems LIBBU_AFFINITY=compact
+ * fills the processors of one node before using the next, while
+ * LIBBU_AFFINITY=spread alternates threads across the nodes.  Note
+ * that this option may increase or even decrease performance,
+ * particularly on platforms with advanced scheduling, so testing is
+ * recommended.
  *
  * This function will not return control until all invocations of the
  * subroutine are finished.
@@ -183,6 +186,35 @@ BU_EXPORT extern size_t bu_avail_cpus(void);
  */
 BU_EXPORT extern void bu_parallel(void (*func)(int func_cpu_id, void *func_data), size_t ncpu, void *data);
 
+/**
+ * Return the number of NUMA nodes holding processors available to
+ * this process, 1 when the topology is unknown.
+ */
+BU_EXPORT extern int bu_numa_nodes(void);
+
+/**
+ * Return the NUMA node, from 0 to bu_numa_nodes()-1, of the processor
+ * the calling thread is currently running on.
+ */
+BU_EXPORT extern int bu_numa_node(void);
+
+/**
+ * Bind the calling thread to the processors of NUMA node 'node', from
+ * 0 to bu_numa_nodes()-1.  Threads it starts afterwards inherit the
+ * binding where the platform supports it.  Returns 0 on success, -1
+ * if the node does not exist or the binding failed.
+ */
+BU_EXPORT extern int bu_numa_bind(int node);
+
+/**
+ * Call 'func' once for every NUMA node, each from a thread bound to
+ * the processors of that node.  Memory allocated and first written by
+ * 'func' is then local to the node, which is how read-mostly data can
+ * be replicated per node.  With a single node, 'func' is simply
+ * called with node 0 from the calling thread.
+ */
+BU_EXPORT extern void bu_numa_run(void (*func)(int node, void *data), void *data);
+
 
 /**
  * @brief
@@ -427,6 +427,7 @@ struct bview_settings {
     fastf_t       point_scale;
     int           redraw_on_zoom;
     fastf_t 	  lod_scale;
+    fastf_t       lod_pixel_threshold; // objects smaller than this on screen are drawn as placeholders (0 disables)
 
     // Faceplate elements fall into two general categories: those which are
     // interactively adjusted (in a geometric sense) and those which are not.
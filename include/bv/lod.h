@@ -60,11 +60,42 @@ bv_view_objs_select(struct bu_ptbl *sset, struct bview *v, int x, int y);
 BV_EXPORT int
 bv_view_objs_rect_select(struct bu_ptbl *sset, struct bview *v, int x1, int y1, int x2, int y2);
 
+/* Number of detail levels used by the LoD routines.  Level 0 is the coarsest
+ * representation of an object. */
+#define BV_LOD_MAXLEVEL 16
+
+/**
+ * Estimate the size, in pixels, of the scene object's bounding box as drawn
+ * in view v.  Perspective views are taken into account, so distant objects
+ * report smaller sizes.  If the object surrounds the eye point MAX_FASTF is
+ * returned.  Returns a negative value if the view doesn't know its window
+ * dimensions.
+ */
+BV_EXPORT fastf_t
+bv_scene_obj_screen_size(struct bv_scene_obj *s, struct bview *v);
+
+/**
+ * Scene level LoD policy.  Based on the screen size of s in v (see
+ * bv_scene_obj_screen_size), returns the detail level (0 to BV_LOD_MAXLEVEL-1)
+ * needed to draw it without visible loss of detail.  If the object covers
+ * fewer than the view's lod_pixel_threshold pixels, -1 is returned to
+ * indicate it may be drawn as a placeholder (e.g. its bounding box.)
+ *
+ * The mesh LoD routines use this to cap their level selection, and adaptive
+ * CSG drawing uses it to decide when to skip full wireframe generation.
+ */
+BV_EXPORT int
+bv_scene_obj_lod_level(struct bv_scene_obj *s, struct bview *v);
+
 /* Storing and reading from a lot of small, individual files doesn't work very
  * well on some platforms.  We provide a "context" to manage bookkeeping of data
  * across objects. The details are implementation internal - the application
  * will simply create a context with a file name and provide it to the various
- * LoD calls. */
+ * LoD calls.
+ *
+ * A context may be shared between threads - bv_mesh_lod_cache and the key
+ * get/put calls may be used to populate the cache from multiple workers
+ * concurrently. */
 struct bv_mesh_lod_context_internal;
 struct bv_mesh_lod_context {
     struct bv_mesh_lod_context_internal *i;
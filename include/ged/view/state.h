@@ -143,6 +143,7 @@ struct draw_update_data_t {
     const struct bg_tess_tol *ttol;
     struct bv_mesh_lod_context *mesh_c;
     struct resource *res;
+    int lod_placeholder;	/* adaptive CSG: below the LoD pixel threshold at the last update */
 };
 
 
@@ -53,9 +53,17 @@ typedef enum {
     /* Add here for format addition like CMYKA, HSV, others  */
 } ICV_COLOR_SPACE;
 
+/**
+ * Pixel value types.  Images store double values by default, but may
+ * instead keep their pixels in one of the narrower types (see
+ * icv_create_typed()).  Integer types map their full range onto
+ * [0, 1], so an 8-bit value of 255 reads as 1.0.
+ */
 typedef enum {
     ICV_DATA_DOUBLE,
-    ICV_DATA_UCHAR
+    ICV_DATA_UCHAR,
+    ICV_DATA_USHORT,
+    ICV_DATA_FLOAT
 } ICV_DATA;
 
 /* Define Various Flags */
@@ -67,10 +75,12 @@ typedef enum {
 struct icv_image {
     uint32_t magic;
     ICV_COLOR_SPACE color_space;
-    double *data;
+    double *data;		/**< pixel values, when data_type is ICV_DATA_DOUBLE */
     float gamma_corr;
     size_t width, height, channels, alpha_channel;
     uint16_t flags;
+    ICV_DATA data_type;		/**< how the pixels are stored */
+    void *pixels;		/**< pixel values for the other data types */
 };
 
 
@@ -90,6 +100,8 @@ typedef struct icv_image icv_image_t;
 	(_i)->width = (_i)->height = (_i)->channels = (_i)->alpha_channel = 0; \
 	(_i)->gamma_corr = 0.0; \
 	(_i)->data = NULL; \
+	(_i)->data_type = ICV_DATA_DOUBLE; \
+	(_i)->pixels = NULL; \
     }
 
 /**
@@ -49,6 +49,35 @@ __BEGIN_DECLS
  */
 ICV_EXPORT extern icv_image_t *icv_create(size_t width, size_t height, ICV_COLOR_SPACE color_space);
 
+/**
+ * Like icv_create(), but the pixels are stored as the given type
+ * rather than as doubles.  An 8-bit image takes an eighth of the
+ * memory of the same image held as doubles.
+ *
+ * The data member of such an image is NULL; its pixels are held in
+ * the pixels member instead.  The arithmetic, filter, fade and resize
+ * operations work directly on the narrower types, clamping integer
+ * results to [0, 1].  Other operations first convert the image to
+ * double storage with icv_convert().
+ *
+ * @param width Width of the image to be created
+ * @param height Height of the image to be created
+ * @param color_space Color space of the image (RGB, grayscale)
+ * @param type Storage type for the pixel values
+ * @return Image structure with allocated space and zeroed data array
+ */
+ICV_EXPORT extern icv_image_t *icv_create_typed(size_t width, size_t height, ICV_COLOR_SPACE color_space, ICV_DATA type);
+
+/**
+ * Change how the pixels of an image are stored.  Values outside
+ * [0, 1] are clamped when converting to an integer type.
+ *
+ * @param bif Image to convert in place
+ * @param type New storage type
+ * @return on success 0, on failure -1
+ */
+ICV_EXPORT extern int icv_convert(icv_image_t *bif, ICV_DATA type);
+
 /**
  * This function zeroes all the data entries of an image
  * @param bif Image Structure
@@ -123,8 +152,10 @@ ICV_EXPORT extern icv_image_t *icv_read(const char *filename, bu_mime_image_t fo
 ICV_EXPORT extern int icv_write(icv_image_t *bif, const char*filename, bu_mime_image_t format);
 
 /**
- * Write an image line to the data of ICV struct. Can handle unsigned
- * char buffers.
+ * Write an image line to the data of ICV struct.  The line may be
+ * given in any ICV_DATA type, whatever the image's own storage type:
+ * 8-bit and 16-bit values are scaled to 0..1, while float and double
+ * values are taken as they are.
  *
  * Note : This function requires memory allocation for ICV_UCHAR_DATA,
  * which in turn acquires BU_SEM_SYSCALL semaphore.
@@ -134,7 +165,7 @@ ICV_EXPORT extern int icv_write(icv_image_t *bif, const char*filename, bu_mime_i
  * the first line
  * @param data Line Data to be written
  * @param type Type of data, e.g., uint8 data specify ICV_DATA_UCHAR or 1
- * @return on success 0, on failure -1
+ * @return on success 0, on failure (including y past the last line) -1
  */
 ICV_EXPORT int icv_writeline(icv_image_t *bif, size_t y, void *data, ICV_DATA type);
 
@@ -180,6 +211,80 @@ ICV_EXPORT unsigned char *icv_data2uchar(const icv_image_t *bif);
 ICV_EXPORT double *icv_uchar2double(unsigned char *data, size_t size);
 
 
+/**
+ * An image file opened for reading or writing one line at a time,
+ * so that images too large to hold in memory can be converted or
+ * compared.  PIX, BW and PNG files can be streamed.
+ *
+ * Lines are numbered as in icv_writeline(), with line 0 at the
+ * bottom of the image, and carry 8 bits per channel.  PIX and BW
+ * files may be visited in any order when the file is seekable.  PNG
+ * files keep their top line first, and so must be visited strictly
+ * from line height-1 down to line 0.
+ */
+typedef struct icv_stream icv_stream_t;
+
+/**
+ * Open an image file for streamed reading.  For PIX and BW files a
+ * zero width or height is deduced from the file size, as
+ * icv_image_size() would.  Returns NULL if the file can not be
+ * opened or its format can not be streamed.
+ */
+ICV_EXPORT extern icv_stream_t *icv_stream_open(const char *filename, bu_mime_image_t format, size_t width, size_t height);
+
+/**
+ * Create an image file of the given size for streamed writing.
+ * Returns NULL if the file can not be created or its format can not
+ * be streamed.
+ */
+ICV_EXPORT extern icv_stream_t *icv_stream_create(const char *filename, bu_mime_image_t format, size_t width, size_t height);
+
+/**
+ * Report the dimensions of a streamed image.  Any of the output
+ * pointers may be NULL.
+ */
+ICV_EXPORT extern void icv_stream_size(const icv_stream_t *s, size_t *width, size_t *height, size_t *channels);
+
+/**
+ * Read line y into data, which must hold width*channels bytes.
+ * @return on success 0, on failure -1
+ */
+ICV_EXPORT extern int icv_stream_readline(icv_stream_t *s, size_t y, unsigned char *data);
+
+/**
+ * Write width*channels bytes from data as line y.
+ * @return on success 0, on failure -1
+ */
+ICV_EXPORT extern int icv_stream_writeline(icv_stream_t *s, size_t y, const unsigned char *data);
+
+/**
+ * Finish and close a stream.  For written streams, fails if any
+ * line was never written or the file could not be completed.
+ * @return on success 0, on failure -1
+ */
+ICV_EXPORT extern int icv_stream_close(icv_stream_t *s);
+
+/**
+ * Copy every line of in to out, which must have the same width and
+ * height.  Gray lines are expanded to RGB and RGB lines averaged to
+ * gray as needed.  Only a band of lines is held in memory at once.
+ * @return on success 0, on failure -1
+ */
+ICV_EXPORT extern int icv_stream_copy(icv_stream_t *out, icv_stream_t *in);
+
+/**
+ * Streamed version of icv_diff(), comparing two image files a line
+ * at a time.  Counts are the same as icv_diff() would report for
+ * images of the same width; pixels of the taller image that have no
+ * counterpart count as off by many.  Images of different widths are
+ * not compared pixel by pixel, and every pixel of the larger counts
+ * as off by many.
+ *
+ * @return 0 if the images match, 1 if they differ, -1 on error
+ */
+ICV_EXPORT extern int icv_stream_diff(int *matching, int *off_by_1, int *off_by_many, icv_stream_t *s1, icv_stream_t *s2);
+
+
 /** @} */
 
 __END_DECLS
@@ -76,6 +76,33 @@ wraypaint(vect_t start, vect_t norm, int paint, struct application *app, FILE *f
 OPTICAL_EXPORT extern int
 viewshade(struct application *app, const struct partition *pp, struct shadework *swp);
 
+/**
+ * Batched counterpart of viewshade().  shade_batch_add() prepares one
+ * shading point exactly as viewshade() would and appends it to the
+ * batch; viewshade_batch() then groups the points by region and hands
+ * each group to the region shader's mf_render_batch routine, falling
+ * back to calling mf_render once per point for shaders without one.
+ * The shadework structures passed to shade_batch_add() must remain
+ * valid until viewshade_batch() returns.
+ */
+OPTICAL_EXPORT extern void
+shade_batch_init(struct shade_batch *sbp, size_t max);
+
+OPTICAL_EXPORT extern void
+shade_batch_free(struct shade_batch *sbp);
+
+OPTICAL_EXPORT extern int
+shade_batch_add(struct shade_batch *sbp, struct application *app, const struct partition *pp, struct shadework *swp);
+
+OPTICAL_EXPORT extern void
+shade_batch_gather(struct shade_batch *sbp, const size_t *idx, size_t n);
+
+OPTICAL_EXPORT extern void
+shade_batch_render(struct shade_batch *sbp, const size_t *idx, size_t n, const struct mfuncs *mfp, void *dp);
+
+OPTICAL_EXPORT extern int
+viewshade_batch(struct shade_batch *sbp);
+
 /* defined in vers.c */
 OPTICAL_EXPORT extern const char *optical_version(void);
 
@@ -35,8 +35,52 @@
 #include "optical/defines.h"
 #include "optical/shadework.h"
 
+/**
+ * A batch of shading points, stored as structure-of-arrays so that
+ * shaders which opt in through mf_render_batch can run the whole
+ * batch through tight loops instead of one partition at a time.
+ *
+ * Points are added with shade_batch_add(), which performs the same
+ * per-point setup as viewshade() and then copies the hit point,
+ * normal, ray direction and UV into the sb_pos/sb_norm/sb_dir/sb_uv
+ * columns.  The caller's shadework structures remain the place where
+ * results (sw_color, sw_transmit, ...) are returned.
+ *
+ * sb_sel and sb_tmp[] are scratch space for mf_render_batch routines,
+ * sized like the other columns.  Their contents do not survive a call
+ * into another shader.
+ */
+#define SHADE_BATCH_NTMP 20
+
+struct shade_batch {
+    uint32_t sb_magic;
+    size_t sb_len;			/**< @brief number of points in the batch */
+    size_t sb_max;			/**< @brief number of points allocated */
+    struct application **sb_ap;		/**< @brief per-point application */
+    const struct partition **sb_pp;	/**< @brief per-point partition */
+    struct shadework **sb_sw;		/**< @brief per-point shadework (results) */
+    int *sb_regid;			/**< @brief per-point region (reg_bit) */
+    int *sb_status;			/**< @brief per-point mf_render style return */
+    fastf_t *sb_pos[3];			/**< @brief hit points, X/Y/Z columns */
+    fastf_t *sb_norm[3];		/**< @brief surface normals, X/Y/Z columns */
+    fastf_t *sb_dir[3];			/**< @brief ray directions, X/Y/Z columns */
+    fastf_t *sb_uv[2];			/**< @brief U/V columns */
+    size_t *sb_order;			/**< @brief point indices grouped by region */
+    size_t *sb_sel;			/**< @brief scratch index column for batch shaders */
+    fastf_t *sb_tmp[SHADE_BATCH_NTMP];	/**< @brief scratch columns for batch shaders */
+};
+#define RT_CK_SHADE_BATCH(_p)	BU_CKMAG(_p, SHADE_BATCH_MAGIC, "shade_batch")
+
 /**
  *  The interface to the various material property & texture routines.
+ *
+ *  Adding mf_render_batch changed the size of this structure, so
+ *  shader tables compiled against the older layout can no longer be
+ *  walked as arrays of struct mfuncs.  Tables using the current
+ *  layout carry MF_MAGIC; older ones still carry MF_MAGIC_V1, and
+ *  dynamically loaded shader libraries tagged that way are refused
+ *  with a request to rebuild them.  Shaders without a batch routine
+ *  simply leave mf_render_batch NULL.
  */
 struct mfuncs {
     uint32_t mf_magic;		/**< @brief To validate structure */
@@ -56,6 +100,10 @@ struct mfuncs {
     void (*mf_print)(struct region *rp,
 		     void *dp);	/**< @brief Routine for printing */
     void (*mf_free)(void *cp);	/**< @brief Routine for releasing storage */
+    int (*mf_render_batch)(struct shade_batch *sbp,
+			   const size_t *idx,
+			   size_t n,
+			   void *dp);	/**< @brief Optional, render the n points idx[] of a batch */
 };
 #define MF_NULL		((struct mfuncs *)0)
 #define RT_CK_MF(_p)	BU_CKMAG(_p, MF_MAGIC, "mfuncs")
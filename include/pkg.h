@@ -82,6 +82,28 @@ struct pkg_header {
     unsigned char pkh_len[4];	/**< @brief Byte count of remainder */
 };
 
+/**
+ * Header magic of an LZ4 compressed message.  The body is the
+ * original byte count (4 bytes, network order) followed by a single
+ * LZ4 block.  Such messages are only ever sent to a peer that has
+ * announced it can decode them, and are inflated before any handler
+ * or pkg_waitfor() caller sees them.
+ */
+#define PKG_MAGIC_LZ4	0x41FF
+
+/**
+ * Message type reserved for libpkg's own connection negotiation.
+ * Never delivered to user handlers; applications must not use it.
+ */
+#define PKG_TYPE_CTL	0xFFFF
+
+/** Capability bits exchanged in PKG_TYPE_CTL messages */
+#define PKG_CAP_LZ4	0x1	/**< @brief peer decodes PKG_MAGIC_LZ4 messages */
+
+/** Connection options, see pkg_options() */
+#define PKG_OPT_LZ4	0x1	/**< @brief compress large messages if the peer can decode them */
+#define PKG_OPT_NOPOLL	0x2	/**< @brief never read input from the send path */
+
 #define	PKG_STREAMLEN	(32*1024)
 struct pkg_conn {
     int	pkc_fd;					/**< @brief TCP connection fd */
@@ -118,6 +140,14 @@ struct pkg_conn {
     char *pkc_buf;				/**< @brief start of dynamic buf */
     char *pkc_curpos;				/**< @brief current position in pkg_buf */
     void *pkc_server_data;			/**< @brief used to hold server data for callbacks */
+    /* CONNECTION OPTIONS AND SEND STATE */
+    unsigned int pkc_opts;			/**< @brief PKG_OPT_* flags */
+    unsigned int pkc_peer_caps;			/**< @brief PKG_CAP_* flags announced by peer */
+    int pkc_caps_sent;				/**< @brief our capabilities have been announced */
+    size_t pkc_unpolled;			/**< @brief bytes sent since input was last polled */
+    void *pkc_lock;				/**< @brief serializes output on this connection */
+    char *pkc_zbuf;				/**< @brief compression scratch buffer */
+    size_t pkc_zlen;				/**< @brief size of pkc_zbuf */
 };
 #define PKC_NULL	((struct pkg_conn *)0)
 #define PKC_ERROR	((struct pkg_conn *)(-1L))
@@ -189,6 +219,29 @@ PKG_EXPORT extern int pkg_suckin(struct pkg_conn *);
  */
 PKG_EXPORT extern int pkg_send(int type, const char *buf, size_t len, struct pkg_conn* pc);
 
+/**
+ * One piece of a scatter/gather message, see pkg_sendv().
+ */
+struct pkg_iovec {
+    const void *iov_base;	/**< @brief start of this piece */
+    size_t iov_len;		/**< @brief byte count of this piece */
+};
+
+/** Most pieces pkg_sendv() accepts in one message */
+#define PKG_IOV_MAX	32
+
+/**
+ * Send a message gathered from iovcnt disjoint buffers.
+ *
+ * The pieces go to the kernel in a single writev() without being
+ * copied, and arrive at the peer as one message of the combined
+ * length.  pkg_send() and pkg_2send() are the one and two piece
+ * forms of this call.
+ *
+ * Returns number of bytes of user data actually sent, or -1 on error.
+ */
+PKG_EXPORT extern int pkg_sendv(int type, const struct pkg_iovec *iov, int iovcnt, struct pkg_conn* pc);
+
 /**
  * Send a two part message on the connection.
  *
@@ -220,6 +273,30 @@ PKG_EXPORT extern int pkg_stream(int type, const char *buf, size_t len, struct p
  */
 PKG_EXPORT extern int pkg_flush(struct pkg_conn* pc);
 
+/**
+ * Set the PKG_OPT_* options of a connection, returning the previous
+ * set.
+ *
+ * Enabling PKG_OPT_LZ4 announces to the peer that this end can
+ * decode compressed messages; a peer built with this libpkg answers
+ * in kind, and from then on messages larger than a few hundred bytes
+ * that compress are sent as PKG_MAGIC_LZ4 frames.  An older peer
+ * logs a single unknown message and the connection carries on
+ * uncompressed.  Call this right after the connection is opened.
+ *
+ * PKG_OPT_NOPOLL stops the send routines from opportunistically
+ * reading pending input, which they otherwise do to keep both ends of
+ * a busy connection from blocking on full socket buffers.
+ *
+ * Threading: the send routines (pkg_send(), pkg_2send(), pkg_sendv(),
+ * pkg_stream(), pkg_flush()) may be called concurrently from any
+ * number of threads; each message goes out whole.  Input processing
+ * (pkg_process(), pkg_block(), pkg_waitfor(), pkg_suckin()) must stay
+ * on a single thread, and when that is not one of the sending threads
+ * PKG_OPT_NOPOLL must be set so senders never touch the input buffer.
+ */
+PKG_EXPORT extern unsigned int pkg_options(struct pkg_conn *pc, unsigned int opts);
+
 /**
  * Wait for a specific msg, user buf, processing others.
  *
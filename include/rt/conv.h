@@ -32,6 +32,35 @@
 
 __BEGIN_DECLS
 
+/**
+ * Tessellating the leaves of a tree one at a time, in region order,
+ * repeats the work for every leaf that is referenced more than once.
+ * When a db_tree_state has a ts_tess_cache, rt_booltree_leaf_tess()
+ * keeps the tessellation of each leaf keyed by primitive, matrix and
+ * tolerances, and hands later uses of the same leaf a copy.  Leaves
+ * whose matrices differ only by a translation (the usual instanced
+ * part) share one tessellation.
+ *
+ * rt_tess_cache_prime() fills the cache by walking the trees with
+ * several CPUs, so a following serial walk (which must combine and
+ * write out regions in order) only has to copy tessellations.
+ */
+RT_EXPORT extern struct rt_tess_cache *rt_tess_cache_create(void);
+RT_EXPORT extern void rt_tess_cache_destroy(struct rt_tess_cache *cache);
+
+/**
+ * Tessellate the leaves of the given trees into the cache, with up to
+ * ncpu threads.  The tolerances and initial state are taken from
+ * init_state, which should match the state of the walk that will use
+ * the cache.  Returns the db_walk_tree() result.
+ */
+RT_EXPORT extern int rt_tess_cache_prime(struct rt_tess_cache *cache,
+					 struct db_i *dbip,
+					 int argc,
+					 const char **argv,
+					 int ncpu,
+					 const struct db_tree_state *init_state);
+
 RT_EXPORT extern union tree *rt_booltree_leaf_tess(struct db_tree_state *tsp,
 						    const struct db_full_path *pathp,
 						    struct rt_db_internal *ip,
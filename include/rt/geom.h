@@ -580,6 +580,9 @@ struct rt_dsp_internal{
 				 * computed from dsp_mtos */
     unsigned short *dsp_buf;	/**< @brief actual data */
     struct bu_mapped_file *dsp_mp;	/**< @brief mapped file for data */
+    const unsigned char *dsp_tiles;	/**< @brief tiled data in dsp_mp, NULL
+					 * when dsp_buf holds the data */
+    unsigned int dsp_tile_shift;	/**< @brief log2 of tile width (tiled data) */
     struct rt_db_internal *dsp_bip;	/**< @brief db object for data */
 #define RT_DSP_SRC_V4_FILE '4'
 #define RT_DSP_SRC_FILE 'f'
@@ -65,6 +65,43 @@ RT_EXPORT extern int re_prep_solids(struct rt_i *rtip,
 				    char **solid_names,
 				    struct resource *resp);
 
+/**
+ * Memory held by a prepped model.  Prep is measured as the change in
+ * the prepping thread's bu_malloc_bytes() count, so memory a prep
+ * routine hands off to other threads is not seen.
+ */
+struct rt_mem_info {
+    size_t prep_bytes[ID_MAX_SOLID+1];  /**< @brief  held by prep, by st_id (ID_NULL is shared preps) */
+    size_t prep_count[ID_MAX_SOLID+1];  /**< @brief  # of solids, by st_id */
+    size_t prep_total;                  /**< @brief  held by prep of all solids */
+    size_t cut_bytes;                   /**< @brief  held by space partitioning */
+    size_t resource_bytes;              /**< @brief  held by the per-CPU resource pools */
+    size_t total;                       /**< @brief  sum of the above */
+};
+
+/* mem_info.c */
+
+struct region; /* forward declaration */
+
+/**
+ * Fill in 'info' with the memory held by the prepped model 'rtip'.
+ */
+RT_EXPORT extern void rt_mem_info(struct rt_mem_info *info,
+				  const struct rt_i *rtip);
+
+/**
+ * Bytes held by the prep of the solids in a region's boolean tree.
+ * Solids shared with other regions are counted in each of them.
+ */
+RT_EXPORT extern size_t rt_region_mem(const struct region *regp);
+
+/**
+ * Log the rt_mem_info() of 'rtip', followed by the 'nregions'
+ * regions holding the most memory.
+ */
+RT_EXPORT extern void rt_pr_mem_info(const struct rt_i *rtip,
+				     size_t nregions);
+
 
 __END_DECLS
 
@@ -65,6 +65,8 @@ struct rt_i {
     int                 rti_save_overlaps; /**< @brief  1=fill in pt_overlap_reg, change boolweave behavior */
     int                 rti_dont_instance; /**< @brief  1=Don't compress instances of solids into 1 while prepping */
     int                 rti_hasty_prep; /**< @brief  1=hasty prep, slower ray-trace */
+    int                 rti_instance_prep; /**< @brief  1=share one prep among rigidly moved placements of a solid */
+    size_t              rti_mem_budget; /**< @brief  bytes prep and space partitioning may hold, 0=no limit */
     size_t              rti_nlights;    /**< @brief  number of light sources */
     int                 rti_prismtrace; /**< @brief  add support for pixel prism trace */
     char *              rti_region_fix_file; /**< @brief  rt_regionfix() file or NULL */
@@ -126,6 +128,13 @@ struct rt_i {
     /* Parameters for dynamic geometry */
     int                 rti_add_to_new_solids_list;
     struct bu_ptbl      rti_new_solids;
+    /* Memory accounting, see rt_mem_info() */
+    size_t              rti_prep_bytes; /**< @brief  bytes held by prepped solids */
+    size_t              rti_cut_bytes;  /**< @brief  bytes held by space partitioning */
+    size_t              rti_mem_dropped; /**< @brief  # solids not prepped for lack of budget */
+    /* NUMA replication, see LIBRT_NUMA_REPLICATE */
+    union cutter **     rti_numa_cut;   /**< @brief  per node copies of rti_CutHead, NULL if not replicated */
+    int                 rti_numa_nodes; /**< @brief  # of entries in rti_numa_cut */
 };
 
 
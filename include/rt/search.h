@@ -105,6 +105,12 @@ __BEGIN_DECLS
  * it will assume you wanted a tops list, which has a good chance of returning
  * unwanted results.
  *
+ * Unless DB_SEARCH_SERIAL is set, the starting paths are distributed
+ * across bu_parallel threads and the results are merged in path_v
+ * order, so the output matches that of a serial search.  Plans using
+ * -exec are always evaluated serially.  The LIBRT_SEARCH_NCPU
+ * environment variable overrides the number of threads used.
+ *
  */
 RT_EXPORT extern int db_search(struct bu_ptbl *results,
 			       int flags,
@@ -124,6 +130,7 @@ RT_EXPORT extern int db_search(struct bu_ptbl *results,
 #define DB_SEARCH_RETURN_UNIQ_DP   0x4   /**< @brief Return the set of unique directory pointers instead of full paths */
 #define DB_SEARCH_QUIET            0x8   /**< @brief Silence all warnings */
 #define DB_SEARCH_PRINT_TOTAL	   0x10	 /**< @brief Print total number of items found in search */
+#define DB_SEARCH_SERIAL           0x20  /**< @brief Evaluate the search on a single thread */
 
 /**
  * Properly free the table contents returned by db_search.  The bu_ptbl
@@ -75,6 +75,7 @@ struct soltab {
     long                        st_npieces;     /**< @brief #  pieces used by this solid */
     long                        st_piecestate_num; /**< @brief re_pieces[] subscript */
     struct bound_rpp *          st_piece_rpps;  /**< @brief bounding RPP of each piece of this solid */
+    size_t                      st_prep_bytes;  /**< @brief bytes held by this solid's prep */
 };
 #define st_name         st_dp->d_namep
 #define RT_SOLTAB_NULL  ((struct soltab *)0)
@@ -27,6 +27,9 @@
 
 #include "common.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "vmath.h"
 
 __BEGIN_DECLS
@@ -135,6 +138,8 @@ RT_EXPORT extern fastf_t TIE_PREC;
 #define TIE_PUSH TIE_VAL(tie_push)
 #define TIE_KDTREE_PREP TIE_VAL(tie_kdtree_prep)
 #define TIE_KDTREE_FREE TIE_VAL(tie_kdtree_free)
+#define TIE_CACHE_SAVE TIE_VAL(tie_cache_save)
+#define TIE_CACHE_LOAD TIE_VAL(tie_cache_load)
 
 RT_EXPORT extern void TIE_INIT(struct tie_s *tie, unsigned int tri_num, unsigned int kdmethod);
 RT_EXPORT extern void TIE_FREE(struct tie_s *tie);
@@ -143,6 +148,8 @@ RT_EXPORT extern void*TIE_WORK(struct tie_s *tie, struct tie_ray_s *ray, struct
 RT_EXPORT extern void TIE_PUSH(struct tie_s *tie, TIE_3 **tlist, unsigned int tnum, void *plist, unsigned int pstride);
 RT_EXPORT extern void TIE_KDTREE_FREE(struct tie_s *tie);
 RT_EXPORT extern void TIE_KDTREE_PREP(struct tie_s *tie);
+RT_EXPORT extern int TIE_CACHE_SAVE(struct tie_s *tie, const char *path, uint64_t key, void **ptrs, unsigned int nptrs, const void *user, size_t user_len);
+RT_EXPORT extern int TIE_CACHE_LOAD(struct tie_s *tie, const char *path, uint64_t key, int (*ptrs_func)(const void *user, size_t user_len, void **ptrs, unsigned int nptrs, void *data), void *data);
 
 __END_DECLS
 
@@ -48,6 +48,7 @@ struct resource;  /* forward declaration */
 struct rt_i;      /* forward declaration */
 struct rt_comb_internal;      /* forward declaration */
 struct rt_db_internal;      /* forward declaration */
+struct rt_tess_cache;      /* forward declaration */
 
 /**
  * State for database tree walker db_walk_tree() and related
@@ -90,10 +91,11 @@ struct db_tree_state {
     struct model **             ts_m;           /**< @brief  ptr to ptr to NMG "model" */
     struct rt_i *               ts_rtip;        /**< @brief  Helper for rt_gettrees() */
     struct resource *           ts_resp;        /**< @brief  Per-CPU data */
+    struct rt_tess_cache *      ts_tess_cache;  /**< @brief  Leaf tessellations shared by rt_booltree_leaf_tess() */
 };
-#define RT_DBTS_INIT_ZERO { RT_DBTS_MAGIC, NULL, 0, 0, 0, 0, 0, RT_MATER_INFO_INIT_ZERO, MAT_INIT_ZERO, 0, BU_AVS_INIT_ZERO, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL }
+#define RT_DBTS_INIT_ZERO { RT_DBTS_MAGIC, NULL, 0, 0, 0, 0, 0, RT_MATER_INFO_INIT_ZERO, MAT_INIT_ZERO, 0, BU_AVS_INIT_ZERO, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL }
 /* from mged_initial_tree_state */
-#define RT_DBTS_INIT_IDN { RT_DBTS_MAGIC, NULL, 0, 0, 0, 0, 100, RT_MATER_INFO_INIT_IDN, MAT_INIT_IDN, 0, BU_AVS_INIT_ZERO, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL }
+#define RT_DBTS_INIT_IDN { RT_DBTS_MAGIC, NULL, 0, 0, 0, 0, 100, RT_MATER_INFO_INIT_IDN, MAT_INIT_IDN, 0, BU_AVS_INIT_ZERO, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL }
 
 /* Used to replace old rt_initial_tree_state global */
 #define RT_DBTS_INIT(_p) do {			\
@@ -122,6 +124,7 @@ struct db_tree_state {
     (_p)->ts_m = NULL;				\
     (_p)->ts_rtip = NULL;			\
     (_p)->ts_resp = NULL;			\
+    (_p)->ts_tess_cache = NULL;			\
 } while (0)
 
 #define TS_SOFAR_MINUS  1       /**< @brief  Subtraction encountered above */
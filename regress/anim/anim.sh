@@ -0,0 +1,154 @@
+#!/bin/sh
+#                         A N I M . S H
+# BRL-CAD
+#
+# Copyright (c) 2024 United States Government as represented by
+# the U.S. Army Research Laboratory.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+# 1. Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#
+# 2. Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following
+# disclaimer in the documentation and/or other materials provided
+# with the distribution.
+#
+# 3. The name of the author may not be used to endorse or promote
+# products derived from this software without specific prior written
+# permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+# OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+###
+
+# Ensure /bin/sh
+export PATH || (echo "This isn't sh."; sh $0 $*; kill $$)
+
+# source common library functionality, setting ARGS, NAME_OF_THIS,
+# PATH_TO_THIS, and THIS.
+. "$1/regress/library.sh"
+
+if test "x$LOGFILE" = "x" ; then
+    LOGFILE=`pwd`/anim.log
+    rm -f $LOGFILE
+fi
+log "=== TESTING rt animation with incremental prep ==="
+
+RT="`ensearch rt`"
+if test ! -f "$RT" ; then
+    log "Unable to find rt, aborting"
+    exit 1
+fi
+A2G="`ensearch asc2g`"
+if test ! -f "$A2G" ; then
+    log "Unable to find asc2g, aborting"
+    exit 1
+fi
+PIXDIFF="`ensearch pixdiff`"
+if test ! -f "$PIXDIFF" ; then
+    log "Unable to find pixdiff, aborting"
+    exit 1
+fi
+
+rm -f anim.asc anim.g
+cat > anim.asc <<EOF
+title {Animation test database}
+units mm
+put {light} ell V {-4 -4 20} A {0.5 0 0} B {0 0.5 0} C {0 0 0.5}
+put {plate.s} arb8 V1 {-30 -30 -1} V2 {30 -30 -1} V3 {30 30 -1} V4 {-30 30 -1} V5 {-30 -30 0} V6 {30 -30 0} V7 {30 30 0} V8 {-30 30 0}
+put {ball1.s} ell V {-10 0 5} A {2 0 0} B {0 2 0} C {0 0 2}
+put {ball2.s} ell V {10 0 5} A {2 0 0} B {0 2 0} C {0 0 2}
+put {box.s} arb8 V1 {-2 -12 1} V2 {2 -12 1} V3 {2 -8 1} V4 {-2 -8 1} V5 {-2 -12 5} V6 {2 -12 5} V7 {2 -8 5} V8 {-2 -8 5}
+put {balls.r} comb region yes tree {u {l ball1.s} {l ball2.s}}
+attr set {balls.r} {region} {R} {region_id} {1001} {rgb} {255/0/0}
+put {box.r} comb region yes tree {l box.s}
+attr set {box.r} {region} {R} {region_id} {1002} {rgb} {0/255/0}
+put {plate.r} comb region yes tree {l plate.s}
+attr set {plate.r} {region} {R} {region_id} {1000}
+put {light.r} comb region yes tree {l light}
+attr set {light.r} {region} {R} {region_id} {1003} {oshader} {light {i 1 v 0}} {rgb} {255/255/255}
+put {all.g} comb region no tree {u {u {l light.r} {l plate.r}} {u {l balls.r} {l box.r}}}
+EOF
+
+run $A2G anim.asc anim.g
+
+# Frames move one ball, move it again along with the box, leave
+# everything where it started, and then move the plate.  The view is
+# repeated so every frame stands alone.
+VIEW="viewsize 1.6e2; orientation 0 0 0 1; eye_pt 0 0 79.5;"
+rm -f anim.frames
+cat > anim.frames <<EOF
+start 1; $VIEW clean;
+anim all.g/balls.r/ball1.s matrix rstack 1 0 0 0 0 1 0 0 0 0 1 3 0 0 0 1;
+end;
+start 2; $VIEW clean;
+anim all.g/balls.r/ball1.s matrix rstack 1 0 0 4 0 1 0 2 0 0 1 0 0 0 0 1;
+anim all.g/box.r matrix rstack 1 0 0 0 0 1 0 4 0 0 1 0 0 0 0 1;
+end;
+start 3; $VIEW clean;
+end;
+start 4; $VIEW clean;
+anim all.g/plate.r/plate.s matrix rstack 1 0 0 0 0 1 0 0 0 0 1 -2 0 0 0 1;
+end;
+EOF
+
+# rt resumes a frame whose output file already exists
+FRAMES="1 2 3 4"
+for frame in $FRAMES ; do
+    rm -f anim.full.pix.$frame anim.incr.pix.$frame anim.diff.pix.$frame
+done
+
+log "rendering frames with a full prep each frame..."
+$RT -M -B -P4 -s64 -p30 -o anim.full.pix anim.g 'all.g' >> $LOGFILE 2>&1 < anim.frames
+
+log "rendering frames re-prepping only animated objects..."
+( echo "set incremental_prep=1;" ; cat anim.frames ) | \
+    $RT -M -B -P4 -s64 -p30 -o anim.incr.pix anim.g 'all.g' >> $LOGFILE 2>&1
+
+FAILED=0
+for frame in $FRAMES ; do
+    if test ! -f anim.full.pix.$frame || test ! -f anim.incr.pix.$frame ; then
+	log "frame $frame was not rendered"
+	FAILED="`expr $FAILED + 1`"
+	continue
+    fi
+    log "... running $PIXDIFF anim.full.pix.$frame anim.incr.pix.$frame > anim.diff.pix.$frame"
+    $PIXDIFF anim.full.pix.$frame anim.incr.pix.$frame > anim.diff.pix.$frame 2>> $LOGFILE
+    NUMBER_WRONG=`tail -n1 "$LOGFILE" | tr , '\012' | awk '/many/ {print $1}'`
+    log "frame $frame: $NUMBER_WRONG off by many"
+    if test "x$NUMBER_WRONG" != "x0" ; then
+	FAILED="`expr $FAILED + 1`"
+    fi
+done
+
+if test "x$FAILED" = "x0" ; then
+    log "-> anim.sh succeeded"
+else
+    log "-> anim.sh FAILED, see $LOGFILE"
+    cat "$LOGFILE"
+fi
+
+exit $FAILED
+
+# Local Variables:
+# mode: sh
+# tab-width: 8
+# sh-indentation: 4
+# sh-basic-offset: 4
+# indent-tabs-mode: t
+# End:
+# ex: shiftwidth=4 tabstop=8
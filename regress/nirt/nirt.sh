@@ -575,6 +575,99 @@ EOF
 run cmp nirt.ref nirt.out
 STATUS=$?
 
+log "*** Test 12 - batch command against per-ray shots ***"
+
+# ids are out of order and one repeats, which batch output must sort
+# stably; ray 4 misses everything
+rm -f nirt.rays.csv nirt.rays.sorted nirt.batch.csv nirt.shots.out
+cat > nirt.rays.csv <<EOF
+x,y,z,dx,dy,dz,id
+-5,0.5,0.25,1,0,0,3
+0.5,-4,0.3,0,1,0,1
+-6,-1.5,-0.8,1,0.25,0.1,2
+0,5,5,0,0,-1,4
+-5,-4.5,0.1,1,1,0,2
+2,0,5,0,0.2,-1,0
+EOF
+sed 1d nirt.rays.csv | sort -s -t, -k7,7n > nirt.rays.sorted
+
+# the same rays, one "s" at a time and in batch order
+shots="backout 0"
+shots="$shots;fmt r \"ray,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f\\n\" x_orig y_orig z_orig x_dir y_dir z_dir"
+shots="$shots;fmt h \"\";fmt g \"\";fmt f \"\";fmt m \"\";fmt o \"\""
+shots="$shots;fmt p \"part,%s,%d,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f\\n\" path_name reg_id x_in y_in z_in x_out y_out z_out obliq_in obliq_out"
+shots="$shots`awk -F, '{printf(";xyz %s %s %s;dir %s %s %s;s", $1, $2, $3, $4, $5, $6)}' nirt.rays.sorted`"
+
+run $NIRT -H 0 -e "batch -P 3 -o nirt.batch.csv nirt.rays.csv;q" nirt.g left_cube.r center_cube.r right_cube.r
+log "... running nirt per-ray shots"
+$NIRT -H 0 -e "$shots;q" nirt.g left_cube.r center_cube.r right_cube.r > nirt.shots.out 2>> $LOGFILE
+
+# per-ray nirt reports points, batch reports distances along the ray
+awk -F, '
+    FILENAME == ARGV[1] {
+	ids[nids++] = $7
+	next
+    }
+    FILENAME == ARGV[2] && $1 == "ray" {
+	n++
+	for (i = 0; i < 6; i++)
+	    r[i] = $(i + 2)
+	next
+    }
+    FILENAME == ARGV[2] && $1 == "part" {
+	k = ++cnt[n]
+	name[n, k] = $2
+	regid[n, k] = $3
+	din[n, k] = ($4 - r[0]) * r[3] + ($5 - r[1]) * r[4] + ($6 - r[2]) * r[5]
+	dout[n, k] = ($7 - r[0]) * r[3] + ($8 - r[1]) * r[4] + ($9 - r[2]) * r[5]
+	oin[n, k] = $10
+	oout[n, k] = $11
+	next
+    }
+    FILENAME == ARGV[3] && FNR > 1 {
+	row[nrows++] = $0
+    }
+    function differ(a, b) {
+	return (a - b > 1.0e-6 || b - a > 1.0e-6)
+    }
+    END {
+	if (n != nids) {
+	    printf("expected %d per-ray shots, got %d\n", nids, n)
+	    exit 1
+	}
+	j = 0
+	for (i = 1; i <= n; i++) {
+	    for (k = 1; k <= cnt[i] || (k == 1 && !cnt[i]); k++) {
+		if (j >= nrows) {
+		    printf("batch output ends before ray %s\n", ids[i - 1])
+		    exit 1
+		}
+		split(row[j++], f, ",")
+		if (f[1] != ids[i - 1] || f[2] != ((cnt[i]) ? k : 0)) {
+		    printf("batch row %d is ray %s partition %s, expected ray %s partition %d\n", j, f[1], f[2], ids[i - 1], (cnt[i]) ? k : 0)
+		    exit 1
+		}
+		if (!cnt[i])
+		    continue
+		if (f[3] != name[i, k] || f[4] != regid[i, k] \
+		    || differ(f[5], din[i, k]) || differ(f[6], dout[i, k]) \
+		    || differ(f[7], dout[i, k] - din[i, k]) \
+		    || differ(f[8], oin[i, k]) || differ(f[9], oout[i, k])) {
+		    printf("batch row %d: %s\n  per-ray: %s,%s,%.9f,%.9f,%.9f,%.9f\n", j, row[j - 1], name[i, k], regid[i, k], din[i, k], dout[i, k], oin[i, k], oout[i, k])
+		    exit 1
+		}
+	    }
+	}
+	if (j != nrows) {
+	    printf("batch output has %d extra rows\n", nrows - j)
+	    exit 1
+	}
+    }' nirt.rays.sorted nirt.shots.out nirt.batch.csv >> $LOGFILE 2>&1
+if test $? -ne 0 ; then
+    log "-> batch output does not match per-ray output"
+    STATUS=1
+fi
+
 if [ X$STATUS = X0 ] ; then
     log "-> nirt.sh succeeded"
 else
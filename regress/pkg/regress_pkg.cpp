@@ -27,6 +27,8 @@
 #define MSG_HELO	1
 #define MSG_DATA	2
 #define MSG_CIAO	3
+#define MSG_BULK	4
+#define BULK_LEN	(256*1024)
 #define MAX_PORT_DIGITS      5
 
 #include "common.h"
@@ -73,6 +75,13 @@ server_data(struct pkg_conn *UNUSED(connection), char *buf)
 }
 
 
+/* the (very compressible) contents of the bulk message */
+static char
+bulk_byte(size_t i)
+{
+    return (char)('a' + (i / 64) % 26);
+}
+
 /* callback when a CIAO message packet is received */
 void
 server_ciao(struct pkg_conn *UNUSED(connection), char *buf)
@@ -156,6 +165,26 @@ server_main(int UNUSED(argc), const char *UNUSED(argv)) {
 	}
     } while (client == PKC_NULL);
 
+    /* the client asked for compression, ask for it too */
+    (void)pkg_options(client, PKG_OPT_LZ4);
+
+    /* send a large message gathered from several pieces */
+    {
+	char *bulk = (char *)bu_malloc(BULK_LEN, "bulk");
+	struct pkg_iovec iov[3];
+	for (size_t i = 0; i < BULK_LEN; i++)
+	    bulk[i] = bulk_byte(i);
+	iov[0].iov_base = bulk;
+	iov[0].iov_len = 10;
+	iov[1].iov_base = bulk + 10;
+	iov[1].iov_len = BULK_LEN / 2;
+	iov[2].iov_base = bulk + 10 + BULK_LEN / 2;
+	iov[2].iov_len = BULK_LEN - 10 - BULK_LEN / 2;
+	bytes = pkg_sendv(MSG_BULK, iov, 3, client);
+	bu_free(bulk, "bulk");
+	if (bytes != BULK_LEN) goto failure;
+    }
+
     /* send the first message to the server */
     bu_vls_sprintf(&buffer, "This is a message from the server.");
     bytes = pkg_send(MSG_DATA, bu_vls_addr(&buffer), (size_t)bu_vls_strlen(&buffer)+1, client);
@@ -211,6 +240,20 @@ client_data(struct pkg_conn *connection, char *buf)
     free(buf);
 }
 
+/* callback when a BULK message packet is received */
+void
+client_bulk(struct pkg_conn *connection, char *buf)
+{
+    if (connection->pkc_len != BULK_LEN)
+	bu_exit(-1, "Bulk message arrived with %zu bytes, expected %d\n", connection->pkc_len, BULK_LEN);
+    for (size_t i = 0; i < BULK_LEN; i++) {
+	if (buf[i] != bulk_byte(i))
+	    bu_exit(-1, "Bulk message corrupt at byte %zu\n", i);
+    }
+    bu_log("Received bulk message of %zu bytes\n", connection->pkc_len);
+    free(buf);
+}
+
 /* callback when a CIAO message packet is received */
 void
 client_ciao(struct pkg_conn *UNUSED(connection), char *buf)
@@ -234,6 +277,7 @@ client_main(int UNUSED(argc), const char **UNUSED(argv)) {
 	{MSG_HELO, client_unexpected, "HELO", NULL},
 	{MSG_DATA, client_data, "DATA", NULL},
 	{MSG_CIAO, client_ciao, "CIAO", NULL},
+	{MSG_BULK, client_bulk, "BULK", NULL},
 	{0, 0, (char *)0, (void*)0}
     };
 
@@ -261,6 +305,9 @@ client_main(int UNUSED(argc), const char **UNUSED(argv)) {
 
     connection->pkc_switch = callbacks;
 
+    /* offer to exchange compressed messages */
+    (void)pkg_options(connection, PKG_OPT_LZ4);
+
     /* let the server know we're cool. */
     bytes = pkg_send(MSG_HELO, MAGIC_ID, strlen(MAGIC_ID) + 1, connection);
     if (bytes < 0) {
@@ -0,0 +1,128 @@
+#!/bin/sh
+#                  P R O G R E S S I V E . S H
+# BRL-CAD
+#
+# Copyright (c) 2024 United States Government as represented by
+# the U.S. Army Research Laboratory.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+# 1. Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#
+# 2. Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following
+# disclaimer in the documentation and/or other materials provided
+# with the distribution.
+#
+# 3. The name of the author may not be used to endorse or promote
+# products derived from this software without specific prior written
+# permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+# OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+###
+#
+# The last pass of a progressive render shoots every pixel exactly
+# as a normal render does, so without hypersampling the two images
+# must match pixel for pixel.  Frame sizes that are not a multiple
+# of the coarsest sample spacing check the partial cells at the
+# edges, and both serial and parallel renders are compared.
+#
+
+# Ensure /bin/sh
+export PATH || (echo "This isn't sh."; sh $0 $*; kill $$)
+
+# source common library functionality, setting ARGS, NAME_OF_THIS,
+# PATH_TO_THIS, and THIS.
+. "$1/regress/library.sh"
+
+if test "x$LOGFILE" = "x" ; then
+    LOGFILE=`pwd`/progressive.log
+    rm -f $LOGFILE
+fi
+log "=== TESTING progressive rendering ==="
+
+RT="`ensearch rt`"
+if test ! -f "$RT" ; then
+    log "Unable to find rt, aborting"
+    exit 1
+fi
+A2G="`ensearch asc2g`"
+if test ! -f "$A2G" ; then
+    log "Unable to find asc2g, aborting"
+    exit 1
+fi
+PIXDIFF="`ensearch pixdiff`"
+if test ! -f "$PIXDIFF" ; then
+    log "Unable to find pixdiff, aborting"
+    exit 1
+fi
+
+rm -f progressive.asc
+cat > progressive.asc <<EOF2
+title {Untitled BRL-CAD Database}
+units mm
+put {plate.s} arb8 V1 {-30 -30 -1} V2 {30 -30 -1} V3 {30 30 -1} V4 {-30 30 -1} V5 {-30 -30 0} V6 {30 -30 0} V7 {30 30 0} V8 {-30 30 0}
+put {pole.s} tgc V {9 2.5 1} H {0 0 10} A {0 -0.25 0} B {0.25 0 0} C {0 -0.25 0} D {0.25 0 0}
+put {ball1.s} ell V {-10 0 5} A {2 0 0} B {0 2 0} C {0 0 2}
+put {ball2.s} ell V {10 0 5} A {4 0 0} B {0 1 0} C {0 0 3}
+put {ring.s} tor V {0 -12 3} H {0 0.3 1} r_a 6 r_h 1
+put {plate.r} comb region yes tree {l plate.s}
+attr set {plate.r} {region} {R} {los} {100} {material_id} {1} {region_id} {1000} {rgb} {200/180/120}
+put {objs.r} comb region yes tree {u {u {l ball1.s} {l pole.s}} {u {l ball2.s} {l ring.s}}}
+attr set {objs.r} {region} {R} {los} {100} {material_id} {1} {region_id} {1001} {oshader} {plastic} {rgb} {90/140/230}
+put {all.g} comb region no tree {u {l plate.r} {l objs.r}}
+EOF2
+
+run $A2G progressive.asc progressive.g
+
+FAILED=0
+for size in "-s64" "-w 101 -n 67" ; do
+    for cpus in 1 3 ; do
+	log "rendering $size -P$cpus normally and progressively..."
+	rm -f progressive.norm.pix progressive.prog.pix progressive.diff.pix
+	$RT -B -a 35 -e 25 -P$cpus $size -o progressive.norm.pix progressive.g all.g >> $LOGFILE 2>&1
+	$RT -B -a 35 -e 25 -P$cpus $size -c "set progressive=1" -o progressive.prog.pix progressive.g all.g >> $LOGFILE 2>&1
+
+	$PIXDIFF progressive.norm.pix progressive.prog.pix > progressive.diff.pix 2>> $LOGFILE
+	DIFFS=`tail -n1 "$LOGFILE" | tr , '\012' | awk '/off by/ {sum += $1} END {print sum+0}'`
+	if test ! -s progressive.norm.pix || test ! -s progressive.prog.pix ; then
+	    DIFFS=1
+	fi
+	log "$size -P$cpus: $DIFFS bytes differ"
+	if test "x$DIFFS" != "x0" ; then
+	    FAILED="`expr $FAILED + 1`"
+	fi
+    done
+done
+
+if test "x$FAILED" = "x0" ; then
+    log "-> progressive.sh succeeded"
+else
+    log "-> progressive.sh FAILED, see $LOGFILE"
+    cat "$LOGFILE"
+fi
+
+exit $FAILED
+
+# Local Variables:
+# mode: sh
+# tab-width: 8
+# sh-indentation: 4
+# sh-basic-offset: 4
+# indent-tabs-mode: t
+# End:
+# ex: shiftwidth=4 tabstop=8
@@ -0,0 +1,155 @@
+#!/bin/sh
+#                    T E S S C A C H E . S H
+# BRL-CAD
+#
+# Copyright (c) 2024 United States Government as represented by
+# the U.S. Army Research Laboratory.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+# 1. Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#
+# 2. Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following
+# disclaimer in the documentation and/or other materials provided
+# with the distribution.
+#
+# 3. The name of the author may not be used to endorse or promote
+# products derived from this software without specific prior written
+# permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+# OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+###
+#
+# Converting with g-stl and g-obj -P greater than one first fills the
+# in-memory tessellation cache (rt_tess_cache) in parallel, and any
+# run can read and fill the on-disk LIBRT_CACHE.  Neither may change
+# the output.  A model whose parts are placed many times, moved and
+# rotated, is converted serially with no cache at all, then in
+# parallel with an empty LIBRT_CACHE (cold) and again with the one
+# that run filled (warm), and serially from the warm cache.  Every
+# output must be byte for byte the same as the first.
+#
+
+# Ensure /bin/sh
+export PATH || (echo "This isn't sh."; sh $0 $*; kill $$)
+
+# source common library functionality, setting ARGS, NAME_OF_THIS,
+# PATH_TO_THIS, and THIS.
+. "$1/regress/library.sh"
+
+if test "x$LOGFILE" = "x" ; then
+    LOGFILE=`pwd`/tesscache.log
+    rm -f $LOGFILE
+fi
+log "=== TESTING tessellation caches ==="
+
+A2G="`ensearch asc2g`"
+if test ! -f "$A2G" ; then
+    log "Unable to find asc2g, aborting"
+    exit 1
+fi
+GSTL="`ensearch g-stl`"
+if test ! -f "$GSTL" ; then
+    log "Unable to find g-stl, aborting"
+    exit 1
+fi
+GOBJ="`ensearch g-obj`"
+if test ! -f "$GOBJ" ; then
+    log "Unable to find g-obj, aborting"
+    exit 1
+fi
+
+CACHEDIR="`pwd`/tesscache.rtcache"
+
+rm -f tesscache.asc
+cat > tesscache.asc <<EOF2
+title {Untitled BRL-CAD Database}
+units mm
+put {body.s} ell V {0 0 0} A {12 0 0} B {0 6 0} C {0 0 4}
+put {mast.s} tgc V {0 0 0} H {0 0 15} A {2 0 0} B {0 2 0} C {1 0 0} D {0 1 0}
+put {hole.s} sph V {6 0 0} r 2.5
+put {ring.s} tor V {0 0 0} H {0 0 1} r_a 8 r_h 1.5
+put {base.s} arb8 V1 {-70 -70 -6} V2 {70 -70 -6} V3 {70 70 -6} V4 {-70 70 -6} V5 {-70 -70 -4} V6 {70 -70 -4} V7 {70 70 -4} V8 {-70 70 -4}
+put {part.c} comb region no tree {- {u {l body.s} {l mast.s}} {l hole.s}}
+put {part1.r} comb region yes tree {l part.c}
+put {part2.r} comb region yes tree {l part.c {1 0 0 40 0 1 0 0 0 0 1 0 0 0 0 1}}
+put {part3.r} comb region yes tree {l part.c {1 0 0 -40 0 1 0 0 0 0 1 0 0 0 0 1}}
+put {part4.r} comb region yes tree {l part.c {1 0 0 0 0 1 0 40 0 0 1 0 0 0 0 1}}
+put {part5.r} comb region yes tree {l part.c {0 -1 0 0 1 0 0 -40 0 0 1 0 0 0 0 1}}
+put {part6.r} comb region yes tree {l part.c {0 -1 0 40 1 0 0 40 0 0 1 10 0 0 0 1}}
+put {rings.r} comb region yes tree {u {u {l ring.s {1 0 0 -40 0 1 0 40 0 0 1 0 0 0 0 1}} {l ring.s {1 0 0 40 0 1 0 -40 0 0 1 0 0 0 0 1}}} {l ring.s {1 0 0 -40 0 0 -1 -40 0 1 0 10 0 0 0 1}}}
+put {base.r} comb region yes tree {l base.s}
+put {all.g} comb region no tree {u {u {u {l part1.r} {l part2.r}} {u {l part3.r} {l part4.r}}} {u {u {l part5.r} {l part6.r}} {u {l rings.r} {l base.r}}}}
+EOF2
+
+run $A2G tesscache.asc tesscache.g
+
+FAILED=0
+
+# convert with converter $1, extension $2, cpus $3, LIBRT_CACHE $4, into tesscache.$5.$2
+convert ( ) {
+    rm -f "tesscache.$5.$2"
+    log "... $1 -P$3 with LIBRT_CACHE=$4"
+    LIBRT_CACHE="$4" ; export LIBRT_CACHE
+    $1 -P$3 -o "tesscache.$5.$2" tesscache.g all.g >> $LOGFILE 2>&1
+    if test ! -s "tesscache.$5.$2" ; then
+	log "ERROR: $1 -P$3 made no output"
+	FAILED="`expr $FAILED + 1`"
+    fi
+}
+
+for conv in "$GSTL:stl" "$GOBJ:obj" ; do
+    CONV="`echo $conv | sed 's/:[^:]*$//'`"
+    EXT="`echo $conv | sed 's/^.*://'`"
+    log "converting with `basename $CONV`..."
+
+    rm -rf "$CACHEDIR" && mkdir "$CACHEDIR"
+    convert "$CONV" $EXT 1 0 ref
+    convert "$CONV" $EXT 3 "$CACHEDIR" cold
+    convert "$CONV" $EXT 3 "$CACHEDIR" warm
+    convert "$CONV" $EXT 1 "$CACHEDIR" warm1
+
+    for run in cold warm warm1 ; do
+	if files_match "tesscache.ref.$EXT" "tesscache.$run.$EXT" ; then
+	    log "$EXT $run: same as serial without a cache"
+	else
+	    FAILED="`expr $FAILED + 1`"
+	fi
+    done
+done
+
+unset LIBRT_CACHE
+rm -rf "$CACHEDIR"
+
+if test "x$FAILED" = "x0" ; then
+    log "-> tesscache.sh succeeded"
+else
+    log "-> tesscache.sh FAILED, see $LOGFILE"
+    cat "$LOGFILE"
+fi
+
+exit $FAILED
+
+# Local Variables:
+# mode: sh
+# tab-width: 8
+# sh-indentation: 4
+# sh-basic-offset: 4
+# indent-tabs-mode: t
+# End:
+# ex: shiftwidth=4 tabstop=8
@@ -94,6 +94,13 @@ enum
 
 RENDER_EXPORT extern int load_g(struct tie_s *tie, const char *db, int argc, const char **argv, struct adrt_mesh_s **);
 
+/* kd-tree cache kept next to the .g, see load_g.c */
+struct bn_tol;
+struct bg_tess_tol;
+RENDER_EXPORT extern uint64_t load_g_cache_key(const char *db, int argc, const char **argv, const struct bg_tess_tol *ttol, const struct bn_tol *tol);
+RENDER_EXPORT extern int load_g_cache_load(struct tie_s *tie, const char *db, uint64_t key, struct adrt_mesh_s *meshes);
+RENDER_EXPORT extern int load_g_cache_save(struct tie_s *tie, const char *db, uint64_t key, struct adrt_mesh_s *meshes);
+
 #endif
 
 /*
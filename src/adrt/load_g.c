@@ -24,7 +24,13 @@
  * exist on the machine the 'slave' program is running, with the correct path
  * passed to it. Only one combination is used, intended to be the top of the
  * tree of concern. It's assumed that only BOT's are to be loaded, non-bots will
- * be silently ignored for now. No KD-TREE caching is assumed. I like tacos.
+ * be silently ignored for now. I like tacos.
+ *
+ * The prepped triangles and KD-TREE are cached in a file next to the
+ * .g (see load_g_cache_save()), keyed by a hash of the .g contents,
+ * the data files of its dsp, ebm and vol objects, the objects loaded
+ * and the tolerances, so that loading an unchanged
+ * model again skips both the tree walk and the KD-TREE build.
  */
 
 #include "common.h"
@@ -33,6 +39,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "bu/hash.h"
+#include "bu/mapped_file.h"
+#include "bu/vls.h"
 #include "gcv.h"
 
 /* interface headers */
@@ -59,6 +68,19 @@ struct gcv_data {
 };
 static struct gcv_data gcvwriter = {{nmg_to_adrt_gcvwrite, NULL, NULL}, NULL};
 
+#define LOAD_G_CACHE_EXT ".tiekd"
+
+/* what is kept of each mesh in the kd-tree cache */
+struct load_g_cache_mesh {
+    char name[ADRT_NAME_SIZE];
+    int flags;
+    int matid;
+    vect_t min, max;
+    fastf_t matrix[16];
+    fastf_t matinv[16];
+    adrt_mesh_attributes_t attributes;
+};
+
 
 /* load the region into the tie image */
 static void
@@ -238,12 +260,224 @@ nmg_to_adrt_gcvwrite(struct nmgregion *r, const struct db_full_path *pathp, stru
 }
 
 
+/*
+ * Add the data files of the dsp, ebm and vol objects in db to the
+ * cache key, found the same way the primitives find them.  Objects
+ * that are not loaded are included too; that only costs a rebuild
+ * when one of their files changes.
+ */
+static void
+load_g_cache_key_files(struct bu_data_hash_state *state, const char *db)
+{
+    struct db_i *kdbip;
+    struct directory *dp;
+
+    if ((kdbip = db_open(db, DB_OPEN_READONLY)) == DBI_NULL)
+	return;
+    if (db_dirbuild(kdbip)) {
+	db_close(kdbip);
+	return;
+    }
+
+    FOR_ALL_DIRECTORY_START(dp, kdbip) {
+	struct rt_db_internal intern;
+	struct bu_mapped_file *mp = NULL;
+	const char *name = NULL;
+
+	if (dp->d_major_type != DB5_MAJORTYPE_BRLCAD)
+	    continue;
+	if (dp->d_minor_type != DB5_MINORTYPE_BRLCAD_DSP
+	    && dp->d_minor_type != DB5_MINORTYPE_BRLCAD_EBM
+	    && dp->d_minor_type != DB5_MINORTYPE_BRLCAD_VOL)
+	    continue;
+	if (rt_db_get_internal(&intern, dp, kdbip, NULL, &rt_uniresource) < 0)
+	    continue;
+
+	switch (intern.idb_minor_type) {
+	    case DB5_MINORTYPE_BRLCAD_DSP: {
+		struct rt_dsp_internal *dsp = (struct rt_dsp_internal *)intern.idb_ptr;
+		if (dsp->dsp_datasrc == RT_DSP_SRC_FILE || dsp->dsp_datasrc == RT_DSP_SRC_V4_FILE) {
+		    name = bu_vls_cstr(&dsp->dsp_name);
+		    mp = bu_open_mapped_file_with_path(kdbip->dbi_filepath, name, "load_g cache key");
+		}
+		break;
+	    }
+	    case DB5_MINORTYPE_BRLCAD_EBM: {
+		struct rt_ebm_internal *ebm = (struct rt_ebm_internal *)intern.idb_ptr;
+		if (ebm->datasrc == RT_EBM_SRC_FILE) {
+		    name = ebm->name;
+		    mp = bu_open_mapped_file_with_path(kdbip->dbi_filepath, name, "load_g cache key");
+		}
+		break;
+	    }
+	    case DB5_MINORTYPE_BRLCAD_VOL: {
+		struct rt_vol_internal *vol = (struct rt_vol_internal *)intern.idb_ptr;
+		if (vol->datasrc == RT_VOL_SRC_FILE) {
+		    name = vol->name;
+		    mp = bu_open_mapped_file(name, "load_g cache key");
+		}
+		break;
+	    }
+	}
+
+	if (name) {
+	    bu_data_hash_update(state, dp->d_namep, strlen(dp->d_namep) + 1);
+	    bu_data_hash_update(state, name, strlen(name) + 1);
+	}
+	if (mp) {
+	    bu_data_hash_update(state, mp->buf, mp->buflen);
+	    bu_close_mapped_file(mp);
+	}
+	rt_db_free_internal(&intern);
+    } FOR_ALL_DIRECTORY_END;
+
+    db_close(kdbip);
+}
+
+
+/**
+ * Key for the kd-tree cache of the given objects in db.
+ */
+uint64_t
+load_g_cache_key(const char *db, int argc, const char **argv, const struct bg_tess_tol *ttol, const struct bn_tol *tol)
+{
+    struct bu_data_hash_state *state;
+    struct bu_mapped_file *mp;
+    uint64_t key;
+    int i;
+
+    state = bu_data_hash_create();
+
+    mp = bu_open_mapped_file(db, "load_g cache key");
+    if (mp) {
+	bu_data_hash_update(state, mp->buf, mp->buflen);
+	bu_close_mapped_file(mp);
+    }
+    load_g_cache_key_files(state, db);
+
+    for (i = 0; i < argc; i++)
+	bu_data_hash_update(state, argv[i], strlen(argv[i]) + 1);
+
+    bu_data_hash_update(state, &ttol->abs, sizeof(ttol->abs));
+    bu_data_hash_update(state, &ttol->rel, sizeof(ttol->rel));
+    bu_data_hash_update(state, &ttol->norm, sizeof(ttol->norm));
+    bu_data_hash_update(state, &tol->dist, sizeof(tol->dist));
+    bu_data_hash_update(state, &tol->perp, sizeof(tol->perp));
+
+    key = (uint64_t)bu_data_hash_val(state);
+    bu_data_hash_destroy(state);
+
+    return key;
+}
+
+
+static int
+load_g_cache_meshes(const void *user, size_t user_len, void **ptrs, unsigned int nptrs, void *data)
+{
+    const struct load_g_cache_mesh *rec = (const struct load_g_cache_mesh *)user;
+    struct adrt_mesh_s *meshes = (struct adrt_mesh_s *)data;
+    unsigned int i;
+
+    if (user_len != nptrs * sizeof(struct load_g_cache_mesh))
+	return -1;
+
+    for (i = 0; i < nptrs; i++) {
+	struct adrt_mesh_s *mesh;
+
+	BU_ALLOC(mesh, struct adrt_mesh_s);
+	BU_ALLOC(mesh->attributes, struct adrt_mesh_attributes_s);
+	BU_LIST_PUSH(&meshes->l, &mesh->l);
+
+	bu_strlcpy(mesh->name, rec[i].name, sizeof(mesh->name));
+	mesh->flags = rec[i].flags;
+	mesh->matid = rec[i].matid;
+	VMOVE(mesh->min, rec[i].min);
+	VMOVE(mesh->max, rec[i].max);
+	MAT_COPY(mesh->matrix, rec[i].matrix);
+	MAT_COPY(mesh->matinv, rec[i].matinv);
+	*mesh->attributes = rec[i].attributes;	/* struct copy */
+	mesh->texture = NULL;
+
+	ptrs[i] = mesh;
+    }
+
+    return 0;
+}
+
+
+/**
+ * Load the cached triangles and kd-tree of db into tie, appending the
+ * cached meshes to the meshes list.  tie must have been through
+ * tie_init() and hold no triangles.  Returns 0 on success, -1 if
+ * there is no valid cache for key.
+ */
+int
+load_g_cache_load(struct tie_s *tie, const char *db, uint64_t key, struct adrt_mesh_s *meshes)
+{
+    struct bu_vls path = BU_VLS_INIT_ZERO;
+    int ret;
+
+    bu_vls_sprintf(&path, "%s%s", db, LOAD_G_CACHE_EXT);
+    ret = TIE_VAL(tie_cache_load)(tie, bu_vls_cstr(&path), key, load_g_cache_meshes, meshes);
+    bu_vls_free(&path);
+
+    return ret;
+}
+
+
+/**
+ * Write the prepped tie and the meshes its triangles point at to the
+ * cache next to db.  Failing to write it is not an error for the
+ * caller; the next load just builds the tree again.
+ */
+int
+load_g_cache_save(struct tie_s *tie, const char *db, uint64_t key, struct adrt_mesh_s *meshes)
+{
+    struct bu_vls path = BU_VLS_INIT_ZERO;
+    struct load_g_cache_mesh *rec;
+    struct adrt_mesh_s *mesh;
+    void **ptrs;
+    unsigned int n = 0;
+    int ret;
+
+    for (BU_LIST_FOR(mesh, adrt_mesh_s, &meshes->l))
+	n++;
+
+    ptrs = (void **)bu_calloc(n ? n : 1, sizeof(void *), "load_g cache ptrs");
+    rec = (struct load_g_cache_mesh *)bu_calloc(n ? n : 1, sizeof(struct load_g_cache_mesh), "load_g cache meshes");
+
+    n = 0;
+    for (BU_LIST_FOR(mesh, adrt_mesh_s, &meshes->l)) {
+	bu_strlcpy(rec[n].name, mesh->name, sizeof(rec[n].name));
+	rec[n].flags = mesh->flags;
+	rec[n].matid = mesh->matid;
+	VMOVE(rec[n].min, mesh->min);
+	VMOVE(rec[n].max, mesh->max);
+	MAT_COPY(rec[n].matrix, mesh->matrix);
+	MAT_COPY(rec[n].matinv, mesh->matinv);
+	if (mesh->attributes)
+	    rec[n].attributes = *mesh->attributes;	/* struct copy */
+	ptrs[n++] = mesh;
+    }
+
+    bu_vls_sprintf(&path, "%s%s", db, LOAD_G_CACHE_EXT);
+    ret = TIE_VAL(tie_cache_save)(tie, bu_vls_cstr(&path), key, ptrs, n, rec, n * sizeof(struct load_g_cache_mesh));
+    bu_vls_free(&path);
+
+    bu_free(rec, "load_g cache meshes");
+    bu_free(ptrs, "load_g cache ptrs");
+
+    return ret;
+}
+
+
 int
 load_g(struct tie_s *tie, const char *db, int argc, const char **argv, struct adrt_mesh_s **meshes)
 {
     struct model *the_model;
     struct bg_tess_tol ttol;		/* tessellation tolerance in mm */
     struct db_tree_state tree_state;	/* includes tol & model */
+    uint64_t key;
 
     cur_tie = tie;	/* blehhh, global... need locking. */
 
@@ -269,6 +503,17 @@ load_g(struct tie_s *tie, const char *db, int argc, const char **argv, struct ad
 
     tie_check_degenerate = 0;
 
+    TIE_VAL(tie_init)(cur_tie, BU_PAGE_SIZE, TIE_KDTREE_FAST);
+
+    /* FIXME: where is this released? */
+    BU_ALLOC(*meshes, struct adrt_mesh_s);
+    BU_LIST_INIT(&((*meshes)->l));
+
+    /* an unchanged model comes straight out of the cache */
+    key = load_g_cache_key(db, argc, argv, &ttol, &tol);
+    if (load_g_cache_load(cur_tie, db, key, *meshes) == 0)
+	return 0;
+
     /* make empty NMG model */
     the_model = nmg_mm();
 
@@ -288,12 +533,6 @@ load_g(struct tie_s *tie, const char *db, int argc, const char **argv, struct ad
     BN_CK_TOL(tree_state.ts_tol);
     BG_CK_TESS_TOL(tree_state.ts_ttol);
 
-    TIE_VAL(tie_init)(cur_tie, BU_PAGE_SIZE, TIE_KDTREE_FAST);
-
-    /* FIXME: where is this released? */
-    BU_ALLOC(*meshes, struct adrt_mesh_s);
-    BU_LIST_INIT(&((*meshes)->l));
-
     gcvwriter.region_end_data.vlfree = &RTG.rtg_vlfree;
     gcvwriter.meshes = meshes;
 
@@ -323,6 +562,8 @@ load_g(struct tie_s *tie, const char *db, int argc, const char **argv, struct ad
 
     TIE_VAL(tie_prep)(cur_tie);
 
+    (void)load_g_cache_save(cur_tie, db, key, *meshes);
+
     return 0;
 }
 
@@ -123,14 +123,14 @@ master_setup(void)
 
 
 void
-master_init(int port, int obs_port, char *list, char *exec, char *comp_host, int verbose)
+master_init(int port, int obs_port, char *list, char *exec, int local, char *comp_host, int verbose)
 {
     /* Setup defaults */
     master_setup();
 
     /* Initialize tienet master */
     master.tile_num = DISPATCHER_TILE_NUM * DISPATCHER_TILE_NUM;
-    tienet_master_init(port, master_result, list, exec, 5, ADRT_VER_KEY, verbose);
+    tienet_master_init(port, master_result, list, exec, local, 5, ADRT_VER_KEY, verbose);
 
     /* Launch a thread to handle networking */
     bu_thrd_create(&master.networking_thread, (bu_thrd_start_t)master_networking, &obs_port);
@@ -626,10 +626,11 @@ static struct option longopts[] =
     { "build",	no_argument,		NULL, 'b' },
     { "verbose",	no_argument,		NULL, 'v' },
     { "list",	required_argument,	NULL, 'l' },
+    { "local",	required_argument,	NULL, 'L' },
 };
 #endif
 
-static char shortopts[] = "bc:de:i:ho:p:vl:h?";
+static char shortopts[] = "bc:de:i:ho:p:vl:L:h?";
 
 unsigned char go_daemon_mode = 0;
 unsigned int master_listener_result = 1;
@@ -648,6 +649,7 @@ static void help(void) {
   -d\t\tdaemon mode.\n\
   -e\t\tscript to execute that starts slaves.\n\
   -l\t\tfile containing list of slaves to use as compute nodes.\n\
+  -L\t\tnumber of slaves to start on this host, sharing memory with the master.\n\
   -o\t\tset observer port number.\n\
   -p\t\tset master port number.\n\
   -v\t\tverbose.\n\
@@ -658,7 +660,7 @@ static void help(void) {
 int main(int argc, char **argv) {
     int port = 0, obs_port = 0, c = 0;
     char exec[64], list[64], comp_host[64];
-    int verbose = 0;
+    int verbose = 0, local = 0;
 
     bu_setprogname(argv[0]);
 
@@ -711,6 +713,10 @@ int main(int argc, char **argv) {
 		bu_strlcpy(exec, bu_optarg, 64);
 		break;
 
+	    case 'L':
+		local = atoi(bu_optarg);
+		break;
+
 	    case 'b':
 		printf("adrt_master build: %s %s\n", __DATE__, __TIME__);
 		return EXIT_SUCCESS;
@@ -726,7 +732,7 @@ int main(int argc, char **argv) {
 	}
     }
 
-    master_init(port, obs_port, list, exec, comp_host, verbose);
+    master_init(port, obs_port, list, exec, local, comp_host, verbose);
 
     return EXIT_SUCCESS;
 }
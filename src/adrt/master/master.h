@@ -26,7 +26,7 @@
 
 #include "rt/tie.h"
 
-extern void master_init(int port, int obs_port, char *list, char *exec, char *comp_host, int verbose);
+extern void master_init(int port, int obs_port, char *list, char *exec, int local, char *comp_host, int verbose);
 
 extern unsigned char go_daemon_mode;
 extern unsigned int master_listener_result;
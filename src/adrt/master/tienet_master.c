@@ -37,11 +37,17 @@
 #ifdef HAVE_NETDB_H
 #  include <netdb.h>
 #endif
+#ifdef HAVE_SYS_WAIT_H
+#  include <sys/wait.h>
+#endif
 
 /* public api headers */
 #include "rt/tie.h"
+#include "bu/app.h"
+#include "bu/parallel.h"
 #include "bu/str.h"
 #include "bu/log.h"
+#include "bu/time.h"
 
 /* adrt headers */
 #include "adrt.h"
@@ -69,12 +75,18 @@ typedef struct tienet_master_socket_s {
     int num;
     tienet_master_data_t mesg;	/* Used for a broadcast message */
     tienet_master_data_t work;	/* The work unit currently being processed */
+    tienet_shm_t *shm;	/* Shared memory of a local slave, NULL for remote ones */
+    int pid;		/* Process of a local slave */
+    int node;		/* NUMA node a local slave is bound to, -1 for none */
+    uint64_t units;	/* Results received from this slave */
+    int64_t sent;	/* When the work unit out was sent */
+    int64_t busy;	/* Time between sending work units and their results */
     struct tienet_master_socket_s *prev;
     struct tienet_master_socket_s *next;
 } tienet_master_socket_t;
 
 
-void tienet_master_init(int port, void fcb_result(tienet_buffer_t *result), char *list, char *exec, int buffer_size, int ver_key, int verbose);
+void tienet_master_init(int port, void fcb_result(tienet_buffer_t *result), char *list, char *exec, int local, int buffer_size, int ver_key, int verbose);
 void tienet_master_free(void);
 void tienet_master_push(const void *data, size_t size);
 void tienet_master_shutdown(void);
@@ -85,9 +97,10 @@ void tienet_master_end(void);
 void tienet_master_wait(void);
 
 void tienet_master_connect_slaves(fd_set *readfds);
+void tienet_master_spawn_slaves(fd_set *readfds);
 int tienet_master_listener(void *ptr);
 void tienet_master_send_work(tienet_master_socket_t *sock);
-void tienet_master_result(tienet_master_socket_t *sock);
+void tienet_master_result(tienet_master_socket_t *sock, short op);
 void tienet_master_shutdown(void);
 
 static int tienet_master_ver_key;
@@ -113,6 +126,9 @@ static tienet_sem_t tienet_master_sem_shutdown; /* Shutdown Semaphore */
 uint64_t tienet_master_transfer;
 static char tienet_master_exec[64]; /* Something to run in order to jumpstart the slaves */
 static char tienet_master_list[64]; /* A list of slaves in daemon mode to connect to */
+static int tienet_master_local; /* Number of slaves to spawn on this host */
+static int64_t tienet_master_first_work; /* When the first work unit went out */
+static int64_t tienet_master_last_result; /* When the last result came in */
 int tienet_master_verbose;
 int tienet_master_endflag;
 int tienet_master_shutdown_state;
@@ -130,7 +146,7 @@ typedef void tienet_master_fcb_result_t(tienet_buffer_t *result);
 tienet_master_fcb_result_t *tienet_master_fcb_result;
 
 
-void tienet_master_init(int port, void fcb_result(tienet_buffer_t *result), char *list, char *exec, int buffer_size, int ver_key, int verbose)
+void tienet_master_init(int port, void fcb_result(tienet_buffer_t *result), char *list, char *exec, int local, int buffer_size, int ver_key, int verbose)
 {
     bu_thrd_t thread;
     int i;
@@ -140,7 +156,7 @@ void tienet_master_init(int port, void fcb_result(tienet_buffer_t *result), char
     tienet_master_verbose = verbose;
     tienet_master_buffer_size = buffer_size;
 
-    BU_ALLOC(tienet_master_buffer, tienet_master_data_t);
+    tienet_master_buffer = (tienet_master_data_t *)bu_calloc(buffer_size, sizeof(tienet_master_data_t), "tienet master buffer");
 
     tienet_master_fcb_result = fcb_result;
     tienet_master_active_slaves = 0;
@@ -161,6 +177,7 @@ void tienet_master_init(int port, void fcb_result(tienet_buffer_t *result), char
 
     bu_strlcpy(tienet_master_list, list, sizeof(tienet_master_list));
     bu_strlcpy(tienet_master_exec, exec, sizeof(tienet_master_exec));
+    tienet_master_local = local;
 
     /* Copy version key to validate slaves of correct version are connecting */
     tienet_master_ver_key = ver_key;
@@ -405,6 +422,144 @@ void tienet_master_connect_slaves(fd_set *readfds)
 }
 
 
+/*
+ * Start tienet_master_local copies of adrt_slave on this host.  Each
+ * gets one end of a socket pair for the op codes, a shared memory
+ * segment for the work units and results, and an equal share of the
+ * processors.  On a NUMA host the slaves are dealt out across the
+ * nodes and each is bound to the processors of its node.
+ */
+void tienet_master_spawn_slaves(fd_set *readfds)
+{
+#ifdef TIENET_LOCAL
+    tienet_master_socket_t *tmp;
+    const char *slave_exec;
+    char arg_link[64], arg_threads[16], exec_failed[MAXPATHLEN + 32];
+    size_t exec_failed_len;
+    int i, threads, nodes;
+    long max_fd;
+
+    if (tienet_master_local <= 0)
+	return;
+
+    slave_exec = bu_dir(NULL, 0, BU_DIR_BIN, "adrt_slave", BU_DIR_EXT, NULL);
+
+    /* only write(2) is safe in the child after a failed exec, so the
+     * message is made up front */
+    snprintf(exec_failed, sizeof(exec_failed), "unable to run %s\n", slave_exec);
+    exec_failed_len = strlen(exec_failed);
+
+    threads = (int)bu_avail_cpus() / tienet_master_local;
+    if (threads < 1)
+	threads = 1;
+    snprintf(arg_threads, sizeof(arg_threads), "%d", threads);
+
+    nodes = bu_numa_nodes();
+
+    max_fd = sysconf(_SC_OPEN_MAX);
+    if (max_fd < 0 || max_fd > 65536)
+	max_fd = 65536;
+
+    for (i = 0; i < tienet_master_local; i++) {
+	tienet_shm_t *shm;
+	int fds[2], slave_ver_key = 0;
+	int node = (nodes > 1) ? i % nodes : -1;
+	pid_t pid;
+	short op;
+
+	BU_ALLOC(shm, tienet_shm_t);
+	if (tienet_shm_create(shm, TIENET_SHM_SIZE)) {
+	    fprintf(stderr, "unable to create shared memory for local slave %d, skipping.\n", i);
+	    bu_free(shm, "local slave shm");
+	    continue;
+	}
+
+	/* not inherited by the other slaves started after this one */
+#ifdef SOCK_CLOEXEC
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+#else
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+#endif
+	    fprintf(stderr, "unable to create socket pair for local slave %d, skipping.\n", i);
+	    tienet_shm_remove(shm);
+	    tienet_shm_detach(shm);
+	    bu_free(shm, "local slave shm");
+	    continue;
+	}
+
+	snprintf(arg_link, sizeof(arg_link), "%d:%d:%d", fds[1], shm->shmid, node);
+
+	pid = fork();
+	if (pid == 0) {
+	    long fd;
+
+	    /* The slave keeps only its end of the pair and stdio, not
+	     * the listening socket or the connections to other slaves. */
+	    for (fd = 3; fd < max_fd; fd++) {
+		if (fd != fds[1])
+		    close((int)fd);
+	    }
+	    (void)fcntl(fds[1], F_SETFD, 0);
+	    execl(slave_exec, slave_exec, "-t", arg_threads, "-L", arg_link, (char *)NULL);
+	    {
+		ssize_t ret = write(STDERR_FILENO, exec_failed, exec_failed_len);
+		_exit(ret < 0 ? 2 : 1);
+	    }
+	}
+	close(fds[1]);
+
+	/* Same handshake as a slave connecting over the network */
+	op = 1;
+	if (pid < 0
+	    || tienet_send(fds[0], &op, sizeof(short))
+	    || tienet_recv(fds[0], &slave_ver_key, sizeof(int))
+	    || slave_ver_key != tienet_master_ver_key) {
+	    fprintf(stderr, "local slave %d did not start, skipping.\n", i);
+	    op = TN_OP_COMPLETE;
+	    if (pid > 0)
+		tienet_send(fds[0], &op, sizeof(short));
+	    close(fds[0]);
+	    tienet_shm_remove(shm);
+	    tienet_shm_detach(shm);
+	    bu_free(shm, "local slave shm");
+	    continue;
+	}
+	op = TN_OP_OKAY;
+	tienet_send(fds[0], &op, sizeof(short));
+
+	/* The slave attached before answering, so nothing else needs the id */
+	tienet_shm_remove(shm);
+
+	/* Append to select list */
+	tmp = tienet_master_socket_list;
+
+	BU_ALLOC(tienet_master_socket_list, tienet_master_socket_t);
+	tienet_master_socket_list->next = tmp;
+	tienet_master_socket_list->prev = NULL;
+	tienet_master_socket_list->num = fds[0];
+	tienet_master_socket_list->active = 0;
+	tienet_master_socket_list->idle = 1;
+	tienet_master_socket_list->shm = shm;
+	tienet_master_socket_list->pid = (int)pid;
+	tienet_master_socket_list->node = node;
+
+	tmp->prev = tienet_master_socket_list;
+	tienet_master_socket_num++;
+	FD_SET(fds[0], readfds);
+
+	V_MAX(tienet_master_highest_fd, fds[0]);
+
+	if (tienet_master_verbose)
+	    printf("Local slave %d started as process %d on NUMA node %d, sock_num: %d\n", i, (int)pid, node, fds[0]);
+    }
+#else
+    if (tienet_master_local > 0)
+	fprintf(stderr, "local slaves are not supported on this platform, skipping.\n");
+    (void)readfds;
+#endif
+}
+
+
 int tienet_master_listener(void *UNUSED(ptr))
 {
     struct sockaddr_in master, slave;
@@ -458,6 +613,9 @@ int tienet_master_listener(void *UNUSED(ptr))
     /* Process slave host list - used for connecting to running daemons */
     tienet_master_connect_slaves(&readfds);
 
+    /* Start the slaves that run on this host */
+    tienet_master_spawn_slaves(&readfds);
+
     /* Handle Network Communications */
     while (1) {
 	select(tienet_master_highest_fd+1, &readfds, NULL, NULL, NULL);
@@ -565,7 +723,8 @@ int tienet_master_listener(void *UNUSED(ptr))
 				break;
 
 			    case TN_OP_RESULT:
-				tienet_master_result(sock);
+			    case TN_OP_SHMRESULT:
+				tienet_master_result(sock, op);
 				break;
 
 			    default:
@@ -588,6 +747,17 @@ int tienet_master_listener(void *UNUSED(ptr))
 }
 
 
+/* Hand a work unit to a local slave through its shared memory. */
+static void tienet_master_send_shm(tienet_master_socket_t *sock, const void *data, int size)
+{
+    short op = TN_OP_SHMWORK;
+
+    memcpy(sock->shm->work, data, size);
+    tienet_send(sock->num, &op, sizeof(short));
+    tienet_send(sock->num, &size, sizeof(int));
+}
+
+
 void tienet_master_send_work(tienet_master_socket_t *sock)
 {
     int size;
@@ -622,10 +792,14 @@ void tienet_master_send_work(tienet_master_socket_t *sock)
      */
     bu_mtx_lock(&tienet_master_broadcast_mut);
     if (sock->mesg.size) {
-	op = TN_OP_SENDWORK;
-	tienet_send(sock->num, &op, sizeof(short));
-	tienet_send(sock->num, &sock->mesg.size, sizeof(int));
-	tienet_send(sock->num, sock->mesg.data, sock->mesg.size);
+	if (sock->shm && sock->mesg.size <= sock->shm->size) {
+	    tienet_master_send_shm(sock, sock->mesg.data, sock->mesg.size);
+	} else {
+	    op = TN_OP_SENDWORK;
+	    tienet_send(sock->num, &op, sizeof(short));
+	    tienet_send(sock->num, &sock->mesg.size, sizeof(int));
+	    tienet_send(sock->num, sock->mesg.data, sock->mesg.size);
+	}
 
 	bu_free(sock->mesg.data, "message data");
 	sock->mesg.data = NULL;
@@ -648,7 +822,10 @@ void tienet_master_send_work(tienet_master_socket_t *sock)
 
 	/* Send Work Unit */
 	TCOPY(int, tienet_master_buffer[tienet_master_pos_read].data, sizeof(short), &size, 0);
-	tienet_send(sock->num, tienet_master_buffer[tienet_master_pos_read].data, sizeof(short) + sizeof(int) + size);
+	if (sock->shm && (size_t)size <= sock->shm->size)
+	    tienet_master_send_shm(sock, &((char *)tienet_master_buffer[tienet_master_pos_read].data)[sizeof(short) + sizeof(int)], size);
+	else
+	    tienet_send(sock->num, tienet_master_buffer[tienet_master_pos_read].data, sizeof(short) + sizeof(int) + size);
 
 	if (sizeof(short) + sizeof(int) + (size_t)size > (size_t)sock->work.size) {
 	    sock->work.size = sizeof(short) + sizeof(int) + size;
@@ -665,6 +842,10 @@ void tienet_master_send_work(tienet_master_socket_t *sock)
 	tienet_sem_post(&tienet_master_sem_fill);
 
 	tienet_master_transfer += size;
+
+	sock->sent = bu_gettime();
+	if (!tienet_master_first_work)
+	    tienet_master_first_work = sock->sent;
     } else {
 	/* no work was available, socket is entering an active idle state. */
 	sock->idle = 1;
@@ -674,8 +855,10 @@ void tienet_master_send_work(tienet_master_socket_t *sock)
 }
 
 
-void tienet_master_result(tienet_master_socket_t *sock)
+void tienet_master_result(tienet_master_socket_t *sock, short op)
 {
+    tienet_buffer_t *result = &tienet_master_result_buffer;
+    tienet_buffer_t shm_result;
 #if defined(ADRT_USE_COMPRESSION) && ADRT_USE_COMPRESSION
     unsigned long comp_len, dest_len;
 #endif
@@ -688,6 +871,26 @@ void tienet_master_result(tienet_master_socket_t *sock)
 
     /* Decrement counter for work units out */
     tienet_sem_wait(&tienet_master_sem_out);
+    sock->units++;
+    tienet_master_last_result = bu_gettime();
+    if (sock->sent) {
+	sock->busy += tienet_master_last_result - sock->sent;
+	sock->sent = 0;
+    }
+
+    if (op == TN_OP_SHMRESULT) {
+	uint32_t slot = 0;
+
+	/* the result is already in one of the slave's result areas */
+	tienet_recv(sock->num, &shm_result.ind, sizeof(uint32_t));
+	tienet_recv(sock->num, &slot, sizeof(uint32_t));
+	if (!sock->shm || shm_result.ind > sock->shm->size)
+	    shm_result.ind = 0;
+	shm_result.data = sock->shm ? sock->shm->result[slot & 1] : NULL;
+	shm_result.size = shm_result.ind;
+	result = &shm_result;
+	goto process;
+    }
 
     /* receive result length */
     tienet_recv(sock->num, &tienet_master_result_buffer.ind, sizeof(unsigned int));
@@ -716,11 +919,12 @@ void tienet_master_result(tienet_master_socket_t *sock)
     tienet_master_transfer += tienet_master_result_buffer.ind;
 #endif
 
+process:
     /* Send next work unit out before processing results so that slave is not waiting while result is being processed. */
     tienet_master_send_work(sock);
 
     /* Application level result callback function to process results. */
-    tienet_master_fcb_result(&tienet_master_result_buffer);
+    tienet_master_fcb_result(result);
 
     /*
      * If there's no units still out, the application has indicated it's done generating work,
@@ -739,6 +943,7 @@ void tienet_master_shutdown(void)
 {
     short op;
     tienet_master_socket_t *tsocket;
+    uint64_t units = 0;
 
 
     tienet_master_shutdown_state = 1;
@@ -763,10 +968,36 @@ void tienet_master_shutdown(void)
 
 	    tienet_recv(tsocket->num, &op, sizeof(short));
 	    close(tsocket->num);
+
+	    if (tienet_master_verbose) {
+		double busy = (double)tsocket->busy / 1.0e6;
+		printf("%s slave on socket %d", tsocket->shm ? "Local" : "Remote", tsocket->num);
+		if (tsocket->shm && tsocket->node >= 0)
+		    printf(" (NUMA node %d)", tsocket->node);
+		printf(" completed %llu work units in %.2fs busy, %.1f units/s\n",
+		       (unsigned long long)tsocket->units, busy, (busy > 0.0) ? (double)tsocket->units / busy : 0.0);
+	    }
+	    units += tsocket->units;
+
+	    if (tsocket->shm) {
+#ifdef HAVE_SYS_WAIT_H
+		waitpid(tsocket->pid, NULL, 0);
+#endif
+		tienet_shm_detach(tsocket->shm);
+		bu_free(tsocket->shm, "local slave shm");
+		tsocket->shm = NULL;
+	    }
 	}
     }
 
     printf("Total data transferred: %.1f MiB\n", (TFLOAT)tienet_master_transfer/(TFLOAT)(1024*1024));
+
+    /* Comparing this rate across slave counts and local (-L) against
+     * remote slaves is the scaling measurement. */
+    if (tienet_master_verbose && tienet_master_last_result > tienet_master_first_work) {
+	double wall = (double)(tienet_master_last_result - tienet_master_first_work) / 1.0e6;
+	printf("Total work units: %llu in %.2fs, %.1f units/s\n", (unsigned long long)units, wall, (double)units / wall);
+    }
 }
 
 
@@ -27,7 +27,7 @@
 #ifndef ADRT_MASTER_TIENET_MASTER_H
 #define ADRT_MASTER_TIENET_MASTER_H
 
-extern void tienet_master_init(int port, void fcb_result(tienet_buffer_t *result), char *list, char *exec, int buffer_size, int ver_key, int verbose);
+extern void tienet_master_init(int port, void fcb_result(tienet_buffer_t *result), char *list, char *exec, int local, int buffer_size, int ver_key, int verbose);
 extern void tienet_master_free(void);
 extern void tienet_master_push(const void *data, size_t size);
 extern void tienet_master_begin(void);
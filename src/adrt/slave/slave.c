@@ -407,11 +407,14 @@ adrt_slave_work(tienet_buffer_t *work, tienet_buffer_t *result)
 }
 
 void
-adrt_slave(int port, char *host, int threads)
+adrt_slave(int port, char *host, int threads, const char *local)
 {
     int i;
     adrt_slave_threads = threads;
-    tienet_slave_init(port, host, adrt_slave_work, adrt_slave_free, ADRT_VER_KEY);
+    if (local && local[0])
+	tienet_slave_local(local, adrt_slave_work, adrt_slave_free, ADRT_VER_KEY);
+    else
+	tienet_slave_init(port, host, adrt_slave_work, adrt_slave_free, ADRT_VER_KEY);
 
     /* Initialize all workspaces as inactive */
     for (i = 0; i < ADRT_MAX_WORKSPACE_NUM; i++)
@@ -423,12 +426,13 @@ adrt_slave(int port, char *host, int threads)
 static struct option longopts[] =
 {
     { "help",	no_argument,		NULL, 'h' },
+    { "local",	required_argument,	NULL, 'L' },
     { "port",	required_argument,	NULL, 'p' },
     { "threads",	required_argument,	NULL, 't' },
     { "version",	no_argument,		NULL, 'v' },
 };
 #endif
-static char shortopts[] = "Xdhp:t:vh?";
+static char shortopts[] = "XdhL:p:t:vh?";
 
 
 static void finish(int sig)
@@ -448,6 +452,7 @@ static void help(void)
     fprintf(stderr,"%s", "Usage: adrt_slave [options] [host]\n\
   -v\t\tdisplay version\n\
   -h\t\tdisplay help\n\
+  -L ...\tlink to a local master, set by adrt_master -L\n\
   -p\t\tport number\n\
   -t ...\tnumber of threads to launch for processing\n");
 }
@@ -457,7 +462,7 @@ int
 main(int argc, char **argv)
 {
     int		port = 0, c = 0, threads = 0;
-    char		host[64], temp[64];
+    char		host[64], temp[64], local[64];
 
     bu_setprogname(argv[0]);
 
@@ -472,6 +477,7 @@ main(int argc, char **argv)
 
     /* Initialize strings */
     host[0] = 0;
+    local[0] = 0;
     port = 0;
 
 
@@ -490,6 +496,10 @@ main(int argc, char **argv)
 		help();
 		return EXIT_SUCCESS;
 
+	    case 'L':
+		bu_strlcpy(local, bu_optarg, sizeof(local));
+		break;
+
 	    case 'p':
 		port = atoi(bu_optarg);
 		break;
@@ -516,7 +526,9 @@ main(int argc, char **argv)
     if (argc)
 	bu_strlcpy(host, argv[0], 64);
 
-    if (!host[0]) {
+    if (local[0]) {
+	/* spawned by a master on this host, no network setup */
+    } else if (!host[0]) {
 	if (!port)
 	    port = TN_SLAVE_PORT;
 	printf("running as daemon.\n");
@@ -525,7 +537,7 @@ main(int argc, char **argv)
 	    port = TN_MASTER_PORT;
     }
 
-    adrt_slave(port, host, threads);
+    adrt_slave(port, host, threads, local);
 
     return EXIT_SUCCESS;
 }
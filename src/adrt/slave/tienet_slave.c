@@ -38,6 +38,7 @@
 #endif
 
 /* public api headers */
+#include "bu/parallel.h"
 #include "rt/tie.h"
 
 /* adrt headers */
@@ -96,24 +97,16 @@ void tienet_slave_free(void)
 }
 
 
+static void tienet_slave_loop(int slave_socket, tienet_shm_t *shm);
+
+
 void tienet_slave_worker(int port, char *host) {
-    tienet_buffer_t result = {0};
-    tienet_buffer_t buffer = {0};
     struct sockaddr_in master = {0};
     struct sockaddr_in slave = {0};
     struct hostent h;
-    short op = 0;
-    uint32_t size = 0;
     int slave_socket = 0;
-    tienet_buffer_t buffer_comp = {0};
-    unsigned long dest_len = 0;
 
 
-    /* Initialize res_buf to NULL for realloc'ing */
-    TIENET_BUFFER_INIT(result);
-    TIENET_BUFFER_INIT(buffer);
-    TIENET_BUFFER_INIT(buffer_comp);
-
     if (gethostbyname(host)) {
 	h = gethostbyname(host)[0];
     } else {
@@ -147,6 +140,71 @@ void tienet_slave_worker(int port, char *host) {
 	exit(1);
     }
 
+    tienet_slave_loop(slave_socket, NULL);
+}
+
+
+/*
+ * Run as a slave spawned by a master on the same host.  The link is
+ * "fd:shmid[:node]", the inherited end of the master's socket pair,
+ * the shared memory the bulk of the work units and results go
+ * through, and the NUMA node to run on (-1 for any).
+ */
+void tienet_slave_local(const char *link,
+			void fcb_work(tienet_buffer_t *work, tienet_buffer_t *result),
+			void fcb_free(void),
+			int ver_key)
+{
+    int slave_socket = -1, shmid = -1, node = -1;
+
+    tienet_slave_fcb_work = fcb_work;
+    tienet_slave_fcb_free = fcb_free;
+    tienet_slave_ver_key = ver_key;
+
+    if (sscanf(link, "%d:%d:%d", &slave_socket, &shmid, &node) < 2 || slave_socket < 0) {
+	fprintf(stderr, "invalid local link \"%s\", exiting.\n", link);
+	exit(1);
+    }
+
+    /* Before any rendering threads exist, so they start out on the
+     * node too and the geometry they load lands in its memory. */
+    if (node >= 0 && bu_numa_bind(node))
+	fprintf(stderr, "unable to bind to NUMA node %d, continuing unbound.\n", node);
+
+#ifdef TIENET_LOCAL
+    {
+	tienet_shm_t shm;
+
+	if (tienet_shm_attach(&shm, shmid)) {
+	    fprintf(stderr, "unable to attach shared memory %d, exiting.\n", shmid);
+	    exit(1);
+	}
+	tienet_slave_loop(slave_socket, &shm);
+    }
+#else
+    tienet_slave_loop(slave_socket, NULL);
+#endif
+}
+
+
+static void
+tienet_slave_loop(int slave_socket, tienet_shm_t *shm)
+{
+    tienet_buffer_t result = {0};
+    tienet_buffer_t buffer = {0};
+    tienet_buffer_t shm_work = {0};
+    short op = 0;
+    uint32_t size = 0;
+    uint32_t slot = 0;
+    tienet_buffer_t buffer_comp = {0};
+    unsigned long dest_len = 0;
+
+
+    /* Initialize res_buf to NULL for realloc'ing */
+    TIENET_BUFFER_INIT(result);
+    TIENET_BUFFER_INIT(buffer);
+    TIENET_BUFFER_INIT(buffer_comp);
+
     /* receive endian of master (going away) */
     {
 	short tienet_endian;
@@ -172,6 +230,34 @@ void tienet_slave_worker(int port, char *host) {
 	if (op == TN_OP_SHUTDOWN || op == TN_OP_COMPLETE) {
 	    close(slave_socket);
 	    exit(0);
+	} else if (op == TN_OP_SHMWORK && shm) {
+	    /* The work unit is already in shared memory */
+	    tienet_recv(slave_socket, &size, sizeof(uint32_t));
+	    if (size > shm->size) {
+		fprintf(stderr, "work unit of %u bytes does not fit in shared memory, exiting.\n", (unsigned int)size);
+		close(slave_socket);
+		exit(1);
+	    }
+	    shm_work.data = shm->work;
+	    shm_work.size = (uint32_t)shm->size;
+	    shm_work.ind = size;
+
+	    tienet_slave_fcb_work(&shm_work, &result);
+
+	    if (!result.ind)
+		continue;
+
+	    if (result.ind <= shm->size) {
+		/* Alternate result areas so the master can still be reading the last one */
+		memcpy(shm->result[slot], result.data, result.ind);
+
+		op = TN_OP_SHMRESULT;
+		tienet_send(slave_socket, &op, sizeof(short));
+		tienet_send(slave_socket, &result.ind, sizeof(uint32_t));
+		tienet_send(slave_socket, &slot, sizeof(uint32_t));
+		slot ^= 1;
+		continue;
+	    }
 	} else {
 	    tienet_recv(slave_socket, &size, sizeof(uint32_t));
 	    TIENET_BUFFER_SIZE(buffer, size);
@@ -183,43 +269,43 @@ void tienet_slave_worker(int port, char *host) {
 
 	    if (!result.ind)
 		continue;
+	}
 
-	    /* Send Result Back, length of: result + op_code + result_length + compression_length */
-	    TIENET_BUFFER_SIZE(buffer, result.ind+sizeof(short)+sizeof(int)+sizeof(uint32_t));
+	/* Send Result Back, length of: result + op_code + result_length + compression_length */
+	TIENET_BUFFER_SIZE(buffer, result.ind+sizeof(short)+sizeof(int)+sizeof(uint32_t));
 
-	    buffer.ind = 0;
+	buffer.ind = 0;
 
-	    /* Pack Operation Code */
-	    op = TN_OP_RESULT;
-	    TCOPY(short, &op, 0, buffer.data, buffer.ind);
-	    buffer.ind += sizeof(short);
+	/* Pack Operation Code */
+	op = TN_OP_RESULT;
+	TCOPY(short, &op, 0, buffer.data, buffer.ind);
+	buffer.ind += sizeof(short);
 
-	    /* Pack Result Length */
-	    TCOPY(uint32_t, &result.ind, 0, buffer.data, buffer.ind);
-	    buffer.ind += sizeof(uint32_t);
+	/* Pack Result Length */
+	TCOPY(uint32_t, &result.ind, 0, buffer.data, buffer.ind);
+	buffer.ind += sizeof(uint32_t);
 
 #if defined(ADRT_USE_COMPRESSION) && ADRT_USE_COMPRESSION
-	    /* Compress the result buffer */
-	    TIENET_BUFFER_SIZE(buffer_comp, result.ind+32);
+	/* Compress the result buffer */
+	TIENET_BUFFER_SIZE(buffer_comp, result.ind+32);
 
-	    dest_len = buffer_comp.size+32;
-	    compress(buffer_comp.data, &dest_len, result.data, result.ind);
-	    size = (uint32_t)dest_len;
+	dest_len = buffer_comp.size+32;
+	compress(buffer_comp.data, &dest_len, result.data, result.ind);
+	size = (uint32_t)dest_len;
 
-	    /* Pack Compressed Result Length */
-	    TCOPY(uint32_t, &size, 0, buffer.data, buffer.ind);
-	    buffer.ind += sizeof(uint32_t);
+	/* Pack Compressed Result Length */
+	TCOPY(uint32_t, &size, 0, buffer.data, buffer.ind);
+	buffer.ind += sizeof(uint32_t);
 
-	    /* Pack Compressed Result Data */
-	    memcpy(&((char *)buffer.data)[buffer.ind], buffer_comp.data, size);
-	    buffer.ind += size;
+	/* Pack Compressed Result Data */
+	memcpy(&((char *)buffer.data)[buffer.ind], buffer_comp.data, size);
+	buffer.ind += size;
 #else
-	    /* Pack Result Data */
-	    memcpy(&((char *)buffer.data)[buffer.ind], result.data, result.ind);
-	    buffer.ind += result.ind;
+	/* Pack Result Data */
+	memcpy(&((char *)buffer.data)[buffer.ind], result.data, result.ind);
+	buffer.ind += result.ind;
 #endif
-	    tienet_send(slave_socket, buffer.data, buffer.ind);
-	}
+	tienet_send(slave_socket, buffer.data, buffer.ind);
     }
 
     TIENET_BUFFER_FREE(result);
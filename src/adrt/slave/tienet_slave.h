@@ -27,6 +27,7 @@
 #define ADRT_SLAVE_TIENET_SLAVE_H
 
 extern void tienet_slave_init(int port, char *host, void fcb_work(tienet_buffer_t *buffer, tienet_buffer_t *result), void fcb_free(void), int ver_key);
+extern void tienet_slave_local(const char *link, void fcb_work(tienet_buffer_t *buffer, tienet_buffer_t *result), void fcb_free(void), int ver_key);
 extern void tienet_slave_free(void);
 
 #endif
@@ -26,6 +26,22 @@
 #include "bnetwork.h"
 #include "bio.h"
 
+#ifdef TIENET_LOCAL
+#  include <sys/types.h>
+#  include <sys/ipc.h>
+#  include <sys/shm.h>
+#endif
+
+/* at the start of the segment, so that a slave can check what it was given */
+struct tienet_shm_header {
+    uint32_t magic;
+    uint32_t pad;
+    uint64_t size;
+};
+
+#define TIENET_SHM_MAGIC 0x54534d31	/* "TSM1" */
+#define TIENET_SHM_HEADER 64
+
 int
 tienet_send(int tsocket, void* data, size_t size)
 {
@@ -104,6 +120,102 @@ void tienet_sem_wait(tienet_sem_t *sem)
 }
 
 
+static void
+tienet_shm_layout(tienet_shm_t *shm)
+{
+    shm->work = (uint8_t *)shm->base + TIENET_SHM_HEADER;
+    shm->result[0] = shm->work + shm->size;
+    shm->result[1] = shm->result[0] + shm->size;
+}
+
+
+/* Create a segment with areas of size bytes, for a slave to attach to. */
+int
+tienet_shm_create(tienet_shm_t *shm, size_t size)
+{
+#ifdef TIENET_LOCAL
+    struct tienet_shm_header *h;
+
+    shm->shmid = shmget(IPC_PRIVATE, TIENET_SHM_HEADER + 3 * size, IPC_CREAT | 0600);
+    if (shm->shmid < 0)
+	return 1;
+
+    shm->base = shmat(shm->shmid, NULL, 0);
+    if (shm->base == (void *)-1L) {
+	shmctl(shm->shmid, IPC_RMID, NULL);
+	return 1;
+    }
+
+    h = (struct tienet_shm_header *)shm->base;
+    h->magic = TIENET_SHM_MAGIC;
+    h->size = size;
+    shm->size = size;
+    tienet_shm_layout(shm);
+    return 0;
+#else
+    (void)shm;
+    (void)size;
+    return 1;
+#endif
+}
+
+
+/* Attach to the segment a master created. */
+int
+tienet_shm_attach(tienet_shm_t *shm, int shmid)
+{
+#ifdef TIENET_LOCAL
+    struct tienet_shm_header *h;
+
+    shm->shmid = shmid;
+    shm->base = shmat(shmid, NULL, 0);
+    if (shm->base == (void *)-1L)
+	return 1;
+
+    h = (struct tienet_shm_header *)shm->base;
+    if (h->magic != TIENET_SHM_MAGIC) {
+	shmdt(shm->base);
+	return 1;
+    }
+    shm->size = (size_t)h->size;
+    tienet_shm_layout(shm);
+    return 0;
+#else
+    (void)shm;
+    (void)shmid;
+    return 1;
+#endif
+}
+
+
+/*
+ * Mark the segment for removal once both sides have detached, so it
+ * doesn't outlive a master or slave that dies.  Only call this once
+ * the slave has attached.
+ */
+void
+tienet_shm_remove(tienet_shm_t *shm)
+{
+#ifdef TIENET_LOCAL
+    shmctl(shm->shmid, IPC_RMID, NULL);
+#else
+    (void)shm;
+#endif
+}
+
+
+void
+tienet_shm_detach(tienet_shm_t *shm)
+{
+#ifdef TIENET_LOCAL
+    if (shm->base && shm->base != (void *)-1L)
+	shmdt(shm->base);
+#endif
+    shm->base = NULL;
+    shm->work = shm->result[0] = shm->result[1] = NULL;
+}
+
+
 /*
  * Local Variables:
  * tab-width: 8
@@ -37,6 +37,19 @@
 #define	TN_OP_SHUTDOWN		0x0015
 #define TN_OP_OKAY		0x0016
 #define	TN_OP_MESSAGE		0x0017
+#define	TN_OP_SHMWORK		0x0018
+#define	TN_OP_SHMRESULT		0x0019
+
+/*
+ * Slaves spawned by the master on the same host (adrt_master -L) pass
+ * work units and results through a shared memory segment instead of
+ * the socket, which then only carries the op codes and lengths.
+ */
+#if defined(HAVE_SYS_SHM_H) && defined(HAVE_SHMGET) && defined(HAVE_SHMAT) && !defined(_WIN32)
+#  define TIENET_LOCAL 1
+#endif
+
+#define	TIENET_SHM_SIZE		(16*1024*1024)	/* bytes in each area */
 
 #define TIENET_BUFFER_INIT(_b) { \
 	_b.data = NULL; \
@@ -65,6 +78,19 @@ typedef struct tienet_sem_s {
 } tienet_sem_t;
 
 
+/* A work area and two result areas, results alternating between
+ * them so that the slave can write one while the master reads the
+ * other.  Units that do not fit go through the socket as usual.
+ */
+typedef struct tienet_shm_s {
+    int shmid;
+    size_t size;		/* bytes in each area */
+    void *base;
+    uint8_t *work;
+    uint8_t *result[2];
+} tienet_shm_t;
+
+
 int tienet_send(int socket, void* data, size_t size);
 int tienet_recv(int socket, void* data, size_t size);
 
@@ -73,6 +99,11 @@ void tienet_sem_free(tienet_sem_t *sem);
 void tienet_sem_post(tienet_sem_t *sem);
 void tienet_sem_wait(tienet_sem_t *sem);
 
+int tienet_shm_create(tienet_shm_t *shm, size_t size);
+int tienet_shm_attach(tienet_shm_t *shm, int shmid);
+void tienet_shm_remove(tienet_shm_t *shm);
+void tienet_shm_detach(tienet_shm_t *shm);
+
 #endif
 
 /*
@@ -270,6 +270,13 @@ main(int argc, const char **argv)
 	fprintf(fp, " %s", argv[c]);
     fprintf(fp, "\n");
 
+    /* With more than one CPU, tessellate all the leaves in parallel
+     * first - the (serial) region walk then only copies them. */
+    if (ncpu > 1) {
+	tree_state.ts_tess_cache = rt_tess_cache_create();
+	(void)rt_tess_cache_prime(tree_state.ts_tess_cache, dbip, argc-1, (const char **)(argv+1), ncpu, &tree_state);
+    }
+
     /* Walk indicated tree(s).  Each region will be output separately */
     (void) db_walk_tree(dbip, argc-1, (const char **)(argv+1),
 			1,			/* ncpu */
@@ -279,6 +286,9 @@ main(int argc, const char **argv)
 			rt_booltree_leaf_tess,
 			(void *)vlfree);	/* in librt/nmg_bool.c */
 
+    rt_tess_cache_destroy(tree_state.ts_tess_cache);
+    tree_state.ts_tess_cache = NULL;
+
     if (regions_tried>0) {
 	percent = ((double)regions_converted * 100.0) / regions_tried;
 	bu_log("Tried %d regions, %d converted to NMG's successfully.  %g%%\n",
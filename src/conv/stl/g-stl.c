@@ -56,7 +56,7 @@
 }
 
 
-static char usage[] = "[-bvi8] [-xX lvl] [-a abs_tess_tol] [-r rel_tess_tol] [-n norm_tess_tol] [-D dist_calc_tol] [-o output_file_name.stl | -m directory_name] brlcad_db.g object(s)\n";
+static char usage[] = "[-bvi8] [-xX lvl] [-a abs_tess_tol] [-r rel_tess_tol] [-n norm_tess_tol] [-D dist_calc_tol] [-P #_of_CPUs] [-o output_file_name.stl | -m directory_name] brlcad_db.g object(s)\n";
 
 static void
 print_usage(const char *progname)
@@ -65,6 +65,7 @@ print_usage(const char *progname)
 }
 
 static int verbose;
+static int ncpu = 1;			/* Number of processors */
 static int NMG_debug;			/* saved arg of -X, for longjmp handling */
 static int binary = 0;			/* Default output is ASCII */
 static char *output_file = NULL;	/* output filename */
@@ -345,7 +346,7 @@ main(int argc, char *argv[])
     the_model = nmg_mm();
 
     /* Get command line arguments. */
-    while ((c = bu_getopt(argc, argv, "a:b8m:n:o:r:vx:D:X:ih?")) != -1) {
+    while ((c = bu_getopt(argc, argv, "a:b8m:n:o:r:vx:D:P:X:ih?")) != -1) {
 	switch (c) {
 	    case 'a':		/* Absolute tolerance. */
 		ttol.abs = atof(bu_optarg);
@@ -381,6 +382,9 @@ main(int argc, char *argv[])
 		tol.dist_sq = tol.dist * tol.dist;
 		rt_pr_tol(&tol);
 		break;
+	    case 'P':
+		ncpu = atoi(bu_optarg);
+		break;
 	    case 'X':
 		sscanf(bu_optarg, "%x", (unsigned int *)&nmg_debug);
 		NMG_debug = nmg_debug;
@@ -471,6 +475,13 @@ main(int argc, char *argv[])
 	    perror("write");
     }
 
+    /* With more than one CPU, tessellate all the leaves in parallel
+     * first - the (serial) region walk then only copies them. */
+    if (ncpu > 1 && !use_mc) {
+	tree_state.ts_tess_cache = rt_tess_cache_create();
+	(void)rt_tess_cache_prime(tree_state.ts_tess_cache, dbip, argc-1, (const char **)(argv+1), ncpu, &tree_state);
+    }
+
     /* Walk indicated tree(s).  Each region will be output separately */
     (void) db_walk_tree(dbip, argc-1, (const char **)(argv+1),
 			1,
@@ -480,6 +491,9 @@ main(int argc, char *argv[])
 			use_mc?NULL:rt_booltree_leaf_tess,
 			(void *)&gcvwriter);
 
+    rt_tess_cache_destroy(tree_state.ts_tess_cache);
+    tree_state.ts_tess_cache = NULL;
+
     if (regions_tried>0) {
 	percent = ((double)regions_converted * 100) / regions_tried;
 	if (verbose)
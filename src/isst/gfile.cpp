@@ -241,6 +241,7 @@ GFile::load_g(const char *filename, int argc, const char *argv[])
     struct bg_tess_tol ttol;		/* tessellation tolerance in mm */
     struct db_tree_state tree_state;	/* includes tol & model */
     struct isst_nmg_data d;
+    uint64_t key;
 
     RT_DBTS_INIT(&tree_state);
     tree_state.ts_tol = &tol;
@@ -265,6 +266,18 @@ GFile::load_g(const char *filename, int argc, const char *argv[])
 
     tie_check_degenerate = 0;
 
+    BU_ALLOC(tie, struct tie_s);
+    TIE_VAL(tie_init)(this->tie, BU_PAGE_SIZE, TIE_KDTREE_FAST);
+
+    /* FIXME: where is this released? */
+    BU_ALLOC(this->meshes, struct adrt_mesh_s);
+    BU_LIST_INIT(&((this->meshes)->l));
+
+    /* an unchanged model comes straight out of the cache */
+    key = load_g_cache_key(filename, argc, argv, &ttol, &tol);
+    if (load_g_cache_load(this->tie, filename, key, this->meshes) == 0)
+	return 0;
+
     /* make empty NMG model */
     the_model = nmg_mm();
     d.vlfree = &RTG.rtg_vlfree;
@@ -281,19 +294,11 @@ GFile::load_g(const char *filename, int argc, const char *argv[])
 	return -1;
     }
     d.dbip = dbip;
-
-    BU_ALLOC(tie, struct tie_s);
     d.cur_tie = this->tie;
 
     BN_CK_TOL(tree_state.ts_tol);
     BG_CK_TESS_TOL(tree_state.ts_ttol);
 
-    TIE_VAL(tie_init)(d.cur_tie, BU_PAGE_SIZE, TIE_KDTREE_FAST);
-
-    /* FIXME: where is this released? */
-    BU_ALLOC(this->meshes, struct adrt_mesh_s);
-    BU_LIST_INIT(&((this->meshes)->l));
-
     gcvwriter.meshes = &this->meshes;
     gcvwriter.region_end_data.vlfree = &RTG.rtg_vlfree;
     gcvwriter.region_end_data.client_data = &d;
@@ -325,6 +330,8 @@ GFile::load_g(const char *filename, int argc, const char *argv[])
 
     TIE_VAL(tie_prep)(d.cur_tie);
 
+    (void)load_g_cache_save(d.cur_tie, filename, key, this->meshes);
+
     return 0;
 }
 
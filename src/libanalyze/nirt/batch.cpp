@@ -0,0 +1,508 @@
+/*                       B A T C H . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file batch.cpp
+ *
+ * Implementation of Natalie's Interactive Ray-Tracer (NIRT)
+ * functionality specific to the batch subcommand.
+ *
+ * The batch command shoots a whole file of rays at the current
+ * geometry, spread over all available processors, rather than one
+ * ray per "s" command.  Results bypass the fmt machinery and are
+ * written either as CSV (one row per partition) or as a compact
+ * binary stream.  Either way they are ordered by ray id, and rays
+ * sharing an id stay in input order.
+ *
+ * Ray input, in local units:
+ *
+ *   CSV:    x,y,z,dx,dy,dz[,id] per line, after an optional header
+ *           line; '#' starts a comment, and rays without an id are
+ *           numbered by their position.  Files named .csv or .txt.
+ *   binary: 6 doubles (origin, direction) and an int64_t id per ray,
+ *           in native byte order.
+ *
+ * Binary output, native byte order:
+ *
+ *   "NIRTBAT1", uint32_t nregions, then for each region (by region
+ *   index) uint32_t len and len bytes of the region path.
+ *
+ *   Per ray: int64_t id, uint32_t npartitions, then per partition
+ *   uint32_t region index, int32_t region id, and doubles d_in, d_out,
+ *   obliq_in, obliq_out.  Distances are in local units, angles in
+ *   degrees.
+ */
+
+/* BRL-CAD includes */
+#include "common.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "bu/cmd.h"
+#include "bu/parallel.h"
+
+#include "./nirt.h"
+
+#define NIRT_BATCH_CHUNK 64	/* rays handed to a processor at a time */
+#define NIRT_BATCH_MAGIC "NIRTBAT1"
+
+struct nirt_batch_ray {
+    point_t pt;
+    vect_t dir;
+    int64_t id;
+};
+
+struct nirt_batch_part {
+    uint32_t reg_bit;
+    int32_t reg_id;
+    double d_in;
+    double d_out;
+    double obliq_in;
+    double obliq_out;
+};
+
+struct nirt_batch_state {
+    struct rt_i *rtip;
+    struct resource **res;
+    std::vector<nirt_batch_ray> *rays;
+    std::vector<std::vector<nirt_batch_part> > *results;
+    size_t next;		/* first ray not yet handed out */
+    int nworkers;		/* workers started, for picking resources */
+};
+
+
+/* Angle in degrees between the ray and the surface normal, folded
+ * into 0-90 the same way the interactive obliquity is. */
+static double
+_nirt_batch_obliq(const vect_t dir, const vect_t normal)
+{
+    double cos_obl = fabs(VDOT(dir, normal) / (MAGNITUDE(dir) * MAGNITUDE(normal)));
+
+    if (cos_obl > 1.0)
+	cos_obl = 1.0;
+    return acos(cos_obl) * RAD2DEG;
+}
+
+
+static int
+_nirt_batch_hit(struct application *ap, struct partition *part_head, struct seg *UNUSED(finished_segs))
+{
+    std::vector<nirt_batch_part> *parts = (std::vector<nirt_batch_part> *)ap->a_uptr;
+    struct partition *pp;
+    vect_t normal;
+
+    for (pp = part_head->pt_forw; pp != part_head; pp = pp->pt_forw) {
+	nirt_batch_part p;
+
+	p.reg_bit = (uint32_t)pp->pt_regionp->reg_bit;
+	p.reg_id = (int32_t)pp->pt_regionp->reg_regionid;
+	p.d_in = pp->pt_inhit->hit_dist;
+	p.d_out = pp->pt_outhit->hit_dist;
+
+	RT_HIT_NORMAL(normal, pp->pt_inhit, pp->pt_inseg->seg_stp, &ap->a_ray, pp->pt_inflip);
+	p.obliq_in = _nirt_batch_obliq(ap->a_ray.r_dir, normal);
+	RT_HIT_NORMAL(normal, pp->pt_outhit, pp->pt_outseg->seg_stp, &ap->a_ray, pp->pt_outflip);
+	p.obliq_out = _nirt_batch_obliq(ap->a_ray.r_dir, normal);
+
+	parts->push_back(p);
+    }
+
+    return 1;
+}
+
+
+static int
+_nirt_batch_miss(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+
+static void
+_nirt_batch_worker(int UNUSED(cpu), void *ptr)
+{
+    struct nirt_batch_state *bs = (struct nirt_batch_state *)ptr;
+    struct application ap;
+    size_t start, end, i;
+    int w;
+
+    /* the cpu id isn't necessarily dense, so number ourselves */
+    bu_semaphore_acquire(BU_SEM_GENERAL);
+    w = bs->nworkers++;
+    bu_semaphore_release(BU_SEM_GENERAL);
+
+    RT_APPLICATION_INIT(&ap);
+    ap.a_rt_i = bs->rtip;
+    ap.a_resource = bs->res[w];
+    ap.a_hit = _nirt_batch_hit;
+    ap.a_miss = _nirt_batch_miss;
+    ap.a_logoverlap = rt_silent_logoverlap;
+    ap.a_onehit = 0;
+
+    while (1) {
+	bu_semaphore_acquire(BU_SEM_GENERAL);
+	start = bs->next;
+	bs->next += NIRT_BATCH_CHUNK;
+	bu_semaphore_release(BU_SEM_GENERAL);
+
+	if (start >= bs->rays->size())
+	    break;
+	end = start + NIRT_BATCH_CHUNK;
+	if (end > bs->rays->size())
+	    end = bs->rays->size();
+
+	for (i = start; i < end; i++) {
+	    const nirt_batch_ray &r = (*bs->rays)[i];
+	    VMOVE(ap.a_ray.r_pt, r.pt);
+	    VMOVE(ap.a_ray.r_dir, r.dir);
+	    ap.a_uptr = (void *)&(*bs->results)[i];
+	    (void)rt_shootray(&ap);
+	}
+    }
+}
+
+
+static int
+_nirt_batch_add_ray(struct nirt_state *nss, std::vector<nirt_batch_ray> &rays, const double v[6], int64_t id)
+{
+    nirt_batch_ray r;
+
+    VSET(r.pt, v[0], v[1], v[2]);
+    VSET(r.dir, v[3], v[4], v[5]);
+    if (MAGNITUDE(r.dir) < SMALL_FASTF) {
+	nerr(nss, "batch: ray %lld has no direction\n", (long long)id);
+	return -1;
+    }
+    VSCALE(r.pt, r.pt, nss->i->local2base);
+    VUNITIZE(r.dir);
+    r.id = id;
+    rays.push_back(r);
+    return 0;
+}
+
+
+static int
+_nirt_batch_read_csv(struct nirt_state *nss, const char *file, std::vector<nirt_batch_ray> &rays)
+{
+    std::ifstream in(file);
+    std::string line;
+    size_t lnum = 0;
+    int header = 0;
+
+    if (!in.is_open()) {
+	nerr(nss, "batch: unable to open %s\n", file);
+	return -1;
+    }
+
+    while (std::getline(in, line)) {
+	double v[6];
+	long long id;
+	int cnt;
+
+	lnum++;
+	size_t cmt = line.find('#');
+	if (cmt != std::string::npos)
+	    line.erase(cmt);
+	_nirt_trim_whitespace(line);
+	if (!line.length())
+	    continue;
+
+	cnt = sscanf(line.c_str(), "%lf , %lf , %lf , %lf , %lf , %lf , %lld", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &id);
+	if (cnt < 1 && !rays.size() && !header) {
+	    /* allow a column header ahead of the first ray */
+	    header = 1;
+	    continue;
+	}
+	if (cnt < 6) {
+	    nerr(nss, "batch: %s:%zu: expected x,y,z,dx,dy,dz[,id]\n", file, lnum);
+	    return -1;
+	}
+	if (cnt < 7)
+	    id = (long long)rays.size();
+	if (_nirt_batch_add_ray(nss, rays, v, (int64_t)id))
+	    return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+_nirt_batch_read_bin(struct nirt_state *nss, const char *file, std::vector<nirt_batch_ray> &rays)
+{
+    FILE *fp = fopen(file, "rb");
+    double v[6];
+    int64_t id;
+
+    if (!fp) {
+	nerr(nss, "batch: unable to open %s\n", file);
+	return -1;
+    }
+
+    while (fread(v, sizeof(double), 6, fp) == 6) {
+	if (fread(&id, sizeof(int64_t), 1, fp) != 1) {
+	    nerr(nss, "batch: %s: truncated ray record\n", file);
+	    fclose(fp);
+	    return -1;
+	}
+	if (_nirt_batch_add_ray(nss, rays, v, id)) {
+	    fclose(fp);
+	    return -1;
+	}
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+
+static void
+_nirt_batch_write_csv(struct nirt_state *nss, FILE *fp, struct rt_i *rtip, std::vector<nirt_batch_ray> &rays,
+		      std::vector<std::vector<nirt_batch_part> > &results, std::vector<size_t> &order)
+{
+    struct bu_vls row = BU_VLS_INIT_ZERO;
+    double b2l = nss->i->base2local;
+
+    bu_vls_sprintf(&row, "id,partition,region,reg_id,d_in,d_out,los,obliq_in,obliq_out\n");
+    for (size_t i = 0; i < order.size(); i++) {
+	const std::vector<nirt_batch_part> &parts = results[order[i]];
+	long long id = (long long)rays[order[i]].id;
+
+	if (!parts.size())
+	    bu_vls_printf(&row, "%lld,0,,,,,,,\n", id);
+	for (size_t j = 0; j < parts.size(); j++) {
+	    const nirt_batch_part &p = parts[j];
+	    bu_vls_printf(&row, "%lld,%zu,%s,%d,%.17g,%.17g,%.17g,%.17g,%.17g\n", id, j + 1,
+			  rtip->Regions[p.reg_bit]->reg_name, (int)p.reg_id,
+			  p.d_in * b2l, p.d_out * b2l, (p.d_out - p.d_in) * b2l,
+			  p.obliq_in, p.obliq_out);
+	}
+
+	/* write as we go rather than holding the whole table */
+	if (bu_vls_strlen(&row) < BU_PAGE_SIZE * 16)
+	    continue;
+	if (fp)
+	    fwrite(bu_vls_cstr(&row), 1, bu_vls_strlen(&row), fp);
+	else
+	    nout(nss, "%s", bu_vls_cstr(&row));
+	bu_vls_trunc(&row, 0);
+    }
+
+    if (fp)
+	fwrite(bu_vls_cstr(&row), 1, bu_vls_strlen(&row), fp);
+    else
+	nout(nss, "%s", bu_vls_cstr(&row));
+    bu_vls_free(&row);
+}
+
+
+static void
+_nirt_batch_write_bin(struct nirt_state *nss, FILE *fp, struct rt_i *rtip, std::vector<nirt_batch_ray> &rays,
+		      std::vector<std::vector<nirt_batch_part> > &results, std::vector<size_t> &order)
+{
+    double b2l = nss->i->base2local;
+    uint32_t n = (uint32_t)rtip->nregions;
+
+    fwrite(NIRT_BATCH_MAGIC, 1, strlen(NIRT_BATCH_MAGIC), fp);
+    fwrite(&n, sizeof(uint32_t), 1, fp);
+    for (size_t i = 0; i < rtip->nregions; i++) {
+	const char *name = (rtip->Regions[i]) ? rtip->Regions[i]->reg_name : "";
+	uint32_t len = (uint32_t)strlen(name);
+	fwrite(&len, sizeof(uint32_t), 1, fp);
+	fwrite(name, 1, len, fp);
+    }
+
+    for (size_t i = 0; i < order.size(); i++) {
+	const std::vector<nirt_batch_part> &parts = results[order[i]];
+	int64_t id = rays[order[i]].id;
+	uint32_t npart = (uint32_t)parts.size();
+
+	fwrite(&id, sizeof(int64_t), 1, fp);
+	fwrite(&npart, sizeof(uint32_t), 1, fp);
+	for (size_t j = 0; j < parts.size(); j++) {
+	    double d[4];
+	    d[0] = parts[j].d_in * b2l;
+	    d[1] = parts[j].d_out * b2l;
+	    d[2] = parts[j].obliq_in;
+	    d[3] = parts[j].obliq_out;
+	    fwrite(&parts[j].reg_bit, sizeof(uint32_t), 1, fp);
+	    fwrite(&parts[j].reg_id, sizeof(int32_t), 1, fp);
+	    fwrite(d, sizeof(double), 4, fp);
+	}
+    }
+}
+
+
+extern "C" int
+_nirt_cmd_batch(void *ns, int argc, const char *argv[])
+{
+    if (!ns) return -1;
+    struct nirt_state *nss = (struct nirt_state *)ns;
+    struct bu_vls optparse_msg = BU_VLS_INIT_ZERO;
+    struct bu_vls ofile = BU_VLS_INIT_ZERO;
+    struct bu_vls ext = BU_VLS_INIT_ZERO;
+    int help = 0;
+    int bin_in = -1;
+    int bin_out = 0;
+    int ncpu = bu_avail_cpus();
+    int ret = 0;
+    struct bu_opt_desc d[6];
+    BU_OPT(d[0], "h", "help",   "",     NULL,         &help,    "print help and exit");
+    BU_OPT(d[1], "i", "binary-in", "",  NULL,         &bin_in,  "read binary rays regardless of file extension");
+    BU_OPT(d[2], "b", "binary", "",     NULL,         &bin_out, "write binary results (requires -o)");
+    BU_OPT(d[3], "o", "output", "file", &bu_opt_vls,  &ofile,   "write results to file instead of the nirt output");
+    BU_OPT(d[4], "P", "cpus",   "#",    &bu_opt_int,  &ncpu,    "number of processors to use");
+    BU_OPT_NULL(d[5]);
+
+    argv++; argc--;
+
+    int ac = bu_opt_parse(&optparse_msg, argc, argv, d);
+    if (ac < 0) {
+	nerr(nss, "%s", bu_vls_cstr(&optparse_msg));
+	bu_vls_free(&optparse_msg);
+	bu_vls_free(&ofile);
+	return -1;
+    }
+    bu_vls_free(&optparse_msg);
+
+    if (help || ac != 1) {
+	char *hstr = bu_opt_describe(d, NULL);
+	nout(nss, "Usage:  batch [options] rayfile\n%s", hstr);
+	bu_free(hstr, "help str");
+	bu_vls_free(&ofile);
+	return (help) ? 0 : -1;
+    }
+
+    if (bin_out && !bu_vls_strlen(&ofile)) {
+	nerr(nss, "batch: binary output requires an output file (-o)\n");
+	bu_vls_free(&ofile);
+	return -1;
+    }
+
+    if (ncpu < 1)
+	ncpu = 1;
+    if (ncpu > MAX_PSW)
+	ncpu = MAX_PSW;
+
+    /* Same prep logic as the shoot command */
+    if (!_nirt_get_rtip(nss)) {
+	bu_vls_free(&ofile);
+	return 0;
+    }
+    if (nss->i->need_reprep) {
+	if (_nirt_raytrace_prep(nss)) {
+	    nerr(nss, "Error: raytrace prep failed!\n");
+	    bu_vls_free(&ofile);
+	    return -1;
+	}
+    }
+    struct rt_i *rtip = _nirt_get_rtip(nss);
+
+    /* Binary unless the file is named as text */
+    if (bin_in < 0) {
+	bin_in = 1;
+	if (bu_path_component(&ext, argv[0], BU_PATH_EXT)
+	    && (BU_STR_EQUIV(bu_vls_cstr(&ext), "csv") || BU_STR_EQUIV(bu_vls_cstr(&ext), "txt")))
+	    bin_in = 0;
+	bu_vls_free(&ext);
+    }
+
+    std::vector<nirt_batch_ray> rays;
+    ret = (bin_in) ? _nirt_batch_read_bin(nss, argv[0], rays) : _nirt_batch_read_csv(nss, argv[0], rays);
+    if (ret) {
+	bu_vls_free(&ofile);
+	return -1;
+    }
+
+    FILE *fp = NULL;
+    if (bu_vls_strlen(&ofile)) {
+	fp = fopen(bu_vls_cstr(&ofile), (bin_out) ? "wb" : "w");
+	if (!fp) {
+	    nerr(nss, "batch: unable to open %s for writing\n", bu_vls_cstr(&ofile));
+	    bu_vls_free(&ofile);
+	    return -1;
+	}
+    }
+
+    /* Processor 0 shoots with nirt's own resource; the others get
+     * temporary ones that are released once the batch is done. */
+    struct resource **res = (struct resource **)bu_calloc(ncpu, sizeof(struct resource *), "batch resources");
+    res[0] = _nirt_get_resource(nss);
+    for (int i = 1; i < ncpu; i++) {
+	BU_ALLOC(res[i], struct resource);
+	rt_init_resource(res[i], i, rtip);
+    }
+
+    std::vector<std::vector<nirt_batch_part> > results(rays.size());
+    struct nirt_batch_state bs;
+    bs.rtip = rtip;
+    bs.res = res;
+    bs.rays = &rays;
+    bs.results = &results;
+    bs.next = 0;
+    bs.nworkers = 0;
+
+    nmsg(nss, "Shooting %zu rays on %d processor%s...\n", rays.size(), ncpu, (ncpu == 1) ? "" : "s");
+    bu_parallel(_nirt_batch_worker, (size_t)ncpu, (void *)&bs);
+
+    for (int i = 1; i < ncpu; i++) {
+	rt_clean_resource_basic(rtip, res[i]);
+	BU_PTBL_SET(&rtip->rti_resources, i, NULL);
+	BU_FREE(res[i], struct resource);
+    }
+    bu_free(res, "batch resources");
+
+    /* Stable, so rays sharing an id keep their input order */
+    std::vector<size_t> order(rays.size());
+    for (size_t i = 0; i < order.size(); i++)
+	order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&rays](size_t a, size_t b) { return rays[a].id < rays[b].id; });
+
+    if (bin_out) {
+	_nirt_batch_write_bin(nss, fp, rtip, rays, results, order);
+    } else {
+	_nirt_batch_write_csv(nss, fp, rtip, rays, results, order);
+    }
+
+    size_t nhit = 0, npart = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+	nhit += (results[i].size()) ? 1 : 0;
+	npart += results[i].size();
+    }
+    nmsg(nss, "batch: %zu rays, %zu hit, %zu partitions\n", rays.size(), nhit, npart);
+
+    if (fp && fclose(fp)) {
+	nerr(nss, "batch: error writing %s\n", bu_vls_cstr(&ofile));
+	ret = -1;
+    }
+    bu_vls_free(&ofile);
+
+    return ret;
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
@@ -1363,6 +1363,7 @@ static const struct nirt_cmd_desc nirt_descs[] = {
     { "hv",             "set/query gridplane coordinates",               "horz vert [dist]" },
     { "xyz",            "set/query target coordinates",                  "X Y Z" },
     { "s",              "shoot a ray at the target",                     NULL },
+    { "batch",          "shoot a file of rays in parallel",              "[-b] [-i] [-o file] [-P #] rayfile" },
     { "backout",        "back out of model",                             NULL },
     { "useair",         "set/query use of air",                          "<0|1|2|...>" },
     { "units",          "set/query local units",                         "<mm|cm|m|in|ft>" },
@@ -2311,6 +2312,7 @@ const struct bu_cmdtab _libanalyze_nirt_cmds[] = {
     { "hv",             _nirt_cmd_grid_coor},
     { "xyz",            _nirt_cmd_target_coor},
     { "s",              _nirt_cmd_shoot},
+    { "batch",          _nirt_cmd_batch},
     { "backout",        _nirt_cmd_backout},
     { "useair",         _nirt_cmd_use_air},
     { "units",          _nirt_cmd_units},
@@ -423,6 +423,8 @@ void _nirt_diff_destroy(struct nirt_state *nss);
 void _nirt_diff_add_seg(struct nirt_state *nss, nirt_seg *nseg);
 extern "C" int _nirt_cmd_diff(void *ns, int argc, const char *argv[]);
 
+extern "C" int _nirt_cmd_batch(void *ns, int argc, const char *argv[]);
+
 
 // Local Variables:
 // tab-width: 8
@@ -26,10 +26,12 @@
  */
 
 #include "common.h"
+#include <atomic>
 #include <iostream>
 #include <numeric>
 #include <queue>
 #include <string>
+#include "bu/parallel.h"
 #include "bg/chull.h"
 #include "bg/tri_tri.h"
 #include "./cdt.h"
@@ -145,8 +147,10 @@ do_triangulation(struct ON_Brep_CDT_State *s_cdt, int fi)
 	    if (!edge) continue;
 	    const ON_Curve* crv = edge->EdgeCurveOf();
 	    if (!crv) continue;
-	    std::set<bedge_seg_t *> &epsegs = s_cdt->e2polysegs[edge->m_edge_index];
-	    if (!epsegs.size()) continue;
+	    // Faces are meshed in parallel - look up, never insert
+	    std::map<int, std::set<bedge_seg_t *>>::iterator ep_it = s_cdt->e2polysegs.find(edge->m_edge_index);
+	    if (ep_it == s_cdt->e2polysegs.end() || !ep_it->second.size()) continue;
+	    std::set<bedge_seg_t *> &epsegs = ep_it->second;
 	    std::set<bedge_seg_t *>::iterator e_it;
 	    for (e_it = epsegs.begin(); e_it != epsegs.end(); e_it++) {
 		bedge_seg_t *b = *e_it;
@@ -197,6 +201,26 @@ do_triangulation(struct ON_Brep_CDT_State *s_cdt, int fi)
     return refine_triangulation(s_cdt, fmesh, 0, 0);
 }
 
+struct cdt_face_job {
+    struct ON_Brep_CDT_State *s_cdt;
+    std::vector<int> faces;
+    std::vector<int> ok;
+    std::atomic<size_t> next;
+};
+
+static void
+cdt_face_worker(int UNUSED(cpu), void *data)
+{
+    struct cdt_face_job *j = (struct cdt_face_job *)data;
+
+    while (1) {
+	size_t ind = j->next.fetch_add(1);
+	if (ind >= j->faces.size())
+	    break;
+	j->ok[ind] = (do_triangulation(j->s_cdt, j->faces[ind])) ? 1 : 0;
+    }
+}
+
 ON_3dVector
 calc_trim_vnorm(ON_BrepVertex& v, ON_BrepTrim *trim)
 {
@@ -520,17 +544,47 @@ ON_Brep_CDT_Tessellate(struct ON_Brep_CDT_State *s_cdt, int face_cnt, int *faces
 
     // Process all of the faces we have been instructed to process, or (default) all faces.
     // Keep track of failures and successes.
-    int face_failures = 0;
-    int face_successes = 0;
+    struct cdt_face_job fjob;
+    fjob.s_cdt = s_cdt;
+    fjob.next = 0;
     int fc = ((face_cnt == 0) || !faces) ? s_cdt->brep->m_F.Count() : face_cnt;
     for (int i = 0; i < fc; i++) {
 	int fi = ((face_cnt == 0) || !faces) ? i : faces[i];
 	if (fi < s_cdt->brep->m_F.Count()) {
-	    if (do_triangulation(s_cdt, fi)) {
-		face_successes++;
-	    } else {
-		face_failures++;
-	    }
+	    fjob.faces.push_back(fi);
+	}
+    }
+    fjob.ok.resize(fjob.faces.size(), 0);
+
+    // The faces are meshed in parallel.  Once the edges are split, each face
+    // only writes to its own mesh and its own entries in the per-face
+    // containers, so make sure all of those entries exist up front - the
+    // workers then only look up existing keys and never change the shape of
+    // the shared maps.  Points and normals created while meshing go to the
+    // shared lists under a semaphore (see CDT_Add3DPnt).
+    for (size_t i = 0; i < fjob.faces.size(); i++) {
+	int fi = fjob.faces[i];
+	(void)s_cdt->fmeshes[fi];
+	(void)s_cdt->face_rtrees_2d[fi];
+	(void)s_cdt->face_rtrees_3d[fi];
+	(void)s_cdt->strim_pnts[fi];
+	(void)s_cdt->strim_norms[fi];
+	(*s_cdt->min_edge_seg_len)[fi] = DBL_MAX;
+	(*s_cdt->max_edge_seg_len)[fi] = 0;
+    }
+    if (fjob.faces.size() > 1) {
+	bu_parallel(cdt_face_worker, 0, (void *)&fjob);
+    } else {
+	cdt_face_worker(0, (void *)&fjob);
+    }
+
+    int face_failures = 0;
+    int face_successes = 0;
+    for (size_t i = 0; i < fjob.ok.size(); i++) {
+	if (fjob.ok[i]) {
+	    face_successes++;
+	} else {
+	    face_failures++;
 	}
     }
 
@@ -604,12 +658,17 @@ ON_Brep_CDT_Mesh(
 
     /* We know now the final triangle set.  We need to build up the set of
      * unique points and normals to generate a mesh containing only the
-     * information actually used by the final triangle set. */
-    std::set<ON_3dPoint *> vfpnts;
-    std::set<ON_3dPoint *> vfnormals;
+     * information actually used by the final triangle set.  They are
+     * numbered in the order the faces first use them, rather than by
+     * address, so the output doesn't depend on how (or on which thread)
+     * the points were allocated. */
+    std::vector<ON_3dPoint *> vfpnts;
+    std::vector<ON_3dPoint *> vfnormals;
     std::set<ON_3dPoint *> flip_normals;
+    std::map<ON_3dPoint *, int> on_pnt_to_bot_pnt;
+    std::map<ON_3dPoint *, int> on_norm_to_bot_norm;
     for (size_t fi = 0; fi < active_faces.size(); fi++) {
-	cdt_mesh_t *fmesh = &s_cdt->fmeshes[(int)fi];
+	cdt_mesh_t *fmesh = &s_cdt->fmeshes[active_faces[fi]];
 	RTree<size_t, double, 3>::Iterator tree_it;
 	fmesh->tris_tree.GetFirst(tree_it);
 	size_t t_ind;
@@ -619,7 +678,10 @@ ON_Brep_CDT_Mesh(
 	    tri = fmesh->tris_vect[t_ind];
 	    for (size_t j = 0; j < 3; j++) {
 		ON_3dPoint *p3d = fmesh->pnts[tri.v[j]];
-		vfpnts.insert(p3d);
+		if (on_pnt_to_bot_pnt.find(p3d) == on_pnt_to_bot_pnt.end()) {
+		    on_pnt_to_bot_pnt[p3d] = (int)vfpnts.size();
+		    vfpnts.push_back(p3d);
+		}
 		ON_3dPoint *onorm = NULL;
 		if (s_cdt->singular_vert_to_norms->find(p3d) != s_cdt->singular_vert_to_norms->end()) {
 		    // Use calculated normal for singularity points
@@ -628,7 +690,10 @@ ON_Brep_CDT_Mesh(
 		    onorm = fmesh->normals[fmesh->nmap[tri.v[j]]];
 		}
 		if (onorm) {
-		    vfnormals.insert(onorm);
+		    if (on_norm_to_bot_norm.find(onorm) == on_norm_to_bot_norm.end()) {
+			on_norm_to_bot_norm[onorm] = (int)vfnormals.size();
+			vfnormals.push_back(onorm);
+		    }
 		    if (fmesh->m_bRev) {
 			flip_normals.insert(onorm);
 		    }
@@ -653,20 +718,16 @@ ON_Brep_CDT_Mesh(
 	*face_normals = (int *)bu_calloc(triangle_cnt*3, sizeof(int), "new face_normals array");
     }
 
-    // Populate the arrays and map the ON containers to their corresponding BoT array entries
-    std::set<ON_3dPoint *>::iterator p_it;
+    // Populate the arrays from the ON containers, using the BoT array
+    // indices assigned above
 
-    // Index vertex points and assign them to the BoT array
-    std::map<ON_3dPoint *, int> on_pnt_to_bot_pnt;
-    int pnt_ind = 0;
-    for (p_it = vfpnts.begin(); p_it != vfpnts.end(); p_it++) {
-	ON_3dPoint *vp = *p_it;
+    // Assign vertex points to the BoT array
+    for (size_t pnt_ind = 0; pnt_ind < vfpnts.size(); pnt_ind++) {
+	ON_3dPoint *vp = vfpnts[pnt_ind];
 	(*vertices)[pnt_ind*3] = vp->x;
 	(*vertices)[pnt_ind*3+1] = vp->y;
 	(*vertices)[pnt_ind*3+2] = vp->z;
-	on_pnt_to_bot_pnt[vp] = pnt_ind;
-	(*s_cdt->bot_pnt_to_on_pnt)[pnt_ind] = vp;
-	pnt_ind++;
+	(*s_cdt->bot_pnt_to_on_pnt)[(int)pnt_ind] = vp;
     }
 
     // Index vertex normal vectors and assign them to the BoT array.  Normal
@@ -678,11 +739,9 @@ ON_Brep_CDT_Mesh(
     //
     // The mapping of 2D triangle point to its associated normal is the
     // responsibility of the  p2t_to_on3_norm_map container
-    std::map<ON_3dPoint *, int> on_norm_to_bot_norm;
-    size_t norm_ind = 0;
     if (normals) {
-	for (p_it = vfnormals.begin(); p_it != vfnormals.end(); p_it++) {
-	    ON_3dPoint *vn = *p_it;
+	for (size_t norm_ind = 0; norm_ind < vfnormals.size(); norm_ind++) {
+	    ON_3dPoint *vn = vfnormals[norm_ind];
 	    ON_3dVector vnf(*vn);
 	    if (flip_normals.find(vn) != flip_normals.end()) {
 		vnf = -1 *vnf;
@@ -690,8 +749,6 @@ ON_Brep_CDT_Mesh(
 	    (*normals)[norm_ind*3] = vnf.x;
 	    (*normals)[norm_ind*3+1] = vnf.y;
 	    (*normals)[norm_ind*3+2] = vnf.z;
-	    on_norm_to_bot_norm[vn] = (int)norm_ind;
-	    norm_ind++;
 	}
     }
 
@@ -699,7 +756,7 @@ ON_Brep_CDT_Mesh(
     // 3D points should be geometrically unique in this final container.
     int face_cnt = 0;
     for (size_t fi = 0; fi < active_faces.size(); fi++) {
-	cdt_mesh_t *fmesh = &s_cdt->fmeshes[(int)fi];
+	cdt_mesh_t *fmesh = &s_cdt->fmeshes[active_faces[fi]];
 	RTree<size_t, double, 3>::Iterator tree_it;
 	fmesh->tris_tree.GetFirst(tree_it);
 	size_t t_ind;
@@ -26,9 +26,11 @@
  */
 
 #include "common.h"
+#include <atomic>
 #include <queue>
 #include <numeric>
 #include <iterator>
+#include "bu/parallel.h"
 #include "bg/chull.h"
 #include "./cdt.h"
 
@@ -1470,6 +1472,67 @@ tol_linear_edges_split(struct ON_Brep_CDT_State *s_cdt)
 
 }
 
+#define CLOSE_EDGE_PARALLEL_MIN 64
+
+struct close_edge_job {
+    struct ON_Brep_CDT_State *s_cdt;
+    RTree<void *, double, 2> *rtree;
+    std::vector<cpolyedge_t *> *ws;
+    std::atomic<size_t> next;
+};
+
+static void
+close_edge_worker(int UNUSED(cpu), void *data)
+{
+    struct close_edge_job *j = (struct close_edge_job *)data;
+
+    while (1) {
+	size_t ind = j->next.fetch_add(1);
+	if (ind >= j->ws->size())
+	    break;
+	cpolyedge_t *tseg = (*j->ws)[ind];
+	ON_2dPoint p2d1(tseg->polygon->pnts_2d[tseg->v2d[0]].first, tseg->polygon->pnts_2d[tseg->v2d[0]].second);
+	ON_2dPoint p2d2(tseg->polygon->pnts_2d[tseg->v2d[1]].first, tseg->polygon->pnts_2d[tseg->v2d[1]].second);
+
+	// Trim 2D bbox
+	ON_Line line(p2d1, p2d2);
+	ON_BoundingBox bb = line.BoundingBox();
+	bb.m_max.x = bb.m_max.x + ON_ZERO_TOLERANCE;
+	bb.m_max.y = bb.m_max.y + ON_ZERO_TOLERANCE;
+	bb.m_min.x = bb.m_min.x - ON_ZERO_TOLERANCE;
+	bb.m_min.y = bb.m_min.y - ON_ZERO_TOLERANCE;
+	double dist = p2d1.DistanceTo(p2d2);
+	double bdist = 0.5*dist;
+	double xdist = bb.m_max.x - bb.m_min.x;
+	double ydist = bb.m_max.y - bb.m_min.y;
+	if (xdist < bdist) {
+	    bb.m_min.x = bb.m_min.x - 0.51*bdist;
+	    bb.m_max.x = bb.m_max.x + 0.51*bdist;
+	}
+	if (ydist < bdist) {
+	    bb.m_min.y = bb.m_min.y - 0.51*bdist;
+	    bb.m_max.y = bb.m_max.y + 0.51*bdist;
+	}
+
+	double tMin[2];
+	tMin[0] = bb.Min().x;
+	tMin[1] = bb.Min().y;
+	double tMax[2];
+	tMax[0] = bb.Max().x;
+	tMax[1] = bb.Max().y;
+
+	//plot_ce_bbox(s_cdt, tseg, "c.p3");
+
+	// Edge context info
+	struct rtree_minsplit_context a_context;
+	a_context.s_cdt = j->s_cdt;
+	a_context.cseg = tseg;
+
+	// Do the search
+	j->rtree->Search(tMin, tMax, MinSplit2dCallback, (void *)&a_context);
+    }
+}
+
 void
 refine_close_edges(struct ON_Brep_CDT_State *s_cdt)
 {
@@ -1490,52 +1553,20 @@ refine_close_edges(struct ON_Brep_CDT_State *s_cdt)
 
 	    bool split_check = false;
 
-	    // TODO - with the status determination being recorded in the cpolyedge_t structure
-	    // itself, this loop should be (in principle) suitable for bu_parallel - we're not
-	    // doing any splitting at this point - searching is a read only activity once
-	    // the initial data containers are set up
-	    std::vector<cpolyedge_t *>::iterator w_it;
-	    for (w_it = ws.begin(); w_it != ws.end(); w_it++) {
-		cpolyedge_t *tseg = *w_it;
-		ON_2dPoint p2d1(tseg->polygon->pnts_2d[tseg->v2d[0]].first, tseg->polygon->pnts_2d[tseg->v2d[0]].second);
-		ON_2dPoint p2d2(tseg->polygon->pnts_2d[tseg->v2d[1]].first, tseg->polygon->pnts_2d[tseg->v2d[1]].second);
-
-		// Trim 2D bbox
-		ON_Line line(p2d1, p2d2);
-		ON_BoundingBox bb = line.BoundingBox();
-		bb.m_max.x = bb.m_max.x + ON_ZERO_TOLERANCE;
-		bb.m_max.y = bb.m_max.y + ON_ZERO_TOLERANCE;
-		bb.m_min.x = bb.m_min.x - ON_ZERO_TOLERANCE;
-		bb.m_min.y = bb.m_min.y - ON_ZERO_TOLERANCE;
-		double dist = p2d1.DistanceTo(p2d2);
-		double bdist = 0.5*dist;
-		double xdist = bb.m_max.x - bb.m_min.x;
-		double ydist = bb.m_max.y - bb.m_min.y;
-		if (xdist < bdist) {
-		    bb.m_min.x = bb.m_min.x - 0.51*bdist;
-		    bb.m_max.x = bb.m_max.x + 0.51*bdist;
-		}
-		if (ydist < bdist) {
-		    bb.m_min.y = bb.m_min.y - 0.51*bdist;
-		    bb.m_max.y = bb.m_max.y + 0.51*bdist;
-		}
-
-		double tMin[2];
-		tMin[0] = bb.Min().x;
-		tMin[1] = bb.Min().y;
-		double tMax[2];
-		tMax[0] = bb.Max().x;
-		tMax[1] = bb.Max().y;
-
-		//plot_ce_bbox(s_cdt, tseg, "c.p3");
-
-		// Edge context info
-		struct rtree_minsplit_context a_context;
-		a_context.s_cdt = s_cdt;
-		a_context.cseg = tseg;
-
-		// Do the search
-		s_cdt->face_rtrees_2d[face.m_face_index].Search(tMin, tMax, MinSplit2dCallback, (void *)&a_context);
+	    // With the status determination being recorded in the cpolyedge_t
+	    // structure itself, each search only writes to its own segment -
+	    // we're not doing any splitting at this point, and searching is a
+	    // read only activity once the initial data containers are set up -
+	    // so the searches are run in parallel.
+	    struct close_edge_job cjob;
+	    cjob.s_cdt = s_cdt;
+	    cjob.rtree = &s_cdt->face_rtrees_2d[face.m_face_index];
+	    cjob.ws = &ws;
+	    cjob.next = 0;
+	    if (ws.size() > CLOSE_EDGE_PARALLEL_MIN) {
+		bu_parallel(close_edge_worker, 0, (void *)&cjob);
+	    } else {
+		close_edge_worker(0, (void *)&cjob);
 	    }
 
 	    // If we need to split, do so.  We need to process as a set,
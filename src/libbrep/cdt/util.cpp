@@ -26,6 +26,7 @@
  */
 
 #include "common.h"
+#include "bu/parallel.h"
 #include "bu/str.h"
 #include "bg/tri_ray.h"
 #include "./cdt.h"
@@ -451,18 +452,32 @@ cdt_ainfo(int fid, int vid, int tid, int eid, fastf_t x2d, fastf_t y2d, fastf_t
     return a;
 }
 
+static int
+cdt_sem_pnts(void)
+{
+    static int sem_cdt_pnts = bu_semaphore_register("SEM_CDT_PNTS");
+    return sem_cdt_pnts;
+}
+
 void
 CDT_Add3DPnt(struct ON_Brep_CDT_State *s, ON_3dPoint *p, int fid, int vid, int tid, int eid, fastf_t x2d, fastf_t y2d)
 {
+    // Faces are meshed in parallel, and all of them record their new points here
+    struct cdt_audit_info *ainfo = cdt_ainfo(fid, vid, tid, eid, x2d, y2d, 0.0, 0.0, 0.0);
+    bu_semaphore_acquire(cdt_sem_pnts());
     s->w3dpnts->push_back(p);
-    (*s->pnt_audit_info)[p] = cdt_ainfo(fid, vid, tid, eid, x2d, y2d, 0.0, 0.0, 0.0);
+    (*s->pnt_audit_info)[p] = ainfo;
+    bu_semaphore_release(cdt_sem_pnts());
 }
 
 void
 CDT_Add3DNorm(struct ON_Brep_CDT_State *s, ON_3dPoint *normal, ON_3dPoint *vert, int fid, int vid, int tid, int eid, fastf_t x2d, fastf_t y2d)
 {
+    struct cdt_audit_info *ainfo = cdt_ainfo(fid, vid, tid, eid, x2d, y2d, vert->x, vert->y, vert->z);
+    bu_semaphore_acquire(cdt_sem_pnts());
     s->w3dnorms->push_back(normal);
-    (*s->pnt_audit_info)[normal] = cdt_ainfo(fid, vid, tid, eid, x2d, y2d, vert->x, vert->y, vert->z);
+    (*s->pnt_audit_info)[normal] = ainfo;
+    bu_semaphore_release(cdt_sem_pnts());
 }
 
 // Digest tessellation tolerances...
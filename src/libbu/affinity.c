@@ -49,30 +49,344 @@
 #  include <windows.h>
 #endif
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bu/debug.h"
+#include "bu/log.h"
 #include "bu/parallel.h"
+#include "bu/str.h"
+#include "./parallel.h"
+
 
-int
-parallel_set_affinity(int cpu)
-{
 #if defined(HAVE_PTHREAD_H) && defined(CPU_ZERO) && (defined(HAVE_SYS_CPUSET_H) || defined(HAVE_SCHED_H))
+#  define AFFINITY_CPUSET 1
+#  if defined(HAVE_SYS_CPUSET_H) || defined(HAVE_PTHREAD_NP_H)
+typedef cpuset_t affinity_set_t;
+#  else
+typedef cpu_set_t affinity_set_t;
+#  endif
+#endif
 
-    /* Linux and BSD pthread affinity */
+#define AFFINITY_MAX_CPUS 1024
+#define AFFINITY_MAX_NODES 64
 
-#if defined(HAVE_SYS_CPUSET_H) || defined(HAVE_PTHREAD_NP_H)
-    cpuset_t set_of_cpus;
-#else
-    cpu_set_t set_of_cpus;
+/*
+ * Processor topology.  The usable processors are kept ordered by
+ * NUMA node so a compact placement is a walk down cpus[] and a spread
+ * placement strides across the node ranges.  Node numbers handed out
+ * by bu_numa_node() are dense indices into node_first[], not the
+ * operating system's node ids.
+ */
+static struct {
+    int init;
+    int nnodes;
+    int ncpus;
+    int cpus[AFFINITY_MAX_CPUS];		/* usable processors, by node */
+    int node_first[AFFINITY_MAX_NODES + 1];	/* start of each node in cpus[] */
+    signed char cpu_node[AFFINITY_MAX_CPUS];	/* node of each processor, -1 if unusable */
+} numa;
+
+
+#if defined(__linux__) && defined(AFFINITY_CPUSET)
+/* Add the processors of a sysfs cpulist ("0-3,8-11") to the current node */
+static void
+numa_read_cpulist(FILE *fp, const affinity_set_t *mask)
+{
+    char buf[4096];
+    char *c = buf;
+
+    if (!bu_fgets(buf, sizeof(buf), fp))
+	return;
+
+    while (*c && *c != '\n') {
+	long first, last, cpu;
+	char *end;
+
+	first = last = strtol(c, &end, 10);
+	if (end == c)
+	    break;
+	c = end;
+	if (*c == '-') {
+	    last = strtol(c + 1, &end, 10);
+	    c = end;
+	}
+	if (*c == ',')
+	    c++;
+
+	for (cpu = first; cpu <= last && cpu < AFFINITY_MAX_CPUS; cpu++) {
+	    if (mask && !CPU_ISSET(cpu, mask))
+		continue;
+	    if (numa.cpu_node[cpu] >= 0 || numa.ncpus >= AFFINITY_MAX_CPUS)
+		continue;
+	    numa.cpu_node[cpu] = (signed char)numa.nnodes;
+	    numa.cpus[numa.ncpus++] = (int)cpu;
+	}
+    }
+}
+#endif
+
+
+static void
+numa_init(void)
+{
+    int i;
+
+    for (i = 0; i < AFFINITY_MAX_CPUS; i++)
+	numa.cpu_node[i] = -1;
+    numa.nnodes = 0;
+    numa.ncpus = 0;
+    numa.node_first[0] = 0;
+
+#if defined(__linux__) && defined(AFFINITY_CPUSET)
+    {
+	affinity_set_t mask;
+	int have_mask = !sched_getaffinity(0, sizeof(mask), &mask);
+	int node;
+
+	for (node = 0; node < AFFINITY_MAX_NODES; node++) {
+	    char path[128];
+	    FILE *fp;
+
+	    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+	    fp = fopen(path, "r");
+	    if (!fp)
+		continue;
+	    numa_read_cpulist(fp, have_mask ? &mask : NULL);
+	    fclose(fp);
+
+	    /* nodes without usable processors (memory only, or masked off) are skipped */
+	    if (numa.ncpus > numa.node_first[numa.nnodes]) {
+		numa.nnodes++;
+		numa.node_first[numa.nnodes] = numa.ncpus;
+	    }
+	}
+    }
 #endif
-    int ret;
-    int ncpus = bu_avail_cpus();
+
+    /* unknown topology, one node holding every processor */
+    if (!numa.nnodes) {
+	int ncpus = (int)bu_avail_cpus();
+
+	if (ncpus > AFFINITY_MAX_CPUS)
+	    ncpus = AFFINITY_MAX_CPUS;
+	for (i = 0; i < ncpus; i++) {
+	    numa.cpus[i] = i;
+	    numa.cpu_node[i] = 0;
+	}
+	numa.ncpus = ncpus;
+	numa.nnodes = 1;
+	numa.node_first[1] = ncpus;
+    }
+
+    if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL)) {
+	for (i = 0; i < numa.nnodes; i++)
+	    bu_log("NUMA node %d: %d processors\n", i, numa.node_first[i+1] - numa.node_first[i]);
+    }
+}
+
+
+static void
+numa_check(void)
+{
+    if (numa.init)
+	return;
+
+    bu_semaphore_acquire(BU_SEM_THREAD);
+    if (!numa.init) {
+	numa_init();
+	numa.init = 1;
+    }
+    bu_semaphore_release(BU_SEM_THREAD);
+}
+
+
+#ifdef AFFINITY_CPUSET
+static int
+affinity_set_cpu(int cpu)
+{
+    affinity_set_t set_of_cpus;
 
     CPU_ZERO(&set_of_cpus);
 
     /* Set affinity to a single CPU core */
-    CPU_SET(cpu % ncpus, &set_of_cpus);
-    ret = pthread_setaffinity_np(pthread_self(), sizeof(set_of_cpus), &set_of_cpus);
+    CPU_SET(cpu, &set_of_cpus);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set_of_cpus), &set_of_cpus);
+}
+#endif
+
+
+/* Processor for the given parallel ID under a placement policy */
+static int
+numa_cpu(int id, int policy)
+{
+    int node, n;
+
+    /* parallel IDs handed to worker threads start at 1 */
+    if (id > 0)
+	id--;
+
+    if (policy == PARALLEL_AFFINITY_SPREAD) {
+	node = id % numa.nnodes;
+	n = numa.node_first[node+1] - numa.node_first[node];
+	return numa.cpus[numa.node_first[node] + (id / numa.nnodes) % n];
+    }
+
+    return numa.cpus[id % numa.ncpus];
+}
+
+
+int
+parallel_affinity_policy(const char *str)
+{
+    if (!str || !*str)
+	return PARALLEL_AFFINITY_NONE;
+
+    if (BU_STR_EQUIV(str, "compact"))
+	return PARALLEL_AFFINITY_COMPACT;
+    if (BU_STR_EQUIV(str, "spread"))
+	return PARALLEL_AFFINITY_SPREAD;
+
+    /* historic behavior, any non-zero value pins IDs to processors in order */
+    return strtol(str, NULL, 0x10) ? PARALLEL_AFFINITY_CORE : PARALLEL_AFFINITY_NONE;
+}
+
+
+int
+parallel_set_affinity_policy(int id, int policy)
+{
+    if (policy != PARALLEL_AFFINITY_COMPACT && policy != PARALLEL_AFFINITY_SPREAD)
+	return parallel_set_affinity(id);
+
+    numa_check();
+
+#ifdef AFFINITY_CPUSET
+    return affinity_set_cpu(numa_cpu(id, policy));
+#else
+    /* the topology is a single node here, so it is the same placement */
+    return parallel_set_affinity(numa_cpu(id, policy));
+#endif
+}
+
+
+int
+bu_numa_nodes(void)
+{
+    numa_check();
+    return numa.nnodes;
+}
+
+
+int
+bu_numa_node(void)
+{
+    numa_check();
+
+    if (numa.nnodes < 2)
+	return 0;
+
+#if defined(__linux__) && defined(AFFINITY_CPUSET)
+    {
+	int cpu = sched_getcpu();
+	if (cpu >= 0 && cpu < AFFINITY_MAX_CPUS && numa.cpu_node[cpu] >= 0)
+	    return numa.cpu_node[cpu];
+    }
+#endif
+
+    return 0;
+}
+
+
+int
+bu_numa_bind(int node)
+{
+    numa_check();
+
+    if (node < 0 || node >= numa.nnodes)
+	return -1;
+
+#ifdef AFFINITY_CPUSET
+    {
+	affinity_set_t set_of_cpus;
+	int i;
+
+	CPU_ZERO(&set_of_cpus);
+	for (i = numa.node_first[node]; i < numa.node_first[node+1]; i++)
+	    CPU_SET(numa.cpus[i], &set_of_cpus);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set_of_cpus), &set_of_cpus) ? -1 : 0;
+    }
+#else
+    /* a single node holding every processor */
+    return 0;
+#endif
+}
 
-    return ret;
+
+#ifdef AFFINITY_CPUSET
+struct numa_run_data {
+    void (*func)(int, void *);
+    void *data;
+    int next;	/* next node to hand out, under BU_SEM_THREAD */
+};
+
+
+static void
+numa_run_node(int UNUSED(id), void *arg)
+{
+    struct numa_run_data *rd = (struct numa_run_data *)arg;
+    int node;
+
+    bu_semaphore_acquire(BU_SEM_THREAD);
+    node = rd->next++;
+    bu_semaphore_release(BU_SEM_THREAD);
+    if (node >= numa.nnodes)
+	return;
+
+    (void)bu_numa_bind(node);
+    rd->func(node, rd->data);
+}
+#endif
+
+
+void
+bu_numa_run(void (*func)(int node, void *data), void *data)
+{
+    if (!func)
+	return;
+
+    numa_check();
+
+#ifdef AFFINITY_CPUSET
+    if (numa.nnodes > 1) {
+	struct numa_run_data rd;
+
+	/* run as bu_parallel() workers, so the nodes' threads have
+	 * their own parallel IDs and what they allocate is counted
+	 * against the caller (see bu_malloc_bytes()) */
+	rd.func = func;
+	rd.data = data;
+	rd.next = 0;
+	bu_parallel(numa_run_node, (size_t)numa.nnodes, &rd);
+
+	/* any node whose thread could not be started */
+	while (rd.next < numa.nnodes)
+	    func(rd.next++, data);
+	return;
+    }
+#endif
+
+    func(0, data);
+}
+
+
+int
+parallel_set_affinity(int cpu)
+{
+#if defined(AFFINITY_CPUSET)
+
+    /* Linux and BSD pthread affinity */
+    return affinity_set_cpu(cpu % bu_avail_cpus());
 
 #elif defined(HAVE_MACH_THREAD_POLICY_H)
 
@@ -302,6 +302,8 @@ bu_identify_magic(register uint32_t magic)
 	    return "light magic";
 	case MF_MAGIC:
 	    return "mf magic";
+	case MF_MAGIC_V1:
+	    return "mf magic (v1, no mf_render_batch)";
 	case PIXEL_EXT_MAGIC:
 	    return "librt pixel_ext";
 	case PL_MAGIC:
@@ -314,6 +316,8 @@ bu_identify_magic(register uint32_t magic)
 	    return "librt resource";
 	case RTI_MAGIC:
 	    return "rt_i";
+	case SHADE_BATCH_MAGIC:
+	    return "liboptical shade_batch";
 	case WDB_METABALLPT_MAGIC:
 	    return "wdb metaball pt";
 	case WDB_PIPESEG_MAGIC:
@@ -23,6 +23,9 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <string.h>
+#ifdef HAVE_MALLOC_H
+#  include <malloc.h>
+#endif
 #ifdef HAVE_SYS_IPC_H
 #  include <sys/ipc.h>
 #endif
@@ -38,6 +41,8 @@
 #include "bu/exit.h"
 #include "bu/log.h"
 
+#include "./parallel.h"
+
 /* strict c89 doesn't declare posix_memalign */
 #ifndef HAVE_DECL_POSIX_MEMALIGN
 extern int posix_memalign(void **, size_t, size_t);
@@ -45,6 +50,16 @@ extern int posix_memalign(void **, size_t, size_t);
 
 int BU_SEM_MALLOC;
 
+/* bytes held per bu_parallel() thread, read and updated under
+ * BU_SEM_MALLOC.  Counters are a cache line apart, so that a thread
+ * updating its own does not evict the lines of the others.
+ */
+#define MALLOC_LINE 64
+static union {
+    ssize_t bytes;
+    char pad[MALLOC_LINE];
+} malloc_bytes[MAX_PSW];
+
 
 /**
  * this controls whether to semaphore protect malloc calls
@@ -66,6 +81,30 @@ typedef enum {
 } alloc_t;
 
 
+/**
+ * size of a live allocation, or 0 if the C library can't tell us.
+ * '_req' is what was asked for, used as a stand-in when counting up.
+ */
+#if defined(HAVE_MALLOC_USABLE_SIZE)
+#  define ALLOC_SIZE(_ptr, _req) malloc_usable_size(_ptr)
+#  define FREE_SIZE(_ptr) malloc_usable_size(_ptr)
+#elif defined(HAVE_WINDOWS_H) && !defined(HAVE_POSIX_MEMALIGN)
+#  define ALLOC_SIZE(_ptr, _req) _msize(_ptr)
+#  define FREE_SIZE(_ptr) _msize(_ptr)
+#else
+#  define ALLOC_SIZE(_ptr, _req) (_req)
+#  define FREE_SIZE(_ptr) 0
+#endif
+
+
+static int
+malloc_cpu(void)
+{
+    int cpu = bu_parallel_id();
+    return (cpu >= 0 && cpu < MAX_PSW) ? cpu : 0;
+}
+
+
 /* non-published globals */
 extern const char bu_vls_message[];
 extern const char bu_strdup_message[];
@@ -147,6 +186,8 @@ alloc(alloc_t type, size_t cnt, size_t sz, const char *str)
     }
 
     bu_n_malloc++;
+    if (LIKELY(ptr != NULL))
+	malloc_bytes[malloc_cpu()].bytes += (ssize_t)ALLOC_SIZE(ptr, cnt*size);
 
 #if defined(MALLOC_NOT_MP_SAFE)
     bu_semaphore_release(BU_SEM_MALLOC);
@@ -204,6 +245,7 @@ bu_free(void *ptr, const char *str)
      */
     *((uint32_t *)ptr) = 0xFFFFFFFF;	/* zappo! */
 
+    malloc_bytes[malloc_cpu()].bytes -= (ssize_t)FREE_SIZE(ptr);
     free(ptr);
     bu_n_free++;
 
@@ -257,7 +299,12 @@ bu_realloc(register void *ptr, size_t siz, const char *str)
     bu_semaphore_acquire(BU_SEM_MALLOC);
 #endif
 
-    ptr = realloc(ptr, siz);
+    {
+	ssize_t oldsiz = (ssize_t)FREE_SIZE(ptr);
+	ptr = realloc(ptr, siz);
+	if (LIKELY(ptr != NULL))
+	    malloc_bytes[malloc_cpu()].bytes += (ssize_t)ALLOC_SIZE(ptr, siz) - oldsiz;
+    }
     bu_n_realloc++;
 
 #if defined(MALLOC_NOT_MP_SAFE)
@@ -276,6 +323,37 @@ bu_realloc(register void *ptr, size_t siz, const char *str)
 }
 
 
+void
+malloc_bytes_add(int cpu, ssize_t nbytes)
+{
+    bu_semaphore_acquire(BU_SEM_MALLOC);
+    malloc_bytes[(cpu >= 0 && cpu < MAX_PSW) ? cpu : 0].bytes += nbytes;
+    bu_semaphore_release(BU_SEM_MALLOC);
+}
+
+
+ssize_t
+bu_malloc_bytes(int cpu)
+{
+    ssize_t total = 0;
+    int i;
+
+    if (cpu >= MAX_PSW)
+	return 0;
+
+    bu_semaphore_acquire(BU_SEM_MALLOC);
+    if (cpu >= 0) {
+	total = malloc_bytes[cpu].bytes;
+    } else {
+	for (i = 0; i < MAX_PSW; i++)
+	    total += malloc_bytes[i].bytes;
+    }
+    bu_semaphore_release(BU_SEM_MALLOC);
+
+    return total;
+}
+
+
 void
 bu_prmem(const char *str)
 {
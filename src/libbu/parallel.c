@@ -152,6 +152,7 @@ struct thread_data {
     int cpu_id;
     int affinity;
     struct parallel_info *parent;
+    ssize_t malloc_bytes;	/* net bytes allocated by the thread */
 };
 
 
@@ -455,7 +456,7 @@ parallel_interface_arg(void *utd)
     if (user_thread_data->affinity) {
 	int ret;
 	/* lock us onto a core corresponding to our parallel ID number */
-	ret = parallel_set_affinity(user_thread_data->cpu_id);
+	ret = parallel_set_affinity_policy(user_thread_data->cpu_id, user_thread_data->affinity);
 	if (ret) {
 	    bu_log("WARNING: encountered unexpected problem setting CPU affinity\n");
 	}
@@ -465,7 +466,16 @@ parallel_interface_arg(void *utd)
     user_thread_data->parent->started++;
     bu_semaphore_release(BU_SEM_THREAD);
 
-    (*(user_thread_data->user_func))(user_thread_data->cpu_id, user_thread_data->user_arg);
+    {
+	ssize_t start = bu_malloc_bytes(user_thread_data->cpu_id);
+
+	(*(user_thread_data->user_func))(user_thread_data->cpu_id, user_thread_data->user_arg);
+
+	/* hand what this thread still holds over to the thread that
+	 * called bu_parallel(), before this ID can be given out again */
+	user_thread_data->malloc_bytes = bu_malloc_bytes(user_thread_data->cpu_id) - start;
+	malloc_bytes_add(user_thread_data->cpu_id, -user_thread_data->malloc_bytes);
+    }
 
     bu_semaphore_acquire(BU_SEM_THREAD);
     user_thread_data->parent->finished++;
@@ -559,10 +569,10 @@ bu_parallel(void (*func)(int, void *), size_t ncpu, void *arg)
 
     libbu_affinity = getenv("LIBBU_AFFINITY");
     if (libbu_affinity)
-	affinity = (int)strtol(libbu_affinity, NULL, 0x10);
+	affinity = parallel_affinity_policy(libbu_affinity);
     if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL)) {
 	if (affinity)
-	    bu_log("CPU affinity enabled. (LIBBU_AFFINITY=%d)\n", affinity);
+	    bu_log("CPU affinity enabled. (LIBBU_AFFINITY=%s)\n", libbu_affinity);
 	else
 	    bu_log("CPU affinity disabled.\n");
     }
@@ -817,6 +827,10 @@ bu_parallel(void (*func)(int, void *), size_t ncpu, void *arg)
     if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL))
 	bu_log("bu_parallel(%zd) complete\n", ncpu);
 
+    /* the workers are done, charge what they allocated to us */
+    for (x = 0; x < ncpu; x++)
+	malloc_bytes_add(bu_parallel_id(), thread_context[x].malloc_bytes);
+
     bu_free(thread_context, "struct thread_data *thread_context");
 
 #endif /* PARALLEL */
@@ -33,6 +33,40 @@
  */
 extern int parallel_set_affinity(int cpu);
 
+/* Thread placement policies, selected with LIBBU_AFFINITY */
+#define PARALLEL_AFFINITY_NONE 0
+#define PARALLEL_AFFINITY_CORE 1	/* parallel ID modulo the processor count */
+#define PARALLEL_AFFINITY_COMPACT 2	/* fill a NUMA node before moving to the next */
+#define PARALLEL_AFFINITY_SPREAD 3	/* alternate threads across the NUMA nodes */
+
+/**
+ * Map a LIBBU_AFFINITY value to a placement policy.  "compact" and
+ * "spread" select the NUMA aware placements, any other non-zero
+ * (hexadecimal) value keeps the historic one thread per processor
+ * pinning.
+ */
+extern int parallel_affinity_policy(const char *str);
+
+/**
+ * Pin the current thread, running as the given parallel ID, to a
+ * processor chosen by the placement policy.
+ *
+ * Return:
+ *  0 on Success
+ * !0 on Failure
+ */
+extern int parallel_set_affinity_policy(int id, int policy);
+
+extern int BU_SEM_THREAD;
+
+/**
+ * Adjust the bu_malloc_bytes() count of the bu_parallel() thread
+ * numbered 'cpu'.  Only that thread may call this for its own count,
+ * or another thread while that one is known to be waiting on it.
+ * Defined in malloc.c.
+ */
+extern void malloc_bytes_add(int cpu, ssize_t nbytes);
+
 extern void thread_set_cpu(int cpu);
 extern int thread_get_cpu(void);
 
@@ -0,0 +1,193 @@
+/*                        M A L L O C . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file malloc.c
+ *
+ * Tests the bu_malloc_bytes() per-thread and total counts across
+ * bu_parallel() threads that allocate and free concurrently.
+ *
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "bu.h"
+
+
+#define MB_BLOCKS 64
+#define MB_SIZE 1000
+#define MB_ROUNDS 200
+
+struct mb_thread {
+    void *kept[MB_BLOCKS];
+    ssize_t allocated;	/* own count change after allocating */
+    ssize_t held;	/* own count change when done */
+    ssize_t block;	/* count change for one kept block */
+};
+
+static struct mb_thread mb_threads[MAX_PSW];
+static ssize_t mb_before[MAX_PSW];
+
+
+static void
+mb_callback(int UNUSED(cpu), void *UNUSED(d))
+{
+    int id = bu_parallel_id();
+    struct mb_thread *t;
+    ssize_t start, before;
+    void *p[MB_BLOCKS];
+    int i, r;
+
+    if (id < 0 || id >= MAX_PSW)
+	return;
+    t = &mb_threads[id];
+    start = bu_malloc_bytes(id);
+
+    /* churn, so that every thread allocates and frees while the
+     * others do, and reads the total while they update it */
+    for (r = 0; r < MB_ROUNDS; r++) {
+	for (i = 0; i < MB_BLOCKS; i++)
+	    p[i] = bu_malloc(MB_SIZE, "mb churn");
+	(void)bu_malloc_bytes(-1);
+	for (i = 0; i < MB_BLOCKS; i++)
+	    bu_free(p[i], "mb churn");
+    }
+
+    before = bu_malloc_bytes(id);
+    for (i = 0; i < MB_BLOCKS; i++) {
+	t->kept[i] = bu_malloc(MB_SIZE, "mb kept");
+	if (i == 0)
+	    t->block = bu_malloc_bytes(id) - before;
+    }
+    t->allocated = bu_malloc_bytes(id) - start;
+
+    /* free every other block, keep the rest for the caller */
+    for (i = 0; i < MB_BLOCKS; i += 2) {
+	bu_free(t->kept[i], "mb kept");
+	t->kept[i] = NULL;
+    }
+    t->held = bu_malloc_bytes(id) - start;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    size_t ncpu = bu_avail_cpus();
+    int self = bu_parallel_id();
+    ssize_t self_start, total_start, held = 0;
+    int counts_free, fail = 0;
+    void *p;
+    int i, j;
+
+    // Normally this file is part of bu_test, so only set this if it
+    // looks like the program name is still unset.
+    if (bu_getprogname()[0] == '\0')
+	bu_setprogname(argv[0]);
+
+    if (argc > 1)
+	ncpu = (size_t)strtoul(argv[1], NULL, 0);
+    if (ncpu < 2)
+	ncpu = 2;
+    if (ncpu >= MAX_PSW)
+	ncpu = MAX_PSW - 1;
+
+    /* where the C library can not report sizes, releases are not
+     * counted (see bu_malloc_bytes()) */
+    self_start = bu_malloc_bytes(self);
+    p = bu_malloc(MB_SIZE, "mb probe");
+    if (bu_malloc_bytes(self) - self_start < MB_SIZE) {
+	bu_log("bu_malloc_bytes: %zd bytes counted for a %d byte block [FAIL]\n", bu_malloc_bytes(self) - self_start, MB_SIZE);
+	return 1;
+    }
+    bu_free(p, "mb probe");
+    counts_free = (bu_malloc_bytes(self) == self_start);
+
+    /* settle anything bu_parallel() allocates on first use */
+    bu_parallel(NULL, ncpu, NULL);
+
+    memset(mb_threads, 0, sizeof(mb_threads));
+    for (i = 0; i < MAX_PSW; i++)
+	mb_before[i] = bu_malloc_bytes(i);
+    self_start = bu_malloc_bytes(self);
+    total_start = bu_malloc_bytes(-1);
+
+    bu_parallel(mb_callback, ncpu, NULL);
+
+    for (i = 0; i < MAX_PSW; i++) {
+	struct mb_thread *t = &mb_threads[i];
+	ssize_t want;
+
+	if (!t->allocated)
+	    continue;
+
+	if (t->block < MB_SIZE || t->allocated != MB_BLOCKS * t->block) {
+	    bu_log("bu_malloc_bytes: thread %d counted %zd for %d blocks of %zd [FAIL]\n", i, t->allocated, MB_BLOCKS, t->block);
+	    fail++;
+	}
+	want = (counts_free) ? t->allocated / 2 : t->allocated;
+	if (t->held != want) {
+	    bu_log("bu_malloc_bytes: thread %d holds %zd, expected %zd [FAIL]\n", i, t->held, want);
+	    fail++;
+	}
+	held += t->held;
+
+	/* what a thread held is moved to the caller when it is done */
+	if (i != self && bu_malloc_bytes(i) != mb_before[i]) {
+	    bu_log("bu_malloc_bytes: thread %d still counts %zd after bu_parallel() [FAIL]\n", i, bu_malloc_bytes(i) - mb_before[i]);
+	    fail++;
+	}
+    }
+
+    if (bu_malloc_bytes(self) - self_start != held) {
+	bu_log("bu_malloc_bytes: caller was charged %zd, threads held %zd [FAIL]\n", bu_malloc_bytes(self) - self_start, held);
+	fail++;
+    }
+    if (bu_malloc_bytes(-1) - total_start != held) {
+	bu_log("bu_malloc_bytes: total grew by %zd, threads held %zd [FAIL]\n", bu_malloc_bytes(-1) - total_start, held);
+	fail++;
+    }
+
+    for (i = 0; i < MAX_PSW; i++) {
+	for (j = 0; j < MB_BLOCKS; j++)
+	    bu_free(mb_threads[i].kept[j], "mb kept");
+    }
+    if (counts_free && bu_malloc_bytes(-1) != total_start) {
+	bu_log("bu_malloc_bytes: total is %zd after freeing, expected %zd [FAIL]\n", bu_malloc_bytes(-1), total_start);
+	fail++;
+    }
+
+    if (fail)
+	return 1;
+
+    bu_log("bu_malloc_bytes across %zd threads [PASS]\n", ncpu);
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
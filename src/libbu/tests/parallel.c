@@ -77,6 +77,15 @@ recursive_callback(int UNUSED(cpu), void *d)
 }
 
 
+static void
+numa_callback(int node, void *UNUSED(d))
+{
+    /* one call per node, each from a thread running on that node */
+    if (node >= 0 && node < MAX_PSW)
+	counter[node] += (bu_numa_node() == node) ? 1 : MAX_PSW;
+}
+
+
 static size_t
 tally(size_t ncpu)
 {
@@ -208,6 +217,15 @@ main(int argc, char *argv[])
     }
     bu_log("bu_parallel recursive callback, many iterations [PASS]\n");
 
+    /* test running once on every NUMA node */
+    memset(counter, 0, sizeof(counter));
+    bu_numa_run(numa_callback, NULL);
+    if (bu_numa_nodes() < 1 || tally(MAX_PSW) != (size_t)bu_numa_nodes()) {
+	bu_log("bu_numa_run on %d nodes [FAIL] (got %zd, expected %d)\n", bu_numa_nodes(), tally(MAX_PSW), bu_numa_nodes());
+	return 1;
+    }
+    bu_log("bu_numa_run on %d nodes [PASS]\n", bu_numa_nodes());
+
     return 0;
 }
 
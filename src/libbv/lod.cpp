@@ -58,6 +58,7 @@
 #include <cstring>
 #include <stdlib.h>
 #include <map>
+#include <mutex>
 #include <set>
 #include <thread>
 #include <vector>
@@ -95,7 +96,7 @@ extern "C" {
 #include "bv/view_sets.h"
 
 // Number of levels of detail to define
-#define POP_MAXLEVEL 16
+#define POP_MAXLEVEL BV_LOD_MAXLEVEL
 
 // Subdirectory in BRL-CAD cache to hold this type of LoD data
 #define POP_CACHEDIR ".POPLoD"
@@ -594,6 +595,85 @@ _obj_visible(struct bv_scene_obj *s, struct bview *v)
     return 0;
 }
 
+extern "C" fastf_t
+bv_scene_obj_screen_size(struct bv_scene_obj *s, struct bview *v)
+{
+    if (!s || !v || v->gv_width <= 0 || v->gv_height <= 0)
+	return -1;
+
+    int persp = (SMALL_FASTF < v->gv_perspective) ? 1 : 0;
+    point_t arb[8];
+    VSET(arb[0], s->bmin[0], s->bmin[1], s->bmin[2]);
+    VSET(arb[1], s->bmin[0], s->bmin[1], s->bmax[2]);
+    VSET(arb[2], s->bmin[0], s->bmax[1], s->bmin[2]);
+    VSET(arb[3], s->bmin[0], s->bmax[1], s->bmax[2]);
+    VSET(arb[4], s->bmax[0], s->bmin[1], s->bmin[2]);
+    VSET(arb[5], s->bmax[0], s->bmin[1], s->bmax[2]);
+    VSET(arb[6], s->bmax[0], s->bmax[1], s->bmin[2]);
+    VSET(arb[7], s->bmax[0], s->bmax[1], s->bmax[2]);
+    point2d_t omin = {INFINITY, INFINITY};
+    point2d_t omax = {-INFINITY, -INFINITY};
+    for (int i = 0; i < 8; i++) {
+	point_t pp, ppnt;
+	point2d_t pxy;
+	if (persp) {
+	    // A box corner behind the eye point means the object is
+	    // (at least partially) surrounding the camera - it needs
+	    // full detail.
+	    const fastf_t *m = v->gv_pmat;
+	    if (m[12]*arb[i][X] + m[13]*arb[i][Y] + m[14]*arb[i][Z] + m[15] < SMALL_FASTF)
+		return MAX_FASTF;
+	    MAT4X3PNT(pp, v->gv_pmat, arb[i]);
+	} else {
+	    VMOVE(pp, arb[i]);
+	}
+	MAT4X3PNT(ppnt, v->gv_model2view, pp);
+	V2SET(pxy, ppnt[0], ppnt[1]);
+	V2MINMAX(omin, omax, pxy);
+    }
+
+    // If the view has calculated its window bounds use them, otherwise
+    // fall back on the standard [-1,1] view space extents.
+    fastf_t wx = v->gv_wmax[0] - v->gv_wmin[0];
+    fastf_t wy = v->gv_wmax[1] - v->gv_wmin[1];
+    if (wx < SMALL_FASTF || wy < SMALL_FASTF) {
+	wx = 2.0;
+	wy = 2.0;
+    }
+
+    fastf_t px = (omax[0] - omin[0]) / wx * (fastf_t)v->gv_width;
+    fastf_t py = (omax[1] - omin[1]) / wy * (fastf_t)v->gv_height;
+
+    return (px > py) ? px : py;
+}
+
+extern "C" int
+bv_scene_obj_lod_level(struct bv_scene_obj *s, struct bview *v)
+{
+    if (!s || !v)
+	return BV_LOD_MAXLEVEL - 1;
+
+    fastf_t px = bv_scene_obj_screen_size(s, v);
+
+    // If we can't tell how big the object is on screen, don't hold
+    // back on detail.
+    if (px < 0)
+	return BV_LOD_MAXLEVEL - 1;
+
+    if (v->gv_s && v->gv_s->lod_pixel_threshold > 0 && px < v->gv_s->lod_pixel_threshold) {
+	bv_log(2, "bv_scene_obj_lod_level %s[%s]: %g pixels, below threshold", bu_vls_cstr(&s->s_name), bu_vls_cstr(&v->gv_name), px);
+	return -1;
+    }
+
+    // Level n quantizes the object's bounds into a 2^n grid - going
+    // one level past pixel resolution keeps the snapping invisible.
+    int level = (px > 1) ? (int)ceil(log2(px)) + 1 : 0;
+    level = (level >= BV_LOD_MAXLEVEL) ? BV_LOD_MAXLEVEL - 1 : level;
+
+    bv_log(2, "bv_scene_obj_lod_level %s[%s]: %g pixels -> %d", bu_vls_cstr(&s->s_name), bu_vls_cstr(&v->gv_name), px, level);
+    return level;
+}
+
 struct bv_mesh_lod_context_internal {
     MDB_env *lod_env;
     MDB_txn *lod_txn;
@@ -603,6 +683,12 @@ struct bv_mesh_lod_context_internal {
     MDB_txn *name_txn;
     MDB_dbi name_dbi;
 
+    // The txn handles above are shared by all users of the context, so
+    // access to each environment is serialized to allow the cache to be
+    // populated from multiple threads.
+    std::mutex lod_mutex;
+    std::mutex name_mutex;
+
     struct bu_vls *fname;
 };
 
@@ -633,7 +719,7 @@ bv_mesh_lod_context_create(const char *name)
     // Create the context
     struct bv_mesh_lod_context *c;
     BU_GET(c, struct bv_mesh_lod_context);
-    BU_GET(c->i, struct bv_mesh_lod_context_internal);
+    c->i = new bv_mesh_lod_context_internal();
     struct bv_mesh_lod_context_internal *i = c->i;
     BU_GET(i->fname, struct bu_vls);
     bu_vls_init(i->fname);
@@ -724,7 +810,9 @@ lod_context_close_lod_fail:
     mdb_env_close(i->lod_env);
 lod_context_fail:
     bu_vls_free(&fname);
-    BU_PUT(c->i, struct bv_mesh_lod_context_internal);
+    bu_vls_free(i->fname);
+    BU_PUT(i->fname, struct bu_vls);
+    delete c->i;
     BU_PUT(c, struct bv_mesh_lod_context);
     return NULL;
 }
@@ -738,7 +826,7 @@ bv_mesh_lod_context_destroy(struct bv_mesh_lod_context *c)
     mdb_env_close(c->i->lod_env);
     bu_vls_free(c->i->fname);
     BU_PUT(c->i->fname, struct bu_vls);
-    BU_PUT(c->i, struct bv_mesh_lod_context_internal);
+    delete c->i;
     BU_PUT(c, struct bv_mesh_lod_context);
 }
 
@@ -762,6 +850,7 @@ bv_mesh_lod_key_get(struct bv_mesh_lod_context *c, const char *name)
     unsigned long long hash = bu_data_hash(bu_vls_cstr(&keystr), bu_vls_strlen(&keystr)*sizeof(char));
     bu_vls_sprintf(&keystr, "%llu", hash);
 
+    std::lock_guard<std::mutex> lock(c->i->name_mutex);
     mdb_txn_begin(c->i->name_env, NULL, 0, &c->i->name_txn);
     mdb_dbi_open(c->i->name_txn, NULL, 0, &c->i->name_dbi);
     mdb_key.mv_size = bu_vls_strlen(&keystr)*sizeof(char);
@@ -769,6 +858,7 @@ bv_mesh_lod_key_get(struct bv_mesh_lod_context *c, const char *name)
     int rc = mdb_get(c->i->name_txn, c->i->name_dbi, &mdb_key, &mdb_data);
     if (rc) {
 	mdb_txn_commit(c->i->name_txn);
+	bu_vls_free(&keystr);
 	return 0;
     }
     unsigned long long *fkeyp = (unsigned long long *)mdb_data.mv_data;
@@ -800,6 +890,7 @@ bv_mesh_lod_key_put(struct bv_mesh_lod_context *c, const char *name, unsigned lo
 
     MDB_val mdb_key;
     MDB_val mdb_data[2];
+    std::lock_guard<std::mutex> lock(c->i->name_mutex);
     mdb_txn_begin(c->i->name_env, NULL, 0, &c->i->name_txn);
     mdb_dbi_open(c->i->name_txn, NULL, 0, &c->i->name_dbi);
     mdb_key.mv_size = bu_vls_strlen(&keystr)*sizeof(char);
@@ -1292,6 +1383,8 @@ POPState::tri_pop_load(int start_level, int level)
 	size_t bsize = cache_get((void **)&b, bu_vls_cstr(&kbuf));
 	if (bsize != level_vcnt[i]*sizeof(point_t)) {
 	    bu_log("Incorrect data size found loading level %d point data\n", i);
+	    cache_done();
+	    bu_vls_free(&kbuf);
 	    return;
 	}
 	lod_tri_pnts.insert(lod_tri_pnts.end(), &b[0], &b[level_vcnt[i]*3]);
@@ -1318,6 +1411,8 @@ POPState::tri_pop_load(int start_level, int level)
 	size_t bsize = cache_get((void **)&b, bu_vls_cstr(&kbuf));
 	if (bsize != level_tricnt[i]*3*sizeof(int)) {
 	    bu_log("Incorrect data size found loading level %d tri data\n", i);
+	    cache_done();
+	    bu_vls_free(&kbuf);
 	    return;
 	}
 	lod_tris.insert(lod_tris.end(), &b[0], &b[level_tricnt[i]*3]);
@@ -1333,6 +1428,8 @@ POPState::tri_pop_load(int start_level, int level)
 	size_t bsize = cache_get((void **)&b, bu_vls_cstr(&kbuf));
 	if (bsize > 0 && bsize != level_tricnt[i]*sizeof(vect_t)*3) {
 	    bu_log("Incorrect data size found loading level %d normal data\n", i);
+	    cache_done();
+	    bu_vls_free(&kbuf);
 	    return;
 	}
 	if (bsize) {
@@ -1544,6 +1641,7 @@ POPState::cache_write(const char *component, std::stringstream &s)
     char *keycstr = bu_strdup(keystr.c_str());
     void *bdata = bu_calloc(buffer.length()+1, sizeof(char), "bdata");
     memcpy(bdata, buffer.data(), buffer.length()*sizeof(char));
+    std::lock_guard<std::mutex> lock(c->i->lod_mutex);
     mdb_txn_begin(c->i->lod_env, NULL, 0, &c->i->lod_txn);
     mdb_dbi_open(c->i->lod_txn, NULL, 0, &c->i->lod_dbi);
     mdb_key.mv_size = keystr.length()*sizeof(char);
@@ -1563,7 +1661,8 @@ POPState::cache_write(const char *component, std::stringstream &s)
 // This pulls the data, but doesn't close the transaction because the
 // calling code will want to manipulate the data.  After that process
 // is complete, cache_done() should be called to prepare for subsequent
-// operations.
+// operations.  The context's lod_mutex is held between the two calls,
+// so every cache_get MUST be paired with a cache_done.
 size_t
 POPState::cache_get(void **data, const char *component)
 {
@@ -1575,6 +1674,7 @@ POPState::cache_get(void **data, const char *component)
     //if (keystr.length()*sizeof(char) > mdb_env_get_maxkeysize(c->i->lod_env))
     //	return 0;
     char *keycstr = bu_strdup(keystr.c_str());
+    c->i->lod_mutex.lock();
     mdb_txn_begin(c->i->lod_env, NULL, 0, &c->i->lod_txn);
     mdb_dbi_open(c->i->lod_txn, NULL, 0, &c->i->lod_dbi);
     mdb_key.mv_size = keystr.length()*sizeof(char);
@@ -1595,6 +1695,7 @@ void
 POPState::cache_done()
 {
     mdb_txn_commit(c->i->lod_txn);
+    c->i->lod_mutex.unlock();
 }
 
 bool
@@ -2038,6 +2139,12 @@ bv_mesh_lod_view(struct bv_scene_obj *s, struct bview *v, int reset)
     vscale = (vscale < 0) ? 0 : vscale;
     vscale = (vscale >= POP_MAXLEVEL) ? POP_MAXLEVEL-1 : vscale;
 
+    // Objects covering only a few pixels don't need more detail than
+    // their screen footprint can show, however big the view is.
+    int plevel = bv_scene_obj_lod_level(s, v);
+    plevel = (plevel < 0) ? 0 : plevel;
+    vscale = (plevel < vscale) ? plevel : vscale;
+
     bv_log(2, "bv_mesh_lod_view %s[%s][%d]", bu_vls_cstr(&s->s_name), bu_vls_cstr(&v->gv_name), vscale);
 
     // If the object is not visible in the scene, don't change the data
@@ -2070,6 +2177,7 @@ cache_del(struct bv_mesh_lod_context *c, unsigned long long hash, const char *co
     MDB_val mdb_key;
     std::string keystr = std::to_string(hash) + std::string(":") + std::string(component);
 
+    std::lock_guard<std::mutex> lock(c->i->lod_mutex);
     mdb_txn_begin(c->i->lod_env, NULL, 0, &c->i->lod_txn);
     mdb_dbi_open(c->i->lod_txn, NULL, 0, &c->i->lod_dbi);
     mdb_key.mv_size = keystr.length()*sizeof(char);
@@ -2102,6 +2210,7 @@ bv_mesh_lod_clear_cache(struct bv_mesh_lod_context *c, unsigned long long key)
 	MDB_val mdb_key, mdb_data;
 	unsigned long long *fkeyp = NULL;
 	unsigned long long fkey = 0;
+	std::lock_guard<std::mutex> lock(c->i->name_mutex);
 	mdb_txn_begin(c->i->name_env, NULL, 0, &c->i->name_txn);
 	mdb_dbi_open(c->i->name_txn, NULL, 0, &c->i->name_dbi);
 	MDB_cursor *cursor;
@@ -2136,41 +2245,46 @@ bv_mesh_lod_clear_cache(struct bv_mesh_lod_context *c, unsigned long long key)
 	int rc;
 
 	// Clear the actual LoD data
-	mdb_txn_begin(c->i->lod_env, NULL, 0, &c->i->lod_txn);
-	mdb_dbi_open(c->i->lod_txn, NULL, 0, &c->i->lod_dbi);
-	rc = mdb_cursor_open(c->i->lod_txn, c->i->lod_dbi, &cursor);
-	if (rc) {
-	    mdb_txn_commit(c->i->lod_txn);
-	    return;
-	}
-	rc = mdb_cursor_get(cursor, &mdb_key, &mdb_data, MDB_FIRST);
-	if (rc) {
+	{
+	    std::lock_guard<std::mutex> lock(c->i->lod_mutex);
+	    mdb_txn_begin(c->i->lod_env, NULL, 0, &c->i->lod_txn);
+	    mdb_dbi_open(c->i->lod_txn, NULL, 0, &c->i->lod_dbi);
+	    rc = mdb_cursor_open(c->i->lod_txn, c->i->lod_dbi, &cursor);
+	    if (rc) {
+		mdb_txn_commit(c->i->lod_txn);
+		return;
+	    }
+	    rc = mdb_cursor_get(cursor, &mdb_key, &mdb_data, MDB_FIRST);
+	    if (rc) {
+		mdb_txn_commit(c->i->lod_txn);
+		return;
+	    }
+	    mdb_cursor_del(cursor, 0);
+	    while (!mdb_cursor_get(cursor, &mdb_key, &mdb_data, MDB_NEXT))
+		mdb_cursor_del(cursor, 0);
 	    mdb_txn_commit(c->i->lod_txn);
-	    return;
 	}
-	mdb_cursor_del(cursor, 0);
-	while (!mdb_cursor_get(cursor, &mdb_key, &mdb_data, MDB_NEXT))
-	    mdb_cursor_del(cursor, 0);
-	mdb_txn_commit(c->i->lod_txn);
 
-	// Iterate over the name/key mapper, removing anything with a value
-	// of key
-	mdb_txn_begin(c->i->name_env, NULL, 0, &c->i->name_txn);
-	mdb_dbi_open(c->i->name_txn, NULL, 0, &c->i->name_dbi);
-	rc = mdb_cursor_open(c->i->name_txn, c->i->name_dbi, &cursor);
-	if (rc) {
-	    mdb_txn_commit(c->i->name_txn);
-	    return;
-	}
-	rc = mdb_cursor_get(cursor, &mdb_key, &mdb_data, MDB_FIRST);
-	if (rc) {
+	// Iterate over the name/key mapper, removing everything
+	{
+	    std::lock_guard<std::mutex> lock(c->i->name_mutex);
+	    mdb_txn_begin(c->i->name_env, NULL, 0, &c->i->name_txn);
+	    mdb_dbi_open(c->i->name_txn, NULL, 0, &c->i->name_dbi);
+	    rc = mdb_cursor_open(c->i->name_txn, c->i->name_dbi, &cursor);
+	    if (rc) {
+		mdb_txn_commit(c->i->name_txn);
+		return;
+	    }
+	    rc = mdb_cursor_get(cursor, &mdb_key, &mdb_data, MDB_FIRST);
+	    if (rc) {
+		mdb_txn_commit(c->i->name_txn);
+		return;
+	    }
+	    mdb_cursor_del(cursor, 0);
+	    while (!mdb_cursor_get(cursor, &mdb_key, &mdb_data, MDB_NEXT))
+		mdb_cursor_del(cursor, 0);
 	    mdb_txn_commit(c->i->name_txn);
-	    return;
 	}
-	mdb_cursor_del(cursor, 0);
-	while (!mdb_cursor_get(cursor, &mdb_key, &mdb_data, MDB_NEXT))
-	    mdb_cursor_del(cursor, 0);
-	mdb_txn_commit(c->i->name_txn);
 
 	return;
     }
@@ -158,22 +158,31 @@ gcv_facetize(struct db_i *db, const struct db_full_path *path,
     {
 	char * const str_path = db_path_to_string(path);
 	struct db_tree_state initial_tree_state;
+	struct rt_tess_cache *tess_cache = rt_tess_cache_create();
+	int walk_ret;
+
 	RT_DBTS_INIT(&initial_tree_state);
 	initial_tree_state.ts_tol = tol;
 	initial_tree_state.ts_ttol = tess_tol;
 	initial_tree_state.ts_m = &nmg_model;
+	initial_tree_state.ts_tess_cache = tess_cache;
 
 	facetize_tree = NULL;
 	nmg_model = nmg_mm();
 
-	if (db_walk_tree(db, 1, (const char **)&str_path, 1, &initial_tree_state, NULL,
-			 _gcv_facetize_region_end, rt_booltree_leaf_tess, &facetize_tree)) {
+	/* Tessellate the leaves using all the CPUs first, so the walk
+	 * below only has to copy them into the boolean tree. */
+	(void)rt_tess_cache_prime(tess_cache, db, 1, (const char **)&str_path, bu_avail_cpus(), &initial_tree_state);
+
+	walk_ret = db_walk_tree(db, 1, (const char **)&str_path, 1, &initial_tree_state, NULL,
+				_gcv_facetize_region_end, rt_booltree_leaf_tess, &facetize_tree);
+	rt_tess_cache_destroy(tess_cache);
+	bu_free(str_path, "str_path");
+
+	if (walk_ret) {
 	    bu_log("gcv_facetize(): error in db_walk_tree()\n");
-	    bu_free(str_path, "str_path");
 	    return _gcv_facetize_cleanup(nmg_model, facetize_tree);
 	}
-
-	bu_free(str_path, "str_path");
     }
 
     if (!facetize_tree)
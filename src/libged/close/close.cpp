@@ -52,8 +52,10 @@ ged_close_core(struct ged *gedp, int UNUSED(argc), const char **UNUSED(argv))
     ged_exec_zap(gedp, 1, (const char **)av);
 
     /* close current database */
-    if (gedp->dbip)
+    if (gedp->dbip) {
+	ged_csg_lod_keys_free(gedp->dbip);
 	db_close(gedp->dbip);
+    }
     gedp->dbip = NULL;
 
     /* Clean up any old acceleration states, if present */
@@ -25,6 +25,7 @@
 
 #include "common.h"
 
+#include <mutex>
 #include <set>
 #include <unordered_map>
 
@@ -68,7 +69,7 @@ prim_tess(struct bv_scene_obj *s, struct rt_db_internal *ip)
 
     struct model *m = nmg_mm();
     struct nmgregion *r = (struct nmgregion *)NULL;
-    if (ip->idb_meth->ft_tessellate(&r, m, ip, ttol, tol) < 0) {
+    if (rt_obj_tess(&r, m, ip, ttol, tol) < 0) {
 	bu_log("ERROR(%s): tessellation failure\n", dp->d_namep);
 	return -1;
     }
@@ -104,6 +105,30 @@ draw_free_data(struct bv_scene_obj *s)
 }
 
 
+/* Stand-in wireframe for objects too small on screen to be worth plotting */
+static void
+bbox_vlist(struct bu_list *vlfree, struct bu_list *vhead, point_t min, point_t max)
+{
+    point_t p[8];
+    VSET(p[0], min[X], min[Y], min[Z]);
+    VSET(p[1], max[X], min[Y], min[Z]);
+    VSET(p[2], max[X], max[Y], min[Z]);
+    VSET(p[3], min[X], max[Y], min[Z]);
+    VSET(p[4], min[X], min[Y], max[Z]);
+    VSET(p[5], max[X], min[Y], max[Z]);
+    VSET(p[6], max[X], max[Y], max[Z]);
+    VSET(p[7], min[X], max[Y], max[Z]);
+
+    for (int i = 0; i < 4; i++) {
+	BV_ADD_VLIST(vlfree, vhead, p[i], BV_VLIST_LINE_MOVE);
+	BV_ADD_VLIST(vlfree, vhead, p[(i+1)%4], BV_VLIST_LINE_DRAW);
+	BV_ADD_VLIST(vlfree, vhead, p[i+4], BV_VLIST_LINE_MOVE);
+	BV_ADD_VLIST(vlfree, vhead, p[(i+1)%4+4], BV_VLIST_LINE_DRAW);
+	BV_ADD_VLIST(vlfree, vhead, p[i], BV_VLIST_LINE_MOVE);
+	BV_ADD_VLIST(vlfree, vhead, p[i+4], BV_VLIST_LINE_DRAW);
+    }
+}
+
 static int
 csg_wireframe_update(struct bv_scene_obj *vo, struct bview *v, int flag)
 {
@@ -129,6 +154,14 @@ csg_wireframe_update(struct bv_scene_obj *vo, struct bview *v, int flag)
 
     bool rework = (flag) ? true : false;
 
+    // Moving a perspective eye point changes how big the object is on
+    // screen without touching the view scale, so check directly whether
+    // the placeholder decision has changed.
+    struct draw_update_data_t *d = (struct draw_update_data_t *)vo->s_i_data;
+    int placeholder = (bv_scene_obj_lod_level(vo, v) < 0) ? 1 : 0;
+    if (!rework && placeholder != d->lod_placeholder)
+	rework = true;
+
     // Check point scale
     if (!rework && !NEAR_EQUAL(vo->curve_scale, vo->s_v->gv_s->curve_scale, SMALL_FASTF))
 	rework = true;
@@ -157,7 +190,6 @@ csg_wireframe_update(struct bv_scene_obj *vo, struct bview *v, int flag)
 	BU_FREE(pv, struct bv_vlist);
     }
 
-    struct draw_update_data_t *d = (struct draw_update_data_t *)vo->s_i_data;
     struct db_full_path *fp = (struct db_full_path *)vo->s_path;
     struct directory *dp = (fp) ? DB_FULL_PATH_CUR_DIR(fp) : (struct directory *)vo->dp;
     struct db_i *dbip = d->dbip;
@@ -168,12 +200,27 @@ csg_wireframe_update(struct bv_scene_obj *vo, struct bview *v, int flag)
     if (ret < 0)
 	return 0;
 
+    // If the solid only covers a few pixels, there's no point in generating
+    // its full wireframe - a bounding box is indistinguishable at that size.
+    d->lod_placeholder = placeholder;
+    if (placeholder && ip->idb_meth->ft_bbox) {
+	point_t bmin, bmax;
+	if (ip->idb_meth->ft_bbox(ip, &bmin, &bmax, d->tol) == 0) {
+	    bbox_vlist(vo->vlfree, &vo->s_vlist, bmin, bmax);
+	    vo->s_type_flags |= BV_CSG_LOD;
+	    bv_obj_stale(vo);
+	    rt_db_free_internal(ip);
+	    return 1;
+	}
+    }
+
     if (ip->idb_meth->ft_adaptive_plot) {
 	ip->idb_meth->ft_adaptive_plot(&vo->s_vlist, ip, d->tol, v, vo->s_size);
 	vo->s_type_flags |= BV_CSG_LOD;
 	bv_obj_stale(vo);
     }
 
+    rt_db_free_internal(ip);
     return 1;
 }
 
@@ -245,6 +292,51 @@ bot_mesh_info_free_clbk(struct bv_mesh_lod *lod, void *cb_data)
     return 0;
 }
 
+/* Hook a cached mesh LoD up to the view object vo of s.  If cbd is non-NULL,
+ * it is used to recover full detail mesh data from the .g when the view
+ * needs more detail than the LoD cache holds. */
+static void
+mesh_lod_attach(struct bv_scene_obj *s, struct bv_scene_obj *vo, struct bv_mesh_lod *lod, struct ged_full_detail_clbk_data *cbd)
+{
+    // Assign the LoD information to the object's draw_data, and let
+    // the LoD know which object it is associated with.
+    vo->draw_data = (void *)lod;
+    lod->s = vo;
+
+    // The object bounds are based on the LoD's calculations.  Because the LoD
+    // cache stores only one cached data set per object, but full path
+    // instances in the scene can be placed with matrices, we must apply the
+    // s_mat transformation to the "baseline" LoD bbox info to get the correct
+    // box for the instance.
+    MAT4X3PNT(vo->bmin, s->s_mat, lod->bmin);
+    MAT4X3PNT(vo->bmax, s->s_mat, lod->bmax);
+    VMOVE(s->bmin, vo->bmin);
+    VMOVE(s->bmax, vo->bmax);
+
+    // Record the necessary information for full detail information recovery.  We
+    // don't duplicate the full mesh detail in the on-disk LoD storage, since we
+    // already have that info in the .g itself, but we need to know how to get at
+    // it when needed.  The free callback will clean up.
+    if (cbd) {
+	bv_mesh_lod_detail_setup_clbk(lod, &bot_mesh_info_clbk, (void *)cbd);
+	bv_mesh_lod_detail_clear_clbk(lod, &bot_mesh_info_clear_clbk);
+	bv_mesh_lod_detail_free_clbk(lod, &bot_mesh_info_free_clbk);
+    }
+
+    // LoD will need to re-check its level settings whenever the view changes
+    vo->s_update_callback = &bv_mesh_lod_view;
+    vo->s_free_callback = &bv_mesh_lod_free;
+
+    // Initialize the LoD data to the current view
+    int level = bv_mesh_lod_view(vo, vo->s_v, 0);
+    if (level < 0) {
+	bu_log("Error loading info for initial LoD view\n");
+    }
+
+    // Mark the object as a Mesh LoD so the drawing routine knows to handle it differently
+    vo->s_type_flags |= BV_MESH_LOD;
+}
+
 static void
 bot_adaptive_plot(struct bv_scene_obj *s, struct bview *v)
 {
@@ -334,48 +426,14 @@ bot_adaptive_plot(struct bv_scene_obj *s, struct bview *v)
 		return;
 	}
 
-	// Assign the LoD information to the object's draw_data, and let
-	// the LoD know which object it is associated with.
-	vo->draw_data = (void *)lod;
-	lod->s = vo;
-
-	// The object bounds are based on the LoD's calculations.  Because the LoD
-	// cache stores only one cached data set per object, but full path
-	// instances in the scene can be placed with matrices, we must apply the
-	// s_mat transformation to the "baseline" LoD bbox info to get the correct
-	// box for the instance.
-	MAT4X3PNT(vo->bmin, s->s_mat, lod->bmin);
-	MAT4X3PNT(vo->bmax, s->s_mat, lod->bmax);
-	VMOVE(s->bmin, vo->bmin);
-	VMOVE(s->bmax, vo->bmax);
-
-	// Record the necessary information for full detail information recovery.  We
-	// don't duplicate the full mesh detail in the on-disk LoD storage, since we
-	// already have that info in the .g itself, but we need to know how to get at
-	// it when needed.  The free callback will clean up, but we need to initialize
-	// the callback data here.
+	// Set up the callback data needed to recover full detail from the .g
 	struct ged_full_detail_clbk_data *cbd;
 	BU_GET(cbd, ged_full_detail_clbk_data);
 	cbd->dbip = dbip;
 	cbd->dp = dp;
 	cbd->res = &rt_uniresource;
 	cbd->intern = NULL;
-	bv_mesh_lod_detail_setup_clbk(lod, &bot_mesh_info_clbk, (void *)cbd);
-	bv_mesh_lod_detail_clear_clbk(lod, &bot_mesh_info_clear_clbk);
-	bv_mesh_lod_detail_free_clbk(lod, &bot_mesh_info_free_clbk);
-
-	// LoD will need to re-check its level settings whenever the view changes
-	vo->s_update_callback = &bv_mesh_lod_view;
-	vo->s_free_callback = &bv_mesh_lod_free;
-
-	// Initialize the LoD data to the current view
-	int level = bv_mesh_lod_view(vo, vo->s_v, 0);
-	if (level < 0) {
-	    bu_log("Error loading info for initial LoD view\n");
-	}
-
-	// Mark the object as a Mesh LoD so the drawing routine knows to handle it differently
-	vo->s_type_flags |= BV_MESH_LOD;
+	mesh_lod_attach(s, vo, lod, cbd);
     }
 
     bv_mesh_lod_view(vo, v, 0);
@@ -485,54 +543,282 @@ brep_adaptive_plot(struct bv_scene_obj *s, struct bview *v)
 	if (!lod)
 	    return;
 
-	// Assign the LoD information to the object's draw_data, and let
-	// the LoD know which object it is associated with.
-	vo->draw_data = (void *)lod;
-	lod->s = vo;
-
-	// The object bounds are based on the LoD's calculations.  Because the LoD
-	// cache stores only one cached data set per object, but full path
-	// instances in the scene can be placed with matrices, we must apply the
-	// s_mat transformation to the "baseline" LoD bbox info to get the correct
-	// box for the instance.
-	MAT4X3PNT(vo->bmin, s->s_mat, lod->bmin);
-	MAT4X3PNT(vo->bmax, s->s_mat, lod->bmax);
-	VMOVE(s->bmin, vo->bmin);
-	VMOVE(s->bmax, vo->bmax);
-
-	// Record the necessary information for full detail information recovery.  We
-	// don't duplicate the full mesh detail in the on-disk LoD storage, since we
-	// already have that info in the .g itself, but we need to know how to get at
-	// it when needed.  The free callback will clean up, but we need to initialize
-	// the callback data here.
+	// Set up the callback data needed to recover full detail from the .g
 	struct ged_full_detail_clbk_data *cbd;
 	BU_GET(cbd, ged_full_detail_clbk_data);
 	cbd->dbip = dbip;
 	cbd->dp = dp;
 	cbd->res = &rt_uniresource;
 	cbd->intern = NULL;
-	bv_mesh_lod_detail_setup_clbk(lod, &bot_mesh_info_clbk, (void *)cbd);
-	bv_mesh_lod_detail_clear_clbk(lod, &bot_mesh_info_clear_clbk);
-	bv_mesh_lod_detail_free_clbk(lod, &bot_mesh_info_free_clbk);
+	mesh_lod_attach(s, vo, lod, cbd);
+    }
 
-	// LoD will need to re-check its level settings whenever the view changes
-	vo->s_update_callback = &bv_mesh_lod_view;
-	vo->s_free_callback = &bv_mesh_lod_free;
+    bv_mesh_lod_view(vo, vo->s_v, 0);
+    bv_obj_stale(vo);
 
-	// Initialize the LoD data to the current view
-	int level = bv_mesh_lod_view(vo, vo->s_v, 0);
-	if (level < 0) {
-	    bu_log("Error loading info for initial LoD view\n");
+    return;
+}
+
+/* Objects that can be drawn through the mesh LoD machinery - BoTs, BReps and
+ * any solid that can be tessellated */
+extern "C" int
+ged_lod_cacheable(struct directory *dp)
+{
+    if (!dp || dp->d_addr == RT_DIR_PHONY_ADDR)
+	return 0;
+    if (dp->d_major_type != DB5_MAJORTYPE_BRLCAD || (dp->d_flags & RT_DIR_COMB))
+	return 0;
+
+    // Non-geometric types and pipes (which are always drawn as
+    // wireframes) have no use for mesh LoD data
+    switch (dp->d_minor_type) {
+	case DB5_MINORTYPE_BRLCAD_PIPE:
+	case DB5_MINORTYPE_BRLCAD_ANNOT:
+	case DB5_MINORTYPE_BRLCAD_DATUM:
+	case DB5_MINORTYPE_BRLCAD_SCRIPT:
+	case DB5_MINORTYPE_BRLCAD_SKETCH:
+	case DB5_MINORTYPE_BRLCAD_PNTS:
+	    return 0;
+	default:
+	    return 1;
+    }
+}
+
+/* Hashing a solid's serialized form is too expensive to repeat every time it
+ * is drawn, so computed keys are remembered per directory entry.  Each
+ * database gets a table, and a change callback registered with the database
+ * when the table is created drops a solid's key whenever it is written, added
+ * or removed.  The table goes away with ged_csg_lod_keys_free when the
+ * database is closed. */
+struct csg_lod_key_memo {
+    double abs, rel, norm, dist;
+    unsigned long long key;
+};
+
+struct csg_lod_keys {
+    std::mutex lock;
+    std::unordered_map<const struct directory *, struct csg_lod_key_memo> keys;
+};
+
+static std::mutex csg_lod_tbls_lock;
+static std::unordered_map<const struct db_i *, struct csg_lod_keys *> csg_lod_tbls;
+
+static void
+csg_lod_keys_changed(struct db_i *UNUSED(dbip), struct directory *dp, int UNUSED(mode), void *u_data)
+{
+    struct csg_lod_keys *k = (struct csg_lod_keys *)u_data;
+    std::lock_guard<std::mutex> g(k->lock);
+    k->keys.erase(dp);
+}
+
+static struct csg_lod_keys *
+csg_lod_keys_get(struct db_i *dbip)
+{
+    std::lock_guard<std::mutex> g(csg_lod_tbls_lock);
+
+    auto k_it = csg_lod_tbls.find(dbip);
+    if (k_it != csg_lod_tbls.end())
+	return k_it->second;
+
+    struct csg_lod_keys *k = new struct csg_lod_keys;
+    csg_lod_tbls[dbip] = k;
+    db_add_changed_clbk(dbip, &csg_lod_keys_changed, (void *)k);
+
+    return k;
+}
+
+extern "C" void
+ged_csg_lod_keys_free(struct db_i *dbip)
+{
+    if (!dbip)
+	return;
+
+    std::lock_guard<std::mutex> g(csg_lod_tbls_lock);
+
+    auto k_it = csg_lod_tbls.find(dbip);
+    if (k_it == csg_lod_tbls.end())
+	return;
+
+    db_rm_changed_clbk(dbip, &csg_lod_keys_changed, (void *)k_it->second);
+    delete k_it->second;
+    csg_lod_tbls.erase(k_it);
+}
+
+/* CSG primitives have no native mesh, so the LoD cache entry is keyed on both
+ * the serialized primitive and the tolerances used to tessellate it - a
+ * change to either invalidates the cached mesh. */
+extern "C" unsigned long long
+ged_csg_lod_key_ext(const struct bu_external *ext, const struct bg_tess_tol *ttol, const struct bn_tol *tol)
+{
+    struct bu_data_hash_state *hs = bu_data_hash_create();
+    bu_data_hash_update(hs, ext->ext_buf, ext->ext_nbytes);
+    bu_data_hash_update(hs, &ttol->abs, sizeof(double));
+    bu_data_hash_update(hs, &ttol->rel, sizeof(double));
+    bu_data_hash_update(hs, &ttol->norm, sizeof(double));
+    bu_data_hash_update(hs, &tol->dist, sizeof(double));
+    unsigned long long key = bu_data_hash_val(hs);
+    bu_data_hash_destroy(hs);
+
+    return key;
+}
+
+extern "C" unsigned long long
+ged_csg_lod_key(struct db_i *dbip, struct directory *dp, const struct bg_tess_tol *ttol, const struct bn_tol *tol)
+{
+    if (!dbip || !dp || !ttol || !tol)
+	return 0;
+
+    struct csg_lod_keys *k = csg_lod_keys_get(dbip);
+    {
+	std::lock_guard<std::mutex> g(k->lock);
+	auto m_it = k->keys.find(dp);
+	if (m_it != k->keys.end()) {
+	    const struct csg_lod_key_memo &m = m_it->second;
+	    if (EQUAL(m.abs, ttol->abs) && EQUAL(m.rel, ttol->rel) &&
+		    EQUAL(m.norm, ttol->norm) && EQUAL(m.dist, tol->dist))
+		return m.key;
 	}
+    }
+
+    struct bu_external ext = BU_EXTERNAL_INIT_ZERO;
+    if (db_get_external(&ext, dp, dbip))
+	return 0;
+    unsigned long long key = ged_csg_lod_key_ext(&ext, ttol, tol);
+    bu_free_external(&ext);
+
+    std::lock_guard<std::mutex> g(k->lock);
+    struct csg_lod_key_memo &m = k->keys[dp];
+    m.abs = ttol->abs;
+    m.rel = ttol->rel;
+    m.norm = ttol->norm;
+    m.dist = tol->dist;
+    m.key = key;
+
+    return key;
+}
+
+extern "C" unsigned long long
+ged_csg_lod_mesh(struct bv_mesh_lod_context *c, unsigned long long key, struct rt_db_internal *ip, const struct bg_tess_tol *ttol, const struct bn_tol *tol)
+{
+    if (!c || !key || !ip)
+	return 0;
+
+    // Just in case we have a stale key...
+    bv_mesh_lod_clear_cache(c, key);
+
+    if (!ip->idb_meth || !ip->idb_meth->ft_tessellate)
+	return 0;
+
+    struct model *m = nmg_mm();
+    struct nmgregion *r = (struct nmgregion *)NULL;
+    struct rt_bot_internal *bot = NULL;
+    if (rt_obj_tess(&r, m, ip, ttol, tol) < 0) {
+	nmg_km(m);
+	return 0;
+    }
+
+    if (!BU_SETJUMP) {
+	/* try */
+	bot = (struct rt_bot_internal *)nmg_mdl_to_bot(m, &RTG.rtg_vlfree, tol);
+    } else {
+	/* catch */
+	BU_UNSETJUMP;
+	nmg_km(m);
+	return 0;
+    } BU_UNSETJUMP;
+    nmg_km(m);
+
+    if (!bot)
+	return 0;
+
+    // As with breps, the .g has no full detail mesh to fall back on, so the
+    // cache must hold everything (ratio of 1)
+    key = bv_mesh_lod_cache(c, (const point_t *)bot->vertices, bot->num_vertices, NULL, bot->faces, bot->num_faces, key, 1);
+
+    rt_bot_internal_free(bot);
+    BU_PUT(bot, struct rt_bot_internal);
+
+    return key;
+}
+
+extern "C" unsigned long long
+ged_csg_lod_cache(struct bv_mesh_lod_context *c, struct db_i *dbip, struct directory *dp, const struct bg_tess_tol *ttol, const struct bn_tol *tol, struct resource *res)
+{
+    if (!c || !dbip || !dp)
+	return 0;
+
+    unsigned long long key = ged_csg_lod_key(dbip, dp, ttol, tol);
+    if (!key)
+	return 0;
+
+    // Already have it - nothing to do
+    struct bv_mesh_lod *lod = bv_mesh_lod_create(c, key);
+    if (lod) {
+	bv_mesh_lod_destroy(lod);
+	bv_mesh_lod_key_put(c, dp->d_namep, key);
+	return key;
+    }
+
+    struct rt_db_internal dbintern;
+    RT_DB_INTERNAL_INIT(&dbintern);
+    if (rt_db_get_internal(&dbintern, dp, dbip, NULL, res) < 0)
+	return 0;
+    key = ged_csg_lod_mesh(c, key, &dbintern, ttol, tol);
+    rt_db_free_internal(&dbintern);
+    if (key)
+	bv_mesh_lod_key_put(c, dp->d_namep, key);
+
+    return key;
+}
 
-	// Mark the object as a Mesh LoD so the drawing routine knows to handle it differently
-	vo->s_type_flags |= BV_MESH_LOD;
+/* Shaded CSG solids are tessellated once and drawn through the mesh LoD
+ * machinery, rather than re-tessellated at full detail on every draw.
+ * Returns 0 on success and -1 if the caller should fall back to the standard
+ * drawing path. */
+static int
+csg_mesh_adaptive_plot(struct bv_scene_obj *s, struct bview *v)
+{
+    if (!s || !v)
+	return -1;
+    struct draw_update_data_t *d = (struct draw_update_data_t *)s->s_i_data;
+    if (!d || !d->mesh_c)
+	return -1;
+    bv_log(1, "csg_mesh_adaptive_plot %s[%s]", bu_vls_cstr(&s->s_name), (v) ? bu_vls_cstr(&v->gv_name) : "NULL");
+
+    struct bv_scene_obj *vo = bv_obj_for_view(s, v);
+
+    if (!vo) {
+	struct db_full_path *fp = (struct db_full_path *)s->s_path;
+	struct directory *dp = (fp) ? DB_FULL_PATH_CUR_DIR(fp) : (struct directory *)s->dp;
+	if (!dp)
+	    return -1;
+
+	// If the name maps to a key generated with other tolerances or an
+	// older version of the solid, it's stale - regenerate.
+	unsigned long long key = bv_mesh_lod_key_get(d->mesh_c, dp->d_namep);
+	if (!key || key != ged_csg_lod_key(d->dbip, dp, d->ttol, d->tol))
+	    key = ged_csg_lod_cache(d->mesh_c, d->dbip, dp, d->ttol, d->tol, d->res);
+	if (!key)
+	    return -1;
+
+	struct bv_mesh_lod *lod = bv_mesh_lod_create(d->mesh_c, key);
+	if (!lod)
+	    return -1;
+
+	s->csg_obj = 0;
+	s->mesh_obj = 1;
+
+	vo = bv_obj_get_vo(s, v);
+	vo->csg_obj = 0;
+	vo->mesh_obj = 1;
+
+	mesh_lod_attach(s, vo, lod, NULL);
     }
 
     bv_mesh_lod_view(vo, vo->s_v, 0);
     bv_obj_stale(vo);
 
-    return;
+    return 0;
 }
 
 /* Wrapper to handle adaptive vs non-adaptive wireframes */
@@ -681,6 +967,18 @@ draw_scene(struct bv_scene_obj *s, struct bview *v)
 	return;
     }
 
+    // Shaded CSG solids are cached as meshes and drawn with the same LoD
+    // logic as BoTs, so large assemblies don't re-tessellate every solid at
+    // full detail.  Pipes are always wireframes (see below.)
+    if (dp->d_major_type == DB5_MAJORTYPE_BRLCAD && v && v->gv_s->adaptive_plot_mesh && s->s_os->s_dmode == 2 &&
+	    dp->d_minor_type != DB5_MINORTYPE_BRLCAD_BOT &&
+	    dp->d_minor_type != DB5_MINORTYPE_BRLCAD_BREP &&
+	    dp->d_minor_type != DB5_MINORTYPE_BRLCAD_PIPE &&
+	    !(dp->d_flags & RT_DIR_COMB)) {
+	if (csg_mesh_adaptive_plot(s, v) == 0)
+	    return;
+    }
+
     /**************************************************************************
      * For the remainder of the options we're into more standard wireframe
      * callback modes - crack the internal and stage the tolerances
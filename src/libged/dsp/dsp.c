@@ -37,6 +37,120 @@
 /* FIXME - we want the DSP macro for convenience here - should this be in include/rt/dsp.h ? */
 #include "../librt/primitives/dsp/dsp.h"
 
+
+static void
+dsp_put32(unsigned char *cp, uint32_t v)
+{
+    cp[0] = (unsigned char)(v >> 24);
+    cp[1] = (unsigned char)(v >> 16);
+    cp[2] = (unsigned char)(v >> 8);
+    cp[3] = (unsigned char)v;
+}
+
+
+/**
+ * Write the height field of a dsp out as a tiled data file (see the
+ * layout in dsp.h), which librt can raytrace straight from the mapped
+ * file.  The tiles are written as they are gathered, and the table of
+ * tile elevation ranges filled in afterwards.
+ */
+static int
+dsp_write_tiled(struct ged *gedp, struct rt_dsp_internal *dsp, const char *file)
+{
+    FILE *fp;
+    unsigned char hdr[DSP_TILED_HDR_LEN];
+    unsigned char *table, *tile;
+    size_t tw = (size_t)1 << DSP_TILE_SHIFT;
+    size_t ntx, nty, tx, ty, x, y, off;
+    int ret = BRLCAD_OK;
+
+    if (!dsp->dsp_xcnt || !dsp->dsp_ycnt) {
+	bu_vls_printf(gedp->ged_result_str, "dsp has no data");
+	return BRLCAD_ERROR;
+    }
+
+    fp = fopen(file, "wb");
+    if (!fp) {
+	bu_vls_printf(gedp->ged_result_str, "unable to open %s for writing", file);
+	return BRLCAD_ERROR;
+    }
+
+    ntx = ((size_t)dsp->dsp_xcnt - 1) / tw + 1;
+    nty = ((size_t)dsp->dsp_ycnt - 1) / tw + 1;
+
+    dsp_put32(hdr, DSP_TILED_MAGIC);
+    dsp_put32(hdr + 4, DSP_TILED_VERSION);
+    dsp_put32(hdr + 8, dsp->dsp_xcnt);
+    dsp_put32(hdr + 12, dsp->dsp_ycnt);
+    dsp_put32(hdr + 16, DSP_TILE_SHIFT);
+    dsp_put32(hdr + 20, 0);
+
+    off = DSP_TILED_DATA_OFF(ntx * nty);
+    table = (unsigned char *)bu_calloc(off - DSP_TILED_HDR_LEN, 1, "dsp tile table");
+    tile = (unsigned char *)bu_malloc(tw * tw * 2, "dsp tile");
+
+    /* leave room for the table, it is written once it is known */
+    if (fwrite(hdr, DSP_TILED_HDR_LEN, 1, fp) != 1
+	|| fwrite(table, off - DSP_TILED_HDR_LEN, 1, fp) != 1)
+	ret = BRLCAD_ERROR;
+
+    for (ty = 0; ty < nty && ret == BRLCAD_OK; ty++) {
+	for (tx = 0; tx < ntx && ret == BRLCAD_OK; tx++) {
+	    unsigned short lo = 0xffff;
+	    unsigned short hi = 0;
+	    unsigned char *cp = tile;
+
+	    for (y = ty * tw; y < (ty + 1) * tw; y++) {
+		for (x = tx * tw; x < (tx + 1) * tw; x++) {
+		    /* pad past the edges with the edge samples */
+		    size_t sx = FMIN(x, (size_t)dsp->dsp_xcnt - 1);
+		    size_t sy = FMIN(y, (size_t)dsp->dsp_ycnt - 1);
+		    unsigned short elev = DSP(dsp, sx, sy);
+
+		    *cp++ = (unsigned char)(elev >> 8);
+		    *cp++ = (unsigned char)elev;
+		}
+	    }
+
+	    /* the range covers the cells in the tile, and so one more
+	     * row and column of samples
+	     */
+	    for (y = ty * tw; y <= (ty + 1) * tw && y < dsp->dsp_ycnt; y++) {
+		for (x = tx * tw; x <= (tx + 1) * tw && x < dsp->dsp_xcnt; x++) {
+		    unsigned short elev = DSP(dsp, x, y);
+		    V_MIN(lo, elev);
+		    V_MAX(hi, elev);
+		}
+	    }
+	    cp = table + (ty * ntx + tx) * 4;
+	    cp[0] = (unsigned char)(lo >> 8);
+	    cp[1] = (unsigned char)lo;
+	    cp[2] = (unsigned char)(hi >> 8);
+	    cp[3] = (unsigned char)hi;
+
+	    if (fwrite(tile, tw * tw * 2, 1, fp) != 1)
+		ret = BRLCAD_ERROR;
+	}
+    }
+
+    if (ret == BRLCAD_OK
+	&& (fseek(fp, DSP_TILED_HDR_LEN, SEEK_SET)
+	    || fwrite(table, off - DSP_TILED_HDR_LEN, 1, fp) != 1))
+	ret = BRLCAD_ERROR;
+    if (fclose(fp))
+	ret = BRLCAD_ERROR;
+
+    bu_free(table, "dsp tile table");
+    bu_free(tile, "dsp tile");
+
+    if (ret != BRLCAD_OK)
+	bu_vls_printf(gedp->ged_result_str, "error writing %s", file);
+    else
+	bu_vls_printf(gedp->ged_result_str, "wrote %zux%zu tiles to %s", ntx, nty, file);
+
+    return ret;
+}
+
 int
 ged_dsp_core(struct ged *gedp, int argc, const char *argv[])
 {
@@ -61,6 +175,7 @@ ged_dsp_core(struct ged *gedp, int argc, const char *argv[])
 	bu_vls_printf(gedp->ged_result_str, "commands:\n");
 	bu_vls_printf(gedp->ged_result_str, "\txy x y                  - report the height value at (x,y)\n");
 	bu_vls_printf(gedp->ged_result_str, "\tdiff obj [min_diff_val] - report height differences at x,y coordinates between two dsp objects\n");
+	bu_vls_printf(gedp->ged_result_str, "\ttile file               - write the height field to file in tiled form\n");
 	return BRLCAD_ERROR;
     }
 
@@ -143,6 +258,18 @@ ged_dsp_core(struct ged *gedp, int argc, const char *argv[])
 	return BRLCAD_OK;
     }
 
+    if (BU_STR_EQUAL(sub, "tile")) {
+	int ret;
+	if (argc < 4) {
+	    bu_vls_printf(gedp->ged_result_str, "Error - tile subcommand specified, but not the file to write.");
+	    rt_db_free_internal(&intern);
+	    return BRLCAD_ERROR;
+	}
+	ret = dsp_write_tiled(gedp, dsp, argv[3]);
+	rt_db_free_internal(&intern);
+	return ret;
+    }
+
     bu_vls_printf(gedp->ged_result_str, "Error - unknown dsp subcommand: %s", sub);
     rt_db_free_internal(&intern);
     return BRLCAD_ERROR;
@@ -65,7 +65,11 @@ ged_close(struct ged *gedp)
     if (gedp == GED_NULL)
 	return;
 
+    // Background LoD workers use both the dbip and the LoD context
+    ged_lod_cache_bg_cancel(gedp);
+
     if (gedp->dbip) {
+	ged_csg_lod_keys_free(gedp->dbip);
 	db_close(gedp->dbip);
 	gedp->dbip = NULL;
     }
@@ -182,6 +186,8 @@ ged_free(struct ged *gedp)
     if (!gedp)
 	return;
 
+    ged_lod_cache_bg_cancel(gedp);
+
     bu_vls_free(&gedp->go_name);
 
     gedp->ged_gvp = NULL;
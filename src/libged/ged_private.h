@@ -48,6 +48,8 @@
 #include <stack>
 #include <string>
 
+class GedLoDCacheJob;
+
 class Ged_Internal {
     public:
 	struct ged *gedp;
@@ -67,6 +69,9 @@ class Ged_Internal {
 	// commands and subcommands.
 	vect_t ged_eye_model = VINIT_ZERO;
 	mat_t ged_viewrot = MAT_INIT_ZERO;
+
+	// Background mesh LoD cache generation (see lod_cache.cpp)
+	GedLoDCacheJob *lod_cache_job = NULL;
 };
 
 #else
@@ -224,6 +229,32 @@ GED_EXPORT extern void _ged_cvt_vlblock_to_solids(struct ged *gedp,
 				       const char *name,
 				       int copy);
 
+/* defined in draw.cpp */
+struct bv_mesh_lod_context;
+GED_EXPORT extern int ged_lod_cacheable(struct directory *dp);
+GED_EXPORT extern unsigned long long ged_csg_lod_key(struct db_i *dbip, struct directory *dp, const struct bg_tess_tol *ttol, const struct bn_tol *tol);
+/* Release the CSG LoD key table of dbip - call before closing it */
+GED_EXPORT extern void ged_csg_lod_keys_free(struct db_i *dbip);
+/* Key for an object's serialized form ext, as ged_csg_lod_key would compute */
+GED_EXPORT extern unsigned long long ged_csg_lod_key_ext(const struct bu_external *ext, const struct bg_tess_tol *ttol, const struct bn_tol *tol);
+/* Tessellate ip into the LoD cache under key, without associating it with
+ * any object name.  Returns key, or 0 on failure. */
+GED_EXPORT extern unsigned long long ged_csg_lod_mesh(struct bv_mesh_lod_context *c, unsigned long long key, struct rt_db_internal *ip, const struct bg_tess_tol *ttol, const struct bn_tol *tol);
+GED_EXPORT extern unsigned long long ged_csg_lod_cache(struct bv_mesh_lod_context *c, struct db_i *dbip, struct directory *dp, const struct bg_tess_tol *ttol, const struct bn_tol *tol, struct resource *res);
+
+/* defined in lod_cache.cpp */
+GED_EXPORT extern unsigned long long ged_lod_cache_obj(struct bv_mesh_lod_context *c, struct db_i *dbip, struct directory *dp, const struct bg_tess_tol *ttol, const struct bn_tol *tol, struct resource *res);
+/* Start generating LoD cache data for all mesh capable objects in the
+ * database, using nthreads background workers (if nthreads <= 0 a default is
+ * chosen.)  Objects drawn in view v are processed first.  Any job already in
+ * progress is cancelled.  Returns immediately. */
+GED_EXPORT extern int ged_lod_cache_bg_start(struct ged *gedp, struct bview *v, int nthreads);
+/* Report progress of the background job.  Returns 1 if it is still running, 0
+ * if it has finished and -1 if there is no job. */
+GED_EXPORT extern int ged_lod_cache_bg_status(struct ged *gedp, size_t *done, size_t *total, size_t *failed, int64_t *elapsed);
+/* Stop the background job (if any), waiting for workers to exit */
+GED_EXPORT extern void ged_lod_cache_bg_cancel(struct ged *gedp);
+
 /* defined in editit.c */
 GED_EXPORT extern int _ged_editit(const char *editstring,
 		       const char *file);
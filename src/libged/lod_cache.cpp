@@ -0,0 +1,524 @@
+/*                   L O D _ C A C H E . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libged/lod_cache.cpp
+ *
+ * Population of the mesh Level-of-Detail cache for database objects.
+ *
+ * Generating the LoD data for a large mesh is expensive, and if it is left to
+ * the drawing code it happens the first time an object is displayed - which
+ * stalls the application.  The routines here allow the cache for an entire
+ * database to be built ahead of time, either synchronously or by a set of
+ * background worker threads.  The background job orders its work so objects
+ * visible in the current view are processed first, and reports progress and
+ * accepts cancellation requests through the "view lod cache" subcommands.
+ */
+
+#include "common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bu/hash.h"
+#include "bu/parallel.h"
+#include "bu/time.h"
+#include "bv/lod.h"
+#include "bv/tcl_data.h"
+#include "raytrace.h"
+#include "ged/view.h"
+#include "./ged_private.h"
+
+/* A copy of what a worker needs to know about one database object.  Objects
+ * are copied out of the database before any worker starts, so the workers
+ * never read the database itself and the application remains free to edit,
+ * kill or rename objects while the cache is being built. */
+struct GedLoDCacheObj {
+    std::string name;
+    int minor_type = 0;
+    struct bu_external ext = BU_EXTERNAL_INIT_ZERO;
+    // Imported up front for solids whose import reads other objects or
+    // data files, and for v4 databases, which have no v5 import path
+    struct rt_db_internal *ip = NULL;
+    // Set if the object was changed after the copy was taken
+    int stale = 0;
+};
+
+class GedLoDCacheJob {
+    public:
+	~GedLoDCacheJob();
+
+	struct db_i *dbip = NULL;
+	struct bv_mesh_lod_context *c = NULL;
+	struct bn_tol tol;
+	struct bg_tess_tol ttol;
+
+	// Objects, in processing order
+	std::vector<GedLoDCacheObj> objs;
+	std::unordered_map<std::string, size_t> obj_ind;
+	size_t nthreads = 1;
+	std::vector<struct resource> res;
+
+	// Guards the stale flags and the name to key associations made
+	// by the workers
+	std::mutex lock;
+
+	std::atomic<size_t> next{0};
+	std::atomic<size_t> next_res{0};
+	std::atomic<size_t> done{0};
+	std::atomic<size_t> failed{0};
+	size_t skipped = 0;	// objects that couldn't be copied
+	std::atomic<int> cancel{0};
+	std::atomic<int> running{0};
+
+	int64_t start_time = 0;
+	int64_t elapsed = 0;
+
+	std::thread runner;
+};
+
+static void
+lod_cache_obj_free(GedLoDCacheObj &o)
+{
+    if (o.ext.ext_buf)
+	bu_free_external(&o.ext);
+    if (o.ip) {
+	rt_db_free_internal(o.ip);
+	BU_PUT(o.ip, struct rt_db_internal);
+	o.ip = NULL;
+    }
+}
+
+GedLoDCacheJob::~GedLoDCacheJob()
+{
+    for (size_t i = 0; i < objs.size(); i++)
+	lod_cache_obj_free(objs[i]);
+}
+
+static int
+lod_cache_obj_copy(GedLoDCacheObj &o, struct db_i *dbip, struct directory *dp)
+{
+    o.name = std::string(dp->d_namep);
+    o.minor_type = dp->d_minor_type;
+
+    int need_import = (db_version(dbip) < 5);
+    switch (dp->d_minor_type) {
+	case DB5_MINORTYPE_BRLCAD_DSP:
+	case DB5_MINORTYPE_BRLCAD_EBM:
+	case DB5_MINORTYPE_BRLCAD_VOL:
+	case DB5_MINORTYPE_BRLCAD_EXTRUDE:
+	case DB5_MINORTYPE_BRLCAD_REVOLVE:
+	case DB5_MINORTYPE_BRLCAD_SUBMODEL:
+	    need_import = 1;
+	    break;
+	default:
+	    break;
+    }
+    if (need_import) {
+	BU_GET(o.ip, struct rt_db_internal);
+	RT_DB_INTERNAL_INIT(o.ip);
+	if (rt_db_get_internal(o.ip, dp, dbip, NULL, &rt_uniresource) < 0) {
+	    BU_PUT(o.ip, struct rt_db_internal);
+	    o.ip = NULL;
+	    return -1;
+	}
+    }
+
+    // BRep and CSG keys are computed from the serialized form
+    if (db_get_external(&o.ext, dp, dbip)) {
+	lod_cache_obj_free(o);
+	return -1;
+    }
+
+    return 0;
+}
+
+static unsigned long long
+lod_cache_bot(struct bv_mesh_lod_context *c, struct rt_db_internal *ip)
+{
+    if (ip->idb_minor_type != DB5_MINORTYPE_BRLCAD_BOT)
+	return 0;
+    struct rt_bot_internal *bot = (struct rt_bot_internal *)ip->idb_ptr;
+    RT_BOT_CK_MAGIC(bot);
+    return bv_mesh_lod_cache(c, (const point_t *)bot->vertices, bot->num_vertices, NULL, bot->faces, bot->num_faces, 0, 0.66);
+}
+
+static unsigned long long
+lod_cache_brep(struct bv_mesh_lod_context *c, unsigned long long key, struct rt_db_internal *ip, const struct bg_tess_tol *ttol, const struct bn_tol *tol)
+{
+    if (ip->idb_minor_type != DB5_MINORTYPE_BRLCAD_BREP)
+	return 0;
+    struct rt_brep_internal *bi = (struct rt_brep_internal *)ip->idb_ptr;
+    RT_BREP_CK_MAGIC(bi);
+
+    // Unlike a BoT, which has the mesh data already, we need to generate the
+    // mesh from the brep
+    int *faces = NULL;
+    int face_cnt = 0;
+    vect_t *normals = NULL;
+    point_t *pnts = NULL;
+    int pnt_cnt = 0;
+
+    int bret = brep_cdt_fast(&faces, &face_cnt, &normals, &pnts, &pnt_cnt, bi->brep, -1, ttol, tol);
+    if (bret == BRLCAD_OK) {
+	// Because we won't have the internal data to use for a full detail scenario, we set the ratio
+	// to 1 rather than .66 for breps...
+	key = bv_mesh_lod_cache(c, (const point_t *)pnts, pnt_cnt, normals, faces, face_cnt, key, 1);
+    } else {
+	key = 0;
+    }
+
+    bu_free(faces, "faces");
+    bu_free(normals, "normals");
+    bu_free(pnts, "pnts");
+
+    return key;
+}
+
+/* Generate the LoD data for a copied object.  Only the copy is used - the
+ * database is needed solely for its version - and the resulting key is not
+ * associated with the object name; that is left to the caller. */
+static unsigned long long
+lod_cache_obj_process(struct bv_mesh_lod_context *c, struct db_i *dbip, GedLoDCacheObj &o, const struct bg_tess_tol *ttol, const struct bn_tol *tol, struct resource *res)
+{
+    unsigned long long key = 0;
+
+    // Objects without mesh data of their own are keyed on their serialized
+    // form, so there's no need to import them if they're already cached
+    if (o.minor_type != DB5_MINORTYPE_BRLCAD_BOT) {
+	if (o.minor_type == DB5_MINORTYPE_BRLCAD_BREP)
+	    key = bu_data_hash((void *)o.ext.ext_buf, o.ext.ext_nbytes);
+	else
+	    key = ged_csg_lod_key_ext(&o.ext, ttol, tol);
+	if (!key)
+	    return 0;
+	struct bv_mesh_lod *lod = bv_mesh_lod_create(c, key);
+	if (lod) {
+	    bv_mesh_lod_destroy(lod);
+	    return key;
+	}
+    }
+
+    struct rt_db_internal dbintern;
+    struct rt_db_internal *ip = o.ip;
+    if (!ip) {
+	RT_DB_INTERNAL_INIT(&dbintern);
+	if (rt_db_external5_to_internal5(&dbintern, &o.ext, o.name.c_str(), dbip, NULL, res) < 0)
+	    return 0;
+	ip = &dbintern;
+    }
+
+    if (o.minor_type == DB5_MINORTYPE_BRLCAD_BOT) {
+	key = lod_cache_bot(c, ip);
+    } else if (o.minor_type == DB5_MINORTYPE_BRLCAD_BREP) {
+	key = lod_cache_brep(c, key, ip, ttol, tol);
+    } else {
+	key = ged_csg_lod_mesh(c, key, ip, ttol, tol);
+    }
+
+    if (ip == &dbintern)
+	rt_db_free_internal(&dbintern);
+
+    return key;
+}
+
+extern "C" unsigned long long
+ged_lod_cache_obj(struct bv_mesh_lod_context *c, struct db_i *dbip, struct directory *dp, const struct bg_tess_tol *ttol, const struct bn_tol *tol, struct resource *res)
+{
+    if (!c || !dbip || !ged_lod_cacheable(dp))
+	return 0;
+
+    // CSG solid keys are remembered per directory entry by draw.cpp
+    if (dp->d_minor_type != DB5_MINORTYPE_BRLCAD_BOT && dp->d_minor_type != DB5_MINORTYPE_BRLCAD_BREP)
+	return ged_csg_lod_cache(c, dbip, dp, ttol, tol, res);
+
+    GedLoDCacheObj o;
+    if (lod_cache_obj_copy(o, dbip, dp))
+	return 0;
+    unsigned long long key = lod_cache_obj_process(c, dbip, o, ttol, tol, res);
+    if (key)
+	bv_mesh_lod_key_put(c, dp->d_namep, key);
+    lod_cache_obj_free(o);
+
+    return key;
+}
+
+
+/* Collect the database objects associated with a scene object hierarchy,
+ * along with their current on-screen sizes */
+static void
+lod_cache_scene_objs(std::vector<std::pair<fastf_t, struct directory *>> &vobjs, struct bv_scene_obj *s, struct bview *v)
+{
+    if (!s)
+	return;
+
+    for (size_t i = 0; i < BU_PTBL_LEN(&s->children); i++) {
+	struct bv_scene_obj *cs = (struct bv_scene_obj *)BU_PTBL_GET(&s->children, i);
+	lod_cache_scene_objs(vobjs, cs, v);
+    }
+
+    struct directory *dp = NULL;
+    if (s->s_path) {
+	struct db_full_path *fp = (struct db_full_path *)s->s_path;
+	if (fp->fp_len > 0)
+	    dp = DB_FULL_PATH_CUR_DIR(fp);
+    } else if (s->s_u_data) {
+	struct ged_bv_data *bdata = (struct ged_bv_data *)s->s_u_data;
+	if (bdata->s_fullpath.fp_len > 0)
+	    dp = DB_FULL_PATH_CUR_DIR(&bdata->s_fullpath);
+    } else {
+	dp = (struct directory *)s->dp;
+    }
+    if (!ged_lod_cacheable(dp))
+	return;
+
+    vobjs.push_back(std::make_pair(bv_scene_obj_screen_size(s, v), dp));
+}
+
+/* Build the processing order for the job - objects drawn in the view come
+ * first, largest on screen to smallest, followed by everything else in the
+ * database. */
+static void
+lod_cache_order(GedLoDCacheJob *j, struct ged *gedp, struct bview *v)
+{
+    std::vector<std::pair<fastf_t, struct directory *>> vobjs;
+
+    if (v) {
+	struct bu_ptbl *db_objs = bv_view_objs(v, BV_DB_OBJS);
+	for (size_t i = 0; db_objs && i < BU_PTBL_LEN(db_objs); i++) {
+	    struct bv_scene_obj *s = (struct bv_scene_obj *)BU_PTBL_GET(db_objs, i);
+	    lod_cache_scene_objs(vobjs, s, v);
+	}
+	struct bu_ptbl *local_db_objs = bv_view_objs(v, BV_DB_OBJS | BV_LOCAL_OBJS);
+	for (size_t i = 0; local_db_objs && i < BU_PTBL_LEN(local_db_objs); i++) {
+	    struct bv_scene_obj *s = (struct bv_scene_obj *)BU_PTBL_GET(local_db_objs, i);
+	    lod_cache_scene_objs(vobjs, s, v);
+	}
+
+	// Older drawing code stores its objects in the display list
+	if (gedp->ged_gdp && gedp->ged_gdp->gd_headDisplay) {
+	    struct display_list *gdlp;
+	    for (BU_LIST_FOR(gdlp, display_list, gedp->ged_gdp->gd_headDisplay)) {
+		struct bv_scene_obj *sp;
+		for (BU_LIST_FOR(sp, bv_scene_obj, &gdlp->dl_head_scene_obj)) {
+		    lod_cache_scene_objs(vobjs, sp, v);
+		}
+	    }
+	}
+    }
+
+    std::stable_sort(vobjs.begin(), vobjs.end(),
+	    [](const std::pair<fastf_t, struct directory *> &a, const std::pair<fastf_t, struct directory *> &b) {
+	    return a.first > b.first;
+	    });
+
+    std::vector<struct directory *> order;
+    std::set<struct directory *> queued;
+    for (size_t i = 0; i < vobjs.size(); i++) {
+	if (queued.find(vobjs[i].second) != queued.end())
+	    continue;
+	queued.insert(vobjs[i].second);
+	order.push_back(vobjs[i].second);
+    }
+
+    struct directory *dp;
+    FOR_ALL_DIRECTORY_START(dp, gedp->dbip) {
+	if (!ged_lod_cacheable(dp) || queued.find(dp) != queued.end())
+	    continue;
+	order.push_back(dp);
+    } FOR_ALL_DIRECTORY_END;
+
+    j->objs.reserve(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+	GedLoDCacheObj o;
+	if (lod_cache_obj_copy(o, gedp->dbip, order[i])) {
+	    j->skipped++;
+	    continue;
+	}
+	j->obj_ind[o.name] = j->objs.size();
+	j->objs.push_back(std::move(o));
+    }
+}
+
+static void
+lod_cache_worker(int UNUSED(cpu), void *data)
+{
+    GedLoDCacheJob *j = (GedLoDCacheJob *)data;
+
+    // The cpu number bu_parallel hands us is its thread id, which isn't
+    // bounded by our thread count - take a resource of our own.  Any
+    // workers beyond nthreads were only started to keep the real ones off
+    // of parallel id 0 (see lod_cache_run.)
+    size_t rind = j->next_res.fetch_add(1);
+    if (rind >= j->nthreads)
+	return;
+    struct resource *res = &j->res[rind];
+
+    while (!j->cancel) {
+	size_t ind = j->next.fetch_add(1);
+	if (ind >= j->objs.size())
+	    break;
+	GedLoDCacheObj &o = j->objs[ind];
+	unsigned long long key = lod_cache_obj_process(j->c, j->dbip, o, &j->ttol, &j->tol, res);
+	if (key) {
+	    // If the object changed while we were working, the key belongs
+	    // to the old version - don't associate it with the name.
+	    std::lock_guard<std::mutex> g(j->lock);
+	    if (!o.stale)
+		bv_mesh_lod_key_put(j->c, o.name.c_str(), key);
+	} else {
+	    j->failed++;
+	}
+	lod_cache_obj_free(o);
+	j->done++;
+    }
+}
+
+static void
+lod_cache_run(GedLoDCacheJob *j)
+{
+    // bu_parallel runs a lone worker directly in the calling thread, whose
+    // parallel id is 0 - the BU_SETJUMP slot of the application's main
+    // thread.  Always ask for at least two so every worker is started as a
+    // thread with an id of its own.
+    size_t ncpu = (j->nthreads > 1) ? j->nthreads : 2;
+    bu_parallel(lod_cache_worker, ncpu, (void *)j);
+    j->elapsed = bu_gettime() - j->start_time;
+    j->running = 0;
+}
+
+/* Database change callback - objects edited after the job copied them must
+ * not have the keys generated from the copies associated with their names. */
+static void
+lod_cache_db_changed(struct db_i *UNUSED(dbip), struct directory *dp, int UNUSED(mode), void *u_data)
+{
+    GedLoDCacheJob *j = (GedLoDCacheJob *)u_data;
+    if (!dp || !dp->d_namep)
+	return;
+    auto o_it = j->obj_ind.find(std::string(dp->d_namep));
+    if (o_it == j->obj_ind.end())
+	return;
+
+    std::lock_guard<std::mutex> g(j->lock);
+    j->objs[o_it->second].stale = 1;
+    // A worker may already have finished with the old version
+    bv_mesh_lod_key_put(j->c, dp->d_namep, 0);
+}
+
+extern "C" void
+ged_lod_cache_bg_cancel(struct ged *gedp)
+{
+    if (!gedp || !gedp->i || !gedp->i->i)
+	return;
+    GedLoDCacheJob *j = gedp->i->i->lod_cache_job;
+    if (!j)
+	return;
+
+    // Workers check the flag between objects, so we may need to wait for
+    // the in-progress meshes to finish.
+    j->cancel = 1;
+    if (j->runner.joinable())
+	j->runner.join();
+
+    db_rm_changed_clbk(j->dbip, &lod_cache_db_changed, (void *)j);
+
+    for (size_t i = 0; i < j->res.size(); i++)
+	rt_clean_resource_complete(NULL, &j->res[i]);
+
+    delete j;
+    gedp->i->i->lod_cache_job = NULL;
+}
+
+extern "C" int
+ged_lod_cache_bg_start(struct ged *gedp, struct bview *v, int nthreads)
+{
+    if (!gedp || !gedp->dbip || !gedp->ged_lod || !gedp->i || !gedp->i->i)
+	return BRLCAD_ERROR;
+
+    // Only one job at a time - clear out any previous (finished or not)
+    ged_lod_cache_bg_cancel(gedp);
+
+    GedLoDCacheJob *j = new GedLoDCacheJob;
+    j->dbip = gedp->dbip;
+    j->c = gedp->ged_lod;
+
+    struct rt_wdb *wdbp = wdb_dbopen(gedp->dbip, RT_WDB_TYPE_DB_DEFAULT);
+    j->tol = wdbp->wdb_tol;
+    j->ttol = wdbp->wdb_ttol;
+
+    lod_cache_order(j, gedp, v);
+
+    // Leave a processor for the application unless told otherwise
+    int ncpus = bu_avail_cpus();
+    if (nthreads <= 0)
+	nthreads = (ncpus > 1) ? ncpus - 1 : 1;
+    if (nthreads > MAX_PSW)
+	nthreads = MAX_PSW;
+    j->nthreads = (size_t)nthreads;
+    j->res.resize(j->nthreads);
+    for (size_t i = 0; i < j->nthreads; i++)
+	rt_init_resource(&j->res[i], (int)i, NULL);
+
+    gedp->i->i->lod_cache_job = j;
+    db_add_changed_clbk(j->dbip, &lod_cache_db_changed, (void *)j);
+
+    j->start_time = bu_gettime();
+    j->running = 1;
+    j->runner = std::thread(lod_cache_run, j);
+
+    return BRLCAD_OK;
+}
+
+extern "C" int
+ged_lod_cache_bg_status(struct ged *gedp, size_t *done, size_t *total, size_t *failed, int64_t *elapsed)
+{
+    if (!gedp || !gedp->i || !gedp->i->i)
+	return -1;
+    GedLoDCacheJob *j = gedp->i->i->lod_cache_job;
+    if (!j)
+	return -1;
+
+    if (done)
+	(*done) = j->done + j->skipped;
+    if (total)
+	(*total) = j->objs.size() + j->skipped;
+    if (failed)
+	(*failed) = j->failed + j->skipped;
+    if (elapsed)
+	(*elapsed) = (j->running) ? bu_gettime() - j->start_time : j->elapsed;
+
+    return (j->running) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C++
+ * c-basic-offset: 4
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -32,6 +32,7 @@
 
 #include "bu.h"
 #include "ged.h"
+#include "wdb.h"
 #include "rt/search.h"
 
 class UnitTests {
@@ -157,6 +158,213 @@ bool AndSearches(struct ged* gedp) {
     return reg_comb;
 }
 
+/* run one search and flatten its results to strings, in result order */
+static std::vector<std::string>
+search_strings(int *cnt, int flags, const char *filter, int path_c, struct directory **path_v, struct db_i *dbip)
+{
+    std::vector<std::string> strs;
+    struct bu_ptbl search_results = BU_PTBL_INIT_ZERO;
+
+    *cnt = db_search(&search_results, flags, filter, path_c, path_v, dbip, NULL, NULL, NULL);
+    for (size_t i = 0; i < BU_PTBL_LEN(&search_results); i++) {
+	if (flags & (DB_SEARCH_FLAT | DB_SEARCH_RETURN_UNIQ_DP)) {
+	    struct directory *dp = (struct directory *)BU_PTBL_GET(&search_results, i);
+	    strs.push_back(std::string(dp->d_namep));
+	} else {
+	    struct db_full_path *fp = (struct db_full_path *)BU_PTBL_GET(&search_results, i);
+	    char *fps = db_path_to_string(fp);
+	    strs.push_back(std::string(fps));
+	    bu_free(fps, "path string");
+	}
+    }
+    if (flags & (DB_SEARCH_FLAT | DB_SEARCH_RETURN_UNIQ_DP))
+	bu_ptbl_free(&search_results);
+    else
+	db_search_free(&search_results);
+
+    return strs;
+}
+
+/* every filter, under every search mode, must give the same results
+ * in the same order whether evaluated on one thread or several */
+static bool
+parallel_matches_serial(struct db_i *dbip, size_t min_nonempty)
+{
+    const char *filters[] = {
+	"",
+	"-type region",
+	"-type shape",
+	"-type comb -not -type region",
+	"-name *.s",
+	"-name *1*",
+	"-attr region_id>1020",
+	"-attr top_index<5",
+	"-attr rgb",
+	"-bool -",
+	"-depth>2",
+	"-mindepth 2 -maxdepth 3",
+	"-matrix 1,0,0,0,0,1,0,50,0,0,1,0,0,0,0,1",
+	"-nnodes>2",
+	"-below -type region",
+	"-below -name common.c",
+	"-above -name s3.s",
+	"-above -attr rgb -and -type comb",
+	"-not -below -type comb",
+	"( -type region -above -bool - ) -or -name *top*",
+	"-path */common.c/*",
+	NULL
+    };
+    const int modes[] = {
+	DB_SEARCH_TREE,
+	DB_SEARCH_HIDDEN,
+	DB_SEARCH_RETURN_UNIQ_DP,
+	DB_SEARCH_RETURN_UNIQ_DP | DB_SEARCH_HIDDEN
+    };
+    struct directory **all = NULL;
+    int all_cnt;
+    bool pass = true;
+    size_t nonempty = 0;
+
+    all_cnt = db_ls(dbip, DB_LS_HIDDEN, NULL, &all);
+
+    for (int f = 0; filters[f]; f++) {
+	for (size_t m = 0; m < sizeof(modes)/sizeof(modes[0]) + 1; m++) {
+	    int flags, path_c = 0, scnt, pcnt;
+	    struct directory **path_v = NULL;
+
+	    if (m < sizeof(modes)/sizeof(modes[0])) {
+		flags = modes[m] | DB_SEARCH_QUIET;
+	    } else {
+		/* a flat search over every object, as "search -flat" does */
+		flags = DB_SEARCH_FLAT | DB_SEARCH_HIDDEN | DB_SEARCH_QUIET;
+		path_c = all_cnt;
+		path_v = all;
+	    }
+
+	    std::vector<std::string> serial = search_strings(&scnt, flags | DB_SEARCH_SERIAL, filters[f], path_c, path_v, dbip);
+	    std::vector<std::string> parallel = search_strings(&pcnt, flags, filters[f], path_c, path_v, dbip);
+
+	    if (scnt != pcnt || serial != parallel) {
+		std::cerr << "[FAIL] \"" << filters[f] << "\" flags " << flags << ": serial found "
+			  << serial.size() << " (" << scnt << "), parallel " << parallel.size() << " (" << pcnt << ")" << std::endl;
+		for (size_t i = 0; i < serial.size() || i < parallel.size(); i++) {
+		    const std::string &ss = (i < serial.size()) ? serial[i] : std::string("-");
+		    const std::string &ps = (i < parallel.size()) ? parallel[i] : std::string("-");
+		    if (ss != ps) {
+			std::cerr << "  first difference at " << i << ": " << ss << " vs " << ps << std::endl;
+			break;
+		    }
+		}
+		pass = false;
+	    }
+	    if (serial.size())
+		nonempty++;
+	}
+    }
+
+    bu_free(all, "all objects");
+
+    /* make sure the filters actually selected something */
+    if (nonempty < min_nonempty) {
+	std::cerr << "[FAIL] only " << nonempty << " searches found anything" << std::endl;
+	pass = false;
+    }
+
+    return pass;
+}
+
+bool ParallelSearches(struct ged* gedp) {
+    return parallel_matches_serial(gedp->dbip, 1);
+}
+
+/* A generated database of many top level assemblies, sharing
+ * primitives and a common subassembly, with attributes, subtractions,
+ * matrices and a hidden top, so the starting objects handed to the
+ * search threads overlap heavily */
+bool GeneratedParallelSearches(struct ged* UNUSED(gedp)) {
+    const int NTOPS = 24;
+    const int NPRIMS = 8;
+    struct db_i *dbip = db_create_inmem();
+    struct rt_wdb *wdbp = wdb_dbopen(dbip, RT_WDB_TYPE_DB_INMEM);
+    struct bu_vls name = BU_VLS_INIT_ZERO;
+    struct bu_vls memb = BU_VLS_INIT_ZERO;
+    struct bu_vls val = BU_VLS_INIT_ZERO;
+    struct wmember wm;
+    unsigned char rgb[3] = {200, 100, 50};
+    mat_t mat;
+    bool pass;
+
+    for (int i = 0; i < NPRIMS; i++) {
+	point_t center;
+	VSET(center, i * 10.0, 0, 0);
+	bu_vls_sprintf(&name, "s%d.s", i);
+	mk_sph(wdbp, bu_vls_cstr(&name), center, 4.0 + i);
+    }
+
+    BU_LIST_INIT(&wm.l);
+    mk_addmember("s0.s", &wm.l, NULL, WMOP_UNION);
+    mk_addmember("s1.s", &wm.l, NULL, WMOP_SUBTRACT);
+    mk_lrcomb(wdbp, "common.r", &wm, 1, NULL, NULL, rgb, 1000, 0, 1, 100, 0);
+    BU_LIST_INIT(&wm.l);
+    mk_addmember("common.r", &wm.l, NULL, WMOP_UNION);
+    mk_addmember("s2.s", &wm.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, "common.c", &wm, 0, NULL, NULL, NULL, 0);
+
+    MAT_IDN(mat);
+    MAT_DELTAS(mat, 0, 50, 0);
+
+    for (int t = 0; t < NTOPS; t++) {
+	struct wmember top;
+	BU_LIST_INIT(&top.l);
+
+	for (int a = 0; a < 3; a++) {
+	    struct wmember assem;
+	    BU_LIST_INIT(&assem.l);
+
+	    for (int r = 0; r < 2; r++) {
+		int id = 1001 + (t * 3 + a) * 2 + r;
+		BU_LIST_INIT(&wm.l);
+		bu_vls_sprintf(&memb, "s%d.s", (t + a + r) % NPRIMS);
+		mk_addmember(bu_vls_cstr(&memb), &wm.l, NULL, WMOP_UNION);
+		bu_vls_sprintf(&memb, "s%d.s", (t + 2 * a + r + 1) % NPRIMS);
+		mk_addmember(bu_vls_cstr(&memb), &wm.l, NULL, (r) ? WMOP_SUBTRACT : WMOP_INTERSECT);
+		bu_vls_sprintf(&name, "r%d_%d_%d.r", t, a, r);
+		mk_lrcomb(wdbp, bu_vls_cstr(&name), &wm, 1, NULL, NULL, (id % 3) ? NULL : rgb, id, 0, 1, 100, 0);
+		mk_addmember(bu_vls_cstr(&name), &assem.l, (r) ? mat : NULL, WMOP_UNION);
+	    }
+	    if ((t + a) % 4 == 0)
+		mk_addmember("common.c", &assem.l, NULL, WMOP_UNION);
+
+	    bu_vls_sprintf(&name, "a%d_%d.c", t, a);
+	    mk_lcomb(wdbp, bu_vls_cstr(&name), &assem, 0, NULL, NULL, NULL, 0);
+	    mk_addmember(bu_vls_cstr(&name), &top.l, (a == 2) ? mat : NULL, (a == 1 && t % 2) ? WMOP_SUBTRACT : WMOP_UNION);
+	}
+	if (t % 5 == 0)
+	    mk_addmember("common.c", &top.l, NULL, WMOP_UNION);
+
+	bu_vls_sprintf(&name, "top%d.c", t);
+	mk_lcomb(wdbp, bu_vls_cstr(&name), &top, 0, NULL, NULL, NULL, 0);
+	bu_vls_sprintf(&val, "%d", t);
+	db5_update_attribute(bu_vls_cstr(&name), "top_index", bu_vls_cstr(&val), dbip);
+    }
+
+    /* hide one of the tops */
+    {
+	struct directory *dp = db_lookup(dbip, "top3.c", LOOKUP_QUIET);
+	if (dp)
+	    dp->d_flags |= RT_DIR_HIDDEN;
+    }
+
+    bu_vls_free(&name);
+    bu_vls_free(&memb);
+    bu_vls_free(&val);
+
+    pass = parallel_matches_serial(dbip, 50);
+
+    db_close(dbip);
+    return pass;
+}
+
 void CheckUsage(int ac, char* av[]) {
     if (ac != 2) {
         bu_exit(BRLCAD_ERROR, "Usage: %s file.g", av[0]);
@@ -172,6 +380,9 @@ int main(int ac, char *av[]) {
 
     CheckUsage(ac, av);
 
+    // spread searches over several threads even on a single core host
+    bu_setenv("LIBRT_SEARCH_NCPU", "4", 1);
+
     // good usage, open db
     struct ged* gedp = ged_open("db", av[1], 1);
 
@@ -183,6 +394,8 @@ int main(int ac, char *av[]) {
     uTests.addTest("Attr Searches", AttrSearches, gedp);
     uTests.addTest("Or Searches", OrSearches, gedp);
     uTests.addTest("And Searches", AndSearches, gedp);
+    uTests.addTest("Parallel Searches", ParallelSearches, gedp);
+    uTests.addTest("Generated Parallel Searches", GeneratedParallelSearches, gedp);
 
     // run all tests
     bool passed = uTests.runAllTests();
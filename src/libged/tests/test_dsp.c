@@ -0,0 +1,367 @@
+/*                      T E S T _ D S P . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file test_dsp.c
+ *
+ * Checks the 'dsp <obj> tile <file>' command and the tiled DSP data
+ * layout.  A height field that is not a whole number of tiles wide
+ * is written in tiled form, the file is checked against the layout
+ * described in librt's dsp.h, and a second dsp using the tiled file
+ * must report the same samples and raytrace the same as the first.
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+#include <math.h>
+
+#include "bu.h"
+#include "raytrace.h"
+#include "wdb.h"
+#include "ged.h"
+
+#include "../../librt/primitives/dsp/dsp.h"
+
+#define DSP_G "ged_test_dsp.g"
+#define DSP_RAW "ged_test_dsp.dsp"
+#define DSP_TILED_FILE "ged_test_dsp.dspt"
+
+#define DSP_W 150
+#define DSP_H 100
+
+#define DSP_MAX_HITS 16
+
+
+static unsigned short
+dsp_elev(size_t x, size_t y)
+{
+    /* a flat plateau, so some tiles are uniform, on rolling ground */
+    if (x >= 70 && x < 140 && y >= 10 && y < 60)
+	return 300;
+    return (unsigned short)(120.0 + 60.0 * sin((double)x / 9.0) * cos((double)y / 13.0) + (double)((x * 7 + y * 3) % 5));
+}
+
+
+static size_t
+dsp_get16(const unsigned char *cp)
+{
+    return ((size_t)cp[0] << 8) | cp[1];
+}
+
+
+static size_t
+dsp_get32(const unsigned char *cp)
+{
+    return ((size_t)cp[0] << 24) | ((size_t)cp[1] << 16) | ((size_t)cp[2] << 8) | cp[3];
+}
+
+
+/* Check the tiled file against the layout in dsp.h */
+static int
+dsp_check_layout(void)
+{
+    struct bu_mapped_file *mf;
+    const unsigned char *buf, *tiles;
+    size_t tw = (size_t)1 << DSP_TILE_SHIFT;
+    size_t ntx = (DSP_W - 1) / tw + 1;
+    size_t nty = (DSP_H - 1) / tw + 1;
+    size_t tx, ty, x, y;
+    int bad = 0;
+
+    mf = bu_open_mapped_file(DSP_TILED_FILE, NULL);
+    if (!mf) {
+	bu_log("dsp tile did not write %s\n", DSP_TILED_FILE);
+	return 1;
+    }
+    buf = (const unsigned char *)mf->buf;
+
+    if (mf->buflen != DSP_TILED_DATA_OFF(ntx * nty) + ntx * nty * tw * tw * 2) {
+	bu_log("%s is %zu bytes, expected %zu\n", DSP_TILED_FILE, mf->buflen,
+	       DSP_TILED_DATA_OFF(ntx * nty) + ntx * nty * tw * tw * 2);
+	bu_close_mapped_file(mf);
+	return 1;
+    }
+    if (dsp_get32(buf) != DSP_TILED_MAGIC || dsp_get32(buf + 4) != DSP_TILED_VERSION
+	|| dsp_get32(buf + 8) != DSP_W || dsp_get32(buf + 12) != DSP_H
+	|| dsp_get32(buf + 16) != DSP_TILE_SHIFT || dsp_get32(buf + 20) != 0)
+    {
+	bu_log("%s has a bad header\n", DSP_TILED_FILE);
+	bu_close_mapped_file(mf);
+	return 1;
+    }
+
+    tiles = buf + DSP_TILED_DATA_OFF(ntx * nty);
+    for (ty = 0; ty < nty; ty++) {
+	for (tx = 0; tx < ntx; tx++) {
+	    const unsigned char *range = buf + DSP_TILED_HDR_LEN + (ty * ntx + tx) * 4;
+	    const unsigned char *tile = tiles + (ty * ntx + tx) * tw * tw * 2;
+	    size_t lo = 0xffff, hi = 0;
+
+	    /* the range includes the next row and column of samples */
+	    for (y = ty * tw; y <= (ty + 1) * tw && y < DSP_H; y++) {
+		for (x = tx * tw; x <= (tx + 1) * tw && x < DSP_W; x++) {
+		    V_MIN(lo, dsp_elev(x, y));
+		    V_MAX(hi, dsp_elev(x, y));
+		}
+	    }
+	    if (dsp_get16(range) != lo || dsp_get16(range + 2) != hi) {
+		bu_log("tile %zu,%zu range is %zu..%zu, expected %zu..%zu\n",
+		       tx, ty, dsp_get16(range), dsp_get16(range + 2), lo, hi);
+		bad++;
+	    }
+
+	    /* samples past the edges repeat the edge samples */
+	    for (y = 0; y < tw; y++) {
+		for (x = 0; x < tw; x++) {
+		    size_t sx = FMIN(tx * tw + x, DSP_W - 1);
+		    size_t sy = FMIN(ty * tw + y, DSP_H - 1);
+		    size_t got = dsp_get16(tile + (y * tw + x) * 2);
+
+		    if (got != dsp_elev(sx, sy)) {
+			bu_log("tile %zu,%zu sample %zu,%zu is %zu, expected %u\n",
+			       tx, ty, x, y, got, dsp_elev(sx, sy));
+			bad++;
+		    }
+		}
+	    }
+	}
+    }
+
+    bu_close_mapped_file(mf);
+    return (bad) ? 1 : 0;
+}
+
+
+/* The tiled dsp must report the same samples as the source */
+static int
+dsp_check_xy(struct ged *gedp)
+{
+    const char *av[5];
+    char xs[32], ys[32];
+    size_t x, y;
+    int bad = 0;
+
+    av[0] = "dsp";
+    av[1] = "tiled.s";
+    av[2] = "xy";
+    av[3] = xs;
+    av[4] = ys;
+    for (y = 0; y < DSP_H; y++) {
+	for (x = 0; x < DSP_W; x++) {
+	    /* a sparse grid, plus the last row and column */
+	    if ((x % 5 && x != DSP_W - 1) || (y % 7 && y != DSP_H - 1))
+		continue;
+	    snprintf(xs, sizeof(xs), "%zu", x);
+	    snprintf(ys, sizeof(ys), "%zu", y);
+	    if (ged_exec(gedp, 5, av) != BRLCAD_OK
+		|| (size_t)atoi(bu_vls_cstr(gedp->ged_result_str)) != dsp_elev(x, y))
+	    {
+		bu_log("dsp tiled.s xy %zu %zu: %s, expected %u\n", x, y,
+		       bu_vls_cstr(gedp->ged_result_str), dsp_elev(x, y));
+		bad++;
+	    }
+	}
+    }
+
+    return (bad) ? 1 : 0;
+}
+
+
+struct dsp_hits {
+    size_t n;
+    fastf_t d[DSP_MAX_HITS][2];
+};
+
+
+static int
+dsp_hit(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs))
+{
+    struct dsp_hits *h = (struct dsp_hits *)ap->a_uptr;
+    struct partition *pp;
+
+    for (pp = PartHeadp->pt_forw; pp != PartHeadp && h->n < DSP_MAX_HITS; pp = pp->pt_forw) {
+	h->d[h->n][0] = pp->pt_inhit->hit_dist;
+	h->d[h->n][1] = pp->pt_outhit->hit_dist;
+	h->n++;
+    }
+    return 1;
+}
+
+
+static int
+dsp_miss(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+
+static struct rt_i *
+dsp_rtip(const char *obj)
+{
+    struct rt_i *rtip = rt_dirbuild(DSP_G, NULL, 0);
+
+    if (rtip == RTI_NULL || rt_gettree(rtip, obj) < 0)
+	bu_exit(1, "unable to load %s from %s\n", obj, DSP_G);
+    rt_prep(rtip);
+    return rtip;
+}
+
+
+/* Rays at the plain and the tiled dsp must hit in the same places */
+static int
+dsp_check_shots(void)
+{
+    struct application ap1, ap2;
+    struct dsp_hits h1, h2;
+    size_t x, y, i, hits = 0;
+    int bad = 0;
+    int pass;
+
+    RT_APPLICATION_INIT(&ap1);
+    ap1.a_rt_i = dsp_rtip("plain.s");
+    ap1.a_hit = dsp_hit;
+    ap1.a_miss = dsp_miss;
+    ap1.a_uptr = (void *)&h1;
+
+    RT_APPLICATION_INIT(&ap2);
+    ap2.a_rt_i = dsp_rtip("tiled.s");
+    ap2.a_hit = dsp_hit;
+    ap2.a_miss = dsp_miss;
+    ap2.a_uptr = (void *)&h2;
+
+    /* straight down, then at a slant crossing several tiles */
+    for (pass = 0; pass < 2; pass++) {
+	for (y = 0; y < DSP_H; y += 3) {
+	    for (x = 0; x < DSP_W; x += 3) {
+		point_t target;
+
+		/* aim at a point on the ground, from well above it */
+		VSET(target, x + 0.37, y + 0.61, 150.0);
+		if (pass)
+		    VSET(ap1.a_ray.r_dir, 0.31, 0.17, -1.0);
+		else
+		    VSET(ap1.a_ray.r_dir, 0.0, 0.0, -1.0);
+		VJOIN1(ap1.a_ray.r_pt, target, -1000.0, ap1.a_ray.r_dir);
+		VUNITIZE(ap1.a_ray.r_dir);
+		ap2.a_ray = ap1.a_ray;
+
+		h1.n = h2.n = 0;
+		(void)rt_shootray(&ap1);
+		(void)rt_shootray(&ap2);
+		hits += h1.n;
+
+		if (h1.n != h2.n) {
+		    bu_log("ray at %zu,%zu: %zu partitions on plain.s, %zu on tiled.s\n", x, y, h1.n, h2.n);
+		    bad++;
+		    continue;
+		}
+		for (i = 0; i < h1.n; i++) {
+		    if (!NEAR_EQUAL(h1.d[i][0], h2.d[i][0], 1.0e-6) || !NEAR_EQUAL(h1.d[i][1], h2.d[i][1], 1.0e-6)) {
+			bu_log("ray at %zu,%zu: plain.s %g to %g, tiled.s %g to %g\n", x, y,
+			       h1.d[i][0], h1.d[i][1], h2.d[i][0], h2.d[i][1]);
+			bad++;
+			break;
+		    }
+		}
+	    }
+	}
+    }
+
+    rt_free_rti(ap1.a_rt_i);
+    rt_free_rti(ap2.a_rt_i);
+
+    if (!hits) {
+	bu_log("no rays hit the dsp\n");
+	bad++;
+    }
+    return (bad) ? 1 : 0;
+}
+
+
+int
+main(int UNUSED(ac), char *av[])
+{
+    struct rt_wdb *wdbp;
+    struct ged *gedp;
+    unsigned char *data;
+    const char *tile[4] = {"dsp", "plain.s", "tile", DSP_TILED_FILE};
+    size_t x, y;
+    mat_t mat;
+    FILE *fp;
+    int ret = 0;
+
+    bu_setprogname(av[0]);
+
+    /* plain layout: row-major network order samples */
+    data = (unsigned char *)bu_malloc(DSP_W * DSP_H * 2, "dsp data");
+    for (y = 0; y < DSP_H; y++) {
+	for (x = 0; x < DSP_W; x++) {
+	    data[(y * DSP_W + x) * 2] = (unsigned char)(dsp_elev(x, y) >> 8);
+	    data[(y * DSP_W + x) * 2 + 1] = (unsigned char)dsp_elev(x, y);
+	}
+    }
+    fp = fopen(DSP_RAW, "wb");
+    if (!fp || fwrite(data, DSP_W * DSP_H * 2, 1, fp) != 1)
+	bu_exit(1, "unable to write %s\n", DSP_RAW);
+    fclose(fp);
+    bu_free(data, "dsp data");
+
+    if (bu_file_exists(DSP_G, NULL))
+	bu_file_delete(DSP_G);
+    bu_file_delete(DSP_TILED_FILE);
+    wdbp = wdb_fopen(DSP_G);
+    if (!wdbp)
+	bu_exit(1, "unable to create %s\n", DSP_G);
+    MAT_IDN(mat);
+    mk_dsp(wdbp, "plain.s", DSP_RAW, DSP_W, DSP_H, mat);
+    mk_dsp(wdbp, "tiled.s", DSP_TILED_FILE, DSP_W, DSP_H, mat);
+    wdb_close(wdbp);
+
+    gedp = ged_open("db", DSP_G, 1);
+    if (!gedp)
+	bu_exit(1, "unable to open %s\n", DSP_G);
+
+    if (ged_exec(gedp, 4, tile) != BRLCAD_OK) {
+	bu_log("dsp plain.s tile failed: %s\n", bu_vls_cstr(gedp->ged_result_str));
+	ret = 1;
+    } else {
+	ret |= dsp_check_layout();
+	ret |= dsp_check_xy(gedp);
+    }
+    ged_close(gedp);
+
+    if (!ret)
+	ret |= dsp_check_shots();
+
+    bu_file_delete(DSP_G);
+    bu_file_delete(DSP_RAW);
+    bu_file_delete(DSP_TILED_FILE);
+
+    return ret;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
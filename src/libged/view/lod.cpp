@@ -54,10 +54,12 @@ _view_cmd_lod(void *bs, int argc, const char **argv)
     int print_help = 0;
     static const char *usage = "view lod [csg|mesh] [0|1]\n"
 	"view lod cache [clear [all_files] | exists] \n"
+	"view lod cache async [threads] | status | cancel\n"
 	"view lod scale [factor]\n"
 	"view lod point_scale [factor]\n"
 	"view lod curve_scale [factor]\n"
-	"view lod bot_threshold [face_cnt]\n";
+	"view lod bot_threshold [face_cnt]\n"
+	"view lod pixel_threshold [px]\n";
 
     GED_CHECK_ARGC_GT_0(gedp, argc, BRLCAD_ERROR);
 
@@ -97,6 +99,7 @@ _view_cmd_lod(void *bs, int argc, const char **argv)
 	bu_vls_printf(gedp->ged_result_str, "point_scale: %g\n", gvp->gv_s->point_scale);
 	bu_vls_printf(gedp->ged_result_str, "curve_scale: %g\n", gvp->gv_s->curve_scale);
 	bu_vls_printf(gedp->ged_result_str, "bot_threshold: %zd\n", gvp->gv_s->bot_threshold);
+	bu_vls_printf(gedp->ged_result_str, "pixel_threshold: %g\n", gvp->gv_s->lod_pixel_threshold);
 	return BRLCAD_OK;
     }
 
@@ -184,6 +187,9 @@ _view_cmd_lod(void *bs, int argc, const char **argv)
 
 	    struct rt_wdb *wdbp = wdb_dbopen(gedp->dbip, RT_WDB_TYPE_DB_DEFAULT);
 
+	    // A background job would be competing with us - stop it
+	    ged_lod_cache_bg_cancel(gedp);
+
 	    // Clear any old cache in memory
 	    bv_mesh_lod_clear_cache(gedp->ged_lod, 0);
 
@@ -192,11 +198,7 @@ _view_cmd_lod(void *bs, int argc, const char **argv)
 	    for (int i = 0; i < RT_DBNHASH; i++) {
 		struct directory *dp;
 		for (dp = gedp->dbip->dbi_Head[i]; dp != RT_DIR_NULL; dp = dp->d_forw) {
-		    if (dp->d_addr == RT_DIR_PHONY_ADDR)
-			continue;
-		    if (dp->d_minor_type == DB5_MINORTYPE_BRLCAD_BOT)
-			total++;
-		    if (dp->d_minor_type == DB5_MINORTYPE_BRLCAD_BREP)
+		    if (ged_lod_cacheable(dp))
 			total++;
 		}
 	    }
@@ -204,94 +206,11 @@ _view_cmd_lod(void *bs, int argc, const char **argv)
 	    for (int i = 0; i < RT_DBNHASH; i++) {
 		struct directory *dp;
 		for (dp = gedp->dbip->dbi_Head[i]; dp != RT_DIR_NULL; dp = dp->d_forw) {
-		    if (dp->d_addr == RT_DIR_PHONY_ADDR)
+		    if (!ged_lod_cacheable(dp))
 			continue;
-
-		    unsigned long long key = 0;
-
-		    // No need to open up the internal unless it's a BoT or a BRep
-		    if (dp->d_minor_type == DB5_MINORTYPE_BRLCAD_BOT) {
-			struct rt_db_internal dbintern;
-			RT_DB_INTERNAL_INIT(&dbintern);
-			struct rt_db_internal *ip = &dbintern;
-			int ret = rt_db_get_internal(ip, dp, gedp->dbip, NULL, &rt_uniresource);
-			if (ret < 0)
-			    continue;
-
-			if (ip->idb_minor_type != DB5_MINORTYPE_BRLCAD_BOT) {
-			    rt_db_free_internal(&dbintern);
-			    continue;
-			}
-			done++;
-			struct bu_vls pname = BU_VLS_INIT_ZERO;
-			bu_log("Caching BoT %s (%d of %d)\n", dp->d_namep, done, total);
-			bu_vls_free(&pname);
-			struct rt_bot_internal *bot = (struct rt_bot_internal *)ip->idb_ptr;
-			RT_BOT_CK_MAGIC(bot);
-			key = bv_mesh_lod_cache(gedp->ged_lod, (const point_t *)bot->vertices, bot->num_vertices, NULL, bot->faces, bot->num_faces, 0, 0.66);
-			if (key)
-			    bv_mesh_lod_key_put(gedp->ged_lod, dp->d_namep, key);
-			rt_db_free_internal(&dbintern);
-		    }
-
-		    if (dp->d_minor_type == DB5_MINORTYPE_BRLCAD_BREP) {
-			struct bu_external ext = BU_EXTERNAL_INIT_ZERO;
-			if (db_get_external(&ext, dp, gedp->dbip))
-			    continue;
-			key = bu_data_hash((void *)ext.ext_buf,  ext.ext_nbytes);
-			bu_free_external(&ext);
-			if (!key)
-			    continue;
-
-			struct rt_db_internal dbintern;
-			RT_DB_INTERNAL_INIT(&dbintern);
-			struct rt_db_internal *ip = &dbintern;
-			int ret = rt_db_get_internal(ip, dp, gedp->dbip, NULL, &rt_uniresource);
-			if (ret < 0)
-			    continue;
-
-			if (ip->idb_minor_type != DB5_MINORTYPE_BRLCAD_BREP) {
-			    rt_db_free_internal(&dbintern);
-			    continue;
-			}
-			done++;
-			struct bu_vls pname = BU_VLS_INIT_ZERO;
-			bu_log("Caching BRep %s (%d of %d)\n", dp->d_namep, done, total);
-			bu_vls_free(&pname);
-			struct rt_brep_internal *bi = (struct rt_brep_internal *)ip->idb_ptr;
-			RT_BREP_CK_MAGIC(bi);
-
-			// Unlike a BoT, which has the mesh data already, we need to generate the
-			// mesh from the brep
-			int *faces = NULL;
-			int face_cnt = 0;
-			vect_t *normals = NULL;
-			point_t *pnts = NULL;
-			int pnt_cnt = 0;
-			struct bn_tol *tol = &wdbp->wdb_tol;
-			struct bg_tess_tol *ttol = &wdbp->wdb_ttol;
-
-			int bret = brep_cdt_fast(&faces, &face_cnt, &normals, &pnts, &pnt_cnt, bi->brep, -1, ttol, tol);
-			if (bret != BRLCAD_OK) {
-			    bu_free(faces, "faces");
-			    bu_free(normals, "normals");
-			    bu_free(pnts, "pnts");
-			    rt_db_free_internal(&dbintern);
-			    continue;
-			}
-
-			// Because we won't have the internal data to use for a full detail scenario, we set the ratio
-			// to 1 rather than .66 for breps...
-			key = bv_mesh_lod_cache(gedp->ged_lod, (const point_t *)pnts, pnt_cnt, normals, faces, face_cnt, key, 1);
-
-			if (key)
-			    bv_mesh_lod_key_put(gedp->ged_lod, dp->d_namep, key);
-
-			rt_db_free_internal(&dbintern);
-			bu_free(faces, "faces");
-			bu_free(normals, "normals");
-			bu_free(pnts, "pnts");
-		    }
+		    done++;
+		    bu_log("Caching %s (%d of %d)\n", dp->d_namep, done, total);
+		    (void)ged_lod_cache_obj(gedp->ged_lod, gedp->dbip, dp, &wdbp->wdb_ttol, &wdbp->wdb_tol, &rt_uniresource);
 		}
 	    }
 
@@ -307,10 +226,45 @@ _view_cmd_lod(void *bs, int argc, const char **argv)
 	    }
 	    return BRLCAD_OK;
 	}
+	if (argc >= 2 && BU_STR_EQUAL(argv[1], "async")) {
+	    int nthreads = 0;
+	    if (argc == 3 && (bu_opt_int(NULL, 1, (const char **)&argv[2], (void *)&nthreads) != 1 || nthreads < 0)) {
+		bu_vls_printf(gedp->ged_result_str, "unknown thread count: %s\n", argv[2]);
+		return BRLCAD_ERROR;
+	    }
+	    if (ged_lod_cache_bg_start(gedp, gvp, nthreads) != BRLCAD_OK) {
+		bu_vls_printf(gedp->ged_result_str, "unable to start background LoD caching\n");
+		return BRLCAD_ERROR;
+	    }
+	    size_t total = 0;
+	    ged_lod_cache_bg_status(gedp, NULL, &total, NULL, NULL);
+	    bu_vls_printf(gedp->ged_result_str, "Caching %zd objects in the background\n", total);
+	    return BRLCAD_OK;
+	}
 	if (argc == 2) {
 	    if (BU_STR_EQUAL(argv[1], "clear")) {
+		ged_lod_cache_bg_cancel(gedp);
 		bv_mesh_lod_clear_cache(gedp->ged_lod, 0);
 		return BRLCAD_OK;
+	    } else if (BU_STR_EQUAL(argv[1], "status")) {
+		size_t done, total, failed;
+		int64_t elapsedtime;
+		int running = ged_lod_cache_bg_status(gedp, &done, &total, &failed, &elapsedtime);
+		if (running < 0) {
+		    bu_vls_printf(gedp->ged_result_str, "no background caching job\n");
+		    return BRLCAD_OK;
+		}
+		int seconds = elapsedtime / 1000000;
+		int minutes = seconds / 60;
+		int hours = minutes / 60;
+		minutes = minutes % 60;
+		seconds = seconds %60;
+		double pct = (total) ? 100.0 * (double)done / (double)total : 100.0;
+		bu_vls_printf(gedp->ged_result_str, "%s: %zd of %zd (%.1f%%), %zd failed (Elapsed time: %02d:%02d:%02d)\n", (running) ? "running" : "complete", done, total, pct, failed, hours, minutes, seconds);
+		return BRLCAD_OK;
+	    } else if (BU_STR_EQUAL(argv[1], "cancel")) {
+		ged_lod_cache_bg_cancel(gedp);
+		return BRLCAD_OK;
 	    } else if (BU_STR_EQUAL(argv[1], "exists")) {
 		for (int i = 0; i < RT_DBNHASH; i++) {
 		    struct directory *dp;
@@ -332,6 +286,7 @@ _view_cmd_lod(void *bs, int argc, const char **argv)
 	}
 	if (argc == 3) {
 	    if (BU_STR_EQUAL(argv[1], "clear") && BU_STR_EQUAL(argv[2], "all_files")) {
+		ged_lod_cache_bg_cancel(gedp);
 		bv_mesh_lod_clear_cache(NULL, 0);
 		return BRLCAD_OK;
 	    }
@@ -397,6 +352,20 @@ _view_cmd_lod(void *bs, int argc, const char **argv)
 
     }
 
+    if (BU_STR_EQUAL(argv[0], "pixel_threshold")) {
+	if (argc == 1) {
+	    bu_vls_printf(gedp->ged_result_str, "%g\n", gvp->gv_s->lod_pixel_threshold);
+	    return BRLCAD_OK;
+	}
+	fastf_t px = 0.0;
+	if (bu_opt_fastf_t(NULL, 1, (const char **)&argv[1], (void *)&px) != 1 || px < 0) {
+	    bu_vls_printf(gedp->ged_result_str, "unknown argument to pixel_threshold: %s\n", argv[1]);
+	    return BRLCAD_ERROR;
+	}
+	gvp->gv_s->lod_pixel_threshold = px;
+	return BRLCAD_OK;
+    }
+
     bu_vls_printf(gedp->ged_result_str, "unknown subcommand: %s\n", argv[0]);
     return BRLCAD_ERROR;
 }
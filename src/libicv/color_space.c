@@ -31,7 +31,7 @@
 #include "bio.h"
 #include "bu/malloc.h"
 #include "bu/log.h"
-#include "icv.h"
+#include "icv_private.h"
 
 int
 icv_gray2rgb(icv_image_t *img)
@@ -47,6 +47,8 @@ icv_gray2rgb(icv_image_t *img)
     if (img->color_space == ICV_COLOR_SPACE_RGB)
 	return 0;
 
+    ICV_IMAGE_DOUBLE_INT(img);
+
     if (img->color_space != ICV_COLOR_SPACE_GRAY) {
 	bu_log("ERROR : color_space error");
 	return -1;
@@ -88,6 +90,8 @@ icv_rgb2gray(icv_image_t *img, ICV_COLOR color, double rweight, double gweight,
     if (img->color_space == ICV_COLOR_SPACE_GRAY)
 	return 0;
 
+    ICV_IMAGE_DOUBLE_INT(img);
+
     if (img->color_space != ICV_COLOR_SPACE_RGB) {
 	bu_log("ERROR : color_space error");
 	return -1;
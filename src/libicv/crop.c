@@ -31,7 +31,7 @@
 #include "bu/malloc.h"
 #include "bu/exit.h"
 #include "vmath.h"
-#include "icv.h"
+#include "icv_private.h"
 
 
 int
@@ -43,6 +43,7 @@ icv_rect(icv_image_t *img, size_t xorig, size_t yorig, size_t xnum, size_t ynum)
     int errorflag;
 
     ICV_IMAGE_VAL_INT(img);
+    ICV_IMAGE_DOUBLE_INT(img);
 
     errorflag=0;
     if (xnum < 1) {
@@ -98,6 +99,7 @@ icv_crop(icv_image_t *img, size_t ulx, size_t uly, size_t urx, size_t ury, size_
     double *data, *p, *q;
 
     ICV_IMAGE_VAL_INT(img);
+    ICV_IMAGE_DOUBLE_INT(img);
 
     /* Allocates output data and assigns to image*/
     data = img->data;
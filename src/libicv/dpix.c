@@ -136,6 +136,9 @@ dpix_write(icv_image_t *bif, FILE *fp)
 	return BRLCAD_ERROR;
     }
 
+    if (ICV_IS_TYPED(bif) && icv_convert(bif, ICV_DATA_DOUBLE) < 0)
+	return BRLCAD_ERROR;
+
     size_t size = bif->width*bif->height*3*sizeof(bif->data[0]);
 
     // TODO - why does dpix use write instead of fwrite?
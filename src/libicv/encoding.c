@@ -23,7 +23,7 @@
  *
  */
 
-#include "icv.h"
+#include "icv_private.h"
 #include "vmath.h"
 #include "bu/magic.h"
 #include "bu/malloc.h"
@@ -56,7 +56,6 @@ icv_data2uchar(const icv_image_t *bif)
 {
     size_t size;
     unsigned char *uchar_data, *char_p;
-    double *double_p;
 
     if (!bif) {
 	return NULL;
@@ -71,32 +70,29 @@ icv_data2uchar(const icv_image_t *bif)
 	return NULL;
     }
 
-    double_p = bif->data;
-
     if (ZERO(bif->gamma_corr)) {
-	while (size--) {
-	    long longval = lrint((*double_p)*255.0);
-
-	    if (longval > 255)
-		*char_p = 255;
-	    else if (longval < 0)
-		*char_p = 0;
-	    else
-		*char_p = (unsigned char)longval;
-
-	    char_p++;
-	    double_p++;
-	}
-
+	icv_uchar_block(uchar_data, bif, 0, size);
     } else {
+	float buf[ICV_BLOCK];
 	float *rand_p;
 	double ex = 1.0/bif->gamma_corr;
+	size_t i = 0, n = 0;
 	bn_rand_init(rand_p, 0);
 
 	while (size--) {
-	    *char_p = floor(pow(*double_p, ex)*255.0 + (double) bn_rand0to1(rand_p) + 0.5);
+	    double val;
+	    if (bif->data_type == ICV_DATA_DOUBLE) {
+		val = bif->data[i];
+	    } else {
+		if (i % ICV_BLOCK == 0) {
+		    n = (size + 1 < ICV_BLOCK) ? size + 1 : ICV_BLOCK;
+		    icv_load_block(buf, bif, i, n);
+		}
+		val = buf[i % ICV_BLOCK];
+	    }
+	    *char_p = floor(pow(val, ex)*255.0 + (double) bn_rand0to1(rand_p) + 0.5);
 	    char_p++;
-	    double_p++;
+	    i++;
 	}
     }
 
@@ -20,6 +20,7 @@
 
 #include "common.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>	/* for file mode info in WRMODE */
@@ -44,7 +45,7 @@
  * FMT:filename as being preferred, but will attempt to guess based on
  * extension as well.
  */
-static bu_mime_image_t
+bu_mime_image_t
 icv_guess_file_format(const char *filename, struct bu_vls *trimmedname)
 {
     // If we have no filename, there's nothing to go on
@@ -78,6 +79,34 @@ icv_guess_file_format(const char *filename, struct bu_vls *trimmedname)
     return BU_MIME_IMAGE_PIX;
 }
 
+/*
+ * Store n double values at offset off of a typed image.  8-bit values
+ * are rounded exactly as icv_data2uchar() would round the doubles, so
+ * an image gets the same bytes whichever way it is stored.
+ */
+static void
+icv_store_doubles(icv_image_t *bif, size_t off, const double *in, size_t n)
+{
+    float buf[ICV_BLOCK];
+    size_t i, j, cnt;
+
+    if (bif->data_type == ICV_DATA_UCHAR) {
+	unsigned char *out = (unsigned char *)bif->pixels + off;
+	for (i = 0; i < n; i++) {
+	    long longval = lrint(in[i]*255.0);
+	    out[i] = (longval > 255) ? 255 : (longval < 0) ? 0 : (unsigned char)longval;
+	}
+	return;
+    }
+
+    for (i = 0; i < n; i += cnt) {
+	cnt = (n - i < ICV_BLOCK) ? n - i : ICV_BLOCK;
+	for (j = 0; j < cnt; j++)
+	    buf[j] = (float)in[i + j];
+	icv_store_block(bif, off + i, buf, cnt);
+    }
+}
+
 /* begin public functions */
 
 icv_image_t *
@@ -181,34 +210,96 @@ icv_write(icv_image_t *bif, const char *filename, bu_mime_image_t format)
 }
 
 
+/*
+ * Convert n values of a line in the given data type to floats in the
+ * 0..1 range, as icv_load_block() would read them from an image
+ * stored in that type.
+ */
+static void
+icv_line2float(float *out, const void *data, ICV_DATA type, size_t n)
+{
+    size_t i;
+
+    switch (type) {
+	case ICV_DATA_DOUBLE:
+	    for (i = 0; i < n; i++)
+		out[i] = (float)((const double *)data)[i];
+	    break;
+	case ICV_DATA_UCHAR:
+	    for (i = 0; i < n; i++)
+		out[i] = ((const unsigned char *)data)[i] / 255.0f;
+	    break;
+	case ICV_DATA_USHORT:
+	    for (i = 0; i < n; i++)
+		out[i] = ((const uint16_t *)data)[i] / 65535.0f;
+	    break;
+	case ICV_DATA_FLOAT:
+	    memcpy(out, data, n*sizeof(float));
+	    break;
+    }
+}
+
+
 int
 icv_writeline(icv_image_t *bif, size_t y, void *data, ICV_DATA type)
 {
     double *dst;
     size_t width_size;
-    unsigned char *p=NULL;
+    size_t i;
 
     if (bif == NULL || data == NULL)
 	return -1;
 
     ICV_IMAGE_VAL_INT(bif);
 
-    if (y > bif->height)
+    if (y >= bif->height)
         return -1;
 
+    if (!icv_data_size(type))
+	return -1;
+
     width_size = (size_t) bif->width*bif->channels;
-    dst = bif->data + width_size*y;
 
-    if (type == ICV_DATA_UCHAR) {
-	p = (unsigned char *)data;
-	for (; width_size > 0; width_size--) {
-		*dst = ICV_CONV_8BIT(*p);
-		p++;
-		dst++;
+    if (ICV_IS_TYPED(bif)) {
+	float buf[ICV_BLOCK];
+	size_t off = width_size*y;
+	size_t cnt;
+
+	if (type == bif->data_type) {
+	    memcpy((char *)bif->pixels + off*icv_data_size(type), data, width_size*icv_data_size(type));
+	    return 0;
+	}
+	if (type == ICV_DATA_DOUBLE) {
+	    icv_store_doubles(bif, off, (const double *)data, width_size);
+	    return 0;
 	}
-    } else
-	memcpy(dst, data, width_size*sizeof(double));
+	for (i = 0; i < width_size; i += cnt) {
+	    cnt = (width_size - i < ICV_BLOCK) ? width_size - i : ICV_BLOCK;
+	    icv_line2float(buf, (const char *)data + i*icv_data_size(type), type, cnt);
+	    icv_store_block(bif, off + i, buf, cnt);
+	}
+	return 0;
+    }
 
+    dst = bif->data + width_size*y;
+
+    switch (type) {
+	case ICV_DATA_DOUBLE:
+	    memcpy(dst, data, width_size*sizeof(double));
+	    break;
+	case ICV_DATA_UCHAR:
+	    for (i = 0; i < width_size; i++)
+		dst[i] = ICV_CONV_8BIT(((unsigned char *)data)[i]);
+	    break;
+	case ICV_DATA_USHORT:
+	    for (i = 0; i < width_size; i++)
+		dst[i] = ((uint16_t *)data)[i] / 65535.0;
+	    break;
+	case ICV_DATA_FLOAT:
+	    for (i = 0; i < width_size; i++)
+		dst[i] = ((float *)data)[i];
+	    break;
+    }
 
     return 0;
 }
@@ -230,6 +321,11 @@ icv_writepixel(icv_image_t *bif, size_t x, size_t y, double *data)
     if (data == NULL)
         return -1;
 
+    if (ICV_IS_TYPED(bif)) {
+	icv_store_doubles(bif, (y*bif->width + x)*bif->channels, data, bif->channels);
+	return 0;
+    }
+
     dst = bif->data + (y*bif->width + x)*bif->channels;
 
     /* can copy float to double also double to double */
@@ -274,8 +370,13 @@ icv_zero(icv_image_t *bif)
 
     ICV_IMAGE_VAL_PTR(bif);
 
-    data = bif->data;
     size = bif->width * bif->height * bif->channels;
+    if (ICV_IS_TYPED(bif)) {
+	memset(bif->pixels, 0, size * icv_data_size(bif->data_type));
+	return bif;
+    }
+
+    data = bif->data;
     for (i = 0; i < size; i++)
 	*data++ = 0;
 
@@ -288,7 +389,10 @@ icv_destroy(icv_image_t *bif)
 {
     ICV_IMAGE_VAL_INT(bif);
 
-    bu_free(bif->data, "Image Data");
+    if (ICV_IS_TYPED(bif))
+	bu_free(bif->pixels, "Image Data");
+    else
+	bu_free(bif->data, "Image Data");
     bu_free(bif, "ICV IMAGE Structure");
     return 0;
 }
@@ -24,9 +24,13 @@
  * images are taken care.
  */
 
+#include "common.h"
+
+#include <string.h>
+
 #include "bu/log.h"
 #include "bu/malloc.h"
-#include "icv.h"
+#include "icv_private.h"
 
 #include "vmath.h"
 
@@ -160,6 +164,61 @@ get_kernel3(ICV_FILTER3 filter_type, double *kern, double *offset)
     return;
 }
 
+/**
+ * 3x3 convolution of an image with typed storage, with zero padding
+ * at the edges.  Rows are loaded as floats into buffers padded by a
+ * pixel on each side, so every tap is a plain multiply-add over a
+ * whole row and vectorizes.  Only three input rows are held, and the
+ * result is written back in place.
+ */
+static void
+filter_typed(icv_image_t *img, const double *kern, double offset)
+{
+    size_t ch = img->channels;
+    size_t widthstep = img->width*ch;
+    size_t padded = widthstep + 2*ch;
+    float *rows, *row[3], *out, *tmp;
+    float w;
+    size_t y, k, i, j;
+
+    rows = (float *)bu_calloc(3*padded + widthstep, sizeof(float), "icv_filter : rows");
+    row[0] = rows;
+    row[1] = rows + padded;
+    row[2] = rows + 2*padded;
+    out = rows + 3*padded;
+
+    /* row[0] is the row below (zero at the bottom edge), row[1] the
+     * row being filtered and row[2] the row above */
+    if (img->height > 0)
+	icv_load_block(row[1] + ch, img, 0, widthstep);
+
+    for (y = 0; y < img->height; y++) {
+	if (y + 1 < img->height)
+	    icv_load_block(row[2] + ch, img, (y + 1)*widthstep, widthstep);
+	else
+	    memset(row[2] + ch, 0, widthstep*sizeof(float));
+
+	for (j = 0; j < widthstep; j++)
+	    out[j] = (float)offset;
+	for (k = 0; k < 3; k++) {
+	    for (i = 0; i < 3; i++) {
+		const float *in = row[k] + i*ch;
+		w = (float)kern[k*3 + i];
+		for (j = 0; j < widthstep; j++)
+		    out[j] += w*in[j];
+	    }
+	}
+	icv_store_block(img, y*widthstep, out, widthstep);
+
+	tmp = row[0];
+	row[0] = row[1];
+	row[1] = row[2];
+	row[2] = tmp;
+    }
+
+    bu_free(rows, "icv_filter : rows");
+}
+
 /* end of private functions */
 
 /* begin public functions */
@@ -193,6 +252,12 @@ icv_filter(icv_image_t *img, ICV_FILTER filter_type)
     if (!kern)
 	return -1;
 
+    if (ICV_IS_TYPED(img)) {
+	filter_typed(img, kern, offset);
+	bu_free(kern, "icv_filter : Kernel");
+	return 0;
+    }
+
     widthstep = img->width*img->channels;
 
     in_data = img->data;
@@ -262,6 +327,9 @@ icv_filter3(icv_image_t *old_img, icv_image_t *curr_img, icv_image_t *new_img, I
     ICV_IMAGE_VAL_PTR(old_img);
     ICV_IMAGE_VAL_PTR(curr_img);
     ICV_IMAGE_VAL_PTR(new_img);
+    ICV_IMAGE_DOUBLE_PTR(old_img);
+    ICV_IMAGE_DOUBLE_PTR(curr_img);
+    ICV_IMAGE_DOUBLE_PTR(new_img);
 
     if ((old_img->width == curr_img->width && curr_img->width == new_img->width) && \
 	(old_img->height == curr_img->height && curr_img->height == new_img->height) && \
@@ -339,6 +407,24 @@ icv_fade(icv_image_t *img, double fraction)
 	return -1;
     }
 
+    if (ICV_IS_TYPED(img)) {
+	float buf[ICV_BLOCK];
+	float f = (float)fraction;
+	size_t i, j, n;
+
+	for (i = 0; i < size; i += n) {
+	    n = (size - i < ICV_BLOCK) ? size - i : ICV_BLOCK;
+	    icv_load_block(buf, img, i, n);
+	    for (j = 0; j < n; j++) {
+		buf[j] *= f;
+		if (buf[j] > 1.0f)
+		    buf[j] = 1.0f;
+	    }
+	    icv_store_block(img, i, buf, n);
+	}
+	return 0;
+    }
+
      data = img->data;
 
     while (size--) {
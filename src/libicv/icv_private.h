@@ -20,12 +20,36 @@
 
 #include "common.h"
 #include "bu/mime.h"
+#include "bu/vls.h"
 #include "bio.h" /* for O_BINARY */
 #include "icv.h"
 
 #ifndef ICV_PRIVATE_H
 #define ICV_PRIVATE_H
 
+/* defined in fileformat.c */
+extern bu_mime_image_t icv_guess_file_format(const char *filename, struct bu_vls *trimmedname);
+
+/* defined in storage.c */
+
+/* typed pixels are worked on through float buffers this long, a
+ * whole number of RGB pixels */
+#define ICV_BLOCK 768
+
+#define ICV_IS_TYPED(_i) ((_i)->data_type != ICV_DATA_DOUBLE)
+
+/* the pixel buffer, whatever type it holds */
+#define ICV_PIXELS(_i) (ICV_IS_TYPED(_i) ? (_i)->pixels : (void *)(_i)->data)
+
+/* for code that only understands double storage */
+#define ICV_IMAGE_DOUBLE_INT(_i) if (ICV_IS_TYPED(_i) && icv_convert((_i), ICV_DATA_DOUBLE) < 0) return -1
+#define ICV_IMAGE_DOUBLE_PTR(_i) if (ICV_IS_TYPED(_i) && icv_convert((_i), ICV_DATA_DOUBLE) < 0) return NULL
+
+extern size_t icv_data_size(ICV_DATA type);
+extern void icv_load_block(float *out, const icv_image_t *img, size_t off, size_t n);
+extern void icv_store_block(icv_image_t *img, size_t off, const float *in, size_t n);
+extern void icv_uchar_block(unsigned char *out, const icv_image_t *img, size_t off, size_t n);
+
 /* defined in bw.c */
 extern icv_image_t *bw_read(FILE *fp, size_t width, size_t height);
 extern int bw_write(icv_image_t *bif, FILE *fp);
@@ -41,6 +65,11 @@ extern int dpix_write(icv_image_t *bif, FILE *fp);
 /* defined in png.c */
 extern icv_image_t* png_read(FILE *fp);
 extern int png_write(icv_image_t *bif, FILE *fp);
+extern void *png_stream_open(FILE *fp, size_t *width, size_t *height);
+extern void *png_stream_create(FILE *fp, size_t width, size_t height, size_t channels);
+extern int png_stream_readrow(void *ps, unsigned char *row);
+extern int png_stream_writerow(void *ps, const unsigned char *row);
+extern int png_stream_close(void *ps, int finish);
 
 /* defined in ppm.c */
 extern icv_image_t* ppm_read(FILE *fp);
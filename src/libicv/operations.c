@@ -27,7 +27,7 @@
 
 #include <math.h>
 
-#include "icv.h"
+#include "icv_private.h"
 
 #include "bio.h"
 #include "bu/log.h"
@@ -37,6 +37,93 @@
 #include "vmath.h"
 
 
+/* Operations on typed images.  Each kernel runs over a float block
+ * with the operation chosen outside the loop, so the compiler can
+ * vectorize it; icv_store_block() clamps integer results. */
+
+#define ICV_OP_ADD 0
+#define ICV_OP_SUB 1
+#define ICV_OP_MUL 2
+#define ICV_OP_DIV 3
+#define ICV_OP_POW 4
+
+static void
+typed_val_op(icv_image_t *img, int op, double val)
+{
+    float buf[ICV_BLOCK];
+    float v = (float)val;
+    size_t size = img->width*img->height*img->channels;
+    size_t i, j, n;
+
+    for (i = 0; i < size; i += n) {
+	n = (size - i < ICV_BLOCK) ? size - i : ICV_BLOCK;
+	icv_load_block(buf, img, i, n);
+	switch (op) {
+	    case ICV_OP_ADD:
+		for (j = 0; j < n; j++)
+		    buf[j] += v;
+		break;
+	    case ICV_OP_MUL:
+		for (j = 0; j < n; j++)
+		    buf[j] *= v;
+		break;
+	    case ICV_OP_DIV:
+		for (j = 0; j < n; j++)
+		    buf[j] /= v;
+		break;
+	    case ICV_OP_POW:
+		for (j = 0; j < n; j++)
+		    buf[j] = powf(buf[j], v);
+		break;
+	}
+	icv_store_block(img, i, buf, n);
+    }
+}
+
+
+static icv_image_t *
+typed_img_op(icv_image_t *img1, icv_image_t *img2, int op)
+{
+    float b1[ICV_BLOCK], b2[ICV_BLOCK];
+    size_t size = img1->width*img1->height*img1->channels;
+    size_t i, j, n;
+    icv_image_t *out_img;
+
+    out_img = icv_create_typed(img1->width, img1->height, img1->color_space, img1->data_type);
+    if (!out_img)
+	return NULL;
+
+    for (i = 0; i < size; i += n) {
+	n = (size - i < ICV_BLOCK) ? size - i : ICV_BLOCK;
+	icv_load_block(b1, img1, i, n);
+	icv_load_block(b2, img2, i, n);
+	switch (op) {
+	    case ICV_OP_ADD:
+		for (j = 0; j < n; j++)
+		    b1[j] += b2[j];
+		break;
+	    case ICV_OP_SUB:
+		for (j = 0; j < n; j++)
+		    b1[j] -= b2[j];
+		break;
+	    case ICV_OP_MUL:
+		for (j = 0; j < n; j++)
+		    b1[j] *= b2[j];
+		break;
+	    case ICV_OP_DIV:
+		for (j = 0; j < n; j++)
+		    b1[j] /= (b2[j] + (float)VDIVIDE_TOL);
+		break;
+	}
+	icv_store_block(out_img, i, b1, n);
+    }
+
+    icv_sanitize(out_img);
+
+    return out_img;
+}
+
+
 int icv_sanitize(icv_image_t* img)
 {
     double *data = NULL;
@@ -44,6 +131,22 @@ int icv_sanitize(icv_image_t* img)
 
     ICV_IMAGE_VAL_INT(img);
 
+    /* integer storage can not leave [0, 1] */
+    if (img->data_type == ICV_DATA_FLOAT) {
+	float *fdata = (float *)img->pixels;
+	for (size = img->width*img->height*img->channels; size>0; size--) {
+	    if (*fdata>1.0f)
+		*fdata = 1.0f;
+	    else if (*fdata<0)
+		*fdata = 0;
+	    fdata++;
+	}
+    }
+    if (ICV_IS_TYPED(img)) {
+	img->flags |= ICV_SANITIZED;
+	return 0;
+    }
+
     data= img->data;
     for (size = img->width*img->height*img->channels; size>0; size--) {
 	if (*data>1.0)
@@ -65,6 +168,15 @@ int icv_add_val(icv_image_t* img, double val)
 
     ICV_IMAGE_VAL_INT(img);
 
+    if (ICV_IS_TYPED(img)) {
+	typed_val_op(img, ICV_OP_ADD, val);
+	if (img->flags & ICV_OPERATIONS_MODE)
+	    img->flags&=(!ICV_SANITIZED);
+	else
+	    icv_sanitize(img);
+	return 0;
+    }
+
     for (size = img->width*img->height*img->channels; size>0; size--) {
 	*data += val;
 	data++;
@@ -85,6 +197,15 @@ int icv_multiply_val(icv_image_t* img, double val)
 
     ICV_IMAGE_VAL_INT(img);
 
+    if (ICV_IS_TYPED(img)) {
+	typed_val_op(img, ICV_OP_MUL, val);
+	if (img->flags & ICV_OPERATIONS_MODE)
+	    img->flags&=(!ICV_SANITIZED);
+	else
+	    icv_sanitize(img);
+	return 0;
+    }
+
     data = img->data;
 
     for (size = img->width*img->height*img->channels; size>0; size--) {
@@ -106,6 +227,15 @@ int icv_divide_val(icv_image_t* img, double val)
 
     ICV_IMAGE_VAL_INT(img);
 
+    if (ICV_IS_TYPED(img)) {
+	typed_val_op(img, ICV_OP_DIV, val);
+	if (img->flags & ICV_OPERATIONS_MODE)
+	    img->flags&=(!ICV_SANITIZED);
+	else
+	    icv_sanitize(img);
+	return 0;
+    }
+
     data = img->data;
 
     /* Since data is double dividing by 0 will result in INF and -INF */
@@ -130,6 +260,15 @@ int icv_pow_val(icv_image_t* img, double val)
 
     ICV_IMAGE_VAL_INT(img);
 
+    if (ICV_IS_TYPED(img)) {
+	typed_val_op(img, ICV_OP_POW, val);
+	if (img->flags & ICV_OPERATIONS_MODE)
+	    img->flags&=(!ICV_SANITIZED);
+	else
+	    icv_sanitize(img);
+	return 0;
+    }
+
     data = img->data;
 
     for (size = img->width*img->height*img->channels; size>0; size--) {
@@ -159,6 +298,9 @@ icv_image_t *icv_add(icv_image_t *img1, icv_image_t *img2)
 	return NULL;
     }
 
+    if (ICV_IS_TYPED(img1) || ICV_IS_TYPED(img2))
+	return typed_img_op(img1, img2, ICV_OP_ADD);
+
     data1 =img1->data;
     data2 =img2->data;
 
@@ -188,6 +330,9 @@ icv_image_t *icv_sub(icv_image_t *img1, icv_image_t *img2)
 	return NULL;
     }
 
+    if (ICV_IS_TYPED(img1) || ICV_IS_TYPED(img2))
+	return typed_img_op(img1, img2, ICV_OP_SUB);
+
     data1 =img1->data;
     data2 =img2->data;
 
@@ -217,6 +362,9 @@ icv_image_t *icv_multiply(icv_image_t *img1, icv_image_t *img2)
 	return NULL;
     }
 
+    if (ICV_IS_TYPED(img1) || ICV_IS_TYPED(img2))
+	return typed_img_op(img1, img2, ICV_OP_MUL);
+
     data1 =img1->data;
     data2 =img2->data;
 
@@ -247,6 +395,9 @@ icv_image_t *icv_divide(icv_image_t *img1, icv_image_t *img2)
 	return NULL;
     }
 
+    if (ICV_IS_TYPED(img1) || ICV_IS_TYPED(img2))
+	return typed_img_op(img1, img2, ICV_OP_DIV);
+
     data1 =img1->data;
     data2 =img2->data;
 
@@ -282,11 +433,34 @@ int icv_saturate(icv_image_t* img, double sat)
 	return -1;
     }
 
-    data = img->data;
-    size = img->width*img->height;
     rwgt = 0.31*(1.0-sat);
     gwgt = 0.61*(1.0-sat);
     bwgt = 0.08*(1.0-sat);
+
+    if (ICV_IS_TYPED(img)) {
+	float buf[ICV_BLOCK];
+	float fr = (float)rwgt, fg = (float)gwgt, fb = (float)bwgt, fs = (float)sat;
+	size_t i, j, n;
+
+	/* ICV_BLOCK is a whole number of pixels */
+	size = img->width*img->height*3;
+	for (i = 0; i < size; i += n) {
+	    n = (size - i < ICV_BLOCK) ? size - i : ICV_BLOCK;
+	    icv_load_block(buf, img, i, n);
+	    for (j = 0; j < n; j += 3) {
+		float fbw = fr*buf[j] + fg*buf[j+1] + fb*buf[j+2];
+		buf[j] = fbw + fs*buf[j];
+		buf[j+1] = fbw + fs*buf[j+1];
+		buf[j+2] = fbw + fs*buf[j+2];
+	    }
+	    icv_store_block(img, i, buf, n);
+	}
+	icv_sanitize(img);
+	return 0;
+    }
+
+    data = img->data;
+    size = img->width*img->height;
     while (size-- > 0) {
 	rt = *data;
 	gt = *(data+1);
@@ -314,38 +488,45 @@ icv_diff(
 
     int ret = 0;
 
-    // Have images
-    unsigned char *d1 = icv_data2uchar(img1);
-    unsigned char *d2 = icv_data2uchar(img2);
+    // Without gamma correction the 8-bit values can be made a block
+    // at a time, rather than holding both whole images as bytes
+    int whole = !ZERO(img1->gamma_corr) || !ZERO(img2->gamma_corr) || img1->channels != 3 || img2->channels != 3;
+    unsigned char *d1 = (whole) ? icv_data2uchar(img1) : NULL;
+    unsigned char *d2 = (whole) ? icv_data2uchar(img2) : NULL;
+    unsigned char blk1[ICV_BLOCK], blk2[ICV_BLOCK];
     size_t s1 = img1->width * img1->height;
     size_t s2 = img2->width * img2->height;
     size_t smin = (s1 < s2) ? s1 : s2;
     size_t smax = (s1 > s2) ? s1 : s2;
-    for (size_t i = 0; i < smin; i++) {
-	int r1 = d1[i*3+0];
-	int g1 = d1[i*3+1];
-	int b1 = d1[i*3+2];
-	int r2 = d2[i*3+0];
-	int g2 = d2[i*3+1];
-	int b2 = d2[i*3+2];
-	int dcnt = 0;
-	dcnt += (r1 != r2) ? 1 : 0;
-	dcnt += (g1 != g2) ? 1 : 0;
-	dcnt += (b1 != b2) ? 1 : 0;
-	switch (dcnt) {
-	    case 0:
-		if (matching)
-		    (*matching)++;
-		break;
-	    case 1:
-		ret = 1;
-		if (off_by_1)
-		    (*off_by_1)++;
-		break;
-	    default:
-		ret = 1;
-		if (off_by_many)
-		    (*off_by_many)++;
+    size_t n;
+    for (size_t i = 0; i < smin; i += n) {
+	n = (smin - i < ICV_BLOCK/3) ? smin - i : ICV_BLOCK/3;
+	const unsigned char *p1 = (whole) ? d1 + i*3 : blk1;
+	const unsigned char *p2 = (whole) ? d2 + i*3 : blk2;
+	if (!whole) {
+	    icv_uchar_block(blk1, img1, i*3, n*3);
+	    icv_uchar_block(blk2, img2, i*3, n*3);
+	}
+	for (size_t k = 0; k < n; k++) {
+	    int dcnt = 0;
+	    dcnt += (p1[k*3+0] != p2[k*3+0]) ? 1 : 0;
+	    dcnt += (p1[k*3+1] != p2[k*3+1]) ? 1 : 0;
+	    dcnt += (p1[k*3+2] != p2[k*3+2]) ? 1 : 0;
+	    switch (dcnt) {
+		case 0:
+		    if (matching)
+			(*matching)++;
+		    break;
+		case 1:
+		    ret = 1;
+		    if (off_by_1)
+			(*off_by_1)++;
+		    break;
+		default:
+		    ret = 1;
+		    if (off_by_many)
+			(*off_by_many)++;
+	    }
 	}
     }
     if (smin != smax) {
@@ -354,8 +535,10 @@ icv_diff(
 	    (*off_by_many) += (int)(smax - smin);
 	}
     }
-    bu_free(d1, "image 1 rgb");
-    bu_free(d2, "image 2 rgb");
+    if (whole) {
+	bu_free(d1, "image 1 rgb");
+	bu_free(d2, "image 2 rgb");
+    }
 
     return ret;
 }
@@ -34,7 +34,7 @@
 
 #include "PImgHash.h"
 
-#include "icv.h"
+#include "icv_private.h"
 
 #include "bio.h"
 #include "bu/log.h"
@@ -83,6 +83,10 @@ icv_pdiff(icv_image_t *img1, icv_image_t *img2)
     if (!img1 || !img2)
 	return -1;
 
+    if ((ICV_IS_TYPED(img1) && icv_convert(img1, ICV_DATA_DOUBLE) < 0) ||
+	(ICV_IS_TYPED(img2) && icv_convert(img2, ICV_DATA_DOUBLE) < 0))
+	return -1;
+
     std::unique_ptr<imghash::Hasher> hasher;
     int dct_size = 4; // 1024 bits
     hasher = std::make_unique<imghash::DCTHasher>(8 * dct_size, true);
@@ -163,6 +163,168 @@ png_read(FILE *fp)
 }
 
 
+/* Row by row access for icv_stream_open() and icv_stream_create() */
+
+struct png_stream {
+    png_structp png_p;
+    png_infop info_p;
+    int writing;
+};
+
+
+void *
+png_stream_open(FILE *fp, size_t *width, size_t *height)
+{
+    struct png_stream *ps;
+    char header[8];
+
+    if (UNLIKELY(!fp))
+	return NULL;
+
+    if (fread(header, 8, 1, fp) != 1 || png_sig_cmp((png_bytep)header, 0, 8)) {
+	bu_log("png_stream_open: This is not a PNG file\n");
+	return NULL;
+    }
+
+    BU_GET(ps, struct png_stream);
+    ps->writing = 0;
+    ps->info_p = NULL;
+    ps->png_p = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (ps->png_p)
+	ps->info_p = png_create_info_struct(ps->png_p);
+    if (!ps->png_p || !ps->info_p || setjmp(png_jmpbuf(ps->png_p))) {
+	bu_log("png_stream_open: unable to read PNG header\n");
+	png_destroy_read_struct(ps->png_p ? &ps->png_p : NULL, ps->info_p ? &ps->info_p : NULL, NULL);
+	BU_PUT(ps, struct png_stream);
+	return NULL;
+    }
+
+    png_init_io(ps->png_p, fp);
+    png_set_sig_bytes(ps->png_p, 8);
+    png_read_info(ps->png_p, ps->info_p);
+
+    /* interlaced rows only become final on the last pass */
+    if (png_get_interlace_type(ps->png_p, ps->info_p) != PNG_INTERLACE_NONE) {
+	bu_log("png_stream_open: interlaced PNG files can not be streamed\n");
+	png_destroy_read_struct(&ps->png_p, &ps->info_p, NULL);
+	BU_PUT(ps, struct png_stream);
+	return NULL;
+    }
+
+    /* same transformations as png_read() */
+    int color_type = png_get_color_type(ps->png_p, ps->info_p);
+    if (color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+	png_set_gray_to_rgb(ps->png_p);
+    png_set_expand(ps->png_p);
+    if (png_get_bit_depth(ps->png_p, ps->info_p) == 16)
+	png_set_strip_16(ps->png_p);
+
+    png_color_16p input_backgrd;
+    if (png_get_bKGD(ps->png_p, ps->info_p, &input_backgrd)) {
+	png_set_background(ps->png_p, input_backgrd, PNG_BACKGROUND_GAMMA_FILE, 1, 1.0);
+    } else {
+	png_color_16 def_backgrd={ 0, 0, 0, 0, 0 };
+	png_set_background(ps->png_p, &def_backgrd, PNG_BACKGROUND_GAMMA_FILE, 0, 1.0);
+    }
+
+    double gammaval;
+    if (png_get_gAMA(ps->png_p, ps->info_p, &gammaval))
+	png_set_gAMA(ps->png_p, ps->info_p, gammaval);
+
+    png_read_update_info(ps->png_p, ps->info_p);
+
+    *width = png_get_image_width(ps->png_p, ps->info_p);
+    *height = png_get_image_height(ps->png_p, ps->info_p);
+
+    return ps;
+}
+
+
+void *
+png_stream_create(FILE *fp, size_t width, size_t height, size_t channels)
+{
+    struct png_stream *ps;
+
+    if (UNLIKELY(!fp))
+	return NULL;
+
+    BU_GET(ps, struct png_stream);
+    ps->writing = 1;
+    ps->info_p = NULL;
+    ps->png_p = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (ps->png_p)
+	ps->info_p = png_create_info_struct(ps->png_p);
+    if (!ps->png_p || !ps->info_p || setjmp(png_jmpbuf(ps->png_p))) {
+	bu_log("png_stream_create: unable to create png header\n");
+	png_destroy_write_struct(ps->png_p ? &ps->png_p : NULL, ps->info_p ? &ps->info_p : NULL);
+	BU_PUT(ps, struct png_stream);
+	return NULL;
+    }
+
+    png_init_io(ps->png_p, fp);
+    png_set_IHDR(ps->png_p, ps->info_p, (unsigned)width, (unsigned)height, 8,
+		 (channels == 1) ? PNG_COLOR_TYPE_GRAY : PNG_COLOR_TYPE_RGB,
+		 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+		 PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(ps->png_p, ps->info_p);
+
+    return ps;
+}
+
+
+int
+png_stream_readrow(void *vps, unsigned char *row)
+{
+    struct png_stream *ps = (struct png_stream *)vps;
+
+    if (setjmp(png_jmpbuf(ps->png_p))) {
+	bu_log("png_stream_readrow: error reading PNG data\n");
+	return -1;
+    }
+    png_read_row(ps->png_p, (png_bytep)row, NULL);
+    return 0;
+}
+
+
+int
+png_stream_writerow(void *vps, const unsigned char *row)
+{
+    struct png_stream *ps = (struct png_stream *)vps;
+
+    if (setjmp(png_jmpbuf(ps->png_p))) {
+	bu_log("png_stream_writerow: error writing PNG data\n");
+	return -1;
+    }
+    png_write_row(ps->png_p, (png_const_bytep)row);
+    return 0;
+}
+
+
+int
+png_stream_close(void *vps, int finish)
+{
+    struct png_stream *ps = (struct png_stream *)vps;
+    int ret = 0;
+
+    if (setjmp(png_jmpbuf(ps->png_p))) {
+	ret = -1;
+    } else if (finish) {
+	if (ps->writing)
+	    png_write_end(ps->png_p, ps->info_p);
+	else
+	    png_read_end(ps->png_p, NULL);
+    }
+
+    if (ps->writing)
+	png_destroy_write_struct(&ps->png_p, &ps->info_p);
+    else
+	png_destroy_read_struct(&ps->png_p, &ps->info_p, NULL);
+    BU_PUT(ps, struct png_stream);
+
+    return ret;
+}
+
+
 /*
  * Local Variables:
  * mode: C
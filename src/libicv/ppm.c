@@ -47,6 +47,9 @@ ppm_write(icv_image_t *bif, FILE *fp)
 	return BRLCAD_ERROR;
     }
 
+    if (ICV_IS_TYPED(bif) && icv_convert(bif, ICV_DATA_DOUBLE) < 0)
+	return BRLCAD_ERROR;
+
     int rows = (int)bif->height;
     int cols = (int)bif->width;
 
@@ -29,9 +29,10 @@
 #include "common.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <sys/stat.h>
 
-#include "icv.h"
+#include "icv_private.h"
 #include "vmath.h"
 #include "bu/log.h"
 #include "bu/malloc.h"
@@ -291,6 +292,61 @@ icv_image_size(const char *name, size_t udpi, size_t file_size, bu_mime_image_t
     return      0;
 }
 
+/* reallocate the pixel buffer for a smaller image */
+static void
+resize_pixels(icv_image_t *bif, const char *str)
+{
+    size_t size = bif->width*bif->height*bif->channels;
+
+    if (ICV_IS_TYPED(bif))
+	bif->pixels = bu_realloc(bif->pixels, size*icv_data_size(bif->data_type), str);
+    else
+	bif->data = (double *)bu_realloc(bif->data, size*sizeof(double), str);
+}
+
+
+static int
+shrink_typed(icv_image_t *bif, size_t factor)
+{
+    size_t ch = bif->channels;
+    size_t widthstep = bif->width*ch;
+    size_t out_width = bif->width/factor;
+    size_t out_height = bif->height/factor;
+    size_t out_step = out_width*ch;
+    float scale = 1.0f/(float)(factor*factor);
+    float *row, *acc;
+    size_t x, y, py, px, c, j;
+
+    row = (float *)bu_malloc((widthstep + 1)*sizeof(float), "shrink_image : row");
+    acc = (float *)bu_malloc((out_step + 1)*sizeof(float), "shrink_image : sums");
+
+    /* output row y only overwrites input rows already consumed */
+    for (y = 0; y < out_height; y++) {
+	memset(acc, 0, out_step*sizeof(float));
+	for (py = 0; py < factor; py++) {
+	    const float *in = row;
+	    icv_load_block(row, bif, (y*factor + py)*widthstep, out_width*factor*ch);
+	    for (x = 0; x < out_width; x++)
+		for (px = 0; px < factor; px++)
+		    for (c = 0; c < ch; c++)
+			acc[x*ch + c] += *in++;
+	}
+	for (j = 0; j < out_step; j++)
+	    acc[j] *= scale;
+	icv_store_block(bif, y*out_step, acc, out_step);
+    }
+
+    bu_free(row, "shrink_image : row");
+    bu_free(acc, "shrink_image : sums");
+
+    bif->width = out_width;
+    bif->height = out_height;
+    resize_pixels(bif, "shrink_image : Reallocation");
+
+    return 0;
+}
+
+
 static int
 shrink_image(icv_image_t* bif, size_t factor)
 {
@@ -304,6 +360,9 @@ shrink_image(icv_image_t* bif, size_t factor)
 	return -1;
     }
 
+    if (ICV_IS_TYPED(bif))
+	return shrink_typed(bif, factor);
+
     facsq = factor*factor;
     res_p = bif->data;
     p = (double *)bu_malloc(bif->channels*sizeof(double), "shrink_image : Pixel Values Temp Buffer");
@@ -340,27 +399,29 @@ shrink_image(icv_image_t* bif, size_t factor)
 static int
 under_sample(icv_image_t* bif, size_t factor)
 {
-    double *data_p, *res_p;
-    size_t x, y, widthstep;
+    unsigned char *data_p, *res_p;
+    size_t x, y, widthstep, psize;
 
     if (UNLIKELY(factor < 1)) {
 	bu_log("Cannot shrink image to 0 factor, factor should be a positive value.");
 	return -1;
     }
 
-    widthstep = bif->width*bif->channels;
-    res_p = bif->data;
+    /* a plain copy, so works on the bytes of any storage type */
+    psize = bif->channels*icv_data_size(bif->data_type);
+    widthstep = bif->width*psize;
+    res_p = (unsigned char *)ICV_PIXELS(bif);
 
     for (y = 0; y < bif->height; y += factor) {
-	data_p = bif->data + widthstep*y;
+	data_p = (unsigned char *)ICV_PIXELS(bif) + widthstep*y;
 	for (x = 0; x < bif->width;
-	     x += factor, res_p += bif->channels, data_p += factor * bif->channels)
-	    VMOVEN(res_p, data_p, bif->channels);
+	     x += factor, res_p += psize, data_p += factor * psize)
+	    memmove(res_p, data_p, psize);
     }
 
     bif->width = (int)bif->width/factor;
     bif->height = (int)bif->height/factor;
-    bif->data = (double *)bu_realloc(bif->data, (size_t)(bif->width*bif->height*bif->channels)*sizeof(double), "under_sample : Reallocation");
+    resize_pixels(bif, "under_sample : Reallocation");
 
     return 0;
 }
@@ -372,9 +433,9 @@ ninterp(icv_image_t* bif, size_t out_width, size_t out_height)
     double xstep, ystep;
     size_t i, j;
     size_t x, y;
-    size_t widthstep;
-    double *in_r, *in_c; /* Pointer to row and col of input buffers */
-    double *out_data, *out_p;
+    size_t widthstep, psize;
+    unsigned char *in_r, *in_c; /* Pointer to row and col of input buffers */
+    unsigned char *out_data, *out_p;
     xstep = (double)(bif->width-1) / (double)(out_width) - 1.0e-06;
     ystep = (double)(bif->height-1) / (double)(out_height) - 1.0e-06;
 
@@ -383,27 +444,33 @@ ninterp(icv_image_t* bif, size_t out_width, size_t out_height)
 	return -1;
     }
 
-    out_p = out_data = (double *)bu_malloc(out_width*out_height*bif->channels*sizeof(double), "ninterp : out_data");
+    /* a plain copy, so works on the bytes of any storage type */
+    psize = bif->channels*icv_data_size(bif->data_type);
+    out_p = out_data = (unsigned char *)bu_malloc(out_width*out_height*psize, "ninterp : out_data");
 
-    widthstep= bif->width*bif->channels;
+    widthstep= bif->width*psize;
 
     for (j = 0; j < out_height; j++) {
 	y = (int)(j*ystep);
-	in_r = bif->data + y*widthstep;
+	in_r = (unsigned char *)ICV_PIXELS(bif) + y*widthstep;
 
 	for (i = 0; i < out_width; i++) {
 	    x = (int)(i*xstep);
 
-	    in_c = in_r + x*bif->channels;
+	    in_c = in_r + x*psize;
 
-	    VMOVEN(out_p, in_c, bif->channels);
-	    out_p += bif->channels;
+	    memcpy(out_p, in_c, psize);
+	    out_p += psize;
 	}
     }
 
-    bu_free(bif->data, "ninterp : in_data");
-
-    bif->data = out_data;
+    if (ICV_IS_TYPED(bif)) {
+	bu_free(bif->pixels, "ninterp : in_data");
+	bif->pixels = out_data;
+    } else {
+	bu_free(bif->data, "ninterp : in_data");
+	bif->data = (double *)out_data;
+    }
 
     bif->width = out_width;
     bif->height = out_height;
@@ -413,6 +480,77 @@ ninterp(icv_image_t* bif, size_t out_width, size_t out_height)
 }
 
 
+static int
+binterp_typed(icv_image_t *bif, size_t out_width, size_t out_height, double xstep, double ystep)
+{
+    icv_image_t out = *bif;
+    size_t ch = bif->channels;
+    size_t widthstep = bif->width*ch;
+    size_t i, j, c;
+    size_t low_y = (size_t)-1, upp_y = (size_t)-1;
+    double x, y;
+    float dx, dy, mid1, mid2;
+    float *low_r, *upp_r, *out_r, *tmp;
+    const float *low_c, *upp_c;
+
+    out.width = out_width;
+    out.height = out_height;
+    out.pixels = bu_malloc(out_width*out_height*ch*icv_data_size(bif->data_type), "binterp : out data");
+
+    low_r = (float *)bu_malloc(widthstep*sizeof(float), "binterp : row");
+    upp_r = (float *)bu_malloc(widthstep*sizeof(float), "binterp : row");
+    out_r = (float *)bu_malloc(out_width*ch*sizeof(float), "binterp : row");
+
+    for (j = 0; j < out_height; j++) {
+	y = j*ystep;
+	dy = (float)(y - (int)y);
+
+	/* rows are visited in order, so the upper row usually becomes
+	 * the next lower one */
+	if ((size_t)y != low_y) {
+	    if ((size_t)y == upp_y) {
+		tmp = low_r;
+		low_r = upp_r;
+		upp_r = tmp;
+		upp_y = (size_t)-1;
+	    } else {
+		icv_load_block(low_r, bif, (size_t)y*widthstep, widthstep);
+	    }
+	    low_y = (size_t)y;
+	}
+	if ((size_t)(y+1) != upp_y) {
+	    icv_load_block(upp_r, bif, (size_t)(y+1)*widthstep, widthstep);
+	    upp_y = (size_t)(y+1);
+	}
+
+	for (i = 0; i < out_width; i++) {
+	    x = i*xstep;
+	    dx = (float)(x - (int)x);
+
+	    low_c = low_r + (int)x*ch;
+	    upp_c = upp_r + (int)x*ch;
+
+	    for (c = 0; c < ch; c++) {
+		mid1 = low_c[c] + dx * (low_c[c + ch] - low_c[c]);
+		mid2 = upp_c[c] + dx * (upp_c[c + ch] - upp_c[c]);
+		out_r[i*ch + c] = mid1 + dy * (mid2 - mid1);
+	    }
+	}
+	icv_store_block(&out, j*out_width*ch, out_r, out_width*ch);
+    }
+
+    bu_free(low_r, "binterp : row");
+    bu_free(upp_r, "binterp : row");
+    bu_free(out_r, "binterp : row");
+
+    bu_free(bif->pixels, "binterp : Input Data");
+    bif->pixels = out.pixels;
+    bif->width = out_width;
+    bif->height = out_height;
+    return 0;
+}
+
+
 static int
 binterp(icv_image_t *bif, size_t out_width, size_t out_height)
 {
@@ -433,6 +571,9 @@ binterp(icv_image_t *bif, size_t out_width, size_t out_height)
 	return -1;
     }
 
+    if (ICV_IS_TYPED(bif))
+	return binterp_typed(bif, out_width, out_height, xstep, ystep);
+
     out_p = out_data = (double *)bu_malloc(out_width*out_height*bif->channels*sizeof(double), "binterp : out data");
 
     widthstep = bif->width*bif->channels;
@@ -25,7 +25,7 @@
 
 #include "bu/magic.h"
 #include "bu/malloc.h"
-#include "icv.h"
+#include "icv_private.h"
 
 static size_t **
 icv_init_bins(icv_image_t* img, size_t n_bins)
@@ -54,10 +54,12 @@ icv_hist(icv_image_t* img, size_t n_bins)
     size_t temp;
     size_t size;
     size_t **bins;
-    size = img->width*img->height;
-    data = img->data;
 
     ICV_IMAGE_VAL_PTR(img);
+    ICV_IMAGE_DOUBLE_PTR(img);
+
+    size = img->width*img->height;
+    data = img->data;
 
     bins = icv_init_bins(img, n_bins);
 
@@ -80,6 +82,7 @@ icv_max(icv_image_t* img)
     size_t i;
 
     ICV_IMAGE_VAL_PTR(img);
+    ICV_IMAGE_DOUBLE_PTR(img);
 
     max = (double *)bu_malloc(sizeof(double)*img->channels, "max values");
 
@@ -107,6 +110,7 @@ icv_sum(icv_image_t* img)
     size_t size,j;
 
     ICV_IMAGE_VAL_PTR(img);
+    ICV_IMAGE_DOUBLE_PTR(img);
 
     sum = (double *)bu_malloc(sizeof(double)*img->channels, "sum values");
 
@@ -152,6 +156,7 @@ icv_min(icv_image_t* img)
     size_t i;
 
     ICV_IMAGE_VAL_PTR(img);
+    ICV_IMAGE_DOUBLE_PTR(img);
 
     min = (double *)bu_malloc(sizeof(double)*img->channels, "min values");
 
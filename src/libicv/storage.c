@@ -0,0 +1,342 @@
+/*                       S T O R A G E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libicv/storage.c
+ *
+ * Storage of image pixels as types other than double.
+ *
+ * Operations on typed images load a block of values into a float
+ * buffer, work on the floats and store them back, so each operation
+ * only needs one kernel however the pixels are stored.  The 8-bit
+ * loads and stores, which dominate for rendered images, use SSE2
+ * where it is available.
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "icv_private.h"
+
+#if defined(__SSE2__) && defined(__GNUC__) && defined(HAVE_EMMINTRIN_H) && defined(HAVE_EMMINTRIN)
+#  include <emmintrin.h>
+#  define ICV_USE_SSE2 1
+#endif
+
+
+static void
+load_uchar(float *out, const unsigned char *in, size_t n)
+{
+    const float scale = 1.0f/255.0f;
+    size_t i = 0;
+
+#ifdef ICV_USE_SSE2
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 16 <= n; i += 16) {
+	__m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+	__m128i lo = _mm_unpacklo_epi8(v, zero);
+	__m128i hi = _mm_unpackhi_epi8(v, zero);
+	_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), vscale));
+	_mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), vscale));
+	_mm_storeu_ps(out + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), vscale));
+	_mm_storeu_ps(out + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), vscale));
+    }
+#endif
+
+    for (; i < n; i++)
+	out[i] = in[i] * scale;
+}
+
+
+static void
+store_uchar(unsigned char *out, const float *in, size_t n)
+{
+    size_t i = 0;
+
+#ifdef ICV_USE_SSE2
+    const __m128 vmax = _mm_set1_ps(255.0f);
+    const __m128 vmin = _mm_setzero_ps();
+
+    /* clamp before converting, so the packs can not wrap */
+#define ICV_TO_8BIT(_o) _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(in + i + (_o)), vmax), vmax), vmin))
+    for (; i + 16 <= n; i += 16) {
+	__m128i a = ICV_TO_8BIT(0);
+	__m128i b = ICV_TO_8BIT(4);
+	__m128i c = ICV_TO_8BIT(8);
+	__m128i d = ICV_TO_8BIT(12);
+	_mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+    }
+#undef ICV_TO_8BIT
+#endif
+
+    for (; i < n; i++) {
+	float v = in[i] * 255.0f;
+	if (v >= 255.0f)
+	    out[i] = 255;
+	else if (v > 0.0f)
+	    out[i] = (unsigned char)lrintf(v);
+	else
+	    out[i] = 0;
+    }
+}
+
+
+static void
+load_ushort(float *out, const uint16_t *in, size_t n)
+{
+    const float scale = 1.0f/65535.0f;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+	out[i] = in[i] * scale;
+}
+
+
+static void
+store_ushort(uint16_t *out, const float *in, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+	float v = in[i] * 65535.0f;
+	if (v >= 65535.0f)
+	    out[i] = 65535;
+	else if (v > 0.0f)
+	    out[i] = (uint16_t)lrintf(v);
+	else
+	    out[i] = 0;
+    }
+}
+
+
+size_t
+icv_data_size(ICV_DATA type)
+{
+    switch (type) {
+	case ICV_DATA_DOUBLE:
+	    return sizeof(double);
+	case ICV_DATA_UCHAR:
+	    return sizeof(unsigned char);
+	case ICV_DATA_USHORT:
+	    return sizeof(uint16_t);
+	case ICV_DATA_FLOAT:
+	    return sizeof(float);
+    }
+    return 0;
+}
+
+
+void
+icv_load_block(float *out, const icv_image_t *img, size_t off, size_t n)
+{
+    size_t i;
+
+    switch (img->data_type) {
+	case ICV_DATA_DOUBLE:
+	    for (i = 0; i < n; i++)
+		out[i] = (float)img->data[off + i];
+	    break;
+	case ICV_DATA_UCHAR:
+	    load_uchar(out, (const unsigned char *)img->pixels + off, n);
+	    break;
+	case ICV_DATA_USHORT:
+	    load_ushort(out, (const uint16_t *)img->pixels + off, n);
+	    break;
+	case ICV_DATA_FLOAT:
+	    memcpy(out, (const float *)img->pixels + off, n * sizeof(float));
+	    break;
+    }
+}
+
+
+void
+icv_store_block(icv_image_t *img, size_t off, const float *in, size_t n)
+{
+    size_t i;
+
+    switch (img->data_type) {
+	case ICV_DATA_DOUBLE:
+	    for (i = 0; i < n; i++)
+		img->data[off + i] = in[i];
+	    break;
+	case ICV_DATA_UCHAR:
+	    store_uchar((unsigned char *)img->pixels + off, in, n);
+	    break;
+	case ICV_DATA_USHORT:
+	    store_ushort((uint16_t *)img->pixels + off, in, n);
+	    break;
+	case ICV_DATA_FLOAT:
+	    memcpy((float *)img->pixels + off, in, n * sizeof(float));
+	    break;
+    }
+}
+
+
+void
+icv_uchar_block(unsigned char *out, const icv_image_t *img, size_t off, size_t n)
+{
+    float buf[ICV_BLOCK];
+    size_t i, cnt;
+
+    switch (img->data_type) {
+	case ICV_DATA_DOUBLE:
+	    /* matches icv_data2uchar() exactly */
+	    for (i = 0; i < n; i++) {
+		long longval = lrint(img->data[off + i]*255.0);
+		if (longval > 255)
+		    out[i] = 255;
+		else if (longval < 0)
+		    out[i] = 0;
+		else
+		    out[i] = (unsigned char)longval;
+	    }
+	    break;
+	case ICV_DATA_UCHAR:
+	    memcpy(out, (const unsigned char *)img->pixels + off, n);
+	    break;
+	default:
+	    for (i = 0; i < n; i += cnt) {
+		cnt = (n - i < ICV_BLOCK) ? n - i : ICV_BLOCK;
+		icv_load_block(buf, img, off + i, cnt);
+		store_uchar(out + i, buf, cnt);
+	    }
+    }
+}
+
+
+icv_image_t *
+icv_create_typed(size_t width, size_t height, ICV_COLOR_SPACE color_space, ICV_DATA type)
+{
+    icv_image_t *bif;
+    size_t channels;
+
+    if (type == ICV_DATA_DOUBLE)
+	return icv_create(width, height, color_space);
+
+    switch (color_space) {
+	case ICV_COLOR_SPACE_RGB :
+	    channels = 3;
+	    break;
+	case ICV_COLOR_SPACE_GRAY :
+	    channels = 1;
+	    break;
+	default :
+	    bu_log("icv_create_typed : Color Space Not Defined\n");
+	    return NULL;
+    }
+
+    BU_ALLOC(bif, struct icv_image);
+    ICV_IMAGE_INIT(bif);
+    bif->width = width;
+    bif->height = height;
+    bif->channels = channels;
+    bif->color_space = color_space;
+    bif->data_type = type;
+    bif->pixels = bu_calloc(width*height*channels, icv_data_size(type), "Image Data");
+
+    return bif;
+}
+
+
+int
+icv_convert(icv_image_t *bif, ICV_DATA type)
+{
+    size_t size, i, cnt;
+    void *np;
+
+    ICV_IMAGE_VAL_INT(bif);
+
+    if (bif->data_type == type)
+	return 0;
+    if (icv_data_size(type) == 0) {
+	bu_log("icv_convert : Unknown data type\n");
+	return -1;
+    }
+
+    size = bif->width*bif->height*bif->channels;
+
+    if (type == ICV_DATA_DOUBLE) {
+	/* go directly to double, so 8-bit values come out exactly as
+	 * icv_uchar2double() would make them */
+	double *dp = (double *)bu_malloc(size*sizeof(double), "Image Data");
+	if (bif->data_type == ICV_DATA_UCHAR) {
+	    const unsigned char *p = (const unsigned char *)bif->pixels;
+	    for (i = 0; i < size; i++)
+		dp[i] = ICV_CONV_8BIT(p[i]);
+	} else if (bif->data_type == ICV_DATA_USHORT) {
+	    const uint16_t *p = (const uint16_t *)bif->pixels;
+	    for (i = 0; i < size; i++)
+		dp[i] = p[i] / 65535.0;
+	} else {
+	    const float *p = (const float *)bif->pixels;
+	    for (i = 0; i < size; i++)
+		dp[i] = p[i];
+	}
+	bu_free(bif->pixels, "Image Data");
+	bif->pixels = NULL;
+	bif->data = dp;
+	bif->data_type = ICV_DATA_DOUBLE;
+	return 0;
+    }
+
+    np = bu_malloc(size*icv_data_size(type), "Image Data");
+
+    if (type == ICV_DATA_UCHAR) {
+	icv_uchar_block((unsigned char *)np, bif, 0, size);
+    } else {
+	icv_image_t tmp = *bif;
+	float buf[ICV_BLOCK];
+
+	tmp.data_type = type;
+	tmp.data = NULL;
+	tmp.pixels = np;
+	for (i = 0; i < size; i += cnt) {
+	    cnt = (size - i < ICV_BLOCK) ? size - i : ICV_BLOCK;
+	    icv_load_block(buf, bif, i, cnt);
+	    icv_store_block(&tmp, i, buf, cnt);
+	}
+    }
+
+    if (bif->data_type == ICV_DATA_DOUBLE) {
+	bu_free(bif->data, "Image Data");
+	bif->data = NULL;
+    } else {
+	bu_free(bif->pixels, "Image Data");
+    }
+    bif->pixels = np;
+    bif->data_type = type;
+
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,514 @@
+/*                        S T R E A M . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libicv/stream.c
+ *
+ * Line at a time reading and writing of image files, for images too
+ * large to load with icv_read().
+ *
+ * PIX and BW files are read through a band of lines, refilled from
+ * wherever in the file the next line is wanted, so they may be
+ * visited in either direction.  PNG files are handed to libpng a row
+ * at a time and keep their own top to bottom order.
+ */
+
+#include "common.h"
+
+#include <string.h>
+#include <sys/stat.h>
+
+#include "bio.h"
+
+#include "bu/file.h"
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "icv_private.h"
+
+/* target size of the band of lines buffered when reading PIX or BW */
+#define ICV_STREAM_BAND_BYTES (1024*1024)
+
+
+struct icv_stream {
+    FILE *fp;
+    int close_fp;		/* not stdin or stdout */
+    int writing;
+    bu_mime_image_t format;
+    size_t width, height, channels;
+    size_t rowbytes;
+    void *png;			/* PNG reader or writer state */
+    size_t next;		/* PNG: the only line that may come next */
+    size_t pos;			/* PIX/BW: line at the current file offset */
+    size_t lines;		/* lines written */
+    unsigned char *band;	/* PIX/BW: lines band_lo .. band_lo+band_n-1 */
+    size_t band_lo, band_n, band_max;
+};
+
+
+static size_t
+stream_channels(bu_mime_image_t format)
+{
+    switch (format) {
+	case BU_MIME_IMAGE_PIX:
+	case BU_MIME_IMAGE_PNG:
+	    return 3;
+	case BU_MIME_IMAGE_BW:
+	    return 1;
+	default:
+	    return 0;
+    }
+}
+
+
+static icv_stream_t *
+stream_alloc(const char *filename, bu_mime_image_t *format, int writing)
+{
+    struct bu_vls fname = BU_VLS_INIT_ZERO;
+    const char *name = filename;
+    icv_stream_t *s;
+    FILE *fp;
+
+    if (*format == BU_MIME_IMAGE_AUTO) {
+	*format = icv_guess_file_format(filename, &fname);
+	if (filename)
+	    name = bu_vls_cstr(&fname);
+    }
+    if (!stream_channels(*format)) {
+	bu_log("icv_stream: only PIX, BW and PNG images can be streamed\n");
+	bu_vls_free(&fname);
+	return NULL;
+    }
+
+    if (name) {
+	fp = fopen(name, writing ? "wb" : "rb");
+    } else {
+	fp = writing ? stdout : stdin;
+	setmode(fileno(fp), O_BINARY);
+    }
+    if (!fp) {
+	bu_log("icv_stream: cannot open %s for %s\n", name, writing ? "writing" : "reading");
+	bu_vls_free(&fname);
+	return NULL;
+    }
+    bu_vls_free(&fname);
+
+    BU_ALLOC(s, icv_stream_t);
+    s->fp = fp;
+    s->close_fp = (name != NULL);
+    s->writing = writing;
+    s->format = *format;
+    s->channels = stream_channels(*format);
+    return s;
+}
+
+
+static void
+stream_free(icv_stream_t *s)
+{
+    if (s->close_fp)
+	fclose(s->fp);
+    else
+	fflush(s->fp);
+    if (s->band)
+	bu_free(s->band, "icv_stream band");
+    bu_free(s, "icv_stream");
+}
+
+
+icv_stream_t *
+icv_stream_open(const char *filename, bu_mime_image_t format, size_t width, size_t height)
+{
+    icv_stream_t *s = stream_alloc(filename, &format, 0);
+
+    if (!s)
+	return NULL;
+
+    if (format == BU_MIME_IMAGE_PNG) {
+	s->png = png_stream_open(s->fp, &width, &height);
+	if (!s->png) {
+	    stream_free(s);
+	    return NULL;
+	}
+    } else if (!width || !height) {
+	struct stat sb;
+	size_t size, pixels;
+
+	if (fstat(fileno(s->fp), &sb) < 0 || sb.st_size <= 0) {
+	    bu_log("icv_stream_open: image size must be given when it can not be deduced from the file size\n");
+	    stream_free(s);
+	    return NULL;
+	}
+	size = (size_t)sb.st_size;
+	pixels = size / s->channels;
+	if (width)
+	    height = pixels / width;
+	else if (height)
+	    width = pixels / height;
+	else if (!icv_image_size(NULL, 0, size, format, &width, &height))
+	    width = height = 0;
+    }
+    if (!width || !height) {
+	bu_log("icv_stream_open: unable to determine the image size\n");
+	if (s->png)
+	    png_stream_close(s->png, 0);
+	stream_free(s);
+	return NULL;
+    }
+
+    s->width = width;
+    s->height = height;
+    s->rowbytes = width * s->channels;
+    s->next = height - 1;
+
+    if (!s->png) {
+	s->band_max = ICV_STREAM_BAND_BYTES / s->rowbytes;
+	if (s->band_max < 1)
+	    s->band_max = 1;
+	if (s->band_max > height)
+	    s->band_max = height;
+	s->band = (unsigned char *)bu_malloc(s->band_max * s->rowbytes, "icv_stream band");
+    }
+
+    return s;
+}
+
+
+icv_stream_t *
+icv_stream_create(const char *filename, bu_mime_image_t format, size_t width, size_t height)
+{
+    icv_stream_t *s;
+
+    if (!width || !height) {
+	bu_log("icv_stream_create: image size must be given\n");
+	return NULL;
+    }
+
+    s = stream_alloc(filename, &format, 1);
+    if (!s)
+	return NULL;
+
+    s->width = width;
+    s->height = height;
+    s->rowbytes = width * s->channels;
+    s->next = height - 1;
+
+    if (format == BU_MIME_IMAGE_PNG) {
+	s->png = png_stream_create(s->fp, width, height, s->channels);
+	if (!s->png) {
+	    stream_free(s);
+	    return NULL;
+	}
+    }
+
+    return s;
+}
+
+
+void
+icv_stream_size(const icv_stream_t *s, size_t *width, size_t *height, size_t *channels)
+{
+    if (!s)
+	return;
+    if (width)
+	*width = s->width;
+    if (height)
+	*height = s->height;
+    if (channels)
+	*channels = s->channels;
+}
+
+
+/* move the file to the start of line y, if it is not already there */
+static int
+stream_seek(icv_stream_t *s, size_t y)
+{
+    if (y == s->pos)
+	return 0;
+    if (bu_fseek(s->fp, (b_off_t)(y * s->rowbytes), SEEK_SET) != 0) {
+	bu_log("icv_stream: %s is not seekable, so lines must be visited bottom to top\n",
+	       s->writing ? "output" : "input");
+	return -1;
+    }
+    s->pos = y;
+    return 0;
+}
+
+
+int
+icv_stream_readline(icv_stream_t *s, size_t y, unsigned char *data)
+{
+    if (!s || !data || s->writing || y >= s->height)
+	return -1;
+
+    if (s->png) {
+	if (y != s->next) {
+	    bu_log("icv_stream_readline: PNG lines must be read from the top down\n");
+	    return -1;
+	}
+	if (png_stream_readrow(s->png, data) < 0)
+	    return -1;
+	s->next--;
+	return 0;
+    }
+
+    if (y < s->band_lo || y >= s->band_lo + s->band_n) {
+	size_t lo, n, got;
+
+	/* continuing upwards, start the band at y; otherwise assume
+	 * we are heading down and end it at y */
+	if (s->band_n && y == s->band_lo + s->band_n)
+	    lo = y;
+	else if (y + 1 >= s->band_max)
+	    lo = y + 1 - s->band_max;
+	else
+	    lo = 0;
+	n = s->height - lo;
+	if (n > s->band_max)
+	    n = s->band_max;
+
+	if (stream_seek(s, lo) < 0)
+	    return -1;
+	got = fread(s->band, 1, n * s->rowbytes, s->fp);
+	if (got < n * s->rowbytes) {
+	    if (ferror(s->fp)) {
+		bu_log("icv_stream_readline: error reading image data\n");
+		s->band_n = 0;
+		return -1;
+	    }
+	    /* short file, as icv_read() treats it */
+	    memset(s->band + got, 0, n * s->rowbytes - got);
+	}
+	s->pos = lo + got / s->rowbytes;
+	if (got % s->rowbytes)
+	    s->pos = (size_t)-1;
+	s->band_lo = lo;
+	s->band_n = n;
+    }
+
+    memcpy(data, s->band + (y - s->band_lo) * s->rowbytes, s->rowbytes);
+    return 0;
+}
+
+
+int
+icv_stream_writeline(icv_stream_t *s, size_t y, const unsigned char *data)
+{
+    if (!s || !data || !s->writing || y >= s->height)
+	return -1;
+
+    if (s->png) {
+	if (y != s->next) {
+	    bu_log("icv_stream_writeline: PNG lines must be written from the top down\n");
+	    return -1;
+	}
+	if (png_stream_writerow(s->png, data) < 0)
+	    return -1;
+	s->next--;
+	s->lines++;
+	return 0;
+    }
+
+    if (stream_seek(s, y) < 0)
+	return -1;
+    if (fwrite(data, 1, s->rowbytes, s->fp) != s->rowbytes) {
+	bu_log("icv_stream_writeline: short write\n");
+	s->pos = (size_t)-1;
+	return -1;
+    }
+    s->pos = y + 1;
+    s->lines++;
+    return 0;
+}
+
+
+int
+icv_stream_close(icv_stream_t *s)
+{
+    int ret = 0;
+
+    if (!s)
+	return -1;
+
+    if (s->writing && s->lines < s->height) {
+	bu_log("icv_stream_close: only %zu of %zu lines were written\n", s->lines, s->height);
+	ret = -1;
+    }
+    /* only finish a PNG that was read or written to the end */
+    if (s->png && png_stream_close(s->png, s->next == (size_t)-1) < 0)
+	ret = -1;
+    if (s->writing && (fflush(s->fp) != 0 || ferror(s->fp)))
+	ret = -1;
+
+    stream_free(s);
+    return ret;
+}
+
+
+/* convert a line between gray and RGB, averaging as icv_rgb2gray() does */
+static void
+stream_convert(unsigned char *out, size_t out_ch, const unsigned char *in, size_t in_ch, size_t width)
+{
+    size_t i;
+
+    if (out_ch == in_ch) {
+	memcpy(out, in, width * in_ch);
+    } else if (out_ch == 3) {
+	for (i = 0; i < width; i++)
+	    out[3*i] = out[3*i+1] = out[3*i+2] = in[i];
+    } else {
+	for (i = 0; i < width; i++)
+	    out[i] = (unsigned char)((in[3*i] + in[3*i+1] + in[3*i+2] + 1) / 3);
+    }
+}
+
+
+int
+icv_stream_copy(icv_stream_t *out, icv_stream_t *in)
+{
+    unsigned char *irow, *orow;
+    size_t k, y;
+    int down;
+    int ret = 0;
+
+    if (!out || !in || !out->writing || in->writing)
+	return -1;
+    if (out->width != in->width || out->height != in->height) {
+	bu_log("icv_stream_copy: images are not the same size\n");
+	return -1;
+    }
+
+    /* PNG needs its top line first, otherwise go in file order */
+    down = (in->png || out->png);
+
+    irow = (unsigned char *)bu_malloc(in->rowbytes, "icv_stream_copy in");
+    orow = (unsigned char *)bu_malloc(out->rowbytes, "icv_stream_copy out");
+    for (k = 0; k < in->height; k++) {
+	y = (down) ? in->height - 1 - k : k;
+	if (icv_stream_readline(in, y, irow) < 0) {
+	    ret = -1;
+	    break;
+	}
+	stream_convert(orow, out->channels, irow, in->channels, in->width);
+	if (icv_stream_writeline(out, y, orow) < 0) {
+	    ret = -1;
+	    break;
+	}
+    }
+    bu_free(irow, "icv_stream_copy in");
+    bu_free(orow, "icv_stream_copy out");
+
+    return ret;
+}
+
+
+int
+icv_stream_diff(int *matching, int *off_by_1, int *off_by_many, icv_stream_t *s1, icv_stream_t *s2)
+{
+    unsigned char *raw, *r1, *r2;
+    size_t hmax, k, x, y, width;
+    int down;
+    int ret = 0;
+
+    if (!s1 || !s2 || s1->writing || s2->writing)
+	return -1;
+
+    if (s1->width != s2->width) {
+	size_t p1 = s1->width * s1->height;
+	size_t p2 = s2->width * s2->height;
+	if (off_by_many)
+	    (*off_by_many) += (int)((p1 > p2) ? p1 : p2);
+	return 1;
+    }
+
+    width = s1->width;
+    hmax = (s1->height > s2->height) ? s1->height : s2->height;
+    down = (s1->png || s2->png);
+
+    raw = (unsigned char *)bu_malloc(width * 3, "icv_stream_diff line");
+    r1 = (unsigned char *)bu_malloc(width * 3, "icv_stream_diff line 1");
+    r2 = (unsigned char *)bu_malloc(width * 3, "icv_stream_diff line 2");
+
+    for (k = 0; k < hmax; k++) {
+	int have1, have2;
+
+	y = (down) ? hmax - 1 - k : k;
+	have1 = (y < s1->height);
+	have2 = (y < s2->height);
+
+	/* lines of a PNG can not be skipped, so read even unmatched ones */
+	if (have1) {
+	    if (icv_stream_readline(s1, y, raw) < 0) {
+		ret = -1;
+		break;
+	    }
+	    stream_convert(r1, 3, raw, s1->channels, width);
+	}
+	if (have2) {
+	    if (icv_stream_readline(s2, y, raw) < 0) {
+		ret = -1;
+		break;
+	    }
+	    stream_convert(r2, 3, raw, s2->channels, width);
+	}
+	if (!have1 || !have2) {
+	    ret = 1;
+	    if (off_by_many)
+		(*off_by_many) += (int)width;
+	    continue;
+	}
+
+	for (x = 0; x < width; x++) {
+	    int dcnt = 0;
+	    dcnt += (r1[x*3+0] != r2[x*3+0]) ? 1 : 0;
+	    dcnt += (r1[x*3+1] != r2[x*3+1]) ? 1 : 0;
+	    dcnt += (r1[x*3+2] != r2[x*3+2]) ? 1 : 0;
+	    switch (dcnt) {
+		case 0:
+		    if (matching)
+			(*matching)++;
+		    break;
+		case 1:
+		    ret = 1;
+		    if (off_by_1)
+			(*off_by_1)++;
+		    break;
+		default:
+		    ret = 1;
+		    if (off_by_many)
+			(*off_by_many)++;
+	    }
+	}
+    }
+
+    bu_free(raw, "icv_stream_diff line");
+    bu_free(r1, "icv_stream_diff line 1");
+    bu_free(r2, "icv_stream_diff line 2");
+
+    return ret;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,306 @@
+/*                         T Y P E D . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libicv/tests/typed.c
+ *
+ * Checks that images stored as 8-bit, 16-bit and float values give
+ * the same 8-bit results as images stored as doubles, that lines of
+ * every data type written into every storage type read back as the
+ * values written, and that a PIX file streamed to PNG and back is
+ * unchanged.
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "icv.h"
+
+#define TW 36
+#define TH 30
+
+static int failures = 0;
+
+
+static icv_image_t *
+typed_image(ICV_DATA type, unsigned int seed)
+{
+    unsigned char line[TW*3];
+    icv_image_t *img;
+    size_t x, y;
+
+    img = icv_create_typed(TW, TH, ICV_COLOR_SPACE_RGB, type);
+    for (y = 0; y < TH; y++) {
+	for (x = 0; x < TW*3; x++) {
+	    seed = seed * 1103515245 + 12345;
+	    line[x] = (unsigned char)(seed >> 16);
+	}
+	icv_writeline(img, y, line, ICV_DATA_UCHAR);
+    }
+    return img;
+}
+
+
+/* 8-bit results may differ by one where float and double round apart */
+static void
+typed_compare(const char *what, ICV_DATA type, icv_image_t *ref, icv_image_t *img)
+{
+    unsigned char *d1, *d2;
+    size_t i, size;
+    int diff, worst = 0;
+
+    if (ref->width != img->width || ref->height != img->height || ref->channels != img->channels) {
+	bu_log("%s (type %d): result is %zux%zu, expected %zux%zu\n", what, (int)type,
+	       img->width, img->height, ref->width, ref->height);
+	failures++;
+	return;
+    }
+
+    d1 = icv_data2uchar(ref);
+    d2 = icv_data2uchar(img);
+    size = ref->width*ref->height*ref->channels;
+    for (i = 0; i < size; i++) {
+	diff = abs((int)d1[i] - (int)d2[i]);
+	if (diff > worst)
+	    worst = diff;
+    }
+    bu_free(d1, "ref data");
+    bu_free(d2, "typed data");
+
+    if (worst > 1) {
+	bu_log("%s (type %d): differs from double storage by %d\n", what, (int)type, worst);
+	failures++;
+    }
+}
+
+
+#define TYPED_OP(_name, _call) { \
+	icv_image_t *ref = typed_image(ICV_DATA_DOUBLE, 1); \
+	icv_image_t *img = typed_image(type, 1); \
+	{ icv_image_t *op_img = ref; _call; } \
+	{ icv_image_t *op_img = img; _call; } \
+	typed_compare(_name, type, ref, img); \
+	icv_destroy(ref); \
+	icv_destroy(img); \
+    }
+
+
+static void
+typed_ops(ICV_DATA type)
+{
+    icv_image_t *a, *b, *ta, *tb, *r1, *r2;
+    int m1 = 0, o1 = 0, n1 = 0, m2 = 0, o2 = 0, n2 = 0;
+
+    TYPED_OP("store", (void)op_img);
+    TYPED_OP("icv_add_val", icv_add_val(op_img, 0.1));
+    TYPED_OP("icv_multiply_val", icv_multiply_val(op_img, 1.7));
+    TYPED_OP("icv_divide_val", icv_divide_val(op_img, 2.5));
+    TYPED_OP("icv_pow_val", icv_pow_val(op_img, 0.5));
+    TYPED_OP("icv_saturate", icv_saturate(op_img, 0.4));
+    TYPED_OP("icv_fade", icv_fade(op_img, 0.6));
+    TYPED_OP("icv_resize undersample", icv_resize(op_img, ICV_RESIZE_UNDERSAMPLE, 0, 0, 3));
+    TYPED_OP("icv_resize ninterp", icv_resize(op_img, ICV_RESIZE_NINTERP, 80, 60, 1));
+    TYPED_OP("icv_resize binterp", icv_resize(op_img, ICV_RESIZE_BINTERP, 80, 60, 1));
+    TYPED_OP("icv_rect", icv_rect(op_img, 3, 4, 10, 9));
+
+    a = typed_image(ICV_DATA_DOUBLE, 1);
+    b = typed_image(ICV_DATA_DOUBLE, 2);
+    ta = typed_image(type, 1);
+    tb = typed_image(type, 2);
+
+    r1 = icv_add(a, b);
+    r2 = icv_add(ta, tb);
+    typed_compare("icv_add", type, r1, r2);
+    icv_destroy(r1);
+    icv_destroy(r2);
+
+    r1 = icv_sub(a, b);
+    r2 = icv_sub(ta, tb);
+    typed_compare("icv_sub", type, r1, r2);
+    icv_destroy(r1);
+    icv_destroy(r2);
+
+    r1 = icv_multiply(a, b);
+    r2 = icv_multiply(ta, tb);
+    typed_compare("icv_multiply", type, r1, r2);
+    icv_destroy(r1);
+    icv_destroy(r2);
+
+    /* mixed storage types */
+    r1 = icv_divide(a, b);
+    r2 = icv_divide(ta, b);
+    typed_compare("icv_divide", type, r1, r2);
+    icv_destroy(r1);
+    icv_destroy(r2);
+
+    if (icv_diff(&m1, &o1, &n1, a, b) != icv_diff(&m2, &o2, &n2, ta, tb) || m1 != m2 || o1 != o2 || n1 != n2) {
+	bu_log("icv_diff (type %d): counts differ from double storage\n", (int)type);
+	failures++;
+    }
+
+    icv_destroy(a);
+    icv_destroy(b);
+    icv_destroy(ta);
+    icv_destroy(tb);
+}
+
+
+/* Line values are k/255, which 8-bit, 16-bit (257*k), float and
+ * double lines all hold exactly, so whatever the line and storage
+ * types the stored image must read back as k/255. */
+static void
+typed_writeline(ICV_DATA type, ICV_DATA storage)
+{
+    unsigned char uc[TW*3];
+    uint16_t us[TW*3];
+    float fl[TW*3];
+    double db[TW*3];
+    void *line = NULL;
+    icv_image_t *img;
+    size_t x, y;
+    double worst = 0.0;
+
+    img = icv_create_typed(TW, TH, ICV_COLOR_SPACE_RGB, storage);
+    for (y = 0; y < TH; y++) {
+	for (x = 0; x < TW*3; x++) {
+	    unsigned char k = (unsigned char)((x*7 + y*13) & 0xff);
+	    uc[x] = k;
+	    us[x] = (uint16_t)(k*257);
+	    fl[x] = k/255.0f;
+	    db[x] = k/255.0;
+	}
+	switch (type) {
+	    case ICV_DATA_DOUBLE: line = db; break;
+	    case ICV_DATA_UCHAR: line = uc; break;
+	    case ICV_DATA_USHORT: line = us; break;
+	    case ICV_DATA_FLOAT: line = fl; break;
+	}
+	if (icv_writeline(img, y, line, type) != 0) {
+	    bu_log("icv_writeline (type %d into %d): line %zu failed\n", (int)type, (int)storage, y);
+	    failures++;
+	}
+    }
+
+    if (icv_writeline(img, TH, line, type) != -1) {
+	bu_log("icv_writeline (type %d into %d): line past the top accepted\n", (int)type, (int)storage);
+	failures++;
+    }
+
+    icv_convert(img, ICV_DATA_DOUBLE);
+    for (y = 0; y < TH; y++) {
+	for (x = 0; x < TW*3; x++) {
+	    double want = ((x*7 + y*13) & 0xff) / 255.0;
+	    double diff = fabs(img->data[y*TW*3 + x] - want);
+	    if (diff > worst)
+		worst = diff;
+	}
+    }
+    icv_destroy(img);
+
+    if (worst > 1.0e-6) {
+	bu_log("icv_writeline (type %d into %d): read back off by %g\n", (int)type, (int)storage, worst);
+	failures++;
+    }
+}
+
+
+static void
+typed_stream(void)
+{
+    const char *pix = "icv_typed.pix";
+    const char *png = "icv_typed.png";
+    icv_stream_t *in, *out;
+    icv_image_t *img;
+    int matching = 0, off_by_1 = 0, off_by_many = 0;
+    int ret;
+
+    img = typed_image(ICV_DATA_UCHAR, 3);
+    if (icv_write(img, pix, BU_MIME_IMAGE_PIX) != 0) {
+	bu_log("unable to write %s\n", pix);
+	failures++;
+	icv_destroy(img);
+	return;
+    }
+    icv_destroy(img);
+
+    in = icv_stream_open(pix, BU_MIME_IMAGE_PIX, TW, TH);
+    out = icv_stream_create(png, BU_MIME_IMAGE_PNG, TW, TH);
+    ret = icv_stream_copy(out, in);
+    ret |= icv_stream_close(out);
+    ret |= icv_stream_close(in);
+    if (ret) {
+	bu_log("icv_stream_copy: PIX to PNG failed\n");
+	failures++;
+    }
+
+    in = icv_stream_open(png, BU_MIME_IMAGE_PNG, 0, 0);
+    out = icv_stream_open(pix, BU_MIME_IMAGE_PIX, TW, TH);
+    ret = icv_stream_diff(&matching, &off_by_1, &off_by_many, in, out);
+    icv_stream_close(in);
+    icv_stream_close(out);
+    if (ret != 0 || matching != TW*TH) {
+	bu_log("icv_stream_diff: %d matching, %d off by 1, %d off by many\n", matching, off_by_1, off_by_many);
+	failures++;
+    }
+
+    bu_file_delete(pix);
+    bu_file_delete(png);
+}
+
+
+int
+main(int UNUSED(argc), char **argv)
+{
+    int t;
+
+    bu_setprogname(argv[0]);
+
+    typed_ops(ICV_DATA_UCHAR);
+    typed_ops(ICV_DATA_USHORT);
+    typed_ops(ICV_DATA_FLOAT);
+
+    for (t = ICV_DATA_DOUBLE; t <= ICV_DATA_FLOAT; t++) {
+	typed_writeline((ICV_DATA)t, ICV_DATA_DOUBLE);
+	typed_writeline((ICV_DATA)t, ICV_DATA_UCHAR);
+	typed_writeline((ICV_DATA)t, ICV_DATA_USHORT);
+	typed_writeline((ICV_DATA)t, ICV_DATA_FLOAT);
+    }
+
+    typed_stream();
+
+    if (failures)
+	bu_log("%d failures\n", failures);
+
+    return (failures) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -206,6 +206,116 @@ nmg_region_both_vfuse(struct bu_ptbl *t1, struct bu_ptbl *t2, const struct bn_to
     return count;
 }
 
+/*
+ * Hash of integer cell coordinates, used to find the vertices or face
+ * planes that are close enough to one another to be worth handing to
+ * the exact (and much more expensive) fuse tests.  Entries are only
+ * ever compared against entries in the same or adjacent cells, which
+ * keeps fusing near linear in the number of entries instead of
+ * quadratic, regardless of how the geometry is laid out.
+ *
+ * Each entry has a four component key; vertices use three of them.
+ * The entries of one bucket are chained through next[], and a chain
+ * may hold several cells that hash alike, so the key is always
+ * compared in full.
+ */
+struct fuse_cells {
+    size_t mask;		/* bucket count - 1, a power of two */
+    long *head;			/* first entry in each bucket, -1 if none */
+    long *next;			/* next entry in the same bucket */
+    int64_t (*key)[4];		/* cell of each entry */
+};
+
+
+static void
+fuse_cells_init(struct fuse_cells *c, size_t n)
+{
+    size_t nbuckets = 64;
+    size_t i;
+
+    while (nbuckets < 2 * n)
+	nbuckets <<= 1;
+    c->mask = nbuckets - 1;
+    c->head = (long *)bu_malloc(nbuckets * sizeof(long), "fuse_cells head");
+    for (i = 0; i < nbuckets; i++)
+	c->head[i] = -1;
+    c->next = (long *)bu_malloc((n + 1) * sizeof(long), "fuse_cells next");
+    c->key = (int64_t (*)[4])bu_malloc((n + 1) * sizeof(int64_t[4]), "fuse_cells key");
+}
+
+
+static void
+fuse_cells_free(struct fuse_cells *c)
+{
+    bu_free(c->head, "fuse_cells head");
+    bu_free(c->next, "fuse_cells next");
+    bu_free(c->key, "fuse_cells key");
+}
+
+
+static size_t
+fuse_cells_hash(const struct fuse_cells *c, const int64_t k[4])
+{
+    uint64_t h;
+
+    h = (uint64_t)k[0] * 73856093ULL;
+    h ^= (uint64_t)k[1] * 19349663ULL;
+    h ^= (uint64_t)k[2] * 83492791ULL;
+    h ^= (uint64_t)k[3] * 2654435761ULL;
+    h ^= h >> 29;
+    return (size_t)h & c->mask;
+}
+
+
+/* Cell of coordinate 'v' for cells 'size' wide */
+static int64_t
+fuse_cell_of(fastf_t v, fastf_t size)
+{
+    fastf_t q = floor(v / size);
+
+    /* keep absurd coordinates from overflowing; they only lose speed */
+    if (q > 4.0e18)
+	return (int64_t)4.0e18;
+    if (q < -4.0e18)
+	return (int64_t)-4.0e18;
+    return (int64_t)q;
+}
+
+
+static void
+fuse_cells_add(struct fuse_cells *c, long e, const int64_t k[4])
+{
+    size_t b = fuse_cells_hash(c, k);
+
+    c->key[e][0] = k[0];
+    c->key[e][1] = k[1];
+    c->key[e][2] = k[2];
+    c->key[e][3] = k[3];
+    c->next[e] = c->head[b];
+    c->head[b] = e;
+}
+
+
+/* Starting from chain position 'e', find the next entry in cell 'k' */
+static long
+fuse_cells_scan(const struct fuse_cells *c, long e, const int64_t k[4])
+{
+    while (e >= 0) {
+	if (c->key[e][0] == k[0] && c->key[e][1] == k[1] &&
+	    c->key[e][2] == k[2] && c->key[e][3] == k[3])
+	    return e;
+	e = c->next[e];
+    }
+    return -1;
+}
+
+
+#define FUSE_CELLS_FOR(_e, _c, _k) \
+    for ((_e) = fuse_cells_scan((_c), (_c)->head[fuse_cells_hash((_c), (_k))], (_k)); \
+	 (_e) >= 0; \
+	 (_e) = fuse_cells_scan((_c), (_c)->next[(_e)], (_k)))
+
+
 /* compare function for bu_sort within function nmg_ptbl_vfuse */
 static int
 x_comp(const void *p1, const void *p2, void *UNUSED(arg))
@@ -224,7 +334,7 @@ x_comp(const void *p1, const void *p2, void *UNUSED(arg))
 
 
 /**
- * Working from the end to the front, scan for geometric duplications
+ * Working from the front to the end, scan for geometric duplications
  * within a single list of vertex structures.
  *
  * Exists primarily as a support routine for nmg_vertex_fuse().
@@ -232,65 +342,84 @@ x_comp(const void *p1, const void *p2, void *UNUSED(arg))
 static int
 nmg_ptbl_vfuse(struct bu_ptbl *t, const struct bn_tol *tol)
 {
-    int count, fuse;
-    register size_t i, j;
-    register fastf_t tmp = tol->dist_sq;
-    register fastf_t ab, abx, aby, abz;
-
-    /* sort the vertices in the 't' list by the 'x' coordinate */
-    bu_sort(BU_PTBL_BASEADDR(t), BU_PTBL_LEN(t), sizeof(long *), x_comp, NULL);
+    struct fuse_cells cells;
+    int64_t k[4];
+    fastf_t size;
+    size_t i, n;
+    long e;
+    int count;
+    int dx, dy, dz;
+
+    n = BU_PTBL_LEN(t);
+
+    /* sort the vertices in the 't' list by the 'x' coordinate, which
+     * fixes the order in which vertices absorb one another
+     */
+    bu_sort(BU_PTBL_BASEADDR(t), n, sizeof(long *), x_comp, NULL);
 
-    count = 0;
-    for (i = 0 ; i < BU_PTBL_LEN(t) ; i++) {
-	register struct vertex *vi;
+    /* Bin the vertices into cells one distance tolerance wide, so
+     * any vertex within tolerance of another is in an adjacent cell.
+     */
+    size = (tol->dist > SMALL_FASTF) ? tol->dist : 1.0;
+    fuse_cells_init(&cells, n);
+    for (i = 0; i < n; i++) {
+	struct vertex *vi;
 	vi = (struct vertex *)BU_PTBL_GET(t, i);
 	if (!vi) continue;
 	NMG_CK_VERTEX(vi);
 	if (!vi->vg_p) continue;
 
-	for (j = i+1 ; j < BU_PTBL_LEN(t) ; j++) {
-	    register struct vertex *vj;
-	    vj = (struct vertex *)BU_PTBL_GET(t, j);
-	    if (!vj) continue;
-	    NMG_CK_VERTEX(vj);
-	    if (!vj->vg_p) continue;
-
-	    if (vi->vg_p == vj->vg_p) {
-		/* They are the same, fuse vj into vi */
-		nmg_jv(vi, vj);  /* vj gets destroyed */
-		BU_PTBL_SET(t, j, NULL);
-		count++;
-		continue;
-	    }
+	k[0] = fuse_cell_of(vi->vg_p->coord[X], size);
+	k[1] = fuse_cell_of(vi->vg_p->coord[Y], size);
+	k[2] = fuse_cell_of(vi->vg_p->coord[Z], size);
+	k[3] = 0;
+	fuse_cells_add(&cells, (long)i, k);
+    }
 
-	    fuse = 1;
-	    abx = vi->vg_p->coord[X] - vj->vg_p->coord[X];
-	    ab = abx * abx;
-	    if (ab > tmp) {
-		break;  /* no more to test */
-	    }
+    count = 0;
+    for (i = 0 ; i < n ; i++) {
+	struct vertex *vi;
+	vi = (struct vertex *)BU_PTBL_GET(t, i);
+	if (!vi) continue;
+	if (!vi->vg_p) continue;
 
-	    aby = vi->vg_p->coord[Y] - vj->vg_p->coord[Y];
-	    ab += (aby * aby);
-	    if (ab > tmp) {
-		fuse = 0;
-	    } else {
-		abz = vi->vg_p->coord[Z] - vj->vg_p->coord[Z];
-		ab += (abz * abz);
-		if (ab > tmp) {
-		    fuse = 0;
+	for (dz = -1; dz <= 1; dz++) {
+	    for (dy = -1; dy <= 1; dy++) {
+		for (dx = -1; dx <= 1; dx++) {
+		    k[0] = cells.key[i][0] + dx;
+		    k[1] = cells.key[i][1] + dy;
+		    k[2] = cells.key[i][2] + dz;
+		    k[3] = 0;
+
+		    FUSE_CELLS_FOR(e, &cells, k) {
+			struct vertex *vj;
+			fastf_t ab, abx, aby, abz;
+
+			/* only look ahead, as the sorted sweep did */
+			if ((size_t)e <= i) continue;
+			vj = (struct vertex *)BU_PTBL_GET(t, e);
+			if (!vj) continue;
+
+			if (vi->vg_p != vj->vg_p) {
+			    abx = vi->vg_p->coord[X] - vj->vg_p->coord[X];
+			    aby = vi->vg_p->coord[Y] - vj->vg_p->coord[Y];
+			    abz = vi->vg_p->coord[Z] - vj->vg_p->coord[Z];
+			    ab = abx * abx + aby * aby + abz * abz;
+			    if (ab > tol->dist_sq)
+				continue;
+			}
+
+			/* They are the same, fuse vj into vi */
+			nmg_jv(vi, vj);  /* vj gets destroyed */
+			BU_PTBL_SET(t, e, NULL);
+			count++;
+		    }
 		}
 	    }
-
-	    if (fuse) {
-		/* They are the same, fuse vj into vi */
-		nmg_jv(vi, vj);  /* vj gets destroyed */
-		BU_PTBL_SET(t, j, NULL);
-		count++;
-	    }
 	}
     }
 
+    fuse_cells_free(&cells);
     return count;
 }
 
@@ -1644,6 +1773,23 @@ nmg_two_face_fuse(struct face *f1, struct face *f2, const struct bn_tol *tol)
 }
 
 
+/* Width of a face normal cell, per unit normal component */
+#define NMG_FUSE_NCELL 0.01
+
+
+/* Descending order of face table indices, for nmg_model_face_fuse() */
+static int
+idx_rcomp(const void *p1, const void *p2, void *UNUSED(arg))
+{
+    size_t i = *(const size_t *)p1;
+    size_t j = *(const size_t *)p2;
+
+    if (i > j)
+	return -1;
+    return (i < j);
+}
+
+
 /**
  * A routine to find all face geometry structures in an nmg model that
  * have the same plane equation, and have them share face geometry.
@@ -1654,20 +1800,73 @@ nmg_two_face_fuse(struct face *f1, struct face *f2, const struct bn_tol *tol)
  * 1) The plane equations must be the same, within tolerance.
  * 2) All the vertices on the 2nd face must lie within the
  * distance tolerance of the 1st face's plane equation.
+ *
+ * Rather than trying every pair of faces, the planes are bucketed by
+ * their distance from the origin, quantized to the distance
+ * tolerance, and by their normal, quantized to NMG_FUSE_NCELL.  Only
+ * faces in adjacent buckets are handed to nmg_two_face_fuse().  Two
+ * planes whose normals differ by more than that can only both be
+ * within tolerance of faces narrower than 2*tol->dist/NMG_FUSE_NCELL,
+ * so those small faces are additionally bucketed on distance alone
+ * and compared with one another.
  */
 int
 nmg_model_face_fuse(struct model *m, struct bu_list *vlfree, const struct bn_tol *tol)
 {
     struct bu_ptbl ftab;
+    struct fuse_cells cells;	/* by plane distance and normal */
+    struct fuse_cells small;	/* small faces, by plane distance */
+    size_t *cand;
+    size_t *stamp;
+    size_t ncand;
+    size_t i, c, n;
+    fastf_t size, small_diag;
+    int64_t k[4];
+    long e;
     int total = 0;
-    register int i, j;
+    int dw, dx, dy, dz, sense;
 
     /* Make a list of all the face structs in the model */
     nmg_face_tabulate(&ftab, &m->magic, vlfree);
+    n = BU_PTBL_LEN(&ftab);
+
+    size = (tol->dist > SMALL_FASTF) ? tol->dist : 1.0;
+    small_diag = 2.0 * tol->dist / NMG_FUSE_NCELL;
+
+    fuse_cells_init(&cells, n);
+    fuse_cells_init(&small, n);
+    for (i = 0; i < n; i++) {
+	struct face *f;
+	struct face_g_plane *fg;
+	vect_t diag;
+
+	f = (struct face *)BU_PTBL_GET(&ftab, i);
+	if (*f->g.magic_p == NMG_FACE_G_SNURB_MAGIC)
+	    continue;
+	fg = f->g.plane_p;
+	if (!fg) continue;
+
+	k[0] = fuse_cell_of(fg->N[W], size);
+	k[1] = fuse_cell_of(fg->N[X], NMG_FUSE_NCELL);
+	k[2] = fuse_cell_of(fg->N[Y], NMG_FUSE_NCELL);
+	k[3] = fuse_cell_of(fg->N[Z], NMG_FUSE_NCELL);
+	fuse_cells_add(&cells, (long)i, k);
+
+	VSUB2(diag, f->max_pt, f->min_pt);
+	if (MAGSQ(diag) < small_diag * small_diag) {
+	    k[1] = k[2] = k[3] = 0;
+	    fuse_cells_add(&small, (long)i, k);
+	}
+    }
+
+    cand = (size_t *)bu_calloc(n + 1, sizeof(size_t), "nmg_model_face_fuse cand");
+    stamp = (size_t *)bu_calloc(n + 1, sizeof(size_t), "nmg_model_face_fuse stamp");
+
+    for (i = n; i-- > 0;) {
+	struct face *f1;
+	struct face_g_plane *fg1;
+	vect_t diag;
 
-    for (i = BU_PTBL_LEN(&ftab)-1; i >= 0; i--) {
-	register struct face *f1;
-	register struct face_g_plane *fg1;
 	f1 = (struct face *)BU_PTBL_GET(&ftab, i);
 
 	if (*f1->g.magic_p == NMG_FACE_G_SNURB_MAGIC) {
@@ -1676,12 +1875,59 @@ nmg_model_face_fuse(struct model *m, struct bu_list *vlfree, const struct bn_tol
 	}
 
 	fg1 = f1->g.plane_p;
+	if (!fg1) continue;
 
-	for (j = i-1; j >= 0; j--) {
-	    register struct face *f2;
-	    register struct face_g_plane *fg2;
+	/* Gather the earlier faces in neighboring buckets.  Planes
+	 * facing the other way only match when they pass within
+	 * tolerance of the origin, as nmg_two_face_fuse() compares
+	 * the plane distances directly.
+	 */
+	ncand = 0;
+	for (sense = 1; sense >= -1; sense -= 2) {
+	    if (sense < 0 && fabs(fg1->N[W]) > tol->dist)
+		break;
+	    for (dw = -1; dw <= 1; dw++) {
+		for (dz = -1; dz <= 1; dz++) {
+		    for (dy = -1; dy <= 1; dy++) {
+			for (dx = -1; dx <= 1; dx++) {
+			    k[0] = fuse_cell_of(fg1->N[W], size) + dw;
+			    k[1] = fuse_cell_of(sense * fg1->N[X], NMG_FUSE_NCELL) + dx;
+			    k[2] = fuse_cell_of(sense * fg1->N[Y], NMG_FUSE_NCELL) + dy;
+			    k[3] = fuse_cell_of(sense * fg1->N[Z], NMG_FUSE_NCELL) + dz;
+			    FUSE_CELLS_FOR(e, &cells, k) {
+				if ((size_t)e >= i || stamp[e] == i + 1)
+				    continue;
+				stamp[e] = i + 1;
+				cand[ncand++] = (size_t)e;
+			    }
+			}
+		    }
+		}
+	    }
+	}
+	VSUB2(diag, f1->max_pt, f1->min_pt);
+	if (MAGSQ(diag) < small_diag * small_diag) {
+	    for (dw = -1; dw <= 1; dw++) {
+		k[0] = fuse_cell_of(fg1->N[W], size) + dw;
+		k[1] = k[2] = k[3] = 0;
+		FUSE_CELLS_FOR(e, &small, k) {
+		    if ((size_t)e >= i || stamp[e] == i + 1)
+			continue;
+		    stamp[e] = i + 1;
+		    cand[ncand++] = (size_t)e;
+		}
+	    }
+	}
 
-	    f2 = (struct face *)BU_PTBL_GET(&ftab, j);
+	/* visit them in the order a scan of the whole table would */
+	if (ncand > 1)
+	    bu_sort(cand, ncand, sizeof(size_t), idx_rcomp, NULL);
+
+	for (c = 0; c < ncand; c++) {
+	    struct face *f2;
+	    struct face_g_plane *fg2;
+
+	    f2 = (struct face *)BU_PTBL_GET(&ftab, cand[c]);
 	    fg2 = f2->g.plane_p;
 	    if (!fg2) continue;
 
@@ -1691,6 +1937,11 @@ nmg_model_face_fuse(struct model *m, struct bu_list *vlfree, const struct bn_tol
 		total++;
 	}
     }
+
+    bu_free(cand, "nmg_model_face_fuse cand");
+    bu_free(stamp, "nmg_model_face_fuse stamp");
+    fuse_cells_free(&cells);
+    fuse_cells_free(&small);
     bu_ptbl_free(&ftab);
     if (nmg_debug & NMG_DEBUG_BASIC && total > 0)
 	bu_log("nmg_model_face_fuse: %d faces fused\n", total);
@@ -61,6 +61,7 @@
 
 #include "vmath.h"
 #include "bu/malloc.h"
+#include "bu/sort.h"
 #include "bn/mat.h"
 #include "bg/plane.h"
 #include "bv/plot3.h"
@@ -6384,6 +6385,205 @@ out:
 }
 
 
+/*
+ * Uniform grid over the bounding boxes of the faces of one shell.
+ *
+ * nmg_crackshells() used to offer every face of one shell to every
+ * face of the other, which is quadratic in the face count and
+ * dominates booleans on finely tessellated shells.  The grid lets
+ * each face of s1 visit only the faces of s2 whose (tolerance
+ * padded) extents share a cell with it.
+ *
+ * Cells are stored compactly: the faces in cell c are
+ * items[start[c]] through items[start[c+1]-1], given as indices
+ * into the face table the grid was built from.
+ */
+struct nmg_face_grid {
+    size_t dim[3];
+    point_t min;
+    vect_t inv_cell;	/* cells per unit length on each axis */
+    size_t *start;
+    size_t *items;
+    size_t *stamp;	/* query number that last returned each face */
+    size_t query;
+    size_t *hits;	/* faces returned by the current query */
+};
+
+
+#define NMG_FACE_GRID_MAXCELLS (1<<21)
+
+
+static int
+nmg_face_grid_cmp(const void *a, const void *b, void *UNUSED(context))
+{
+    size_t ia = *(const size_t *)a;
+    size_t ib = *(const size_t *)b;
+
+    if (ia < ib)
+	return -1;
+    return (ia > ib);
+}
+
+
+/* Convert the box [lo, hi] to an inclusive range of cells */
+static void
+nmg_face_grid_range(const struct nmg_face_grid *g, const point_t lo, const point_t hi, fastf_t pad, size_t cmin[3], size_t cmax[3])
+{
+    int i;
+
+    for (i = 0; i < 3; i++) {
+	fastf_t a = (lo[i] - pad - g->min[i]) * g->inv_cell[i];
+	fastf_t b = (hi[i] + pad - g->min[i]) * g->inv_cell[i];
+	fastf_t top = (fastf_t)(g->dim[i] - 1);
+
+	a = (a < 0.0) ? 0.0 : ((a > top) ? top : a);
+	b = (b < 0.0) ? 0.0 : ((b > top) ? top : b);
+	cmin[i] = (size_t)a;
+	cmax[i] = (size_t)b;
+    }
+}
+
+
+/**
+ * Bin the faces in 'faces' that touch the box [min, max] into a grid
+ * spanning that box.  Faces wholly outside the box are left out, as
+ * nmg_crackshells() would skip them anyway.
+ */
+static void
+nmg_face_grid_build(struct nmg_face_grid *g, const struct bu_ptbl *faces, const point_t min, const point_t max, const struct bn_tol *tol)
+{
+    size_t nfaces = (size_t)BU_PTBL_LEN(faces);
+    size_t ncells, c, j;
+    size_t *fill = NULL;
+    size_t x, y, z;
+    size_t cmin[3], cmax[3];
+    vect_t ext;
+    fastf_t maxext, vol, cell;
+    int i, k;
+
+    memset(g, 0, sizeof(struct nmg_face_grid));
+    VMOVE(g->min, min);
+    VSUB2(ext, max, min);
+    maxext = FMAX(ext[X], FMAX(ext[Y], ext[Z]));
+
+    /* Size the cells so there are about as many cells as faces,
+     * distributed over the axes the box actually extends along.
+     * A sheet of faces gets a 2D grid rather than a few thick slabs.
+     */
+    vol = 1.0;
+    k = 0;
+    for (i = 0; i < 3; i++) {
+	if (ext[i] > maxext * 1.0e-3 && ext[i] > tol->dist) {
+	    vol *= ext[i];
+	    k++;
+	}
+    }
+    cell = (k > 0 && nfaces > 0) ? pow(vol / (fastf_t)nfaces, 1.0 / (fastf_t)k) : 0.0;
+    ncells = 1;
+    for (i = 0; i < 3; i++) {
+	g->dim[i] = 1;
+	if (cell > SMALL_FASTF && ext[i] > maxext * 1.0e-3 && ext[i] > tol->dist) {
+	    fastf_t d = ceil(ext[i] / cell);
+	    g->dim[i] = (d < 1.0) ? 1 : ((d > 256.0) ? 256 : (size_t)d);
+	}
+	ncells *= g->dim[i];
+    }
+    while (ncells > NMG_FACE_GRID_MAXCELLS) {
+	ncells = 1;
+	for (i = 0; i < 3; i++) {
+	    g->dim[i] = (g->dim[i] + 1) / 2;
+	    ncells *= g->dim[i];
+	}
+    }
+    for (i = 0; i < 3; i++)
+	g->inv_cell[i] = (ext[i] > SMALL_FASTF) ? (fastf_t)g->dim[i] / ext[i] : 0.0;
+
+    g->start = (size_t *)bu_calloc(ncells + 1, sizeof(size_t), "nmg_face_grid start");
+    g->stamp = (size_t *)bu_calloc(nfaces + 1, sizeof(size_t), "nmg_face_grid stamp");
+    g->hits = (size_t *)bu_calloc(nfaces + 1, sizeof(size_t), "nmg_face_grid hits");
+
+    /* Two passes over the faces: count the entries in each cell, then
+     * fill them in.  Face boxes are padded by the distance tolerance,
+     * matching the V3RPP_DISJOINT_TOL() test the face intersector
+     * applies, so that no pair it would accept is missed.
+     */
+    for (k = 0; k < 2; k++) {
+	for (j = 0; j < nfaces; j++) {
+	    const struct face *fp = (const struct face *)BU_PTBL_GET(faces, j);
+
+	    if (V3RPP_DISJOINT_TOL(fp->min_pt, fp->max_pt, min, max, tol->dist))
+		continue;
+	    nmg_face_grid_range(g, fp->min_pt, fp->max_pt, tol->dist, cmin, cmax);
+	    for (z = cmin[Z]; z <= cmax[Z]; z++) {
+		for (y = cmin[Y]; y <= cmax[Y]; y++) {
+		    for (x = cmin[X]; x <= cmax[X]; x++) {
+			c = (z * g->dim[Y] + y) * g->dim[X] + x;
+			if (k == 0)
+			    g->start[c + 1]++;
+			else
+			    g->items[g->start[c] + fill[c]++] = j;
+		    }
+		}
+	    }
+	}
+	if (k == 0) {
+	    for (c = 0; c < ncells; c++)
+		g->start[c + 1] += g->start[c];
+	    g->items = (size_t *)bu_malloc((g->start[ncells] + 1) * sizeof(size_t), "nmg_face_grid items");
+	    fill = (size_t *)bu_calloc(ncells, sizeof(size_t), "nmg_face_grid fill");
+	}
+    }
+    bu_free(fill, "nmg_face_grid fill");
+}
+
+
+/**
+ * Find the faces of the grid whose cells overlap the box of face fp.
+ * The indices are returned in g->hits in ascending order, so callers
+ * visit them in the same sequence a full scan of the table would.
+ *
+ * Returns the number of faces found.
+ */
+static size_t
+nmg_face_grid_query(struct nmg_face_grid *g, const struct face *fp, const struct bn_tol *tol)
+{
+    size_t cmin[3], cmax[3];
+    size_t x, y, z, c, n, e;
+
+    g->query++;
+    n = 0;
+    nmg_face_grid_range(g, fp->min_pt, fp->max_pt, tol->dist, cmin, cmax);
+    for (z = cmin[Z]; z <= cmax[Z]; z++) {
+	for (y = cmin[Y]; y <= cmax[Y]; y++) {
+	    for (x = cmin[X]; x <= cmax[X]; x++) {
+		c = (z * g->dim[Y] + y) * g->dim[X] + x;
+		for (e = g->start[c]; e < g->start[c + 1]; e++) {
+		    size_t j = g->items[e];
+		    if (g->stamp[j] == g->query)
+			continue;
+		    g->stamp[j] = g->query;
+		    g->hits[n++] = j;
+		}
+	    }
+	}
+    }
+    if (n > 1)
+	bu_sort(g->hits, n, sizeof(size_t), nmg_face_grid_cmp, NULL);
+
+    return n;
+}
+
+
+static void
+nmg_face_grid_free(struct nmg_face_grid *g)
+{
+    bu_free(g->start, "nmg_face_grid start");
+    bu_free(g->items, "nmg_face_grid items");
+    bu_free(g->stamp, "nmg_face_grid stamp");
+    bu_free(g->hits, "nmg_face_grid hits");
+}
+
+
 /**
  * Split the components of two shells wherever they may intersect,
  * in preparation for performing boolean operations on the shells.
@@ -6399,7 +6599,8 @@ nmg_crackshells(struct shell *s1, struct shell *s2, struct bu_list *vlfree, cons
     struct faceuse *fu1, *fu2;
     struct face *fp1, *fp2;
     struct shell_a *sa1, *sa2;
-    size_t i, j;
+    struct nmg_face_grid grid;
+    size_t i, j, k, nhits;
     point_t isect_min_pt, isect_max_pt;
 
     if (UNLIKELY(nmg_debug & NMG_DEBUG_POLYSECT)) {
@@ -6464,6 +6665,8 @@ nmg_crackshells(struct shell *s1, struct shell *s2, struct bu_list *vlfree, cons
 	nmg_vshell(&s2->r_p->s_hd, s2->r_p);
     }
 
+    nmg_face_grid_build(&grid, &faces2, isect_min_pt, isect_max_pt, tol);
+
     for (i = 0; i < (size_t)BU_PTBL_LEN(&faces1); i++) {
 	fp1 = (struct face *)BU_PTBL_GET(&faces1, i);
 	NMG_CK_FACE(fp1);
@@ -6477,7 +6680,10 @@ nmg_crackshells(struct shell *s1, struct shell *s2, struct bu_list *vlfree, cons
 	    continue;
 	}
 
-	for (j = 0; j < (size_t)BU_PTBL_LEN(&faces2); j++) {
+	/* Only faces of s2 sharing a grid cell with fp1 can touch it */
+	nhits = nmg_face_grid_query(&grid, fp1, tol);
+	for (k = 0; k < nhits; k++) {
+	    j = grid.hits[k];
 	    fp2 = (struct face *)BU_PTBL_GET(&faces2, j);
 	    NMG_CK_FACE(fp2);
 	    fu2 = fp2->fu_p;
@@ -6529,6 +6735,7 @@ nmg_crackshells(struct shell *s1, struct shell *s2, struct bu_list *vlfree, cons
 	}
     }
 
+    nmg_face_grid_free(&grid);
     bu_ptbl_free(&faces1);
     bu_ptbl_free(&faces2);
 
@@ -0,0 +1,337 @@
+/*                       C R A C K . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libnmg/tests/crack.c
+ *
+ * Regression test for the candidate face search in nmg_crackshells().
+ *
+ * Two finely triangulated, gently curved sheets covering the same
+ * area are cracked against each other twice: once by
+ * nmg_crackshells(), which only intersects the face pairs its grid
+ * reports as close, and once by intersecting every face of one shell
+ * with every face of the other, as nmg_crackshells() used to.  The
+ * sheets cross along a curve, so both must split the shells, and
+ * both must leave the same vertices and edges behind.  A candidate
+ * search that drops a pair which actually intersects shows up as a
+ * missing vertex.
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bu/app.h"
+#include "bu/malloc.h"
+#include "bu/ptbl.h"
+#include "bu/sort.h"
+#include "bu/str.h"
+#include "bn/tol.h"
+#include "nmg.h"
+
+
+/* What is left of one shell after cracking */
+struct crack_result {
+    size_t nverts;
+    size_t nedges;
+    fastf_t *pts;	/* vertex coordinates, sorted */
+};
+
+
+/**
+ * Build an n by n grid of triangle pairs over the unit square, with
+ * height given by a low frequency wave.  'phase' selects one of two
+ * different surfaces, and also shifts the grid so the vertices of
+ * the two sheets do not line up.
+ */
+static struct shell *
+crack_mk_sheet(struct model *m, int n, int phase, const struct bn_tol *tol)
+{
+    struct nmgregion *r;
+    struct shell *s;
+    struct faceuse *fu;
+    struct vertex **verts;
+    struct vertex **vp[3];
+    struct bu_ptbl faces;
+    fastf_t shift;
+    int x, y;
+    size_t i;
+
+    r = nmg_mrsv(m);
+    s = BU_LIST_FIRST(shell, &r->s_hd);
+    verts = (struct vertex **)bu_calloc((n + 1) * (n + 1), sizeof(struct vertex *), "crack verts");
+
+    bu_ptbl_init(&faces, 64, "crack faces");
+    for (y = 0; y < n; y++) {
+	for (x = 0; x < n; x++) {
+	    struct vertex **v00 = &verts[y * (n + 1) + x];
+	    struct vertex **v10 = &verts[y * (n + 1) + x + 1];
+	    struct vertex **v01 = &verts[(y + 1) * (n + 1) + x];
+	    struct vertex **v11 = &verts[(y + 1) * (n + 1) + x + 1];
+
+	    vp[0] = v00;
+	    vp[1] = v10;
+	    vp[2] = v11;
+	    fu = nmg_cmface(s, vp, 3);
+	    bu_ptbl_ins(&faces, (long *)fu);
+
+	    vp[0] = v00;
+	    vp[1] = v11;
+	    vp[2] = v01;
+	    fu = nmg_cmface(s, vp, 3);
+	    bu_ptbl_ins(&faces, (long *)fu);
+	}
+    }
+
+    shift = phase ? 0.37 / (fastf_t)n : 0.0;
+    for (y = 0; y <= n; y++) {
+	for (x = 0; x <= n; x++) {
+	    point_t pt;
+
+	    pt[X] = (fastf_t)x / (fastf_t)n + shift;
+	    pt[Y] = (fastf_t)y / (fastf_t)n + shift;
+	    if (phase)
+		pt[Z] = 0.05 + 0.1 * (pt[X] - 0.5) + 0.05 * cos(M_PI * pt[Y]);
+	    else
+		pt[Z] = 0.1 * sin(M_PI * pt[X]) * sin(M_PI * pt[Y]);
+	    nmg_vertex_gv(verts[y * (n + 1) + x], pt);
+	}
+    }
+
+    for (i = 0; i < BU_PTBL_LEN(&faces); i++) {
+	fu = (struct faceuse *)BU_PTBL_GET(&faces, i);
+	if (nmg_fu_planeeqn(fu, tol) < 0)
+	    bu_exit(1, "crack: degenerate face in test sheet\n");
+    }
+    bu_ptbl_free(&faces);
+    bu_free(verts, "crack verts");
+
+    nmg_region_a(r, tol);
+    return s;
+}
+
+
+/**
+ * Intersect every face of s1 with every face of s2.  This is the
+ * face/face part of nmg_crackshells() before it had a candidate
+ * search, and serves as the reference.  The test sheets have no wire
+ * edges or lone vertices, so the rest of nmg_crackshells() has
+ * nothing to do for them.
+ */
+static void
+crack_brute(struct shell *s1, struct shell *s2, struct bu_list *vlfree, const struct bn_tol *tol)
+{
+    struct bu_ptbl faces1, faces2;
+    point_t isect_min_pt, isect_max_pt;
+    size_t i, j;
+
+    VMOVE(isect_min_pt, s1->sa_p->min_pt);
+    VMAX(isect_min_pt, s2->sa_p->min_pt);
+    VMOVE(isect_max_pt, s1->sa_p->max_pt);
+    VMIN(isect_max_pt, s2->sa_p->max_pt);
+
+    nmg_face_tabulate(&faces1, &s1->l.magic, vlfree);
+    nmg_face_tabulate(&faces2, &s2->l.magic, vlfree);
+
+    for (i = 0; i < BU_PTBL_LEN(&faces1); i++) {
+	struct face *fp1 = (struct face *)BU_PTBL_GET(&faces1, i);
+	struct faceuse *fu1 = fp1->fu_p;
+
+	if (fu1->orientation == OT_OPPOSITE)
+	    fu1 = fu1->fumate_p;
+	if (V3RPP_DISJOINT_TOL(fp1->min_pt, fp1->max_pt, isect_min_pt, isect_max_pt, tol->dist))
+	    continue;
+
+	for (j = 0; j < BU_PTBL_LEN(&faces2); j++) {
+	    struct face *fp2 = (struct face *)BU_PTBL_GET(&faces2, j);
+	    struct faceuse *fu2 = fp2->fu_p;
+
+	    if (fu2->orientation == OT_OPPOSITE)
+		fu2 = fu2->fumate_p;
+	    if (V3RPP_DISJOINT_TOL(fp2->min_pt, fp2->max_pt, isect_min_pt, isect_max_pt, tol->dist))
+		continue;
+	    nmg_isect_two_generic_faces(fu1, fu2, vlfree, tol);
+	}
+    }
+
+    bu_ptbl_free(&faces1);
+    bu_ptbl_free(&faces2);
+}
+
+
+static int
+crack_pt_cmp(const void *a, const void *b, void *UNUSED(context))
+{
+    const fastf_t *pa = (const fastf_t *)a;
+    const fastf_t *pb = (const fastf_t *)b;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+	if (pa[i] < pb[i])
+	    return -1;
+	if (pa[i] > pb[i])
+	    return 1;
+    }
+    return 0;
+}
+
+
+static void
+crack_tally(struct crack_result *res, struct shell *s, struct bu_list *vlfree)
+{
+    struct bu_ptbl tab;
+    size_t i;
+
+    nmg_edge_tabulate(&tab, &s->l.magic, vlfree);
+    res->nedges = BU_PTBL_LEN(&tab);
+    bu_ptbl_free(&tab);
+
+    nmg_vertex_tabulate(&tab, &s->l.magic, vlfree);
+    res->nverts = BU_PTBL_LEN(&tab);
+    res->pts = (fastf_t *)bu_calloc(res->nverts + 1, 3 * sizeof(fastf_t), "crack pts");
+    for (i = 0; i < res->nverts; i++) {
+	struct vertex *v = (struct vertex *)BU_PTBL_GET(&tab, i);
+	VMOVE(&res->pts[3 * i], v->vg_p->coord);
+    }
+    bu_ptbl_free(&tab);
+
+    bu_sort(res->pts, res->nverts, 3 * sizeof(fastf_t), crack_pt_cmp, NULL);
+}
+
+
+/**
+ * Crack two n by n sheets against each other, either with
+ * nmg_crackshells() or by brute force, and record what is left of
+ * each.  Returns -1 if cracking did not split the sheets.
+ */
+static int
+crack_run(int n, int brute, struct crack_result res[2], const struct bn_tol *tol)
+{
+    struct model *m;
+    struct shell *s1, *s2;
+    struct bu_list vlfree;
+    struct bu_ptbl verts;
+    size_t before;
+
+    BU_LIST_INIT(&vlfree);
+
+    m = nmg_mm();
+    s1 = crack_mk_sheet(m, n, 0, tol);
+    s2 = crack_mk_sheet(m, n, 1, tol);
+    nmg_rebound(m, tol);
+
+    nmg_vertex_tabulate(&verts, &s1->l.magic, &vlfree);
+    before = BU_PTBL_LEN(&verts);
+    bu_ptbl_free(&verts);
+
+    if (brute)
+	crack_brute(s1, s2, &vlfree, tol);
+    else
+	nmg_crackshells(s1, s2, &vlfree, tol);
+
+    crack_tally(&res[0], s1, &vlfree);
+    crack_tally(&res[1], s2, &vlfree);
+
+    bu_log("crack: %d x %d grid, %s, %zu -> %zu vertices, %zu edges in s1, %zu vertices, %zu edges in s2\n",
+	   n, n, brute ? "all pairs" : "nmg_crackshells", before,
+	   res[0].nverts, res[0].nedges, res[1].nverts, res[1].nedges);
+
+    nmg_km(m);
+
+    /* the sheets cross, so cracking must have added vertices to s1 */
+    if (res[0].nverts <= before) {
+	bu_log("crack: the shells were not split\n");
+	return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+crack_compare(const struct crack_result *a, const struct crack_result *b, const char *name, const struct bn_tol *tol)
+{
+    size_t i;
+
+    if (a->nverts != b->nverts || a->nedges != b->nedges) {
+	bu_log("crack: %s has %zu vertices, %zu edges, expected %zu vertices, %zu edges\n",
+	       name, a->nverts, a->nedges, b->nverts, b->nedges);
+	return 1;
+    }
+    for (i = 0; i < a->nverts; i++) {
+	if (!VNEAR_EQUAL(&a->pts[3 * i], &b->pts[3 * i], tol->dist)) {
+	    bu_log("crack: %s vertex %zu at (%g %g %g), expected (%g %g %g)\n", name, i,
+		   V3ARGS(&a->pts[3 * i]), V3ARGS(&b->pts[3 * i]));
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+
+int
+main(int argc, char **argv)
+{
+    struct bn_tol tol = BN_TOL_INIT_TOL;
+    struct crack_result fast[2], ref[2];
+    int n = 24;
+    int ret = 0;
+    int i;
+
+    // Normally this file is part of nmg_test, so only set this if it looks like
+    // the program name is still unset.
+    if (bu_getprogname()[0] == '\0')
+	bu_setprogname(argv[0]);
+
+    if (argc > 2) {
+	bu_exit(1, "Usage: %s [grid_size]\n", argv[0]);
+    }
+    if (argc == 2) {
+	n = atoi(argv[1]);
+	if (n < 2)
+	    bu_exit(1, "crack: grid size must be at least 2\n");
+    }
+
+    if (crack_run(n, 0, fast, &tol) < 0 || crack_run(n, 1, ref, &tol) < 0)
+	bu_exit(1, "crack: invalid result\n");
+
+    ret |= crack_compare(&fast[0], &ref[0], "s1", &tol);
+    ret |= crack_compare(&fast[1], &ref[1], "s2", &tol);
+
+    for (i = 0; i < 2; i++) {
+	bu_free(fast[i].pts, "crack pts");
+	bu_free(ref[i].pts, "crack pts");
+    }
+
+    if (ret)
+	bu_log("crack: nmg_crackshells() result differs from intersecting all face pairs\n");
+
+    return ret;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,363 @@
+/*                        F U S E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libnmg/tests/fuse.c
+ *
+ * Regression test for the cell hash in nmg_vertex_fuse().
+ *
+ * A grid of triangles is built with every triangle owning its own
+ * three vertices, each a slightly jittered copy of a grid point.  The
+ * grid points sit on cell boundaries, so the copies of one point land
+ * in different cells but stay within tolerance of each other.  Some
+ * points also get an extra copy pushed out to nearly a full tolerance
+ * away, so whether it fuses depends on which copy absorbs the others
+ * first.
+ *
+ * The same model is fused twice: once by nmg_vertex_fuse(), and once
+ * by the sorted sweep over every later vertex that nmg_vertex_fuse()
+ * used before it hashed vertices into cells.  Both must leave the same
+ * number of vertices, and every triangle corner must end up on a
+ * vertex at the same place.
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bu/app.h"
+#include "bu/malloc.h"
+#include "bu/ptbl.h"
+#include "bu/sort.h"
+#include "bu/str.h"
+#include "bn/tol.h"
+#include "nmg.h"
+
+
+/* What is left of the model after fusing */
+struct vfuse_result {
+    int count;		/* fuses performed */
+    size_t nverts;	/* vertices left */
+    size_t nfaces;
+    fastf_t *corners;	/* three corners of each face, in creation order */
+};
+
+
+/* Small deterministic generator, so both runs see the same model */
+static fastf_t
+vfuse_rand(unsigned long *state)
+{
+    *state = *state * 6364136223846793005UL + 1442695040888963407UL;
+    return (fastf_t)((*state >> 33) & 0xffffff) / (fastf_t)0x1000000;
+}
+
+
+/* Grid point x, y.  Every coordinate is a whole number of distance
+ * tolerances, which is where nmg_vertex_fuse() puts cell boundaries.
+ */
+static void
+vfuse_grid_pt(point_t pt, int x, int y, const struct bn_tol *tol)
+{
+    pt[X] = 10.0 * x * tol->dist;
+    pt[Y] = 10.0 * y * tol->dist;
+    pt[Z] = 10.0 * ((x * 3 + y * 5) % 7) * tol->dist;
+}
+
+
+/* Make a triangle with three new vertices near the given points */
+static struct faceuse *
+vfuse_mk_tri(struct shell *s, point_t pts[3], fastf_t jitter, unsigned long *state, const struct bn_tol *tol)
+{
+    struct vertex *verts[3] = {NULL, NULL, NULL};
+    struct vertex **vp[3];
+    struct faceuse *fu;
+    int i, j;
+
+    for (i = 0; i < 3; i++)
+	vp[i] = &verts[i];
+    fu = nmg_cmface(s, vp, 3);
+
+    for (i = 0; i < 3; i++) {
+	point_t pt;
+	for (j = 0; j < 3; j++)
+	    pt[j] = pts[i][j] + (2.0 * vfuse_rand(state) - 1.0) * jitter * tol->dist;
+	nmg_vertex_gv(verts[i], pt);
+    }
+
+    return fu;
+}
+
+
+static struct model *
+vfuse_mk_model(int n, struct bu_ptbl *faces, const struct bn_tol *tol)
+{
+    struct model *m;
+    struct nmgregion *r;
+    struct shell *s;
+    unsigned long state = 1;
+    point_t pts[3];
+    int x, y;
+
+    m = nmg_mm();
+    r = nmg_mrsv(m);
+    s = BU_LIST_FIRST(shell, &r->s_hd);
+
+    bu_ptbl_init(faces, 64, "vfuse faces");
+    for (y = 0; y < n; y++) {
+	for (x = 0; x < n; x++) {
+	    /* Jitter each axis by up to a quarter tolerance, so any two
+	     * copies of a point are within 0.87 tolerance of each other
+	     */
+	    vfuse_grid_pt(pts[0], x, y, tol);
+	    vfuse_grid_pt(pts[1], x + 1, y, tol);
+	    vfuse_grid_pt(pts[2], x + 1, y + 1, tol);
+	    bu_ptbl_ins(faces, (long *)vfuse_mk_tri(s, pts, 0.25, &state, tol));
+
+	    vfuse_grid_pt(pts[1], x + 1, y + 1, tol);
+	    vfuse_grid_pt(pts[2], x, y + 1, tol);
+	    bu_ptbl_ins(faces, (long *)vfuse_mk_tri(s, pts, 0.25, &state, tol));
+
+	    /* A stray triangle with a corner 0.9 tolerance from the grid
+	     * point along a diagonal, which only fuses with some copies
+	     */
+	    if ((x + y) % 3 == 0) {
+		vfuse_grid_pt(pts[0], x, y, tol);
+		pts[0][X] += 0.9 * tol->dist / sqrt(3.0);
+		pts[0][Y] -= 0.9 * tol->dist / sqrt(3.0);
+		pts[0][Z] += 0.9 * tol->dist / sqrt(3.0);
+		VSET(pts[1], pts[0][X] + 3.0 * tol->dist, pts[0][Y] + 3.5 * tol->dist, pts[0][Z] + 100.0 * tol->dist);
+		VSET(pts[2], pts[0][X] + 5.5 * tol->dist, pts[0][Y] + 1.5 * tol->dist, pts[0][Z] + 100.0 * tol->dist);
+		bu_ptbl_ins(faces, (long *)vfuse_mk_tri(s, pts, 0.0, &state, tol));
+	    }
+	}
+    }
+
+    return m;
+}
+
+
+/* compare function for bu_sort, as used by nmg_vertex_fuse() */
+static int
+vfuse_x_comp(const void *p1, const void *p2, void *UNUSED(arg))
+{
+    fastf_t i, j;
+
+    i = (*((struct vertex **)p1))->vg_p->coord[X];
+    j = (*((struct vertex **)p2))->vg_p->coord[X];
+
+    if (EQUAL(i, j))
+	return 0;
+    else if (i > j)
+	return 1;
+    return -1;
+}
+
+
+/**
+ * Fuse the vertices of m by sweeping them in X order and testing each
+ * against every later vertex until the X gap exceeds tolerance.  This
+ * is what nmg_vertex_fuse() did before it had a cell hash, and serves
+ * as the reference.  Returns the number of fuses, and counts those
+ * whose two vertices were in different cells in 'straddles'.
+ */
+static int
+vfuse_brute(struct model *m, struct bu_list *vlfree, const struct bn_tol *tol, int *straddles)
+{
+    struct bu_ptbl t;
+    size_t i, j;
+    int count = 0;
+
+    nmg_vertex_tabulate(&t, &m->magic, vlfree);
+    bu_sort(BU_PTBL_BASEADDR(&t), BU_PTBL_LEN(&t), sizeof(long *), vfuse_x_comp, NULL);
+
+    *straddles = 0;
+    for (i = 0; i < BU_PTBL_LEN(&t); i++) {
+	struct vertex *vi = (struct vertex *)BU_PTBL_GET(&t, i);
+	if (!vi || !vi->vg_p)
+	    continue;
+
+	for (j = i + 1; j < BU_PTBL_LEN(&t); j++) {
+	    struct vertex *vj = (struct vertex *)BU_PTBL_GET(&t, j);
+	    fastf_t abx, aby, abz;
+	    int k;
+
+	    if (!vj || !vj->vg_p)
+		continue;
+
+	    abx = vi->vg_p->coord[X] - vj->vg_p->coord[X];
+	    if (abx * abx > tol->dist_sq)
+		break;
+	    aby = vi->vg_p->coord[Y] - vj->vg_p->coord[Y];
+	    abz = vi->vg_p->coord[Z] - vj->vg_p->coord[Z];
+	    if (abx * abx + aby * aby + abz * abz > tol->dist_sq)
+		continue;
+
+	    for (k = X; k <= Z; k++) {
+		if (floor(vi->vg_p->coord[k] / tol->dist) != floor(vj->vg_p->coord[k] / tol->dist)) {
+		    (*straddles)++;
+		    break;
+		}
+	    }
+
+	    nmg_jv(vi, vj);
+	    BU_PTBL_SET(&t, j, NULL);
+	    count++;
+	}
+    }
+
+    bu_ptbl_free(&t);
+    return count;
+}
+
+
+static void
+vfuse_tally(struct vfuse_result *res, struct model *m, struct bu_ptbl *faces, struct bu_list *vlfree)
+{
+    struct bu_ptbl tab;
+    size_t i;
+
+    nmg_vertex_tabulate(&tab, &m->magic, vlfree);
+    res->nverts = BU_PTBL_LEN(&tab);
+    bu_ptbl_free(&tab);
+
+    res->nfaces = BU_PTBL_LEN(faces);
+    res->corners = (fastf_t *)bu_calloc(res->nfaces * 3, 3 * sizeof(fastf_t), "vfuse corners");
+    for (i = 0; i < res->nfaces; i++) {
+	struct faceuse *fu = (struct faceuse *)BU_PTBL_GET(faces, i);
+	struct loopuse *lu = BU_LIST_FIRST(loopuse, &fu->lu_hd);
+	struct edgeuse *eu;
+	size_t c = 0;
+
+	NMG_CK_FACEUSE(fu);
+	for (BU_LIST_FOR(eu, edgeuse, &lu->down_hd)) {
+	    if (c < 3)
+		VMOVE(&res->corners[(i * 3 + c) * 3], eu->vu_p->v_p->vg_p->coord);
+	    c++;
+	}
+	if (c != 3)
+	    bu_exit(1, "fuse: face %zu has %zu corners after fusing\n", i, c);
+    }
+}
+
+
+static int
+vfuse_run(int n, int brute, struct vfuse_result *res, int *straddles, const struct bn_tol *tol)
+{
+    struct model *m;
+    struct bu_ptbl faces;
+    struct bu_list vlfree;
+    struct bu_ptbl verts;
+    size_t before;
+
+    BU_LIST_INIT(&vlfree);
+
+    m = vfuse_mk_model(n, &faces, tol);
+
+    nmg_vertex_tabulate(&verts, &m->magic, &vlfree);
+    before = BU_PTBL_LEN(&verts);
+    bu_ptbl_free(&verts);
+
+    *straddles = 0;
+    if (brute)
+	res->count = vfuse_brute(m, &vlfree, tol, straddles);
+    else
+	res->count = nmg_vertex_fuse(&m->magic, &vlfree, tol);
+
+    vfuse_tally(res, m, &faces, &vlfree);
+
+    bu_log("fuse: %d x %d grid, %s, %zu -> %zu vertices, %d fuses\n",
+	   n, n, brute ? "sorted sweep" : "nmg_vertex_fuse", before, res->nverts, res->count);
+
+    bu_ptbl_free(&faces);
+    nmg_km(m);
+
+    if (res->nverts >= before) {
+	bu_log("fuse: no vertices were fused\n");
+	return -1;
+    }
+
+    return 0;
+}
+
+
+int
+main(int argc, char **argv)
+{
+    struct bn_tol tol = BN_TOL_INIT_TOL;
+    struct vfuse_result fast, ref;
+    int straddles, unused;
+    int n = 40;
+    int ret = 0;
+    size_t i;
+
+    // Normally this file is part of nmg_test, so only set this if it looks like
+    // the program name is still unset.
+    if (bu_getprogname()[0] == '\0')
+	bu_setprogname(argv[0]);
+
+    if (argc > 2) {
+	bu_exit(1, "Usage: %s [grid_size]\n", argv[0]);
+    }
+    if (argc == 2) {
+	n = atoi(argv[1]);
+	if (n < 2)
+	    bu_exit(1, "fuse: grid size must be at least 2\n");
+    }
+
+    if (vfuse_run(n, 0, &fast, &unused, &tol) < 0 || vfuse_run(n, 1, &ref, &straddles, &tol) < 0)
+	bu_exit(1, "fuse: invalid result\n");
+
+    /* the test is only meaningful if fused pairs crossed cell boundaries */
+    if (straddles == 0) {
+	bu_log("fuse: no fused pair crossed a cell boundary\n");
+	ret = 1;
+    }
+
+    if (fast.count != ref.count || fast.nverts != ref.nverts) {
+	bu_log("fuse: nmg_vertex_fuse() made %d fuses leaving %zu vertices, expected %d fuses leaving %zu\n",
+	       fast.count, fast.nverts, ref.count, ref.nverts);
+	ret = 1;
+    }
+    for (i = 0; !ret && i < fast.nfaces * 3; i++) {
+	if (!VEQUAL(&fast.corners[i * 3], &ref.corners[i * 3])) {
+	    bu_log("fuse: face %zu corner %zu at (%g %g %g), expected (%g %g %g)\n", i / 3, i % 3,
+		   V3ARGS(&fast.corners[i * 3]), V3ARGS(&ref.corners[i * 3]));
+	    ret = 1;
+	}
+    }
+
+    bu_free(fast.corners, "vfuse corners");
+    bu_free(ref.corners, "vfuse corners");
+
+    if (ret)
+	bu_log("fuse: nmg_vertex_fuse() result differs from the sorted sweep\n");
+
+    return ret;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
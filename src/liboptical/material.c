@@ -111,6 +111,16 @@ try_load(const char *path, const char *material)
     if (OPTICAL_DEBUG&OPTICAL_DEBUG_MATERIAL)
 	bu_log("%s_mfuncs table found\n", material);
 
+    /* tables built before mf_render_batch existed use a shorter
+     * struct mfuncs, so stepping through them would misread every
+     * entry after the first.
+     */
+    if (shader_mfuncs && shader_mfuncs->mf_magic == MF_MAGIC_V1) {
+	bu_log("%s: shader library predates batched shading and must be rebuilt\n", path);
+	bu_dlclose(handle);
+	return (struct mfuncs *)NULL;
+    }
+
     /* make sure the shader we were looking for is in the mfuncs table */
     for (mfp = shader_mfuncs; mfp && mfp->mf_name != (char *)NULL; mfp++) {
 	RT_CK_MF(mfp);
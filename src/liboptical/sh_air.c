@@ -79,22 +79,22 @@ static void air_free(void *cp);
 
 struct mfuncs air_mfuncs[] = {
     {MF_MAGIC,	"airtest",	0,		MFI_HIT, MFF_PROC,
-     air_setup,	airtest_render,	air_print,	air_free },
+     air_setup,	airtest_render,	air_print,	air_free,	0 },
 
     {MF_MAGIC,	"air",		0,		MFI_HIT, MFF_PROC,
-     air_setup,	air_render,	air_print,	air_free },
+     air_setup,	air_render,	air_print,	air_free,	0 },
 
     {MF_MAGIC,	"fog",		0,		MFI_HIT, MFF_PROC,
-     air_setup,	air_render,	air_print,	air_free },
+     air_setup,	air_render,	air_print,	air_free,	0 },
 
     {MF_MAGIC,	"emist",	0,		MFI_HIT, MFF_PROC,
-     air_setup,	emist_render,	air_print,	air_free },
+     air_setup,	emist_render,	air_print,	air_free,	0 },
 
     {MF_MAGIC,	"tmist",	0,		MFI_HIT, MFF_PROC,
-     air_setup,	tmist_render,	air_print,	air_free },
+     air_setup,	tmist_render,	air_print,	air_free,	0 },
 
     {0,		(char *)0,	0,		0,	0,
-     0,		0,		0,		0 }
+     0,		0,		0,		0,	0 }
 };
 
 static void
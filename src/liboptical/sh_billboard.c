@@ -582,10 +582,10 @@ bbd_render(struct application *ap, const struct partition *pp, struct shadework
  */
 struct mfuncs bbd_mfuncs[] = {
     {MF_MAGIC,	"bbd",	0,	MFI_NORMAL|MFI_HIT|MFI_UV,	0,
-     bbd_setup,	bbd_render,	bbd_print,	bbd_free },
+     bbd_setup,	bbd_render,	bbd_print,	bbd_free,	0 },
 
     {0,		(char *)0,	0,		0,		0,
-     0,		0,		0,		0 }
+     0,		0,		0,		0,	0 }
 };
 
 
@@ -88,10 +88,10 @@ static void brdf_free(void *cp);
 
 struct mfuncs brdf_mfuncs[] = {
     {MF_MAGIC,	"brdf",		0,		MFI_NORMAL|MFI_LIGHT,	0,
-     brdf_setup,	brdf_render,	brdf_print,	brdf_free },
+     brdf_setup,	brdf_render,	brdf_print,	brdf_free,	0 },
 
     {0,		(char *)0,	0,		0,	0,
-     0,		0,		0,		0 }
+     0,		0,		0,		0,	0 }
 };
 
 
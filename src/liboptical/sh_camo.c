@@ -119,13 +119,13 @@ static void camo_free(void *cp);
 
 struct mfuncs camo_mfuncs[] = {
     {MF_MAGIC,	"camo",		0,		MFI_HIT,	0,
-     camo_setup,	camo_render,	camo_print,	camo_free },
+     camo_setup,	camo_render,	camo_print,	camo_free,	0 },
 
     {MF_MAGIC,	"marble",		0,		MFI_HIT,	0,
-     marble_setup,	marble_render,	camo_print,	camo_free },
+     marble_setup,	marble_render,	camo_print,	camo_free,	0 },
 
     {0,		(char *)0,	0,		0,		0,
-     0,		0,		0,		0 }
+     0,		0,		0,		0,	0 }
 };
 
 
@@ -54,10 +54,10 @@ static void cloud_free(void *cp);
 
 struct mfuncs cloud_mfuncs[] = {
     {MF_MAGIC,	"cloud",	0,		MFI_UV,		0,
-     cloud_setup,	cloud_render,	cloud_print,	cloud_free },
+     cloud_setup,	cloud_render,	cloud_print,	cloud_free,	0 },
 
     {0,		(char *)0,	0,		0,		0,
-     0,		0,		0,		0 }
+     0,		0,		0,		0,	0 }
 };
 
 
@@ -85,16 +85,16 @@ static double beckmann(double a, double m2);
 
 struct mfuncs cook_mfuncs[] = {
     {MF_MAGIC,	"cook",		0,		MFI_NORMAL|MFI_LIGHT,	0,
-     cook_setup,	cook_render,	cook_print,	cook_free },
+     cook_setup,	cook_render,	cook_print,	cook_free,	0 },
 
     {MF_MAGIC,	"cmirror",	0,		MFI_NORMAL|MFI_LIGHT,	0,
-     cmirror_setup,	cook_render,	cook_print,	cook_free },
+     cmirror_setup,	cook_render,	cook_print,	cook_free,	0 },
 
     {MF_MAGIC,	"cglass",	0,		MFI_NORMAL|MFI_LIGHT,	0,
-     cglass_setup,	cook_render,	cook_print,	cook_free },
+     cglass_setup,	cook_render,	cook_print,	cook_free,	0 },
 
     {0,		(char *)0,	0,		0,	0,
-     0,		0,		0,		0 }
+     0,		0,		0,		0,	0 }
 };
 
 
@@ -81,10 +81,10 @@ static void fbm_free(void *cp);
 
 struct mfuncs fbm_mfuncs[] = {
     {MF_MAGIC,	"bump_fbm",		0,	MFI_NORMAL|MFI_HIT|MFI_UV,	0,
-     fbm_setup,	 fbm_render,	fbm_print,	fbm_free },
+     fbm_setup,	 fbm_render,	fbm_print,	fbm_free,	0 },
 
     {0,		(char*)0,		0,				0,	0,
-     0,		0,			0,				0}
+     0,		0,			0,				0,	0}
 };
 
 
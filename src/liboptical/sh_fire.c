@@ -169,10 +169,10 @@ static void fire_free(void *cp);
  */
 struct mfuncs fire_mfuncs[] = {
     {MF_MAGIC,	"fire",		0,		MFI_HIT,	0,
-     fire_setup,	fire_render,	fire_print,	fire_free },
+     fire_setup,	fire_render,	fire_print,	fire_free,	0 },
 
     {0,		(char *)0,	0,		0,		0,
-     0,		0,		0,		0 }
+     0,		0,		0,		0,	0 }
 };
 
 
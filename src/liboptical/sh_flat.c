@@ -120,9 +120,9 @@ struct bu_structparse flat_parse_tab[] = {
  */
 struct mfuncs flat_mfuncs[] = {
     {MF_MAGIC,	"flat",		0,		MFI_HIT,	0, /* !!! try to set to 0 */
-     flat_setup,	flat_render,	flat_print,	flat_free },
+     flat_setup,	flat_render,	flat_print,	flat_free,	0 },
     {0,		(char *)0,	0,		0,		0,
-     0,		0,		0,		0 }
+     0,		0,		0,		0,	0 }
 };
 
 
@@ -141,10 +141,10 @@ static void gauss_free(void *cp);
  */
 struct mfuncs gauss_mfuncs[] = {
     {MF_MAGIC,	"gauss",	0,		MFI_NORMAL|MFI_HIT|MFI_UV,	0,
-     gauss_setup,	gauss_render,	gauss_print,	gauss_free },
+     gauss_setup,	gauss_render,	gauss_print,	gauss_free,	0 },
 
     {0,		(char *)0,	0,		0,		0,
-     0,		0,		0,		0 }
+     0,		0,		0,		0,	0 }
 };
 
 
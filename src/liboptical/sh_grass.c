@@ -230,8 +230,8 @@ static void grass_free(void *cp);
  * values for the parameters.
  */
 struct mfuncs grass_mfuncs[] = {
-    {MF_MAGIC,	"grass",	0,	MFI_NORMAL|MFI_HIT|MFI_UV,	MFF_PROC,	grass_setup,	grass_render,	grass_print,	grass_free },
-    {0,		(char *)0,	0,	0,				0,		0,		0,		0,		0 }
+    {MF_MAGIC,	"grass",	0,	MFI_NORMAL|MFI_HIT|MFI_UV,	MFF_PROC,	grass_setup,	grass_render,	grass_print,	grass_free,	0 },
+    {0,		(char *)0,	0,	0,				0,		0,		0,		0,		0,	0 }
 };
 
 
@@ -54,14 +54,15 @@ static void light_pt_set(const struct bu_structparse *, const char *, void *, co
 
 static int light_setup(struct region *rp, struct bu_vls *matparm, void **dpp, const struct mfuncs *mfp, struct rt_i *rtip);
 static int light_render(struct application *ap, const struct partition *pp, struct shadework *swp, void *dp);
+static int light_render_batch(struct shade_batch *sbp, const size_t *idx, size_t n, void *dp);
 static void light_print(register struct region *rp, void *dp);
 static void light_free(void *cp);
 
 
 /** callback registration table for this shader in optical_shader_init() */
 struct mfuncs light_mfuncs[] = {
-    {MF_MAGIC,	"light",	0,		MFI_NORMAL,	0,     light_setup,	light_render,	light_print,	light_free },
-    {0,		(char *)0,	0,		0,		0,     0,		0,		0,		0 }
+    {MF_MAGIC,	"light",	0,		MFI_NORMAL,	0,     light_setup,	light_render,	light_print,	light_free,	light_render_batch },
+    {0,		(char *)0,	0,		0,		0,     0,		0,		0,		0,	0 }
 };
 
 
@@ -287,6 +288,56 @@ light_render(struct application *ap, const struct partition *pp, struct shadewor
 }
 
 
+/*
+ * Batched light_render(), one pass over the normal and ray direction
+ * columns.
+ */
+static int
+light_render_batch(struct shade_batch *sbp, const size_t *idx, size_t n, void *dp)
+{
+    register struct light_specific *lsp = (struct light_specific *)dp;
+    fastf_t *f = sbp->sb_tmp[0];
+    size_t k;
+
+    RT_CK_LIGHT(lsp);
+
+    for (k = 0; k < n; k++) {
+	size_t j = idx[k];
+	fastf_t nx = sbp->sb_norm[X][j];
+	fastf_t ny = sbp->sb_norm[Y][j];
+	fastf_t nz = sbp->sb_norm[Z][j];
+	fastf_t c, beam;
+
+	/* Provide cosine/2 shading, to make light look round */
+	c = -(nx*sbp->sb_dir[X][j] + ny*sbp->sb_dir[Y][j] + nz*sbp->sb_dir[Z][j]) * 0.5;
+	if (c < 0)
+	    c = 0;
+
+	/* See if surface normal falls in light beam direction */
+	beam = lsp->lt_aim[X]*nx + lsp->lt_aim[Y]*ny + lsp->lt_aim[Z]*nz;
+	f[k] = (beam < lsp->lt_cosangle ? c : c + 0.5) * lsp->lt_fraction;
+    }
+
+    for (k = 0; k < n; k++) {
+	size_t j = idx[k];
+
+	if (!PM_Activated) {
+	    VSCALE(sbp->sb_sw[j]->sw_color, lsp->lt_color, f[k]);
+	}
+
+	if (optical_debug & OPTICAL_DEBUG_LIGHT) {
+	    bu_log("light %s xy=%d, %d temp=%g\n",
+		   sbp->sb_pp[j]->pt_regionp->reg_name,
+		   sbp->sb_ap[j]->a_x, sbp->sb_ap[j]->a_y,
+		   sbp->sb_sw[j]->sw_temperature);
+	}
+	sbp->sb_status[j] = 1;
+    }
+
+    return 1;
+}
+
+
 /**
  * preparation routine for light_gen_sample_pts() that sets up a
  * sample point ray.
@@ -46,9 +46,9 @@ static void sh_null_free(void *cp);
  * four shader functions *must* be defined, even if they do nothing.
  */
 struct mfuncs null_mfuncs[] = {
-    {MF_MAGIC,	"null",		0,		MFI_HIT,	0, sh_null_setup,	sh_null_render,	sh_null_print,	sh_null_free },
-    {MF_MAGIC,	"invisible",	0,		MFI_HIT,	0, sh_null_setup,	sh_null_render,	sh_null_print,	sh_null_free },
-    {0,		(char *)0,	0,		0,		0, 0,		0,		0,		0 }
+    {MF_MAGIC,	"null",		0,		MFI_HIT,	0, sh_null_setup,	sh_null_render,	sh_null_print,	sh_null_free,	0 },
+    {MF_MAGIC,	"invisible",	0,		MFI_HIT,	0, sh_null_setup,	sh_null_render,	sh_null_print,	sh_null_free,	0 },
+    {0,		(char *)0,	0,		0,		0, 0,		0,		0,		0,	0 }
 };
 
 
@@ -104,8 +104,8 @@ extern "C" {
  * values for the parameters.
  */
 struct mfuncs osl_mfuncs[] = {
-    {MF_MAGIC,	"osl",	0,	MFI_NORMAL|MFI_HIT|MFI_UV,	0,     osl_setup,	osl_render,	osl_print,	osl_free },
-    {0,		(char *)0,	0,		0,		0,     0,		0,		0,		0 }
+    {MF_MAGIC,	"osl",	0,	MFI_NORMAL|MFI_HIT|MFI_UV,	0,     osl_setup,	osl_render,	osl_print,	osl_free,	0 },
+    {0,		(char *)0,	0,		0,		0,     0,		0,		0,		0,	0 }
 };
 
 int
@@ -72,17 +72,18 @@ static int phong_setup(register struct region *rp, struct bu_vls *matparm, void
 static int mirror_setup(register struct region *rp, struct bu_vls *matparm, void **dpp, const struct mfuncs *mfp, struct rt_i *rtip);
 static int glass_setup(register struct region *rp, struct bu_vls *matparm, void **dpp, const struct mfuncs *mfp, struct rt_i *rtip);
 static int phong_render(register struct application *ap, const struct partition *pp, struct shadework *swp, void *dp);
+static int phong_render_batch(struct shade_batch *sbp, const size_t *idx, size_t n, void *dp);
 static void phong_print(register struct region *rp, void *dp);
 static void phong_free(void *cp);
 
 /* This can't be const, so the forward link can be written later */
 struct mfuncs phg_mfuncs[] = {
-    {MF_MAGIC,	"default",	0,		MFI_NORMAL,	0,     phong_setup,	phong_render,	phong_print,	phong_free },
-    {MF_MAGIC,	"phong",	0,		MFI_NORMAL,	0,     phong_setup,	phong_render,	phong_print,	phong_free },
-    {MF_MAGIC,	"plastic",	0,		MFI_NORMAL,	0,     phong_setup,	phong_render,	phong_print,	phong_free },
-    {MF_MAGIC,	"mirror",	0,		MFI_NORMAL,	0,     mirror_setup,	phong_render,	phong_print,	phong_free },
-    {MF_MAGIC,	"glass",	0,		MFI_NORMAL,	0,     glass_setup,	phong_render,	phong_print,	phong_free },
-    {0,		(char *)0,	0,		0,	0,     0,		0,		0,		0 }
+    {MF_MAGIC,	"default",	0,		MFI_NORMAL,	0,     phong_setup,	phong_render,	phong_print,	phong_free,	phong_render_batch },
+    {MF_MAGIC,	"phong",	0,		MFI_NORMAL,	0,     phong_setup,	phong_render,	phong_print,	phong_free,	phong_render_batch },
+    {MF_MAGIC,	"plastic",	0,		MFI_NORMAL,	0,     phong_setup,	phong_render,	phong_print,	phong_free,	phong_render_batch },
+    {MF_MAGIC,	"mirror",	0,		MFI_NORMAL,	0,     mirror_setup,	phong_render,	phong_print,	phong_free,	phong_render_batch },
+    {MF_MAGIC,	"glass",	0,		MFI_NORMAL,	0,     glass_setup,	phong_render,	phong_print,	phong_free,	phong_render_batch },
+    {0,		(char *)0,	0,		0,	0,     0,		0,		0,		0,	0 }
 };
 
 
@@ -443,6 +444,156 @@ phong_render(register struct application *ap, const struct partition *pp, struct
 }
 
 
+/*
+ * Batched phong_render().  The ambient, diffuse and specular terms
+ * are evaluated column by column over the whole batch; light
+ * visibility and the reflection/refraction recursion are still done
+ * one point at a time.  Points that only want transmission, and
+ * everything while photon mapping is active, go through
+ * phong_render().
+ */
+static int
+phong_render_batch(struct shade_batch *sbp, const size_t *idx, size_t n, void *dp)
+{
+    struct phong_specific *ps =
+	(struct phong_specific *)dp;
+    fastf_t **t = sbp->sb_tmp;
+    fastf_t *nx = t[0], *ny = t[1], *nz = t[2];		/* normal */
+    fastf_t *dx = t[3], *dy = t[4], *dz = t[5];		/* ray dir */
+    fastf_t *mr = t[6], *mg = t[7], *mb = t[8];		/* material color */
+    fastf_t *cr = t[9], *cg = t[10], *cb = t[11];	/* shaded color */
+    fastf_t *lx = t[12], *ly = t[13], *lz = t[14];	/* to light */
+    fastf_t *ir = t[15], *ig = t[16], *ib = t[17];	/* light color * intensity */
+    fastf_t *lf = t[18];				/* visible fraction */
+    size_t *sel = sbp->sb_sel;
+    size_t i, k, m;
+    size_t nlights;
+
+    if (!ps || ps->magic != PL_MAGIC)
+	bu_bomb("phong_render_batch: bad magic\n");
+
+    if (optical_debug&OPTICAL_DEBUG_SHADE)
+	bu_struct_print("phong_render_batch", phong_parse, (char *)ps);
+
+    m = 0;
+    for (k = 0; k < n; k++) {
+	size_t j = idx[k];
+	struct shadework *swp = sbp->sb_sw[j];
+
+	if (swp->sw_xmitonly || PM_Activated || PM_Visualize) {
+	    sbp->sb_status[j] = phong_render(sbp->sb_ap[j], sbp->sb_pp[j], swp, dp);
+	    continue;
+	}
+
+	swp->sw_transmit = ps->transmit;
+	swp->sw_reflect = ps->reflect;
+	swp->sw_refrac_index = ps->refrac_index;
+	swp->sw_extinction = ps->extinction;
+
+	sel[m] = j;
+	nx[m] = sbp->sb_norm[X][j];
+	ny[m] = sbp->sb_norm[Y][j];
+	nz[m] = sbp->sb_norm[Z][j];
+	dx[m] = sbp->sb_dir[X][j];
+	dy[m] = sbp->sb_dir[Y][j];
+	dz[m] = sbp->sb_dir[Z][j];
+	mr[m] = swp->sw_color[0];
+	mg[m] = swp->sw_color[1];
+	mb[m] = swp->sw_color[2];
+	m++;
+    }
+    if (m == 0)
+	return 1;
+
+    /* Diffuse reflectance from "Ambient" light source (at eye), plus emission */
+    for (k = 0; k < m; k++) {
+	fastf_t cosine = -(nx[k]*dx[k] + ny[k]*dy[k] + nz[k]*dz[k]);
+	if (cosine > 1.00001)
+	    cosine = 1;
+	if (cosine < 0.0)
+	    cosine = 0;
+	cosine *= AmbientIntensity;
+	cr[k] = mr[k] * cosine + ps->emission[0];
+	cg[k] = mg[k] * cosine + ps->emission[1];
+	cb[k] = mb[k] * cosine + ps->emission[2];
+    }
+
+    /* Same reasoning as phong_render(): only we can tell what is lit */
+    for (k = 0; k < m; k++)
+	light_obs(sbp->sb_ap[sel[k]], sbp->sb_sw[sel[k]], ps->mfp->mf_inputs);
+
+    nlights = sbp->sb_ap[sel[0]]->a_rt_i->rti_nlights;
+    for (i = 0; i < nlights; i++) {
+
+	/* gather this light's contribution into columns; shadowed
+	 * points get a zero fraction and so add nothing below.
+	 */
+	for (k = 0; k < m; k++) {
+	    const struct shadework *swp = sbp->sb_sw[sel[k]];
+	    const struct light_specific *lp = swp->sw_visible[i];
+
+	    if (lp == LIGHT_NULL) {
+		lf[k] = lx[k] = ly[k] = lz[k] = 0;
+		ir[k] = ig[k] = ib[k] = 0;
+		continue;
+	    }
+	    lf[k] = swp->sw_lightfract[i] * lp->lt_fraction;
+	    lx[k] = swp->sw_tolight[3*i+0];
+	    ly[k] = swp->sw_tolight[3*i+1];
+	    lz[k] = swp->sw_tolight[3*i+2];
+	    ir[k] = lp->lt_color[0] * swp->sw_intensity[3*i+0];
+	    ig[k] = lp->lt_color[1] * swp->sw_intensity[3*i+1];
+	    ib[k] = lp->lt_color[2] * swp->sw_intensity[3*i+2];
+	}
+
+	for (k = 0; k < m; k++) {
+	    fastf_t cosine, spec, refl_d, refl_s;
+	    fastf_t rx, ry, rz;
+
+	    /* Diffuse reflectance from this light source. */
+	    cosine = nx[k]*lx[k] + ny[k]*ly[k] + nz[k]*lz[k];
+	    if (cosine > 1.00001)
+		cosine = 1;
+	    refl_d = cosine > 0.0 ? ps->wgt_diffuse * lf[k] * cosine : 0.0;
+
+	    /* Specular, as in phong_render() */
+	    rx = 2 * cosine * nx[k] - lx[k];
+	    ry = 2 * cosine * ny[k] - ly[k];
+	    rz = 2 * cosine * nz[k] - lz[k];
+	    spec = -(rx*dx[k] + ry*dy[k] + rz*dz[k]);
+	    if (spec > 1.00001)
+		spec = 1;
+	    if (spec > 0.0) {
+		refl_s = ps->wgt_specular * lf[k] *
+#ifdef PHAST_PHONG
+		    spec / (ps->shine - ps->shine*spec + spec);
+#else
+		phg_ipow(spec, ps->shine);
+#endif /* PHAST_PHONG */
+	    } else {
+		refl_s = 0.0;
+	    }
+
+	    cr[k] += (refl_d * mr[k] + refl_s) * ir[k];
+	    cg[k] += (refl_d * mg[k] + refl_s) * ig[k];
+	    cb[k] += (refl_d * mb[k] + refl_s) * ib[k];
+	}
+    }
+
+    for (k = 0; k < m; k++) {
+	size_t j = sel[k];
+	struct shadework *swp = sbp->sb_sw[j];
+
+	VSET(swp->sw_color, cr[k], cg[k], cb[k]);
+	if (swp->sw_reflect > 0 || swp->sw_transmit > 0)
+	    (void)rr_render(sbp->sb_ap[j], sbp->sb_pp[j], swp);
+	sbp->sb_status[j] = 1;
+    }
+
+    return 1;
+}
+
+
 #ifndef PHAST_PHONG
 /*
  * Raise a floating point number to an integer power
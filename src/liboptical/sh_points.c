@@ -67,8 +67,8 @@ static void points_print(register struct region *rp, void *dp);
 static void points_mfree(void *cp);
 
 struct mfuncs points_mfuncs[] = {
-    {MF_MAGIC,	"points",	0,		MFI_UV,		0,     points_setup,	points_render,	points_print,	points_mfree },
-    {0,		(char *)0,	0,		0,		0,     0,		0,		0,		0 }
+    {MF_MAGIC,	"points",	0,		MFI_UV,		0,     points_setup,	points_render,	points_print,	points_mfree,	0 },
+    {0,		(char *)0,	0,		0,		0,     0,		0,		0,		0,	0 }
 };
 
 
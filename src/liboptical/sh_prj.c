@@ -42,6 +42,7 @@
 #include "raytrace.h"
 #include "optical.h"
 #include "bv/plot3.h"
+#include "./texcache.h"
 
 
 #define prj_MAGIC 0x70726a00	/* "prj" */
@@ -71,9 +72,11 @@ struct img_specific {
     char i_antialias;	/* anti-alias texture */
     char i_behind;	/* shade points behind img plane */
     fastf_t i_perspective;	/* perspective angle 0=ortho */
+    struct tex_image *i_tex;	/* shared cache entry, owns i_data/i_binunifp */
+    int i_mip;		/* filter through i_tex's mip-map, see tex_image_mip() */
 };
 #define IMG_MAGIC 0x696d6700	/* "img" */
-#define IMG_SPECIFIC_INIT_ZERO {BU_LIST_INIT_ZERO, 0, BU_VLS_INIT_ZERO, '\0', NULL, NULL, NULL, 0, 0, 0.0, VINIT_ZERO, HINIT_ZERO, MAT_INIT_IDN, MAT_INIT_IDN, HINIT_ZERO, MAT_INIT_IDN, '\0', '\0', '\0', 0.0}
+#define IMG_SPECIFIC_INIT_ZERO {BU_LIST_INIT_ZERO, 0, BU_VLS_INIT_ZERO, '\0', NULL, NULL, NULL, 0, 0, 0.0, VINIT_ZERO, HINIT_ZERO, MAT_INIT_IDN, MAT_INIT_IDN, HINIT_ZERO, MAT_INIT_IDN, '\0', '\0', '\0', 0.0, NULL, 0}
 
 
 /**
@@ -427,10 +430,10 @@ static void prj_free(void *cp);
  */
 struct mfuncs prj_mfuncs[] = {
     {MF_MAGIC,	"prj",		0,		MFI_NORMAL|MFI_HIT|MFI_UV,	0,
-     prj_setup,	prj_render,	prj_print,	prj_free },
+     prj_setup,	prj_render,	prj_print,	prj_free,	0 },
 
     {0,		(char *)0,	0,		0,		0,
-     0,		0,		0,		0 }
+     0,		0,		0,		0,	0 }
 };
 
 
@@ -452,6 +455,7 @@ prj_setup(register struct region *rp, struct bu_vls *matparm, void **dpp, const
 
     struct bu_vls parameter_data = BU_VLS_INIT_ZERO;
     struct bu_mapped_file *parameter_file;
+    struct bu_vls key = BU_VLS_INIT_ZERO;
 
     /* check the arguments */
     RT_CHECK_RTI(rtip);
@@ -524,8 +528,21 @@ prj_setup(register struct region *rp, struct bu_vls *matparm, void **dpp, const
 
     bu_vls_free(&parameter_data);
 
-    /* load the image data for any specified images */
+    /* load the image data for any specified images, sharing any
+     * that other regions have already loaded
+     */
     for (BU_LIST_FOR(img_sp, img_specific, &prj_sp->prj_images.l)) {
+	img_sp->i_mip = tex_image_mip();
+	bu_vls_sprintf(&key, "%p %d %dx%dx3 %s", (void *)rtip->rti_dbip, img_sp->i_datasrc,
+		       img_sp->i_width, img_sp->i_height, bu_vls_cstr(&img_sp->i_name));
+	img_sp->i_tex = tex_image_get(bu_vls_cstr(&key));
+	if (img_sp->i_tex) {
+	    img_sp->i_data = img_sp->i_tex->ti_mp;
+	    img_sp->i_binunifp = img_sp->i_tex->ti_binunifp;
+	    img_sp->i_img = (unsigned char *)img_sp->i_tex->ti_pix;
+	    continue;
+	}
+
 	if (img_load_datasource(img_sp, rtip->rti_dbip, img_sp->i_width * img_sp->i_height * 3) < 0) {
 	    bu_log("\nERROR: prj_setup() %s %s could not be loaded [source was %s]\n",
 		   rp->reg_name, bu_vls_addr(&img_sp->i_name),
@@ -535,9 +552,17 @@ prj_setup(register struct region *rp, struct bu_vls *matparm, void **dpp, const
 	    img_sp->i_through='0';
 	    HREVERSE(img_sp->i_plane, img_sp->i_plane);
 
+	    bu_vls_free(&key);
 	    return -1;
 	}
+
+	img_sp->i_tex = tex_image_add(bu_vls_cstr(&key), img_sp->i_data, img_sp->i_binunifp,
+				      img_sp->i_width, img_sp->i_height, 3);
+	img_sp->i_data = img_sp->i_tex->ti_mp;
+	img_sp->i_binunifp = img_sp->i_tex->ti_binunifp;
+	img_sp->i_img = (unsigned char *)img_sp->i_tex->ti_pix;
     }
+    bu_vls_free(&key);
 
     /* if even one of the images is to be anti-aliased, then we need
      * to set the rti_prismtrace flag so that we can compute the exact
@@ -596,9 +621,14 @@ prj_free(void *cp)
     while (BU_LIST_WHILE(img_sp, img_specific, &prj_sp->prj_images.l)) {
 
 	img_sp->i_img = (unsigned char *)0;
-	bu_close_mapped_file(img_sp->i_data);
+	if (img_sp->i_tex) {
+	    tex_image_put(img_sp->i_tex);
+	    img_sp->i_tex = NULL;
+	} else {
+	    bu_close_mapped_file(img_sp->i_data);
+	    if (img_sp->i_binunifp) rt_binunif_free(img_sp->i_binunifp);
+	}
 	img_sp->i_data = (struct bu_mapped_file *)NULL; /* sanity */
-	if (img_sp->i_binunifp) rt_binunif_free(img_sp->i_binunifp);
 	img_sp->i_binunifp = (struct rt_binunif_internal *)NULL; /* sanity */
 	bu_vls_free(&img_sp->i_name);
 
@@ -619,7 +649,7 @@ static const point_t delta = {0.5, 0.5, 0.0};
 
 
 static int
-project_point(point_t sh_color, struct img_specific *img_sp, struct prj_specific *prj_sp, point_t r_pt)
+project_point(point_t sh_color, struct img_specific *img_sp, struct prj_specific *prj_sp, point_t r_pt, const struct pixel_ext *r_pe)
 {
     int x, y;
     point_t sh_pt;
@@ -679,6 +709,35 @@ project_point(point_t sh_color, struct img_specific *img_sp, struct prj_specific
 	VADD2(tmp_pt, r_pt, tmp_pt);
 	pdv_3cont(prj_sp->prj_plfd, tmp_pt);
     }
+
+    /* With LIBOPTICAL_TEXFILTER=mip and the pixel's extent on the
+     * surface, filter the part of the image it covers instead of
+     * taking the one pixel under the hit.  By default, and for an
+     * extent within one image pixel, the direct lookup is kept.
+     */
+    if (r_pe && img_sp->i_mip && img_sp->i_antialias != '0' && img_sp->i_tex &&
+	img_sp->i_tex->ti_len >= (size_t)img_sp->i_width * img_sp->i_height * 3) {
+	point_t c_pt;
+	fastf_t umin, umax, vmin, vmax;
+	int i;
+
+	umin = vmin = INFINITY;
+	umax = vmax = -INFINITY;
+	for (i = 0; i < CORNER_PTS; i++) {
+	    MAT4X3PNT(c_pt, img_sp->i_sh_to_img, r_pe->corner[i].r_pt);
+	    VADD2(c_pt, c_pt, delta);
+	    V_MIN(umin, c_pt[X]);
+	    V_MAX(umax, c_pt[X]);
+	    V_MIN(vmin, c_pt[Y]);
+	    V_MAX(vmax, c_pt[Y]);
+	}
+	if ((umax - umin) * img_sp->i_width > 1.0 || (vmax - vmin) * img_sp->i_height > 1.0) {
+	    tex_image_sample(img_sp->i_tex, sh_pt[X], sh_pt[Y],
+			     (umax - umin) * 0.5, (vmax - vmin) * 0.5, sh_color);
+	    return 0;
+	}
+    }
+
     VMOVE(sh_color, pixel);	/* int/float conversion */
     return 0;
 }
@@ -810,7 +869,7 @@ prj_render(struct application *ap, const struct partition *pp, struct shadework
 	    continue;
 	}
 
-	if (project_point(sh_color, img_sp, prj_sp, r_pt))
+	if (project_point(sh_color, img_sp, prj_sp, r_pt, ap->a_pixelext ? &r_pe : NULL))
 	    continue;
 
 	VSCALE(sh_color, sh_color, cs);
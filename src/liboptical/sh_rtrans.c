@@ -68,8 +68,8 @@ static void rtrans_print(register struct region *rp, void *dp);
 static void rtrans_free(void *cp);
 
 struct mfuncs rtrans_mfuncs[] = {
-    {MF_MAGIC,	"rtrans",	0,		0,	0,     rtrans_setup,	rtrans_render,	rtrans_print,	rtrans_free },
-    {0,		(char *)0,	0,		0,	0,     0,		0,		0,		0 }
+    {MF_MAGIC,	"rtrans",	0,		0,	0,     rtrans_setup,	rtrans_render,	rtrans_print,	rtrans_free,	0 },
+    {0,		(char *)0,	0,		0,	0,     0,		0,		0,		0,	0 }
 };
 
 
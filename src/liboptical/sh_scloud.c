@@ -107,9 +107,9 @@ static void scloud_print(register struct region *rp, void *dp);
 static void scloud_free(void *cp);
 
 struct mfuncs scloud_mfuncs[] = {
-    {MF_MAGIC,	"scloud",	0,	MFI_HIT, MFF_PROC,     scloud_setup,	scloud_render,	scloud_print,	scloud_free },
-    {MF_MAGIC,	"tsplat",	0,	MFI_HIT, MFF_PROC,     scloud_setup,	tsplat_render,	scloud_print,	scloud_free },
-    {0,		(char *)0,	0,		0, 0,     0,		0,		0,		0 }
+    {MF_MAGIC,	"scloud",	0,	MFI_HIT, MFF_PROC,     scloud_setup,	scloud_render,	scloud_print,	scloud_free,	0 },
+    {MF_MAGIC,	"tsplat",	0,	MFI_HIT, MFF_PROC,     scloud_setup,	tsplat_render,	scloud_print,	scloud_free,	0 },
+    {0,		(char *)0,	0,		0, 0,     0,		0,		0,		0,	0 }
 };
 
 
@@ -59,8 +59,8 @@ static void spm_print(register struct region *rp, void *dp);
 static void spm_mfree(void *cp);
 
 struct mfuncs spm_mfuncs[] = {
-    {MF_MAGIC,	"spm",		0,		MFI_UV,		0,     spm_setup,	spm_render,	spm_print,	spm_mfree },
-    {0,		(char *)0,	0,		0,		0,     0,		0,		0,		0 }
+    {MF_MAGIC,	"spm",		0,		MFI_UV,		0,     spm_setup,	spm_render,	spm_print,	spm_mfree,	0 },
+    {0,		(char *)0,	0,		0,		0,     0,		0,		0,		0,	0 }
 };
 
 
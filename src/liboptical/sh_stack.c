@@ -36,14 +36,15 @@
 
 static int sh_stk_setup(register struct region *rp, struct bu_vls *matparm, void **dpp, const struct mfuncs *mf_p, struct rt_i *rtip);
 static int sh_stk_render(struct application *ap, const struct partition *pp, struct shadework *swp, void *dp);
+static int sh_stk_render_batch(struct shade_batch *sbp, const size_t *idx, size_t n, void *dp);
 static void sh_stk_print(register struct region *rp, void *dp);
 static void sh_stk_free(void *cp);
 static int ext_setup(register struct region *rp, struct bu_vls *matparm, void **dpp, const struct mfuncs *mf_p, struct rt_i *rtip);
 
 struct mfuncs stk_mfuncs[] = {
-    {MF_MAGIC,	"stack",	0,		0,	0,     sh_stk_setup,	sh_stk_render,	sh_stk_print,	sh_stk_free},
-    {MF_MAGIC,	"extern",	0,		0,	0,     ext_setup,	sh_stk_render,	sh_stk_print,	sh_stk_free},
-    {0,		(char *)0,	0,		0,	0,     0,		0,		0,		0}
+    {MF_MAGIC,	"stack",	0,		0,	0,     sh_stk_setup,	sh_stk_render,	sh_stk_print,	sh_stk_free,	sh_stk_render_batch},
+    {MF_MAGIC,	"extern",	0,		0,	0,     ext_setup,	sh_stk_render,	sh_stk_print,	sh_stk_free,	sh_stk_render_batch},
+    {0,		(char *)0,	0,		0,	0,     0,		0,		0,		0,	0}
 };
 
 
@@ -306,6 +307,63 @@ sh_stk_render(struct application *ap, const struct partition *pp, struct shadewo
 }
 
 
+/*
+ * Batched sh_stk_render().  Each stage is run over every point still
+ * in the stack, through the stage's own batch routine where it has
+ * one.  A point whose stage does not return 1 drops out, exactly as
+ * sh_stk_render() stops early.
+ */
+static int
+sh_stk_render_batch(struct shade_batch *sbp, const size_t *idx, size_t n, void *dp)
+{
+    register struct stk_specific *sp =
+	(struct stk_specific *)dp;
+    size_t *live;
+    size_t k, m;
+    int i;
+    char tmp[128];
+
+    if (sp == NULL) {
+	bu_log("sh_stk_render_batch: Null pointer\n");
+	for (k = 0; k < n; k++)
+	    sbp->sb_status[idx[k]] = 0;
+	return 0;
+    }
+
+    /* stages may use the batch scratch columns, so keep our own list */
+    live = (size_t *)bu_malloc(n * sizeof(size_t), "sh_stk_render_batch live");
+    memcpy(live, idx, n * sizeof(size_t));
+    m = n;
+    for (k = 0; k < n; k++)
+	sbp->sb_status[idx[k]] = 1;
+
+    for (i = 0; i < 16 && sp->mfuncs[i] != NULL && m > 0; i++) {
+	size_t kept = 0;
+
+	if (optical_debug&OPTICAL_DEBUG_SHADE) {
+	    snprintf(tmp, 128, "before stacked \"%s\" shader", sp->mfuncs[i]->mf_name);
+
+	    for (k = 0; k < m; k++)
+		pr_shadework(tmp, sbp->sb_sw[live[k]]);
+	}
+
+	shade_batch_render(sbp, live, m, sp->mfuncs[i], sp->udata[i]);
+
+	for (k = 0; k < m; k++) {
+	    if (sbp->sb_status[live[k]] != 1) {
+		sbp->sb_status[live[k]] = 0;
+		continue;
+	    }
+	    live[kept++] = live[k];
+	}
+	m = kept;
+    }
+
+    bu_free(live, "sh_stk_render_batch live");
+    return 1;
+}
+
+
 static void
 sh_stk_print(register struct region *rp, void *dp)
 {
@@ -78,10 +78,10 @@ struct bu_structparse stxt_parse[] = {
 
 
 struct mfuncs stxt_mfuncs[] = {
-    {MF_MAGIC,	"brick",	0,		MFI_HIT,	0,     stxt_setup,	brick_render,	stxt_print,	stxt_free },
-    {MF_MAGIC,	"mbound",	0,		MFI_HIT,	0,     stxt_setup,	mbound_render,	stxt_print,	stxt_free },
-    {MF_MAGIC,	"rbound",	0,		MFI_HIT,	0,     stxt_setup,	rbound_render,	stxt_print,	stxt_free },
-    {0,		(char *)0,	0,		0,		0,     0,		0,		0,		0 }
+    {MF_MAGIC,	"brick",	0,		MFI_HIT,	0,     stxt_setup,	brick_render,	stxt_print,	stxt_free,	0 },
+    {MF_MAGIC,	"mbound",	0,		MFI_HIT,	0,     stxt_setup,	mbound_render,	stxt_print,	stxt_free,	0 },
+    {MF_MAGIC,	"rbound",	0,		MFI_HIT,	0,     stxt_setup,	rbound_render,	stxt_print,	stxt_free,	0 },
+    {0,		(char *)0,	0,		0,		0,     0,		0,		0,		0,	0 }
 };
 
 
@@ -103,10 +103,10 @@ static void tcl_free(void *cp);
  */
 struct mfuncs tcl_mfuncs[] = {
     {MF_MAGIC,	"tcl",		0,		MFI_NORMAL|MFI_HIT|MFI_UV,	0,
-     tcl_setup,	tcl_render,	tcl_print,	tcl_free },
+     tcl_setup,	tcl_render,	tcl_print,	tcl_free,	0 },
 
     {0,		(char *)0,	0,		0,		0,
-     0,		0,		0,		0 }
+     0,		0,		0,		0,	0 }
 };
 
 
@@ -33,6 +33,7 @@
 #include "vmath.h"
 #include "raytrace.h"
 #include "optical.h"
+#include "./texcache.h"
 
 
 #define TXT_NAME_LEN 128
@@ -51,6 +52,8 @@ struct txt_specific {
     char tx_datasrc; /* which type of datasource */
     struct rt_binunif_internal *tx_binunifp;  /* db internal object when TXT_SRC_OBJECT */
     struct bu_mapped_file *tx_mp;    /* mapped file when TXT_SRC_FILE */
+    struct tex_image *tx_img;	/* shared cache entry, owns tx_binunifp/tx_mp */
+    int tx_mip;		/* filter through tx_img's mip-map, see tex_image_mip() */
 };
 #define TX_NULL ((struct txt_specific *)0)
 #define TX_O(m) bu_offsetof(struct txt_specific, m)
@@ -126,7 +129,8 @@ txt_transp_hook(const struct bu_structparse *sdp,
 
 /*
  * This is a helper routine used in txt_setup() to load a texture either from
- * a file or from a db object.  The resources are released in txt_free()
+ * a file or from a db object.  The resources are handed to the texture
+ * cache, which releases them when the last txt_free() drops the image
  * (there is no specific unload_datasource function).
  */
 static int
@@ -216,6 +220,53 @@ txt_load_datasource(struct txt_specific *texture, struct db_i *dbInstance, const
 }
 
 
+/*
+ * With LIBOPTICAL_TEXFILTER=mip, lookups go through the shared
+ * mip-map when it holds the whole image and the footprint (u +/- du,
+ * v +/- dv) spans more than one texel.  Otherwise, and by default,
+ * the box filter below is used as it always was, so existing
+ * renderings do not change.  A footprint within one texel keeps the
+ * direct lookup, and a short image keeps the wrap-around and red
+ * warning tint of the direct lookups.
+ */
+static int
+txt_filtered(const struct txt_specific *tp, int nchan, fastf_t du, fastf_t dv)
+{
+    if (!tp->tx_mip || !tp->tx_img || tp->tx_trans_valid ||
+	tp->tx_img->ti_len < (size_t)tp->tx_w * tp->tx_n * nchan)
+	return 0;
+
+    return 2.0 * du * tp->tx_w > 1.0 || 2.0 * dv * tp->tx_n > 1.0;
+}
+
+
+/*
+ * Return the RGB texel at the given byte offset.  Offsets past the end
+ * of a texture that is smaller than its advertised size are wrapped,
+ * and *warn is set so the caller can tint the result.
+ */
+static const unsigned char *
+txt_texel(const struct txt_specific *tp, unsigned int offset, char *warn)
+{
+    if (tp->tx_mp) {
+	if (offset >= tp->tx_mp->buflen) {
+	    offset %= tp->tx_mp->buflen;
+	    *warn = 1;
+	}
+	return ((const unsigned char *)(tp->tx_mp->buf)) + offset;
+    } else if (tp->tx_binunifp) {
+	if (offset >= tp->tx_binunifp->count) {
+	    offset %= tp->tx_binunifp->count;
+	    *warn = 1;
+	}
+	return ((const unsigned char *)(tp->tx_binunifp->u.uint8)) + offset;
+    }
+
+    bu_bomb("sh_text.c -- No texture data found\n");
+    return NULL;
+}
+
+
 /*
  * Given a u, v coordinate within the texture (0 <= u, v <= 1.0),
  * return a pointer to the relevant pixel.
@@ -287,6 +338,16 @@ txt_render(struct application *ap, const struct partition *pp, struct shadework
 	uvc.uv_du = uvc.uv_dv = 0;
     }
 
+    if (txt_filtered(tp, 3, uvc.uv_du, uvc.uv_dv)) {
+	fastf_t rgb[3];
+
+	tex_image_sample(tp->tx_img, uvc.uv_u, uvc.uv_v, uvc.uv_du, uvc.uv_dv, rgb);
+	VSCALE(swp->sw_color, rgb, 1.0 / 255.0);
+	if (swp->sw_reflect > 0 || swp->sw_transmit > 0)
+	    (void)rr_render(ap, pp, swp);
+	return 1;
+    }
+
     xmin = uvc.uv_u - uvc.uv_du;
     xmax = uvc.uv_u + uvc.uv_du;
     ymin = uvc.uv_v - uvc.uv_dv;
@@ -310,25 +371,9 @@ txt_render(struct application *ap, const struct partition *pp, struct shadework
     if (dx == 0 && dy == 0) {
 	/* No averaging necessary */
 
-	register unsigned char *cp=NULL;
-	unsigned int offset;
+	register const unsigned char *cp;
 
-	offset = (int)(ymin * (tp->tx_n-1)) * tp->tx_w * 3 + (int)(xmin * (tp->tx_w-1)) * 3;
-	if (tp->tx_mp) {
-	    if (offset >= tp->tx_mp->buflen) {
-		offset %= tp->tx_mp->buflen;
-		color_warn = 1;
-	    }
-	    cp = ((unsigned char *)(tp->tx_mp->buf)) + offset;
-	} else if (tp->tx_binunifp) {
-	    if (offset >= tp->tx_binunifp->count) {
-		offset %= tp->tx_binunifp->count;
-		color_warn = 1;
-	    }
-	    cp = ((unsigned char *)(tp->tx_binunifp->u.uint8)) + offset;
-	} else {
-	    bu_bomb("sh_text.c -- No texture data found\n");
-	}
+	cp = txt_texel(tp, (int)(ymin * (tp->tx_n-1)) * tp->tx_w * 3 + (int)(xmin * (tp->tx_w-1)) * 3, &color_warn);
 	r = *cp++;
 	g = *cp++;
 	b = *cp;
@@ -472,6 +517,110 @@ txt_render(struct application *ap, const struct partition *pp, struct shadework
 }
 
 
+/*
+ * Batched txt_render().  The U, V replication and mirroring is done
+ * over the UV columns.  Points whose footprint falls inside a single
+ * texel are looked up directly, and with LIBOPTICAL_TEXFILTER=mip
+ * those spanning several texels are filtered through the shared
+ * mip-map.  Anything that needs the box-filtered average,
+ * transparency, or the missing-texture colors goes through
+ * txt_render().
+ */
+static int
+txt_render_batch(struct shade_batch *sbp, const size_t *idx, size_t n, void *dp)
+{
+    register struct txt_specific *tp =
+	(struct txt_specific *)dp;
+    fastf_t *u = sbp->sb_tmp[0];
+    fastf_t *v = sbp->sb_tmp[1];
+    size_t k;
+
+    if (tp->tx_trans_valid || (bu_vls_strlen(&tp->tx_name) <= 0) ||
+	(!tp->tx_mp && !tp->tx_binunifp) || (optical_debug & OPTICAL_DEBUG_SHADE)) {
+	for (k = 0; k < n; k++) {
+	    size_t j = idx[k];
+	    sbp->sb_status[j] = txt_render(sbp->sb_ap[j], sbp->sb_pp[j], sbp->sb_sw[j], dp);
+	}
+	return 1;
+    }
+
+    /* take care of scaling U, V coordinates to get the desired amount
+     * of replication of the texture
+     */
+    for (k = 0; k < n; k++) {
+	size_t j = idx[k];
+	fastf_t uu = sbp->sb_uv[0][j] * tp->tx_scale[X];
+	fastf_t vv = sbp->sb_uv[1][j] * tp->tx_scale[Y];
+	long tu = uu;
+	long tv = vv;
+
+	uu -= tu;
+	vv -= tv;
+	u[k] = (tp->tx_mirror && (tu & 1)) ? 1.0 - uu : uu;
+	v[k] = (tp->tx_mirror && (tv & 1)) ? 1.0 - vv : vv;
+    }
+
+    for (k = 0; k < n; k++) {
+	size_t j = idx[k];
+	struct shadework *swp = sbp->sb_sw[j];
+	fastf_t du, dv;
+	fastf_t xmin, xmax, ymin, ymax;
+	const unsigned char *cp;
+	fastf_t r, g, b;
+	char color_warn = 0;
+
+	du = swp->sw_uv.uv_du / tp->tx_scale[X];
+	dv = swp->sw_uv.uv_dv / tp->tx_scale[Y];
+	if (du > 0.125) du = 0.125;
+	if (dv > 0.125) dv = 0.125;
+
+	if (du >= 0 && dv >= 0 && txt_filtered(tp, 3, du, dv)) {
+	    fastf_t rgb[3];
+
+	    tex_image_sample(tp->tx_img, u[k], v[k], du, dv, rgb);
+	    VSCALE(swp->sw_color, rgb, 1.0 / 255.0);
+	    if (swp->sw_reflect > 0 || swp->sw_transmit > 0)
+		(void)rr_render(sbp->sb_ap[j], sbp->sb_pp[j], swp);
+	    sbp->sb_status[j] = 1;
+	    continue;
+	}
+
+	xmin = u[k] - du;
+	xmax = u[k] + du;
+	ymin = v[k] - dv;
+	ymax = v[k] + dv;
+	if (xmin < 0) xmin = 0;
+	if (ymin < 0) ymin = 0;
+	if (xmax > 1) xmax = 1;
+	if (ymax > 1) ymax = 1;
+
+	if (du < 0 || dv < 0 ||
+	    (int)(xmax * (tp->tx_w-1)) != (int)(xmin * (tp->tx_w-1)) ||
+	    (int)(ymax * (tp->tx_n-1)) != (int)(ymin * (tp->tx_n-1))) {
+	    sbp->sb_status[j] = txt_render(sbp->sb_ap[j], sbp->sb_pp[j], swp, dp);
+	    continue;
+	}
+
+	cp = txt_texel(tp, (int)(ymin * (tp->tx_n-1)) * tp->tx_w * 3 + (int)(xmin * (tp->tx_w-1)) * 3, &color_warn);
+	r = cp[0];
+	g = cp[1];
+	b = cp[2];
+	if (color_warn == 1) {
+	    r = (r + 255.0) / 2;
+	    g /= 2;
+	    b /= 2;
+	}
+
+	VSET(swp->sw_color, r / 255.0, g / 255.0, b / 255.0);
+	if (swp->sw_reflect > 0 || swp->sw_transmit > 0)
+	    (void)rr_render(sbp->sb_ap[j], sbp->sb_pp[j], swp);
+	sbp->sb_status[j] = 1;
+    }
+
+    return 1;
+}
+
+
 /*
  * Given a u, v coordinate within the texture (0 <= u, v <= 1.0),
  * return the filtered intensity.
@@ -535,6 +684,16 @@ bwtxt_render(struct application *ap, const struct partition *pp, struct shadewor
 	       pp->pt_inseg->seg_stp->st_name);
 	uvc.uv_du = uvc.uv_dv = 0;
     }
+
+    if (txt_filtered(tp, 1, uvc.uv_du, uvc.uv_dv)) {
+	fastf_t val;
+
+	tex_image_sample(tp->tx_img, uvc.uv_u, uvc.uv_v, uvc.uv_du, uvc.uv_dv, &val);
+	VSETALL(swp->sw_color, val / 255.0);
+	if (swp->sw_reflect > 0 || swp->sw_transmit > 0)
+	    (void)rr_render(ap, pp, swp);
+	return 1;
+    }
     xmin = uvc.uv_u - uvc.uv_du;
     xmax = uvc.uv_u + uvc.uv_du;
     ymin = uvc.uv_v - uvc.uv_dv;
@@ -601,6 +760,7 @@ txt_setup(register struct region *rp, struct bu_vls *matparm, void **dpp, const
 {
     register struct txt_specific *tp;
     int pixelbytes = 3;
+    struct bu_vls key = BU_VLS_INIT_ZERO;
 
     BU_CK_VLS(matparm);
     BU_GET(tp, struct txt_specific);
@@ -617,6 +777,8 @@ txt_setup(register struct region *rp, struct bu_vls *matparm, void **dpp, const
     tp->tx_datasrc = 0; /* source is auto-located by default */
     tp->tx_binunifp = NULL;
     tp->tx_mp = NULL;
+    tp->tx_img = NULL;
+    tp->tx_mip = tex_image_mip();
 
     /* load given values */
     if (bu_struct_parse(matparm, txt_parse, (char *)tp, NULL) < 0) {
@@ -634,11 +796,23 @@ txt_setup(register struct region *rp, struct bu_vls *matparm, void **dpp, const
 
     if (BU_STR_EQUAL(mfp->mf_name, "bwtexture")) pixelbytes = 1;
 
+    /* regions using the same image share one copy of it */
+    bu_vls_sprintf(&key, "%p %d %dx%dx%d %s", (void *)rtip->rti_dbip, tp->tx_datasrc,
+		   tp->tx_w, tp->tx_n, pixelbytes, bu_vls_cstr(&tp->tx_name));
+    tp->tx_img = tex_image_get(bu_vls_cstr(&key));
+
     /* load the texture from its datasource */
-    if (txt_load_datasource(tp, rtip->rti_dbip, tp->tx_w * tp->tx_n * pixelbytes)<0) {
-	bu_log("\nERROR: txt_setup() %s %s could not be loaded [source was %s]\n", rp->reg_name, bu_vls_addr(&tp->tx_name), tp->tx_datasrc==TXT_SRC_OBJECT?"object":tp->tx_datasrc==TXT_SRC_FILE?"file":"auto");
-	return -1;
+    if (!tp->tx_img) {
+	if (txt_load_datasource(tp, rtip->rti_dbip, tp->tx_w * tp->tx_n * pixelbytes)<0) {
+	    bu_log("\nERROR: txt_setup() %s %s could not be loaded [source was %s]\n", rp->reg_name, bu_vls_addr(&tp->tx_name), tp->tx_datasrc==TXT_SRC_OBJECT?"object":tp->tx_datasrc==TXT_SRC_FILE?"file":"auto");
+	    bu_vls_free(&key);
+	    return -1;
+	}
+	tp->tx_img = tex_image_add(bu_vls_cstr(&key), tp->tx_mp, tp->tx_binunifp, tp->tx_w, tp->tx_n, pixelbytes);
     }
+    bu_vls_free(&key);
+    tp->tx_mp = tp->tx_img->ti_mp;
+    tp->tx_binunifp = tp->tx_img->ti_binunifp;
 
 
     if (optical_debug & OPTICAL_DEBUG_SHADE) {
@@ -663,8 +837,13 @@ txt_free(void *cp)
     struct txt_specific *tp =	(struct txt_specific *)cp;
 
     bu_vls_free(&tp->tx_name);
-    if (tp->tx_binunifp) rt_binunif_free(tp->tx_binunifp);
-    bu_close_mapped_file(tp->tx_mp);
+    if (tp->tx_img) {
+	tex_image_put(tp->tx_img);
+	tp->tx_img = NULL;
+    } else {
+	if (tp->tx_binunifp) rt_binunif_free(tp->tx_binunifp);
+	bu_close_mapped_file(tp->tx_mp);
+    }
     tp->tx_binunifp = (struct rt_binunif_internal *)NULL; /* sanity */
     tp->tx_mp = (struct bu_mapped_file *)NULL; /* sanity */
     BU_PUT(cp, struct txt_specific);
@@ -968,14 +1147,14 @@ mlib_void2(void *UNUSED(b))
 }
 
 struct mfuncs txt_mfuncs[] = {
-    {MF_MAGIC,	"texture",	0,	MFI_UV,		0,	txt_setup,	txt_render,	txt_print,	txt_free },
-    {MF_MAGIC,	"bwtexture",	0,	MFI_UV,		0,	txt_setup,	bwtxt_render,	txt_print,	txt_free },
-    {MF_MAGIC,	"checker",	0,	MFI_UV,		0,	ckr_setup,	ckr_render,	ckr_print,	ckr_free },
-    {MF_MAGIC,	"testmap",	0,	MFI_UV,		0,	mlib_one,	tstm_render,	mlib_void,	mlib_void2 },
-    {MF_MAGIC,	"fakestar",	0,	0,		0,	mlib_one,	star_render,	mlib_void,	mlib_void2 },
-    {MF_MAGIC,	"bump",		0,	MFI_UV|MFI_NORMAL, 0,	txt_setup,	bmp_render,	txt_print,	txt_free },
-    {MF_MAGIC,	"envmap",	0,	0,		0,	envmap_setup,	mlib_zero,	mlib_void,	mlib_void2 },
-    {0,		(char *)0,	0,	0,		0,	0,		0,		0,		0 }
+    {MF_MAGIC,	"texture",	0,	MFI_UV,		0,	txt_setup,	txt_render,	txt_print,	txt_free,	txt_render_batch },
+    {MF_MAGIC,	"bwtexture",	0,	MFI_UV,		0,	txt_setup,	bwtxt_render,	txt_print,	txt_free,	0 },
+    {MF_MAGIC,	"checker",	0,	MFI_UV,		0,	ckr_setup,	ckr_render,	ckr_print,	ckr_free,	0 },
+    {MF_MAGIC,	"testmap",	0,	MFI_UV,		0,	mlib_one,	tstm_render,	mlib_void,	mlib_void2,	0 },
+    {MF_MAGIC,	"fakestar",	0,	0,		0,	mlib_one,	star_render,	mlib_void,	mlib_void2,	0 },
+    {MF_MAGIC,	"bump",		0,	MFI_UV|MFI_NORMAL, 0,	txt_setup,	bmp_render,	txt_print,	txt_free,	0 },
+    {MF_MAGIC,	"envmap",	0,	0,		0,	envmap_setup,	mlib_zero,	mlib_void,	mlib_void2,	0 },
+    {0,		(char *)0,	0,	0,		0,	0,		0,		0,		0,	0 }
 };
 
 
@@ -90,10 +90,10 @@ static void toon_free(void *cp);
  */
 struct mfuncs toon_mfuncs[] = {
     {MF_MAGIC,	"toon",	0,	MFI_NORMAL|MFI_HIT,	0,
-     toon_setup,	toon_render,	toon_print,	toon_free },
+     toon_setup,	toon_render,	toon_print,	toon_free,	0 },
 
     {0,		(char *)0,	0,		0,		0,
-     0,		0,		0,		0 }
+     0,		0,		0,		0,	0 }
 };
 
 
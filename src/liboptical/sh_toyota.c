@@ -109,10 +109,10 @@ fastf_t skylight_spectral_dist(fastf_t lambda, fastf_t *Zenith, fastf_t *Sky_elm
 fastf_t zenith_luminance(fastf_t sun_alt, fastf_t t_vl);
 
 struct mfuncs toyota_mfuncs[] = {
-    {MF_MAGIC,	"toyota",	0,		MFI_NORMAL|MFI_LIGHT,	0,     toyota_setup,	toyota_render,	toyota_print,	toyota_free },
-    {MF_MAGIC,	"tmirror",	0,		MFI_NORMAL|MFI_LIGHT,	0,     tmirror_setup,	toyota_render,	toyota_print,	toyota_free },
-    {MF_MAGIC,	"tglass",	0,		MFI_NORMAL|MFI_LIGHT,	0,     tglass_setup,	toyota_render,	toyota_print,	toyota_free },
-    {0,		(char *)0,	0,		0,	0,     0,		0,		0,		0 }
+    {MF_MAGIC,	"toyota",	0,		MFI_NORMAL|MFI_LIGHT,	0,     toyota_setup,	toyota_render,	toyota_print,	toyota_free,	0 },
+    {MF_MAGIC,	"tmirror",	0,		MFI_NORMAL|MFI_LIGHT,	0,     tmirror_setup,	toyota_render,	toyota_print,	toyota_free,	0 },
+    {MF_MAGIC,	"tglass",	0,		MFI_NORMAL|MFI_LIGHT,	0,     tglass_setup,	toyota_render,	toyota_print,	toyota_free,	0 },
+    {0,		(char *)0,	0,		0,	0,     0,		0,		0,		0,	0 }
 };
 
 
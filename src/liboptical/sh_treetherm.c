@@ -157,8 +157,8 @@ static void tthrm_free(void *cp);
  * values for the parameters.
  */
 struct mfuncs tthrm_mfuncs[] = {
-    {MF_MAGIC,	"tthrm",		0,		MFI_NORMAL|MFI_HIT|MFI_UV,	0,     tthrm_setup,	tthrm_render,	tthrm_print,	tthrm_free },
-    {0,		(char *)0,	0,		0,		0,     0,		0,		0,		0 }
+    {MF_MAGIC,	"tthrm",		0,		MFI_NORMAL|MFI_HIT|MFI_UV,	0,     tthrm_setup,	tthrm_render,	tthrm_print,	tthrm_free,	0 },
+    {0,		(char *)0,	0,		0,		0,     0,		0,		0,		0,	0 }
 };
 void
 print_thrm_seg(struct thrm_seg *ts)
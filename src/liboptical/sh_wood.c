@@ -98,9 +98,9 @@ static void wood_D_set(const struct bu_structparse *, const char *, void *, cons
  */
 
 struct mfuncs wood_mfuncs[] = {
-    {MF_MAGIC,	"wood",		0,	MFI_HIT|MFI_UV|MFI_NORMAL,	0,	wood_setup,	wood_render,	wood_print,	wood_free},
-    {MF_MAGIC,	"w",		0,	MFI_HIT|MFI_UV|MFI_NORMAL,	0,	wood_setup,	wood_render,	wood_print,	wood_free},
-    {0,		(char *)0,	0,	0,				0,	0,		0,		0,		0}
+    {MF_MAGIC,	"wood",		0,	MFI_HIT|MFI_UV|MFI_NORMAL,	0,	wood_setup,	wood_render,	wood_print,	wood_free,	0},
+    {MF_MAGIC,	"w",		0,	MFI_HIT|MFI_UV|MFI_NORMAL,	0,	wood_setup,	wood_render,	wood_print,	wood_free,	0},
+    {0,		(char *)0,	0,	0,				0,	0,		0,		0,		0,	0}
 };
 
 /*
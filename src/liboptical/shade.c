@@ -30,8 +30,10 @@
 #include "common.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
+#include "bu/sort.h"
 #include "bn.h"
 #include "vmath.h"
 #include "raytrace.h"
@@ -137,7 +139,7 @@ shade_inputs(struct application *ap, const struct partition *pp, struct shadewor
 		    bu_log("shade_inputs(%s) flip N xy=%d, %d %s surf=%d dot=%g\n",
 			   pp->pt_inseg->seg_stp->st_name,
 			   ap->a_x, ap->a_y,
-			   OBJ[pp->pt_inseg->seg_stp->st_id].ft_name,
+			   pp->pt_inseg->seg_stp->st_meth->ft_name,
 			   swp->sw_hit.hit_surfno, f);
 		    bu_log("center: %0.17g %0.17g %0.17g\n", V3ARGS(ap->a_ray.r_pt));
 		    bu_log("dir: %0.17g %0.17g %0.17g\n", V3ARGS(ap->a_ray.r_dir));
@@ -190,7 +192,7 @@ hit pt: %g %g %g end pt: %g %g %g\n",
 		   swp->sw_uv.uv_u, swp->sw_uv.uv_v,
 		   swp->sw_uv.uv_du, swp->sw_uv.uv_dv,
 		   pp->pt_inseg->seg_stp->st_name,
-		   OBJ[pp->pt_inseg->seg_stp->st_id].ft_name,
+		   pp->pt_inseg->seg_stp->st_meth->ft_name,
 		   pp->pt_inhit->hit_surfno,
 		   ap->a_x, ap->a_y);
 	    VSET(swp->sw_color, 0, 9, 0);	/* Hyper-Green */
@@ -214,19 +216,14 @@ hit pt: %g %g %g end pt: %g %g %g\n",
 }
 
 
-/**
- * Call the material-specific shading function, after making certain
- * that all shadework fields desired have been provided.
- *
- * Returns -
- * 0 on failure
- * 1 on success
- *
- * But of course, nobody cares what this returns.  Everyone calls us
- * as (void)viewshade()
+/*
+ * Everything viewshade() does before handing a point to its shader:
+ * seed the shadework from the partition and compute whichever
+ * optional inputs the region's shader asked for.  Returns the
+ * region's mfuncs, or NULL if the point cannot be shaded.
  */
-int
-viewshade(struct application *ap, const struct partition *pp, struct shadework *swp)
+static const struct mfuncs *
+shade_prep(struct application *ap, const struct partition *pp, struct shadework *swp)
 {
     register const struct mfuncs *mfp;
     register const struct region *rp;
@@ -247,7 +244,7 @@ viewshade(struct application *ap, const struct partition *pp, struct shadework *
 	if (OPTICAL_DEBUG&OPTICAL_DEBUG_SHADE) {
 	    bu_log("ERROR: NULL shadework or mfuncs structure encountered\n");
 	}
-	return 0;
+	return NULL;
     }
 
     want = mfp->mf_inputs;
@@ -311,10 +308,33 @@ viewshade(struct application *ap, const struct partition *pp, struct shadework *
 	pr_shadework("before mf_render", swp);
     }
 
+    return mfp;
+}
+
+
+/**
+ * Call the material-specific shading function, after making certain
+ * that all shadework fields desired have been provided.
+ *
+ * Returns -
+ * 0 on failure
+ * 1 on success
+ *
+ * But of course, nobody cares what this returns.  Everyone calls us
+ * as (void)viewshade()
+ */
+int
+viewshade(struct application *ap, const struct partition *pp, struct shadework *swp)
+{
+    register const struct mfuncs *mfp;
+
+    mfp = shade_prep(ap, pp, swp);
+    if (!mfp)
+	return 0;
 
     /* Invoke the actual shader (may be a tree of them) */
-    if (mfp && mfp->mf_render)
-	(void)mfp->mf_render(ap, pp, swp, rp->reg_udata);
+    if (mfp->mf_render)
+	(void)mfp->mf_render(ap, pp, swp, pp->pt_regionp->reg_udata);
 
     if (OPTICAL_DEBUG&OPTICAL_DEBUG_SHADE) {
 	pr_shadework("after mf_render", swp);
@@ -325,6 +345,221 @@ viewshade(struct application *ap, const struct partition *pp, struct shadework *
 }
 
 
+/*
+ * (Re)size every per-point column of a batch to hold max points.
+ */
+static void
+shade_batch_alloc(struct shade_batch *sbp, size_t max)
+{
+    int i;
+
+    sbp->sb_ap = (struct application **)bu_realloc(sbp->sb_ap, max * sizeof(struct application *), "sb_ap");
+    sbp->sb_pp = (const struct partition **)bu_realloc((void *)sbp->sb_pp, max * sizeof(struct partition *), "sb_pp");
+    sbp->sb_sw = (struct shadework **)bu_realloc(sbp->sb_sw, max * sizeof(struct shadework *), "sb_sw");
+    sbp->sb_regid = (int *)bu_realloc(sbp->sb_regid, max * sizeof(int), "sb_regid");
+    sbp->sb_status = (int *)bu_realloc(sbp->sb_status, max * sizeof(int), "sb_status");
+    sbp->sb_order = (size_t *)bu_realloc(sbp->sb_order, max * sizeof(size_t), "sb_order");
+    sbp->sb_sel = (size_t *)bu_realloc(sbp->sb_sel, max * sizeof(size_t), "sb_sel");
+    for (i = 0; i < 3; i++) {
+	sbp->sb_pos[i] = (fastf_t *)bu_realloc(sbp->sb_pos[i], max * sizeof(fastf_t), "sb_pos");
+	sbp->sb_norm[i] = (fastf_t *)bu_realloc(sbp->sb_norm[i], max * sizeof(fastf_t), "sb_norm");
+	sbp->sb_dir[i] = (fastf_t *)bu_realloc(sbp->sb_dir[i], max * sizeof(fastf_t), "sb_dir");
+    }
+    for (i = 0; i < 2; i++)
+	sbp->sb_uv[i] = (fastf_t *)bu_realloc(sbp->sb_uv[i], max * sizeof(fastf_t), "sb_uv");
+    for (i = 0; i < SHADE_BATCH_NTMP; i++)
+	sbp->sb_tmp[i] = (fastf_t *)bu_realloc(sbp->sb_tmp[i], max * sizeof(fastf_t), "sb_tmp");
+
+    sbp->sb_max = max;
+}
+
+
+void
+shade_batch_init(struct shade_batch *sbp, size_t max)
+{
+    memset(sbp, 0, sizeof(struct shade_batch));
+    sbp->sb_magic = SHADE_BATCH_MAGIC;
+    shade_batch_alloc(sbp, max > 0 ? max : 1);
+}
+
+
+void
+shade_batch_free(struct shade_batch *sbp)
+{
+    int i;
+
+    RT_CK_SHADE_BATCH(sbp);
+
+    bu_free(sbp->sb_ap, "sb_ap");
+    bu_free((void *)sbp->sb_pp, "sb_pp");
+    bu_free(sbp->sb_sw, "sb_sw");
+    bu_free(sbp->sb_regid, "sb_regid");
+    bu_free(sbp->sb_status, "sb_status");
+    bu_free(sbp->sb_order, "sb_order");
+    bu_free(sbp->sb_sel, "sb_sel");
+    for (i = 0; i < 3; i++) {
+	bu_free(sbp->sb_pos[i], "sb_pos");
+	bu_free(sbp->sb_norm[i], "sb_norm");
+	bu_free(sbp->sb_dir[i], "sb_dir");
+    }
+    for (i = 0; i < 2; i++)
+	bu_free(sbp->sb_uv[i], "sb_uv");
+    for (i = 0; i < SHADE_BATCH_NTMP; i++)
+	bu_free(sbp->sb_tmp[i], "sb_tmp");
+
+    memset(sbp, 0, sizeof(struct shade_batch));
+}
+
+
+/**
+ * Refresh the position, normal, direction and UV columns of the
+ * listed points from their shadework.  Batch shaders that change
+ * sw_hit or sw_uv are expected to call this (or update the columns
+ * themselves) before returning.
+ */
+void
+shade_batch_gather(struct shade_batch *sbp, const size_t *idx, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+	size_t j = idx[i];
+	const struct shadework *swp = sbp->sb_sw[j];
+	const struct application *ap = sbp->sb_ap[j];
+
+	sbp->sb_pos[X][j] = swp->sw_hit.hit_point[X];
+	sbp->sb_pos[Y][j] = swp->sw_hit.hit_point[Y];
+	sbp->sb_pos[Z][j] = swp->sw_hit.hit_point[Z];
+	sbp->sb_norm[X][j] = swp->sw_hit.hit_normal[X];
+	sbp->sb_norm[Y][j] = swp->sw_hit.hit_normal[Y];
+	sbp->sb_norm[Z][j] = swp->sw_hit.hit_normal[Z];
+	sbp->sb_dir[X][j] = ap->a_ray.r_dir[X];
+	sbp->sb_dir[Y][j] = ap->a_ray.r_dir[Y];
+	sbp->sb_dir[Z][j] = ap->a_ray.r_dir[Z];
+	sbp->sb_uv[0][j] = swp->sw_uv.uv_u;
+	sbp->sb_uv[1][j] = swp->sw_uv.uv_v;
+    }
+}
+
+
+/**
+ * Prepare one shading point the way viewshade() would and append it
+ * to the batch.  Returns 0 if the point cannot be shaded (it is then
+ * not added), 1 otherwise.
+ */
+int
+shade_batch_add(struct shade_batch *sbp, struct application *ap, const struct partition *pp, struct shadework *swp)
+{
+    size_t i;
+
+    RT_CK_SHADE_BATCH(sbp);
+
+    if (!shade_prep(ap, pp, swp))
+	return 0;
+
+    if (sbp->sb_len >= sbp->sb_max)
+	shade_batch_alloc(sbp, sbp->sb_max * 2);
+
+    i = sbp->sb_len++;
+    sbp->sb_ap[i] = ap;
+    sbp->sb_pp[i] = pp;
+    sbp->sb_sw[i] = swp;
+    sbp->sb_regid[i] = pp->pt_regionp->reg_bit;
+    sbp->sb_status[i] = 0;
+    shade_batch_gather(sbp, &i, 1);
+
+    return 1;
+}
+
+
+/**
+ * Run one shader over the points idx[0..n-1] of a batch, through its
+ * mf_render_batch routine when it has one and through mf_render one
+ * point at a time otherwise.  Per-point results land in sb_status.
+ */
+void
+shade_batch_render(struct shade_batch *sbp, const size_t *idx, size_t n, const struct mfuncs *mfp, void *dp)
+{
+    size_t i;
+
+    RT_CK_SHADE_BATCH(sbp);
+    RT_CK_MF(mfp);
+
+    if (mfp->mf_render_batch) {
+	(void)mfp->mf_render_batch(sbp, idx, n, dp);
+	return;
+    }
+
+    for (i = 0; i < n; i++) {
+	size_t j = idx[i];
+
+	sbp->sb_status[j] = 1;
+	if (mfp->mf_render)
+	    sbp->sb_status[j] = mfp->mf_render(sbp->sb_ap[j], sbp->sb_pp[j], sbp->sb_sw[j], dp);
+    }
+
+    /* a scalar shader may have moved the hit point or bent the normal */
+    shade_batch_gather(sbp, idx, n);
+}
+
+
+static int
+shade_batch_cmp(const void *a, const void *b, void *arg)
+{
+    const struct shade_batch *sbp = (const struct shade_batch *)arg;
+    size_t i = *(const size_t *)a;
+    size_t j = *(const size_t *)b;
+
+    if (sbp->sb_regid[i] != sbp->sb_regid[j])
+	return sbp->sb_regid[i] < sbp->sb_regid[j] ? -1 : 1;
+    return (i > j) - (i < j);
+}
+
+
+/**
+ * Shade every point of the batch, one region (and hence one shader
+ * instance) at a time, then empty the batch so it can be refilled.
+ *
+ * Returns the number of points whose shader ran to completion.
+ */
+int
+viewshade_batch(struct shade_batch *sbp)
+{
+    size_t i, start, end;
+    int ok = 0;
+
+    RT_CK_SHADE_BATCH(sbp);
+
+    for (i = 0; i < sbp->sb_len; i++)
+	sbp->sb_order[i] = i;
+    bu_sort(sbp->sb_order, sbp->sb_len, sizeof(size_t), shade_batch_cmp, sbp);
+
+    for (start = 0; start < sbp->sb_len; start = end) {
+	const struct region *rp = sbp->sb_pp[sbp->sb_order[start]]->pt_regionp;
+
+	for (end = start + 1; end < sbp->sb_len; end++) {
+	    if (sbp->sb_regid[sbp->sb_order[end]] != rp->reg_bit)
+		break;
+	}
+
+	shade_batch_render(sbp, sbp->sb_order + start, end - start,
+			   (const struct mfuncs *)rp->reg_mfuncs, rp->reg_udata);
+    }
+
+    for (i = 0; i < sbp->sb_len; i++) {
+	if (OPTICAL_DEBUG&OPTICAL_DEBUG_SHADE) {
+	    pr_shadework("after mf_render", sbp->sb_sw[i]);
+	    bu_log("\n");
+	}
+	if (sbp->sb_status[i] == 1)
+	    ok++;
+    }
+
+    sbp->sb_len = 0;
+    return ok;
+}
+
+
 /*
  * Local Variables:
  * mode: C
@@ -0,0 +1,385 @@
+/*                   S H A D E _ B A T C H . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file shade_batch.c
+ *
+ * Shade the same set of hit points once through viewshade() and once
+ * through shade_batch_add()/viewshade_batch(), and check that both
+ * paths produce the same colors.  The scene mixes shaders with batch
+ * routines (plastic, light, stack) and without (camo), and carries a
+ * shadow-casting light so light_obs() fires rays from inside the
+ * batch.
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "vmath.h"
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "raytrace.h"
+#include "wdb.h"
+#include "optical.h"
+#include "optical/light.h"
+
+
+#define SB_DB "optical_shade_batch.g"
+#define SB_GRID 40
+#define SB_TOL 1.0e-6
+
+
+/* one hit point, kept alive until it has been shaded */
+struct sb_point {
+    struct application ap;
+    struct seg seg[2];
+    struct partition pt;
+    struct shadework sw;
+};
+
+
+/* [0] is shaded by viewshade(), [1] by viewshade_batch() */
+struct sb_hit {
+    struct sb_point p[2];
+};
+
+
+struct sb_hits {
+    struct sb_hit *hits;
+    size_t n;
+    size_t max;
+};
+
+
+static struct mfuncs *mfHead = MF_NULL;
+
+
+static void
+sb_point_save(struct sb_point *sp, const struct application *ap, const struct partition *pp)
+{
+    sp->ap = *ap;			/* struct copy */
+    sp->ap.a_uptr = (void *)pp->pt_regionp;
+
+    sp->seg[0] = *pp->pt_inseg;		/* struct copy */
+    sp->seg[1] = *pp->pt_outseg;	/* struct copy */
+    sp->seg[0].seg_in.hit_rayp = sp->seg[0].seg_out.hit_rayp = &sp->ap.a_ray;
+    sp->seg[1].seg_in.hit_rayp = sp->seg[1].seg_out.hit_rayp = &sp->ap.a_ray;
+
+    sp->pt = *pp;			/* struct copy */
+    sp->pt.pt_inseg = &sp->seg[0];
+    sp->pt.pt_outseg = &sp->seg[1];
+    sp->pt.pt_inhit = (pp->pt_inhit == &pp->pt_inseg->seg_in) ? &sp->seg[0].seg_in : &sp->seg[0].seg_out;
+    sp->pt.pt_outhit = (pp->pt_outhit == &pp->pt_outseg->seg_in) ? &sp->seg[1].seg_in : &sp->seg[1].seg_out;
+    sp->pt.pt_overlap_reg = NULL;
+
+    /* same starting point colorview() gives viewshade() */
+    memset(&sp->sw, 0, sizeof(sp->sw));
+    sp->sw.sw_transmit = sp->sw.sw_reflect = 0.0;
+    sp->sw.sw_refrac_index = 1.0;
+    sp->sw.sw_extinction = 0;
+    sp->sw.sw_xmitonly = 0;
+    sp->sw.sw_inputs = 0;
+    VSETALL(sp->sw.sw_color, 1);
+    VSETALL(sp->sw.sw_basecolor, 1);
+}
+
+
+static int
+sb_hit(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs))
+{
+    struct sb_hits *hp = (struct sb_hits *)ap->a_uptr;
+    struct partition *pp;
+    struct sb_hit *h;
+
+    for (pp = PartHeadp->pt_forw; pp != PartHeadp; pp = pp->pt_forw)
+	if (pp->pt_outhit->hit_dist >= 0.0)
+	    break;
+    if (pp == PartHeadp || hp->n >= hp->max)
+	return 0;
+
+    h = &hp->hits[hp->n++];
+    sb_point_save(&h->p[0], ap, pp);
+    sb_point_save(&h->p[1], ap, pp);
+    return 1;
+}
+
+
+static int
+sb_miss(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+
+static void
+sb_region(struct rt_wdb *wdbp, const char *name, const char *solid, const char *shader, const char *args, unsigned char r, unsigned char g, unsigned char b)
+{
+    struct wmember wm;
+    unsigned char rgb[3];
+
+    rgb[0] = r;
+    rgb[1] = g;
+    rgb[2] = b;
+
+    BU_LIST_INIT(&wm.l);
+    (void)mk_addmember(solid, &wm.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, name, &wm, 1, shader, args, rgb, 0);
+}
+
+
+static void
+sb_make_db(void)
+{
+    struct rt_wdb *wdbp;
+    struct wmember wm;
+    point_t p1, p2;
+
+    wdbp = wdb_fopen(SB_DB);
+    if (!wdbp)
+	bu_exit(1, "ERROR: unable to create %s\n", SB_DB);
+
+    VSET(p1, 0, 0, 0);
+    mk_sph(wdbp, "ball.s", p1, 40.0);
+    VSET(p1, -100, -100, -60);
+    VSET(p2, 100, 100, -50);
+    mk_rpp(wdbp, "plate.s", p1, p2);
+    VSET(p1, 45, 30, -50);
+    VSET(p2, 85, 70, -10);
+    mk_rpp(wdbp, "box.s", p1, p2);
+    VSET(p1, -60, 60, 70);
+    mk_sph(wdbp, "lamp.s", p1, 8.0);
+    VSET(p1, 200, -150, 300);
+    mk_sph(wdbp, "sun.s", p1, 5.0);
+
+    sb_region(wdbp, "ball.r", "ball.s", "plastic", "sp=.7 di=.3 sh=12", 200, 60, 40);
+    sb_region(wdbp, "plate.r", "plate.s", "stack", "camo;plastic", 90, 160, 90);
+    sb_region(wdbp, "box.r", "box.s", "camo", "", 40, 80, 200);
+    sb_region(wdbp, "lamp.r", "lamp.s", "light", "s=0 v=1", 255, 255, 255);
+    sb_region(wdbp, "sun.r", "sun.s", "light", "i=1 s=1 v=0", 255, 255, 255);
+
+    BU_LIST_INIT(&wm.l);
+    (void)mk_addmember("ball.r", &wm.l, NULL, WMOP_UNION);
+    (void)mk_addmember("plate.r", &wm.l, NULL, WMOP_UNION);
+    (void)mk_addmember("box.r", &wm.l, NULL, WMOP_UNION);
+    (void)mk_addmember("lamp.r", &wm.l, NULL, WMOP_UNION);
+    (void)mk_addmember("sun.r", &wm.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, "scene", &wm, 0, NULL, NULL, NULL, 0);
+
+    wdb_close(wdbp);
+}
+
+
+/* same per-region shader setup rt's view_setup() performs */
+static void
+sb_setup(struct rt_i *rtip)
+{
+    struct region *regp;
+
+    optical_shader_init(&mfHead);
+
+    regp = BU_LIST_FIRST(region, &rtip->HeadRegion);
+    while (BU_LIST_NOT_HEAD(regp, &rtip->HeadRegion)) {
+	switch (mlib_setup(&mfHead, regp, rtip)) {
+	    case 0:
+		{
+		    struct region *r = BU_LIST_NEXT(region, &regp->l);
+		    rt_del_regtree(rtip, regp, &rt_uniresource);
+		    regp = r;
+		    continue;
+		}
+	    case 1:
+		break;
+	    case 2:
+		bu_ptbl_ins(&rtip->delete_regs, (long *)regp);
+		break;
+	    default:
+		bu_exit(1, "ERROR: mlib_setup failed on %s\n", regp->reg_name);
+	}
+	regp = BU_LIST_NEXT(region, &regp->l);
+    }
+}
+
+
+static void
+sb_cleanup(struct rt_i *rtip)
+{
+    struct region *regp;
+
+    for (BU_LIST_FOR(regp, region, &(rtip->HeadRegion)))
+	mlib_free(regp);
+    light_cleanup();
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    struct rt_i *rtip;
+    struct resource res;
+    struct application ap;
+    struct shade_batch sb;
+    struct sb_hits hits;
+    struct bu_ptbl regions = BU_PTBL_INIT_ZERO;
+    size_t i, half;
+    int x, y, ok;
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (argc != 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    bu_file_delete(SB_DB);
+    sb_make_db();
+
+    rtip = rt_dirbuild(SB_DB, NULL, 0);
+    if (rtip == RTI_NULL)
+	bu_exit(1, "ERROR: unable to open %s\n", SB_DB);
+    if (rt_gettree(rtip, "scene") < 0)
+	bu_exit(1, "ERROR: unable to load scene\n");
+
+    memset(&res, 0, sizeof(res));
+    rt_init_resource(&res, 0, rtip);
+
+    sb_setup(rtip);
+    rt_prep(rtip);
+
+    RT_APPLICATION_INIT(&ap);
+    ap.a_rt_i = rtip;
+    ap.a_resource = &res;
+    ap.a_hit = sb_hit;
+    ap.a_miss = sb_miss;
+    ap.a_onehit = 0;
+    rtip->rti_nlights = light_init(&ap);
+    if (rtip->rti_nlights < 2)
+	bu_exit(1, "ERROR: expected 2 lights, found %d\n", rtip->rti_nlights);
+
+    hits.max = SB_GRID * SB_GRID;
+    hits.n = 0;
+    hits.hits = (struct sb_hit *)bu_calloc(hits.max, sizeof(struct sb_hit), "sb_hits");
+    ap.a_uptr = (void *)&hits;
+
+    /* a tilted grid of rays over the whole scene */
+    for (y = 0; y < SB_GRID; y++) {
+	for (x = 0; x < SB_GRID; x++) {
+	    ap.a_x = x;
+	    ap.a_y = y;
+	    VSET(ap.a_ray.r_pt,
+		 -120.0 + 240.0 * x / (SB_GRID - 1),
+		 -120.0 + 240.0 * y / (SB_GRID - 1),
+		 300.0);
+	    VSET(ap.a_ray.r_dir, 0.15, 0.25, -1.0);
+	    VUNITIZE(ap.a_ray.r_dir);
+	    (void)rt_shootray(&ap);
+	}
+    }
+
+    for (i = 0; i < hits.n; i++) {
+	const struct region *rp = hits.hits[i].p[0].pt.pt_regionp;
+	bu_ptbl_ins_unique(&regions, (long *)rp);
+    }
+    if (BU_PTBL_LEN(&regions) < 4) {
+	bu_log("ERROR: only %zu regions hit out of %zu points\n", BU_PTBL_LEN(&regions), hits.n);
+	ret = 1;
+    }
+
+    /* reference colors, one point at a time */
+    for (i = 0; i < hits.n; i++) {
+	struct sb_point *sp = &hits.hits[i].p[0];
+	if (viewshade(&sp->ap, &sp->pt, &sp->sw) != 1) {
+	    bu_log("ERROR: viewshade failed on point %zu\n", i);
+	    ret = 1;
+	}
+    }
+
+    /* batched colors, in two fills of a deliberately small batch so
+     * both growth and reuse after viewshade_batch() are exercised
+     */
+    shade_batch_init(&sb, 16);
+    half = hits.n / 2;
+    for (i = 0; i < hits.n; i++) {
+	struct sb_point *sp = &hits.hits[i].p[1];
+
+	if (i == half) {
+	    ok = viewshade_batch(&sb);
+	    if (ok != (int)half) {
+		bu_log("ERROR: first batch shaded %d of %zu points\n", ok, half);
+		ret = 1;
+	    }
+	}
+	if (shade_batch_add(&sb, &sp->ap, &sp->pt, &sp->sw) != 1) {
+	    bu_log("ERROR: shade_batch_add failed on point %zu\n", i);
+	    ret = 1;
+	}
+    }
+    ok = viewshade_batch(&sb);
+    if (ok != (int)(hits.n - half)) {
+	bu_log("ERROR: second batch shaded %d of %zu points\n", ok, hits.n - half);
+	ret = 1;
+    }
+    for (i = 0; i < hits.n - half; i++) {
+	if (sb.sb_status[i] != 1) {
+	    bu_log("ERROR: point %zu finished with status %d\n", half + i, sb.sb_status[i]);
+	    ret = 1;
+	}
+    }
+    if (sb.sb_len != 0) {
+	bu_log("ERROR: batch not emptied, %zu points left\n", sb.sb_len);
+	ret = 1;
+    }
+    shade_batch_free(&sb);
+
+    for (i = 0; i < hits.n; i++) {
+	const struct shadework *s0 = &hits.hits[i].p[0].sw;
+	const struct shadework *s1 = &hits.hits[i].p[1].sw;
+
+	if (!VNEAR_EQUAL(s0->sw_color, s1->sw_color, SB_TOL)
+	    || !NEAR_EQUAL(s0->sw_transmit, s1->sw_transmit, SB_TOL)
+	    || !NEAR_EQUAL(s0->sw_reflect, s1->sw_reflect, SB_TOL)) {
+	    bu_log("ERROR: %s point %zu: viewshade (%g %g %g) t=%g r=%g, batch (%g %g %g) t=%g r=%g\n",
+		   hits.hits[i].p[0].pt.pt_regionp->reg_name, i,
+		   V3ARGS(s0->sw_color), s0->sw_transmit, s0->sw_reflect,
+		   V3ARGS(s1->sw_color), s1->sw_transmit, s1->sw_reflect);
+	    ret = 1;
+	}
+    }
+
+    bu_log("%zu points over %zu regions compared\n", hits.n, BU_PTBL_LEN(&regions));
+
+    bu_ptbl_free(&regions);
+    bu_free(hits.hits, "sb_hits");
+    sb_cleanup(rtip);
+    rt_clean_resource(rtip, &res);
+    rt_free_rti(rtip);
+    bu_file_delete(SB_DB);
+
+    return ret;
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,435 @@
+/*                     T E X C A C H E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file texcache.c
+ *
+ * Exercise the shared texture cache: reference counted sharing of
+ * images, the values of the reduced levels and which level a lookup
+ * reads, LRU eviction under a small LIBOPTICAL_TEXCACHE cap,
+ * concurrent lookups racing eviction, and the LIBOPTICAL_TEXFILTER
+ * opt-in to mip-map filtering.
+ *
+ * The cache is private to liboptical, so it is compiled in here
+ * directly rather than linked.
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "bu/app.h"
+#include "bu/env.h"
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "bu/parallel.h"
+#include "raytrace.h"
+
+#include "../texcache.c"
+
+
+#define TC_NTHREADS 4
+#define TC_NLOOKUPS 4000
+
+
+static unsigned char *
+tc_pixels(int w, int h)
+{
+    unsigned char *pix = (unsigned char *)bu_malloc((size_t)w * h * 3, "tc pixels");
+    int x, y;
+
+    for (y = 0; y < h; y++) {
+	for (x = 0; x < w; x++) {
+	    unsigned char *p = pix + ((size_t)y * w + x) * 3;
+	    p[0] = ((x / 4 + y / 4) & 1) ? 255 : 0;
+	    p[1] = (unsigned char)(x * 255 / (w - 1));
+	    p[2] = (unsigned char)((x * 7 + y * 13) & 0xff);
+	}
+    }
+    return pix;
+}
+
+
+static struct rt_binunif_internal *
+tc_binunif(int w, int h)
+{
+    struct rt_binunif_internal *bip;
+
+    BU_ALLOC(bip, struct rt_binunif_internal);
+    bip->magic = RT_BINUNIF_INTERNAL_MAGIC;
+    bip->type = DB5_MINORTYPE_BINU_8BITINT_U;
+    bip->count = (size_t)w * h * 3;
+    bip->u.uint8 = tc_pixels(w, h);
+    return bip;
+}
+
+
+/* the shaders only use the mip-map when asked to */
+static int
+tc_filter(void)
+{
+    int ret = 0;
+
+    bu_setenv("LIBOPTICAL_TEXFILTER", "", 1);
+    if (tex_image_mip()) {
+	bu_log("ERROR: mip-map filtering is on by default\n");
+	ret = 1;
+    }
+    bu_setenv("LIBOPTICAL_TEXFILTER", "box", 1);
+    if (tex_image_mip()) {
+	bu_log("ERROR: mip-map filtering is on with LIBOPTICAL_TEXFILTER=box\n");
+	ret = 1;
+    }
+    bu_setenv("LIBOPTICAL_TEXFILTER", "mip", 1);
+    if (!tex_image_mip()) {
+	bu_log("ERROR: mip-map filtering is off with LIBOPTICAL_TEXFILTER=mip\n");
+	ret = 1;
+    }
+
+    return ret;
+}
+
+
+static int
+tc_sharing(void)
+{
+    struct tex_image *a, *b, *c;
+    int ret = 0;
+
+    if (tex_image_get("tc share") != NULL) {
+	bu_log("ERROR: lookup of an image never added succeeded\n");
+	ret = 1;
+    }
+
+    a = tex_image_add("tc share", NULL, tc_binunif(16, 8), 16, 8, 3);
+    b = tex_image_add("tc share", NULL, tc_binunif(16, 8), 16, 8, 3);
+    c = tex_image_get("tc share");
+    if (a != b || a != c) {
+	bu_log("ERROR: one key gave three images %p %p %p\n", (void *)a, (void *)b, (void *)c);
+	return 1;
+    }
+    if (a->ti_refs != 3) {
+	bu_log("ERROR: shared image has %d references, expected 3\n", a->ti_refs);
+	ret = 1;
+    }
+    if (a->ti_nlevels != 5) {
+	bu_log("ERROR: 16x8 image has %d levels, expected 5\n", a->ti_nlevels);
+	ret = 1;
+    }
+
+    tex_image_put(c);
+    tex_image_put(b);
+    if (tex_image_get("tc share") != a) {
+	bu_log("ERROR: image released while still referenced\n");
+	ret = 1;
+    }
+    tex_image_put(a);
+    tex_image_put(a);
+    if (tex_image_get("tc share") != NULL) {
+	bu_log("ERROR: image still cached after its last reference\n");
+	ret = 1;
+    }
+
+    return ret;
+}
+
+
+/* box filter one level into the next, w x h, as the cache does */
+static unsigned char *
+tc_reduce(const unsigned char *src, int sw, int sh, int w, int h)
+{
+    unsigned char *dst = (unsigned char *)bu_malloc((size_t)w * h * 3, "tc level");
+    int x, y, c;
+
+    for (y = 0; y < h; y++) {
+	int y0 = 2 * y;
+	int y1 = 2 * y + 1 < sh ? 2 * y + 1 : sh - 1;
+
+	for (x = 0; x < w; x++) {
+	    int x0 = 2 * x;
+	    int x1 = 2 * x + 1 < sw ? 2 * x + 1 : sw - 1;
+
+	    for (c = 0; c < 3; c++) {
+		int sum = src[((size_t)y0 * sw + x0) * 3 + c] + src[((size_t)y0 * sw + x1) * 3 + c]
+		    + src[((size_t)y1 * sw + x0) * 3 + c] + src[((size_t)y1 * sw + x1) * 3 + c];
+		dst[((size_t)y * w + x) * 3 + c] = (unsigned char)((sum + 2) / 4);
+	    }
+	}
+    }
+    return dst;
+}
+
+
+static int
+tc_levels(void)
+{
+    const int w = 200, h = 136;
+    struct tex_image *tip;
+    unsigned char *ref, *next;
+    fastf_t out[3];
+    int level, x, y, c;
+    int ret = 0;
+
+    tip = tex_image_add("tc levels", NULL, tc_binunif(w, h), w, h, 3);
+    ref = tc_pixels(w, h);
+
+    /* a point footprint reads level 0 as is */
+    for (y = 0; y < h; y += 7) {
+	for (x = 0; x < w; x += 5) {
+	    tex_image_sample(tip, (x + 0.5) / w, (y + 0.5) / h, 0.0, 0.0, out);
+	    for (c = 0; c < 3; c++) {
+		if (!NEAR_EQUAL(out[c], ref[((size_t)y * w + x) * 3 + c], 1.0e-9)) {
+		    bu_log("ERROR: level 0 texel %d,%d[%d] is %g, expected %d\n", x, y, c, out[c], ref[((size_t)y * w + x) * 3 + c]);
+		    ret = 1;
+		}
+	    }
+	}
+    }
+
+    for (level = 1; level < tip->ti_nlevels; level++) {
+	const struct tex_level *lp = &tip->ti_levels[level];
+	const struct tex_level *pp = &tip->ti_levels[level - 1];
+
+	next = tc_reduce(ref, pp->lv_w, pp->lv_h, lp->lv_w, lp->lv_h);
+	bu_free(ref, "tc level");
+	ref = next;
+
+	for (y = 0; y < lp->lv_h; y++) {
+	    for (x = 0; x < lp->lv_w; x++) {
+		const unsigned char *want = ref + ((size_t)y * lp->lv_w + x) * 3;
+		const struct tex_tile *tp;
+		const unsigned char *got;
+
+		bu_semaphore_acquire(texcache.sem);
+		tp = tex_tile_get(tip, level, x, y, 1);
+		got = tp->t_pix + ((y % TEX_TILE) * TEX_TILE + (x % TEX_TILE)) * 3;
+		for (c = 0; c < 3; c++) {
+		    if (got[c] != want[c]) {
+			bu_log("ERROR: level %d texel %d,%d[%d] is %d, expected %d\n", level, x, y, c, got[c], want[c]);
+			ret = 1;
+		    }
+		}
+		bu_semaphore_release(texcache.sem);
+	    }
+	}
+
+	/* a footprint 2^level texels square, centered on a texel of
+	 * this level, reads exactly that texel
+	 */
+	if (lp->lv_w > 1 && lp->lv_h > 1) {
+	    fastf_t du = (fastf_t)(1 << level) / (2.0 * w);
+	    fastf_t dv = (fastf_t)(1 << level) / (2.0 * h);
+
+	    x = lp->lv_w / 2;
+	    y = lp->lv_h / 2;
+	    tex_image_sample(tip, (x + 0.5) / lp->lv_w, (y + 0.5) / lp->lv_h, du, dv, out);
+	    for (c = 0; c < 3; c++) {
+		fastf_t want = ref[((size_t)y * lp->lv_w + x) * 3 + c];
+		if (!NEAR_EQUAL(out[c], want, 1.0e-6)) {
+		    bu_log("ERROR: level %d lookup [%d] is %g, expected %g\n", level, c, out[c], want);
+		    ret = 1;
+		}
+	    }
+	}
+    }
+
+    /* a footprint larger than the image reads the single top texel */
+    tex_image_sample(tip, 0.5, 0.5, 2.0, 2.0, out);
+    for (c = 0; c < 3; c++) {
+	if (!NEAR_EQUAL(out[c], ref[c], 1.0e-6)) {
+	    bu_log("ERROR: top level [%d] is %g, expected %d\n", c, out[c], ref[c]);
+	    ret = 1;
+	}
+    }
+
+    bu_free(ref, "tc level");
+    tex_image_put(tip);
+    return ret;
+}
+
+
+static int
+tc_eviction(void)
+{
+    const int w = 2048, h = 2048;
+    size_t tile_bytes = TEX_TILE * TEX_TILE * 3;
+    struct tex_image *tip;
+    struct tex_level *lp;
+    struct tex_tile *tp;
+    size_t ntiles = 0;
+    fastf_t out[3];
+    int tx, ty;
+    int ret = 0;
+
+    tip = tex_image_add("tc evict", NULL, tc_binunif(w, h), w, h, 3);
+    lp = &tip->ti_levels[1];
+
+    /* level 1 alone is 3MB, three times the cap; visit the middle of
+     * each of its tiles in turn
+     */
+    for (ty = 0; ty < lp->lv_th; ty++) {
+	for (tx = 0; tx < lp->lv_tw; tx++) {
+	    tex_image_sample(tip,
+			     (tx * TEX_TILE + TEX_TILE / 2) / (fastf_t)lp->lv_w,
+			     (ty * TEX_TILE + TEX_TILE / 2) / (fastf_t)lp->lv_h,
+			     1.0 / w, 1.0 / h, out);
+	}
+    }
+
+    for (BU_LIST_FOR(tp, tex_tile, &texcache.lru))
+	ntiles++;
+    if (texcache.resident > texcache.limit) {
+	bu_log("ERROR: %zu bytes of tiles resident over a %zu byte cap\n", texcache.resident, texcache.limit);
+	ret = 1;
+    }
+    if (ntiles == 0 || ntiles * tile_bytes != texcache.resident) {
+	bu_log("ERROR: %zu tiles listed for %zu resident bytes\n", ntiles, texcache.resident);
+	ret = 1;
+    }
+
+    /* the last tile used is the newest, the first has been evicted */
+    tp = BU_LIST_FIRST(tex_tile, &texcache.lru);
+    if (tp->t_level != 1 || tp->t_index != (size_t)lp->lv_tw * lp->lv_th - 1) {
+	bu_log("ERROR: newest tile is level %d index %zu\n", tp->t_level, tp->t_index);
+	ret = 1;
+    }
+    if (lp->lv_tiles[0] != NULL) {
+	bu_log("ERROR: least recently used tile was not evicted\n");
+	ret = 1;
+    }
+
+    tex_image_put(tip);
+    if (texcache.resident != 0 || BU_LIST_NON_EMPTY(&texcache.lru)) {
+	bu_log("ERROR: %zu bytes of tiles left after the image was released\n", texcache.resident);
+	ret = 1;
+    }
+
+    return ret;
+}
+
+
+struct tc_thread_data {
+    struct tex_image *tip;
+    fastf_t *want;
+    int failed;
+};
+
+
+static void
+tc_lookup(int i, fastf_t *u, fastf_t *v, fastf_t *du, fastf_t *dv)
+{
+    unsigned int r = (unsigned int)i * 2654435761u;
+
+    *u = (r & 0xffff) / 65536.0;
+    *v = ((r >> 16) & 0xffff) / 65536.0;
+    *du = ((r >> 3) % 97) / 4096.0;
+    *dv = ((r >> 7) % 89) / 4096.0;
+}
+
+
+static void
+tc_thread(int cpu, void *data)
+{
+    struct tc_thread_data *tdp = (struct tc_thread_data *)data;
+    fastf_t u, v, du, dv, out[3];
+    int i, c;
+
+    for (i = 0; i < TC_NLOOKUPS; i++) {
+	int n = (i + cpu * (TC_NLOOKUPS / TC_NTHREADS)) % TC_NLOOKUPS;
+
+	tc_lookup(n, &u, &v, &du, &dv);
+	tex_image_sample(tdp->tip, u, v, du, dv, out);
+	for (c = 0; c < 3; c++) {
+	    if (!NEAR_EQUAL(out[c], tdp->want[n * 3 + c], 1.0e-9)) {
+		bu_semaphore_acquire(BU_SEM_GENERAL);
+		tdp->failed++;
+		bu_semaphore_release(BU_SEM_GENERAL);
+		break;
+	    }
+	}
+    }
+}
+
+
+static int
+tc_threads(void)
+{
+    const int w = 2048, h = 1536;
+    struct tc_thread_data td;
+    fastf_t u, v, du, dv;
+    int i;
+
+    td.tip = tex_image_add("tc threads", NULL, tc_binunif(w, h), w, h, 3);
+    td.want = (fastf_t *)bu_malloc(TC_NLOOKUPS * 3 * sizeof(fastf_t), "tc want");
+    td.failed = 0;
+
+    /* level values don't depend on what has been evicted, so serial
+     * lookups give the answers the racing ones must reproduce
+     */
+    for (i = 0; i < TC_NLOOKUPS; i++) {
+	tc_lookup(i, &u, &v, &du, &dv);
+	tex_image_sample(td.tip, u, v, du, dv, td.want + i * 3);
+    }
+
+    bu_parallel(tc_thread, TC_NTHREADS, &td);
+
+    if (td.failed)
+	bu_log("ERROR: %d concurrent lookups disagreed with serial ones\n", td.failed);
+    if (texcache.resident > texcache.limit) {
+	bu_log("ERROR: %zu bytes of tiles resident over a %zu byte cap\n", texcache.resident, texcache.limit);
+	td.failed++;
+    }
+
+    bu_free(td.want, "tc want");
+    tex_image_put(td.tip);
+    return td.failed ? 1 : 0;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (argc != 1)
+	bu_exit(1, "Usage: %s\n", argv[0]);
+
+    /* the cap is read when the first image is added */
+    bu_setenv("LIBOPTICAL_TEXCACHE", "1", 1);
+
+    ret |= tc_filter();
+    ret |= tc_sharing();
+    ret |= tc_levels();
+    ret |= tc_eviction();
+    ret |= tc_threads();
+
+    return ret;
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
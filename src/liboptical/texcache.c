@@ -0,0 +1,552 @@
+/*                      T E X C A C H E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file liboptical/texcache.c
+ *
+ * Shared, mip-mapped texture images.  See texcache.h.
+ *
+ * The image table, the LRU list and the tile slots of every level are
+ * protected by a single semaphore.  Level 0 and the pixels of a built
+ * tile never change, so they are read without it: a lookup that stays
+ * on level 0 never takes the semaphore, and one that needs reduced
+ * levels takes it once to find (or build) and pin its tiles and once
+ * more to unpin them.  Pinned tiles are never discarded.
+ */
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "bu/hash.h"
+#include "bu/list.h"
+#include "bu/malloc.h"
+#include "bu/parallel.h"
+#include "bu/str.h"
+#include "vmath.h"
+#include "raytrace.h"
+#include "./texcache.h"
+
+
+#define TEX_TILE	64	/* texels on a side of a mip-map tile */
+#define TEX_MAXANISO	8	/* most samples along an elongated footprint */
+#define TEX_MINTILES	64	/* never cap the cache below this many tiles */
+#define TEX_LIMIT_MB	256	/* default cap, LIBOPTICAL_TEXCACHE overrides */
+#define TEX_MAXSAMPLES	(2 * TEX_MAXANISO)	/* bilinear samples in one lookup */
+
+struct tex_tile {
+    struct bu_list l;		/* LRU order, most recently used first */
+    struct tex_image *t_image;
+    int t_level;
+    size_t t_index;
+    int t_pins;			/* lookups and builds reading t_pix */
+    unsigned char *t_pix;	/* TEX_TILE * TEX_TILE texels */
+};
+
+struct tex_level {
+    int lv_w, lv_h;		/* size in texels */
+    int lv_tw, lv_th;		/* size in tiles */
+    struct tex_tile **lv_tiles;
+};
+
+/* one bilinear sample: a 2x2 block of texels of one level */
+struct tex_sample {
+    int s_level;
+    int s_x[2], s_y[2];
+    fastf_t s_fx, s_fy;
+    fastf_t s_weight;
+    struct tex_tile *s_tiles[4];	/* pinned, when s_level > 0 */
+};
+
+static struct {
+    int sem;
+    bu_hash_tbl *images;	/* key -> struct tex_image */
+    struct bu_list lru;
+    size_t resident;		/* bytes of tile data */
+    size_t limit;
+} texcache = {0, NULL, BU_LIST_INIT_ZERO, 0, 0};
+
+
+/* caller holds texcache.sem */
+static void
+tex_cache_init(void)
+{
+    const char *env;
+    size_t mb = TEX_LIMIT_MB;
+    size_t tile_bytes = TEX_TILE * TEX_TILE * 3 + sizeof(struct tex_tile);
+
+    if (texcache.images)
+	return;
+
+    texcache.images = bu_hash_create(64);
+    BU_LIST_INIT(&texcache.lru);
+
+    env = getenv("LIBOPTICAL_TEXCACHE");
+    if (env && atoi(env) > 0)
+	mb = (size_t)atoi(env);
+    texcache.limit = mb * 1024 * 1024;
+    if (texcache.limit < TEX_MINTILES * tile_bytes)
+	texcache.limit = TEX_MINTILES * tile_bytes;
+}
+
+
+static void
+tex_tile_free(struct tex_tile *tp)
+{
+    struct tex_level *lp = &tp->t_image->ti_levels[tp->t_level];
+
+    BU_LIST_DEQUEUE(&tp->l);
+    lp->lv_tiles[tp->t_index] = NULL;
+    texcache.resident -= TEX_TILE * TEX_TILE * tp->t_image->ti_nchan;
+    bu_free(tp->t_pix, "tex_tile pix");
+    BU_PUT(tp, struct tex_tile);
+}
+
+
+/*
+ * Level 0 texel.  Like the shaders always have, read past the end of
+ * a short image by wrapping around.
+ */
+static const unsigned char *
+tex_texel0(const struct tex_image *tip, int x, int y)
+{
+    size_t avail = tip->ti_len / tip->ti_nchan;
+    size_t i = (size_t)y * tip->ti_w + x;
+
+    if (i >= avail)
+	i %= avail;
+    return tip->ti_pix + i * tip->ti_nchan;
+}
+
+
+static struct tex_tile *tex_tile_get(struct tex_image *tip, int level, int x, int y, int direct);
+
+
+/*
+ * Box filter one tile of a level from the level above it.  Since the
+ * tile size is even, the 2x2 parents of a texel always share a tile,
+ * and a tile has at most 2x2 parent tiles.  Those are pinned for the
+ * whole build, so building one of them cannot evict another that is
+ * still to be read.
+ *
+ * A tile only built to feed another one goes to the old end of the
+ * LRU list, so deriving a small level does not push out the tiles
+ * lookups are actually reading.
+ */
+static struct tex_tile *
+tex_tile_build(struct tex_image *tip, int level, size_t index, int direct)
+{
+    struct tex_level *lp = &tip->ti_levels[level];
+    const struct tex_level *pp = &tip->ti_levels[level-1];
+    int nchan = tip->ti_nchan;
+    int x0 = (int)(index % lp->lv_tw) * TEX_TILE;
+    int y0 = (int)(index / lp->lv_tw) * TEX_TILE;
+    struct tex_tile *parents[4] = {NULL, NULL, NULL, NULL};
+    struct tex_tile *tp, *old, *prev;
+    int x, y, c, k;
+
+    for (k = 0; level > 1 && k < 4; k++) {
+	int px = 2*x0 + (k & 1) * TEX_TILE;
+	int py = 2*y0 + (k >> 1) * TEX_TILE;
+
+	if (px < pp->lv_w && py < pp->lv_h) {
+	    parents[k] = tex_tile_get(tip, level-1, px, py, 0);
+	    parents[k]->t_pins++;
+	}
+    }
+
+    BU_GET(tp, struct tex_tile);
+    tp->t_image = tip;
+    tp->t_level = level;
+    tp->t_index = index;
+    tp->t_pins = 0;
+    tp->t_pix = (unsigned char *)bu_calloc(TEX_TILE * TEX_TILE, nchan, "tex_tile pix");
+
+    for (y = y0; y < y0 + TEX_TILE && y < lp->lv_h; y++) {
+	int py0 = 2*y;
+	int py1 = 2*y+1 < pp->lv_h ? 2*y+1 : pp->lv_h-1;
+
+	for (x = x0; x < x0 + TEX_TILE && x < lp->lv_w; x++) {
+	    int px0 = 2*x;
+	    int px1 = 2*x+1 < pp->lv_w ? 2*x+1 : pp->lv_w-1;
+	    const unsigned char *a, *b, *d, *e;
+	    unsigned char *out = tp->t_pix + ((y - y0) * TEX_TILE + (x - x0)) * nchan;
+
+	    if (level == 1) {
+		a = tex_texel0(tip, px0, py0);
+		b = tex_texel0(tip, px1, py0);
+		d = tex_texel0(tip, px0, py1);
+		e = tex_texel0(tip, px1, py1);
+	    } else {
+		/* one tile holds all four */
+		const struct tex_tile *ptp = parents[(py0 - 2*y0 >= TEX_TILE ? 2 : 0) + (px0 - 2*x0 >= TEX_TILE ? 1 : 0)];
+		const unsigned char *base = ptp->t_pix;
+		int ox = (px0 / TEX_TILE) * TEX_TILE;
+		int oy = (py0 / TEX_TILE) * TEX_TILE;
+
+		a = base + ((py0 - oy) * TEX_TILE + (px0 - ox)) * nchan;
+		b = base + ((py0 - oy) * TEX_TILE + (px1 - ox)) * nchan;
+		d = base + ((py1 - oy) * TEX_TILE + (px0 - ox)) * nchan;
+		e = base + ((py1 - oy) * TEX_TILE + (px1 - ox)) * nchan;
+	    }
+
+	    for (c = 0; c < nchan; c++)
+		out[c] = (unsigned char)((a[c] + b[c] + d[c] + e[c] + 2) / 4);
+	}
+    }
+
+    for (k = 0; k < 4; k++) {
+	if (parents[k])
+	    parents[k]->t_pins--;
+    }
+
+    /* make room, oldest first, passing over tiles being read */
+    for (old = BU_LIST_LAST(tex_tile, &texcache.lru);
+	 BU_LIST_NOT_HEAD(old, &texcache.lru)
+	     && texcache.resident + TEX_TILE * TEX_TILE * nchan > texcache.limit;
+	 old = prev) {
+	prev = BU_LIST_PLAST(tex_tile, old);
+	if (!old->t_pins)
+	    tex_tile_free(old);
+    }
+
+    lp->lv_tiles[index] = tp;
+    texcache.resident += TEX_TILE * TEX_TILE * nchan;
+    if (direct) {
+	BU_LIST_APPEND(&texcache.lru, &tp->l);
+    } else {
+	BU_LIST_INSERT(&texcache.lru, &tp->l);
+    }
+
+    return tp;
+}
+
+
+/*
+ * Find or build the tile holding texel (x, y) of a level.  Only
+ * direct (lookup) uses count as a use for the LRU order.  Caller
+ * holds texcache.sem.
+ */
+static struct tex_tile *
+tex_tile_get(struct tex_image *tip, int level, int x, int y, int direct)
+{
+    struct tex_level *lp = &tip->ti_levels[level];
+    size_t index = (size_t)(y / TEX_TILE) * lp->lv_tw + (x / TEX_TILE);
+    struct tex_tile *tp = lp->lv_tiles[index];
+
+    if (!tp)
+	return tex_tile_build(tip, level, index, direct);
+
+    if (direct && texcache.lru.forw != &tp->l) {
+	BU_LIST_DEQUEUE(&tp->l);
+	BU_LIST_APPEND(&texcache.lru, &tp->l);
+    }
+    return tp;
+}
+
+
+int
+tex_image_mip(void)
+{
+    const char *env = getenv("LIBOPTICAL_TEXFILTER");
+
+    return env && BU_STR_EQUAL(env, "mip");
+}
+
+
+struct tex_image *
+tex_image_get(const char *key)
+{
+    struct tex_image *tip = NULL;
+
+    if (!texcache.images)
+	return NULL;
+
+    bu_semaphore_acquire(texcache.sem);
+    tip = (struct tex_image *)bu_hash_get(texcache.images, (const uint8_t *)key, strlen(key));
+    if (tip)
+	tip->ti_refs++;
+    bu_semaphore_release(texcache.sem);
+
+    return tip;
+}
+
+
+struct tex_image *
+tex_image_add(const char *key, struct bu_mapped_file *mp, struct rt_binunif_internal *bip, int w, int h, int nchan)
+{
+    struct tex_image *tip;
+    int i;
+
+    texcache.sem = bu_semaphore_register("OPTICAL_SEM_TEXCACHE");
+
+    bu_semaphore_acquire(texcache.sem);
+    tex_cache_init();
+
+    tip = (struct tex_image *)bu_hash_get(texcache.images, (const uint8_t *)key, strlen(key));
+    if (tip) {
+	tip->ti_refs++;
+	bu_semaphore_release(texcache.sem);
+	if (mp)
+	    bu_close_mapped_file(mp);
+	if (bip)
+	    rt_binunif_free(bip);
+	return tip;
+    }
+
+    BU_ALLOC(tip, struct tex_image);
+    bu_vls_init(&tip->ti_key);
+    bu_vls_strcpy(&tip->ti_key, key);
+    tip->ti_refs = 1;
+    tip->ti_w = w;
+    tip->ti_h = h;
+    tip->ti_nchan = nchan;
+    tip->ti_mp = mp;
+    tip->ti_binunifp = bip;
+    if (mp) {
+	tip->ti_pix = (const unsigned char *)mp->buf;
+	tip->ti_len = mp->buflen;
+    } else if (bip) {
+	tip->ti_pix = (const unsigned char *)bip->u.uint8;
+	tip->ti_len = bip->count;
+    }
+
+    /* level 0 is the image, so it has no tiles */
+    for (tip->ti_nlevels = 1; (w >> tip->ti_nlevels) > 0 || (h >> tip->ti_nlevels) > 0; tip->ti_nlevels++)
+	;
+    tip->ti_levels = (struct tex_level *)bu_calloc(tip->ti_nlevels, sizeof(struct tex_level), "tex_levels");
+    for (i = 0; i < tip->ti_nlevels; i++) {
+	struct tex_level *lp = &tip->ti_levels[i];
+
+	lp->lv_w = (w >> i) > 0 ? (w >> i) : 1;
+	lp->lv_h = (h >> i) > 0 ? (h >> i) : 1;
+	lp->lv_tw = (lp->lv_w + TEX_TILE - 1) / TEX_TILE;
+	lp->lv_th = (lp->lv_h + TEX_TILE - 1) / TEX_TILE;
+	if (i > 0)
+	    lp->lv_tiles = (struct tex_tile **)bu_calloc((size_t)lp->lv_tw * lp->lv_th, sizeof(struct tex_tile *), "tex_level tiles");
+    }
+
+    bu_hash_set(texcache.images, (const uint8_t *)key, strlen(key), tip);
+    bu_semaphore_release(texcache.sem);
+
+    return tip;
+}
+
+
+void
+tex_image_put(struct tex_image *tip)
+{
+    struct tex_tile *tp, *next;
+    int i;
+
+    if (!tip)
+	return;
+
+    bu_semaphore_acquire(texcache.sem);
+    if (--tip->ti_refs > 0) {
+	bu_semaphore_release(texcache.sem);
+	return;
+    }
+
+    bu_hash_rm(texcache.images, (const uint8_t *)bu_vls_cstr(&tip->ti_key), bu_vls_strlen(&tip->ti_key));
+    for (tp = BU_LIST_FIRST(tex_tile, &texcache.lru); BU_LIST_NOT_HEAD(tp, &texcache.lru); tp = next) {
+	next = BU_LIST_PNEXT(tex_tile, tp);
+	if (tp->t_image == tip)
+	    tex_tile_free(tp);
+    }
+    bu_semaphore_release(texcache.sem);
+
+    for (i = 1; i < tip->ti_nlevels; i++)
+	bu_free(tip->ti_levels[i].lv_tiles, "tex_level tiles");
+    bu_free(tip->ti_levels, "tex_levels");
+
+    if (tip->ti_mp)
+	bu_close_mapped_file(tip->ti_mp);
+    if (tip->ti_binunifp)
+	rt_binunif_free(tip->ti_binunifp);
+    bu_vls_free(&tip->ti_key);
+    bu_free(tip, "tex_image");
+}
+
+
+/*
+ * Work out which texels of a level a bilinear sample at (u, v) reads
+ * and how they are weighted.  Touches no cache state.
+ */
+static void
+tex_sample_setup(const struct tex_image *tip, int level, fastf_t u, fastf_t v, fastf_t weight, struct tex_sample *sp)
+{
+    const struct tex_level *lp = &tip->ti_levels[level];
+    fastf_t x = u * lp->lv_w - 0.5;
+    fastf_t y = v * lp->lv_h - 0.5;
+    int x0, y0, x1, y1;
+
+    x0 = (int)floor(x);
+    y0 = (int)floor(y);
+    sp->s_fx = x - x0;
+    sp->s_fy = y - y0;
+    x1 = x0 + 1;
+    y1 = y0 + 1;
+    CLAMP(x0, 0, lp->lv_w - 1);
+    CLAMP(x1, 0, lp->lv_w - 1);
+    CLAMP(y0, 0, lp->lv_h - 1);
+    CLAMP(y1, 0, lp->lv_h - 1);
+
+    sp->s_level = level;
+    sp->s_x[0] = x0;
+    sp->s_x[1] = x1;
+    sp->s_y[0] = y0;
+    sp->s_y[1] = y1;
+    sp->s_weight = weight;
+}
+
+
+/*
+ * Texel k (x index in bit 0, y index in bit 1) of a sample.  Level 0
+ * is read straight from the image, other levels from the sample's
+ * pinned tiles.
+ */
+static const unsigned char *
+tex_sample_texel(const struct tex_image *tip, const struct tex_sample *sp, int k)
+{
+    int x = sp->s_x[k & 1];
+    int y = sp->s_y[k >> 1];
+
+    if (sp->s_level == 0)
+	return tex_texel0(tip, x, y);
+
+    return sp->s_tiles[k]->t_pix + ((y % TEX_TILE) * TEX_TILE + (x % TEX_TILE)) * tip->ti_nchan;
+}
+
+
+static void
+tex_bilinear(const struct tex_image *tip, const struct tex_sample *sp, fastf_t *out)
+{
+    const unsigned char *t00 = tex_sample_texel(tip, sp, 0);
+    const unsigned char *t10 = tex_sample_texel(tip, sp, 1);
+    const unsigned char *t01 = tex_sample_texel(tip, sp, 2);
+    const unsigned char *t11 = tex_sample_texel(tip, sp, 3);
+    int c;
+
+    for (c = 0; c < tip->ti_nchan; c++) {
+	fastf_t top = t00[c] + sp->s_fx * (t10[c] - t00[c]);
+	fastf_t bot = t01[c] + sp->s_fx * (t11[c] - t01[c]);
+	out[c] += sp->s_weight * (top + sp->s_fy * (bot - top));
+    }
+}
+
+
+void
+tex_image_sample(struct tex_image *tip, fastf_t u, fastf_t v, fastf_t du, fastf_t dv, fastf_t *out)
+{
+    struct tex_sample samples[TEX_MAXSAMPLES];
+    fastf_t wu, wv, major, minor, lod, frac;
+    fastf_t step_u = 0.0, step_v = 0.0;
+    int taps = 1;
+    int nsamples = 0;
+    int pinned;
+    int l0, l1, c, t, k;
+
+    for (c = 0; c < tip->ti_nchan; c++)
+	out[c] = 0.0;
+    /* nothing to filter without at least one whole texel */
+    if (tip->ti_len < (size_t)tip->ti_nchan)
+	return;
+
+    /* footprint size, in level 0 texels */
+    wu = 2.0 * (du > 0.0 ? du : 0.0) * tip->ti_w;
+    wv = 2.0 * (dv > 0.0 ? dv : 0.0) * tip->ti_h;
+    major = wu > wv ? wu : wv;
+    minor = wu > wv ? wv : wu;
+
+    /* a long thin footprint gets several samples along its length,
+     * each filtered to the width of the short side
+     */
+    if (major > 1.0) {
+	if (minor < major / TEX_MAXANISO)
+	    minor = major / TEX_MAXANISO;
+	taps = (int)ceil(major / minor);
+	if (taps > TEX_MAXANISO)
+	    taps = TEX_MAXANISO;
+	if (wu > wv)
+	    step_u = 2.0 * du / taps;
+	else
+	    step_v = 2.0 * dv / taps;
+    }
+
+    lod = minor > 1.0 ? log2(minor) : 0.0;
+    if (lod > tip->ti_nlevels - 1)
+	lod = tip->ti_nlevels - 1;
+    l0 = (int)lod;
+    l1 = l0 + 1 < tip->ti_nlevels ? l0 + 1 : l0;
+    frac = lod - l0;
+
+    for (t = 0; t < taps; t++) {
+	fastf_t s = t - (taps - 1) * 0.5;
+	fastf_t su = u + s * step_u;
+	fastf_t sv = v + s * step_v;
+
+	tex_sample_setup(tip, l0, su, sv, (1.0 - frac) / taps, &samples[nsamples++]);
+	if (frac > 0.0)
+	    tex_sample_setup(tip, l1, su, sv, frac / taps, &samples[nsamples++]);
+    }
+
+    /* level 0 is only ever read, reduced levels need their tiles */
+    pinned = (l0 > 0 || frac > 0.0);
+    if (pinned) {
+	bu_semaphore_acquire(texcache.sem);
+	for (t = 0; t < nsamples; t++) {
+	    struct tex_sample *sp = &samples[t];
+
+	    if (sp->s_level == 0)
+		continue;
+	    for (k = 0; k < 4; k++) {
+		sp->s_tiles[k] = tex_tile_get(tip, sp->s_level, sp->s_x[k & 1], sp->s_y[k >> 1], 1);
+		sp->s_tiles[k]->t_pins++;
+	    }
+	}
+	bu_semaphore_release(texcache.sem);
+    }
+
+    for (t = 0; t < nsamples; t++)
+	tex_bilinear(tip, &samples[t], out);
+
+    if (pinned) {
+	bu_semaphore_acquire(texcache.sem);
+	for (t = 0; t < nsamples; t++) {
+	    if (samples[t].s_level == 0)
+		continue;
+	    for (k = 0; k < 4; k++)
+		samples[t].s_tiles[k]->t_pins--;
+	}
+	bu_semaphore_release(texcache.sem);
+    }
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
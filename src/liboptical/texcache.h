@@ -0,0 +1,109 @@
+/*                      T E X C A C H E . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file liboptical/texcache.h
+ *
+ * Process-wide cache of texture images for the image based shaders.
+ *
+ * Every region that references the same image shares one cache
+ * entry, which owns the mapped file or binary object holding the
+ * pixels.  Reduced (mip-map) levels are built on demand in square
+ * tiles, and the total memory they use is capped by discarding the
+ * least recently used tiles.  The cap is LIBOPTICAL_TEXCACHE
+ * megabytes, 256 by default.  Level 0 is the image itself and is not
+ * counted.
+ *
+ * The shaders only filter through the mip-map when
+ * LIBOPTICAL_TEXFILTER is "mip".  By default they keep their own box
+ * filtering, so existing renderings do not change.
+ */
+
+#ifndef LIBOPTICAL_TEXCACHE_H
+#define LIBOPTICAL_TEXCACHE_H
+
+#include "common.h"
+
+#include "bu/mapped_file.h"
+#include "bu/vls.h"
+#include "raytrace.h"
+
+struct tex_level;
+
+struct tex_image {
+    struct bu_vls ti_key;
+    int ti_refs;
+    int ti_w;				/* width of level 0, in texels */
+    int ti_h;				/* height of level 0, in texels */
+    int ti_nchan;			/* bytes per texel, 1 to 4 */
+    const unsigned char *ti_pix;	/* level 0 */
+    size_t ti_len;			/* bytes actually available at ti_pix */
+    struct bu_mapped_file *ti_mp;	/* owned source, when a file */
+    struct rt_binunif_internal *ti_binunifp; /* owned source, when an object */
+    int ti_nlevels;
+    struct tex_level *ti_levels;
+};
+
+__BEGIN_DECLS
+
+/**
+ * Returns a new reference to the cached image for key, or NULL.
+ */
+extern struct tex_image *tex_image_get(const char *key);
+
+/**
+ * Enter an image, read from either mp or bip, into the cache and
+ * return a reference to it.  The cache takes ownership of the
+ * source.  If key is already present its entry is returned instead
+ * and the given source is released.
+ */
+extern struct tex_image *tex_image_add(const char *key, struct bu_mapped_file *mp, struct rt_binunif_internal *bip, int w, int h, int nchan);
+
+/**
+ * Drop a reference; the last one releases the image and its tiles.
+ */
+extern void tex_image_put(struct tex_image *tip);
+
+/**
+ * Returns non-zero if LIBOPTICAL_TEXFILTER asks the shaders to use
+ * tex_image_sample() for footprints larger than a texel.
+ */
+extern int tex_image_mip(void);
+
+/**
+ * Filtered lookup of the footprint (u +/- du, v +/- dv), all in the
+ * 0..1 texture space.  The mip-map level is chosen from the shorter
+ * side of the footprint and blended between the two nearest levels;
+ * an elongated footprint is covered by several such samples spaced
+ * along its long side.  Writes ti_nchan values in the 0..255 range.
+ */
+extern void tex_image_sample(struct tex_image *tip, fastf_t u, fastf_t v, fastf_t du, fastf_t dv, fastf_t *out);
+
+__END_DECLS
+
+#endif /* LIBOPTICAL_TEXCACHE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
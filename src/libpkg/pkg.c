@@ -79,9 +79,14 @@
 
 #include <errno.h>
 
+#if !defined(HAVE_WINSOCK_H) && defined(HAVE_PTHREAD_H)
+#  include <pthread.h>
+#endif
+
 #include "bio.h"
 
 #include "pkg.h"
+#include "./pkg_lz4.h"
 
 #if defined(HAVE_GETHOSTBYNAME) && !defined(HAVE_DECL_GETHOSTBYNAME) && !defined(_WINSOCKAPI_)
 extern struct hostent *gethostbyname(const char *);
@@ -119,12 +124,15 @@ extern struct hostent *gethostbyname(const char *);
 
 #define PKG_CK(p) { \
 	if (p==PKC_NULL||p->pkc_magic!=PKG_MAGIC) { \
-		snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "%s: bad pointer %p line %d\n", __FILE__, (void *)(p), __LINE__); \
-		_pkg_errlog(_pkg_errbuf);abort(); \
+		char _ckbuf[MAX_PKG_ERRBUF_SIZE]; \
+		snprintf(_ckbuf, MAX_PKG_ERRBUF_SIZE, "%s: bad pointer %p line %d\n", __FILE__, (void *)(p), __LINE__); \
+		_pkg_errlog(_ckbuf);abort(); \
 	} \
 }
 
 #define MAXQLEN 512	/* largest packet we will queue on stream */
+#define PKG_POLL_BYTES (64*1024)	/* output between input polls */
+#define PKG_LZ4_MINLEN 512	/* smallest message worth compressing */
 
 /* A macro for logging a string message when the debug file is open */
 #ifndef NO_DEBUG_CHECKING
@@ -137,7 +145,6 @@ int pkg_nochecking = 0;	/* set to disable extra checking for input */
 int pkg_permport = 0;	/* TCP port that pkg_permserver() is listening on XXX */
 
 #define MAX_PKG_ERRBUF_SIZE 128
-static char _pkg_errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
 static FILE *_pkg_debug = (FILE*)NULL;
 
 
@@ -201,13 +208,19 @@ static void
 _pkg_timestamp(void)
 {
     time_t now;
-    struct tm *tmp;
+    struct tm tmbuf;
+    struct tm *tmp = &tmbuf;
     int pid;
 
     if (!_pkg_debug)
 	return;
     (void)time(&now);
-    tmp = localtime(&now);
+    /* senders may log concurrently, so no shared static tm */
+#ifdef HAVE_WINSOCK_H
+    (void)localtime_s(&tmbuf, &now);
+#else
+    (void)localtime_r(&now, &tmbuf);
+#endif
 
     /* avoid libbu dependency */
 #ifdef HAVE_UNISTD_H
@@ -247,17 +260,86 @@ _pkg_errlog(const char *s)
 static void
 _pkg_perror(void (*errlog)(const char *msg), const char *s)
 {
-    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "%s: ", s);
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
+    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "%s: ", s);
 
-    if (errno >= 0 || strlen(_pkg_errbuf) >= MAX_PKG_ERRBUF_SIZE) {
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "%s: errno=%d\n", s, errno);
-	fprintf(stderr, "%s", _pkg_errbuf);
+    if (errno >= 0 || strlen(errbuf) >= MAX_PKG_ERRBUF_SIZE) {
+	snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "%s: errno=%d\n", s, errno);
+	fprintf(stderr, "%s", errbuf);
 	return;
     }
 
-    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "%s: %s\n", s, strerror(errno));
+    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "%s: %s\n", s, strerror(errno));
     if (errlog)
-	errlog(_pkg_errbuf);
+	errlog(errbuf);
+}
+
+
+/**
+ * Per-connection output lock, on native primitives since libpkg is
+ * kept free of a libbu dependency.  Without thread support the lock
+ * is a no-op.
+ *
+ * These are private implementation functions.
+ */
+static void *
+_pkg_lock_create(void)
+{
+#if defined(HAVE_WINSOCK_H)
+    CRITICAL_SECTION *cs = (CRITICAL_SECTION *)malloc(sizeof(CRITICAL_SECTION));
+    if (cs)
+	InitializeCriticalSection(cs);
+    return cs;
+#elif defined(HAVE_PTHREAD_H)
+    pthread_mutex_t *m = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
+    if (m && pthread_mutex_init(m, NULL) != 0) {
+	free(m);
+	m = NULL;
+    }
+    return m;
+#else
+    return NULL;
+#endif
+}
+
+
+static void
+_pkg_lock_destroy(void *lock)
+{
+    if (!lock)
+	return;
+#if defined(HAVE_WINSOCK_H)
+    DeleteCriticalSection((CRITICAL_SECTION *)lock);
+#elif defined(HAVE_PTHREAD_H)
+    pthread_mutex_destroy((pthread_mutex_t *)lock);
+#endif
+    free(lock);
+}
+
+
+static void
+_pkg_lock(struct pkg_conn *pc)
+{
+    if (!pc->pkc_lock)
+	return;
+#if defined(HAVE_WINSOCK_H)
+    EnterCriticalSection((CRITICAL_SECTION *)pc->pkc_lock);
+#elif defined(HAVE_PTHREAD_H)
+    pthread_mutex_lock((pthread_mutex_t *)pc->pkc_lock);
+#endif
+}
+
+
+static void
+_pkg_unlock(struct pkg_conn *pc)
+{
+    if (!pc->pkc_lock)
+	return;
+#if defined(HAVE_WINSOCK_H)
+    LeaveCriticalSection((CRITICAL_SECTION *)pc->pkc_lock);
+#elif defined(HAVE_PTHREAD_H)
+    pthread_mutex_unlock((pthread_mutex_t *)pc->pkc_lock);
+#endif
 }
 
 
@@ -309,6 +391,7 @@ _pkg_makeconn(int fd, const struct pkg_switch *switchp, void (*errlog)(const cha
     pc->pkc_curpos = (char *)0;
     pc->pkc_strpos = 0;
     pc->pkc_incur = pc->pkc_inend = 0;
+    pc->pkc_lock = _pkg_lock_create();
     return pc;
 }
 
@@ -344,6 +427,7 @@ _pkg_ck_debug(void)
 struct pkg_conn *
 pkg_open(const char *host, const char *service, const char *protocol, const char *uname, const char *UNUSED(passwd), const struct pkg_switch *switchp, void (*errlog)(const char *msg))
 {
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
     if (strlen(host) == 5 && !strncmp(host, "STDIO", 5)) {
 	return _pkg_makeconn(PKG_STDIO_MODE, switchp, errlog);
     }
@@ -403,9 +487,9 @@ pkg_open(const char *host, const char *service, const char *protocol, const char
     } else {
 	struct servent *sp;
 	if ((sp = getservbyname(service, "tcp")) == NULL) {
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_open(%s, %s): unknown service\n",
+	    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_open(%s, %s): unknown service\n",
 		     host, service);
-	    errlog(_pkg_errbuf);
+	    errlog(errbuf);
 	    return PKC_ERROR;
 	}
 	saServer.sin_port = sp->s_port;
@@ -442,9 +526,9 @@ pkg_open(const char *host, const char *service, const char *protocol, const char
     } else {
 	struct servent *sp;
 	if ((sp = getservbyname(service, "tcp")) == NULL) {
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_open(%s, %s): unknown service\n",
+	    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_open(%s, %s): unknown service\n",
 		     host, service);
-	    errlog(_pkg_errbuf);
+	    errlog(errbuf);
 	    return PKC_ERROR;
 	}
 	sinhim.sin_port = sp->s_port;
@@ -457,9 +541,9 @@ pkg_open(const char *host, const char *service, const char *protocol, const char
 	sinhim.sin_addr.s_addr = inet_addr(host);
     } else {
 	if ((hp = gethostbyname(host)) == NULL) {
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_open(%s, %s): unknown host\n",
+	    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_open(%s, %s): unknown host\n",
 		     host, service);
-	    errlog(_pkg_errbuf);
+	    errlog(errbuf);
 	    return PKC_ERROR;
 	}
 	sinhim.sin_family = hp->h_addrtype;
@@ -531,6 +615,7 @@ pkg_transerver(const struct pkg_switch *switchp, void (*errlog)(const char *))
 static int
 _pkg_permserver_impl(struct in_addr iface, const char *service, const char *protocol, int backlog, void (*errlog)(const char *msg))
 {
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
     struct servent *sp;
     int pkg_listenfd;
 #ifdef HAVE_WINSOCK_H
@@ -576,10 +661,10 @@ _pkg_permserver_impl(struct in_addr iface, const char *service, const char *prot
 	saServer.sin_port = htons((unsigned short)atoi(service));
     } else {
 	if ((sp = getservbyname(service, "tcp")) == NULL) {
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE,
+	    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE,
 		     "pkg_permserver(%s, %d): unknown service\n",
 		     service, backlog);
-	    errlog(_pkg_errbuf);
+	    errlog(errbuf);
 	    return (int)PKC_ERROR;
 	}
 	saServer.sin_port = sp->s_port;
@@ -632,10 +717,10 @@ _pkg_permserver_impl(struct in_addr iface, const char *service, const char *prot
 	sinme.sin_port = htons((unsigned short)atoi(service));
     } else {
 	if ((sp = getservbyname(service, "tcp")) == NULL) {
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE,
+	    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE,
 		     "pkg_permserver(%s, %d): unknown service\n",
 		     service, backlog);
-	    errlog(_pkg_errbuf);
+	    errlog(errbuf);
 	    return -1;
 	}
 	sinme.sin_port = sp->s_port;
@@ -816,6 +901,7 @@ pkg_getclient(int fd, const struct pkg_switch *switchp, void (*errlog)(const cha
 void
 pkg_close(struct pkg_conn *pc)
 {
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
     PKG_CK(pc);
     if (_pkg_debug) {
 	_pkg_timestamp();
@@ -831,9 +917,9 @@ pkg_close(struct pkg_conn *pc)
     }
 
     if (pc->pkc_buf != (char *)0) {
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_close(%p): partial input pkg discarded, buf=%p\n",
+	snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_close(%p): partial input pkg discarded, buf=%p\n",
 		 (void *)pc, (void *)(pc->pkc_buf));
-	pc->pkc_errlog(_pkg_errbuf);
+	pc->pkc_errlog(errbuf);
 	(void)free(pc->pkc_buf);
     }
     if (pc->pkc_inbuf != (char *)0) {
@@ -841,6 +927,13 @@ pkg_close(struct pkg_conn *pc)
 	pc->pkc_inbuf = (char *)0;
 	pc->pkc_inlen = 0;
     }
+    if (pc->pkc_zbuf != (char *)0) {
+	(void)free(pc->pkc_zbuf);
+	pc->pkc_zbuf = (char *)0;
+	pc->pkc_zlen = 0;
+    }
+    _pkg_lock_destroy(pc->pkc_lock);
+    pc->pkc_lock = NULL;
 
     if (pc->pkc_fd != PKG_STDIO_MODE) {
 #ifdef HAVE_WINSOCK_H
@@ -905,6 +998,7 @@ _pkg_inget(struct pkg_conn *pc, char *buf, size_t count)
 static void
 _pkg_checkin(struct pkg_conn *pc, int nodelay)
 {
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
 
     struct timeval tv;
     fd_set bits;
@@ -949,10 +1043,10 @@ _pkg_checkin(struct pkg_conn *pc, int nodelay)
 	    (void)pkg_suckin(pc);
 	} else {
 	    /* Odd condition, bits! */
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE,
+	    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE,
 		     "_pkg_checkin: select returned %ld, bits=0\n",
 		     (long int)i);
-	    (pc->pkc_errlog)(_pkg_errbuf);
+	    (pc->pkc_errlog)(errbuf);
 	}
     } else if (i < 0) {
 	/* Error condition */
@@ -962,28 +1056,245 @@ _pkg_checkin(struct pkg_conn *pc, int nodelay)
 }
 
 
-int
-pkg_send(int type, const char *buf, size_t len, struct pkg_conn *pc)
+/**
+ * Write all of a gathered message to the connection, picking up
+ * after short writes.  Returns the number of bytes written, which is
+ * less than total only if the connection failed part way, or -1 if
+ * nothing could be written.
+ *
+ * This is a private implementation function.
+ */
+static ssize_t
+_pkg_writev(struct pkg_conn *pc, const struct pkg_iovec *vec, int cnt, size_t total, const char *what)
 {
+    int fd = (pc->pkc_fd == PKG_STDIO_MODE) ? pc->pkc_out_fd : pc->pkc_fd;
+    size_t done = 0;
+    ssize_t i;
+    int j;
 #ifdef HAVE_WRITEV
-    static struct iovec cmdvec[2];
+    struct iovec iov[PKG_IOV_MAX+1];
+    int n;
+#else
+    char tbuf[16*1024];
+    int merged = 0;
+
+    /*
+     * On the assumption that buffer copying is less expensive than
+     * having this transmission broken into several network packets
+     * (with TCP, each with a "push" bit set), merge it all into one
+     * buffer here, unless size is enormous.
+     */
+    if (total <= sizeof(tbuf)) {
+	size_t off = 0;
+	for (j = 0; j < cnt; j++) {
+	    memcpy(tbuf + off, vec[j].iov_base, vec[j].iov_len);
+	    off += vec[j].iov_len;
+	}
+	merged = 1;
+    }
 #endif
-    static struct pkg_header hdr;
+
+    while (done < total) {
+	size_t skip = done;
+#ifdef HAVE_WRITEV
+	/* rebuild the vector past whatever already went out */
+	n = 0;
+	for (j = 0; j < cnt; j++) {
+	    if (skip >= vec[j].iov_len) {
+		skip -= vec[j].iov_len;
+		continue;
+	    }
+	    iov[n].iov_base = (void *)((const char *)vec[j].iov_base + skip);
+	    iov[n].iov_len = vec[j].iov_len - skip;
+	    skip = 0;
+	    n++;
+	}
+
+	/*
+	 * TODO: set this FD to NONBIO.  If not all output got sent,
+	 * loop in select() waiting for capacity to go out, and reading
+	 * input as well.  Prevents deadlocking.
+	 */
+	errno = 0;
+	i = writev(fd, iov, n);
+#else
+	const char *bp = tbuf + done;
+	size_t blen = total - done;
+
+	if (!merged) {
+	    /* send the pieces one at a time */
+	    for (j = 0; j < cnt; j++) {
+		if (skip < vec[j].iov_len)
+		    break;
+		skip -= vec[j].iov_len;
+	    }
+	    bp = (const char *)vec[j].iov_base + skip;
+	    blen = vec[j].iov_len - skip;
+	}
+	errno = 0;
+	i = PKG_SEND(fd, bp, blen);
+#endif
+	if (i < 0) {
+	    if (errno == EINTR)
+		continue;
+	    if (errno != EBADF)
+		_pkg_perror(pc->pkc_errlog, what);
+	    break;
+	}
+	if (i == 0)
+	    break;
+	done += (size_t)i;
+    }
+
+    if (done == 0 && total > 0)
+	return -1;
+    return (ssize_t)done;
+}
+
+
+/**
+ * Write out the stream buffer.  Caller holds the output lock.
+ *
+ * This is a private implementation function.
+ */
+static int
+_pkg_flush_locked(struct pkg_conn *pc)
+{
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
+    struct pkg_iovec vec;
     ssize_t i;
 
-    PKG_CK(pc);
+    if (pc->pkc_strpos <= 0) {
+	pc->pkc_strpos = 0;	/* sanity for < 0 */
+	return 0;
+    }
 
-    if (_pkg_debug) {
-	_pkg_timestamp();
-	fprintf(_pkg_debug,
-		"pkg_send(type=%d, buf=%p, len=%llu, pc=%p)\n",
-		type, (void *)buf, (unsigned long long)len, (void *)pc);
-	fflush(_pkg_debug);
+    vec.iov_base = pc->pkc_stream;
+    vec.iov_len = (size_t)pc->pkc_strpos;
+    i = _pkg_writev(pc, &vec, 1, vec.iov_len, "pkg_flush: write");
+    if (i < 0)
+	return -1;
+    if (i != pc->pkc_strpos) {
+	snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_flush of %d, wrote %d\n",
+		 pc->pkc_strpos, (int)i);
+	(pc->pkc_errlog)(errbuf);
+	pc->pkc_strpos -= (int)i;
+	/* copy leftovers to front of stream */
+	memmove(pc->pkc_stream, pc->pkc_stream + i, (size_t)pc->pkc_strpos);
+	return (int)i;	/* amount of user data sent */
+    }
+    pc->pkc_strpos = 0;
+    return (int)i;
+}
+
+
+/**
+ * Queue a small message on the stream buffer.  Caller holds the
+ * output lock and has checked len against MAXQLEN.
+ *
+ * This is a private implementation function.
+ */
+static int
+_pkg_stream_locked(int type, const struct pkg_iovec *iov, int iovcnt, size_t len, struct pkg_conn *pc)
+{
+    struct pkg_header hdr;
+    int j;
+
+    if (len > PKG_STREAMLEN - sizeof(struct pkg_header) - pc->pkc_strpos)
+	(void)_pkg_flush_locked(pc);
+
+    pkg_pshort((char *)hdr.pkh_magic, (unsigned short)PKG_MAGIC);
+    pkg_pshort((char *)hdr.pkh_type, (unsigned short)type);	/* should see if valid type */
+    pkg_plong((char *)hdr.pkh_len, (unsigned long)len);
+
+    memcpy(&(pc->pkc_stream[pc->pkc_strpos]), (char *)&hdr, sizeof(struct pkg_header));
+    pc->pkc_strpos += sizeof(struct pkg_header);
+    for (j = 0; j < iovcnt; j++) {
+	memcpy(&(pc->pkc_stream[pc->pkc_strpos]), iov[j].iov_base, iov[j].iov_len);
+	pc->pkc_strpos += (int)iov[j].iov_len;
+    }
+
+    return (int)(len + sizeof(struct pkg_header));
+}
+
+
+/**
+ * Compress a gathered message into the connection's scratch buffer,
+ * laid out as a PKG_MAGIC_LZ4 message body.  Returns NULL when the
+ * message doesn't shrink, in which case it goes out as is.  Caller
+ * holds the output lock.
+ *
+ * This is a private implementation function.
+ */
+static const char *
+_pkg_compress(struct pkg_conn *pc, const struct pkg_iovec *iov, int iovcnt, size_t len, size_t *zlen)
+{
+    size_t bound = _pkg_lz4_bound(len) + 4;
+    size_t need = bound + ((iovcnt > 1) ? len : 0);
+    const char *src;
+    size_t clen;
+    int j;
+
+    if (pc->pkc_zlen < need) {
+	char *nbuf = (char *)realloc(pc->pkc_zbuf, need);
+	if (!nbuf)
+	    return NULL;
+	pc->pkc_zbuf = nbuf;
+	pc->pkc_zlen = need;
+    }
+
+    if (iovcnt == 1) {
+	src = (const char *)iov[0].iov_base;
+    } else {
+	/* the encoder wants its input contiguous */
+	char *cp = pc->pkc_zbuf + bound;
+	src = cp;
+	for (j = 0; j < iovcnt; j++) {
+	    memcpy(cp, iov[j].iov_base, iov[j].iov_len);
+	    cp += iov[j].iov_len;
+	}
     }
 
-    /* Check for any pending input, no delay */
-    /* Input may be read, but not acted upon, to prevent deep recursion */
-    _pkg_checkin(pc, 1);
+    clen = _pkg_lz4_compress(src, len, pc->pkc_zbuf + 4, bound - 4);
+    if (clen == 0 || clen + 4 >= len)
+	return NULL;
+
+    pkg_plong(pc->pkc_zbuf, (unsigned long)len);
+    *zlen = clen + 4;
+    return pc->pkc_zbuf;
+}
+
+
+/**
+ * Send one message.  Caller holds the output lock.
+ *
+ * This is a private implementation function.
+ */
+static int
+_pkg_sendv_locked(int type, const struct pkg_iovec *iov, int iovcnt, size_t len, struct pkg_conn *pc, const char *what)
+{
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
+    struct pkg_header hdr;
+    struct pkg_iovec vec[PKG_IOV_MAX+1];
+    unsigned short magic = PKG_MAGIC;
+    const char *zbuf = NULL;
+    size_t zlen = 0;
+    size_t wlen = len;
+    ssize_t i;
+    int cnt = 0;
+    int j;
+
+    /*
+     * Check for any pending input, no delay, once enough has been
+     * sent that the peer may be stuck writing to us.  A select() per
+     * message costs more than a small message itself.  Input may be
+     * read, but not acted upon, to prevent deep recursion.
+     */
+    pc->pkc_unpolled += len + sizeof(hdr);
+    if (!(pc->pkc_opts & PKG_OPT_NOPOLL) && pc->pkc_unpolled >= PKG_POLL_BYTES) {
+	pc->pkc_unpolled = 0;
+	_pkg_checkin(pc, 1);
+    }
 
     /* Flush any queued stream output first. */
     if (pc->pkc_strpos > 0) {
@@ -995,128 +1306,109 @@ pkg_send(int type, const char *buf, size_t len, struct pkg_conn *pc)
 	 */
 	if (len <= MAXQLEN && len <= PKG_STREAMLEN -
 	    sizeof(struct pkg_header) - pc->pkc_strpos) {
-	    (void)pkg_stream(type, buf, len, pc);
-	    return (pkg_flush(pc) < 0) ? -1 : (int)len;
+	    (void)_pkg_stream_locked(type, iov, iovcnt, len, pc);
+	    return (_pkg_flush_locked(pc) < 0) ? -1 : (int)len;
 	}
-	if (pkg_flush(pc) < 0)
+	if (_pkg_flush_locked(pc) < 0)
 	    return -1;	/* assumes 2nd write would fail too */
     }
 
-    pkg_pshort((char *)hdr.pkh_magic, (unsigned long)PKG_MAGIC);
-    pkg_pshort((char *)hdr.pkh_type, (unsigned short)type);	/* should see if valid type */
-    pkg_plong((char *)hdr.pkh_len, (unsigned long)len);
-
-#ifdef HAVE_WRITEV
-    cmdvec[0].iov_base = (void *)&hdr;
-    cmdvec[0].iov_len = sizeof(hdr);
-    cmdvec[1].iov_base = (void *)buf;
-    cmdvec[1].iov_len = len;
+    if ((pc->pkc_opts & PKG_OPT_LZ4) && (pc->pkc_peer_caps & PKG_CAP_LZ4)
+	&& type != PKG_TYPE_CTL && len >= PKG_LZ4_MINLEN)
+	zbuf = _pkg_compress(pc, iov, iovcnt, len, &zlen);
 
-    /*
-     * TODO: set this FD to NONBIO.  If not all output got sent, loop
-     * in select() waiting for capacity to go out, and reading input
-     * as well.  Prevents deadlocking.
-     */
-    if (pc->pkc_fd == PKG_STDIO_MODE) {
-	i = writev(pc->pkc_out_fd, cmdvec, (len>0)?2:1);
+    vec[cnt].iov_base = &hdr;
+    vec[cnt].iov_len = sizeof(hdr);
+    cnt++;
+    if (zbuf) {
+	magic = PKG_MAGIC_LZ4;
+	wlen = zlen;
+	vec[cnt].iov_base = zbuf;
+	vec[cnt].iov_len = zlen;
+	cnt++;
     } else {
-	i = writev(pc->pkc_fd, cmdvec, (len>0)?2:1);
-    }
-    if (i != (ssize_t)(len+sizeof(hdr))) {
-	if (i < 0) {
-	    _pkg_perror(pc->pkc_errlog, "pkg_send: writev");
-	    return -1;
+	for (j = 0; j < iovcnt; j++) {
+	    if (iov[j].iov_len > 0)
+		vec[cnt++] = iov[j];
 	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_send of %llu+%llu, wrote %d\n",
-		 (unsigned long long)sizeof(hdr), (unsigned long long)len, (int)i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	return i-sizeof(hdr);	/* amount of user data sent */
     }
-#else
-    /*
-     * On the assumption that buffer copying is less expensive than
-     * having this transmission broken into two network packets (with
-     * TCP, each with a "push" bit set), merge it all into one buffer
-     * here, unless size is enormous.
-     */
-    if (len + sizeof(hdr) <= 16*1024) {
-	char tbuf[16*1024] = {0};
 
-	memcpy(tbuf, (char *)&hdr, sizeof(hdr));
-	if (len > 0)
-	    memcpy(tbuf+sizeof(hdr), buf, len);
+    pkg_pshort((char *)hdr.pkh_magic, magic);
+    pkg_pshort((char *)hdr.pkh_type, (unsigned short)type);	/* should see if valid type */
+    pkg_plong((char *)hdr.pkh_len, (unsigned long)wlen);
 
-	errno = 0;
-	if (pc->pkc_fd == PKG_STDIO_MODE) {
-	    i = PKG_SEND(pc->pkc_out_fd, tbuf, len+sizeof(hdr));
-	} else {
-	    i = PKG_SEND(pc->pkc_fd, tbuf, len+sizeof(hdr));
-	}
-	if ((size_t)i != len+sizeof(hdr)) {
-	    if (i < 0) {
-		if (errno == EBADF)
-		    return -1;
-		_pkg_perror(pc->pkc_errlog, "pkg_send: tbuf write");
-		return -1;
-	    }
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_send of %zu, wrote %zd\n",
-		     len, i-(ssize_t)sizeof(hdr));
-	    (pc->pkc_errlog)(_pkg_errbuf);
-	    return (int)(i-sizeof(hdr));	/* amount of user data sent */
-	}
-	return (int)len;
-    }
-    /* Send them separately */
-    errno = 0;
-    if (pc->pkc_fd == PKG_STDIO_MODE) {
-	i = PKG_SEND(pc->pkc_out_fd, (char *)&hdr, sizeof(hdr));
-    } else {
-	i = PKG_SEND(pc->pkc_fd, (char *)&hdr, sizeof(hdr));
-    }
-    if (i != sizeof(hdr)) {
-	if (i < 0) {
-	    if (errno == EBADF)
-		return -1;
-	    _pkg_perror(pc->pkc_errlog, "pkg_send: header write");
+    i = _pkg_writev(pc, vec, cnt, wlen + sizeof(hdr), what);
+    if (i < 0)
+	return -1;
+    if ((size_t)i != wlen + sizeof(hdr)) {
+	snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "%s of %llu+%llu, wrote %ld\n",
+		 what, (unsigned long long)sizeof(hdr), (unsigned long long)wlen, (long)i);
+	(pc->pkc_errlog)(errbuf);
+	/* a partial compressed body doesn't map back onto user data */
+	if (zbuf || (size_t)i < sizeof(hdr))
 	    return -1;
-	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_send header of %llu, wrote %zd\n",
-		 (unsigned long long)sizeof(hdr), i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	return -1;		/* amount of user data sent */
+	return (int)(i - sizeof(hdr));	/* amount of user data sent */
     }
-    if (len <= 0)
-	return 0;
-    errno = 0;
-    if (pc->pkc_fd == PKG_STDIO_MODE) {
-	i = PKG_SEND(pc->pkc_out_fd, buf, len);
-    } else {
-	i = PKG_SEND(pc->pkc_fd, buf, len);
+    return (int)len;
+}
+
+
+/**
+ * Total up a gathered message, then send it under the output lock.
+ *
+ * This is a private implementation function.
+ */
+static int
+_pkg_sendv(int type, const struct pkg_iovec *iov, int iovcnt, struct pkg_conn *pc, const char *what)
+{
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
+    size_t len = 0;
+    int ret;
+    int j;
+
+    for (j = 0; j < iovcnt; j++)
+	len += iov[j].iov_len;
+
+    /* the header carries a 32 bit length */
+    if ((unsigned long long)len > 0xFFFFFFFFULL) {
+	snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "%s: message of %llu bytes is too large\n",
+		 what, (unsigned long long)len);
+	(pc->pkc_errlog)(errbuf);
+	return -1;
     }
-    if ((size_t)i != len) {
-	if (i < 0) {
-	    if (errno == EBADF)
-		return -1;
-	    _pkg_perror(pc->pkc_errlog, "pkg_send: write");
-	    return -1;
-	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_send of %zu, wrote %zd\n", len, i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	return i;		/* amount of user data sent */
+
+    _pkg_lock(pc);
+    ret = _pkg_sendv_locked(type, iov, iovcnt, len, pc, what);
+    _pkg_unlock(pc);
+    return ret;
+}
+
+
+int
+pkg_send(int type, const char *buf, size_t len, struct pkg_conn *pc)
+{
+    struct pkg_iovec iov[1];
+
+    PKG_CK(pc);
+
+    if (_pkg_debug) {
+	_pkg_timestamp();
+	fprintf(_pkg_debug,
+		"pkg_send(type=%d, buf=%p, len=%llu, pc=%p)\n",
+		type, (void *)buf, (unsigned long long)len, (void *)pc);
+	fflush(_pkg_debug);
     }
-#endif
-    return (int)len;
+
+    iov[0].iov_base = buf;
+    iov[0].iov_len = len;
+    return _pkg_sendv(type, iov, 1, pc, "pkg_send: write");
 }
 
 
 int
 pkg_2send(int type, const char *buf1, size_t len1, const char *buf2, size_t len2, struct pkg_conn *pc)
 {
-#ifdef HAVE_WRITEV
-    static struct iovec cmdvec[3];
-#endif
-    static struct pkg_header hdr;
-    ssize_t i;
+    struct pkg_iovec iov[2];
 
     PKG_CK(pc);
 
@@ -1128,165 +1420,46 @@ pkg_2send(int type, const char *buf1, size_t len1, const char *buf2, size_t len2
 	fflush(_pkg_debug);
     }
 
-    /* Check for any pending input, no delay */
-    /* Input may be read, but not acted upon, to prevent deep recursion */
-    _pkg_checkin(pc, 1);
+    iov[0].iov_base = buf1;
+    iov[0].iov_len = len1;
+    iov[1].iov_base = buf2;
+    iov[1].iov_len = len2;
+    return _pkg_sendv(type, iov, 2, pc, "pkg_2send: write");
+}
 
-    /* Flush any queued stream output first. */
-    if (pc->pkc_strpos > 0) {
-	if (pkg_flush(pc) < 0)
-	    return -1;	/* assumes 2nd write would fail too */
-    }
 
-    pkg_pshort((char *)hdr.pkh_magic, (unsigned short)PKG_MAGIC);
-    pkg_pshort((char *)hdr.pkh_type, (unsigned short)type);	/* should see if valid type */
-    pkg_plong((char *)hdr.pkh_len, (unsigned long)(len1+len2));
+int
+pkg_sendv(int type, const struct pkg_iovec *iov, int iovcnt, struct pkg_conn *pc)
+{
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
 
-#ifdef HAVE_WRITEV
-    cmdvec[0].iov_base = (void *)&hdr;
-    cmdvec[0].iov_len = sizeof(hdr);
-    cmdvec[1].iov_base = (void *)buf1;
-    cmdvec[1].iov_len = len1;
-    cmdvec[2].iov_base = (void *)buf2;
-    cmdvec[2].iov_len = len2;
+    PKG_CK(pc);
 
-    /*
-     * TODO: set this FD to NONBIO.  If not all output got sent, loop
-     * in select() waiting for capacity to go out, and reading input
-     * as well.  Prevents deadlocking.
-     */
-    if (pc->pkc_fd == PKG_STDIO_MODE) {
-	i = writev(pc->pkc_out_fd, cmdvec, 3);
-    } else {
-	i = writev(pc->pkc_fd, cmdvec, 3);
-    }
-    if (i != (ssize_t)(len1+len2+sizeof(hdr))) {
-	if (i < 0) {
-	    _pkg_perror(pc->pkc_errlog, "pkg_2send: writev");
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE,
-		     "pkg_send2(type=%d, buf1=x%lx, len1=%ld, buf2=x%lx, len2=%ld, pc=x%lx)\n",
-		     type, (unsigned long int)buf1, (long)len1,
-		     (unsigned long int)buf2, (long)len2, (unsigned long int)pc);
-	    (pc->pkc_errlog)(_pkg_errbuf);
-	    return -1;
-	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send of %llu+%llu+%llu, wrote %ld\n",
-		 (unsigned long long)sizeof(hdr), (unsigned long long)len1, (unsigned long long)len2, (long int)i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	return i-sizeof(hdr);	/* amount of user data sent */
-    }
-#else
-    /*
-     * On the assumption that buffer copying is less expensive than
-     * having this transmission broken into two network packets (with
-     * TCP, each with a "push" bit set), merge it all into one buffer
-     * here, unless size is enormous.
-     */
-    if (len1 + len2 + sizeof(hdr) <= 16*1024) {
-	char tbuf[16*1024] = {0};
-
-	memcpy(tbuf, (char *)&hdr, sizeof(hdr));
-	if (len1 > 0)
-	    memcpy(tbuf+sizeof(hdr), buf1, len1);
-	if (len2 > 0)
-	    memcpy(tbuf+sizeof(hdr)+len1, buf2, len2);
-	errno = 0;
-	if (pc->pkc_fd == PKG_STDIO_MODE) {
-	    i = PKG_SEND(pc->pkc_out_fd, tbuf, len1+len2+sizeof(hdr));
-	} else {
-	    i = PKG_SEND(pc->pkc_fd, tbuf, len1+len2+sizeof(hdr));
-	}
-	if ((size_t)i != len1+len2+sizeof(hdr)) {
-	    if (i < 0) {
-		if (errno == EBADF)
-		    return -1;
-		_pkg_perror(pc->pkc_errlog, "pkg_2send: tbuf write");
-		return -1;
-	    }
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send of %llu+%llu, wrote %zd\n",
-		     (unsigned long long)len1, (unsigned long long)len2, i-(ssize_t)sizeof(hdr));
-	    (pc->pkc_errlog)(_pkg_errbuf);
-	    return (int)(i-sizeof(hdr));	/* amount of user data sent */
-	}
-	return (int)(len1+len2);
-    }
-    /* Send it in three pieces */
-    errno = 0;
-    if (pc->pkc_fd == PKG_STDIO_MODE) {
-	i = (ssize_t)PKG_SEND(pc->pkc_out_fd, (char *)&hdr, sizeof(hdr));
-    } else {
-	i = (ssize_t)PKG_SEND(pc->pkc_fd, (char *)&hdr, sizeof(hdr));
-    }
-    if (i != sizeof(hdr)) {
-	if (i < 0) {
-	    if (errno == EBADF)
-		return -1;
-	    _pkg_perror(pc->pkc_errlog, "pkg_2send: header write");
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send write(%d, %p, %zu) ret=%zd\n",
-		     pc->pkc_fd, (void *)&hdr, sizeof(hdr), i);
-	    (pc->pkc_errlog)(_pkg_errbuf);
-	    return -1;
-	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send of %zu+%zu+%zu, wrote header=%zd\n",
-		 sizeof(hdr), len1, len2, i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	return -1;		/* amount of user data sent */
+    if (_pkg_debug) {
+	_pkg_timestamp();
+	fprintf(_pkg_debug,
+		"pkg_sendv(type=%d, iov=%p, iovcnt=%d, pc=%p)\n",
+		type, (void *)iov, iovcnt, (void *)pc);
+	fflush(_pkg_debug);
     }
 
-    errno = 0;
-    if (pc->pkc_fd == PKG_STDIO_MODE) {
-	i = PKG_SEND(pc->pkc_out_fd, buf1, len1);
-    } else {
-	i = PKG_SEND(pc->pkc_fd, buf1, len1);
-    }
-    if ((size_t)i != len1) {
-	if (i < 0) {
-	    if (errno == EBADF)
-		return -1;
-	    _pkg_perror(pc->pkc_errlog, "pkg_2send: write buf1");
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send write(%d, %p, %zu) ret=%zd\n",
-		     pc->pkc_fd, (void *)buf1, len1, i);
-	    (pc->pkc_errlog)(_pkg_errbuf);
-	    return -1;
-	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send of %zu+%zu+%zu, wrote len1=%zd\n",
-		 sizeof(hdr), len1, len2, i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	return i;		/* amount of user data sent */
+    if (iovcnt < 0 || iovcnt > PKG_IOV_MAX || (iovcnt > 0 && !iov)) {
+	snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_sendv: bad vector of %d pieces\n", iovcnt);
+	(pc->pkc_errlog)(errbuf);
+	return -1;
     }
-    if (len2 <= (size_t)0)
-	return i;
 
-    errno = 0;
-    if (pc->pkc_fd == PKG_STDIO_MODE) {
-	i = PKG_SEND(pc->pkc_out_fd, buf2, len2);
-    } else {
-	i = PKG_SEND(pc->pkc_fd, buf2, len2);
-    }
-    if (i != (ssize_t)len2) {
-	if (i < 0) {
-	    if (errno == EBADF)
-		return -1;
-	    _pkg_perror(pc->pkc_errlog, "pkg_2send: write buf2");
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send write(%d, %p, %zu) ret=%zd\n",
-		     pc->pkc_fd, (void *)buf2, len2, i);
-	    (pc->pkc_errlog)(_pkg_errbuf);
-	    return -1;
-	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_2send of %zu+%zu+%zu, wrote len2=%zd\n",
-		 sizeof(hdr), len1, len2, i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	return (int)(len1+i);		/* amount of user data sent */
-    }
-#endif
-    return (int)(len1+len2);
+    return _pkg_sendv(type, iov, iovcnt, pc, "pkg_sendv: write");
 }
 
 
 int
 pkg_stream(int type, const char *buf, size_t len, struct pkg_conn *pc)
 {
-    static struct pkg_header hdr;
+    struct pkg_iovec iov[1];
+    int ret;
+
+    PKG_CK(pc);
 
     if (_pkg_debug) {
 	_pkg_timestamp();
@@ -1299,27 +1472,21 @@ pkg_stream(int type, const char *buf, size_t len, struct pkg_conn *pc)
     if (len > MAXQLEN)
 	return pkg_send(type, buf, len, pc);
 
-    if (len > PKG_STREAMLEN - sizeof(struct pkg_header) - pc->pkc_strpos)
-	pkg_flush(pc);
+    iov[0].iov_base = buf;
+    iov[0].iov_len = len;
 
     /* Queue it */
-    pkg_pshort((char *)hdr.pkh_magic, (unsigned short)PKG_MAGIC);
-    pkg_pshort((char *)hdr.pkh_type, (unsigned short)type);	/* should see if valid type */
-    pkg_plong((char *)hdr.pkh_len, (unsigned long)len);
-
-    memcpy(&(pc->pkc_stream[pc->pkc_strpos]), (char *)&hdr, sizeof(struct pkg_header));
-    pc->pkc_strpos += sizeof(struct pkg_header);
-    memcpy(&(pc->pkc_stream[pc->pkc_strpos]), buf, len);
-    pc->pkc_strpos += (int)len;
-
-    return (int)(len + sizeof(struct pkg_header));
+    _pkg_lock(pc);
+    ret = _pkg_stream_locked(type, iov, 1, len, pc);
+    _pkg_unlock(pc);
+    return ret;
 }
 
 
 int
 pkg_flush(struct pkg_conn *pc)
 {
-    int i;
+    int ret;
 
     if (_pkg_debug) {
 	_pkg_timestamp();
@@ -1329,34 +1496,48 @@ pkg_flush(struct pkg_conn *pc)
 	fflush(_pkg_debug);
     }
 
-    if (pc->pkc_strpos <= 0) {
-	pc->pkc_strpos = 0;	/* sanity for < 0 */
-	return 0;
-    }
+    _pkg_lock(pc);
+    ret = _pkg_flush_locked(pc);
+    _pkg_unlock(pc);
+    return ret;
+}
 
-    errno = 0;
-    if (pc->pkc_fd == PKG_STDIO_MODE) {
-	i = write(pc->pkc_out_fd, pc->pkc_stream, (size_t)pc->pkc_strpos);
-    } else {
-	i = write(pc->pkc_fd, pc->pkc_stream, (size_t)pc->pkc_strpos);
-    }
-    if (i != pc->pkc_strpos) {
-	if (i < 0) {
-	    if (errno == EBADF)
-		return -1;
-	    _pkg_perror(pc->pkc_errlog, "pkg_flush: write");
-	    return -1;
-	}
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_flush of %d, wrote %d\n",
-		 pc->pkc_strpos, i);
-	(pc->pkc_errlog)(_pkg_errbuf);
-	pc->pkc_strpos -= i;
-	/* copy leftovers to front of stream */
-	memmove(pc->pkc_stream, pc->pkc_stream + i, (size_t)pc->pkc_strpos);
-	return i;	/* amount of user data sent */
-    }
-    pc->pkc_strpos = 0;
-    return i;
+
+/**
+ * Tell the peer what this end of the connection can decode.  Caller
+ * holds the output lock.
+ *
+ * This is a private implementation function.
+ */
+static void
+_pkg_announce_locked(struct pkg_conn *pc)
+{
+    char caps[4];
+    struct pkg_iovec iov[1];
+
+    pkg_plong(caps, (unsigned long)PKG_CAP_LZ4);
+    iov[0].iov_base = caps;
+    iov[0].iov_len = sizeof(caps);
+    if (_pkg_sendv_locked(PKG_TYPE_CTL, iov, 1, sizeof(caps), pc, "pkg_options: write") == (int)sizeof(caps))
+	pc->pkc_caps_sent = 1;
+}
+
+
+unsigned int
+pkg_options(struct pkg_conn *pc, unsigned int opts)
+{
+    unsigned int prev;
+
+    PKG_CK(pc);
+
+    _pkg_lock(pc);
+    prev = pc->pkc_opts;
+    pc->pkc_opts = opts;
+    if ((opts & PKG_OPT_LZ4) && !pc->pkc_caps_sent)
+	_pkg_announce_locked(pc);
+    _pkg_unlock(pc);
+
+    return prev;
 }
 
 
@@ -1371,6 +1552,7 @@ pkg_flush(struct pkg_conn *pc)
 static int
 _pkg_gethdr(struct pkg_conn *pc, char *buf)
 {
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
     size_t i;
 
     PKG_CK(pc);
@@ -1384,38 +1566,39 @@ _pkg_gethdr(struct pkg_conn *pc, char *buf)
     if ((i = _pkg_inget(pc, (char *)&(pc->pkc_hdr),
 			sizeof(struct pkg_header))) != sizeof(struct pkg_header)) {
 	if (i > 0) {
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "_pkg_gethdr: header read of %ld?\n", (long)i);
-	    (pc->pkc_errlog)(_pkg_errbuf);
+	    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "_pkg_gethdr: header read of %ld?\n", (long)i);
+	    (pc->pkc_errlog)(errbuf);
 	}
 	return -1;
     }
-    while (pkg_gshort((char *)pc->pkc_hdr.pkh_magic) != PKG_MAGIC) {
+    while (pkg_gshort((char *)pc->pkc_hdr.pkh_magic) != PKG_MAGIC
+	   && pkg_gshort((char *)pc->pkc_hdr.pkh_magic) != PKG_MAGIC_LZ4) {
 	int c;
 	c = *((unsigned char *)&pc->pkc_hdr);
 	if (isprint(c)) {
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE,
+	    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE,
 		     "_pkg_gethdr: skipping noise x%x %c\n",
 		     c, c);
 	} else {
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE,
+	    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE,
 		     "_pkg_gethdr: skipping noise x%x\n",
 		     c);
 	}
 	if (pc->pkc_errlog) {
-	    (pc->pkc_errlog)(_pkg_errbuf);
+	    (pc->pkc_errlog)(errbuf);
 	} else {
-	    fprintf(stderr, "%s", _pkg_errbuf);
+	    fprintf(stderr, "%s", errbuf);
 	}
 	/* Slide over one byte and try again */
 	memmove((char *)&pc->pkc_hdr, ((char *)&pc->pkc_hdr)+1, sizeof(struct pkg_header)-1);
 	if ((i = _pkg_inget(pc,
 			    ((char *)&pc->pkc_hdr)+sizeof(struct pkg_header)-1,
 			    1)) != 1) {
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "_pkg_gethdr: hdr read=%ld?\n", (long)i);
+	    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "_pkg_gethdr: hdr read=%ld?\n", (long)i);
 	    if (pc->pkc_errlog) {
-		(pc->pkc_errlog)(_pkg_errbuf);
+		(pc->pkc_errlog)(errbuf);
 	    } else {
-		fprintf(stderr, "%s", _pkg_errbuf);
+		fprintf(stderr, "%s", errbuf);
 	    }
 	    return -1;
 	}
@@ -1431,7 +1614,8 @@ _pkg_gethdr(struct pkg_conn *pc, char *buf)
     if (pc->pkc_len >= SSIZE_MAX-2)
 	return -1;
 
-    if (buf) {
+    /* compressed messages are inflated out of a dynamic buffer */
+    if (buf && pkg_gshort((char *)pc->pkc_hdr.pkh_magic) != PKG_MAGIC_LZ4) {
 	pc->pkc_buf = buf;
     } else {
 	/* Prepare to read message into dynamic buffer */
@@ -1445,9 +1629,67 @@ _pkg_gethdr(struct pkg_conn *pc, char *buf)
 }
 
 
+/**
+ * Once a whole PKG_MAGIC_LZ4 message is in pkc_buf, replace it with
+ * its inflated form and make the header describe that, so everything
+ * downstream sees an ordinary message.
+ *
+ * Returns 0 if the message was not compressed, 1 if it was inflated,
+ * and -1 if it is corrupt.
+ *
+ * This is a private implementation function.
+ */
+static int
+_pkg_inflate(struct pkg_conn *pc)
+{
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
+    size_t olen;
+    char *obuf;
+
+    if (pkg_gshort((char *)pc->pkc_hdr.pkh_magic) != PKG_MAGIC_LZ4)
+	return 0;
+
+    if (pc->pkc_len < 4 || pc->pkc_buf == (char *)0) {
+	snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "_pkg_inflate: short compressed message, len %ld\n",
+		 (long)pc->pkc_len);
+	(pc->pkc_errlog)(errbuf);
+	return -1;
+    }
+
+    /* LZ4 can't expand more than 255:1, don't allocate past that */
+    olen = pkg_glong(pc->pkc_buf);
+    if (olen >= SSIZE_MAX-2 || olen / 255 > pc->pkc_len) {
+	snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "_pkg_inflate: implausible length %ld from %ld\n",
+		 (long)olen, (long)pc->pkc_len);
+	(pc->pkc_errlog)(errbuf);
+	return -1;
+    }
+    if ((obuf = (char *)malloc(olen+2)) == NULL) {
+	_pkg_perror(pc->pkc_errlog, "_pkg_inflate: malloc fail");
+	return -1;
+    }
+    if (_pkg_lz4_decompress(pc->pkc_buf + 4, pc->pkc_len - 4, obuf, olen) < 0) {
+	snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "_pkg_inflate: corrupt message type %d, len %ld\n",
+		 pc->pkc_type, (long)pc->pkc_len);
+	(pc->pkc_errlog)(errbuf);
+	(void)free(obuf);
+	return -1;
+    }
+
+    (void)free(pc->pkc_buf);
+    pc->pkc_buf = obuf;
+    pc->pkc_curpos = obuf + olen;
+    pc->pkc_len = olen;
+    pkg_pshort((char *)pc->pkc_hdr.pkh_magic, (unsigned short)PKG_MAGIC);
+    pkg_plong((char *)pc->pkc_hdr.pkh_len, (unsigned long)olen);
+    return 1;
+}
+
+
 int
 pkg_waitfor (int type, char *buf, size_t len, struct pkg_conn *pc)
 {
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
     size_t i;
 
     PKG_CK(pc);
@@ -1478,7 +1720,7 @@ pkg_waitfor (int type, char *buf, size_t len, struct pkg_conn *pc)
 
     if (pc->pkc_type != type) {
 	/* A message of some other type has unexpectedly arrived. */
-	if (pc->pkc_len > 0) {
+	if (pc->pkc_len > 0 && pc->pkc_buf == buf) {
 	    if ((pc->pkc_buf = (char *)malloc(pc->pkc_len+2)) == NULL) {
 		_pkg_perror(pc->pkc_errlog, "pkg_waitfor: malloc failed");
 		return -1;
@@ -1491,18 +1733,48 @@ pkg_waitfor (int type, char *buf, size_t len, struct pkg_conn *pc)
     if (pc->pkc_len == 0)
 	return 0;
 
+    if (pkg_gshort((char *)pc->pkc_hdr.pkh_magic) == PKG_MAGIC_LZ4) {
+	/* Compressed, read it whole and hand over the inflated bytes */
+	if ((i = _pkg_inget(pc, pc->pkc_buf, pc->pkc_len)) != pc->pkc_len
+	    || _pkg_inflate(pc) < 0) {
+	    if (i != pc->pkc_len) {
+		snprintf(errbuf, MAX_PKG_ERRBUF_SIZE,
+			 "pkg_waitfor: _pkg_inget %ld gave %ld\n",
+			 (long)pc->pkc_len, (long)i);
+		(pc->pkc_errlog)(errbuf);
+	    }
+	    (void)free(pc->pkc_buf);
+	    pc->pkc_buf = (char *)0;
+	    pc->pkc_curpos = (char *)0;
+	    return -1;
+	}
+	i = pc->pkc_len;
+	if (i > len) {
+	    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE,
+		     "pkg_waitfor: message %ld exceeds buffer %ld\n",
+		     (long)pc->pkc_len, (long)len);
+	    (pc->pkc_errlog)(errbuf);
+	    i = len;	/* potentially truncated, but OK */
+	}
+	memcpy(buf, pc->pkc_buf, i);
+	(void)free(pc->pkc_buf);
+	pc->pkc_buf = (char *)0;
+	pc->pkc_curpos = (char *)0;
+	return (int)i;
+    }
+
     /* See if incoming message is larger than user's buffer */
     if (pc->pkc_len > len) {
 	char *bp;
 	size_t excess;
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE,
+	snprintf(errbuf, MAX_PKG_ERRBUF_SIZE,
 		 "pkg_waitfor: message %ld exceeds buffer %ld\n",
 		 (long)pc->pkc_len, (long)len);
-	(pc->pkc_errlog)(_pkg_errbuf);
+	(pc->pkc_errlog)(errbuf);
 	if ((i = _pkg_inget(pc, buf, len)) != len) {
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE,
+	    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE,
 		     "pkg_waitfor: _pkg_inget %ld gave %ld\n", (long)len, (long)i);
-	    (pc->pkc_errlog)(_pkg_errbuf);
+	    (pc->pkc_errlog)(errbuf);
 	    return -1;
 	}
 	excess = pc->pkc_len - len;	/* size of excess message */
@@ -1511,10 +1783,10 @@ pkg_waitfor (int type, char *buf, size_t len, struct pkg_conn *pc)
 	    return -1;
 	}
 	if ((i = _pkg_inget(pc, bp, excess)) != excess) {
-	    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE,
+	    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE,
 		     "pkg_waitfor: _pkg_inget of excess, %ld gave %ld\n",
 		     (long)excess, (long)i);
-	    (pc->pkc_errlog)(_pkg_errbuf);
+	    (pc->pkc_errlog)(errbuf);
 	    (void)free(bp);
 	    return -1;
 	}
@@ -1524,10 +1796,10 @@ pkg_waitfor (int type, char *buf, size_t len, struct pkg_conn *pc)
 
     /* Read the whole message into the users buffer */
     if ((i = _pkg_inget(pc, buf, pc->pkc_len)) != pc->pkc_len) {
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE,
+	snprintf(errbuf, MAX_PKG_ERRBUF_SIZE,
 		 "pkg_waitfor: _pkg_inget %ld gave %ld\n",
 		 (long)pc->pkc_len, (long)i);
-	(pc->pkc_errlog)(_pkg_errbuf);
+	(pc->pkc_errlog)(errbuf);
 	return -1;
     }
     if (_pkg_debug) {
@@ -1546,6 +1818,7 @@ pkg_waitfor (int type, char *buf, size_t len, struct pkg_conn *pc)
 char *
 pkg_bwaitfor (int type, struct pkg_conn *pc)
 {
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
     size_t i;
     char *tmpbuf;
 
@@ -1577,12 +1850,17 @@ pkg_bwaitfor (int type, struct pkg_conn *pc)
     /* Read the whole message into the dynamic buffer */
     if (pc->pkc_buf != (char *)0) {
       if ((i = _pkg_inget(pc, pc->pkc_buf, pc->pkc_len)) != pc->pkc_len) {
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE,
+	snprintf(errbuf, MAX_PKG_ERRBUF_SIZE,
 	    "pkg_bwaitfor: _pkg_inget %ld gave %ld\n", (long)pc->pkc_len, (long)i);
-	(pc->pkc_errlog)(_pkg_errbuf);
+	(pc->pkc_errlog)(errbuf);
+      } else if (_pkg_inflate(pc) < 0) {
+	(void)free(pc->pkc_buf);
+	pc->pkc_buf = (char *)0;
+	pc->pkc_curpos = (char *)0;
+	return (char *)0;
       }
     } else {
-      snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_bwaitfor: tried to read from null pc->pkc_buf!\n");
+      snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_bwaitfor: tried to read from null pc->pkc_buf!\n");
       return (char *)0;
     }
     tmpbuf = pc->pkc_buf;
@@ -1594,6 +1872,39 @@ pkg_bwaitfor (int type, struct pkg_conn *pc)
 }
 
 
+/**
+ * Handle a PKG_TYPE_CTL message from the peer: note its capabilities
+ * and, the first time, answer with ours.
+ *
+ * This is a private implementation function.
+ */
+static int
+_pkg_ctl(struct pkg_conn *pc)
+{
+    if (pc->pkc_len >= 4 && pc->pkc_buf != (char *)0)
+	pc->pkc_peer_caps = (unsigned int)pkg_glong(pc->pkc_buf);
+
+    (void)free(pc->pkc_buf);
+    pc->pkc_buf = (char *)0;
+    pc->pkc_curpos = (char *)0;
+    pc->pkc_left = -1;		/* safety */
+
+    if (_pkg_debug) {
+	_pkg_timestamp();
+	fprintf(_pkg_debug,
+		"_pkg_ctl(pc=%p) peer caps=x%x\n",
+		(void *)pc, pc->pkc_peer_caps);
+	fflush(_pkg_debug);
+    }
+
+    _pkg_lock(pc);
+    if (!pc->pkc_caps_sent)
+	_pkg_announce_locked(pc);
+    _pkg_unlock(pc);
+    return 1;
+}
+
+
 /**
  * Given that a whole message has arrived, send it to the appropriate
  * User Handler, or else grouse.  Returns -1 on fatal error, 0 on no
@@ -1604,6 +1915,7 @@ pkg_bwaitfor (int type, struct pkg_conn *pc)
 static int
 _pkg_dispatch(struct pkg_conn *pc)
 {
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
     int i;
 
     PKG_CK(pc);
@@ -1617,6 +1929,18 @@ _pkg_dispatch(struct pkg_conn *pc)
     if (pc->pkc_left != 0)
 	return -1;
 
+    if (_pkg_inflate(pc) < 0) {
+	(void)free(pc->pkc_buf);
+	pc->pkc_buf = (char *)0;
+	pc->pkc_curpos = (char *)0;
+	pc->pkc_left = -1;		/* safety */
+	return -1;
+    }
+
+    /* Negotiation traffic never reaches the user */
+    if (pc->pkc_type == PKG_TYPE_CTL)
+	return _pkg_ctl(pc);
+
     /* Whole message received, process it via switchout table */
     for (i = 0; pc->pkc_switch[i].pks_handler != NULL; i++) {
 	char *tempbuf;
@@ -1643,9 +1967,9 @@ _pkg_dispatch(struct pkg_conn *pc)
 	pc->pkc_user_data = (void *)NULL;
 	return 1;
     }
-    snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "_pkg_dispatch: no handler for message type %d, len %ld\n",
+    snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "_pkg_dispatch: no handler for message type %d, len %ld\n",
 	     pc->pkc_type, (long)pc->pkc_len);
-    (pc->pkc_errlog)(_pkg_errbuf);
+    (pc->pkc_errlog)(errbuf);
     (void)free(pc->pkc_buf);
     pc->pkc_buf = (char *)0;
     pc->pkc_curpos = (char *)0;
@@ -1658,6 +1982,7 @@ _pkg_dispatch(struct pkg_conn *pc)
 int
 pkg_process(struct pkg_conn *pc)
 {
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
     size_t len;
     int available;
     int errcnt;
@@ -1672,16 +1997,16 @@ pkg_process(struct pkg_conn *pc)
 	available = pc->pkc_inend - pc->pkc_incur;	/* amt in input buf */
 	if (_pkg_debug) {
 	    if (pc->pkc_left < 0) {
-		snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "awaiting new header");
+		snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "awaiting new header");
 	    } else if (pc->pkc_left > 0) {
-		snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "need more data");
+		snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "need more data");
 	    } else {
-		snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg is all here");
+		snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "pkg is all here");
 	    }
 	    _pkg_timestamp();
 	    fprintf(_pkg_debug,
 		    "pkg_process(pc=%p) pkc_left=%d %s (avail=%d)\n",
-		    (void *)pc, pc->pkc_left, _pkg_errbuf, available);
+		    (void *)pc, pc->pkc_left, errbuf, available);
 	    fflush(_pkg_debug);
 	}
 	if (pc->pkc_left < 0) {
@@ -1813,6 +2138,7 @@ pkg_block(struct pkg_conn *pc)
 int
 pkg_suckin(struct pkg_conn *pc)
 {
+    char errbuf[MAX_PKG_ERRBUF_SIZE] = {0};
     size_t avail;
     int got;
     int ret;
@@ -1899,13 +2225,13 @@ pkg_suckin(struct pkg_conn *pc)
 	}
 #ifndef HAVE_WINSOCK_H
 	_pkg_perror(pc->pkc_errlog, "pkg_suckin: read");
-	snprintf(_pkg_errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_suckin: read(%d, %p, %ld) ret=%d inbuf=%p, inend=%d\n",
+	snprintf(errbuf, MAX_PKG_ERRBUF_SIZE, "pkg_suckin: read(%d, %p, %ld) ret=%d inbuf=%p, inend=%d\n",
 		 pc->pkc_fd, (void *)(&pc->pkc_inbuf[pc->pkc_inend]), (long)avail,
 		 got, (void *)pc->pkc_inbuf, pc->pkc_inend);
 	if (pc->pkc_errlog) {
-	    (pc->pkc_errlog)(_pkg_errbuf);
+	    (pc->pkc_errlog)(errbuf);
 	} else {
-	    fprintf(stderr, "%s", _pkg_errbuf);
+	    fprintf(stderr, "%s", errbuf);
 	}
 #endif
 	ret = -1;
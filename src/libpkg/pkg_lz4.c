@@ -0,0 +1,267 @@
+/*                       P K G _ L Z 4 . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libpkg/pkg_lz4.c
+ *
+ * A small, self-contained encoder and decoder for the LZ4 block
+ * format, used by libpkg for compressed message frames.
+ *
+ * librt carries a full LZ4 implementation for its cache, but libpkg
+ * sits below librt and must not depend on it.  The encoder here is a
+ * single pass greedy matcher, which is all the interactive traffic
+ * libpkg carries (pixel scanlines, framebuffer rectangles) needs.
+ * Its output is a standard LZ4 block and can be read by any
+ * conforming decoder.  The decoder is fully bounds checked, since
+ * its input arrives off the network.
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "pkg_lz4.h"
+
+
+#define LZ4_MINMATCH	4	/* shortest match the format encodes */
+#define LZ4_LASTLITERALS 5	/* block always ends in this many literals */
+#define LZ4_MFLIMIT	12	/* last match must start this far from end */
+#define LZ4_MAXOFFSET	65535
+#define LZ4_HASHLOG	12
+#define LZ4_RUNMASK	15
+
+
+static unsigned int
+_lz4_read32(const unsigned char *p)
+{
+    unsigned int v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+
+static unsigned int
+_lz4_hash(unsigned int seq)
+{
+    return (seq * 2654435761U) >> (32 - LZ4_HASHLOG);
+}
+
+
+/* Append an extended length (the part beyond the 4 bit token field) */
+static unsigned char *
+_lz4_putlen(unsigned char *op, size_t len)
+{
+    while (len >= 255) {
+	*op++ = 255;
+	len -= 255;
+    }
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+
+size_t
+_pkg_lz4_bound(size_t srclen)
+{
+    return srclen + srclen / 255 + 16;
+}
+
+
+size_t
+_pkg_lz4_compress(const char *src, size_t srclen, char *dst, size_t dstcap)
+{
+    /* positions are stored +1 so zero means empty */
+    unsigned int table[1 << LZ4_HASHLOG];
+    const unsigned char *base = (const unsigned char *)src;
+    const unsigned char *ip = base;
+    const unsigned char *anchor = base;
+    const unsigned char *iend = base + srclen;
+    unsigned char *op = (unsigned char *)dst;
+    unsigned char *oend = op + dstcap;
+    unsigned char *token;
+    size_t litlen;
+
+    /* pkg frames carry a 32 bit length, so positions fit the table */
+    if (!src || !dst || srclen > 0xFFFFFFFFUL - 1)
+	return 0;
+
+    memset(table, 0, sizeof(table));
+
+    if (srclen > LZ4_MFLIMIT) {
+	const unsigned char *mflimit = iend - LZ4_MFLIMIT;
+	const unsigned char *matchlimit = iend - LZ4_LASTLITERALS;
+
+	while (ip < mflimit) {
+	    unsigned int seq = _lz4_read32(ip);
+	    unsigned int h = _lz4_hash(seq);
+	    unsigned int pos = (unsigned int)(ip - base) + 1;
+	    unsigned int ref = table[h];
+	    const unsigned char *match;
+	    const unsigned char *mp;
+	    const unsigned char *rp;
+	    size_t mlen;
+	    size_t off;
+
+	    table[h] = pos;
+	    if (!ref || pos - ref > LZ4_MAXOFFSET || _lz4_read32(base + ref - 1) != seq) {
+		ip++;
+		continue;
+	    }
+	    match = base + ref - 1;
+
+	    /* grow the match backwards over pending literals */
+	    while (ip > anchor && match > base && ip[-1] == match[-1]) {
+		ip--;
+		match--;
+	    }
+
+	    /* and forwards, stopping short of the trailing literals */
+	    mp = ip + LZ4_MINMATCH;
+	    rp = match + LZ4_MINMATCH;
+	    while (mp < matchlimit && *mp == *rp) {
+		mp++;
+		rp++;
+	    }
+
+	    litlen = (size_t)(ip - anchor);
+	    mlen = (size_t)(mp - ip) - LZ4_MINMATCH;
+	    off = (size_t)(ip - match);
+
+	    if ((size_t)(oend - op) < 1 + litlen / 255 + 1 + litlen + 2 + mlen / 255 + 1)
+		return 0;
+
+	    token = op++;
+	    if (litlen >= LZ4_RUNMASK) {
+		*token = (unsigned char)(LZ4_RUNMASK << 4);
+		op = _lz4_putlen(op, litlen - LZ4_RUNMASK);
+	    } else {
+		*token = (unsigned char)(litlen << 4);
+	    }
+	    memcpy(op, anchor, litlen);
+	    op += litlen;
+
+	    *op++ = (unsigned char)(off & 0xFF);
+	    *op++ = (unsigned char)(off >> 8);
+
+	    if (mlen >= LZ4_RUNMASK) {
+		*token |= LZ4_RUNMASK;
+		op = _lz4_putlen(op, mlen - LZ4_RUNMASK);
+	    } else {
+		*token |= (unsigned char)mlen;
+	    }
+
+	    ip = mp;
+	    anchor = ip;
+	}
+    }
+
+    /* final literal run */
+    litlen = (size_t)(iend - anchor);
+    if ((size_t)(oend - op) < 1 + litlen / 255 + 1 + litlen)
+	return 0;
+    token = op++;
+    if (litlen >= LZ4_RUNMASK) {
+	*token = (unsigned char)(LZ4_RUNMASK << 4);
+	op = _lz4_putlen(op, litlen - LZ4_RUNMASK);
+    } else {
+	*token = (unsigned char)(litlen << 4);
+    }
+    memcpy(op, anchor, litlen);
+    op += litlen;
+
+    return (size_t)(op - (unsigned char *)dst);
+}
+
+
+int
+_pkg_lz4_decompress(const char *src, size_t srclen, char *dst, size_t dstlen)
+{
+    const unsigned char *ip = (const unsigned char *)src;
+    const unsigned char *iend = ip + srclen;
+    unsigned char *ostart = (unsigned char *)dst;
+    unsigned char *op = ostart;
+    unsigned char *oend = ostart + dstlen;
+
+    if (!src || !dst)
+	return -1;
+
+    while (ip < iend) {
+	unsigned int token = *ip++;
+	size_t litlen = token >> 4;
+	size_t mlen = token & LZ4_RUNMASK;
+	size_t off;
+	const unsigned char *match;
+
+	if (litlen == LZ4_RUNMASK) {
+	    unsigned int b;
+	    do {
+		if (ip >= iend)
+		    return -1;
+		b = *ip++;
+		litlen += b;
+	    } while (b == 255);
+	}
+	if ((size_t)(iend - ip) < litlen || (size_t)(oend - op) < litlen)
+	    return -1;
+	memcpy(op, ip, litlen);
+	op += litlen;
+	ip += litlen;
+
+	/* the last sequence is literals only */
+	if (ip >= iend)
+	    break;
+
+	if (iend - ip < 2)
+	    return -1;
+	off = (size_t)ip[0] | ((size_t)ip[1] << 8);
+	ip += 2;
+	if (off == 0 || off > (size_t)(op - ostart))
+	    return -1;
+
+	if (mlen == LZ4_RUNMASK) {
+	    unsigned int b;
+	    do {
+		if (ip >= iend)
+		    return -1;
+		b = *ip++;
+		mlen += b;
+	    } while (b == 255);
+	}
+	mlen += LZ4_MINMATCH;
+	if ((size_t)(oend - op) < mlen)
+	    return -1;
+
+	/* matches may overlap their own output, so copy bytewise */
+	match = op - off;
+	while (mlen--)
+	    *op++ = *match++;
+    }
+
+    return (op == oend) ? 0 : -1;
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,71 @@
+/*                       P K G _ L Z 4 . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file libpkg/pkg_lz4.h
+ *
+ * Private interface to the LZ4 block codec used for compressed
+ * message frames.
+ *
+ */
+
+#ifndef LIBPKG_PKG_LZ4_H
+#define LIBPKG_PKG_LZ4_H
+
+#include "common.h"
+
+#include <stddef.h>
+
+__BEGIN_DECLS
+
+/**
+ * Worst case size of the compressed form of a srclen byte block.
+ */
+extern size_t _pkg_lz4_bound(size_t srclen);
+
+/**
+ * Compress srclen bytes of src into an LZ4 block at dst, writing no
+ * more than dstcap bytes.
+ *
+ * Returns the compressed size, or 0 if the output did not fit.
+ */
+extern size_t _pkg_lz4_compress(const char *src, size_t srclen, char *dst, size_t dstcap);
+
+/**
+ * Decompress an LZ4 block of srclen bytes into exactly dstlen bytes
+ * at dst.  All offsets and lengths are validated against both
+ * buffers, so corrupt or hostile input can not overrun them.
+ *
+ * Returns 0 on success, -1 if the block is malformed or does not
+ * decode to exactly dstlen bytes.
+ */
+extern int _pkg_lz4_decompress(const char *src, size_t srclen, char *dst, size_t dstlen);
+
+__END_DECLS
+
+#endif /* LIBPKG_PKG_LZ4_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
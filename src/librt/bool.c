@@ -215,7 +215,7 @@ rt_boolweave(struct seg *out_hd, struct seg *in_hd, struct partition *PartHdp, s
 	      segp->seg_out.hit_dist <= INFINITY)) {
 	    if (RT_G_DEBUG&RT_DEBUG_PARTITION) {
 		bu_log("rt_boolweave:  Defective %s segment %s (%.18e, %.18e) %d, %d\n",
-		       OBJ[segp->seg_stp->st_id].ft_name,
+		       segp->seg_stp->st_meth->ft_name,
 		       segp->seg_stp->st_name,
 		       segp->seg_in.hit_dist,
 		       segp->seg_out.hit_dist,
@@ -227,7 +227,7 @@ rt_boolweave(struct seg *out_hd, struct seg *in_hd, struct partition *PartHdp, s
 	if (segp->seg_in.hit_dist > segp->seg_out.hit_dist) {
 	    if (RT_G_DEBUG&RT_DEBUG_PARTITION) {
 		bu_log("rt_boolweave:  Inside-out %s segment %s (%.18e, %.18e) %d, %d\n",
-		       OBJ[segp->seg_stp->st_id].ft_name,
+		       segp->seg_stp->st_meth->ft_name,
 		       segp->seg_stp->st_name,
 		       segp->seg_in.hit_dist,
 		       segp->seg_out.hit_dist,
@@ -35,9 +35,270 @@
 
 #include "common.h"
 #include "string.h"
+#include "bu/hash.h"
+#include "bu/parallel.h"
+#include "bu/ptbl.h"
 #include "nmg.h"
 #include "raytrace.h"
 
+
+struct rt_tess_cache {
+    bu_hash_tbl *tbl;		/* tess_cache_key -> struct model */
+    int sem;
+};
+
+/* Tessellations are cached with the translation part of the leaf
+ * matrix taken out, so translated instances share one entry. */
+struct tess_cache_key {
+    const struct directory *dp;
+    fastf_t mat[16];
+    double ttol[3];
+    double tol[2];
+};
+
+
+struct rt_tess_cache *
+rt_tess_cache_create(void)
+{
+    struct rt_tess_cache *cache;
+
+    BU_ALLOC(cache, struct rt_tess_cache);
+    cache->tbl = bu_hash_create(1024);
+    cache->sem = bu_semaphore_register("RT_SEM_TESS_CACHE");
+
+    return cache;
+}
+
+
+void
+rt_tess_cache_destroy(struct rt_tess_cache *cache)
+{
+    struct bu_hash_entry *e;
+
+    if (!cache)
+	return;
+
+    for (e = bu_hash_next(cache->tbl, NULL); e; e = bu_hash_next(cache->tbl, e)) {
+	struct model *m = (struct model *)bu_hash_value(e, NULL);
+	if (m)
+	    nmg_km(m);
+    }
+    bu_hash_destroy(cache->tbl);
+    bu_free(cache, "rt_tess_cache");
+}
+
+
+/**
+ * Fill in the cache key for a leaf, and the translation that was
+ * taken out of its matrix.  A matrix with a perspective part keeps
+ * its translation in the key.
+ */
+static void
+tess_cache_key(struct tess_cache_key *key, vect_t offset, const struct directory *dp, const struct db_tree_state *tsp)
+{
+    int i;
+
+    memset(key, 0, sizeof(struct tess_cache_key));
+    key->dp = dp;
+    for (i = 0; i < 16; i++)
+	key->mat[i] = tsp->ts_mat[i];
+    key->ttol[0] = tsp->ts_ttol->abs;
+    key->ttol[1] = tsp->ts_ttol->rel;
+    key->ttol[2] = tsp->ts_ttol->norm;
+    key->tol[0] = tsp->ts_tol->dist;
+    key->tol[1] = tsp->ts_tol->perp;
+
+    VSETALL(offset, 0.0);
+    if (ZERO(tsp->ts_mat[12]) && ZERO(tsp->ts_mat[13]) && ZERO(tsp->ts_mat[14]) && !ZERO(tsp->ts_mat[15])) {
+	VSET(offset, tsp->ts_mat[MDX], tsp->ts_mat[MDY], tsp->ts_mat[MDZ]);
+	VSCALE(offset, offset, 1.0/tsp->ts_mat[15]);
+	key->mat[MDX] = key->mat[MDY] = key->mat[MDZ] = 0.0;
+    }
+}
+
+
+/**
+ * Move a tessellation by offset.  Only planar faces and straight
+ * edges, which is all the primitive tessellators make, can be moved;
+ * returns -1, leaving the model alone, if there is anything else.
+ */
+static int
+tess_translate(struct model *m, const vect_t offset, const struct bn_tol *tol)
+{
+    struct bu_ptbl verts, faces, edges, planes;
+    size_t i;
+    int ret = 0;
+
+    NMG_CK_MODEL(m);
+
+    bu_ptbl_init(&faces, 64, "faces");
+    bu_ptbl_init(&edges, 64, "edge geometry");
+    nmg_face_tabulate(&faces, &m->magic, &RTG.rtg_vlfree);
+    nmg_edge_g_tabulate(&edges, &m->magic, &RTG.rtg_vlfree);
+
+    for (i = 0; i < BU_PTBL_LEN(&faces); i++) {
+	struct face *f = (struct face *)BU_PTBL_GET(&faces, i);
+	if (!f->g.magic_p || *f->g.magic_p != NMG_FACE_G_PLANE_MAGIC)
+	    ret = -1;
+    }
+    for (i = 0; i < BU_PTBL_LEN(&edges); i++) {
+	uint32_t *ep = (uint32_t *)BU_PTBL_GET(&edges, i);
+	if (*ep != NMG_EDGE_G_LSEG_MAGIC)
+	    ret = -1;
+    }
+
+    if (!ret) {
+	bu_ptbl_init(&verts, 64, "vertices");
+	nmg_vertex_tabulate(&verts, &m->magic, &RTG.rtg_vlfree);
+	for (i = 0; i < BU_PTBL_LEN(&verts); i++) {
+	    struct vertex *v = (struct vertex *)BU_PTBL_GET(&verts, i);
+	    if (v->vg_p)
+		VADD2(v->vg_p->coord, v->vg_p->coord, offset);
+	}
+	bu_ptbl_free(&verts);
+
+	/* a face and its mate may share one plane */
+	bu_ptbl_init(&planes, 64, "face planes");
+	for (i = 0; i < BU_PTBL_LEN(&faces); i++) {
+	    struct face *f = (struct face *)BU_PTBL_GET(&faces, i);
+	    bu_ptbl_ins_unique(&planes, (long *)f->g.plane_p);
+	}
+	for (i = 0; i < BU_PTBL_LEN(&planes); i++) {
+	    struct face_g_plane *fg = (struct face_g_plane *)BU_PTBL_GET(&planes, i);
+	    fg->N[W] += VDOT(fg->N, offset);
+	}
+	bu_ptbl_free(&planes);
+
+	for (i = 0; i < BU_PTBL_LEN(&edges); i++) {
+	    struct edge_g_lseg *eg = (struct edge_g_lseg *)BU_PTBL_GET(&edges, i);
+	    VADD2(eg->e_pt, eg->e_pt, offset);
+	}
+
+	nmg_rebound(m, tol);
+    }
+
+    bu_ptbl_free(&faces);
+    bu_ptbl_free(&edges);
+
+    return ret;
+}
+
+
+/**
+ * Returns a copy of the cached tessellation for key, moved by offset,
+ * or NULL if there isn't one.
+ */
+static struct model *
+tess_cache_get(struct rt_tess_cache *cache, const struct tess_cache_key *key, const vect_t offset, const struct bn_tol *tol)
+{
+    struct model *cm, *m;
+
+    bu_semaphore_acquire(cache->sem);
+    cm = (struct model *)bu_hash_get(cache->tbl, (const uint8_t *)key, sizeof(struct tess_cache_key));
+    bu_semaphore_release(cache->sem);
+
+    /* cached models are never changed once they are in the table */
+    if (!cm)
+	return NULL;
+    m = nmg_clone_model(cm);
+    if (!VNEAR_ZERO(offset, SMALL_FASTF) && tess_translate(m, offset, tol) < 0) {
+	nmg_km(m);
+	return NULL;
+    }
+    return m;
+}
+
+
+/**
+ * Cache a copy of tessellation m, moved back by offset.  If another
+ * thread got there first, its copy is kept.  Only models holding a
+ * single region are cached, so the region of a copy is unambiguous.
+ */
+static void
+tess_cache_put(struct rt_tess_cache *cache, const struct tess_cache_key *key, const vect_t offset, const struct model *m, const struct bn_tol *tol)
+{
+    struct model *cm;
+
+    if (BU_LIST_IS_EMPTY(&m->r_hd) || BU_LIST_FIRST(nmgregion, &m->r_hd) != BU_LIST_LAST(nmgregion, &m->r_hd))
+	return;
+
+    cm = nmg_clone_model(m);
+
+    if (!VNEAR_ZERO(offset, SMALL_FASTF)) {
+	vect_t back;
+	VREVERSE(back, offset);
+	if (tess_translate(cm, back, tol) < 0) {
+	    nmg_km(cm);
+	    return;
+	}
+    }
+
+    bu_semaphore_acquire(cache->sem);
+    if (!bu_hash_get(cache->tbl, (const uint8_t *)key, sizeof(struct tess_cache_key))) {
+	bu_hash_set(cache->tbl, (const uint8_t *)key, sizeof(struct tess_cache_key), (void *)cm);
+	cm = NULL;
+    }
+    bu_semaphore_release(cache->sem);
+
+    if (cm)
+	nmg_km(cm);
+}
+
+
+static void
+tess_cache_free_leaves(union tree *tp)
+{
+    if (!tp)
+	return;
+
+    switch (tp->tr_op) {
+	case OP_TESS:
+	    if (tp->tr_d.td_r) {
+		nmg_km(tp->tr_d.td_r->m_p);
+		tp->tr_d.td_r = NULL;
+	    }
+	    break;
+	case OP_UNION:
+	case OP_INTERSECT:
+	case OP_SUBTRACT:
+	case OP_XOR:
+	    tess_cache_free_leaves(tp->tr_b.tb_right);
+	    /* fall through */
+	case OP_NOT:
+	case OP_GUARD:
+	case OP_XNOP:
+	    tess_cache_free_leaves(tp->tr_b.tb_left);
+	    break;
+	default:
+	    break;
+    }
+}
+
+
+/* The priming walk only wants the cache filled - drop the leaves */
+static union tree *
+tess_cache_region_end(struct db_tree_state *UNUSED(tsp), const struct db_full_path *UNUSED(pathp), union tree *curtree, void *UNUSED(client_data))
+{
+    tess_cache_free_leaves(curtree);
+    return curtree;
+}
+
+
+int
+rt_tess_cache_prime(struct rt_tess_cache *cache, struct db_i *dbip, int argc, const char **argv, int ncpu, const struct db_tree_state *init_state)
+{
+    struct db_tree_state ts;
+
+    if (!cache || !dbip || !init_state)
+	return -1;
+
+    ts = *init_state;	/* struct copy */
+    ts.ts_tess_cache = cache;
+    ts.ts_m = NULL;
+
+    return db_walk_tree(dbip, argc, argv, ncpu, &ts, NULL, tess_cache_region_end, rt_booltree_leaf_tess, NULL);
+}
+
 /**
  * Called from db_walk_tree() each time a tree leaf is encountered.
  * The primitive solid, in external format, is provided in 'ep', and
@@ -50,6 +311,9 @@
  * tessellation in a new tree structure (union), and return a pointer
  * to that.
  *
+ * If the tree state has a ts_tess_cache, an earlier tessellation of
+ * the same leaf is copied rather than tessellating it again.
+ *
  * Usually given as an argument to, and called from db_walk_tree().
  *
  * This routine must be prepared to run in parallel.
@@ -57,10 +321,12 @@
 union tree *
 rt_booltree_leaf_tess(struct db_tree_state *tsp, const struct db_full_path *pathp, struct rt_db_internal *ip, void *UNUSED(client_data))
 {
-    struct model *m;
+    struct model *m = NULL;
     struct nmgregion *r1 = (struct nmgregion *)NULL;
     union tree *curtree;
     struct directory *dp;
+    struct tess_cache_key key;
+    vect_t offset;
 
     if (!tsp || !pathp || !ip)
 	return TREE_NULL;
@@ -81,11 +347,23 @@ rt_booltree_leaf_tess(struct db_tree_state *tsp, const struct db_full_path *path
     BG_CK_TESS_TOL(tsp->ts_ttol);
     RT_CK_RESOURCE(tsp->ts_resp);
 
-    m = nmg_mm();
+    if (tsp->ts_tess_cache) {
+	tess_cache_key(&key, offset, dp, tsp);
+	m = tess_cache_get(tsp->ts_tess_cache, &key, offset, tsp->ts_tol);
+	if (m)
+	    r1 = BU_LIST_FIRST(nmgregion, &m->r_hd);
+    }
 
-    if (ip->idb_meth->ft_tessellate(&r1, m, ip, tsp->ts_ttol, tsp->ts_tol) < 0) {
-	bu_log("ERROR(%s): tessellation failure\n", dp->d_namep);
-	return TREE_NULL;
+    if (!r1) {
+	m = nmg_mm();
+
+	if (rt_obj_tess(&r1, m, ip, tsp->ts_ttol, tsp->ts_tol) < 0) {
+	    bu_log("ERROR(%s): tessellation failure\n", dp->d_namep);
+	    return TREE_NULL;
+	}
+
+	if (tsp->ts_tess_cache)
+	    tess_cache_put(tsp->ts_tess_cache, &key, offset, m, tsp->ts_tol);
     }
 
     NMG_CK_REGION(r1);
@@ -19,7 +19,7 @@
  */
 /** @file cache.c
  *
- * Caching of prep data
+ * Caching of prep and tessellation data
  *
  */
 
@@ -49,6 +49,8 @@
 #include "rt/db_attr.h"
 #include "rt/db_io.h"
 #include "rt/func.h"
+#include "rt/functab.h"
+#include "nmg.h"
 
 /* Defined in cache_lz4.c */
 extern int brl_LZ4_compress_default(const char* source, char* dest, int sourceSize, int maxDestSize);
@@ -544,54 +546,25 @@ cache_try_load(const struct rt_cache *cache, const char *name, const struct rt_d
 }
 
 
+/* writes a cache object holding the given attributes and data,
+ * flipping it into place atomically.  returns truthfully if the named
+ * object exists on return.  the externals are released.
+ */
 static int
-cache_try_store(struct rt_cache *cache, const char *name, const struct rt_db_internal *internal, struct soltab *stp)
+cache_write_object(struct rt_cache *cache, const char *name, struct bu_external *attributes_external, struct bu_external *data_external)
 {
     FILE *focache = NULL;
-    struct bu_external attributes_external = BU_EXTERNAL_INIT_ZERO;
-    struct bu_external data_external = BU_EXTERNAL_INIT_ZERO;
     struct bu_external db_external = BU_EXTERNAL_INIT_ZERO;
-    size_t version = (size_t)-1;
     char path[MAXPATHLEN] = {0};
     char tmpname[MAXPATHLEN] = {0};
     char tmppath[MAXPATHLEN] = {0};
     int ret = 0;
 
-    RT_CK_DB_INTERNAL(internal);
-    RT_CK_SOLTAB(stp);
-
-    CACHE_DEBUG("++++ [%lu.%lu] Trying to STORE %s\n", bu_pid(), bu_parallel_id(), name);
-
-    if (rt_obj_prep_serialize(stp, internal, &data_external, &version) || version == (size_t)-1) {
-	CACHE_DEBUG("++++++ [%lu.%lu] Failed to serialize %s\n", bu_pid(), bu_parallel_id(), name);
-	return 0; /* can't serialize */
-    }
-
-    compress_external(cache, &data_external);
-
-    {
-	struct bu_attribute_value_set attributes = BU_AVS_INIT_ZERO;
-	struct bu_vls version_vls = BU_VLS_INIT_ZERO;
-
-	bu_vls_sprintf(&version_vls, "%zu", version);
-	bu_avs_add(&attributes, "mime_type", cache_mime_type);
-	bu_avs_add(&attributes, "rt_cache::version", bu_vls_addr(&version_vls));
-	if (stp->st_dp && stp->st_dp->d_namep) {
-	    bu_avs_add(&attributes, "rt_cache::source_obj", stp->st_dp->d_namep);
-	}
-	if (stp->st_rtip && stp->st_rtip->rti_dbip->dbi_filename) {
-	    bu_avs_add(&attributes, "rt_cache::source_g", stp->st_rtip->rti_dbip->dbi_filename);
-	}
-	db5_export_attributes(&attributes_external, &attributes);
-	bu_vls_free(&version_vls);
-	bu_avs_free(&attributes);
-    }
-
     /* [FIXME: redundant] make sure we can write to the cache dir */
     if (!bu_file_writable(cache->dir) || !bu_file_executable(cache->dir)) {
 	cache_warn(cache, cache->dir, "Directory is not writable.  Caching disabled.");
-	bu_free_external(&attributes_external);
-	bu_free_external(&data_external);
+	bu_free_external(attributes_external);
+	bu_free_external(data_external);
 	return 0;
     }
     cache_get_objdir(cache, name, tmppath, MAXPATHLEN);
@@ -599,8 +572,8 @@ cache_try_store(struct rt_cache *cache, const char *name, const struct rt_db_int
 	char objdir[MAXPATHLEN] = {0};
 	bu_path_basename(tmppath, objdir);
 	cache_warn(cache, objdir, "Subdirectory is not writable.  Caching disabled.");
-	bu_free_external(&attributes_external);
-	bu_free_external(&data_external);
+	bu_free_external(attributes_external);
+	bu_free_external(data_external);
 	return 0;
     }
 
@@ -612,17 +585,20 @@ cache_try_store(struct rt_cache *cache, const char *name, const struct rt_db_int
 
     if (!cache_create_dir(cache, tmpname)) {
 	CACHE_DEBUG("++++++ [%lu.%lu] Failed to create cache dir %s\n", bu_pid(), bu_parallel_id(), tmpname);
-	bu_free_external(&attributes_external);
-	bu_free_external(&data_external);
+	bu_free_external(attributes_external);
+	bu_free_external(data_external);
 	return 0; /* no storage */
     }
 
-    db5_export_object3(&db_external, 0, name, 0, &attributes_external,
-		       &data_external, DB5_MAJORTYPE_BINARY_MIME, 0,
+    db5_export_object3(&db_external, 0, name, 0, attributes_external,
+		       data_external, DB5_MAJORTYPE_BINARY_MIME, 0,
 		       DB5_ZZZ_UNCOMPRESSED, DB5_ZZZ_UNCOMPRESSED);
 
     focache = fopen(tmppath, "wb");
     if (!focache) {
+	bu_free_external(&db_external);
+	bu_free_external(attributes_external);
+	bu_free_external(data_external);
 	CACHE_DEBUG("++++++ [%lu.%lu] Failed to put cache temp %s\n", bu_pid(), bu_parallel_id(), tmpname);
 	return 0; /* can't stash */
     }
@@ -631,8 +607,8 @@ cache_try_store(struct rt_cache *cache, const char *name, const struct rt_db_int
 	fclose(focache);
 	bu_file_delete(tmppath);
 	bu_free_external(&db_external);
-	bu_free_external(&attributes_external);
-	bu_free_external(&data_external);
+	bu_free_external(attributes_external);
+	bu_free_external(data_external);
 	CACHE_DEBUG("++++++ [%lu.%lu] Failed to put cache temp %s\n", bu_pid(), bu_parallel_id(), tmpname);
 	return 0; /* can't stash */
     }
@@ -641,8 +617,8 @@ cache_try_store(struct rt_cache *cache, const char *name, const struct rt_db_int
     CACHE_DEBUG("++++++ [%lu.%lu] Successfully wrote cache temp %s\n", bu_pid(), bu_parallel_id(), tmpname);
 
     bu_free_external(&db_external);
-    bu_free_external(&attributes_external);
-    bu_free_external(&data_external);
+    bu_free_external(attributes_external);
+    bu_free_external(data_external);
 
     /* get the real / final cache object file name */
     cache_get_objfile(cache, name, path, MAXPATHLEN);
@@ -679,13 +655,7 @@ cache_try_store(struct rt_cache *cache, const char *name, const struct rt_db_int
 	CACHE_DEBUG("++++++ [%lu.%lu] No longer need %s\n", bu_pid(), bu_parallel_id(), tmpname);
 	bu_file_delete(tmppath);
 
-	if (cache_read_entry(cache, name) != NULL) {
-	    CACHE_DEBUG("++++++ [%lu.%lu] Successfully read %s\n", bu_pid(), bu_parallel_id(), name);
-	    return 1;
-	} else {
-	    CACHE_DEBUG("++++++ [%lu.%lu] BUT we can't read %s !!!  Giving up.\n", bu_pid(), bu_parallel_id(), name);
-	    return 0;
-	}
+	return 1;
     }
 
     /* atomically flip it into place */
@@ -700,9 +670,56 @@ cache_try_store(struct rt_cache *cache, const char *name, const struct rt_db_int
 	return 0; /* someone probably beat us to it */
     }
 
+    return 1;
+}
+
+
+static int
+cache_try_store(struct rt_cache *cache, const char *name, const struct rt_db_internal *internal, struct soltab *stp)
+{
+    struct bu_external attributes_external = BU_EXTERNAL_INIT_ZERO;
+    struct bu_external data_external = BU_EXTERNAL_INIT_ZERO;
+    size_t version = (size_t)-1;
+
+    RT_CK_DB_INTERNAL(internal);
+    RT_CK_SOLTAB(stp);
+
+    CACHE_DEBUG("++++ [%lu.%lu] Trying to STORE %s\n", bu_pid(), bu_parallel_id(), name);
+
+    if (rt_obj_prep_serialize(stp, internal, &data_external, &version) || version == (size_t)-1) {
+	CACHE_DEBUG("++++++ [%lu.%lu] Failed to serialize %s\n", bu_pid(), bu_parallel_id(), name);
+	return 0; /* can't serialize */
+    }
+
+    compress_external(cache, &data_external);
+
+    {
+	struct bu_attribute_value_set attributes = BU_AVS_INIT_ZERO;
+	struct bu_vls version_vls = BU_VLS_INIT_ZERO;
+
+	bu_vls_sprintf(&version_vls, "%zu", version);
+	bu_avs_add(&attributes, "mime_type", cache_mime_type);
+	bu_avs_add(&attributes, "rt_cache::version", bu_vls_addr(&version_vls));
+	if (stp->st_dp && stp->st_dp->d_namep) {
+	    bu_avs_add(&attributes, "rt_cache::source_obj", stp->st_dp->d_namep);
+	}
+	if (stp->st_rtip && stp->st_rtip->rti_dbip->dbi_filename) {
+	    bu_avs_add(&attributes, "rt_cache::source_g", stp->st_rtip->rti_dbip->dbi_filename);
+	}
+	db5_export_attributes(&attributes_external, &attributes);
+	bu_vls_free(&version_vls);
+	bu_avs_free(&attributes);
+    }
+
+    if (!cache_write_object(cache, name, &attributes_external, &data_external))
+	return 0;
+
     if (cache_read_entry(cache, name) != NULL) {
+	CACHE_DEBUG("++++++ [%lu.%lu] Successfully read %s\n", bu_pid(), bu_parallel_id(), name);
 	return 1;
     }
+
+    CACHE_DEBUG("++++++ [%lu.%lu] BUT we can't read %s !!!  Giving up.\n", bu_pid(), bu_parallel_id(), name);
     return 0;
 }
 
@@ -732,6 +749,523 @@ rt_cache_prep(struct rt_cache *cache, struct soltab *stp, struct rt_db_internal
 }
 
 
+/*
+ * Tessellation cache.
+ *
+ * Tessellations are stored as plain planar polygon meshes in network
+ * order, uncompressed, so a cached mesh is rebuilt directly from the
+ * mapped cache file.  The layout is:
+ *
+ *   header   vertex, shell, face and corner counts (4 longs)
+ *   vertex   point (3 doubles)
+ *   shell    face count (1 long)
+ *   face     plane of the OT_SAME faceuse, corner count (4 doubles, 1 long)
+ *   corner   vertex index, flags, vertexuse normal (2 longs, 3 doubles)
+ *
+ * Faces are listed in shell order and corners in loop order.  Only
+ * tessellations made of single-loop planar faces with straight edges
+ * are cached; anything else is simply tessellated every time.
+ */
+
+#define CACHE_TESS_VERSION 2
+
+#define TESS_HDR_SIZE (4 * SIZEOF_NETWORK_LONG)
+#define TESS_VERT_SIZE (ELEMENTS_PER_POINT * SIZEOF_NETWORK_DOUBLE)
+#define TESS_SHELL_SIZE SIZEOF_NETWORK_LONG
+#define TESS_FACE_SIZE (ELEMENTS_PER_PLANE * SIZEOF_NETWORK_DOUBLE + SIZEOF_NETWORK_LONG)
+#define TESS_CORNER_SIZE (2 * SIZEOF_NETWORK_LONG + ELEMENTS_PER_VECT * SIZEOF_NETWORK_DOUBLE)
+
+#define TESS_CORNER_REAL 0x1	/* edge leaving this corner is real */
+#define TESS_CORNER_NORMAL 0x2	/* vertexuse normal is set */
+
+static const char * const cache_tess_mime_type = "brlcad/cache-tess";
+
+
+static unsigned char *
+tess_put_long(unsigned char *cp, size_t val)
+{
+    uint32_t nval = htonl((uint32_t)val);
+    memcpy(cp, &nval, SIZEOF_NETWORK_LONG);
+    return cp + SIZEOF_NETWORK_LONG;
+}
+
+
+static const unsigned char *
+tess_get_long(const unsigned char *cp, size_t *val)
+{
+    uint32_t nval;
+    memcpy(&nval, cp, SIZEOF_NETWORK_LONG);
+    *val = ntohl(nval);
+    return cp + SIZEOF_NETWORK_LONG;
+}
+
+
+static unsigned char *
+tess_put_doubles(unsigned char *cp, const fastf_t *vals, size_t count)
+{
+    double d[ELEMENTS_PER_PLANE];
+    size_t i;
+
+    for (i = 0; i < count; i++)
+	d[i] = vals[i];
+    bu_cv_htond(cp, (const unsigned char *)d, count);
+    return cp + count * SIZEOF_NETWORK_DOUBLE;
+}
+
+
+static const unsigned char *
+tess_get_doubles(const unsigned char *cp, fastf_t *vals, size_t count)
+{
+    double d[ELEMENTS_PER_PLANE];
+    size_t i;
+
+    bu_cv_ntohd((unsigned char *)d, cp, count);
+    for (i = 0; i < count; i++)
+	vals[i] = d[i];
+    return cp + count * SIZEOF_NETWORK_DOUBLE;
+}
+
+
+static int
+cache_tess_name(char name[STATIC_ARRAY(37)], const struct rt_db_internal *ip, const struct bg_tess_tol *ttol, const struct bn_tol *tol)
+{
+    struct bu_external ext = BU_EXTERNAL_INIT_ZERO;
+    uint8_t namespace_uuid[16];
+    uint8_t uuid[16];
+    /* arbitrary namespace for a v5 uuid, distinct from the prep one */
+    const uint8_t base_namespace_uuid[16] = {0x7c, 0x05, 0x2e, 0x91, 0x5b, 0x44, 0x4f, 0x0a, 0xa3, 0x6d, 0x1e, 0xc2, 0x38, 0xf9, 0x60, 0x17};
+    uint8_t tol_buffer[2 * SIZEOF_NETWORK_LONG + SIZEOF_NETWORK_DOUBLE * 5];
+    double tols[5];
+    const struct rt_functab *ft;
+
+    RT_CK_DB_INTERNAL(ip);
+
+    /* these take their shape from other objects or from data files,
+     * which their own external form does not capture.
+     */
+    switch (ip->idb_minor_type) {
+	case ID_EBM:
+	case ID_VOL:
+	case ID_DSP:
+	case ID_EXTRUDE:
+	case ID_SUBMODEL:
+	case ID_REVOLVE:
+	    return 0;
+    }
+
+    if (ip->idb_major_type != DB5_MAJORTYPE_BRLCAD || ip->idb_minor_type < 0)
+	return 0;
+
+    ft = &OBJ[ip->idb_minor_type];
+    if (!ft->ft_export5)
+	return 0;
+
+    /* the export of different primitives can have the same size and
+     * layout (RHC and EPA, ELL and EHY), so the type goes into the
+     * name along with the format version and the tolerances.
+     */
+    tess_put_long(tol_buffer, CACHE_TESS_VERSION);
+    tess_put_long(tol_buffer + SIZEOF_NETWORK_LONG, (size_t)ip->idb_minor_type);
+    tols[0] = ttol->abs;
+    tols[1] = ttol->rel;
+    tols[2] = ttol->norm;
+    tols[3] = tol->dist;
+    tols[4] = tol->perp;
+    bu_cv_htond(tol_buffer + 2 * SIZEOF_NETWORK_LONG, (const unsigned char *)tols, 5);
+
+    if (bu_uuid_create(namespace_uuid, sizeof(tol_buffer), tol_buffer, base_namespace_uuid) != 5)
+	return 0;
+
+    /* the internal form is already placed by its matrix, so the
+     * export captures placement as well as shape.
+     */
+    if (ft->ft_export5(&ext, ip, 1.0, NULL, NULL) < 0) {
+	bu_free_external(&ext);
+	return 0;
+    }
+
+    if (bu_uuid_create(uuid, ext.ext_nbytes, ext.ext_buf, namespace_uuid) != 5) {
+	bu_free_external(&ext);
+	return 0;
+    }
+    bu_free_external(&ext);
+
+    if (bu_uuid_encode(uuid, (uint8_t *)name))
+	return 0;
+
+    return 1;
+}
+
+
+/* returns truthfully if the region can be cached, encoding it into
+ * data.
+ */
+static int
+cache_tess_encode(struct bu_external *data, const struct nmgregion *r)
+{
+    const struct shell *s;
+    const struct faceuse *fu;
+    const struct loopuse *lu;
+    const struct edgeuse *eu;
+    struct model *m;
+    long *vindex;
+    size_t nverts = 0, nshells = 0, nfaces = 0, ncorners = 0;
+    unsigned char *cp;
+
+    NMG_CK_REGION(r);
+    m = r->m_p;
+    NMG_CK_MODEL(m);
+
+    /* check and count, numbering vertices by first use */
+    vindex = (long *)bu_malloc(m->maxindex * sizeof(long), "vindex");
+    memset(vindex, -1, m->maxindex * sizeof(long));
+
+    for (BU_LIST_FOR(s, shell, &r->s_hd)) {
+	if (s->vu_p || BU_LIST_NON_EMPTY(&s->lu_hd) || BU_LIST_NON_EMPTY(&s->eu_hd))
+	    goto fail;
+	nshells++;
+	for (BU_LIST_FOR(fu, faceuse, &s->fu_hd)) {
+	    size_t cnt = 0;
+
+	    if (fu->orientation == OT_OPPOSITE)
+		continue;
+	    if (fu->orientation != OT_SAME || !fu->f_p->g.magic_p
+		|| *fu->f_p->g.magic_p != NMG_FACE_G_PLANE_MAGIC)
+		goto fail;
+
+	    lu = BU_LIST_FIRST(loopuse, &fu->lu_hd);
+	    if (BU_LIST_NEXT_NOT_HEAD(lu, &fu->lu_hd) || lu->orientation != OT_SAME
+		|| BU_LIST_FIRST_MAGIC(&lu->down_hd) != NMG_EDGEUSE_MAGIC)
+		goto fail;
+
+	    for (BU_LIST_FOR(eu, edgeuse, &lu->down_hd)) {
+		const struct vertex *v = eu->vu_p->v_p;
+
+		if (eu->g.magic_p && *eu->g.magic_p != NMG_EDGE_G_LSEG_MAGIC)
+		    goto fail;
+		if (!v->vg_p)
+		    goto fail;
+		if (vindex[v->index] < 0)
+		    vindex[v->index] = (long)nverts++;
+		cnt++;
+	    }
+	    if (cnt < 3)
+		goto fail;
+	    ncorners += cnt;
+	    nfaces++;
+	}
+    }
+    if (!nfaces)
+	goto fail;
+
+    data->ext_nbytes = TESS_HDR_SIZE + nverts * TESS_VERT_SIZE + nshells * TESS_SHELL_SIZE
+	+ nfaces * TESS_FACE_SIZE + ncorners * TESS_CORNER_SIZE;
+    data->ext_buf = (uint8_t *)bu_calloc(data->ext_nbytes, 1, "tess cache data");
+
+    cp = data->ext_buf;
+    cp = tess_put_long(cp, nverts);
+    cp = tess_put_long(cp, nshells);
+    cp = tess_put_long(cp, nfaces);
+    cp = tess_put_long(cp, ncorners);
+
+    for (BU_LIST_FOR(s, shell, &r->s_hd)) {
+	for (BU_LIST_FOR(fu, faceuse, &s->fu_hd)) {
+	    if (fu->orientation != OT_SAME)
+		continue;
+	    lu = BU_LIST_FIRST(loopuse, &fu->lu_hd);
+	    for (BU_LIST_FOR(eu, edgeuse, &lu->down_hd)) {
+		const struct vertex *v = eu->vu_p->v_p;
+		if (vindex[v->index] >= 0) {
+		    tess_put_doubles(data->ext_buf + TESS_HDR_SIZE + vindex[v->index] * TESS_VERT_SIZE, v->vg_p->coord, ELEMENTS_PER_POINT);
+		}
+	    }
+	}
+    }
+    cp += nverts * TESS_VERT_SIZE;
+
+    for (BU_LIST_FOR(s, shell, &r->s_hd)) {
+	size_t cnt = 0;
+	for (BU_LIST_FOR(fu, faceuse, &s->fu_hd)) {
+	    if (fu->orientation == OT_SAME)
+		cnt++;
+	}
+	cp = tess_put_long(cp, cnt);
+    }
+
+    for (BU_LIST_FOR(s, shell, &r->s_hd)) {
+	for (BU_LIST_FOR(fu, faceuse, &s->fu_hd)) {
+	    plane_t pl;
+
+	    if (fu->orientation != OT_SAME)
+		continue;
+	    lu = BU_LIST_FIRST(loopuse, &fu->lu_hd);
+	    NMG_GET_FU_PLANE(pl, fu);
+	    cp = tess_put_doubles(cp, pl, ELEMENTS_PER_PLANE);
+	    cp = tess_put_long(cp, (size_t)bu_list_len(&lu->down_hd));
+	}
+    }
+
+    for (BU_LIST_FOR(s, shell, &r->s_hd)) {
+	for (BU_LIST_FOR(fu, faceuse, &s->fu_hd)) {
+	    if (fu->orientation != OT_SAME)
+		continue;
+	    lu = BU_LIST_FIRST(loopuse, &fu->lu_hd);
+	    for (BU_LIST_FOR(eu, edgeuse, &lu->down_hd)) {
+		const struct vertexuse *vu = eu->vu_p;
+		size_t flags = 0;
+		vect_t N = VINIT_ZERO;
+
+		if (eu->e_p->is_real)
+		    flags |= TESS_CORNER_REAL;
+		if (vu->a.magic_p && *vu->a.magic_p == NMG_VERTEXUSE_A_PLANE_MAGIC) {
+		    flags |= TESS_CORNER_NORMAL;
+		    VMOVE(N, vu->a.plane_p->N);
+		}
+		cp = tess_put_long(cp, vindex[vu->v_p->index]);
+		cp = tess_put_long(cp, flags);
+		cp = tess_put_doubles(cp, N, ELEMENTS_PER_VECT);
+	    }
+	}
+    }
+
+    bu_free(vindex, "vindex");
+    return 1;
+
+fail:
+    bu_free(vindex, "vindex");
+    return 0;
+}
+
+
+/* rebuilds a region written by cache_tess_encode() in model m.
+ * returns truthfully on success, leaving m untouched on failure.
+ */
+static int
+cache_tess_decode(struct nmgregion **r, struct model *m, const uint8_t *buf, size_t nbytes, const struct bn_tol *tol)
+{
+    const unsigned char *cp = buf;
+    const unsigned char *shells, *faces, *corners;
+    size_t nverts, nshells, nfaces, ncorners;
+    size_t i, j, k, cnt, total, maxcnt;
+    struct vertex **verts;
+    struct vertex ***vertp;
+    struct shell *s;
+
+    if (nbytes < TESS_HDR_SIZE)
+	return 0;
+
+    cp = tess_get_long(cp, &nverts);
+    cp = tess_get_long(cp, &nshells);
+    cp = tess_get_long(cp, &nfaces);
+    cp = tess_get_long(cp, &ncorners);
+
+    if (!nshells || !nfaces || nbytes != TESS_HDR_SIZE + nverts * TESS_VERT_SIZE + nshells * TESS_SHELL_SIZE
+	+ nfaces * TESS_FACE_SIZE + ncorners * TESS_CORNER_SIZE)
+	return 0;
+
+    shells = cp + nverts * TESS_VERT_SIZE;
+    faces = shells + nshells * TESS_SHELL_SIZE;
+    corners = faces + nfaces * TESS_FACE_SIZE;
+
+    /* validate counts and indices before touching the model */
+    for (i = 0, total = 0, cp = shells; i < nshells; i++) {
+	cp = tess_get_long(cp, &cnt);
+	total += cnt;
+    }
+    if (total != nfaces)
+	return 0;
+    for (i = 0, total = 0, maxcnt = 0, cp = faces; i < nfaces; i++) {
+	cp = tess_get_long(cp + ELEMENTS_PER_PLANE * SIZEOF_NETWORK_DOUBLE, &cnt);
+	if (cnt < 3)
+	    return 0;
+	if (cnt > maxcnt)
+	    maxcnt = cnt;
+	total += cnt;
+    }
+    if (total != ncorners)
+	return 0;
+    for (i = 0, cp = corners; i < ncorners; i++, cp += TESS_CORNER_SIZE) {
+	size_t vi;
+	tess_get_long(cp, &vi);
+	if (vi >= nverts)
+	    return 0;
+    }
+
+    verts = (struct vertex **)bu_calloc(nverts, sizeof(struct vertex *), "tess cache verts");
+    vertp = (struct vertex ***)bu_calloc(maxcnt, sizeof(struct vertex **), "tess cache vertp");
+
+    *r = nmg_mrsv(m);
+    s = BU_LIST_FIRST(shell, &(*r)->s_hd);
+
+    for (i = 0; i < nshells; i++) {
+	size_t shell_faces;
+
+	shells = tess_get_long(shells, &shell_faces);
+	if (i > 0)
+	    s = nmg_msv(*r);
+
+	for (j = 0; j < shell_faces; j++) {
+	    const unsigned char *face_corners = corners;
+	    struct faceuse *fu;
+	    struct loopuse *lu;
+	    struct edgeuse *eu;
+	    plane_t pl;
+
+	    faces = tess_get_doubles(faces, pl, ELEMENTS_PER_PLANE);
+	    faces = tess_get_long(faces, &cnt);
+
+	    for (k = 0; k < cnt; k++, corners += TESS_CORNER_SIZE) {
+		size_t vi;
+		tess_get_long(corners, &vi);
+		vertp[k] = &verts[vi];
+	    }
+
+	    fu = nmg_cmface(s, vertp, (int)cnt);
+	    nmg_face_g(fu, pl);
+
+	    /* the loop follows the corners, find where it starts */
+	    lu = BU_LIST_FIRST(loopuse, &fu->lu_hd);
+	    for (BU_LIST_FOR(eu, edgeuse, &lu->down_hd)) {
+		if (eu->vu_p->v_p == *vertp[0])
+		    break;
+	    }
+
+	    for (k = 0; k < cnt; k++, face_corners += TESS_CORNER_SIZE) {
+		size_t vi, flags;
+
+		if (BU_LIST_IS_HEAD(eu, &lu->down_hd))
+		    eu = BU_LIST_FIRST(edgeuse, &lu->down_hd);
+
+		tess_get_long(tess_get_long(face_corners, &vi), &flags);
+		if (flags & TESS_CORNER_REAL)
+		    eu->e_p->is_real = 1;
+		if (flags & TESS_CORNER_NORMAL) {
+		    struct edgeuse *prev = BU_LIST_PPREV_CIRC(edgeuse, eu);
+		    vect_t N, rev;
+
+		    tess_get_doubles(face_corners + 2 * SIZEOF_NETWORK_LONG, N, ELEMENTS_PER_VECT);
+		    VREVERSE(rev, N);
+		    nmg_vertexuse_nv(eu->vu_p, N);
+		    /* the mate loop runs backwards, so the previous
+		     * edge's mate starts at this vertex.
+		     */
+		    nmg_vertexuse_nv(prev->eumate_p->vu_p, rev);
+		}
+		eu = BU_LIST_PNEXT(edgeuse, eu);
+	    }
+	}
+    }
+
+    cp = buf + TESS_HDR_SIZE;
+    for (i = 0; i < nverts; i++) {
+	point_t pt;
+	cp = tess_get_doubles(cp, pt, ELEMENTS_PER_POINT);
+	if (verts[i])
+	    nmg_vertex_gv(verts[i], pt);
+    }
+
+    bu_free(vertp, "tess cache vertp");
+    bu_free(verts, "tess cache verts");
+
+    nmg_region_a(*r, tol);
+
+    return 1;
+}
+
+
+static int
+cache_tess_load(const struct rt_cache *cache, const char *name, struct nmgregion **r, struct model *m, const struct bn_tol *tol)
+{
+    char path[MAXPATHLEN] = {0};
+    struct bu_mapped_file *mfp;
+    struct db5_raw_internal raw_internal;
+    int ret = 0;
+
+    cache_get_objfile(cache, name, path, MAXPATHLEN);
+    if (!bu_file_exists(path, NULL))
+	return 0;
+
+    CACHE_DEBUG("++++ [%lu.%lu] Trying to LOAD tessellation %s\n", bu_pid(), bu_parallel_id(), name);
+
+    mfp = bu_open_mapped_file(path, NULL);
+    if (!mfp || !mfp->buf) {
+	if (mfp)
+	    bu_close_mapped_file(mfp);
+	return 0;
+    }
+
+    if (db5_get_raw_internal_ptr(&raw_internal, (const unsigned char *)mfp->buf) != NULL) {
+	struct bu_attribute_value_set attributes;
+
+	if (db5_import_attributes(&attributes, &raw_internal.attributes) >= 0) {
+	    const char *version_str = bu_avs_get(&attributes, "rt_cache::version");
+
+	    if (BU_STR_EQUAL(cache_tess_mime_type, bu_avs_get(&attributes, "mime_type"))
+		&& version_str && atoi(version_str) == CACHE_TESS_VERSION)
+	    {
+		ret = cache_tess_decode(r, m, raw_internal.body.ext_buf, raw_internal.body.ext_nbytes, tol);
+	    }
+	    bu_avs_free(&attributes);
+	}
+    }
+
+    bu_close_mapped_file(mfp);
+    return ret;
+}
+
+
+static void
+cache_tess_store(struct rt_cache *cache, const char *name, const struct nmgregion *r)
+{
+    struct bu_external attributes_external = BU_EXTERNAL_INIT_ZERO;
+    struct bu_external data_external = BU_EXTERNAL_INIT_ZERO;
+    struct bu_attribute_value_set attributes = BU_AVS_INIT_ZERO;
+    struct bu_vls version_vls = BU_VLS_INIT_ZERO;
+
+    CACHE_DEBUG("++++ [%lu.%lu] Trying to STORE tessellation %s\n", bu_pid(), bu_parallel_id(), name);
+
+    if (!cache_tess_encode(&data_external, r)) {
+	CACHE_DEBUG("++++++ [%lu.%lu] Tessellation %s can not be cached\n", bu_pid(), bu_parallel_id(), name);
+	return;
+    }
+
+    bu_vls_sprintf(&version_vls, "%d", CACHE_TESS_VERSION);
+    bu_avs_add(&attributes, "mime_type", cache_tess_mime_type);
+    bu_avs_add(&attributes, "rt_cache::version", bu_vls_cstr(&version_vls));
+    db5_export_attributes(&attributes_external, &attributes);
+    bu_vls_free(&version_vls);
+    bu_avs_free(&attributes);
+
+    (void)cache_write_object(cache, name, &attributes_external, &data_external);
+}
+
+
+int
+rt_cache_tess(struct rt_cache *cache, struct nmgregion **r, struct model *m, struct rt_db_internal *internal, const struct bg_tess_tol *ttol, const struct bn_tol *tol)
+{
+    char name[37] = {0};
+    const struct rt_functab *ft;
+    int ret;
+
+    RT_CK_DB_INTERNAL(internal);
+    ft = &OBJ[internal->idb_minor_type];
+
+    if (!cache || !ttol || !tol || *r || !cache_tess_name(name, internal, ttol, tol))
+	return ft->ft_tessellate(r, m, internal, ttol, tol);
+
+    if (cache_tess_load(cache, name, r, m, tol))
+	return 0; /* found in cache */
+
+    /* not in cache yet */
+
+    ret = ft->ft_tessellate(r, m, internal, ttol, tol);
+    if (ret == 0 && *r && !cache->read_only)
+	cache_tess_store(cache, name, *r);
+
+    return ret;
+}
+
+
 void
 rt_cache_close(struct rt_cache *cache)
 {
@@ -19,7 +19,7 @@
  */
 /** @file cache.h
  *
- * Caching of prep data
+ * Caching of prep and tessellation data
  *
  */
 
@@ -32,6 +32,8 @@
 
 #include "rt/db_internal.h"
 #include "rt/soltab.h"
+#include "bg/defines.h"
+#include "nmg.h"
 
 
 __BEGIN_DECLS
@@ -88,6 +90,18 @@ void rt_cache_close(struct rt_cache *cache);
  */
 int rt_cache_prep(struct rt_cache *cache, struct soltab *stp, struct rt_db_internal *ip);
 
+/**
+ * tessellates an object, reading the result from cache when
+ * available.
+ *
+ * works like rt_obj_tess(), with the object looked up (and cached)
+ * based on its export data and the tessellation tolerances.  cached
+ * tessellations are plain polygon meshes, so only tessellations made
+ * of planar single-loop faces are stored; others are tessellated on
+ * every call.
+ */
+int rt_cache_tess(struct rt_cache *cache, struct nmgregion **r, struct model *m, struct rt_db_internal *ip, const struct bg_tess_tol *ttol, const struct bn_tol *tol);
+
 
 __END_DECLS
 
@@ -48,6 +48,7 @@
 #include "raytrace.h"
 #include "bg/plane.h"
 #include "bv/plot3.h"
+#include "./librt_private.h"
 
 
 static int rt_ck_overlap(const vect_t min, const vect_t max, const struct soltab *stp, const struct rt_i *rtip);
@@ -594,8 +595,8 @@ rt_ck_overlap(const vect_t min, const vect_t max, const struct soltab *stp, cons
     }
 
     /* RPP overlaps, invoke per-solid method for detailed check */
-    if (OBJ[stp->st_id].ft_classify &&
-	OBJ[stp->st_id].ft_classify(stp, min, max, &rtip->rti_tol) == BG_CLASSIFY_OUTSIDE)
+    if (stp->st_meth->ft_classify &&
+	stp->st_meth->ft_classify(stp, min, max, &rtip->rti_tol) == BG_CLASSIFY_OUTSIDE)
 	return 0;
 
     /* don't know, check it */
@@ -1112,6 +1113,218 @@ rt_ct_measure(register struct rt_i *rtip, register union cutter *cutp, size_t de
 }
 
 
+int
+rt_numa_replicas(void)
+{
+    const char *env = getenv("LIBRT_NUMA_REPLICATE");
+    char *end = NULL;
+    long n;
+
+    if (!env || !*env)
+	return 0;
+
+    /* a count forces that many copies, whatever the node count */
+    n = strtol(env, &end, 10);
+    if (end != env) {
+	if (n <= 0)
+	    return 0;
+	return (n > MAX_PSW) ? MAX_PSW : (int)n;
+    }
+
+    /* anything else asks for one copy per node */
+    return (bu_numa_nodes() > 1) ? bu_numa_nodes() : 0;
+}
+
+
+int
+rt_numa_replica(int replicas)
+{
+    int nodes = bu_numa_nodes();
+    int node = bu_numa_node();
+    int mine, id;
+
+    if (replicas <= 1)
+	return 0;
+    if (node < 0 || node >= nodes)
+	node = 0;
+    if (replicas <= nodes)
+	return node % replicas;
+
+    /* copies node, node + nodes, ... were made on this node, spread
+     * its threads over them */
+    mine = (replicas - node + nodes - 1) / nodes;
+    id = bu_parallel_id();
+    if (id < 0)
+	id = 0;
+    return node + nodes * (id % mine);
+}
+
+
+/*
+ * Deep copy of a cut tree.  Nodes and their lists are new, the
+ * soltabs they refer to are shared with the original.
+ */
+static union cutter *
+rt_ct_dup(const union cutter *cutp)
+{
+    union cutter *dup;
+    size_t i;
+
+    dup = (union cutter *)bu_malloc(sizeof(union cutter), "numa cutter");
+    *dup = *cutp;
+
+    switch (cutp->cut_type) {
+	case CUT_CUTNODE:
+	    dup->cn.cn_l = rt_ct_dup(cutp->cn.cn_l);
+	    dup->cn.cn_r = rt_ct_dup(cutp->cn.cn_r);
+	    break;
+
+	case CUT_BOXNODE:
+	    dup->bn.bn_list = (struct soltab **)NULL;
+	    dup->bn.bn_maxlen = cutp->bn.bn_len;
+	    if (cutp->bn.bn_len) {
+		dup->bn.bn_list = (struct soltab **)bu_malloc(cutp->bn.bn_len * sizeof(struct soltab *), "numa bn_list[]");
+		memcpy(dup->bn.bn_list, cutp->bn.bn_list, cutp->bn.bn_len * sizeof(struct soltab *));
+	    }
+
+	    dup->bn.bn_piecelist = (struct rt_piecelist *)NULL;
+	    dup->bn.bn_maxpiecelen = cutp->bn.bn_piecelen;
+	    if (cutp->bn.bn_piecelen) {
+		dup->bn.bn_piecelist = (struct rt_piecelist *)bu_malloc(cutp->bn.bn_piecelen * sizeof(struct rt_piecelist), "numa bn_piecelist[]");
+		for (i = 0; i < cutp->bn.bn_piecelen; i++) {
+		    const struct rt_piecelist *plp = &cutp->bn.bn_piecelist[i];
+		    struct rt_piecelist *dlp = &dup->bn.bn_piecelist[i];
+
+		    *dlp = *plp;
+		    dlp->pieces = NULL;
+		    if (plp->npieces) {
+			dlp->pieces = (long *)bu_malloc(plp->npieces * sizeof(long), "numa pieces[]");
+			memcpy(dlp->pieces, plp->pieces, plp->npieces * sizeof(long));
+		    }
+		}
+	    }
+	    break;
+
+	default:
+	    break;
+    }
+
+    return dup;
+}
+
+
+static void
+rt_ct_dup_free(union cutter *cutp)
+{
+    size_t i;
+
+    switch (cutp->cut_type) {
+	case CUT_CUTNODE:
+	    rt_ct_dup_free(cutp->cn.cn_l);
+	    rt_ct_dup_free(cutp->cn.cn_r);
+	    break;
+
+	case CUT_BOXNODE:
+	    if (cutp->bn.bn_list)
+		bu_free(cutp->bn.bn_list, "numa bn_list[]");
+	    for (i = 0; i < cutp->bn.bn_piecelen; i++) {
+		if (cutp->bn.bn_piecelist[i].pieces)
+		    bu_free(cutp->bn.bn_piecelist[i].pieces, "numa pieces[]");
+	    }
+	    if (cutp->bn.bn_piecelist)
+		bu_free(cutp->bn.bn_piecelist, "numa bn_piecelist[]");
+	    break;
+
+	default:
+	    break;
+    }
+
+    bu_free(cutp, "numa cutter");
+}
+
+
+struct rt_numa_replicate_data {
+    struct rt_i *rtip;
+    int replicas;
+};
+
+
+/* Runs bound to one NUMA node so its copies land in its memory */
+static void
+rt_numa_replicate_node(int node, void *data)
+{
+    struct rt_numa_replicate_data *rd = (struct rt_numa_replicate_data *)data;
+    struct rt_i *rtip = rd->rtip;
+    int nodes = bu_numa_nodes();
+    struct soltab *stp;
+    int i;
+
+    for (i = node; i < rd->replicas; i += nodes) {
+	if (rtip->rti_numa_cut && i < rtip->rti_numa_nodes)
+	    rtip->rti_numa_cut[i] = rt_ct_dup(&rtip->rti_CutHead);
+
+	RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
+	    if (stp->st_id == ID_BOT)
+		rt_bot_replicate(stp, i);
+	} RT_VISIT_ALL_SOLTABS_END;
+    }
+}
+
+
+void
+rt_cut_replicas_free(struct rt_i *rtip)
+{
+    int i;
+
+    RT_CK_RTI(rtip);
+
+    if (!rtip->rti_numa_cut)
+	return;
+
+    for (i = 0; i < rtip->rti_numa_nodes; i++) {
+	if (rtip->rti_numa_cut[i])
+	    rt_ct_dup_free(rtip->rti_numa_cut[i]);
+    }
+    bu_free(rtip->rti_numa_cut, "rti_numa_cut[]");
+    rtip->rti_numa_cut = (union cutter **)NULL;
+    rtip->rti_numa_nodes = 0;
+}
+
+
+void
+rt_numa_replicate(struct rt_i *rtip)
+{
+    struct rt_numa_replicate_data rd;
+    int replicas = rt_numa_replicas();
+    struct soltab *stp;
+
+    RT_CK_RTI(rtip);
+
+    rt_cut_replicas_free(rtip);
+
+    /* the tables are sized here, the node threads only fill in
+     * their own entries */
+    RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
+	if (stp->st_id == ID_BOT)
+	    rt_bot_replicas(stp, replicas);
+    } RT_VISIT_ALL_SOLTABS_END;
+
+    if (!replicas)
+	return;
+
+    if (rtip->rti_CutHead.cut_type == CUT_CUTNODE || rtip->rti_CutHead.cut_type == CUT_BOXNODE) {
+	rtip->rti_numa_cut = (union cutter **)bu_calloc(replicas, sizeof(union cutter *), "rti_numa_cut[]");
+	rtip->rti_numa_nodes = replicas;
+    }
+    rd.rtip = rtip;
+    rd.replicas = replicas;
+    bu_numa_run(rt_numa_replicate_node, &rd);
+
+    if (RT_G_DEBUG & RT_DEBUG_CUT)
+	bu_log("rt_numa_replicate: prep data copied %d times over %d NUMA nodes\n", replicas, bu_numa_nodes());
+}
+
+
 void
 rt_cut_clean(struct rt_i *rtip)
 {
@@ -397,6 +397,7 @@ db_rm_changed_clbk(struct db_i *dbip, dbi_changed_t c, void *u_data)
 	BU_PUT(cb, struct dbi_changed_clbk);
 	rm_cnt++;
     }
+    bu_ptbl_free(&rm_clbks);
 
     return rm_cnt;
 }
@@ -435,6 +436,7 @@ db_rm_update_nref_clbk(struct db_i *dbip, dbi_update_nref_t c, void *u_data)
 	BU_PUT(cb, struct dbi_update_nref_clbk);
 	rm_cnt++;
     }
+    bu_ptbl_free(&rm_clbks);
 
     return rm_cnt;
 }
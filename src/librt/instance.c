@@ -0,0 +1,319 @@
+/*                      I N S T A N C E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file librt/instance.c
+ *
+ * Placements of a solid that share the prep of another placement.
+ *
+ * When rti_instance_prep is set, a solid that is referenced again
+ * under a different matrix does not get prepped again if the new
+ * matrix differs from the first placement's only by a rotation and
+ * translation.  The new soltab instead refers to the first one (the
+ * prototype), and its methods carry rays into the prototype's
+ * coordinates and carry hit points, normals and curvature directions
+ * back out.  Rigid transforms preserve distance, so hit distances
+ * need no correction.
+ *
+ * Instances have an st_id of ID_NULL and st_meth pointing at
+ * _rt_instance_functab; code that dispatches on a soltab must go
+ * through st_meth rather than OBJ[st_id].
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "vmath.h"
+#include "bn/mat.h"
+#include "raytrace.h"
+#include "librt_private.h"
+
+
+struct instance_specific {
+    struct soltab *proto;	/**< @brief  soltab that holds the prep */
+    mat_t to_proto;		/**< @brief  this placement to prototype's */
+    mat_t from_proto;		/**< @brief  prototype's placement to this */
+};
+
+
+/**
+ * True if 'm' only rotates (possibly mirrors) and translates.
+ */
+static int
+instance_is_rigid(const mat_t m, const struct bn_tol *tol)
+{
+    vect_t c[3];
+    int i;
+
+    if (!ZERO(m[12]) || !ZERO(m[13]) || !ZERO(m[14]) || !NEAR_EQUAL(m[15], 1.0, SMALL_FASTF))
+	return 0;
+
+    for (i = 0; i < 3; i++)
+	VSET(c[i], m[i], m[4+i], m[8+i]);
+
+    for (i = 0; i < 3; i++) {
+	if (!NEAR_EQUAL(MAGSQ(c[i]), 1.0, tol->perp))
+	    return 0;
+	if (!NEAR_ZERO(VDOT(c[i], c[(i+1)%3]), tol->perp))
+	    return 0;
+    }
+    return 1;
+}
+
+
+static int
+instance_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct seg *seghead)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct soltab *proto = isp->proto;
+    struct bu_list *last = seghead->l.back;
+    struct seg *segp;
+    struct xray lray;
+    int ret;
+
+    lray = *rp;		/* struct copy */
+    MAT4X3PNT(lray.r_pt, isp->to_proto, rp->r_pt);
+    MAT4X3VEC(lray.r_dir, isp->to_proto, rp->r_dir);
+
+    ret = proto->st_meth->ft_shot(proto, &lray, ap, seghead);
+
+    /* claim the new segments for this placement */
+    for (segp = BU_LIST_NEXT(seg, last); BU_LIST_NOT_HEAD(segp, &seghead->l); segp = BU_LIST_PNEXT(seg, segp))
+	segp->seg_stp = stp;
+
+    return ret;
+}
+
+
+static void
+instance_norm(struct hit *hitp, struct soltab *stp, struct xray *rp)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct soltab *proto = isp->proto;
+    struct xray *rayp = hitp->hit_rayp;
+    struct xray lray;
+    point_t pt;
+    vect_t n;
+
+    if (!proto->st_meth->ft_norm)
+	return;
+
+    lray = *rp;		/* struct copy */
+    MAT4X3PNT(lray.r_pt, isp->to_proto, rp->r_pt);
+    MAT4X3VEC(lray.r_dir, isp->to_proto, rp->r_dir);
+
+    /* some norm routines expect the shot to have left the point */
+    VJOIN1(hitp->hit_point, lray.r_pt, hitp->hit_dist, lray.r_dir);
+    hitp->hit_rayp = &lray;
+
+    proto->st_meth->ft_norm(hitp, proto, &lray);
+
+    hitp->hit_rayp = rayp;
+    MAT4X3PNT(pt, isp->from_proto, hitp->hit_point);
+    MAT4X3VEC(n, isp->from_proto, hitp->hit_normal);
+    VMOVE(hitp->hit_point, pt);
+    VMOVE(hitp->hit_normal, n);
+}
+
+
+static void
+instance_curve(struct curvature *cvp, struct hit *hitp, struct soltab *stp)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct soltab *proto = isp->proto;
+    point_t pt;
+    vect_t n, dir;
+
+    if (!proto->st_meth->ft_curve)
+	return;
+
+    VMOVE(pt, hitp->hit_point);
+    VMOVE(n, hitp->hit_normal);
+    MAT4X3PNT(hitp->hit_point, isp->to_proto, pt);
+    MAT4X3VEC(hitp->hit_normal, isp->to_proto, n);
+
+    proto->st_meth->ft_curve(cvp, hitp, proto);
+
+    VMOVE(hitp->hit_point, pt);
+    VMOVE(hitp->hit_normal, n);
+    MAT4X3VEC(dir, isp->from_proto, cvp->crv_pdir);
+    VMOVE(cvp->crv_pdir, dir);
+}
+
+
+static void
+instance_uv(struct application *ap, struct soltab *stp, struct hit *hitp, struct uvcoord *uvp)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct soltab *proto = isp->proto;
+    point_t pt;
+    vect_t n;
+
+    if (!proto->st_meth->ft_uv)
+	return;
+
+    VMOVE(pt, hitp->hit_point);
+    VMOVE(n, hitp->hit_normal);
+    MAT4X3PNT(hitp->hit_point, isp->to_proto, pt);
+    MAT4X3VEC(hitp->hit_normal, isp->to_proto, n);
+
+    proto->st_meth->ft_uv(ap, proto, hitp, uvp);
+
+    VMOVE(hitp->hit_point, pt);
+    VMOVE(hitp->hit_normal, n);
+}
+
+
+static void
+instance_print(const struct soltab *stp)
+{
+    const struct instance_specific *isp = (const struct instance_specific *)stp->st_specific;
+
+    if (!isp)
+	return;
+
+    bu_log("instance of %s (bit %ld)\n", isp->proto->st_dp->d_namep, isp->proto->st_bit);
+    bn_mat_print("to prototype", isp->to_proto);
+}
+
+
+static void
+instance_free(struct soltab *stp)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+
+    if (!isp)
+	return;
+
+    rt_free_soltab(isp->proto);
+    BU_PUT(isp, struct instance_specific);
+    stp->st_specific = NULL;
+}
+
+
+const struct rt_functab _rt_instance_functab = {
+    .magic = RT_FUNCTAB_MAGIC,
+    .ft_name = "ID_INSTANCE",
+    .ft_label = "instance",
+    .ft_use_rpp = 0,
+    .ft_shot = instance_shot,
+    .ft_print = instance_print,
+    .ft_norm = instance_norm,
+    .ft_uv = instance_uv,
+    .ft_curve = instance_curve,
+    .ft_free = instance_free
+};
+
+
+int
+_rt_instance_init(struct soltab *stp, struct soltab *proto)
+{
+    struct instance_specific *isp;
+    mat_t inv;
+
+    RT_CK_SOLTAB(stp);
+    RT_CK_SOLTAB(proto);
+
+    BU_GET(isp, struct instance_specific);
+
+    /* a null st_matp is the identity */
+    if (stp->st_matp) {
+	if (!bn_mat_inverse(inv, stp->st_matp)) {
+	    BU_PUT(isp, struct instance_specific);
+	    return 0;
+	}
+	if (proto->st_matp)
+	    bn_mat_mul(isp->to_proto, proto->st_matp, inv);
+	else
+	    MAT_COPY(isp->to_proto, inv);
+    } else if (proto->st_matp) {
+	MAT_COPY(isp->to_proto, proto->st_matp);
+    } else {
+	MAT_IDN(isp->to_proto);
+    }
+
+    if (!instance_is_rigid(isp->to_proto, &stp->st_rtip->rti_tol)
+	|| !bn_mat_inverse(isp->from_proto, isp->to_proto)) {
+	BU_PUT(isp, struct instance_specific);
+	return 0;
+    }
+
+    isp->proto = proto;
+    proto->st_uses++;
+
+    stp->st_id = ID_NULL;
+    stp->st_meth = &_rt_instance_functab;
+    stp->st_specific = (void *)isp;
+
+    return 1;
+}
+
+
+void
+_rt_instance_finish(struct soltab *stp)
+{
+    struct instance_specific *isp = (struct instance_specific *)stp->st_specific;
+    struct soltab *proto = isp->proto;
+    point_t corner, pt;
+    int i;
+
+    if (proto->st_aradius <= 0) {
+	/* the prototype failed to prep, so this placement is dead too */
+	rt_free_soltab(proto);
+	BU_PUT(isp, struct instance_specific);
+	stp->st_specific = NULL;
+	stp->st_aradius = -1;
+	return;
+    }
+
+    stp->st_aradius = proto->st_aradius;
+    stp->st_bradius = proto->st_bradius;
+    MAT4X3PNT(stp->st_center, isp->from_proto, proto->st_center);
+
+    if (proto->st_aradius >= INFINITY || !isfinite(proto->st_min[X]) || !isfinite(proto->st_max[X])
+	|| !isfinite(proto->st_min[Y]) || !isfinite(proto->st_max[Y])
+	|| !isfinite(proto->st_min[Z]) || !isfinite(proto->st_max[Z])) {
+	VMOVE(stp->st_min, proto->st_min);
+	VMOVE(stp->st_max, proto->st_max);
+	return;
+    }
+
+    VSETALL(stp->st_max, -INFINITY);
+    VSETALL(stp->st_min,  INFINITY);
+    for (i = 0; i < 8; i++) {
+	VSET(corner,
+	     (i & 1) ? proto->st_max[X] : proto->st_min[X],
+	     (i & 2) ? proto->st_max[Y] : proto->st_min[Y],
+	     (i & 4) ? proto->st_max[Z] : proto->st_min[Z]);
+	MAT4X3PNT(pt, isp->from_proto, corner);
+	VMINMAX(stp->st_min, stp->st_max, pt);
+    }
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -110,7 +110,44 @@ extern const union cutter *rt_advance_to_next_cell(struct rt_shootray_status *ss
  * used by rt_shootray_bundle()
  * FIXME: non-public API shouldn't be using rt_ prefix
  */
-extern void rt_plot_cell(const union cutter *cutp, struct rt_shootray_status *ssp, struct bu_list *waiting_segs_hd, struct rt_i *rtip);
+extern void rt_plot_cell(const union cutter *cutp, const struct rt_shootray_status *ssp, struct bu_list *waiting_segs_hd, struct rt_i *rtip);
+
+/**
+ * Number of copies of the read-mostly prep data to make, 0 unless
+ * LIBRT_NUMA_REPLICATE is set.  A number forces that many copies,
+ * any other value gives one per NUMA node when there is more than
+ * one.
+ */
+extern int rt_numa_replicas(void);
+
+/**
+ * Which of 'replicas' copies the calling thread should use, one made
+ * on its own NUMA node when there is one.
+ */
+extern int rt_numa_replica(int replicas);
+
+/**
+ * Replace the copies of the cut tree with fresh ones and copy any
+ * BoT that has none yet, once after prep, or just release the cut
+ * tree copies when replication is off.  Anything changing
+ * rti_CutHead after prep must release the copies first.
+ */
+extern void rt_numa_replicate(struct rt_i *rtip);
+extern void rt_cut_replicas_free(struct rt_i *rtip);
+
+/**
+ * Size a BoT's table of copies for rt_numa_replicate(), and fill in
+ * one entry from the thread that should own its memory.
+ */
+extern void rt_bot_replicas(struct soltab *stp, int replicas);
+extern void rt_bot_replicate(struct soltab *stp, int replica);
+
+/**
+ * The cut tree a ray fired from the calling thread starts from, the
+ * copy local to the thread's NUMA node when there is one.
+ */
+#define RT_CUT_HEAD(_rtip) \
+    ((_rtip)->rti_numa_cut ? (const union cutter *)(_rtip)->rti_numa_cut[rt_numa_replica((_rtip)->rti_numa_nodes)] : (const union cutter *)&(_rtip)->rti_CutHead)
 
 /* db_fullpath.c */
 
@@ -227,6 +264,30 @@ extern void plot_ellipse(
 extern int _rt_tcl_list_to_int_array(const char *list, int **array, int *array_len);
 extern int _rt_tcl_list_to_fastf_array(const char *list, fastf_t **array, int *array_len);
 
+/* instance.c */
+
+/**
+ * Methods for a soltab that shares the prep of another placement of
+ * the same solid.
+ */
+extern const struct rt_functab _rt_instance_functab;
+
+/**
+ * Make the new soltab 'stp' an instance of 'proto' if the two
+ * placements differ only by a rigid motion.  Must be called while
+ * holding the tree semaphore for the solid.
+ *
+ * @return 1 if stp is now an instance
+ * @return 0 if stp has to be prepped on its own
+ */
+extern int _rt_instance_init(struct soltab *stp, struct soltab *proto);
+
+/**
+ * Fill in the bounds of an instance once its prototype is prepped,
+ * or mark it dead if the prototype failed to prep.
+ */
+extern void _rt_instance_finish(struct soltab *stp);
+
 /* view.c */
 extern fastf_t solid_point_spacing(const struct bview *gvp, fastf_t solid_width);
 extern fastf_t view_avg_sample_spacing(const struct bview *gvp);
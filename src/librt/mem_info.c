@@ -0,0 +1,208 @@
+/*                      M E M _ I N F O . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file librt/mem_info.c
+ *
+ * Reporting on the memory held by a prepped model.
+ *
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "bu/malloc.h"
+#include "bu/sort.h"
+#include "bu/units.h"
+#include "vmath.h"
+#include "raytrace.h"
+
+
+static size_t
+mem_resource(const struct rt_i *rtip, const struct resource *resp)
+{
+    size_t bytes = 0;
+
+    if (resp->re_magic != RESOURCE_MAGIC)
+	return 0;
+
+    bytes += (size_t)resp->re_seglen * sizeof(struct seg);
+    bytes += (size_t)resp->re_partlen * sizeof(struct partition);
+    bytes += (size_t)resp->re_boolslen * sizeof(union tree *);
+    bytes += (size_t)resp->re_tree_malloc * sizeof(union tree);
+    if (resp->re_pieces)
+	bytes += rtip->rti_nsolids_with_pieces * sizeof(struct rt_piecestate);
+
+    return bytes;
+}
+
+
+static size_t
+mem_tree(const union tree *tp)
+{
+    if (!tp)
+	return 0;
+
+    switch (tp->tr_op) {
+	case OP_SOLID:
+	    return (tp->tr_a.tu_stp) ? tp->tr_a.tu_stp->st_prep_bytes : 0;
+	case OP_UNION:
+	case OP_INTERSECT:
+	case OP_SUBTRACT:
+	case OP_XOR:
+	    return mem_tree(tp->tr_b.tb_left) + mem_tree(tp->tr_b.tb_right);
+	case OP_NOT:
+	case OP_GUARD:
+	case OP_XNOP:
+	    return mem_tree(tp->tr_b.tb_left);
+	default:
+	    return 0;
+    }
+}
+
+
+void
+rt_mem_info(struct rt_mem_info *info, const struct rt_i *rtip)
+{
+    struct soltab *stp;
+    size_t i;
+
+    RT_CK_RTI(rtip);
+
+    memset(info, 0, sizeof(struct rt_mem_info));
+
+    RT_VISIT_ALL_SOLTABS_START(stp, (struct rt_i *)rtip) {
+	if (stp->st_id < 0 || stp->st_id > ID_MAX_SOLID)
+	    continue;
+	info->prep_bytes[stp->st_id] += stp->st_prep_bytes;
+	info->prep_count[stp->st_id]++;
+	info->prep_total += stp->st_prep_bytes;
+    } RT_VISIT_ALL_SOLTABS_END;
+
+    info->cut_bytes = rtip->rti_cut_bytes;
+
+    for (i = 0; i < BU_PTBL_LEN(&rtip->rti_resources); i++) {
+	const struct resource *resp = (const struct resource *)BU_PTBL_GET(&rtip->rti_resources, i);
+	if (resp)
+	    info->resource_bytes += mem_resource(rtip, resp);
+    }
+
+    info->total = info->prep_total + info->cut_bytes + info->resource_bytes;
+}
+
+
+size_t
+rt_region_mem(const struct region *regp)
+{
+    RT_CK_REGION(regp);
+    return mem_tree(regp->reg_treetop);
+}
+
+
+struct mem_region {
+    const struct region *regp;
+    size_t bytes;
+};
+
+
+static int
+mem_region_cmp(const void *a, const void *b, void *UNUSED(arg))
+{
+    const struct mem_region *ra = (const struct mem_region *)a;
+    const struct mem_region *rb = (const struct mem_region *)b;
+
+    if (ra->bytes > rb->bytes)
+	return -1;
+    if (ra->bytes < rb->bytes)
+	return 1;
+    return 0;
+}
+
+
+static const char *
+mem_human(char *buf, size_t len, size_t bytes)
+{
+    if (bu_humanize_number(buf, len, (int64_t)bytes, "B", BU_HN_AUTOSCALE, BU_HN_B | BU_HN_NOSPACE | BU_HN_DECIMAL) < 0)
+	snprintf(buf, len, "%zu", bytes);
+    return buf;
+}
+
+
+void
+rt_pr_mem_info(const struct rt_i *rtip, size_t nregions)
+{
+    struct rt_mem_info info;
+    char b1[16], b2[16], b3[16], b4[16];
+    int id;
+
+    RT_CK_RTI(rtip);
+
+    rt_mem_info(&info, rtip);
+
+    bu_log("Memory: %s prep, %s space partitioning, %s resources, %s total\n",
+	   mem_human(b1, sizeof(b1), info.prep_total),
+	   mem_human(b2, sizeof(b2), info.cut_bytes),
+	   mem_human(b3, sizeof(b3), info.resource_bytes),
+	   mem_human(b4, sizeof(b4), info.total));
+    if (rtip->rti_mem_budget)
+	bu_log("Memory budget: %s\n", mem_human(b1, sizeof(b1), rtip->rti_mem_budget));
+
+    for (id = 0; id <= ID_MAX_SOLID; id++) {
+	if (!info.prep_count[id])
+	    continue;
+	bu_log("%10s %6zu %s\n",
+	       mem_human(b1, sizeof(b1), info.prep_bytes[id]),
+	       info.prep_count[id],
+	       (id == ID_NULL) ? "shared preps" : OBJ[id].ft_label);
+    }
+
+    if (nregions > 0 && rtip->nregions > 0) {
+	struct mem_region *regs;
+	struct region *regp;
+	size_t i, n = 0;
+
+	regs = (struct mem_region *)bu_calloc(rtip->nregions, sizeof(struct mem_region), "mem_region");
+	for (BU_LIST_FOR(regp, region, &rtip->HeadRegion)) {
+	    if (n >= rtip->nregions)
+		break;
+	    regs[n].regp = regp;
+	    regs[n].bytes = rt_region_mem(regp);
+	    n++;
+	}
+	bu_sort(regs, n, sizeof(struct mem_region), mem_region_cmp, NULL);
+
+	if (nregions > n)
+	    nregions = n;
+	for (i = 0; i < nregions && regs[i].bytes; i++)
+	    bu_log("%10s %s\n", mem_human(b1, sizeof(b1), regs[i].bytes), regs[i].regp->reg_name);
+
+	bu_free(regs, "mem_region");
+    }
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -40,22 +40,24 @@ void
 rt_pr_soltab(register const struct soltab *stp)
 {
     register int id = stp->st_id;
+    const struct rt_functab *ft;
 
-    if (id <= 0 || id > ID_MAX_SOLID) {
+    if (id < 0 || id > ID_MAX_SOLID || (id == 0 && !stp->st_meth)) {
 	bu_log("stp=%p, id=%d.\n", (void *)stp, id);
 	bu_bomb("rt_pr_soltab:  bad id");
     }
+    ft = (stp->st_meth) ? stp->st_meth : &OBJ[id];
     bu_log("------------ %s (bit %ld) %s ------------\n",
 	   stp->st_dp->d_namep, stp->st_bit,
-	   OBJ[id].ft_name);
+	   ft->ft_name);
     VPRINT("Bound Sph CENTER", stp->st_center);
     bu_log("Approx Sph Radius = %g\n", INTCLAMP(stp->st_aradius));
     bu_log("Bounding Sph Radius = %g\n", INTCLAMP(stp->st_bradius));
     VPRINT("Bound RPP min", stp->st_min);
     VPRINT("Bound RPP max", stp->st_max);
     bu_pr_ptbl("st_regions", &stp->st_regions, 1);
-    if (OBJ[id].ft_print)
-	OBJ[id].ft_print(stp);
+    if (ft->ft_print)
+	ft->ft_print(stp);
 }
 
 
@@ -136,13 +138,13 @@ rt_pr_partition_vls(struct bu_vls *v, const struct rt_i *rtip, register const st
     stp = pp->pt_inseg->seg_stp;
     bu_vls_printf(v, "%s (%s#%ld) ",
 		  stp->st_dp->d_namep,
-		  OBJ[stp->st_id].ft_name+3,
+		  stp->st_meth->ft_name+3,
 		  stp->st_bit);
 
     stp = pp->pt_outseg->seg_stp;
     bu_vls_printf(v, "%s (%s#%ld) ",
 		  stp->st_dp->d_namep,
-		  OBJ[stp->st_id].ft_name+3,
+		  stp->st_meth->ft_name+3,
 		  stp->st_bit);
 
     bu_vls_printf(v, "(%g, %g)",
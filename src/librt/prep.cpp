@@ -39,10 +39,12 @@
 
 
 #include "bu/parallel.h"
+#include "bu/units.h"
 #include "vmath.h"
 #include "bn.h"
 #include "raytrace.h"
 #include "bv/plot3.h"
+#include "librt_private.h"
 
 #include "optical.h"
 #include "optical/plastic.h"
@@ -121,6 +123,24 @@ rt_new_rti(struct db_i *dbip)
      */
     rtip->rti_space_partition = RT_PART_NUBSPT;
 
+    /* Sharing prep between placements of a solid trades a matrix
+     * multiply per ray for prep time and memory, so it is opt-in.
+     */
+    {
+	const char *instance_prep = getenv("LIBRT_INSTANCE_PREP");
+	rtip->rti_instance_prep = (instance_prep && bu_str_true(instance_prep)) ? 1 : 0;
+    }
+
+    /* Render farm nodes can set a memory budget for prep without
+     * touching every application, e.g. LIBRT_MEM_BUDGET=8G
+     */
+    {
+	const char *budget = getenv("LIBRT_MEM_BUDGET");
+	int64_t bytes = 0;
+	if (budget && bu_dehumanize_number(budget, &bytes) == 0 && bytes > 0)
+	    rtip->rti_mem_budget = (size_t)bytes;
+    }
+
     /*
      * Zero the solid instancing counters in dbip database instance.
      * Done here because the same dbip could be used by multiple
@@ -396,7 +416,24 @@ rt_prep_parallel(struct rt_i *rtip, int ncpu)
      * Multiple CPUs can be used here.
      */
     for (i=1; i<=CUT_MAXIMUM; i++) rtip->rti_ncut_by_type[i] = 0;
-    rt_cut_it(rtip, ncpu);
+
+    /* With less than a quarter of the memory budget left after prep,
+     * settle for a shallow cut tree.  Rays get slower, but the prep
+     * completes.
+     */
+    if (rtip->rti_mem_budget && !rtip->rti_hasty_prep &&
+	rtip->rti_prep_bytes > rtip->rti_mem_budget - rtip->rti_mem_budget/4) {
+	bu_log("rt_prep_parallel(): prep holds %zu of %zu budgeted bytes, limiting space partitioning\n",
+	       rtip->rti_prep_bytes, rtip->rti_mem_budget);
+	rtip->rti_hasty_prep = 1;
+    }
+
+    {
+	ssize_t cut_bytes = bu_malloc_bytes(-1);
+	rt_cut_it(rtip, ncpu);
+	cut_bytes = bu_malloc_bytes(-1) - cut_bytes;
+	rtip->rti_cut_bytes = (cut_bytes > 0) ? (size_t)cut_bytes : 0;
+    }
 
     /* Release storage used for bounding RPPs of solid "pieces" */
     RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
@@ -429,6 +466,10 @@ rt_prep_parallel(struct rt_i *rtip, int ncpu)
 	    (void)fclose(plotfp);
 	}
     }
+
+    /* copies of the finished cut tree and BoTs, for NUMA nodes */
+    rt_numa_replicate(rtip);
+
     rtip->needprep = 0;		/* prep is done */
     bu_semaphore_release(RT_SEM_RESULTS);	/* end critical section */
 
@@ -1152,6 +1193,26 @@ rt_clean(struct rt_i *rtip)
      * Clear out the solid table, AFTER doing the region table.  Can't
      * use RT_VISIT_ALL_SOLTABS_START here
      */
+    /* Instances hold a use of their prototype, so they go first.
+     * Freeing one can also free its prototype, which may be the next
+     * soltab on the list, so they are gathered before any is freed.
+     * Prototypes are never instances themselves, so the gathered
+     * pointers all stay valid.
+     */
+    {
+	struct bu_ptbl instances = BU_PTBL_INIT_ZERO;
+
+	head = &(rtip->rti_solidheads[0]);
+	for (; head < &(rtip->rti_solidheads[RT_DBNHASH]); head++) {
+	    for (BU_LIST_FOR(stp, soltab, head)) {
+		if (stp->st_meth == &_rt_instance_functab)
+		    bu_ptbl_ins(&instances, (long *)stp);
+	    }
+	}
+	for (i = 0; i < (int)BU_PTBL_LEN(&instances); i++)
+	    rt_free_soltab((struct soltab *)BU_PTBL_GET(&instances, i));
+	bu_ptbl_free(&instances);
+    }
     head = &(rtip->rti_solidheads[0]);
     for (; head < &(rtip->rti_solidheads[RT_DBNHASH]); head++) {
 	while (BU_LIST_WHILE(stp, soltab, head)) {
@@ -1160,6 +1221,8 @@ rt_clean(struct rt_i *rtip)
 	}
     }
     rtip->nsolids = 0;
+    rtip->rti_prep_bytes = 0;
+    rtip->rti_mem_dropped = 0;
 
     /* Clean out the array of pointers to regions, if any */
     if (rtip->Regions) {
@@ -1167,12 +1230,14 @@ rt_clean(struct rt_i *rtip)
 	rtip->Regions = (struct region **)0;
 
 	/* Free space partitions */
+	rt_cut_replicas_free(rtip);
 	rt_fr_cut(rtip, &(rtip->rti_CutHead));
 	memset((char *)&(rtip->rti_CutHead), 0, sizeof(union cutter));
 	rt_fr_cut(rtip, &(rtip->rti_inf_box));
 	memset((char *)&(rtip->rti_inf_box), 0, sizeof(union cutter));
     }
     rt_cut_clean(rtip);
+    rtip->rti_cut_bytes = 0;
 
     /* Free animation structures */
     /* XXX modify to only free those from this rtip */
@@ -1755,6 +1820,9 @@ rt_unprep(struct rt_i *rtip, struct rt_reprep_obj_list *objs, struct resource *r
     struct db_full_path *path;
     size_t i, j, k;
 
+    /* the cut tree is about to change under the copies */
+    rt_cut_replicas_free(rtip);
+
     rt_res_pieces_clean(resp, rtip);
 
     /* find all paths from top objects to objects being unprepped */
@@ -1967,6 +2035,8 @@ rt_reprep(struct rt_i *rtip, struct rt_reprep_obj_list *objs, struct resource *r
     VMOVE(old_min, rtip->mdl_min);
     VMOVE(old_max, rtip->mdl_max);
 
+    rt_cut_replicas_free(rtip);
+
     rtip->needprep = 1;
 
     argv = (char **)bu_calloc(BU_PTBL_LEN(&(objs->paths)), sizeof(char *), "argv");
@@ -2054,6 +2124,8 @@ rt_reprep(struct rt_i *rtip, struct rt_reprep_obj_list *objs, struct resource *r
 	fill_out_bsp(rtip, &rtip->rti_CutHead, resp, bb);
     }
 
+    rt_numa_replicate(rtip);
+
     if (BU_PTBL_LEN(&rtip->rti_resources)) {
 	for (i=0; i<BU_PTBL_LEN(&rtip->rti_resources); i++) {
 	    struct resource *re;
@@ -371,8 +371,109 @@ struct spatial_partition_s {
 				through triangle_s */
     hit_da *hit_arrays_per_cpu;
     size_t num_cpus;
+    long num_nodes;
+    size_t num_tris;
+    /* numa_nodes copies of root, tris and vertex_normals, made by
+     * rt_numa_replicate() after prep, NULL unless
+     * LIBRT_NUMA_REPLICATE is set */
+    int numa_nodes;
+    struct bvh_flat_node **numa_root;
+    triangle_s **numa_tris;
+    fastf_t **numa_normals;
 };
 
+
+static void
+bot_replicas_free(struct spatial_partition_s *sps)
+{
+    int i;
+
+    if (!sps->numa_root)
+	return;
+
+    for (i = 0; i < sps->numa_nodes; i++) {
+	if (sps->numa_root[i])
+	    bu_free(sps->numa_root[i], "numa bot bvh flat nodes");
+	if (sps->numa_tris[i])
+	    bu_free(sps->numa_tris[i], "numa bot triangles");
+	if (sps->numa_normals[i])
+	    bu_free(sps->numa_normals[i], "numa bot norms");
+    }
+    bu_free(sps->numa_root, "numa bot bvh");
+    bu_free(sps->numa_tris, "numa bot tris");
+    bu_free(sps->numa_normals, "numa bot normals");
+    sps->numa_root = NULL;
+    sps->numa_tris = NULL;
+    sps->numa_normals = NULL;
+    sps->numa_nodes = 0;
+}
+
+
+void
+rt_bot_replicas(struct soltab *stp, int replicas)
+{
+    struct bot_specific *bot = (struct bot_specific *)stp->st_specific;
+    struct spatial_partition_s *sps;
+
+    if (!bot || !bot->tie)
+	return;
+    sps = (struct spatial_partition_s *)bot->tie;
+
+    /* copies made by an earlier prep are kept by a reprep */
+    if (sps->numa_nodes == replicas)
+	return;
+
+    bot_replicas_free(sps);
+    if (replicas <= 0)
+	return;
+
+    sps->numa_root = (struct bvh_flat_node **)bu_calloc(replicas, sizeof(struct bvh_flat_node *), "numa bot bvh");
+    sps->numa_tris = (triangle_s **)bu_calloc(replicas, sizeof(triangle_s *), "numa bot tris");
+    sps->numa_normals = (fastf_t **)bu_calloc(replicas, sizeof(fastf_t *), "numa bot normals");
+    sps->numa_nodes = replicas;
+}
+
+
+void
+rt_bot_replicate(struct soltab *stp, int replica)
+{
+    struct bot_specific *bot = (struct bot_specific *)stp->st_specific;
+    struct spatial_partition_s *sps;
+    struct bvh_flat_node *root;
+    triangle_s *tris;
+    fastf_t *norms = NULL;
+    long i;
+
+    if (!bot || !bot->tie)
+	return;
+    sps = (struct spatial_partition_s *)bot->tie;
+    if (replica < 0 || replica >= sps->numa_nodes || sps->numa_root[replica])
+	return;
+
+    root = (struct bvh_flat_node *)bu_malloc(sps->num_nodes * sizeof(struct bvh_flat_node), "numa bot bvh flat nodes");
+    memcpy(root, sps->root, sps->num_nodes * sizeof(struct bvh_flat_node));
+    for (i = 0; i < sps->num_nodes; i++) {
+	if (root[i].n_primitives == 0)
+	    root[i].data.other_child = root + (sps->root[i].data.other_child - sps->root);
+    }
+
+    if (sps->vertex_normals) {
+	norms = (fastf_t *)bu_malloc(sps->num_tris * 9 * sizeof(fastf_t), "numa bot norms");
+	memcpy(norms, sps->vertex_normals, sps->num_tris * 9 * sizeof(fastf_t));
+    }
+
+    tris = (triangle_s *)bu_malloc(sps->num_tris * sizeof(triangle_s), "numa bot triangles");
+    memcpy(tris, sps->tris, sps->num_tris * sizeof(triangle_s));
+    for (i = 0; i < (long)sps->num_tris; i++) {
+	if (tris[i].norms)
+	    tris[i].norms = norms + (sps->tris[i].norms - sps->vertex_normals);
+    }
+
+    sps->numa_root[replica] = root;
+    sps->numa_tris[replica] = tris;
+    sps->numa_normals[replica] = norms;
+}
+
 /**
  * Given a pointer to a GED database record, and a transformation
  * matrix, determine if this is a valid BOT, and if so, precompute
@@ -534,6 +635,13 @@ rt_bot_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     sps->tris = tris;
     sps->vertex_normals = tri_norms;
     sps->num_cpus = bu_avail_cpus();	// NOTE: this does NOT respect user requested cpu count (ie if -P was used)
+    sps->num_nodes = nodes_created;
+    sps->num_tris = bot_ip->num_faces;
+
+    sps->numa_nodes = 0;
+    sps->numa_root = NULL;
+    sps->numa_tris = NULL;
+    sps->numa_normals = NULL;
 
     /* per-cpu mem allocated MAX_PSW to ensure contention-free */
     sps->hit_arrays_per_cpu = (hit_da *) bu_calloc(MAX_PSW, sizeof(hit_da), "thread-local bot hit arrays");
@@ -709,7 +817,12 @@ rt_bot_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
     hit_da *hits_da = &sps->hit_arrays_per_cpu[thread_ind];
     hits_da->count = 0;
 
-    bot_shot_hlbvh_flat(sps->root, rp, sps->tris, bot->bot_ntri, hits_da);
+    if (sps->numa_root) {
+	int replica = rt_numa_replica(sps->numa_nodes);
+	bot_shot_hlbvh_flat(sps->numa_root[replica], rp, sps->numa_tris[replica], bot->bot_ntri, hits_da);
+    } else {
+	bot_shot_hlbvh_flat(sps->root, rp, sps->tris, bot->bot_ntri, hits_da);
+    }
 
     if (hits_da->count == 0) {
 	return 0;
@@ -866,6 +979,7 @@ rt_bot_free(struct soltab *stp)
 	bu_free(sps->root, "bot bvh flat nodes");
 	bu_free(sps->tris, "bot triangles");
 	bu_free(sps->vertex_normals, "bot normals");
+	bot_replicas_free(sps);
 	if (sps->hit_arrays_per_cpu) {
 	    for (size_t i = 0; i < MAX_PSW; i++) {
 		if (sps->hit_arrays_per_cpu[i].items) {
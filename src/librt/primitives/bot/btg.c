@@ -32,6 +32,7 @@
 
 #include "tie.c"
 #include "tie_kdtree.c"
+#include "tie_cache.c"
 
 int tie_check_degenerate = 0;
 fastf_t TIE_PREC = 0.1;
@@ -32,6 +32,7 @@
 
 #include "tie.c"
 #include "tie_kdtree.c"
+#include "tie_cache.c"
 
 /*
  * Local Variables:
@@ -40,8 +40,18 @@
 extern int isnan(double x);
 #endif
 
+/* The watertight test relies on each product in an edge function
+ * being rounded on its own, so that triangles sharing an edge get
+ * exactly opposite values for it.  Fusing them into multiply-adds
+ * breaks that and lets rays slip between triangles.  GCC ignores the
+ * standard pragma, so btg.c and btgf.c also get -ffp-contract=off.
+ */
+#if defined(__clang__)
+#  pragma STDC FP_CONTRACT OFF
+#elif defined(_MSC_VER)
+#  pragma fp_contract(off)
+#endif
 
-#define TIE_TAB1 "\1\0\0\2\2\1"	/* Triangle Index Table */
 
 #define TIE_DEGENERATE_THRESHOLD 0.0001
 
@@ -117,6 +127,78 @@ TIE_VAL(tri_prep)(struct tie_s *tie)
 }
 
 
+/*
+ * Pack the triangles of every leaf at or below node for tie_work().
+ * raw holds the three vertices of each triangle of tie->tri_list in
+ * order, or is NULL to read them out of the triangles themselves,
+ * which is only possible before tri_prep() has replaced them.
+ */
+static void
+TIE_VAL(tie_pack_node)(struct tie_s *tie, struct tie_kdtree_s *node, const TIE_3 *raw)
+{
+    struct tie_geom_s *geom;
+    unsigned int i, j, k, l;
+
+    if (!node || !node->data)
+	return;
+
+    if (TIE_HAS_CHILDREN(node->b)) {
+	TIE_VAL(tie_pack_node)(tie, &((struct tie_kdtree_s *)node->data)[0], raw);
+	TIE_VAL(tie_pack_node)(tie, &((struct tie_kdtree_s *)node->data)[1], raw);
+	return;
+    }
+
+    geom = (struct tie_geom_s *)node->data;
+    if (geom->pack)
+	bu_free(geom->pack, "pack");
+    geom->pack = NULL;
+    geom->pack_num = (geom->tri_num + TIE_SIMD_WIDTH - 1) / TIE_SIMD_WIDTH;
+    if (!geom->pack_num)
+	return;
+    geom->pack = (struct tie_pack_s *)bu_calloc(geom->pack_num, sizeof(struct tie_pack_s), "pack");
+
+    for (i = 0; i < geom->tri_num; i++) {
+	struct tie_pack_s *p = &geom->pack[i / TIE_SIMD_WIDTH];
+	struct tie_tri_s *tri = geom->tri_list[i];
+	const TIE_3 *vert = raw ? &raw[3 * (tri - tie->tri_list)] : tri->data;
+
+	l = i % TIE_SIMD_WIDTH;
+	p->tri[l] = tri;
+	for (j = 0; j < 3; j++)
+	    for (k = 0; k < 3; k++)
+		p->v[j][k][l] = vert[j].v[k];
+    }
+}
+
+
+#if TIE_PRECISION == 0
+/*
+ * Redo the edge functions of one lane in double precision.  A ray
+ * landing exactly on an edge or vertex in float gets a zero edge
+ * function, and whether the triangles on either side then claim it
+ * depends on rounding; in double the tie is all but always broken.
+ */
+static void
+TIE_VAL(tie_edges_double)(const struct tie_pack_s *p, unsigned int l, const struct tie_ray_s *ray, int kx, int ky, int kz, double e[3], double *tn)
+{
+    double sx = ray->dir[kx] / ray->dir[kz];
+    double sy = ray->dir[ky] / ray->dir[kz];
+    double x[3], y[3], z[3];
+    int j;
+
+    for (j = 0; j < 3; j++) {
+	z[j] = (double)p->v[j][kz][l] - ray->pos[kz];
+	x[j] = (double)p->v[j][kx][l] - ray->pos[kx] - sx * z[j];
+	y[j] = (double)p->v[j][ky][l] - ray->pos[ky] - sy * z[j];
+    }
+    e[0] = x[2]*y[1] - y[2]*x[1];
+    e[1] = x[0]*y[2] - y[0]*x[2];
+    e[2] = x[1]*y[0] - y[1]*x[0];
+    *tn = (e[0]*z[0] + e[1]*z[1] + e[2]*z[2]) / ray->dir[kz];
+}
+#endif
+
+
 /*************************************************************
  **************** EXPORTED FUNCTIONS *************************
  *************************************************************/
@@ -182,6 +264,9 @@ TIE_VAL(tie_prep)(struct tie_s *tie)
     /* Build the kd-tree */
     TIE_KDTREE_PREP(tie);
 
+    /* Pack the leaves while the triangles still hold their vertices */
+    TIE_VAL(tie_pack_node)(tie, tie->kdtree, NULL);
+
     /* Prep all the triangles */
     TIE_VAL(tri_prep)(tie);
 }
@@ -221,10 +306,10 @@ TIE_VAL(tie_work)(struct tie_s *tie, struct tie_ray_s *ray, struct tie_id_s *id,
     struct tie_tri_s *hit_list[256], *tri;
     struct tie_geom_s *data;
     struct tie_kdtree_s *node, *temp[2];
-    TFLOAT near, far, dirinv[3], dist;
+    TFLOAT near, far, dirinv[3], dist, org[3], shear[3], tmin, tmax;
     unsigned int i, n;
     uint8_t hit_count;
-    int ab[3], split, stack_ind;
+    int ab[3], split, stack_ind, kx, ky, kz;
     void *result;
 
     if (!tie->kdtree)
@@ -244,6 +329,31 @@ TIE_VAL(tie_work)(struct tie_s *tie, struct tie_ray_s *ray, struct tie_id_s *id,
 	ab[i] = dirinv[i] < 0.0 ? 1.0 : 0.0;
     }
 
+    /*
+     * Set up the watertight triangle test (Woop, Benthin and Wald,
+     * JCGT 2013): the triangles are sheared into a space where the
+     * ray runs down +kz from the origin, so whether it passes inside
+     * an edge depends only on the edge and not on the triangle it
+     * belongs to.  kx and ky swap for rays running down -kz to keep
+     * the winding.
+     */
+    kz = 0;
+    if (fabs(ray->dir[1]) > fabs(ray->dir[kz]))
+	kz = 1;
+    if (fabs(ray->dir[2]) > fabs(ray->dir[kz]))
+	kz = 2;
+    kx = (kz + 1) % 3;
+    ky = (kx + 1) % 3;
+    if (ray->dir[kz] < 0.0) {
+	int swap = kx;
+	kx = ky;
+	ky = swap;
+    }
+    shear[0] = ray->dir[kx] / ray->dir[kz];
+    shear[1] = ray->dir[ky] / ray->dir[kz];
+    shear[2] = 1.0 / ray->dir[kz];
+    VMOVE(org, ray->pos);
+
     /* Extracting value of splitting plane from the kdtree */
     split = tie->kdtree->b & (uint32_t)0x3L;
 
@@ -314,79 +424,111 @@ TIE_VAL(tie_work)(struct tie_s *tie, struct tie_ray_s *ray, struct tie_id_s *id,
 
 	hit_count = 0;
 	data = (struct tie_geom_s *)(node->data);
-
-	for (i = 0; i < data->tri_num; i++) {
-	    /*
-	     * Triangle Intersection Code
-	     */
-	    TFLOAT u0, v0, *v;
-	    int i1, i2;
-
-	    tri = data->tri_list[i];
-	    u0 = VDOT(tri->data[1].v,  ray->pos);
-	    v0 = VDOT(tri->data[1].v,  ray->dir);
-
-	    /* skip rays that are practically perpendicular so we
-	     * don't try to divide by zero and propagate NaN (or
-	     * crash).
-	     */
-	    if (ZERO(v0))
-		continue;
-
-	    t.dist = -(tri->data[2].v[0] + u0) / v0;
-
-	    if (isnan(t.dist))
-		continue;
+	tmin = near - TIE_PREC;
+	tmax = far + TIE_PREC;
+
+	for (i = 0; i < data->pack_num; i++) {
+	    const struct tie_pack_s *p = &data->pack[i];
+	    TFLOAT e0[TIE_SIMD_WIDTH], e1[TIE_SIMD_WIDTH], e2[TIE_SIMD_WIDTH];
+	    TFLOAT tn[TIE_SIMD_WIDTH], td[TIE_SIMD_WIDTH];
+	    tie_lane_t ok[TIE_SIMD_WIDTH];
+#if TIE_PRECISION == 0
+	    tie_lane_t edge[TIE_SIMD_WIDTH];
+#endif
+	    unsigned int l;
 
 	    /*
-	     * Intersection point on triangle must lie within the
-	     * kdtree node or it is rejected Apply TIE_PREC to near
-	     * and far such that triangles that lie on orthogonal
-	     * planes aren't in a precision fuzz boundary, thus
-	     * missing something they should actually have hit.
+	     * Test every lane at once.  This loop has no branches so
+	     * that the compiler can turn it into SIMD instructions.
+	     * A ray in the plane of a triangle, and the degenerate
+	     * triangle at the origin in unused lanes, get a NaN or
+	     * infinite distance and fail the range test.
 	     */
-	    if (t.dist < near-TIE_PREC || t.dist > far+TIE_PREC)
-		continue;
-
-	    /* Compute Intersection Point (P = O + Dt) */
-	    VSCALE(t.pos,  ray->dir,  t.dist);
-	    VADD2(t.pos,  ray->pos,  t.pos);
-
-	    /* Extract i1 and i2 indices from the 'b' field */
-	    v = tri->v;
-
-	    i1 = TIE_TAB1[tri->b & (uint32_t)0x7L];
-	    i2 = TIE_TAB1[3 + (tri->b & (uint32_t)0x7L)];
+	    for (l = 0; l < TIE_SIMD_WIDTH; l++) {
+		TFLOAT az = p->v[0][kz][l] - org[kz];
+		TFLOAT bz = p->v[1][kz][l] - org[kz];
+		TFLOAT cz = p->v[2][kz][l] - org[kz];
+		TFLOAT ax = p->v[0][kx][l] - org[kx] - shear[0] * az;
+		TFLOAT ay = p->v[0][ky][l] - org[ky] - shear[1] * az;
+		TFLOAT bx = p->v[1][kx][l] - org[kx] - shear[0] * bz;
+		TFLOAT by = p->v[1][ky][l] - org[ky] - shear[1] * bz;
+		TFLOAT cx = p->v[2][kx][l] - org[kx] - shear[0] * cz;
+		TFLOAT cy = p->v[2][ky][l] - org[ky] - shear[1] * cz;
+		TFLOAT lo, hi;
+
+		e0[l] = cx*by - cy*bx;
+		e1[l] = ax*cy - ay*cx;
+		e2[l] = bx*ay - by*ax;
+		td[l] = e0[l] + e1[l] + e2[l];
+		tn[l] = shear[2] * (e0[l]*az + e1[l]*bz + e2[l]*cz) / td[l];
+
+		lo = e0[l] < e1[l] ? e0[l] : e1[l];
+		lo = lo < e2[l] ? lo : e2[l];
+		hi = e0[l] > e1[l] ? e0[l] : e1[l];
+		hi = hi > e2[l] ? hi : e2[l];
+
+		/*
+		 * The ray must be on the inside of all three edges, and
+		 * the hit must lie within the kdtree node.  Apply
+		 * TIE_PREC to near and far such that triangles that lie
+		 * on orthogonal planes aren't in a precision fuzz
+		 * boundary, thus missing something they should actually
+		 * have hit.
+		 */
+		ok[l] = ((lo >= 0) | (hi <= 0)) & (tn[l] >= tmin) & (tn[l] <= tmax);
+#if TIE_PRECISION == 0
+		/* on an edge in float, see below */
+		edge[l] = (e0[l] == 0) | (e1[l] == 0) | (e2[l] == 0);
+#endif
+	    }
 
-	    /* Compute U and V */
-	    u0 = t.pos[i1] - tri->data[0].v[i1];
-	    v0 = t.pos[i2] - tri->data[0].v[i2];
+	    for (l = 0; l < TIE_SIMD_WIDTH; l++) {
+		fastf_t d;
 
-	    /*
-	     * Compute the barycentric coordinates, and make sure the
-	     * coordinates fall within the boundaries of the triangle
-	     * plane.
-	     */
-	    if (fabs(tri->data[2].v[1]) <= TIE_PREC) {
-		t.beta = u0 / tri->data[2].v[2];
-		if (t.beta < 0 || t.beta > 1)
+#if TIE_PRECISION == 0
+		if (!(ok[l] | edge[l]) || !p->tri[l])
 		    continue;
-		t.alpha = (v0 - t.beta*v[1]) / v[0];
-	    } else {
-		t.beta = (v0*tri->data[2].v[1] - u0*v[0]) / (v[1]*tri->data[2].v[1] - tri->data[2].v[2]*v[0]);
-		if (t.beta < 0 || t.beta > 1)
+#else
+		if (!ok[l] || !p->tri[l])
 		    continue;
-		t.alpha = (u0 - t.beta*tri->data[2].v[2]) / tri->data[2].v[1];
-	    }
+#endif
 
-	    if (t.alpha < 0 || (t.alpha + t.beta) > 1.0)
-		continue;
+		t.dist = tn[l];
+		t.alpha = e1[l];
+		t.beta = e2[l];
+		d = td[l];
+
+#if TIE_PRECISION == 0
+		if (edge[l]) {
+		    double e[3];
+
+		    TIE_VAL(tie_edges_double)(p, l, ray, kx, ky, kz, e, &t.dist);
+		    if ((e[0] < 0.0 || e[1] < 0.0 || e[2] < 0.0) && (e[0] > 0.0 || e[1] > 0.0 || e[2] > 0.0))
+			continue;
+		    d = e[0] + e[1] + e[2];
+		    if (ZERO(d))
+			continue;
+		    t.dist /= d;
+		    if (isnan(t.dist) || t.dist < tmin || t.dist > tmax)
+			continue;
+		    t.alpha = e[1];
+		    t.beta = e[2];
+		}
+#endif
 
-	    /* Triangle Intersected, append it in the list */
-	    if (hit_count < 0xFF) {
-		hit_list[hit_count] = tri;
-		id_list[hit_count] = t;
-		hit_count++;
+		/* Compute Intersection Point (P = O + Dt) */
+		VJOIN1(t.pos, ray->pos, t.dist, ray->dir);
+
+		/* Barycentric weights of the second and third vertices */
+		t.alpha /= d;
+		t.beta /= d;
+
+		/* Triangle Intersected, append it in the list */
+		if (hit_count < 0xFF) {
+		    hit_list[hit_count] = p->tri[l];
+		    id_list[hit_count] = t;
+		    hit_count++;
+		}
 	    }
 	}
 
@@ -0,0 +1,493 @@
+/*                     T I E _ C A C H E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file primitives/bot/tie_cache.c
+ *
+ * On-disk copy of a prepped tie, so that applications loading the
+ * same geometry again can skip the kd-tree build.
+ *
+ * The file is a header followed by flat arrays: the prepped
+ * triangles, the kd-tree nodes and the triangle references of the
+ * leaves, padded to a multiple of 8 bytes, then an application block.  Each triangle also keeps the
+ * vertices it was pushed with, which tie_prep() no longer has in the
+ * triangle itself, to repack the leaves for tie_work() on load.
+ * Pointers are stored as array indices, and the children of a node
+ * are stored next to each other.  The triangle association pointers
+ * are stored as indices into a table supplied by the application,
+ * which also gets its own block back to rebuild that table on load.
+ *
+ * The file is only valid for the build that wrote it: the header
+ * records the format version, byte order and size of TFLOAT, and a
+ * key chosen by the application (typically a hash of the geometry
+ * the triangles came from).  Any mismatch makes the load fail, and
+ * the caller builds the tree as usual.
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bu/file.h"
+#include "bu/hash.h"
+#include "bu/malloc.h"
+#include "bu/mapped_file.h"
+#include "bu/process.h"
+#include "rt/tie.h"
+
+#include "tieprivate.h"
+
+#define TIE_CACHE_MAGIC "TIEKDC\0\0"
+#define TIE_CACHE_VERSION 3
+#define TIE_CACHE_ENDIAN 0x01020304
+
+struct tie_cache_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;		/* TIE_CACHE_ENDIAN as written */
+    uint32_t tfloat_size;	/* sizeof(TFLOAT) */
+    uint32_t kdmethod;
+    uint64_t key;		/* application's validation key */
+    uint32_t tri_num;
+    uint32_t node_num;
+    uint32_t ref_num;		/* triangle references in the leaves */
+    uint32_t ptr_num;		/* entries in the association table */
+    uint64_t user_len;		/* bytes in the application block */
+    uint32_t max_depth;
+    uint32_t pad;
+    double min[3], max[3];
+    double amin[3], amax[3];
+    double mid[3];
+    double radius;
+    double prec;		/* TIE_PREC */
+};
+
+struct tie_cache_tri {
+    TIE_3 data[3];
+    TIE_3 vert[3];		/* vertices as pushed */
+    TFLOAT v[2];
+    uint32_t b;
+    uint32_t ptr;		/* index into the association table */
+};
+
+struct tie_cache_node {
+    float axis;
+    uint32_t b;
+    uint32_t index;		/* first child, or first reference of a leaf */
+    uint32_t count;		/* triangles in a leaf */
+};
+
+#define TIE_CACHE_NOPTR 0xffffffff
+
+/* the references are padded so the application block that follows
+ * them is 8 byte aligned, like every other array in the file */
+#define TIE_CACHE_REFS_SIZE(_n) (((size_t)(_n) * sizeof(uint32_t) + 7) & ~(size_t)7)
+
+
+struct tie_cache_state {
+    struct tie_s *tie;
+    struct tie_cache_node *nodes;
+    uint32_t *refs;
+    size_t node_num;
+    size_t ref_num;
+};
+
+
+static void
+tie_cache_count(struct tie_kdtree_s *node, size_t *node_num, size_t *ref_num)
+{
+    (*node_num)++;
+    if (TIE_HAS_CHILDREN(node->b)) {
+	tie_cache_count(&((struct tie_kdtree_s *)node->data)[0], node_num, ref_num);
+	tie_cache_count(&((struct tie_kdtree_s *)node->data)[1], node_num, ref_num);
+    } else if (node->data) {
+	*ref_num += ((struct tie_geom_s *)node->data)->tri_num;
+    }
+}
+
+
+static void
+tie_cache_flatten(struct tie_cache_state *s, struct tie_kdtree_s *node, size_t slot)
+{
+    struct tie_cache_node *cn = &s->nodes[slot];
+
+    cn->axis = node->axis;
+    cn->b = node->b;
+
+    if (TIE_HAS_CHILDREN(node->b)) {
+	size_t first = s->node_num;
+
+	s->node_num += 2;
+	cn->index = (uint32_t)first;
+	cn->count = 0;
+	tie_cache_flatten(s, &((struct tie_kdtree_s *)node->data)[0], first);
+	tie_cache_flatten(s, &((struct tie_kdtree_s *)node->data)[1], first + 1);
+    } else {
+	struct tie_geom_s *g = (struct tie_geom_s *)node->data;
+	uint32_t i;
+
+	cn->index = (uint32_t)s->ref_num;
+	cn->count = g ? g->tri_num : 0;
+	for (i = 0; i < cn->count; i++)
+	    s->refs[s->ref_num++] = (uint32_t)(g->tri_list[i] - s->tie->tri_list);
+    }
+}
+
+
+static int
+tie_cache_unflatten(struct tie_cache_state *s, struct tie_kdtree_s *node, size_t slot)
+{
+    const struct tie_cache_node *cn = &s->nodes[slot];
+
+    node->axis = cn->axis;
+
+    if (TIE_HAS_CHILDREN(cn->b)) {
+	struct tie_kdtree_s *kids;
+
+	/* children always come after their parent */
+	if (cn->index <= slot || (size_t)cn->index + 1 >= s->node_num)
+	    return -1;
+
+	/* only mark the node once it has children to free */
+	kids = (struct tie_kdtree_s *)bu_calloc(2, sizeof(struct tie_kdtree_s), "tie_cache kids");
+	node->data = kids;
+	node->b = cn->b;
+	if (tie_cache_unflatten(s, &kids[0], cn->index) < 0)
+	    return -1;
+	return tie_cache_unflatten(s, &kids[1], cn->index + 1);
+    } else {
+	struct tie_geom_s *g;
+	uint32_t i;
+
+	if ((size_t)cn->index + cn->count > s->ref_num)
+	    return -1;
+
+	BU_ALLOC(g, struct tie_geom_s);
+	node->data = g;
+	node->b = cn->b;
+	g->tri_num = cn->count;
+	g->tri_list = NULL;
+	if (!cn->count)
+	    return 0;
+
+	g->tri_list = (struct tie_tri_s **)bu_calloc(cn->count, sizeof(struct tie_tri_s *), "tie_cache tri_list");
+	for (i = 0; i < cn->count; i++) {
+	    uint32_t t = s->refs[cn->index + i];
+	    if (t >= s->tie->tri_num)
+		return -1;
+	    g->tri_list[i] = &s->tie->tri_list[t];
+	}
+    }
+    return 0;
+}
+
+
+static void
+tie_cache_verts(struct tie_s *tie, struct tie_kdtree_s *node, struct tie_cache_tri *tris)
+{
+    struct tie_geom_s *g;
+    unsigned int i, j, k, l;
+
+    if (!node || !node->data)
+	return;
+
+    if (TIE_HAS_CHILDREN(node->b)) {
+	tie_cache_verts(tie, &((struct tie_kdtree_s *)node->data)[0], tris);
+	tie_cache_verts(tie, &((struct tie_kdtree_s *)node->data)[1], tris);
+	return;
+    }
+
+    g = (struct tie_geom_s *)node->data;
+    for (i = 0; i < g->pack_num; i++) {
+	const struct tie_pack_s *p = &g->pack[i];
+	for (l = 0; l < TIE_SIMD_WIDTH && p->tri[l]; l++) {
+	    struct tie_cache_tri *ct = &tris[p->tri[l] - tie->tri_list];
+	    for (j = 0; j < 3; j++)
+		for (k = 0; k < 3; k++)
+		    ct->vert[j].v[k] = p->v[j][k][l];
+	}
+    }
+}
+
+
+/**
+ * Write a prepped tie to the file at path.
+ *
+ * The association pointer of each triangle must be NULL or one of
+ * the nptrs entries of ptrs; it is stored as the index of that entry.
+ * user_len bytes at user are stored as-is and handed back by
+ * tie_cache_load(), so that the application can rebuild its table.
+ * The block is handed back 8 byte aligned, so it may hold an array
+ * of structs with double members.
+ * The file is written under a temporary name unique to this process
+ * and renamed into place.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int
+TIE_VAL(tie_cache_save)(struct tie_s *tie, const char *path, uint64_t key, void **ptrs, unsigned int nptrs, const void *user, size_t user_len)
+{
+    struct tie_cache_header h;
+    struct tie_cache_state s;
+    struct tie_cache_tri *tris;
+    struct bu_hash_tbl *ptrtbl;
+    char tmp[MAXPATHLEN];
+    size_t node_num = 0, ref_num = 0;
+    uint32_t pad = 0;
+    unsigned int i;
+    FILE *fp;
+    int ret = -1;
+
+    if (!tie || !tie->kdtree || !path)
+	return -1;
+
+    tie_cache_count(tie->kdtree, &node_num, &ref_num);
+    if (node_num >= TIE_CACHE_NOPTR || ref_num >= TIE_CACHE_NOPTR)
+	return -1;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TIE_CACHE_MAGIC, sizeof(h.magic));
+    h.version = TIE_CACHE_VERSION;
+    h.endian = TIE_CACHE_ENDIAN;
+    h.tfloat_size = sizeof(TFLOAT);
+    h.kdmethod = tie->kdmethod;
+    h.key = key;
+    h.tri_num = tie->tri_num;
+    h.node_num = (uint32_t)node_num;
+    h.ref_num = (uint32_t)ref_num;
+    h.ptr_num = nptrs;
+    h.user_len = user_len;
+    h.max_depth = tie->max_depth;
+    VMOVE(h.min, tie->min);
+    VMOVE(h.max, tie->max);
+    VMOVE(h.amin, tie->amin);
+    VMOVE(h.amax, tie->amax);
+    VMOVE(h.mid, tie->mid);
+    h.radius = tie->radius;
+    h.prec = TIE_PREC;
+
+    /* association pointers become table indices */
+    ptrtbl = bu_hash_create(nptrs ? nptrs : 1);
+    for (i = 0; i < nptrs; i++)
+	bu_hash_set(ptrtbl, (const uint8_t *)&ptrs[i], sizeof(void *), (void *)(uintptr_t)(i + 1));
+
+    tris = (struct tie_cache_tri *)bu_calloc(tie->tri_num ? tie->tri_num : 1, sizeof(struct tie_cache_tri), "tie_cache tris");
+    for (i = 0; i < tie->tri_num; i++) {
+	struct tie_tri_s *tri = &tie->tri_list[i];
+	uintptr_t idx = 0;
+
+	tris[i].data[0] = tri->data[0];
+	tris[i].data[1] = tri->data[1];
+	tris[i].data[2] = tri->data[2];
+	V2MOVE(tris[i].v, tri->v);
+	tris[i].b = tri->b;
+	if (tri->ptr)
+	    idx = (uintptr_t)bu_hash_get(ptrtbl, (const uint8_t *)&tri->ptr, sizeof(void *));
+	if (tri->ptr && !idx) {
+	    bu_log("tie_cache_save: triangle %u refers to an unlisted pointer\n", i);
+	    goto out;
+	}
+	tris[i].ptr = idx ? (uint32_t)(idx - 1) : TIE_CACHE_NOPTR;
+    }
+
+    tie_cache_verts(tie, tie->kdtree, tris);
+
+    s.tie = tie;
+    s.nodes = (struct tie_cache_node *)bu_calloc(node_num, sizeof(struct tie_cache_node), "tie_cache nodes");
+    s.refs = (uint32_t *)bu_calloc(ref_num ? ref_num : 1, sizeof(uint32_t), "tie_cache refs");
+    s.node_num = 1;
+    s.ref_num = 0;
+    tie_cache_flatten(&s, tie->kdtree, 0);
+
+    /* the pid keeps writers of the same cache out of each other's way */
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, bu_pid());
+    fp = fopen(tmp, "wb");
+    if (fp) {
+	int ok = (fwrite(&h, sizeof(h), 1, fp) == 1
+		  && fwrite(tris, sizeof(struct tie_cache_tri), tie->tri_num, fp) == tie->tri_num
+		  && fwrite(s.nodes, sizeof(struct tie_cache_node), node_num, fp) == node_num
+		  && fwrite(s.refs, sizeof(uint32_t), ref_num, fp) == ref_num
+		  && (!(ref_num & 1) || fwrite(&pad, sizeof(pad), 1, fp) == 1)
+		  && (!user_len || fwrite(user, user_len, 1, fp) == 1));
+	if (fclose(fp) != 0)
+	    ok = 0;
+
+	/* rename() will not replace an existing file everywhere */
+	if (ok && bu_file_exists(path, NULL))
+	    bu_file_delete(path);
+	if (ok && rename(tmp, path) == 0)
+	    ret = 0;
+	else
+	    bu_file_delete(tmp);
+    }
+
+    bu_free(s.nodes, "tie_cache nodes");
+    bu_free(s.refs, "tie_cache refs");
+out:
+    bu_free(tris, "tie_cache tris");
+    bu_hash_destroy(ptrtbl);
+    return ret;
+}
+
+
+/**
+ * Load a tie written by tie_cache_save() in place of pushing the
+ * triangles and calling tie_prep().  The tie must have been through
+ * tie_init() and hold no triangles yet.
+ *
+ * ptrs_func is given the application block stored with the tie and
+ * must fill in the nptrs entries of the association table from it,
+ * returning 0 on success.  The block is 8 byte aligned and only valid
+ * during the call.
+ * It is called after the rest of the file has been checked, so once
+ * it succeeds the load does too; if it fails, it must undo whatever
+ * it did before returning.
+ *
+ * @return 0 if the tie was loaded, -1 if the file is missing, stale
+ * or damaged, in which case the tie is left empty.
+ */
+int
+TIE_VAL(tie_cache_load)(struct tie_s *tie, const char *path, uint64_t key, int (*ptrs_func)(const void *user, size_t user_len, void **ptrs, unsigned int nptrs, void *data), void *data)
+{
+    struct bu_mapped_file *mp;
+    const struct tie_cache_header *h;
+    const struct tie_cache_tri *tris;
+    const uint8_t *buf;
+    struct tie_cache_state s;
+    TIE_3 *verts;
+    void **ptrs = NULL;
+    size_t need;
+    unsigned int i;
+    int ret = -1;
+
+    if (!tie || !path || tie->tri_num || tie->kdtree)
+	return -1;
+    if (!bu_file_exists(path, NULL))
+	return -1;
+
+    mp = bu_open_mapped_file(path, "tie kd-tree cache");
+    if (!mp)
+	return -1;
+
+    buf = (const uint8_t *)mp->buf;
+    h = (const struct tie_cache_header *)buf;
+    if (mp->buflen < sizeof(struct tie_cache_header)
+	|| memcmp(h->magic, TIE_CACHE_MAGIC, sizeof(h->magic)) != 0
+	|| h->version != TIE_CACHE_VERSION
+	|| h->endian != TIE_CACHE_ENDIAN
+	|| h->tfloat_size != sizeof(TFLOAT)
+	|| h->kdmethod != tie->kdmethod
+	|| h->key != key
+	|| h->node_num == 0)
+	goto out;
+
+    need = sizeof(struct tie_cache_header)
+	+ (size_t)h->tri_num * sizeof(struct tie_cache_tri)
+	+ (size_t)h->node_num * sizeof(struct tie_cache_node)
+	+ TIE_CACHE_REFS_SIZE(h->ref_num)
+	+ (size_t)h->user_len;
+    if (mp->buflen != need)
+	goto out;
+
+    tris = (const struct tie_cache_tri *)(buf + sizeof(struct tie_cache_header));
+    s.nodes = (struct tie_cache_node *)(tris + h->tri_num);
+    s.refs = (uint32_t *)(s.nodes + h->node_num);
+
+    for (i = 0; i < h->tri_num; i++) {
+	if (tris[i].ptr != TIE_CACHE_NOPTR && tris[i].ptr >= h->ptr_num)
+	    goto out;
+    }
+
+    if (h->tri_num > tie->tri_num_alloc) {
+	tie->tri_list = (struct tie_tri_s *)bu_realloc(tie->tri_list, sizeof(struct tie_tri_s) * h->tri_num, "tie_cache tri_list");
+	tie->tri_num_alloc = h->tri_num;
+    }
+    for (i = 0; i < h->tri_num; i++) {
+	struct tie_tri_s *tri = &tie->tri_list[i];
+
+	tri->data[0] = tris[i].data[0];
+	tri->data[1] = tris[i].data[1];
+	tri->data[2] = tris[i].data[2];
+	V2MOVE(tri->v, tris[i].v);
+	tri->b = tris[i].b;
+	tri->ptr = NULL;
+    }
+    tie->tri_num = h->tri_num;
+
+    s.tie = tie;
+    s.node_num = h->node_num;
+    s.ref_num = h->ref_num;
+    BU_ALLOC(tie->kdtree, struct tie_kdtree_s);
+    if (tie_cache_unflatten(&s, tie->kdtree, 0) < 0)
+	goto fail;
+
+    /* the file checks out, so the application is only asked to
+     * rebuild its table once nothing else can go wrong */
+    if (h->ptr_num) {
+	ptrs = (void **)bu_calloc(h->ptr_num, sizeof(void *), "tie_cache ptrs");
+	if (!ptrs_func || ptrs_func((const void *)((const uint8_t *)s.refs + TIE_CACHE_REFS_SIZE(h->ref_num)), (size_t)h->user_len, ptrs, h->ptr_num, data) != 0)
+	    goto fail;
+	for (i = 0; i < h->tri_num; i++) {
+	    if (tris[i].ptr != TIE_CACHE_NOPTR)
+		tie->tri_list[i].ptr = ptrs[tris[i].ptr];
+	}
+    }
+
+    verts = (TIE_3 *)bu_calloc(3 * (size_t)(h->tri_num ? h->tri_num : 1), sizeof(TIE_3), "tie_cache verts");
+    for (i = 0; i < h->tri_num; i++) {
+	verts[3*i+0] = tris[i].vert[0];
+	verts[3*i+1] = tris[i].vert[1];
+	verts[3*i+2] = tris[i].vert[2];
+    }
+    TIE_VAL(tie_pack_node)(tie, tie->kdtree, verts);
+    bu_free(verts, "tie_cache verts");
+
+    tie->max_depth = h->max_depth;
+    VMOVE(tie->min, h->min);
+    VMOVE(tie->max, h->max);
+    VMOVE(tie->amin, h->amin);
+    VMOVE(tie->amax, h->amax);
+    VMOVE(tie->mid, h->mid);
+    tie->radius = h->radius;
+    tie->stat = 0;
+    TIE_PREC = h->prec;
+    ret = 0;
+    goto out;
+
+fail:
+    TIE_KDTREE_FREE(tie);
+    tie->kdtree = NULL;
+    tie->tri_num = 0;
+out:
+    if (ptrs)
+	bu_free(ptrs, "tie_cache ptrs");
+    bu_close_mapped_file(mp);
+    return ret;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -127,6 +127,8 @@ tie_kdtree_free_node(struct tie_kdtree_s *node)
 	    if (tmp->tri_num > 0) {
 		bu_free(tmp->tri_list, "tri_list");
 	    }
+	    if (tmp->pack)
+		bu_free(tmp->pack, "pack");
 	    bu_free(tmp, "data");
 	}
     }
@@ -38,9 +38,36 @@ extern "C" {
 #define TIE_HAS_CHILDREN(bits) (bits & (uint32_t)0x4L)
 #define TIE_SET_HAS_CHILDREN(bits) (bits | (uint32_t)0x4L)
 
+/* Number of triangles tested at once by tie_work(), and an integer
+ * the size of TFLOAT for the per-triangle results, so that the test
+ * vectorizes.  Eight floats only fit in one register with AVX.
+ */
+#if TIE_PRECISION == 0
+#  if defined(__AVX__)
+#    define TIE_SIMD_WIDTH 8
+#  else
+#    define TIE_SIMD_WIDTH 4
+#  endif
+typedef int32_t tie_lane_t;
+#else
+#  define TIE_SIMD_WIDTH 4
+typedef int64_t tie_lane_t;
+#endif
+
+/* The triangles of a leaf, TIE_SIMD_WIDTH at a time.  The vertices
+ * are kept exactly as pushed, so the watertight test in tie_work()
+ * gives the same answer for an edge from both of its triangles.
+ */
+struct tie_pack_s {
+    TFLOAT v[3][3][TIE_SIMD_WIDTH];		/* vertex, axis, lane */
+    struct tie_tri_s *tri[TIE_SIMD_WIDTH];	/* NULL for unused lanes */
+};
+
 struct tie_geom_s {
     struct tie_tri_s **tri_list; /* 4-bytes or 8-bytes */
     uint32_t tri_num; /* 4-bytes */
+    uint32_t pack_num; /* 4-bytes */
+    struct tie_pack_s *pack; /* 4-bytes or 8-bytes */
 };
 
 #ifdef _WIN32
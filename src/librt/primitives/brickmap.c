@@ -0,0 +1,404 @@
+/*                      B R I C K M A P . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file primitives/brickmap.c
+ *
+ * Min/max occupancy pyramid for the voxel primitives.
+ *
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "bu/malloc.h"
+#include "bu/parallel.h"
+#include "brickmap.h"
+
+
+#define BRICKMAP_MAGIC 0x42524b4d	/* "BRKM" */
+#define BRICKMAP_VERSION 1
+
+
+static size_t
+brickmap_count(const struct rt_brickmap_level *lp)
+{
+    return lp->dim[X] * lp->dim[Y] * lp->dim[Z];
+}
+
+
+void
+rt_brickmap_build(struct rt_brickmap *bm, int ndim, const size_t dim[3], const unsigned char *cells, size_t ystride, size_t zstride)
+{
+    struct rt_brickmap_level *lp;
+    size_t x, y, z, i, n;
+    int a, l;
+
+    memset(bm, 0, sizeof(struct rt_brickmap));
+    bm->ndim = ndim;
+    bm->dim[X] = dim[X];
+    bm->dim[Y] = dim[Y];
+    bm->dim[Z] = (ndim > 2) ? dim[Z] : 1;
+    if (!cells || !bm->dim[X] || !bm->dim[Y] || !bm->dim[Z])
+	return;
+
+    for (l = 0; l < RT_BRICKMAP_MAX_LEVELS; l++) {
+	int top = 1;
+
+	lp = &bm->level[l];
+	lp->shift = RT_BRICKMAP_BASE_SHIFT + l * RT_BRICKMAP_LEVEL_SHIFT;
+	for (a = 0; a < 3; a++) {
+	    lp->dim[a] = ((bm->dim[a] - 1) >> lp->shift) + 1;
+	    if (lp->dim[a] > 1)
+		top = 0;
+	}
+	n = brickmap_count(lp);
+	lp->min = (unsigned char *)bu_malloc(n, "brickmap min");
+	lp->max = (unsigned char *)bu_malloc(n, "brickmap max");
+	memset(lp->min, 0xFF, n);
+	memset(lp->max, 0, n);
+	bm->nlevels++;
+
+	if (l == 0) {
+	    /* a single pass over the cells, a row at a time */
+	    for (z = 0; z < bm->dim[Z]; z++) {
+		for (y = 0; y < bm->dim[Y]; y++) {
+		    const unsigned char *row = cells + y * ystride + z * zstride;
+		    size_t base = ((z >> lp->shift) * lp->dim[Y] + (y >> lp->shift)) * lp->dim[X];
+
+		    for (x = 0; x < bm->dim[X]; x++) {
+			i = base + (x >> lp->shift);
+			if (row[x] < lp->min[i])
+			    lp->min[i] = row[x];
+			if (row[x] > lp->max[i])
+			    lp->max[i] = row[x];
+		    }
+		}
+	    }
+	} else {
+	    /* fold the level below */
+	    const struct rt_brickmap_level *sp = &bm->level[l - 1];
+	    size_t s = RT_BRICKMAP_LEVEL_SHIFT;
+
+	    for (z = 0; z < sp->dim[Z]; z++) {
+		for (y = 0; y < sp->dim[Y]; y++) {
+		    for (x = 0; x < sp->dim[X]; x++) {
+			size_t j = (z * sp->dim[Y] + y) * sp->dim[X] + x;
+			i = ((z >> s) * lp->dim[Y] + (y >> s)) * lp->dim[X] + (x >> s);
+			if (sp->min[j] < lp->min[i])
+			    lp->min[i] = sp->min[j];
+			if (sp->max[j] > lp->max[i])
+			    lp->max[i] = sp->max[j];
+		    }
+		}
+	    }
+	}
+
+	if (top)
+	    break;
+    }
+}
+
+
+void
+rt_brickmap_free(struct rt_brickmap *bm)
+{
+    int l;
+
+    if (!bm)
+	return;
+    for (l = 0; l < bm->nlevels; l++) {
+	bu_free(bm->level[l].min, "brickmap min");
+	bu_free(bm->level[l].max, "brickmap max");
+    }
+    memset(bm, 0, sizeof(struct rt_brickmap));
+}
+
+
+int
+rt_brickmap_uniform(const struct rt_brickmap *bm, const size_t cell[3], unsigned int lo, unsigned int hi, int want_solid)
+{
+    int best = -1;
+    int l;
+
+    for (l = 0; l < bm->nlevels; l++) {
+	const struct rt_brickmap_level *lp = &bm->level[l];
+	size_t i;
+	unsigned int bmin, bmax;
+
+	i = ((cell[Z] >> lp->shift) * lp->dim[Y] + (cell[Y] >> lp->shift)) * lp->dim[X] + (cell[X] >> lp->shift);
+	bmin = lp->min[i];
+	bmax = lp->max[i];
+
+	if (want_solid) {
+	    if (bmin < lo || bmax > hi)
+		break;
+	} else {
+	    /* conservative: no cell can fall in [lo, hi] */
+	    if (bmax >= lo && bmin <= hi)
+		break;
+	}
+	/* a brick containing this one can only be uniform if this is */
+	best = (int)lp->shift;
+    }
+
+    return best;
+}
+
+
+int
+rt_brickmap_exit(int ndim, size_t shift, const fastf_t dir[3], const fastf_t t[3], const fastf_t delta[3], const size_t cell[3], size_t steps[3], fastf_t *texit)
+{
+    size_t todo[3];
+    fastf_t tx = INFINITY;
+    int axis = X;
+    int a;
+
+    /* crossings needed to leave the brick along each axis, and when
+     * the last of them happens
+     */
+    for (a = 0; a < ndim; a++) {
+	size_t lo = (cell[a] >> shift) << shift;
+	fastf_t ta;
+
+	steps[a] = 0;
+	todo[a] = 0;
+	if (ZERO(delta[a]) || !(t[a] < INFINITY))
+	    continue;
+	if (dir[a] > 0)
+	    todo[a] = lo + ((size_t)1 << shift) - cell[a];
+	else
+	    todo[a] = cell[a] - lo + 1;
+	ta = t[a] + (fastf_t)(todo[a] - 1) * delta[a];
+	if (ta < tx) {
+	    tx = ta;
+	    axis = a;
+	}
+    }
+    for (; a < 3; a++)
+	steps[a] = 0;
+
+    /* the other axes only get the crossings that come first */
+    for (a = 0; a < ndim; a++) {
+	fastf_t k;
+
+	if (a == axis) {
+	    steps[a] = todo[a];
+	    continue;
+	}
+	if (!todo[a] || t[a] >= tx)
+	    continue;
+	k = ceil((tx - t[a]) / delta[a]);
+	if (k > (fastf_t)(todo[a] - 1))
+	    k = (fastf_t)(todo[a] - 1);
+	steps[a] = (size_t)k;
+    }
+
+    *texit = tx;
+    return axis;
+}
+
+
+int
+rt_brickmap_stamp(const char *file, int64_t stamp[2])
+{
+    struct stat sb;
+    int ret;
+
+    stamp[0] = stamp[1] = 0;
+    if (!file)
+	return -1;
+
+    bu_semaphore_acquire(BU_SEM_SYSCALL);
+    ret = stat(file, &sb);
+    bu_semaphore_release(BU_SEM_SYSCALL);
+    if (ret < 0)
+	return -1;
+
+    stamp[0] = (int64_t)sb.st_size;
+    stamp[1] = (int64_t)sb.st_mtime;
+    return 0;
+}
+
+
+static unsigned char *
+brickmap_put32(unsigned char *cp, uint32_t v)
+{
+    cp[0] = (unsigned char)(v >> 24);
+    cp[1] = (unsigned char)(v >> 16);
+    cp[2] = (unsigned char)(v >> 8);
+    cp[3] = (unsigned char)v;
+    return cp + 4;
+}
+
+
+static const unsigned char *
+brickmap_get32(const unsigned char *cp, uint32_t *v)
+{
+    *v = ((uint32_t)cp[0] << 24) | ((uint32_t)cp[1] << 16) | ((uint32_t)cp[2] << 8) | (uint32_t)cp[3];
+    return cp + 4;
+}
+
+
+/* header: magic, version, ndim, dim[3], nlevels, stamp (2 x 2 words) */
+#define BRICKMAP_HDR_WORDS 11
+/* per level: shift, dim[3] */
+#define BRICKMAP_LEVEL_WORDS 4
+
+
+void
+rt_brickmap_export(struct bu_external *ext, const struct rt_brickmap *bm, const int64_t stamp[2])
+{
+    unsigned char *cp;
+    size_t len;
+    int a, l;
+
+    BU_CK_EXTERNAL(ext);
+
+    len = BRICKMAP_HDR_WORDS * 4;
+    for (l = 0; l < bm->nlevels; l++)
+	len += BRICKMAP_LEVEL_WORDS * 4 + 2 * brickmap_count(&bm->level[l]);
+
+    ext->ext_nbytes = len;
+    ext->ext_buf = (uint8_t *)bu_malloc(len, "brickmap external");
+    cp = ext->ext_buf;
+
+    cp = brickmap_put32(cp, BRICKMAP_MAGIC);
+    cp = brickmap_put32(cp, BRICKMAP_VERSION);
+    cp = brickmap_put32(cp, (uint32_t)bm->ndim);
+    for (a = 0; a < 3; a++)
+	cp = brickmap_put32(cp, (uint32_t)bm->dim[a]);
+    cp = brickmap_put32(cp, (uint32_t)bm->nlevels);
+    for (a = 0; a < 2; a++) {
+	cp = brickmap_put32(cp, (uint32_t)((uint64_t)stamp[a] >> 32));
+	cp = brickmap_put32(cp, (uint32_t)((uint64_t)stamp[a] & 0xFFFFFFFFU));
+    }
+
+    for (l = 0; l < bm->nlevels; l++) {
+	const struct rt_brickmap_level *lp = &bm->level[l];
+	size_t n = brickmap_count(lp);
+
+	cp = brickmap_put32(cp, (uint32_t)lp->shift);
+	for (a = 0; a < 3; a++)
+	    cp = brickmap_put32(cp, (uint32_t)lp->dim[a]);
+	memcpy(cp, lp->min, n);
+	cp += n;
+	memcpy(cp, lp->max, n);
+	cp += n;
+    }
+}
+
+
+int
+rt_brickmap_import(struct rt_brickmap *bm, const struct bu_external *ext, int ndim, const size_t dim[3], const int64_t stamp[2])
+{
+    const unsigned char *cp;
+    const unsigned char *end;
+    uint32_t v, hi, lo;
+    int a, l, nlevels;
+
+    BU_CK_EXTERNAL(ext);
+    memset(bm, 0, sizeof(struct rt_brickmap));
+
+    if (ext->ext_nbytes < BRICKMAP_HDR_WORDS * 4)
+	return -1;
+    cp = ext->ext_buf;
+    end = cp + ext->ext_nbytes;
+
+    cp = brickmap_get32(cp, &v);
+    if (v != BRICKMAP_MAGIC)
+	return -1;
+    cp = brickmap_get32(cp, &v);
+    if (v != BRICKMAP_VERSION)
+	return -1;
+    cp = brickmap_get32(cp, &v);
+    if ((int)v != ndim)
+	return -1;
+    for (a = 0; a < 3; a++) {
+	size_t want = (a < ndim) ? dim[a] : 1;
+	cp = brickmap_get32(cp, &v);
+	if ((size_t)v != want)
+	    return -1;
+    }
+    cp = brickmap_get32(cp, &v);
+    if (v < 1 || v > RT_BRICKMAP_MAX_LEVELS)
+	return -1;
+    nlevels = (int)v;
+    for (a = 0; a < 2; a++) {
+	cp = brickmap_get32(cp, &hi);
+	cp = brickmap_get32(cp, &lo);
+	if ((int64_t)(((uint64_t)hi << 32) | lo) != stamp[a])
+	    return -1;
+    }
+
+    bm->ndim = ndim;
+    bm->dim[X] = dim[X];
+    bm->dim[Y] = dim[Y];
+    bm->dim[Z] = (ndim > 2) ? dim[Z] : 1;
+
+    for (l = 0; l < nlevels; l++) {
+	struct rt_brickmap_level *lp = &bm->level[l];
+	size_t n;
+
+	if (end - cp < BRICKMAP_LEVEL_WORDS * 4)
+	    goto bad;
+	cp = brickmap_get32(cp, &v);
+	lp->shift = v;
+	if (lp->shift != (size_t)(RT_BRICKMAP_BASE_SHIFT + l * RT_BRICKMAP_LEVEL_SHIFT))
+	    goto bad;
+	for (a = 0; a < 3; a++) {
+	    cp = brickmap_get32(cp, &v);
+	    lp->dim[a] = v;
+	    if (lp->dim[a] != ((bm->dim[a] - 1) >> lp->shift) + 1)
+		goto bad;
+	}
+	n = brickmap_count(lp);
+	if ((size_t)(end - cp) < 2 * n)
+	    goto bad;
+
+	lp->min = (unsigned char *)bu_malloc(n, "brickmap min");
+	lp->max = (unsigned char *)bu_malloc(n, "brickmap max");
+	bm->nlevels++;
+	memcpy(lp->min, cp, n);
+	cp += n;
+	memcpy(lp->max, cp, n);
+	cp += n;
+    }
+    if (cp != end)
+	goto bad;
+
+    return 0;
+
+bad:
+    rt_brickmap_free(bm);
+    return -1;
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
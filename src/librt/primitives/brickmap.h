@@ -0,0 +1,129 @@
+/*                      B R I C K M A P . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file primitives/brickmap.h
+ *
+ * Min/max occupancy pyramid over a 2-D or 3-D grid of 8-bit cells,
+ * used by the voxel primitives (VOL, EBM) to step over whole bricks
+ * of uniformly empty or uniformly solid cells in a single DDA step.
+ *
+ * Level 0 covers bricks of 4 cells on a side, and each level above
+ * it bricks four times larger, up to the size of the grid.  Each
+ * brick records the smallest and largest cell value inside it, so
+ * the pyramid does not depend on the thresholds used to decide which
+ * cells are solid.
+ */
+
+#ifndef LIBRT_PRIMITIVES_BRICKMAP_H
+#define LIBRT_PRIMITIVES_BRICKMAP_H
+
+#include "common.h"
+
+#include "vmath.h"
+#include "bu/parse.h"
+
+__BEGIN_DECLS
+
+#define RT_BRICKMAP_BASE_SHIFT 2	/* level 0 bricks are 4 cells wide */
+#define RT_BRICKMAP_LEVEL_SHIFT 2	/* each level is 4x wider */
+#define RT_BRICKMAP_MAX_LEVELS 16
+
+struct rt_brickmap_level {
+    size_t shift;		/* bricks are 1<<shift cells on a side */
+    size_t dim[3];		/* bricks along each axis */
+    unsigned char *min;		/* smallest cell value in each brick */
+    unsigned char *max;		/* largest cell value in each brick */
+};
+
+struct rt_brickmap {
+    int ndim;			/* 2 or 3 */
+    size_t dim[3];		/* cells along each axis, dim[Z] is 1 for 2-D */
+    int nlevels;
+    struct rt_brickmap_level level[RT_BRICKMAP_MAX_LEVELS];
+};
+
+
+/**
+ * Build the pyramid for a grid of dim[0] x dim[1] (x dim[2]) cells.
+ * Cell (x, y, z) is read from cells[x + y*ystride + z*zstride].
+ */
+extern void rt_brickmap_build(struct rt_brickmap *bm, int ndim, const size_t dim[3],
+			      const unsigned char *cells, size_t ystride, size_t zstride);
+
+extern void rt_brickmap_free(struct rt_brickmap *bm);
+
+/**
+ * Find the largest brick holding cell[] whose cells are all solid
+ * (value in [lo, hi]) when want_solid is set, or all empty otherwise.
+ *
+ * Returns the brick's shift, or -1 if even the smallest brick is
+ * mixed.
+ */
+extern int rt_brickmap_uniform(const struct rt_brickmap *bm, const size_t cell[3],
+			       unsigned int lo, unsigned int hi, int want_solid);
+
+/**
+ * Work out how a grid DDA leaves the brick of side 1<<shift that
+ * holds cell[].  dir[] is the ray direction, t[] the distance to the
+ * next cell boundary crossing on each axis and delta[] the distance
+ * between crossings.
+ *
+ * On return, steps[] holds how many cells the DDA moves along each
+ * axis to reach the first cell past the brick, and *texit the
+ * distance at which it gets there.  Returns the axis crossed last,
+ * i.e. the entry axis of the next cell.
+ */
+extern int rt_brickmap_exit(int ndim, size_t shift, const fastf_t dir[3],
+			    const fastf_t t[3], const fastf_t delta[3],
+			    const size_t cell[3], size_t steps[3], fastf_t *texit);
+
+/**
+ * Identify the contents of a data file cheaply (size and modification
+ * time), so a cached pyramid can be matched to the file it came from.
+ * Returns 0 on success, -1 if the file can not be examined.
+ */
+extern int rt_brickmap_stamp(const char *file, int64_t stamp[2]);
+
+/**
+ * Pack the pyramid, along with the data stamp it belongs to, for
+ * the librt prep cache.
+ */
+extern void rt_brickmap_export(struct bu_external *ext, const struct rt_brickmap *bm, const int64_t stamp[2]);
+
+/**
+ * Unpack a pyramid written by rt_brickmap_export().  Fails (returning
+ * -1 and leaving bm empty) unless it was built for a grid of the
+ * given shape and the same data stamp.
+ */
+extern int rt_brickmap_import(struct rt_brickmap *bm, const struct bu_external *ext,
+			      int ndim, const size_t dim[3], const int64_t stamp[2]);
+
+__END_DECLS
+
+#endif /* LIBRT_PRIMITIVES_BRICKMAP_H */
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -74,6 +74,15 @@
 #define DIM_BB_CHILDREN 4
 #define NUM_BB_CHILDREN (DIM_BB_CHILDREN*DIM_BB_CHILDREN)
 
+/* The bounding box tree below this layer is built a tile at a time,
+ * the first time a ray enters the tile.  Layer 3 nodes are 64 cells on
+ * a side, matching the tiles of a DSP_TILE_SHIFT tiled data file.
+ */
+#define DSP_TILE_LAYER 3
+
+/* tiles are built under one of this many locks, picked by tile number */
+#define DSP_TILE_LOCKS 8
+
 #define IMPORT_FAIL(_s) \
     if (dsp_ip) { \
 	bu_log("rt_dsp_import4(%d) '%s' %s\n", __LINE__, bu_vls_addr(&dsp_ip->dsp_name), _s); \
@@ -85,8 +94,8 @@
 
 
 struct dsp_rpp {
-    unsigned short dsp_min[3];
-    unsigned short dsp_max[3];
+    uint32_t dsp_min[3];
+    uint32_t dsp_max[3];
 };
 
 
@@ -105,8 +114,10 @@ struct dsp_bb {
      * dsp_b_ch_dim is typically DIM_BB_CHILDREN, DIM_BB_CHILDREN
      * except for "border" areas of the array
      */
-    unsigned short dspb_subcell_size;/* XXX This is not yet computed */
+    unsigned int dspb_subcell_size;/* XXX This is not yet computed */
     unsigned short dspb_ch_dim[2];	/* dimensions of children[] */
+    unsigned int dspb_tile;	/* 1 + index in dsp_specific tiles[] if
+				 * the children are built on demand */
     struct dsp_bb *dspb_children[NUM_BB_CHILDREN];
 };
 
@@ -123,6 +134,16 @@ struct dsp_bb_layer {
     struct dsp_bb *p; /* array of dsp_bb's for this level */
 };
 
+/*
+ * The part of the bounding box tree under one node of the tile layer.
+ * 'built', bbs[] and the node's children are only written while
+ * holding the tile's lock (see dsp_tile_build()).
+ */
+struct dsp_tile {
+    struct dsp_bb *bbs;
+    int built;
+};
+
 # define XCNT(_p) (((struct rt_dsp_internal *)_p)->dsp_xcnt)
 # define YCNT(_p) (((struct rt_dsp_internal *)_p)->dsp_ycnt)
 # define XSIZ(_p) (_p->dsp_i.dsp_xcnt - 1)
@@ -161,8 +182,11 @@ struct dsp_specific {
     int xsiz;
     int ysiz;
     int layers;
-    struct dsp_bb_layer *layer;
+    struct dsp_bb_layer *layer;	/* layers below tile_layer have no p */
     struct dsp_bb *bb_array;
+    int tile_layer;
+    struct dsp_tile *tiles;	/* one per node of the tile layer */
+    struct bu_bitv **tiles_seen;	/* per re_cpu, tiles known to be built */
 };
 
 
@@ -418,7 +442,8 @@ plot_layers(struct dsp_specific *dsp_sp)
     int r, g, b, c;
     struct dsp_bb *d_bb;
 
-    for (l = 0; l < dsp_sp->layers; l++) {
+    /* the layers below the tile layer are only built in pieces */
+    for (l = dsp_sp->tile_layer; l < dsp_sp->layers; l++) {
 	bu_semaphore_acquire(BU_SEM_SYSCALL);
 	sprintf(buf, "Dsp_layer%d.plot3", l);
 	fp=fopen(buf, "wb");
@@ -620,75 +645,29 @@ rt_dsp_print(register const struct soltab *stp)
 }
 
 
+static const char *dsp_tile_sem_names[DSP_TILE_LOCKS] = {
+    "LIBRT_SEM_DSP_TILE0", "LIBRT_SEM_DSP_TILE1",
+    "LIBRT_SEM_DSP_TILE2", "LIBRT_SEM_DSP_TILE3",
+    "LIBRT_SEM_DSP_TILE4", "LIBRT_SEM_DSP_TILE5",
+    "LIBRT_SEM_DSP_TILE6", "LIBRT_SEM_DSP_TILE7"
+};
+static int dsp_tile_sems[DSP_TILE_LOCKS];
+
+
 /**
- * compute bounding boxes for each cell, then compute bounding boxes
- * for collections of bounding boxes
+ * compute the bounding boxes of the w by h cells starting at cell
+ * (x0, y0), storing them row by row in bbs[]
  */
 static void
-dsp_layers(struct dsp_specific *dsp, unsigned short *d_min, unsigned short *d_max)
+dsp_fill_cells(struct dsp_specific *dsp, struct dsp_bb *bbs, unsigned int x0, unsigned int y0, unsigned int w, unsigned int h)
 {
-    int idx, curr_layer, xs, ys, xv, yv, tot;
-    unsigned int x, y, i, j, k;
-    unsigned short dsp_min, dsp_max;
+    unsigned int x, y, k;
+    unsigned short cell_min, cell_max;
     unsigned short elev;
     struct dsp_bb *dsp_bb;
-    struct dsp_rpp *t;
-    struct dsp_bb_layer *curr, *prev;
-    unsigned short subcell_size;
 
-    /* First we compute the total number of struct dsp_bb's we will need */
-    xs = dsp->xsiz;
-    ys = dsp->ysiz;
-    tot = xs * ys;
-    /*    bu_log("layer %d   %dx%d\n", 0, xs, ys); */
-    dsp->layers = 1;
-    while (xs > 1 || ys > 1) {
-	xv = xs / DIM_BB_CHILDREN;
-	yv = ys / DIM_BB_CHILDREN;
-	if (xs % DIM_BB_CHILDREN) xv++;
-	if (ys % DIM_BB_CHILDREN) yv++;
-
-#ifdef FULL_DSP_DEBUGGING
-	if (RT_G_DEBUG & RT_DEBUG_HF)
-	    bu_log("layer %d   %dx%d\n", dsp->layers, xv, yv);
-#endif
-	tot += xv * yv;
-
-	if (xv > 0) xs = xv;
-	else xs = 1;
-
-	if (yv > 0) ys = yv;
-	else ys = 1;
-	dsp->layers++;
-    }
-
-
-#ifdef FULL_DSP_DEBUGGING
-    if (RT_G_DEBUG & RT_DEBUG_HF)
-	bu_log("%d layers total\n", dsp->layers);
-#endif
-
-    /* allocate the struct dsp_bb's we will need */
-    dsp->layer = (struct dsp_bb_layer *)bu_malloc(dsp->layers * sizeof(struct dsp_bb_layer),
-			   "dsp_bb_layers array");
-    dsp->bb_array = (struct dsp_bb *)bu_malloc(tot * sizeof(struct dsp_bb), "dsp_bb array");
-
-    /* now we fill in the "lowest" layer of struct dsp_bb's from the
-     * raw data
-     */
-    dsp->layer[0].dim[X] = dsp->xsiz;
-    dsp->layer[0].dim[Y] = dsp->ysiz;
-    dsp->layer[0].p = dsp->bb_array;
-
-    dsp_min = 0xffff;
-    dsp_max = 0;
-
-    for (y = 0; y < YSIZ(dsp); y++) {
-
-	unsigned short cell_min = 0xffff;
-	unsigned short cell_max = 0;
-
-	for (x = 0; x < XSIZ(dsp); x++) {
+    for (y = y0; y < y0 + h; y++) {
+	for (x = x0; x < x0 + w; x++) {
 
 	    elev = DSP(&dsp->dsp_i, x, y);
 	    cell_min = cell_max = elev;
@@ -705,17 +684,13 @@ dsp_layers(struct dsp_specific *dsp, unsigned short *d_min, unsigned short *d_ma
 	    V_MIN(cell_min, elev);
 	    V_MAX(cell_max, elev);
 
-	    /* factor the cell min/max into the overall min/max */
-	    V_MIN(dsp_min, cell_min);
-	    V_MAX(dsp_max, cell_max);
-
 	    /* fill in the dsp_rpp cell min/max */
-	    i = y*XSIZ(dsp) + x;
-	    dsp_bb = &dsp->layer[0].p[i];
+	    dsp_bb = &bbs[(y - y0) * w + (x - x0)];
 	    VSET(dsp_bb->dspb_rpp.dsp_min, x, y, cell_min);
 	    VSET(dsp_bb->dspb_rpp.dsp_max, x+1, y+1, cell_max);
 
 	    dsp_bb->dspb_subcell_size = 0;
+	    dsp_bb->dspb_tile = 0;
 
 	    /* There are no "children" of a layer 0 element */
 	    dsp_bb->dspb_ch_dim[X] = 0;
@@ -731,17 +706,177 @@ dsp_layers(struct dsp_specific *dsp, unsigned short *d_min, unsigned short *d_ma
 	     */
 	}
     }
+}
 
-    *d_min = dsp_min;
-    *d_max = dsp_max;
 
+/**
+ * compute the bounding boxes of layer 'curr_layer' from those of the
+ * layer below it.  (x0, y0) is the position of curr->p[0] within the
+ * whole layer, which is not the origin when filling in part of a tile.
+ */
+static void
+dsp_fill_layer(struct dsp_bb_layer *curr, struct dsp_bb_layer *prev, int curr_layer, unsigned int x0, unsigned int y0)
+{
+    unsigned int x, y, i, j;
+    int idx, tot, n;
+    struct dsp_bb *dsp_bb;
+    struct dsp_rpp *t;
 
-    if (RT_G_DEBUG & RT_DEBUG_HF)
-	bu_log("layer 0 filled\n");
+    n = lrint(pow((double)DIM_BB_CHILDREN, (double)curr_layer));
+
+    /* walk the grid and fill in the values for this layer */
+    for (y = 0; y < curr->dim[Y]; y++) {
+	for (x = 0; x < curr->dim[X]; x++) {
+	    int xp, yp;
+	    /* x, y are in the coordinates in the current
+	     * layer.  xp, yp are the coordinates of the
+	     * same area in the previous (lower) layer.
+	     */
+	    xp = x * DIM_BB_CHILDREN;
+	    yp = y * DIM_BB_CHILDREN;
+
+	    /* initialize the current dsp_bb cell */
+	    dsp_bb = &curr->p[y*curr->dim[X]+x];
+	    dsp_bb->magic = MAGIC_dsp_bb;
+	    VSET(dsp_bb->dspb_rpp.dsp_min,
+		 (x0 + x) * n, (y0 + y) * n, 0x0ffff);
+	    VSET(dsp_bb->dspb_rpp.dsp_max,
+		 (x0 + x) * n, (y0 + y) * n, 0);
+
+	    /* record the dimensions of our children */
+	    dsp_bb->dspb_subcell_size = n / DIM_BB_CHILDREN;
+	    dsp_bb->dspb_tile = 0;
+
+	    tot = 0;
+	    i = 0;
+	    for (j = 0; j < DIM_BB_CHILDREN && (yp+j)<prev->dim[Y]; j++) {
+		for (i = 0; i < DIM_BB_CHILDREN && (xp+i)<prev->dim[X]; i++) {
+
+		    idx = (yp+j) * prev->dim[X] + xp+i;
+
+		    t = &prev->p[ idx ].dspb_rpp;
+
+		    VMINMAX(dsp_bb->dspb_rpp.dsp_min,
+			    dsp_bb->dspb_rpp.dsp_max, t->dsp_min);
+		    VMINMAX(dsp_bb->dspb_rpp.dsp_min,
+			    dsp_bb->dspb_rpp.dsp_max, t->dsp_max);
+
+		    dsp_bb->dspb_children[tot++] = &prev->p[ idx ];
+
+		}
+	    }
+
+	    dsp_bb->dspb_ch_dim[X] = i;
+	    dsp_bb->dspb_ch_dim[Y] = j;
+	}
+    }
+}
+
+
+/**
+ * find the elevation range of each node of the tile layer.  A tiled
+ * data file with tiles the size of the nodes records this in its tile
+ * table, so the samples need not be touched at all.  Otherwise the
+ * samples under each node are scanned once, which is still far less
+ * work and memory than building the cells' bounding boxes.
+ */
+static void
+dsp_tile_ranges(struct dsp_specific *dsp, struct dsp_bb_layer *tl, int n)
+{
+    struct rt_dsp_internal *dsp_ip = &dsp->dsp_i;
+    const unsigned char *table = NULL;
+    size_t ntx = 0;
+    unsigned int x, y, tx, ty;
+    struct dsp_bb *dsp_bb;
+
+    if (dsp_ip->dsp_tiles && dsp_ip->dsp_mp
+	&& ((size_t)1 << dsp_ip->dsp_tile_shift) == (size_t)n) {
+	table = (const unsigned char *)dsp_ip->dsp_mp->buf + DSP_TILED_HDR_LEN;
+	ntx = DSP_TILES_X(dsp_ip);
+    }
+
+    for (ty = 0; ty < tl->dim[Y]; ty++) {
+	for (tx = 0; tx < tl->dim[X]; tx++) {
+	    unsigned short lo = 0xffff;
+	    unsigned short hi = 0;
+
+	    dsp_bb = &tl->p[ty * tl->dim[X] + tx];
+
+	    if (table) {
+		const unsigned char *cp = table + (ty * ntx + tx) * 4;
+		lo = (unsigned short)((cp[0] << 8) | cp[1]);
+		hi = (unsigned short)((cp[2] << 8) | cp[3]);
+	    } else {
+		/* the cells' corners, so one sample past the node */
+		for (y = dsp_bb->dspb_rpp.dsp_min[Y]; y <= dsp_bb->dspb_rpp.dsp_max[Y]; y++) {
+		    for (x = dsp_bb->dspb_rpp.dsp_min[X]; x <= dsp_bb->dspb_rpp.dsp_max[X]; x++) {
+			unsigned short elev = DSP(dsp_ip, x, y);
+			V_MIN(lo, elev);
+			V_MAX(hi, elev);
+		    }
+		}
+	    }
+
+	    dsp_bb->dspb_rpp.dsp_min[Z] = lo;
+	    dsp_bb->dspb_rpp.dsp_max[Z] = hi;
+	}
+    }
+}
+
+
+/**
+ * compute bounding boxes for each cell, then compute bounding boxes
+ * for collections of bounding boxes
+ *
+ * Only the layers from dsp->tile_layer up are built here.  The nodes
+ * of the tile layer are bounded from their samples, and the layers
+ * beneath each of them are left for dsp_tile_build() to fill in when
+ * a ray first reaches it.
+ */
+static void
+dsp_layers(struct dsp_specific *dsp, unsigned short *d_min, unsigned short *d_max)
+{
+    int curr_layer, xs, ys, xv, yv, n;
+    size_t tot;
+    unsigned int x, y, i, k;
+    unsigned short dsp_min, dsp_max;
+    struct dsp_bb *dsp_bb;
+    struct dsp_bb_layer *tl, *prev;
+
+    /* First we compute the number of layers */
+    xs = dsp->xsiz;
+    ys = dsp->ysiz;
+    /*    bu_log("layer %d   %dx%d\n", 0, xs, ys); */
+    dsp->layers = 1;
+    while (xs > 1 || ys > 1) {
+	xv = xs / DIM_BB_CHILDREN;
+	yv = ys / DIM_BB_CHILDREN;
+	if (xs % DIM_BB_CHILDREN) xv++;
+	if (ys % DIM_BB_CHILDREN) yv++;
+
+#ifdef FULL_DSP_DEBUGGING
+	if (RT_G_DEBUG & RT_DEBUG_HF)
+	    bu_log("layer %d   %dx%d\n", dsp->layers, xv, yv);
+#endif
+
+	if (xv > 0) xs = xv;
+	else xs = 1;
+
+	if (yv > 0) ys = yv;
+	else ys = 1;
+	dsp->layers++;
+    }
 
-    subcell_size = 1;
 
-    /* now we compute successive layers from the initial layer */
+#ifdef FULL_DSP_DEBUGGING
+    if (RT_G_DEBUG & RT_DEBUG_HF)
+	bu_log("%d layers total\n", dsp->layers);
+#endif
+
+    dsp->layer = (struct dsp_bb_layer *)bu_calloc(dsp->layers, sizeof(struct dsp_bb_layer),
+			   "dsp_bb_layers array");
+    dsp->layer[0].dim[X] = dsp->xsiz;
+    dsp->layer[0].dim[Y] = dsp->ysiz;
     for (curr_layer = 1; curr_layer < dsp->layers; curr_layer++) {
 	/* compute the number of cells in each direction for this layer */
 
@@ -760,65 +895,86 @@ dsp_layers(struct dsp_specific *dsp, unsigned short *d_min, unsigned short *d_ma
 	else
 	    dsp->layer[curr_layer].dim[Y] =
 		ys / DIM_BB_CHILDREN;
+    }
+
+    dsp->tile_layer = DSP_TILE_LAYER;
+    if (dsp->tile_layer > dsp->layers - 1)
+	dsp->tile_layer = dsp->layers - 1;
+
+    /* allocate the struct dsp_bb's we will need for the tile layer
+     * and those above it
+     */
+    tot = 0;
+    for (curr_layer = dsp->tile_layer; curr_layer < dsp->layers; curr_layer++)
+	tot += (size_t)dsp->layer[curr_layer].dim[X] * dsp->layer[curr_layer].dim[Y];
+    dsp->bb_array = (struct dsp_bb *)bu_malloc(tot * sizeof(struct dsp_bb), "dsp_bb array");
 
+    dsp->layer[dsp->tile_layer].p = dsp->bb_array;
+    for (curr_layer = dsp->tile_layer + 1; curr_layer < dsp->layers; curr_layer++) {
 	/* set the start of the array for this layer */
 	dsp->layer[curr_layer].p =
 	    &dsp->layer[curr_layer-1].p[dsp->layer[curr_layer-1].dim[X] * dsp->layer[curr_layer-1].dim[Y] ];
+    }
 
-	curr = &dsp->layer[curr_layer];
-	prev = &dsp->layer[curr_layer-1];
-
-	if (RT_G_DEBUG & RT_DEBUG_HF)
-	    bu_log("layer %d  subcell size %d\n", curr_layer, subcell_size);
-
-	/* walk the grid and fill in the values for this layer */
-	for (y = 0; y < curr->dim[Y]; y++) {
-	    for (x = 0; x < curr->dim[X]; x++) {
-		int n, xp, yp;
-		/* x, y are in the coordinates in the current
-		 * layer.  xp, yp are the coordinates of the
-		 * same area in the previous (lower) layer.
-		 */
-		xp = x * DIM_BB_CHILDREN;
-		yp = y * DIM_BB_CHILDREN;
-
-		/* initialize the current dsp_bb cell */
-		dsp_bb = &curr->p[y*curr->dim[X]+x];
+    /* now we fill in the tile layer */
+    tl = &dsp->layer[dsp->tile_layer];
+    if (dsp->tile_layer == 0) {
+	/* too small to bother, just a cell or two */
+	dsp_fill_cells(dsp, tl->p, 0, 0, tl->dim[X], tl->dim[Y]);
+    } else {
+	n = lrint(pow((double)DIM_BB_CHILDREN, (double)dsp->tile_layer));
+	prev = &dsp->layer[dsp->tile_layer - 1];
+	dsp->tiles = (struct dsp_tile *)bu_calloc((size_t)tl->dim[X] * tl->dim[Y],
+						  sizeof(struct dsp_tile), "dsp tiles");
+	dsp->tiles_seen = (struct bu_bitv **)bu_calloc(MAX_PSW, sizeof(struct bu_bitv *), "dsp tiles seen");
+
+	for (y = 0; y < tl->dim[Y]; y++) {
+	    for (x = 0; x < tl->dim[X]; x++) {
+		i = y * tl->dim[X] + x;
+		dsp_bb = &tl->p[i];
 		dsp_bb->magic = MAGIC_dsp_bb;
-		n = lrint(pow((double)DIM_BB_CHILDREN, (double)curr_layer));
-		VSET(dsp_bb->dspb_rpp.dsp_min,
-		     x * n, y * n, 0x0ffff);
+		VSET(dsp_bb->dspb_rpp.dsp_min, x * n, y * n, 0);
 		VSET(dsp_bb->dspb_rpp.dsp_max,
-		     x * n, y * n, 0);
-
-		/* record the dimensions of our children */
-		dsp_bb->dspb_subcell_size = subcell_size;
-
-
-		tot = 0;
-		i = 0;
-		for (j = 0; j < DIM_BB_CHILDREN && (yp+j)<prev->dim[Y]; j++) {
-		    for (i = 0; i < DIM_BB_CHILDREN && (xp+i)<prev->dim[X]; i++) {
+		     FMIN((x + 1) * n, (unsigned int)dsp->xsiz),
+		     FMIN((y + 1) * n, (unsigned int)dsp->ysiz), 0);
+		dsp_bb->dspb_subcell_size = n / DIM_BB_CHILDREN;
+
+		/* the children are known, just not built yet */
+		dsp_bb->dspb_ch_dim[X] = FMIN(DIM_BB_CHILDREN, prev->dim[X] - x * DIM_BB_CHILDREN);
+		dsp_bb->dspb_ch_dim[Y] = FMIN(DIM_BB_CHILDREN, prev->dim[Y] - y * DIM_BB_CHILDREN);
+		for (k = 0; k < NUM_BB_CHILDREN; k++)
+		    dsp_bb->dspb_children[k] = (struct dsp_bb *)NULL;
+		dsp_bb->dspb_tile = i + 1;
+	    }
+	}
+	dsp_tile_ranges(dsp, tl, n);
 
-			idx = (yp+j) * prev->dim[X] + xp+i;
+	if (!dsp_tile_sems[0]) {
+	    for (k = 0; k < DSP_TILE_LOCKS; k++)
+		dsp_tile_sems[k] = bu_semaphore_register(dsp_tile_sem_names[k]);
+	}
+    }
 
-			t = &prev->p[ idx ].dspb_rpp;
+    dsp_min = 0xffff;
+    dsp_max = 0;
+    for (i = 0; i < tl->dim[X] * tl->dim[Y]; i++) {
+	V_MIN(dsp_min, tl->p[i].dspb_rpp.dsp_min[Z]);
+	V_MAX(dsp_max, tl->p[i].dspb_rpp.dsp_max[Z]);
+    }
+    *d_min = dsp_min;
+    *d_max = dsp_max;
 
-			VMINMAX(dsp_bb->dspb_rpp.dsp_min,
-				dsp_bb->dspb_rpp.dsp_max, t->dsp_min);
-			VMINMAX(dsp_bb->dspb_rpp.dsp_min,
-				dsp_bb->dspb_rpp.dsp_max, t->dsp_max);
 
-			dsp_bb->dspb_children[tot++] = &prev->p[ idx ];
+    if (RT_G_DEBUG & RT_DEBUG_HF)
+	bu_log("layer %d filled\n", dsp->tile_layer);
 
-		    }
-		}
+    /* now we compute successive layers from the tile layer */
+    for (curr_layer = dsp->tile_layer + 1; curr_layer < dsp->layers; curr_layer++) {
+	if (RT_G_DEBUG & RT_DEBUG_HF)
+	    bu_log("layer %d  subcell size %ld\n", curr_layer,
+		   lrint(pow((double)DIM_BB_CHILDREN, (double)curr_layer - 1)));
 
-		dsp_bb->dspb_ch_dim[X] = i;
-		dsp_bb->dspb_ch_dim[Y] = j;
-	    }
-	}
-	subcell_size *= DIM_BB_CHILDREN;
+	dsp_fill_layer(&dsp->layer[curr_layer], &dsp->layer[curr_layer-1], curr_layer, 0, 0);
     }
 
 #ifdef PLOT_LAYERS
@@ -830,6 +986,115 @@ dsp_layers(struct dsp_specific *dsp, unsigned short *d_min, unsigned short *d_ma
 #endif
 }
 
+
+/**
+ * build the part of the bounding box tree under a node of the tile
+ * layer, the first time a ray reaches it.  Rays in other threads may
+ * arrive at the same tile at the same time, so the build is done
+ * under the tile's lock, and only by whichever gets there first.
+ *
+ * Taking the lock is also what makes the new children visible to a
+ * thread that did not build them, so each thread takes it the first
+ * time it reaches a tile, and then remembers in its own bit vector
+ * (indexed by re_cpu, like the tree_not[] nodes of rt_booleval()) that
+ * the tile is built and never locks it again.
+ */
+static void
+dsp_tile_build(struct dsp_specific *dsp, struct dsp_bb *root, struct resource *resp)
+{
+    struct dsp_tile *tile = &dsp->tiles[root->dspb_tile - 1];
+    struct bu_bitv **seen = &dsp->tiles_seen[resp->re_cpu];
+    int sem = dsp_tile_sems[(root->dspb_tile - 1) % DSP_TILE_LOCKS];
+    struct dsp_bb_layer sub[DSP_TILE_LAYER];
+    unsigned int x0, y0, w, h, i;
+    size_t tot;
+    int l, n;
+
+    if (*seen && BU_BITTEST(*seen, root->dspb_tile - 1))
+	return;
+
+    bu_semaphore_acquire(sem);
+    if (tile->built) {
+	bu_semaphore_release(sem);
+	goto seen;
+    }
+
+    x0 = root->dspb_rpp.dsp_min[X];
+    y0 = root->dspb_rpp.dsp_min[Y];
+    w = root->dspb_rpp.dsp_max[X] - x0;
+    h = root->dspb_rpp.dsp_max[Y] - y0;
+
+    /* the part of each lower layer that lies in the tile */
+    tot = 0;
+    n = 1;
+    for (l = 0; l < dsp->tile_layer; l++) {
+	sub[l].dim[X] = (w + n - 1) / n;
+	sub[l].dim[Y] = (h + n - 1) / n;
+	tot += (size_t)sub[l].dim[X] * sub[l].dim[Y];
+	n *= DIM_BB_CHILDREN;
+    }
+    tile->bbs = (struct dsp_bb *)bu_malloc(tot * sizeof(struct dsp_bb), "dsp tile bb array");
+    sub[0].p = tile->bbs;
+    for (l = 1; l < dsp->tile_layer; l++)
+	sub[l].p = &sub[l-1].p[sub[l-1].dim[X] * sub[l-1].dim[Y]];
+
+    dsp_fill_cells(dsp, sub[0].p, x0, y0, w, h);
+    n = 1;
+    for (l = 1; l < dsp->tile_layer; l++) {
+	n *= DIM_BB_CHILDREN;
+	dsp_fill_layer(&sub[l], &sub[l-1], l, x0 / n, y0 / n);
+    }
+
+    /* hang the new subtree from the tile layer node */
+    l = dsp->tile_layer - 1;
+    for (i = 0; i < (unsigned int)root->dspb_ch_dim[X] * root->dspb_ch_dim[Y]; i++)
+	root->dspb_children[i] = &sub[l].p[i];
+
+    tile->built = 1;
+    bu_semaphore_release(sem);
+
+seen:
+    if (!*seen)
+	*seen = bu_bitv_new((size_t)dsp->layer[dsp->tile_layer].dim[X] * dsp->layer[dsp->tile_layer].dim[Y]);
+    BU_BITSET(*seen, root->dspb_tile - 1);
+}
+
+
+/**
+ * release the bounding box tree, including any tiles built so far
+ */
+static void
+dsp_layers_free(struct dsp_specific *dsp)
+{
+    size_t i, ntiles;
+
+    if (dsp->tiles) {
+	ntiles = (size_t)dsp->layer[dsp->tile_layer].dim[X] * dsp->layer[dsp->tile_layer].dim[Y];
+	for (i = 0; i < ntiles; i++) {
+	    if (dsp->tiles[i].bbs)
+		bu_free(dsp->tiles[i].bbs, "dsp tile bb array");
+	}
+	bu_free(dsp->tiles, "dsp tiles");
+	dsp->tiles = NULL;
+    }
+    if (dsp->tiles_seen) {
+	for (i = 0; i < MAX_PSW; i++) {
+	    if (dsp->tiles_seen[i])
+		bu_bitv_free(dsp->tiles_seen[i]);
+	}
+	bu_free(dsp->tiles_seen, "dsp tiles seen");
+	dsp->tiles_seen = NULL;
+    }
+    if (dsp->bb_array) {
+	bu_free(dsp->bb_array, "dsp_bb array");
+	dsp->bb_array = NULL;
+    }
+    if (dsp->layer) {
+	bu_free(dsp->layer, "dsp_bb_layers array");
+	dsp->layer = NULL;
+    }
+}
+
 /**
  * Calculate the bounding box for a dsp.
  */
@@ -919,6 +1184,8 @@ rt_dsp_bbox(struct rt_db_internal *ip, point_t *min, point_t *max, const struct
 
 #undef BBOX_PT
 
+    dsp_layers_free(&ds);
+
     switch (dsp_ip->dsp_datasrc) {
 	case RT_DSP_SRC_V4_FILE:
 	case RT_DSP_SRC_FILE:
@@ -2164,7 +2431,7 @@ recurse_dsp_bb(struct isect_stuff *isect,
     fastf_t tX, tY;	/* dist from hit pt. to next cell boundary */
     fastf_t curr_dist;
     short cX, cY;	/* coordinates of current cell */
-    short cs;		/* cell X, Y dimension */
+    int cs;		/* cell X, Y dimension */
     short stepX, stepY;	/* dist to step in child array for each dir */
     short stepPX, stepPY;
     fastf_t out_dist;
@@ -2438,6 +2705,10 @@ isect_ray_dsp_bb(struct isect_stuff *isect, struct dsp_bb *dsp_bb)
      * boundary.  We've got to intersect the children
      */
     if (dsp_bb->dspb_ch_dim[0]) {
+	/* the first ray into a tile builds the tree beneath it */
+	if (dsp_bb->dspb_tile)
+	    dsp_tile_build(isect->dsp, dsp_bb, isect->ap->a_resource);
+
 #ifdef ORDERED_ISECT
 	return recurse_dsp_bb(isect, dsp_bb, minpt, maxpt, bbmin, bbmax);
 #else
@@ -3088,6 +3359,8 @@ rt_dsp_free(register struct soltab *stp)
 	    break;
     }
 
+    dsp_layers_free(dsp);
+
     BU_PUT(dsp, struct dsp_specific);
 }
 
@@ -3958,6 +4231,62 @@ rt_dsp_tess(struct nmgregion **r, struct model *m, struct rt_db_internal *ip, co
 }
 
 
+/**
+ * Set up a DSP to read its samples directly from a tiled data file
+ * (see dsp.h).  The samples stay in the mapped file, in network
+ * order, so nothing is read until it is used.
+ *
+ * Returns:
+ * 0 Success
+ * !0 Not a tiled file for this DSP
+ */
+static int
+get_tiled_data(struct rt_dsp_internal *dsp_ip, struct bu_mapped_file *mf)
+{
+    const unsigned char *cp = (const unsigned char *)mf->buf;
+    uint32_t hdr[DSP_TILED_HDR_LEN / 4];
+    size_t ntiles, tile_len;
+    int i;
+
+    if (mf->buflen < DSP_TILED_HDR_LEN || !dsp_ip->dsp_xcnt || !dsp_ip->dsp_ycnt)
+	return -1;
+
+    for (i = 0; i < DSP_TILED_HDR_LEN / 4; i++) {
+	hdr[i] = ntohl(*(uint32_t *)cp);
+	cp += SIZEOF_NETWORK_LONG;
+    }
+    if (hdr[0] != DSP_TILED_MAGIC)
+	return -1;
+    if (hdr[1] != DSP_TILED_VERSION) {
+	bu_log("DSP tiled file version %u not supported\n", hdr[1]);
+	return -1;
+    }
+    if (hdr[2] != dsp_ip->dsp_xcnt || hdr[3] != dsp_ip->dsp_ycnt) {
+	bu_log("DSP tiled file is %ux%u, s/b %ux%u\n",
+	       hdr[2], hdr[3], dsp_ip->dsp_xcnt, dsp_ip->dsp_ycnt);
+	return -1;
+    }
+    if (hdr[4] < 1 || hdr[4] > 12) {
+	bu_log("DSP tiled file has bad tile size 2^%u\n", hdr[4]);
+	return -1;
+    }
+
+    dsp_ip->dsp_tile_shift = hdr[4];
+    ntiles = DSP_TILES_X(dsp_ip) * DSP_TILES_Y(dsp_ip);
+    tile_len = ((size_t)1 << (2 * hdr[4])) * 2;
+    if (mf->buflen != DSP_TILED_DATA_OFF(ntiles) + ntiles * tile_len) {
+	bu_log("DSP tiled file wrong size: %zu s/b %zu\n",
+	       (size_t)mf->buflen, DSP_TILED_DATA_OFF(ntiles) + ntiles * tile_len);
+	dsp_ip->dsp_tile_shift = 0;
+	return -1;
+    }
+
+    dsp_ip->dsp_buf = NULL;
+    dsp_ip->dsp_tiles = (const unsigned char *)mf->buf + DSP_TILED_DATA_OFF(ntiles);
+    return 0;
+}
+
+
 /**
  * Retrieve data for DSP from external file.
  * Returns:
@@ -3989,9 +4318,16 @@ get_file_data(struct rt_dsp_internal *dsp_ip, const struct db_i *dbip)
 	return 0;
     }
 
-    if ((size_t)dsp_ip->dsp_mp->buflen != (size_t)(dsp_ip->dsp_xcnt*dsp_ip->dsp_ycnt*2)) {
-	bu_log("DSP buffer wrong size: %lu s/b %u ",
-	       (long unsigned int)dsp_ip->dsp_mp->buflen, dsp_ip->dsp_xcnt*dsp_ip->dsp_ycnt*2);
+    dsp_ip->dsp_tiles = NULL;
+    dsp_ip->dsp_tile_shift = 0;
+
+    if ((size_t)dsp_ip->dsp_mp->buflen != (size_t)dsp_ip->dsp_xcnt*dsp_ip->dsp_ycnt*2) {
+	/* not a plain array of samples, may be a tiled file */
+	if (get_tiled_data(dsp_ip, mf) == 0)
+	    return 0;
+
+	bu_log("DSP buffer wrong size: %lu s/b %zu ",
+	       (long unsigned int)dsp_ip->dsp_mp->buflen, (size_t)dsp_ip->dsp_xcnt*dsp_ip->dsp_ycnt*2);
 	return -1;
     }
 
@@ -4168,6 +4504,7 @@ dsp_get_data(struct rt_dsp_internal *dsp_ip, const mat_t mat, const struct db_i
 
     dsp_ip->dsp_mp = (struct bu_mapped_file *)NULL;
     dsp_ip->dsp_buf = NULL;
+    dsp_ip->dsp_tiles = NULL;
 
     return 1;
 }
@@ -4552,6 +4889,7 @@ rt_dsp_ifree(struct rt_db_internal *ip)
 
     dsp_ip->magic = 0;			/* sanity */
     dsp_ip->dsp_mp = (struct bu_mapped_file *)0;
+    dsp_ip->dsp_tiles = NULL;
 
     if (BU_VLS_IS_INITIALIZED(&dsp_ip->dsp_name))
 	bu_vls_free(&dsp_ip->dsp_name);
@@ -25,11 +25,59 @@
 #ifndef LIBRT_PRIMITIVES_DSP_DSP_H
 #define LIBRT_PRIMITIVES_DSP_DSP_H
 
+/*
+ * Tiled data file layout.  Rather than the usual row-major array of
+ * samples, the file holds a header, a table of the lowest and highest
+ * elevation in each tile and then the tiles themselves, each a
+ * row-major square of (1 << shift) samples on a side.  All values are
+ * in network order.
+ *
+ *	uint32	magic, version, xcnt, ycnt, shift, reserved
+ *	uint16	min, max		(for each tile, row by row)
+ *		padding up to DSP_TILED_ALIGN
+ *	uint16	samples			(for each tile, row by row)
+ *
+ * The min/max of a tile covers the cells whose lower left corner lies
+ * in the tile, i.e. one extra row and column of samples.  Tiles on
+ * the right and top edges are padded out to full size.  This lets the
+ * data be used straight from the mapped file, and lets prep bound each
+ * tile without reading its samples.
+ */
+#define DSP_TILED_MAGIC 0x44535054	/* "DSPT" */
+#define DSP_TILED_VERSION 1
+#define DSP_TILED_HDR_LEN 24
+#define DSP_TILED_ALIGN 4096		/* tiles start on a page boundary */
+#define DSP_TILE_SHIFT 6		/* tiles written by "dsp tile" are 64 wide */
+
+/* tiles along each axis of a tiled dsp */
+#define DSP_TILES_X(_p) ((((size_t)(_p)->dsp_xcnt - 1) >> (_p)->dsp_tile_shift) + 1)
+#define DSP_TILES_Y(_p) ((((size_t)(_p)->dsp_ycnt - 1) >> (_p)->dsp_tile_shift) + 1)
+
+/* offset of the first tile in a tiled data file */
+#define DSP_TILED_DATA_OFF(_ntiles) \
+	((DSP_TILED_HDR_LEN + (size_t)(_ntiles) * 4 + DSP_TILED_ALIGN - 1) / DSP_TILED_ALIGN * DSP_TILED_ALIGN)
+
+/* access to a sample in tiled data */
+#define DSP_TILED(_p, _x, _y) dsp_tiled_sample((_p), (size_t)(_x), (size_t)(_y))
+
+static inline unsigned short
+dsp_tiled_sample(const struct rt_dsp_internal *p, size_t x, size_t y)
+{
+    size_t shift = p->dsp_tile_shift;
+    size_t mask = ((size_t)1 << shift) - 1;
+    size_t tile = (y >> shift) * DSP_TILES_X(p) + (x >> shift);
+    const unsigned char *cp = p->dsp_tiles
+	+ ((((tile << shift) + (y & mask)) << shift) + (x & mask)) * 2;
+
+    return (unsigned short)((cp[0] << 8) | cp[1]);
+}
+
 /* access to the DSP data array */
 # define DSP(_p, _x, _y) (						\
+	((_p) && (_p)->dsp_tiles) ? DSP_TILED(_p, _x, _y) :		\
 	((_p) && (_p)->dsp_buf) ?					\
 	((unsigned short *)((_p)->dsp_buf))[				\
-	    (_y) * ((struct rt_dsp_internal *)_p)->dsp_xcnt + (_x)	\
+	    (size_t)(_y) * ((struct rt_dsp_internal *)_p)->dsp_xcnt + (_x)	\
 	    ] : 0)
 
 #endif /* LIBRT_PRIMITIVES_DSP_DSP_H */
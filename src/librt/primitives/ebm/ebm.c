@@ -43,6 +43,7 @@
 #include "rt/geom.h"
 #include "raytrace.h"
 #include "../fixpt.h"
+#include "../brickmap.h"
 #include "../../librt_private.h"
 
 
@@ -55,6 +56,7 @@ struct rt_ebm_specific {
     vect_t ebm_origin;	/* local coords of grid origin (0, 0, 0) for now */
     vect_t ebm_large;	/* local coords of XYZ max */
     mat_t ebm_mat;	/* model to ideal space */
+    struct rt_brickmap ebm_bricks;	/* min/max pyramid over the bitmap */
 };
 
 
@@ -466,11 +468,40 @@ rt_ebm_dda(register struct xray *rp, struct soltab *stp, struct application *ap,
     if (RT_G_DEBUG&RT_DEBUG_EBM)bu_log("Exit t[X]=%g, t[Y]=%g\n", t[X], t[Y]);
 
     inside = 0;
+    igrid[Z] = 0;
 
     while (t0 < tmax) {
 	int val;
 	struct seg *segp;
 
+	/* Step straight over any brick of cells that are all set
+	 * while inside, or all clear while outside.
+	 */
+	if (ebmp->ebm_bricks.nlevels
+	    && igrid[X] < ebmp->ebm_i.xdim && igrid[Y] < ebmp->ebm_i.ydim)
+	{
+	    int shift = rt_brickmap_uniform(&ebmp->ebm_bricks, igrid, 1, 255, inside);
+	    if (shift >= 0) {
+		size_t steps[3];
+
+		in_index = rt_brickmap_exit(2, (size_t)shift, rp->r_dir, t, delta, igrid, steps, &t0);
+		for (j = X; j <= Y; j++) {
+		    t[j] += steps[j] * delta[j];
+		    if (rp->r_dir[j] > 0)
+			igrid[j] += steps[j];
+		    else
+			igrid[j] -= steps[j];
+		}
+		if (RT_G_DEBUG&RT_DEBUG_EBM)bu_log("skipped %d wide brick to [%zu %zu] at %g\n",
+						1 << shift, igrid[X], igrid[Y], t0);
+
+		/* past the edge of the bitmap, the ray is done */
+		if (igrid[X] >= ebmp->ebm_i.xdim || igrid[Y] >= ebmp->ebm_i.ydim)
+		    break;
+		continue;
+	    }
+	}
+
 	/* find minimum exit t value */
 	out_index = t[X] < t[Y] ? X : Y;
 
@@ -1121,16 +1152,12 @@ rt_ebm_bbox(struct rt_db_internal *ip, point_t *min, point_t *max, const struct
 
 
 /**
- * Returns -
- * 0 OK
- * !0 Failure
- *
- * Implicit return -
- * A struct rt_ebm_specific is created, and its address is stored
- * in stp->st_specific for use by rt_ebm_shot().
+ * Everything rt_ebm_prep() does except building the brick pyramid,
+ * shared with rt_ebm_prep_serialize() which reads the pyramid back
+ * from the prep cache instead.
  */
-int
-rt_ebm_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
+static void
+ebm_prep_specific(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
 {
     struct rt_ebm_internal *eip;
     register struct rt_ebm_specific *ebmp;
@@ -1177,11 +1204,96 @@ rt_ebm_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     VADD2SCALE(stp->st_center, stp->st_min, stp->st_max, 0.5);
     VSCALE(radvec, diam, 0.5);
     stp->st_aradius = stp->st_bradius = MAGNITUDE(radvec);
+}
+
+
+/**
+ * Returns -
+ * 0 OK
+ * !0 Failure
+ *
+ * Implicit return -
+ * A struct rt_ebm_specific is created, and its address is stored
+ * in stp->st_specific for use by rt_ebm_shot().
+ */
+int
+rt_ebm_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
+{
+    register struct rt_ebm_specific *ebmp;
+    size_t dim[3];
+
+    ebm_prep_specific(stp, ip, rtip);
+    ebmp = (struct rt_ebm_specific *)stp->st_specific;
+
+    /* Summarize the bitmap so rt_ebm_dda() can skip uniform regions */
+    if ((ebmp->ebm_i.datasrc == RT_EBM_SRC_FILE && ebmp->ebm_i.mp && ebmp->ebm_i.mp->apbuf)
+	|| (ebmp->ebm_i.datasrc == RT_EBM_SRC_OBJ && ebmp->ebm_i.buf))
+    {
+	VSET(dim, ebmp->ebm_i.xdim, ebmp->ebm_i.ydim, 1);
+	rt_brickmap_build(&ebmp->ebm_bricks, 2, dim, bit(&ebmp->ebm_i, 0, 0),
+			  ebmp->ebm_i.xdim + BIT_XWIDEN*2, 0);
+    }
 
     return 0;		/* OK */
 }
 
 
+/**
+ * Store or restore the brick pyramid in the librt prep cache.  Only
+ * bitmaps read from a file are cached, with the file's size and time
+ * stamp recorded to tell when the pyramid is stale.
+ */
+int
+rt_ebm_prep_serialize(struct soltab *stp, const struct rt_db_internal *ip, struct bu_external *external, size_t *version)
+{
+    const size_t current_version = 0;
+    struct rt_ebm_internal *eip;
+    struct rt_ebm_specific *ebmp;
+    struct bu_mapped_file *mp;
+    struct rt_brickmap bricks;
+    int64_t stamp[2];
+    size_t dim[3];
+
+    RT_CK_SOLTAB(stp);
+    RT_CK_DB_INTERNAL(ip);
+    BU_CK_EXTERNAL(external);
+
+    eip = (struct rt_ebm_internal *)ip->idb_ptr;
+    RT_EBM_CK_MAGIC(eip);
+
+    /* prep takes the mapped file away from the internal form */
+    ebmp = (struct rt_ebm_specific *)stp->st_specific;
+    mp = ebmp ? ebmp->ebm_i.mp : eip->mp;
+    if (eip->datasrc != RT_EBM_SRC_FILE || !mp || !mp->apbuf)
+	return 1;
+    stamp[0] = (int64_t)mp->buflen;
+    stamp[1] = (int64_t)mp->modtime;
+
+    if (ebmp) {
+	/* export to external */
+	if (!ebmp->ebm_bricks.nlevels)
+	    return 1;
+	rt_brickmap_export(external, &ebmp->ebm_bricks, stamp);
+	*version = current_version;
+	return 0;
+    }
+
+    /* load from external */
+    if (*version != current_version)
+	return 1;
+
+    VSET(dim, eip->xdim, eip->ydim, 1);
+    if (rt_brickmap_import(&bricks, external, 2, dim, stamp) < 0)
+	return 1;
+
+    ebm_prep_specific(stp, (struct rt_db_internal *)ip, stp->st_rtip);
+    ebmp = (struct rt_ebm_specific *)stp->st_specific;
+    ebmp->ebm_bricks = bricks;	/* struct copy */
+
+    return 0;
+}
+
+
 void
 rt_ebm_print(register const struct soltab *stp)
 {
@@ -1315,6 +1427,7 @@ rt_ebm_free(struct soltab *stp)
 	(struct rt_ebm_specific *)stp->st_specific;
 
     bu_close_mapped_file(ebmp->ebm_i.mp);
+    rt_brickmap_free(&ebmp->ebm_bricks);
 
     BU_PUT(ebmp, struct rt_ebm_specific);
 }
@@ -39,7 +39,7 @@ rt_obj_curve(struct curvature *cvp, struct hit *hitp, struct soltab *stp)
     if (id < 0)
 	return -2;
 
-    ft = &OBJ[id];
+    ft = (stp->st_meth) ? stp->st_meth : &OBJ[id];
     if (!ft)
 	return -3;
     if (!ft->ft_curve)
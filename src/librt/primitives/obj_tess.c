@@ -21,8 +21,31 @@
 #include "common.h"
 
 
+#include "bu/parallel.h"
 #include "bn.h"
 #include "raytrace.h"
+#include "../cache.h"
+
+
+/* tessellations are cached process-wide, opened on first use */
+static struct rt_cache *
+obj_tess_cache(void)
+{
+    static int opened = 0;
+    static struct rt_cache *cache = NULL;
+    struct rt_cache *ret;
+    int sem = bu_semaphore_register("SEM_CACHE_TESS");
+
+    bu_semaphore_acquire(sem);
+    if (!opened) {
+	cache = rt_cache_open();
+	opened = 1;
+    }
+    ret = cache;
+    bu_semaphore_release(sem);
+
+    return ret;
+}
 
 
 int
@@ -50,7 +73,7 @@ rt_obj_tess(struct nmgregion **r, struct model *m, struct rt_db_internal *ip, co
     if (!ft->ft_tessellate)
 	return -4;
 
-    return ft->ft_tessellate(r, m, ip, ttol, tol);
+    return rt_cache_tess(obj_tess_cache(), r, m, ip, ttol, tol);
 }
 
 
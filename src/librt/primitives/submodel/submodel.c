@@ -174,6 +174,7 @@ rt_submodel_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rti
     sub_rtip->useair = rtip->useair;
     sub_rtip->rti_dont_instance = rtip->rti_dont_instance;
     sub_rtip->rti_hasty_prep = rtip->rti_hasty_prep;
+    sub_rtip->rti_instance_prep = rtip->rti_instance_prep;
     sub_rtip->rti_tol = rtip->rti_tol;	/* struct copy */
     sub_rtip->rti_ttol = rtip->rti_ttol;	/* struct copy */
 
@@ -783,7 +783,7 @@ const struct rt_functab OBJ[] = {
 	NULL, /* find_selections */
 	NULL, /* evaluate_selection */
 	NULL, /* process_selection */
-	NULL, /* serialize */
+	RTFUNCTAB_FUNC_PREP_SERIALIZE_CAST(rt_ebm_prep_serialize),
 	NULL, /* label */
 	NULL  /* perturb */
     },
@@ -831,7 +831,7 @@ const struct rt_functab OBJ[] = {
 	NULL, /* find_selections */
 	NULL, /* evaluate_selection */
 	NULL, /* process_selection */
-	NULL, /* serialize */
+	RTFUNCTAB_FUNC_PREP_SERIALIZE_CAST(rt_vol_prep_serialize),
 	NULL, /* label */
 	NULL  /* perturb */
     },
@@ -43,6 +43,7 @@
 #include "raytrace.h"
 
 #include "../fixpt.h"
+#include "../brickmap.h"
 
 
 /*
@@ -59,6 +60,7 @@ struct rt_vol_specific {
     mat_t vol_mat;	/* model to ideal space */
     vect_t vol_origin;	/* local coords of grid origin (0, 0, 0) for now */
     vect_t vol_large;	/* local coords of XYZ max */
+    struct rt_brickmap vol_bricks;	/* min/max pyramid over the map */
 };
 #define VOL_NULL ((struct rt_vol_specific *)0)
 
@@ -305,6 +307,45 @@ rt_vol_shot(struct soltab *stp, register struct xray *rp, struct application *ap
 	int val;
 	struct seg *segp;
 
+	/* Step straight over any brick of cells that are all solid
+	 * while inside, or all empty while outside, as nothing can
+	 * happen in them.
+	 */
+	if (volp->vol_bricks.nlevels
+	    && igrid[X] >= 0 && (size_t)igrid[X] < volp->vol_i.xdim
+	    && igrid[Y] >= 0 && (size_t)igrid[Y] < volp->vol_i.ydim
+	    && igrid[Z] >= 0 && (size_t)igrid[Z] < volp->vol_i.zdim)
+	{
+	    size_t cell[3];
+	    int shift;
+
+	    cell[X] = (size_t)igrid[X];
+	    cell[Y] = (size_t)igrid[Y];
+	    cell[Z] = (size_t)igrid[Z];
+	    shift = rt_brickmap_uniform(&volp->vol_bricks, cell, volp->vol_i.lo, volp->vol_i.hi, inside);
+	    if (shift >= 0) {
+		size_t steps[3];
+
+		in_axis = rt_brickmap_exit(3, (size_t)shift, rp->r_dir, t, delta, cell, steps, &t0);
+		for (j = X; j <= Z; j++) {
+		    t[j] += steps[j] * delta[j];
+		    if (rp->r_dir[j] > 0)
+			igrid[j] += (int)steps[j];
+		    else
+			igrid[j] -= (int)steps[j];
+		}
+		if (RT_G_DEBUG&RT_DEBUG_VOL)bu_log("skipped %d wide brick to [%d %d %d] at %g\n",
+						1 << shift, igrid[X], igrid[Y], igrid[Z], t0);
+
+		/* past the edge of the grid, the ray is done */
+		if (igrid[X] < 0 || (size_t)igrid[X] >= volp->vol_i.xdim
+		    || igrid[Y] < 0 || (size_t)igrid[Y] >= volp->vol_i.ydim
+		    || igrid[Z] < 0 || (size_t)igrid[Z] >= volp->vol_i.zdim)
+		    break;
+		continue;
+	    }
+	}
+
 	/* find minimum exit t value */
 	if (t[X] < t[Y]) {
 	    if (t[Z] < t[X]) {
@@ -968,16 +1009,12 @@ rt_vol_bbox(struct rt_db_internal *ip, point_t *min, point_t *max, const struct
 
 
 /**
- * Returns -
- * 0 OK
- * !0 Failure
- *
- * Implicit return -
- * A struct rt_vol_specific is created, and its address is stored
- * in stp->st_specific for use by rt_vol_shot().
+ * Everything rt_vol_prep() does except building the brick pyramid,
+ * shared with rt_vol_prep_serialize() which reads the pyramid back
+ * from the prep cache instead.
  */
-int
-rt_vol_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
+static int
+vol_prep_specific(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
 {
     struct rt_vol_internal *vip;
     register struct rt_vol_specific *volp;
@@ -1027,6 +1064,92 @@ rt_vol_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
 }
 
 
+/**
+ * Returns -
+ * 0 OK
+ * !0 Failure
+ *
+ * Implicit return -
+ * A struct rt_vol_specific is created, and its address is stored
+ * in stp->st_specific for use by rt_vol_shot().
+ */
+int
+rt_vol_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
+{
+    register struct rt_vol_specific *volp;
+    size_t dim[3];
+
+    if (vol_prep_specific(stp, ip, rtip))
+	return 1;
+    volp = (struct rt_vol_specific *)stp->st_specific;
+
+    /* Summarize the map so rt_vol_shot() can skip uniform regions */
+    if (volp->vol_i.map) {
+	VSET(dim, volp->vol_i.xdim, volp->vol_i.ydim, volp->vol_i.zdim);
+	rt_brickmap_build(&volp->vol_bricks, 3, dim, &VOL(&volp->vol_i, 0, 0, 0),
+			  volp->vol_i.xdim + VOL_XWIDEN*2,
+			  (volp->vol_i.xdim + VOL_XWIDEN*2) * (volp->vol_i.ydim + VOL_YWIDEN*2));
+    }
+
+    return 0;		/* OK */
+}
+
+
+/**
+ * Store or restore the brick pyramid in the librt prep cache.  Only
+ * volumes read from a file are cached, as the file's size and time
+ * stamp are recorded with the pyramid to tell when it is stale.  The
+ * voxels themselves are still read at import time.
+ */
+int
+rt_vol_prep_serialize(struct soltab *stp, const struct rt_db_internal *ip, struct bu_external *external, size_t *version)
+{
+    const size_t current_version = 0;
+    struct rt_vol_internal *vip;
+    struct rt_vol_specific *volp;
+    struct rt_brickmap bricks;
+    int64_t stamp[2];
+    size_t dim[3];
+
+    RT_CK_SOLTAB(stp);
+    RT_CK_DB_INTERNAL(ip);
+    BU_CK_EXTERNAL(external);
+
+    vip = (struct rt_vol_internal *)ip->idb_ptr;
+    RT_VOL_CK_MAGIC(vip);
+
+    if (vip->datasrc != RT_VOL_SRC_FILE || rt_brickmap_stamp(vip->name, stamp) < 0)
+	return 1;
+
+    if (stp->st_specific) {
+	/* export to external */
+	volp = (struct rt_vol_specific *)stp->st_specific;
+	if (!volp->vol_bricks.nlevels)
+	    return 1;
+	rt_brickmap_export(external, &volp->vol_bricks, stamp);
+	*version = current_version;
+	return 0;
+    }
+
+    /* load from external */
+    if (*version != current_version || !vip->map)
+	return 1;
+
+    VSET(dim, vip->xdim, vip->ydim, vip->zdim);
+    if (rt_brickmap_import(&bricks, external, 3, dim, stamp) < 0)
+	return 1;
+
+    if (vol_prep_specific(stp, (struct rt_db_internal *)ip, stp->st_rtip)) {
+	rt_brickmap_free(&bricks);
+	return 1;
+    }
+    volp = (struct rt_vol_specific *)stp->st_specific;
+    volp->vol_bricks = bricks;	/* struct copy */
+
+    return 0;
+}
+
+
 void
 rt_vol_print(register const struct soltab *stp)
 {
@@ -1131,6 +1254,7 @@ rt_vol_free(struct soltab *stp)
 	bu_free((char *)volp->vol_i.map, "vol_map");
 	volp->vol_i.map = NULL; /* sanity */
     }
+    rt_brickmap_free(&volp->vol_bricks);
     BU_PUT(volp, struct rt_vol_specific);
 }
 
@@ -84,6 +84,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <string.h>
 #include <stdlib.h>
@@ -148,6 +149,7 @@ struct list_client_data_t {
     struct db_i *dbip;
     struct bu_ptbl *full_paths;
     int flags;
+    struct resource *resp;
 };
 
 
@@ -252,7 +254,7 @@ db_fullpath_list(struct db_full_path *path, void *client_data)
 	struct rt_db_internal in;
 	struct rt_comb_internal *comb;
 
-	if (rt_db_get_internal(&in, dp, lcd->dbip, NULL, &rt_uniresource) < 0)
+	if (rt_db_get_internal(&in, dp, lcd->dbip, NULL, lcd->resp) < 0)
 	    return;
 
 	std::unordered_map<std::string, int> c_inst_map;
@@ -263,6 +265,20 @@ db_fullpath_list(struct db_full_path *path, void *client_data)
 }
 
 
+/**
+ * Return the resource to use for database reads made while evaluating
+ * a node.  Nodes evaluated by the parallel executor carry their own
+ * per-thread resource.
+ */
+static struct resource *
+search_resource(struct db_node_t *db_node)
+{
+    if (db_node && db_node->resp)
+	return db_node->resp;
+    return &rt_uniresource;
+}
+
+
 static struct db_plan_t *
 palloc(enum db_search_ntype t, int (*f)(struct db_plan_t *, struct db_node_t *, struct db_i *, struct bu_ptbl *), struct bu_ptbl *p)
 {
@@ -359,6 +375,90 @@ find_execute_nested_plans(struct db_i *dbip, struct bu_ptbl *results, struct db_
 }
 
 
+/*
+ * Nested -above/-below plans are evaluated over and over on the same
+ * objects as the search visits every path containing them.  When the
+ * nested plan only looks at the object itself (name, type, attributes,
+ * etc.) and not at the path leading to it, its result is remembered
+ * per directory entry.  Caches are per thread, so no locking is needed.
+ */
+struct _db_search_memo {
+    std::unordered_map<const struct db_plan_t *, int> dp_only;
+    std::unordered_map<const struct db_plan_t *, std::unordered_map<const struct directory *, int>> nested;
+    std::unordered_map<const struct db_plan_t *, std::unordered_map<const struct directory *, int>> above;
+};
+
+
+/* Returns 1 if the result of the plan chain depends only on the
+ * current directory entry and not on the path or search output. */
+static int
+plan_is_dp_only(const struct db_plan_t *plan)
+{
+    const struct db_plan_t *p;
+    for (p = plan; p; p = p->next) {
+	switch (p->type) {
+	    case N_NAME:
+	    case N_INAME:
+	    case N_ATTR:
+	    case N_STDATTR:
+	    case N_PARAM:
+	    case N_TYPE:
+	    case N_SIZE:
+	    case N_NNODES:
+		break;
+	    case N_NOT:
+	    case N_EXPR:
+		if (!plan_is_dp_only(p->p_un._p_data[0]))
+		    return 0;
+		break;
+	    case N_OR:
+		if (!plan_is_dp_only(p->p_un._p_data[0]) || !plan_is_dp_only(p->p_un._p_data[1]))
+		    return 0;
+		break;
+	    case N_ABOVE:
+		/* only depends on the subtree below the object */
+		if (!plan_is_dp_only(p->p_un._bl_data[0]))
+		    return 0;
+		break;
+	    default:
+		return 0;
+	}
+    }
+    return 1;
+}
+
+
+static int
+memo_dp_only(struct _db_search_memo *memo, const struct db_plan_t *plan)
+{
+    std::unordered_map<const struct db_plan_t *, int>::iterator d_it = memo->dp_only.find(plan);
+    if (d_it != memo->dp_only.end())
+	return d_it->second;
+
+    int dp_only = plan_is_dp_only(plan);
+    memo->dp_only[plan] = dp_only;
+    return dp_only;
+}
+
+
+static int
+find_execute_nested_plans_memo(struct db_i *dbip, struct bu_ptbl *results, struct db_node_t *db_node, struct db_plan_t *plan)
+{
+    struct directory *dp = DB_FULL_PATH_CUR_DIR(db_node->path);
+    if (!db_node->memo || !dp || !memo_dp_only(db_node->memo, plan))
+	return find_execute_nested_plans(dbip, results, db_node, plan);
+
+    std::unordered_map<const struct directory *, int> &dmap = db_node->memo->nested[plan];
+    std::unordered_map<const struct directory *, int>::iterator r_it = dmap.find(dp);
+    if (r_it != dmap.end())
+	return r_it->second;
+
+    int state = find_execute_nested_plans(dbip, results, db_node, plan);
+    dmap[dp] = state;
+    return state;
+}
+
+
 /*
  * -below expression functions --
  *
@@ -377,12 +477,18 @@ f_below(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, st
     db_dup_full_path(&parent_path, db_node->path);
     DB_FULL_PATH_POP(&parent_path);
     curr_node.path = &parent_path;
+    curr_node.full_paths = db_node->full_paths;
+    curr_node.path_idx = -1;
+    curr_node.flags = db_node->flags;
+    curr_node.matched_filters = 1;
+    curr_node.resp = db_node->resp;
+    curr_node.memo = db_node->memo;
     distance = db_node->path->fp_len - parent_path.fp_len;
 
     while ((parent_path.fp_len > 0) && (state == 0) && !(db_node->flags & DB_SEARCH_FLAT)) {
 	distance++;
 	if ((distance <= plan->max_depth) && (distance >= plan->min_depth)) {
-	    state += find_execute_nested_plans(dbip, results, &curr_node, plan->p_un._ab_data[0]);
+	    state += find_execute_nested_plans_memo(dbip, results, &curr_node, plan->p_un._ab_data[0]);
 	}
 	DB_FULL_PATH_POP(&parent_path);
     }
@@ -410,39 +516,83 @@ c_below(char *UNUSED(ignore), char ***UNUSED(ignored), int UNUSED(unused), struc
  * objects below the current object in the tree.
  */
 static int
-f_above(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, struct bu_ptbl *UNUSED(results))
+f_above_scan(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip)
 {
     int i = 0;
-    int state = 0;
+    int start = 0;
     struct db_node_t curr_node;
     struct bu_ptbl *full_paths = db_node->full_paths;
 
     unsigned int f_path_len = db_node->path->fp_len;
 
-    for (i = 0; i < (int)BU_PTBL_LEN(full_paths); i++) {
+    /* full_paths is built depth first, so when we know where this
+     * node's path is in the table its subtree is the run of longer
+     * paths immediately following it. */
+    if (db_node->path_idx >= 0)
+	start = db_node->path_idx + 1;
+
+    for (i = start; i < (int)BU_PTBL_LEN(full_paths); i++) {
 	struct db_full_path *this_path = (struct db_full_path *)BU_PTBL_GET(full_paths, i);
 
+	if (db_node->path_idx >= 0 && this_path->fp_len <= f_path_len)
+	    break;
+
 	/* Check depth criteria by comparing to db_node->path - if OK execute nested plans */
-	if (this_path->fp_len > f_path_len && db_full_path_match_top(db_node->path, this_path)) {
+	if (this_path->fp_len > f_path_len && (db_node->path_idx >= 0 || db_full_path_match_top(db_node->path, this_path))) {
 	    int relative_depth = this_path->fp_len - f_path_len;
 
 	    if (relative_depth >= plan->min_depth && relative_depth <= plan->max_depth) {
 		curr_node.path = this_path;
 		curr_node.flags = db_node->flags;
 		curr_node.full_paths = full_paths;
+		curr_node.path_idx = i;
+		curr_node.matched_filters = 1;
+		curr_node.resp = db_node->resp;
+		curr_node.memo = db_node->memo;
 
-		state = find_execute_nested_plans(dbip, NULL, &curr_node, plan->p_un._bl_data[0]);
-		if (state)
+		if (find_execute_nested_plans_memo(dbip, NULL, &curr_node, plan->p_un._bl_data[0]))
 		    return 1;
 	    }
 	}
     }
 
-    db_node->matched_filters = 0;
     return 0;
 }
 
 
+static int
+f_above(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, struct bu_ptbl *UNUSED(results))
+{
+    int state = 0;
+    struct directory *dp = DB_FULL_PATH_CUR_DIR(db_node->path);
+
+    if (!db_node->full_paths) {
+	db_node->matched_filters = 0;
+	return 0;
+    }
+
+    /* Whether anything below an object matches only depends on the
+     * object itself if the nested plan does - in that case reuse
+     * answers from other instances of the same object. */
+    if (db_node->memo && dp && memo_dp_only(db_node->memo, plan->p_un._bl_data[0])) {
+	std::unordered_map<const struct directory *, int> &dmap = db_node->memo->above[plan];
+	std::unordered_map<const struct directory *, int>::iterator r_it = dmap.find(dp);
+	if (r_it != dmap.end()) {
+	    state = r_it->second;
+	} else {
+	    state = f_above_scan(plan, db_node, dbip);
+	    dmap[dp] = state;
+	}
+    } else {
+	state = f_above_scan(plan, db_node, dbip);
+    }
+
+    if (!state)
+	db_node->matched_filters = 0;
+    return state;
+}
+
+
 static int
 c_above(char *UNUSED(ignore), char ***UNUSED(ignored), int UNUSED(unused), struct db_plan_t **resultplan, int *UNUSED(db_search_isoutput), struct bu_ptbl *tbl, struct _db_search_ctx *UNUSED(ctx))
 {
@@ -826,7 +976,7 @@ f_objparam(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip,
     }
 
     RT_DB_INTERNAL_INIT(&in);
-    if (rt_db_get_internal(&in, dp, dbip, (fastf_t *)NULL, &rt_uniresource) < 0) {
+    if (rt_db_get_internal(&in, dp, dbip, (fastf_t *)NULL, search_resource(db_node)) < 0) {
 	rt_db_free_internal(&in);
 	db_node->matched_filters = 0;
 	return 0;
@@ -1066,7 +1216,7 @@ f_type(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, str
 
     }
 
-    if (rt_db_get_internal(&intern, dp, dbip, (fastf_t *)NULL, &rt_uniresource) < 0)
+    if (rt_db_get_internal(&intern, dp, dbip, (fastf_t *)NULL, search_resource(db_node)) < 0)
 	return 0;
     if (intern.idb_major_type != DB5_MAJORTYPE_BRLCAD) {
 	rt_db_free_internal(&intern);
@@ -1655,7 +1805,7 @@ f_matrix(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, s
 
 	if (dp->d_flags & RT_DIR_COMB) {
 	    struct rt_db_internal intern;
-	    if (rt_db_get_internal(&intern, dp, dbip, (fastf_t *)NULL, &rt_uniresource) > 0) {
+	    if (rt_db_get_internal(&intern, dp, dbip, (fastf_t *)NULL, search_resource(db_node)) > 0) {
 		struct rt_comb_internal *comb = (struct rt_comb_internal *)intern.idb_ptr;
 		if (comb->tree != NULL) {
 		    child_matrix(comb->tree, cdp->d_namep, &mat);
@@ -1752,7 +1902,7 @@ f_nnodes(struct db_plan_t *plan, struct db_node_t *db_node, struct db_i *dbip, s
     }
 
     if (dp->d_flags & RT_DIR_COMB) {
-	rt_db_get_internal(&in, dp, dbip, (fastf_t *)NULL, &rt_uniresource);
+	rt_db_get_internal(&in, dp, dbip, (fastf_t *)NULL, search_resource(db_node));
 	comb = (struct rt_comb_internal *)in.idb_ptr;
 	if (comb->tree == NULL) {
 	    node_count = 0;
@@ -2568,6 +2718,137 @@ db_search_free(struct bu_ptbl *search_results)
 }
 
 
+/* Shared state for evaluating a plan over a set of starting paths */
+struct db_search_state {
+    struct db_i *dbip;
+    struct db_plan_t *plan;
+    int flags;
+    struct directory **paths;
+    int path_cnt;
+    struct bu_ptbl *results;		/* per-path result tables (parallel only) */
+    int *counts;			/* per-path match counts (parallel only) */
+    struct resource *resources;		/* per-thread resources (parallel only) */
+    int curr;				/* next path to process, semaphored */
+};
+
+
+static int
+db_search_plan_has_exec(struct bu_ptbl *plans)
+{
+    size_t i;
+    for (i = 0; i < BU_PTBL_LEN(plans); i++) {
+	struct db_plan_t *p = (struct db_plan_t *)BU_PTBL_GET(plans, i);
+	if (p->type == N_EXEC)
+	    return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * Evaluate the plan over the path_v[i] object and everything below
+ * it.  Each starting object gets its own table of full paths, which is
+ * all -above needs to see, so starting objects can be handled
+ * independently of each other.  Returns the number of matches.
+ */
+static int
+db_search_path(struct db_search_state *s, int i, struct bu_ptbl *results, struct resource *resp, struct _db_search_memo *memo)
+{
+    int j;
+    int result_cnt = 0;
+    struct directory *curr_dp = s->paths[i];
+    struct db_full_path *start_path = NULL;
+    struct bu_ptbl *full_paths = NULL;
+    struct list_client_data_t lcd;
+
+    if (curr_dp == RT_DIR_NULL)
+	return 0;
+
+    if (!(s->flags & DB_SEARCH_HIDDEN) && (curr_dp->d_flags & RT_DIR_HIDDEN))
+	return 0;
+
+    BU_ALLOC(start_path, struct db_full_path);
+    db_full_path_init(start_path);
+    db_add_node_to_full_path(start_path, curr_dp);
+    /* by convention, a top level node is "unioned" into the global database */
+    DB_FULL_PATH_SET_CUR_BOOL(start_path, 2);
+
+    /* For a flat search, we don't need to build a table of paths -
+     * just run the filters on the path */
+    if (s->flags & DB_SEARCH_FLAT) {
+	struct db_node_t curr_node;
+	curr_node.path = start_path;
+	curr_node.full_paths = NULL;
+	curr_node.path_idx = -1;
+	curr_node.flags = s->flags;
+	curr_node.matched_filters = 1;
+	curr_node.resp = resp;
+	curr_node.memo = memo;
+	find_execute_plans(s->dbip, results, &curr_node, s->plan);
+	result_cnt += curr_node.matched_filters;
+	db_free_full_path(start_path);
+	bu_free(start_path, "free search path container");
+	return result_cnt;
+    }
+
+    /* Build a set of all full paths under the starting object, including
+     * the starting path itself */
+    BU_ALLOC(full_paths, struct bu_ptbl);
+    BU_PTBL_INIT(full_paths);
+    lcd.dbip = s->dbip;
+    lcd.full_paths = full_paths;
+    lcd.flags = s->flags;
+    lcd.resp = (resp) ? resp : &rt_uniresource;
+    bu_ptbl_ins(full_paths, (long *)start_path);
+    db_fullpath_list(start_path, (void **)&lcd);
+
+    for (j = 0; j < (int)BU_PTBL_LEN(full_paths); j++) {
+	struct db_node_t curr_node;
+	curr_node.path = (struct db_full_path *)BU_PTBL_GET(full_paths, j);
+	curr_node.full_paths = full_paths;
+	curr_node.path_idx = j;
+	curr_node.flags = s->flags;
+	curr_node.matched_filters = 1;
+	curr_node.resp = resp;
+	curr_node.memo = memo;
+	find_execute_plans(s->dbip, results, &curr_node, s->plan);
+	result_cnt += curr_node.matched_filters;
+    }
+
+    /* Done with the paths now - we have our answer */
+    db_search_free(full_paths);
+    bu_free(full_paths, "free search container");
+
+    return result_cnt;
+}
+
+
+static void
+db_search_worker(int cpu, void *data)
+{
+    struct db_search_state *s = (struct db_search_state *)data;
+    struct resource *resp = &s->resources[cpu];
+    struct _db_search_memo memo;
+    int i;
+
+    while (1) {
+	bu_semaphore_acquire(RT_SEM_WORKER);
+	i = s->curr++;
+	bu_semaphore_release(RT_SEM_WORKER);
+
+	if (i >= s->path_cnt)
+	    break;
+
+	if (s->results) {
+	    bu_ptbl_init(&s->results[i], 8, "search path results");
+	    s->counts[i] = db_search_path(s, i, &s->results[i], resp, &memo);
+	} else {
+	    s->counts[i] = db_search_path(s, i, NULL, resp, &memo);
+	}
+    }
+}
+
+
 int
 db_search(struct bu_ptbl *search_results,
 	  int search_flags,
@@ -2633,83 +2914,88 @@ db_search(struct bu_ptbl *search_results,
 	paths = top_level_objects;
     }
 
+    /* First, check if search_results is initialized - don't trust the caller to do it,
+     * but it's fine if they did */
+    if (search_results && search_results != BU_PTBL_NULL) {
+	if (!BU_PTBL_IS_INITIALIZED(search_results)) {
+	    BU_PTBL_INIT(search_results);
+	}
+    }
+
     /* execute the plan */
     {
-	struct bu_ptbl *full_paths = NULL;
-	struct list_client_data_t lcd;
-
-	/* First, check if search_results is initialized - don't trust the caller to do it,
-	 * but it's fine if they did */
-	if (search_results && search_results != BU_PTBL_NULL) {
-	    if (!BU_PTBL_IS_INITIALIZED(search_results)) {
-		BU_PTBL_INIT(search_results);
+	struct db_search_state state;
+	size_t ncpu = 1;
+
+	state.dbip = dbip;
+	state.plan = dbplan;
+	state.flags = search_flags;
+	state.paths = paths;
+	state.path_cnt = path_cnt;
+	state.results = NULL;
+	state.counts = NULL;
+	state.resources = NULL;
+	state.curr = 0;
+
+	/* -exec hands control to caller code that may not be thread
+	 * safe, so plans using it are always evaluated serially */
+	if (!(search_flags & DB_SEARCH_SERIAL) && path_cnt > 1 && !db_search_plan_has_exec(&dbplans)) {
+	    const char *search_ncpu = getenv("LIBRT_SEARCH_NCPU");
+	    ncpu = bu_avail_cpus();
+	    if (search_ncpu && atoi(search_ncpu) > 0)
+		ncpu = (size_t)atoi(search_ncpu);
+	    if (ncpu > MAX_PSW)
+		ncpu = MAX_PSW;
+	    if (ncpu > (size_t)path_cnt)
+		ncpu = (size_t)path_cnt;
+	}
+
+	if (ncpu < 2) {
+	    struct _db_search_memo memo;
+	    for (i = 0; i < path_cnt; i++) {
+		result_cnt += db_search_path(&state, i, search_results, NULL, &memo);
+	    }
+	} else {
+	    state.counts = (int *)bu_calloc(path_cnt, sizeof(int), "search counts");
+	    if (search_results)
+		state.results = (struct bu_ptbl *)bu_calloc(path_cnt, sizeof(struct bu_ptbl), "search results");
+	    state.resources = (struct resource *)bu_calloc(ncpu, sizeof(struct resource), "search resources");
+	    for (i = 0; i < (int)ncpu; i++) {
+		rt_init_resource(&state.resources[i], i, NULL);
 	    }
-	}
-
-	/* Build a set of all full paths under the supplied paths, including the starting
-	 * paths themselves */
-	if (!(search_flags & DB_SEARCH_FLAT)) {
-	    BU_ALLOC(full_paths, struct bu_ptbl);
-	    BU_PTBL_INIT(full_paths);
-	    lcd.dbip = dbip;
-	    lcd.full_paths = full_paths;
-	    lcd.flags = search_flags;
-	}
 
-	/* If we're doing a flat search, we can handle everything in this loop.
-	 * Otherwise, we're building a list of full paths to be handled in a
-	 * second pass. */
-	for (i = 0; i < path_cnt; i++) {
-	    struct directory *curr_dp = paths[i];
-	    struct db_full_path *start_path = NULL;
+	    bu_parallel(db_search_worker, ncpu, (void *)&state);
 
-	    if (curr_dp == RT_DIR_NULL) {
-		continue;
+	    /* Merge per-path results in input order, so the output is
+	     * the same as that of a serial search */
+	    std::unordered_set<long *> uniq_dps;
+	    int uniq = (search_flags & DB_SEARCH_FLAT || search_flags & DB_SEARCH_RETURN_UNIQ_DP);
+	    if (uniq && search_results) {
+		for (i = 0; i < (int)BU_PTBL_LEN(search_results); i++)
+		    uniq_dps.insert(BU_PTBL_GET(search_results, i));
 	    }
-
-	    if ((search_flags & DB_SEARCH_HIDDEN) || !(curr_dp->d_flags & RT_DIR_HIDDEN)) {
-
-		BU_ALLOC(start_path, struct db_full_path);
-		db_full_path_init(start_path);
-		db_add_node_to_full_path(start_path, curr_dp);
-		DB_FULL_PATH_SET_CUR_BOOL(start_path, 2);
-
-		/* For a flat search, we don't need to build a table of paths -
-		 * just run the filters on the path */
-		if (search_flags & DB_SEARCH_FLAT) {
-		    struct db_node_t curr_node;
-		    /* by convention, a top level node is "unioned" into the global database */
-		    curr_node.path = start_path;
-		    curr_node.flags = search_flags;
-		    curr_node.matched_filters = 1;
-		    curr_node.full_paths = NULL;
-		    find_execute_plans(dbip, search_results, &curr_node, dbplan);
-		    result_cnt += curr_node.matched_filters;
-		    DB_FULL_PATH_POP(start_path);
-		} else {
-		    /* by convention, a top level node is "unioned" into the global database */
-		    bu_ptbl_ins(full_paths, (long *)start_path);
-		    /* Use the initial path to tree-walk and build a set of all paths below
-		     * start_path */
-		    db_fullpath_list(start_path, (void **)&lcd);
+	    for (i = 0; i < path_cnt; i++) {
+		result_cnt += state.counts[i];
+		if (!state.results || !BU_PTBL_IS_INITIALIZED(&state.results[i]))
+		    continue;
+		for (size_t j = 0; j < BU_PTBL_LEN(&state.results[i]); j++) {
+		    long *entry = BU_PTBL_GET(&state.results[i], j);
+		    if (uniq) {
+			if (!uniq_dps.insert(entry).second)
+			    continue;
+		    }
+		    bu_ptbl_ins(search_results, entry);
 		}
+		bu_ptbl_free(&state.results[i]);
 	    }
-	}
 
-	if (!(search_flags & DB_SEARCH_FLAT)) {
-	    for (i = 0; i < (int)BU_PTBL_LEN(full_paths); i++) {
-		struct db_node_t curr_node;
-		curr_node.path = (struct db_full_path *)BU_PTBL_GET(full_paths, i);
-		curr_node.full_paths = full_paths;
-		curr_node.flags = search_flags;
-		curr_node.matched_filters = 1;
-		find_execute_plans(dbip, search_results, &curr_node, dbplan);
-		result_cnt += curr_node.matched_filters;
+	    for (i = 0; i < (int)ncpu; i++) {
+		rt_clean_resource_complete(NULL, &state.resources[i]);
 	    }
-
-	    /* Done with the paths now - we have our answer */
-	    db_search_free(full_paths);
-	    bu_free(full_paths, "free search container");
+	    bu_free(state.resources, "search resources");
+	    if (state.results)
+		bu_free(state.results, "search results");
+	    bu_free(state.counts, "search counts");
 	}
     }
 
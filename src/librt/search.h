@@ -69,12 +69,18 @@ struct _db_search_ctx {
     void *u2; /**< @brief A pointer that will be passed to the callback. */
 };
 
+/* per-thread cache of nested plan results, keyed by plan and directory pointer */
+struct _db_search_memo;
+
 /* node struct - holds data specific to each node under consideration */
 struct db_node_t {
     struct db_full_path *path;
     struct bu_ptbl *full_paths;
+    int path_idx;			/* index of path in full_paths, or -1 if not from the table */
     int flags;
     int matched_filters;
+    struct resource *resp;		/* resource for database reads (NULL for rt_uniresource) */
+    struct _db_search_memo *memo;	/* nested plan result cache (may be NULL) */
 };
 
 /* search node type */
@@ -29,6 +29,7 @@
 
 #include "raytrace.h"
 #include "bv/plot3.h"
+#include "librt_private.h"
 
 
 #define V3PT_DEPARTING_RPP(_step, _lo, _hi, _pt)			\
@@ -449,7 +450,7 @@ rt_find_backing_dist(struct rt_shootray_status *ss, struct bu_bitv *backbits) {
     fastf_t prev_dist = -1.0;
     fastf_t curr_dist = 0.0;
     point_t curr_pt;
-    union cutter *cutp;
+    const union cutter *cutp;
     struct bu_bitv *solidbits;
     struct xray ray;
     struct resource *resp;
@@ -476,7 +477,7 @@ rt_find_backing_dist(struct rt_shootray_status *ss, struct bu_bitv *backbits) {
 	/* descend into the space partitioning tree based on this
 	 * point.
 	 */
-	cutp = &ss->ap->a_rt_i->rti_CutHead;
+	cutp = RT_CUT_HEAD(ss->ap->a_rt_i);
 	while (cutp->cut_type == CUT_CUTNODE) {
 	    if (curr_pt[cutp->cn.cn_axis] >= cutp->cn.cn_point) {
 		cutp=cutp->cn.cn_r;
@@ -925,7 +926,7 @@ rt_shootray(register struct application *ap)
 
     ss.lastcut = CUTTER_NULL;
     ss.old_status = (struct rt_shootray_status *)NULL;
-    ss.curcut = &ap->a_rt_i->rti_CutHead;
+    ss.curcut = RT_CUT_HEAD(ap->a_rt_i);
 
     if (ss.curcut->cut_type == CUT_CUTNODE || ss.curcut->cut_type == CUT_BOXNODE) {
 	ss.lastcell = ss.curcut;
@@ -1472,7 +1473,7 @@ rt_cell_n_on_ray(register struct application *ap, int n)
 
     ss.lastcut = CUTTER_NULL;
     ss.old_status = (struct rt_shootray_status *)NULL;
-    ss.curcut = &ap->a_rt_i->rti_CutHead;
+    ss.curcut = RT_CUT_HEAD(ap->a_rt_i);
 
     if (ss.curcut->cut_type == CUT_CUTNODE || ss.curcut->cut_type == CUT_BOXNODE) {
 	ss.lastcell = ss.curcut;
@@ -516,6 +516,90 @@ test_cache(char *rp, long int test_num, long int obj_cnt, int do_parallel, int d
 }
 
 
+static void
+tess_counts(struct nmgregion *r, size_t *nverts, size_t *nfaces, size_t *nnorms)
+{
+    struct bu_ptbl tab = BU_PTBL_INIT_ZERO;
+
+    nmg_vertex_tabulate(&tab, &r->l.magic, &RTG.rtg_vlfree);
+    *nverts = BU_PTBL_LEN(&tab);
+    bu_ptbl_reset(&tab);
+    nmg_face_tabulate(&tab, &r->l.magic, &RTG.rtg_vlfree);
+    *nfaces = BU_PTBL_LEN(&tab);
+    bu_ptbl_reset(&tab);
+    nmg_vertexuse_normal_tabulate(&tab, &r->l.magic, &RTG.rtg_vlfree);
+    *nnorms = BU_PTBL_LEN(&tab);
+    bu_ptbl_free(&tab);
+}
+
+
+/* Tessellate an ellipsoid twice through rt_obj_tess, checking the
+ * first call stores one cache object and the second call rebuilds the
+ * same mesh from it. */
+static int
+test_tess_cache(long int test_num)
+{
+    struct bu_vls cache_dir = BU_VLS_INIT_ZERO;
+    struct rt_db_internal intern;
+    struct rt_ell_internal ell;
+    struct bg_tess_tol ttol = BG_TESS_TOL_INIT_TOL;
+    struct bn_tol tol = BN_TOL_INIT_TOL;
+    struct model *m[2];
+    struct nmgregion *r[2] = {NULL, NULL};
+    size_t nverts[2], nfaces[2], nnorms[2];
+
+    bu_vls_sprintf(&cache_dir, "%s_dir_%ld", RTC_PREFIX, test_num);
+
+    bu_setenv("LIBRT_CACHE", bu_dir(NULL, 0, BU_DIR_CURR, bu_vls_cstr(&cache_dir), NULL), 1);
+
+    if (bu_file_exists(getenv("LIBRT_CACHE"), NULL)) {
+	bu_exit(1, "Test %ld: stale test cache directory %s exists\n", test_num, getenv("LIBRT_CACHE"));
+    }
+
+    ell.magic = RT_ELL_INTERNAL_MAGIC;
+    VSET(ell.v, 1.0, 2.0, 3.0);
+    VSET(ell.a, 10.0, 0.0, 0.0);
+    VSET(ell.b, 0.0, 5.0, 0.0);
+    VSET(ell.c, 0.0, 0.0, 2.0);
+
+    RT_DB_INTERNAL_INIT(&intern);
+    intern.idb_major_type = DB5_MAJORTYPE_BRLCAD;
+    intern.idb_minor_type = ID_ELL;
+    intern.idb_type = ID_ELL;
+    intern.idb_meth = &OBJ[ID_ELL];
+    intern.idb_ptr = (void *)&ell;
+
+    for (int i = 0; i < 2; i++) {
+	m[i] = nmg_mm();
+	if (rt_obj_tess(&r[i], m[i], &intern, &ttol, &tol) < 0 || !r[i]) {
+	    bu_exit(1, "Test %ld: tessellation %d failed\n", test_num, i + 1);
+	}
+	tess_counts(r[i], &nverts[i], &nfaces[i], &nnorms[i]);
+
+	size_t cc = cache_count(bu_vls_cstr(&cache_dir), 0);
+	if (cc != 1) {
+	    bu_exit(1, "Test %ld: expected 1 cache object after tessellation %d, found %zu\n", test_num, i + 1, cc);
+	}
+    }
+
+    if (nverts[0] != nverts[1] || nfaces[0] != nfaces[1] || nnorms[0] != nnorms[1]) {
+	bu_exit(1, "Test %ld: cached tessellation has %zu vertices, %zu faces and %zu normals, expected %zu, %zu and %zu\n",
+		test_num, nverts[1], nfaces[1], nnorms[1], nverts[0], nfaces[0], nnorms[0]);
+    }
+    if (!VNEAR_EQUAL(r[0]->ra_p->min_pt, r[1]->ra_p->min_pt, tol.dist)
+	|| !VNEAR_EQUAL(r[0]->ra_p->max_pt, r[1]->ra_p->max_pt, tol.dist)) {
+	bu_exit(1, "Test %ld: cached tessellation bounds differ\n", test_num);
+    }
+
+    nmg_km(m[0]);
+    nmg_km(m[1]);
+
+    cache_cleanup(&cache_dir);
+    bu_vls_free(&cache_dir);
+    return 0;
+}
+
+
 const char *rt_cache_test_usage =
 "Usage: rt_cache 1             (Single object serial test)\n"
 "       rt_cache 2             (Single object parallel test)\n"
@@ -524,6 +608,7 @@ const char *rt_cache_test_usage =
 "       rt_cache 5 [obj_count] (Multiple distinct object serial test)\n"
 "       rt_cache 6 [obj_count] (Multiple distinct object parallel test)\n"
 "       rt_cache 7 [obj_count] (Multiple distinct objects, multiple instances in tree parallel test)\n"
+"       rt_cache 8             (Tessellation cache test)\n"
 "       rt_cache 20 [obj_count] [subprocess_count] (Multiple process identical objects test)\n"
 "       rt_cache 21 [obj_count] [subprocess_count] (Multiple process distinct objects test)\n";
 
@@ -603,6 +688,9 @@ main(int ac, char *av[])
 	case 7:
 	    /* Parallel prep API, multiple objects, non-unique content, multiple instances in tree */
 	    return test_cache(rp, test_num, obj_cnt, 1, 1, 0, 5);
+	case 8:
+	    /* Tessellation cache, 1 object */
+	    return test_tess_cache(test_num);
 	case 20:
 	    /* Multiple objects, same content, multi-process */
 	    return test_cache(rp, test_num, obj_cnt, 1, 0, subprocess_cnt, 0);
@@ -0,0 +1,345 @@
+/*                      I N S T A N C E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file instance.c
+ *
+ * Checks that sharing prep between placements of a solid
+ * (LIBRT_INSTANCE_PREP) does not change what rays hit.  A model with
+ * many rotated and moved copies of a few solids, along with some
+ * scaled copies that can not share prep, is shot with the option off
+ * and on, and every ray must see the same regions at the same
+ * distances.  Each model is also cleaned and prepped again, which
+ * must give the same hits as the first prep.
+ *
+ * Usage: rt_instance [rays]
+ */
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "bu/app.h"
+#include "bu/env.h"
+#include "bu/file.h"
+#include "bu/malloc.h"
+#include "bu/str.h"
+#include "bn/mat.h"
+#include "bn/rand.h"
+#include "bn/randmt.h"
+#include "raytrace.h"
+#include "wdb.h"
+
+#define INSTANCE_G "rt_instance_test.g"
+
+/* copies of each solid along each side of the grid */
+#define INSTANCE_GRID 6
+#define INSTANCE_SPACING 100.0
+
+/* agreement required between the two preps, in mm */
+#define INSTANCE_TOL 1.0e-3
+
+#define INSTANCE_MAX_HITS 64
+#define INSTANCE_NAMELEN 32
+
+struct instance_hits {
+    size_t n;
+    fastf_t d[INSTANCE_MAX_HITS][2];
+    char reg[INSTANCE_MAX_HITS][INSTANCE_NAMELEN];
+};
+
+
+static int
+instance_hit(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs))
+{
+    struct instance_hits *h = (struct instance_hits *)ap->a_uptr;
+    struct partition *pp;
+
+    for (pp = PartHeadp->pt_forw; pp != PartHeadp; pp = pp->pt_forw) {
+	if (h->n >= INSTANCE_MAX_HITS)
+	    break;
+	h->d[h->n][0] = pp->pt_inhit->hit_dist;
+	h->d[h->n][1] = pp->pt_outhit->hit_dist;
+	bu_strlcpy(h->reg[h->n], pp->pt_regionp->reg_name, INSTANCE_NAMELEN);
+	h->n++;
+    }
+    return 1;
+}
+
+
+static int
+instance_miss(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+
+/**
+ * Each solid is used by one region per grid cell, under a different
+ * rotation and translation in each.  Every fifth cell scales the
+ * solid as well, so it has to be prepped on its own.
+ */
+static void
+instance_mk(struct rt_wdb *wdbp)
+{
+    const char *solids[] = {"sph.s", "ell.s", "tor.s", "rcc.s", "arb.s", NULL};
+    struct wmember head, top;
+    point_t center, min, max;
+    vect_t a, b, c, h;
+    mat_t mat;
+    char name[INSTANCE_NAMELEN];
+    int i, x, y;
+
+    VSETALL(center, 0.0);
+    if (mk_sph(wdbp, "sph.s", center, 20.0) < 0)
+	bu_exit(1, "rt_instance: unable to make sph.s\n");
+    VSET(a, 30.0, 0.0, 0.0);
+    VSET(b, 0.0, 15.0, 0.0);
+    VSET(c, 0.0, 0.0, 8.0);
+    if (mk_ell(wdbp, "ell.s", center, a, b, c) < 0)
+	bu_exit(1, "rt_instance: unable to make ell.s\n");
+    VSET(h, 0.3, 0.2, 1.0);
+    VUNITIZE(h);
+    if (mk_tor(wdbp, "tor.s", center, h, 25.0, 6.0) < 0)
+	bu_exit(1, "rt_instance: unable to make tor.s\n");
+    VSET(h, 5.0, 10.0, 40.0);
+    if (mk_rcc(wdbp, "rcc.s", center, h, 12.0) < 0)
+	bu_exit(1, "rt_instance: unable to make rcc.s\n");
+    VSET(min, -15.0, -10.0, -5.0);
+    VSET(max, 20.0, 10.0, 25.0);
+    if (mk_rpp(wdbp, "arb.s", min, max) < 0)
+	bu_exit(1, "rt_instance: unable to make arb.s\n");
+
+    BU_LIST_INIT(&top.l);
+    for (i = 0; solids[i]; i++) {
+	for (y = 0; y < INSTANCE_GRID; y++) {
+	    for (x = 0; x < INSTANCE_GRID; x++) {
+		int cell = y * INSTANCE_GRID + x;
+
+		bn_mat_angles(mat, 17.0 * cell, 31.0 * i + 11.0 * y, 7.0 * x);
+		MAT_DELTAS(mat, x * INSTANCE_SPACING, y * INSTANCE_SPACING, i * INSTANCE_SPACING);
+		if (cell % 5 == 4)
+		    mat[15] = 0.8;
+
+		BU_LIST_INIT(&head.l);
+		(void)mk_addmember(solids[i], &head.l, mat, WMOP_UNION);
+		snprintf(name, INSTANCE_NAMELEN, "%s.%d.r", solids[i], cell);
+		if (mk_lcomb(wdbp, name, &head, 1, NULL, NULL, NULL, 0) < 0)
+		    bu_exit(1, "rt_instance: unable to make %s\n", name);
+		(void)mk_addmember(name, &top.l, NULL, WMOP_UNION);
+	    }
+	}
+    }
+    if (mk_lcomb(wdbp, "all", &top, 0, NULL, NULL, NULL, 0) < 0)
+	bu_exit(1, "rt_instance: unable to make all\n");
+}
+
+
+static void
+instance_load(struct rt_i *rtip)
+{
+    if (rt_gettree(rtip, "all") < 0)
+	bu_exit(1, "rt_instance: unable to load all\n");
+    rt_prep(rtip);
+}
+
+
+/**
+ * Shoot nrays random rays at the model, recording their partitions
+ * in hits.  The same rays are shot on every call.
+ */
+static void
+instance_shoot(struct rt_i *rtip, struct instance_hits *hits, size_t nrays)
+{
+    struct application ap;
+    point_t center, lo, hi;
+    fastf_t radius;
+    size_t i;
+
+    VSET(lo, -50.0, -50.0, -50.0);
+    VSET(hi, INSTANCE_GRID * INSTANCE_SPACING, INSTANCE_GRID * INSTANCE_SPACING, 5 * INSTANCE_SPACING);
+    VADD2SCALE(center, lo, hi, 0.5);
+    radius = DIST_PNT_PNT(lo, hi);
+
+    RT_APPLICATION_INIT(&ap);
+    ap.a_rt_i = rtip;
+    ap.a_hit = instance_hit;
+    ap.a_miss = instance_miss;
+
+    bn_randmt_seed(5489);
+    for (i = 0; i < nrays; i++) {
+	point_t target;
+
+	/* from a point on a sphere around the model toward a point
+	 * inside its bounding box */
+	bn_rand_sph_sample(ap.a_ray.r_pt, center, radius);
+	VSET(target,
+	     lo[X] + bn_randmt() * (hi[X] - lo[X]),
+	     lo[Y] + bn_randmt() * (hi[Y] - lo[Y]),
+	     lo[Z] + bn_randmt() * (hi[Z] - lo[Z]));
+	VSUB2(ap.a_ray.r_dir, target, ap.a_ray.r_pt);
+	VUNITIZE(ap.a_ray.r_dir);
+
+	hits[i].n = 0;
+	ap.a_uptr = (void *)&hits[i];
+	(void)rt_shootray(&ap);
+    }
+}
+
+
+/**
+ * Returns the number of rays whose partitions differ.
+ */
+static size_t
+instance_compare(const char *what, const struct instance_hits *ref, const struct instance_hits *got, size_t nrays)
+{
+    size_t i, j, bad = 0, hit = 0;
+
+    for (i = 0; i < nrays; i++) {
+	if (ref[i].n)
+	    hit++;
+	if (got[i].n != ref[i].n) {
+	    bu_log("rt_instance: %s: ray %zu has %zu partitions, expected %zu\n", what, i, got[i].n, ref[i].n);
+	    bad++;
+	    continue;
+	}
+	for (j = 0; j < ref[i].n; j++) {
+	    if (!BU_STR_EQUAL(got[i].reg[j], ref[i].reg[j])
+		|| !NEAR_EQUAL(got[i].d[j][0], ref[i].d[j][0], INSTANCE_TOL)
+		|| !NEAR_EQUAL(got[i].d[j][1], ref[i].d[j][1], INSTANCE_TOL))
+	    {
+		bu_log("rt_instance: %s: ray %zu partition %zu is %s %g to %g, expected %s %g to %g\n",
+		       what, i, j, got[i].reg[j], got[i].d[j][0], got[i].d[j][1],
+		       ref[i].reg[j], ref[i].d[j][0], ref[i].d[j][1]);
+		bad++;
+		break;
+	    }
+	}
+    }
+
+    bu_log("rt_instance: %s: %zu rays, %zu hit something, %zu disagree\n", what, nrays, hit, bad);
+    return bad;
+}
+
+
+/**
+ * Prep the model with instance prep on or off, shoot it, then clean
+ * it, prep it again and check the second prep sees the same.
+ * Returns the number of instances made, or -1 on a mismatch.
+ */
+static long
+instance_run(int instance_prep, struct instance_hits *hits, size_t nrays)
+{
+    struct instance_hits *again;
+    struct rt_i *rtip;
+    struct soltab *stp;
+    long instances = 0;
+    size_t bad;
+
+    bu_setenv("LIBRT_INSTANCE_PREP", instance_prep ? "1" : "0", 1);
+    rtip = rt_dirbuild(INSTANCE_G, NULL, 0);
+    if (rtip == RTI_NULL)
+	bu_exit(1, "rt_instance: unable to open %s\n", INSTANCE_G);
+    if (rtip->rti_instance_prep != instance_prep)
+	bu_exit(1, "rt_instance: LIBRT_INSTANCE_PREP=%d was not honored\n", instance_prep);
+
+    instance_load(rtip);
+    RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
+	if (stp->st_id == ID_NULL)
+	    instances++;
+    } RT_VISIT_ALL_SOLTABS_END;
+    instance_shoot(rtip, hits, nrays);
+
+    again = (struct instance_hits *)bu_calloc(nrays, sizeof(struct instance_hits), "instance hits");
+    rt_clean(rtip);
+    instance_load(rtip);
+    instance_shoot(rtip, again, nrays);
+    bad = instance_compare(instance_prep ? "prep again, shared" : "prep again, unshared", hits, again, nrays);
+    bu_free(again, "instance hits");
+
+    rt_free_rti(rtip);
+
+    return (bad) ? -1 : instances;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    struct rt_wdb *wdbp;
+    struct instance_hits *off, *on;
+    size_t nrays = 2000;
+    long off_n, on_n;
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (argc > 2) {
+	bu_log("Usage: %s [rays]\n", argv[0]);
+	return 1;
+    }
+    if (argc > 1)
+	nrays = (size_t)strtoul(argv[1], NULL, 10);
+
+    if (bu_file_exists(INSTANCE_G, NULL))
+	bu_file_delete(INSTANCE_G);
+    wdbp = wdb_fopen(INSTANCE_G);
+    if (!wdbp)
+	bu_exit(1, "rt_instance: unable to create %s\n", INSTANCE_G);
+    instance_mk(wdbp);
+    wdb_close(wdbp);
+
+    off = (struct instance_hits *)bu_calloc(nrays, sizeof(struct instance_hits), "instance hits");
+    on = (struct instance_hits *)bu_calloc(nrays, sizeof(struct instance_hits), "instance hits");
+
+    off_n = instance_run(0, off, nrays);
+    on_n = instance_run(1, on, nrays);
+
+    if (off_n < 0 || on_n < 0)
+	ret = 1;
+    if (off_n != 0) {
+	bu_log("rt_instance: %ld instances made with LIBRT_INSTANCE_PREP off\n", off_n);
+	ret = 1;
+    }
+    if (on_n <= 0) {
+	bu_log("rt_instance: no instances made with LIBRT_INSTANCE_PREP on\n");
+	ret = 1;
+    }
+    bu_log("rt_instance: %ld instances shared their prep\n", on_n);
+
+    if (instance_compare("shared against unshared", off, on, nrays))
+	ret = 1;
+
+    bu_free(off, "instance hits");
+    bu_free(on, "instance hits");
+    bu_file_delete(INSTANCE_G);
+
+    return ret;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
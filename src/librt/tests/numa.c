@@ -0,0 +1,444 @@
+/*                          N U M A . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file numa.c
+ *
+ * Checks that the copies of the cut tree and BoTs made for NUMA nodes
+ * (LIBRT_NUMA_REPLICATE) do not change what rays hit.  A model of
+ * BoTs and a few other solids is shot without copies, then prepped
+ * with a forced number of copies, which works on a single node too,
+ * and shot from several threads so the threads walk different copies.
+ * Every ray must see the same regions at the same distances.
+ *
+ * Usage: rt_numa [rays [threads [copies]]]
+ */
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "bu/app.h"
+#include "bu/env.h"
+#include "bu/file.h"
+#include "bu/malloc.h"
+#include "bu/parallel.h"
+#include "bu/str.h"
+#include "bn/rand.h"
+#include "bn/randmt.h"
+#include "raytrace.h"
+#include "wdb.h"
+
+#define NUMA_G "rt_numa_test.g"
+
+/* BoT spheres along each side of the grid */
+#define NUMA_GRID 4
+#define NUMA_SPACING 100.0
+
+/* facets around and from pole to pole of each sphere */
+#define NUMA_SEGS 24
+#define NUMA_RINGS 12
+
+#define NUMA_MAX_HITS 64
+#define NUMA_NAMELEN 32
+
+struct numa_hits {
+    size_t n;
+    fastf_t d[NUMA_MAX_HITS][2];
+    char reg[NUMA_MAX_HITS][NUMA_NAMELEN];
+};
+
+struct numa_shots {
+    struct rt_i *rtip;
+    struct xray *rays;
+    struct numa_hits *hits;
+    size_t nrays;
+    size_t ncpu;
+};
+
+static struct resource numa_resources[MAX_PSW];
+
+
+static int
+numa_hit(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs))
+{
+    struct numa_hits *h = (struct numa_hits *)ap->a_uptr;
+    struct partition *pp;
+
+    for (pp = PartHeadp->pt_forw; pp != PartHeadp; pp = pp->pt_forw) {
+	if (h->n >= NUMA_MAX_HITS)
+	    break;
+	h->d[h->n][0] = pp->pt_inhit->hit_dist;
+	h->d[h->n][1] = pp->pt_outhit->hit_dist;
+	bu_strlcpy(h->reg[h->n], pp->pt_regionp->reg_name, NUMA_NAMELEN);
+	h->n++;
+    }
+    return 1;
+}
+
+
+static int
+numa_miss(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+
+/**
+ * A BoT sphere of the given radius, as rings of quads split into
+ * triangles between the two poles.
+ */
+static void
+numa_mk_bot(struct rt_wdb *wdbp, const char *name, fastf_t radius)
+{
+    size_t nverts = 2 + (NUMA_RINGS - 1) * NUMA_SEGS;
+    size_t nfaces = 2 * NUMA_SEGS * (NUMA_RINGS - 1);
+    fastf_t *verts = (fastf_t *)bu_calloc(nverts * 3, sizeof(fastf_t), "numa bot vertices");
+    int *faces = (int *)bu_calloc(nfaces * 3, sizeof(int), "numa bot faces");
+    int north = 0, south = (int)nverts - 1;
+    size_t f = 0;
+    int r, s;
+
+    VSET(&verts[north * 3], 0.0, 0.0, radius);
+    VSET(&verts[south * 3], 0.0, 0.0, -radius);
+    for (r = 1; r < NUMA_RINGS; r++) {
+	fastf_t phi = M_PI * r / NUMA_RINGS;
+	for (s = 0; s < NUMA_SEGS; s++) {
+	    fastf_t theta = M_2PI * s / NUMA_SEGS;
+	    int v = 1 + (r - 1) * NUMA_SEGS + s;
+	    VSET(&verts[v * 3], radius * sin(phi) * cos(theta), radius * sin(phi) * sin(theta), radius * cos(phi));
+	}
+    }
+
+#define NUMA_V(_r, _s) (1 + ((_r) - 1) * NUMA_SEGS + ((_s) % NUMA_SEGS))
+    for (s = 0; s < NUMA_SEGS; s++) {
+	VSET(&faces[f * 3], north, NUMA_V(1, s), NUMA_V(1, s + 1));
+	f++;
+	VSET(&faces[f * 3], south, NUMA_V(NUMA_RINGS - 1, s + 1), NUMA_V(NUMA_RINGS - 1, s));
+	f++;
+	for (r = 1; r < NUMA_RINGS - 1; r++) {
+	    VSET(&faces[f * 3], NUMA_V(r, s), NUMA_V(r + 1, s), NUMA_V(r + 1, s + 1));
+	    f++;
+	    VSET(&faces[f * 3], NUMA_V(r, s), NUMA_V(r + 1, s + 1), NUMA_V(r, s + 1));
+	    f++;
+	}
+    }
+#undef NUMA_V
+
+    if (mk_bot(wdbp, name, RT_BOT_SOLID, RT_BOT_CCW, 0, nverts, nfaces, verts, faces, NULL, NULL) < 0)
+	bu_exit(1, "rt_numa: unable to make %s\n", name);
+
+    bu_free(verts, "numa bot vertices");
+    bu_free(faces, "numa bot faces");
+}
+
+
+/**
+ * A grid of BoT spheres, each placed by its region, with a sphere
+ * and a box among them so the cut tree holds other solids as well.
+ */
+static void
+numa_mk(struct rt_wdb *wdbp)
+{
+    struct wmember head, top;
+    point_t center, min, max;
+    mat_t mat;
+    char name[NUMA_NAMELEN];
+    int x, y;
+
+    BU_LIST_INIT(&top.l);
+    for (y = 0; y < NUMA_GRID; y++) {
+	for (x = 0; x < NUMA_GRID; x++) {
+	    int cell = y * NUMA_GRID + x;
+
+	    snprintf(name, NUMA_NAMELEN, "bot.%d.s", cell);
+	    numa_mk_bot(wdbp, name, 20.0 + 3.0 * cell);
+
+	    MAT_IDN(mat);
+	    MAT_DELTAS(mat, x * NUMA_SPACING, y * NUMA_SPACING, (cell % 3) * 20.0);
+	    BU_LIST_INIT(&head.l);
+	    (void)mk_addmember(name, &head.l, mat, WMOP_UNION);
+	    snprintf(name, NUMA_NAMELEN, "bot.%d.r", cell);
+	    if (mk_lcomb(wdbp, name, &head, 1, NULL, NULL, NULL, 0) < 0)
+		bu_exit(1, "rt_numa: unable to make %s\n", name);
+	    (void)mk_addmember(name, &top.l, NULL, WMOP_UNION);
+	}
+    }
+
+    VSET(center, 1.5 * NUMA_SPACING, 1.5 * NUMA_SPACING, 80.0);
+    if (mk_sph(wdbp, "sph.s", center, 45.0) < 0)
+	bu_exit(1, "rt_numa: unable to make sph.s\n");
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("sph.s", &head.l, NULL, WMOP_UNION);
+    if (mk_lcomb(wdbp, "sph.r", &head, 1, NULL, NULL, NULL, 0) < 0)
+	bu_exit(1, "rt_numa: unable to make sph.r\n");
+    (void)mk_addmember("sph.r", &top.l, NULL, WMOP_UNION);
+
+    VSET(min, -60.0, -60.0, -90.0);
+    VSET(max, NUMA_GRID * NUMA_SPACING, NUMA_GRID * NUMA_SPACING, -70.0);
+    if (mk_rpp(wdbp, "rpp.s", min, max) < 0)
+	bu_exit(1, "rt_numa: unable to make rpp.s\n");
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("rpp.s", &head.l, NULL, WMOP_UNION);
+    if (mk_lcomb(wdbp, "rpp.r", &head, 1, NULL, NULL, NULL, 0) < 0)
+	bu_exit(1, "rt_numa: unable to make rpp.r\n");
+    (void)mk_addmember("rpp.r", &top.l, NULL, WMOP_UNION);
+
+    if (mk_lcomb(wdbp, "all", &top, 0, NULL, NULL, NULL, 0) < 0)
+	bu_exit(1, "rt_numa: unable to make all\n");
+}
+
+
+static struct rt_i *
+numa_load(const char *replicate)
+{
+    struct rt_i *rtip;
+
+    if (replicate)
+	bu_setenv("LIBRT_NUMA_REPLICATE", replicate, 1);
+    else
+	bu_setenv("LIBRT_NUMA_REPLICATE", "", 1);
+
+    rtip = rt_dirbuild(NUMA_G, NULL, 0);
+    if (rtip == RTI_NULL)
+	bu_exit(1, "rt_numa: unable to open %s\n", NUMA_G);
+    if (rt_gettree(rtip, "all") < 0)
+	bu_exit(1, "rt_numa: unable to load all\n");
+    rt_prep(rtip);
+
+    return rtip;
+}
+
+
+/**
+ * Random rays from a sphere around the model toward points inside
+ * its bounding box.  The same rays are made on every call.
+ */
+static void
+numa_rays(struct xray *rays, size_t nrays)
+{
+    point_t center, lo, hi;
+    fastf_t radius;
+    size_t i;
+
+    VSET(lo, -60.0, -60.0, -90.0);
+    VSET(hi, NUMA_GRID * NUMA_SPACING, NUMA_GRID * NUMA_SPACING, 130.0);
+    VADD2SCALE(center, lo, hi, 0.5);
+    radius = DIST_PNT_PNT(lo, hi);
+
+    bn_randmt_seed(5489);
+    for (i = 0; i < nrays; i++) {
+	point_t target;
+
+	bn_rand_sph_sample(rays[i].r_pt, center, radius);
+	VSET(target,
+	     lo[X] + bn_randmt() * (hi[X] - lo[X]),
+	     lo[Y] + bn_randmt() * (hi[Y] - lo[Y]),
+	     lo[Z] + bn_randmt() * (hi[Z] - lo[Z]));
+	VSUB2(rays[i].r_dir, target, rays[i].r_pt);
+	VUNITIZE(rays[i].r_dir);
+    }
+}
+
+
+/* Each thread shoots every ncpu'th ray, with its own resource */
+static void
+numa_shoot(int cpu, void *data)
+{
+    struct numa_shots *shots = (struct numa_shots *)data;
+    struct application ap;
+    size_t i;
+
+    RT_APPLICATION_INIT(&ap);
+    ap.a_rt_i = shots->rtip;
+    ap.a_hit = numa_hit;
+    ap.a_miss = numa_miss;
+    ap.a_resource = &numa_resources[cpu];
+
+    for (i = (size_t)cpu; i < shots->nrays; i += shots->ncpu) {
+	ap.a_ray = shots->rays[i];
+	shots->hits[i].n = 0;
+	ap.a_uptr = (void *)&shots->hits[i];
+	(void)rt_shootray(&ap);
+    }
+}
+
+
+static void
+numa_run(struct rt_i *rtip, struct xray *rays, struct numa_hits *hits, size_t nrays, size_t ncpu)
+{
+    struct numa_shots shots;
+    size_t i;
+
+    for (i = 0; i < ncpu; i++)
+	rt_init_resource(&numa_resources[i], (int)i, rtip);
+
+    shots.rtip = rtip;
+    shots.rays = rays;
+    shots.hits = hits;
+    shots.nrays = nrays;
+    shots.ncpu = ncpu;
+    bu_parallel(numa_shoot, ncpu, &shots);
+
+    for (i = 0; i < ncpu; i++)
+	rt_clean_resource(rtip, &numa_resources[i]);
+}
+
+
+/**
+ * Returns the number of rays whose partitions differ.
+ */
+static size_t
+numa_compare(const char *what, const struct numa_hits *ref, const struct numa_hits *got, size_t nrays)
+{
+    size_t i, j, bad = 0, hit = 0;
+
+    for (i = 0; i < nrays; i++) {
+	if (ref[i].n)
+	    hit++;
+	if (got[i].n != ref[i].n) {
+	    bu_log("rt_numa: %s: ray %zu has %zu partitions, expected %zu\n", what, i, got[i].n, ref[i].n);
+	    bad++;
+	    continue;
+	}
+	for (j = 0; j < ref[i].n; j++) {
+	    /* the copies are exact, so are the hits */
+	    if (!BU_STR_EQUAL(got[i].reg[j], ref[i].reg[j])
+		|| !EQUAL(got[i].d[j][0], ref[i].d[j][0])
+		|| !EQUAL(got[i].d[j][1], ref[i].d[j][1]))
+	    {
+		bu_log("rt_numa: %s: ray %zu partition %zu is %s %g to %g, expected %s %g to %g\n",
+		       what, i, j, got[i].reg[j], got[i].d[j][0], got[i].d[j][1],
+		       ref[i].reg[j], ref[i].d[j][0], ref[i].d[j][1]);
+		bad++;
+		break;
+	    }
+	}
+    }
+
+    bu_log("rt_numa: %s: %zu rays, %zu hit something, %zu disagree\n", what, nrays, hit, bad);
+    return bad;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    struct rt_wdb *wdbp;
+    struct rt_i *rtip;
+    struct xray *rays;
+    struct numa_hits *ref, *got;
+    size_t nrays = 4000, ncpu = 4;
+    int copies = 3, i;
+    char env[32];
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (argc > 4) {
+	bu_log("Usage: %s [rays [threads [copies]]]\n", argv[0]);
+	return 1;
+    }
+    if (argc > 1)
+	nrays = (size_t)strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+	ncpu = (size_t)strtoul(argv[2], NULL, 10);
+    if (argc > 3)
+	copies = atoi(argv[3]);
+    if (ncpu < 1)
+	ncpu = 1;
+    if (ncpu > MAX_PSW)
+	ncpu = MAX_PSW;
+    if (copies < 1)
+	copies = 1;
+
+    if (bu_file_exists(NUMA_G, NULL))
+	bu_file_delete(NUMA_G);
+    wdbp = wdb_fopen(NUMA_G);
+    if (!wdbp)
+	bu_exit(1, "rt_numa: unable to create %s\n", NUMA_G);
+    numa_mk(wdbp);
+    wdb_close(wdbp);
+
+    rays = (struct xray *)bu_calloc(nrays, sizeof(struct xray), "numa rays");
+    ref = (struct numa_hits *)bu_calloc(nrays, sizeof(struct numa_hits), "numa hits");
+    got = (struct numa_hits *)bu_calloc(nrays, sizeof(struct numa_hits), "numa hits");
+    numa_rays(rays, nrays);
+
+    /* without copies, from one thread */
+    rtip = numa_load(NULL);
+    if (rtip->rti_numa_cut) {
+	bu_log("rt_numa: cut tree copied with LIBRT_NUMA_REPLICATE unset\n");
+	ret = 1;
+    }
+    numa_run(rtip, rays, ref, nrays, 1);
+    rt_free_rti(rtip);
+
+    /* with a forced number of copies, from several threads */
+    snprintf(env, sizeof(env), "%d", copies);
+    rtip = numa_load(env);
+    if (!rtip->rti_numa_cut || rtip->rti_numa_nodes != copies) {
+	bu_log("rt_numa: LIBRT_NUMA_REPLICATE=%d made %d copies of the cut tree\n", copies, rtip->rti_numa_cut ? rtip->rti_numa_nodes : 0);
+	ret = 1;
+    } else {
+	for (i = 0; i < copies; i++) {
+	    if (!rtip->rti_numa_cut[i] || rtip->rti_numa_cut[i] == &rtip->rti_CutHead) {
+		bu_log("rt_numa: copy %d of the cut tree is missing\n", i);
+		ret = 1;
+	    }
+	}
+    }
+    numa_run(rtip, rays, got, nrays, ncpu);
+    if (numa_compare("copies against none", ref, got, nrays))
+	ret = 1;
+    rt_free_rti(rtip);
+
+    /* one copy per node is none at all on a single node */
+    rtip = numa_load("node");
+    if (bu_numa_nodes() < 2 && rtip->rti_numa_cut) {
+	bu_log("rt_numa: LIBRT_NUMA_REPLICATE=node copied the cut tree on a single node\n");
+	ret = 1;
+    }
+    if (bu_numa_nodes() > 1 && rtip->rti_numa_nodes != bu_numa_nodes()) {
+	bu_log("rt_numa: LIBRT_NUMA_REPLICATE=node made %d copies for %d nodes\n", rtip->rti_numa_nodes, bu_numa_nodes());
+	ret = 1;
+    }
+    numa_run(rtip, rays, got, nrays, ncpu);
+    if (numa_compare("one copy per node against none", ref, got, nrays))
+	ret = 1;
+    rt_free_rti(rtip);
+
+    bu_free(rays, "numa rays");
+    bu_free(ref, "numa hits");
+    bu_free(got, "numa hits");
+    bu_file_delete(NUMA_G);
+
+    return ret;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
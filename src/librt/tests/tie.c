@@ -0,0 +1,78 @@
+/*                           T I E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file tie.c
+ *
+ * Checks that the float and double tie are both watertight, and
+ * compares their speed.
+ *
+ * Usage: rt_tie [segments [rays]]
+ */
+
+#ifdef TIE_PRECISION
+#  undef TIE_PRECISION
+#endif
+#define TIE_PRECISION 1
+
+#include "tie_shoot.c"
+
+#include <stdlib.h>
+
+#include "bu/app.h"
+
+
+int
+main(int argc, char *argv[])
+{
+    size_t segs = 64, nrays = 100000;
+    size_t leaks_s, leaks_d;
+    double rate_s, rate_d;
+
+    bu_setprogname(argv[0]);
+
+    if (argc > 1)
+	segs = (size_t)strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+	nrays = (size_t)strtoul(argv[2], NULL, 10);
+    if (argc > 3 || segs < 8) {
+	bu_log("Usage: %s [segments (>= 8) [rays]]\n", argv[0]);
+	return 1;
+    }
+
+    leaks_s = tie_shoot_single(segs, nrays, &rate_s);
+    leaks_d = tie_shoot_double(segs, nrays, &rate_d);
+
+    bu_log("float:  %zu rays leaked, %.0f rays/sec\n", leaks_s, rate_s);
+    bu_log("double: %zu rays leaked, %.0f rays/sec\n", leaks_d, rate_d);
+    if (rate_d > 0.0)
+	bu_log("float/double: %.2f\n", rate_s / rate_d);
+
+    return (leaks_s || leaks_d) ? 1 : 0;
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,185 @@
+/*                     T I E _ S H O O T . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file tie_shoot.c
+ *
+ * Body of the tie test, included by tie.c and tie_single.c with
+ * TIE_PRECISION set so that it is built against both the double and
+ * the float tie.
+ *
+ * A closed sphere is tessellated with shared vertices and rays are
+ * fired from inside it straight at every vertex and edge midpoint,
+ * where a test that is not watertight lets rays slip between the
+ * triangles.  Every one of them has to hit something.  Then random
+ * rays are fired from inside the sphere to time the intersector.
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#include "vmath.h"
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "bu/time.h"
+#include "rt/tie.h"
+
+#include "tie_shoot.h"
+
+
+static void *
+TIE_VAL(shoot_hit)(struct tie_ray_s *UNUSED(ray), struct tie_id_s *UNUSED(id), struct tie_tri_s *UNUSED(tri), void *ptr)
+{
+    (*(size_t *)ptr)++;
+    return NULL;
+}
+
+
+static double
+TIE_VAL(shoot_rand)(uint32_t *state)
+{
+    /* xorshift, so both precisions fire the same rays */
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (double)*state / (double)UINT32_MAX;
+}
+
+
+static size_t
+TIE_VAL(shoot_at)(struct tie_s *tie, const point_t pos, const point_t target)
+{
+    struct tie_ray_s ray;
+    struct tie_id_s id;
+    size_t hits = 0;
+
+    VMOVE(ray.pos, pos);
+    VSUB2(ray.dir, target, pos);
+    VUNITIZE(ray.dir);
+    ray.depth = 0;
+    TIE_WORK(tie, &ray, &id, TIE_VAL(shoot_hit), &hits);
+    return hits;
+}
+
+
+/**
+ * Shoot a sphere of 'segs' latitude bands at this precision.  Returns
+ * the number of vertex and edge rays that got through it, and sets
+ * rate to the random rays traced per second.
+ */
+size_t
+TIE_VAL(tie_shoot)(size_t segs, size_t nrays, double *rate)
+{
+    struct tie_s tie;
+    TIE_3 *verts, **tlist;
+    size_t nlon = 2 * segs, nverts, ntris = 0;
+    size_t i, j, leaks = 0;
+    point_t inside;
+    uint32_t state = 0x2545F491;
+    int64_t start, elapsed;
+
+    /* poles plus a ring of nlon vertices between each pair of bands */
+    nverts = 2 + (segs - 1) * nlon;
+    verts = (TIE_3 *)bu_calloc(nverts, sizeof(TIE_3), "verts");
+    tlist = (TIE_3 **)bu_calloc(3 * 2 * segs * nlon, sizeof(TIE_3 *), "tlist");
+
+    VSET(verts[0].v, 0, 0, 1);
+    VSET(verts[1].v, 0, 0, -1);
+    for (i = 1; i < segs; i++) {
+	double lat = M_PI * (double)i / (double)segs;
+	for (j = 0; j < nlon; j++) {
+	    double lon = 2.0 * M_PI * (double)j / (double)nlon;
+	    VSET(verts[2 + (i-1)*nlon + j].v, sin(lat) * cos(lon), sin(lat) * sin(lon), cos(lat));
+	}
+    }
+
+#define SHOOT_RING(_i, _j) (&verts[2 + ((_i)-1)*nlon + ((_j) % nlon)])
+#define SHOOT_TRI(_a, _b, _c) { tlist[3*ntris] = (_a); tlist[3*ntris+1] = (_b); tlist[3*ntris+2] = (_c); ntris++; }
+    for (j = 0; j < nlon; j++) {
+	SHOOT_TRI(&verts[0], SHOOT_RING(1, j), SHOOT_RING(1, j+1));
+	SHOOT_TRI(&verts[1], SHOOT_RING(segs-1, j+1), SHOOT_RING(segs-1, j));
+	for (i = 1; i < segs - 1; i++) {
+	    SHOOT_TRI(SHOOT_RING(i, j), SHOOT_RING(i+1, j), SHOOT_RING(i+1, j+1));
+	    SHOOT_TRI(SHOOT_RING(i, j), SHOOT_RING(i+1, j+1), SHOOT_RING(i, j+1));
+	}
+    }
+#undef SHOOT_TRI
+#undef SHOOT_RING
+
+    TIE_INIT(&tie, (unsigned int)ntris, TIE_KDTREE_FAST);
+    TIE_PUSH(&tie, tlist, (unsigned int)ntris, NULL, 0);
+    TIE_PREP(&tie);
+
+    /* off center, so that no ray runs along an axis of the tree */
+    VSET(inside, 0.1, -0.07, 0.03);
+
+    for (i = 0; i < nverts; i++) {
+	point_t target;
+	VMOVE(target, verts[i].v);
+	if (!TIE_VAL(shoot_at)(&tie, inside, target))
+	    leaks++;
+    }
+    for (i = 0; i < ntris; i++) {
+	for (j = 0; j < 3; j++) {
+	    point_t a, b, target;
+	    VMOVE(a, tlist[3*i+j]->v);
+	    VMOVE(b, tlist[3*i+(j+1)%3]->v);
+	    VADD2SCALE(target, a, b, 0.5);
+	    if (!TIE_VAL(shoot_at)(&tie, inside, target))
+		leaks++;
+	}
+    }
+
+    start = bu_gettime();
+    for (i = 0; i < nrays; i++) {
+	point_t pos, target;
+	VSET(pos,
+	     TIE_VAL(shoot_rand)(&state) - 0.5,
+	     TIE_VAL(shoot_rand)(&state) - 0.5,
+	     TIE_VAL(shoot_rand)(&state) - 0.5);
+	VSET(target,
+	     TIE_VAL(shoot_rand)(&state) - 0.5,
+	     TIE_VAL(shoot_rand)(&state) - 0.5,
+	     TIE_VAL(shoot_rand)(&state) - 0.5);
+	if (VNEAR_EQUAL(pos, target, SMALL_FASTF))
+	    continue;
+	if (!TIE_VAL(shoot_at)(&tie, pos, target))
+	    leaks++;
+    }
+    elapsed = bu_gettime() - start;
+    *rate = (elapsed > 0) ? (double)nrays / ((double)elapsed / 1.0e6) : 0.0;
+
+    TIE_FREE(&tie);
+    bu_free(tlist, "tlist");
+    bu_free(verts, "verts");
+
+    return leaks;
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
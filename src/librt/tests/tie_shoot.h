@@ -0,0 +1,50 @@
+/*                     T I E _ S H O O T . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file tie_shoot.h
+ *
+ * The tie test bodies built from tie_shoot.c, one per precision.
+ *
+ */
+
+#ifndef LIBRT_TESTS_TIE_SHOOT_H
+#define LIBRT_TESTS_TIE_SHOOT_H
+
+#include "common.h"
+
+#include <stddef.h>
+
+__BEGIN_DECLS
+
+extern size_t tie_shoot_single(size_t segs, size_t nrays, double *rate);
+extern size_t tie_shoot_double(size_t segs, size_t nrays, double *rate);
+
+__END_DECLS
+
+#endif /* LIBRT_TESTS_TIE_SHOOT_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
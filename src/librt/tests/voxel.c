@@ -0,0 +1,425 @@
+/*                         V O X E L . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2024 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file voxel.c
+ *
+ * Checks the VOL and EBM ray intersectors against a brute force
+ * reference.  Each test object has large uniformly empty and solid
+ * areas, which the intersectors step over a whole brick at a time,
+ * along with holes and lone cells that force them back to single
+ * cell steps.  Random rays are shot at it, and the hit partitions
+ * must match the union of the solid cells intersected one by one.
+ *
+ * Usage: rt_voxel [rays]
+ */
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/malloc.h"
+#include "bu/sort.h"
+#include "bn/rand.h"
+#include "bn/randmt.h"
+#include "raytrace.h"
+#include "wdb.h"
+
+#define VOXEL_G "rt_voxel_test.g"
+#define VOXEL_VOL "rt_voxel_test.vol"
+#define VOXEL_EBM "rt_voxel_test.ebm"
+
+#define VOL_DIM 64
+#define VOL_LO 10
+#define VOL_HI 200
+
+#define EBM_DIM 64
+#define EBM_TALL 20.0
+
+/* agreement required between librt and the reference */
+#define VOXEL_TOL 1.0e-4
+
+/* rays with a partition or gap shorter than this are skipped, as
+ * the partition weaver may legitimately fuse or drop such pieces */
+#define VOXEL_MIN_PIECE 0.01
+
+#define VOXEL_MAX_HITS 256
+
+
+struct voxel_box {
+    point_t min, max;
+};
+
+struct voxel_hits {
+    size_t n;
+    fastf_t d[VOXEL_MAX_HITS][2];
+};
+
+
+static int
+voxel_hit(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs))
+{
+    struct voxel_hits *h = (struct voxel_hits *)ap->a_uptr;
+    struct partition *pp;
+
+    for (pp = PartHeadp->pt_forw; pp != PartHeadp; pp = pp->pt_forw) {
+	if (h->n >= VOXEL_MAX_HITS)
+	    break;
+	h->d[h->n][0] = pp->pt_inhit->hit_dist;
+	h->d[h->n][1] = pp->pt_outhit->hit_dist;
+	h->n++;
+    }
+    return 1;
+}
+
+
+static int
+voxel_miss(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+
+static int
+voxel_cmp(const void *a, const void *b, void *UNUSED(context))
+{
+    const fastf_t *da = (const fastf_t *)a;
+    const fastf_t *db = (const fastf_t *)b;
+
+    if (da[0] < db[0])
+	return -1;
+    return (da[0] > db[0]);
+}
+
+
+/**
+ * Intersect the ray with every solid cell and merge the touching
+ * intervals.  Returns -1 if the result has a piece too small to
+ * compare reliably.
+ */
+static int
+voxel_reference(struct voxel_hits *ref, const struct voxel_box *cells, size_t ncells, const struct xray *rp)
+{
+    fastf_t (*iv)[2];
+    size_t i, n = 0;
+    int j;
+
+    iv = (fastf_t (*)[2])bu_calloc(ncells + 1, sizeof(fastf_t) * 2, "voxel intervals");
+    for (i = 0; i < ncells; i++) {
+	fastf_t tin = -INFINITY, tout = INFINITY;
+
+	for (j = X; j <= Z; j++) {
+	    fastf_t t1, t2;
+
+	    if (ZERO(rp->r_dir[j])) {
+		if (rp->r_pt[j] < cells[i].min[j] || rp->r_pt[j] > cells[i].max[j])
+		    tout = -INFINITY;
+		continue;
+	    }
+	    t1 = (cells[i].min[j] - rp->r_pt[j]) / rp->r_dir[j];
+	    t2 = (cells[i].max[j] - rp->r_pt[j]) / rp->r_dir[j];
+	    if (t1 > t2) {
+		fastf_t tmp = t1;
+		t1 = t2;
+		t2 = tmp;
+	    }
+	    if (t1 > tin)
+		tin = t1;
+	    if (t2 < tout)
+		tout = t2;
+	}
+	if (tout > tin) {
+	    iv[n][0] = tin;
+	    iv[n][1] = tout;
+	    n++;
+	}
+    }
+
+    bu_sort(iv, n, sizeof(fastf_t) * 2, voxel_cmp, NULL);
+
+    ref->n = 0;
+    for (i = 0; i < n; i++) {
+	if (ref->n && iv[i][0] <= ref->d[ref->n - 1][1] + SMALL_FASTF) {
+	    if (iv[i][1] > ref->d[ref->n - 1][1])
+		ref->d[ref->n - 1][1] = iv[i][1];
+	    continue;
+	}
+	if (ref->n >= VOXEL_MAX_HITS)
+	    break;
+	ref->d[ref->n][0] = iv[i][0];
+	ref->d[ref->n][1] = iv[i][1];
+	ref->n++;
+    }
+    bu_free(iv, "voxel intervals");
+
+    for (i = 0; i < ref->n; i++) {
+	if (ref->d[i][1] - ref->d[i][0] < VOXEL_MIN_PIECE)
+	    return -1;
+	if (i && ref->d[i][0] - ref->d[i - 1][1] < VOXEL_MIN_PIECE)
+	    return -1;
+    }
+    return 0;
+}
+
+
+/**
+ * Shoot nrays random rays at the object and compare the partitions
+ * with the reference.  Returns the number of rays that disagree.
+ */
+static size_t
+voxel_shoot(const char *obj, const struct voxel_box *cells, size_t ncells, const point_t max, size_t nrays)
+{
+    struct application ap;
+    struct rt_i *rtip;
+    struct voxel_hits got, ref;
+    point_t center;
+    fastf_t radius;
+    size_t i, j, shot = 0, bad = 0;
+
+    rtip = rt_dirbuild(VOXEL_G, NULL, 0);
+    if (rtip == RTI_NULL)
+	bu_exit(1, "rt_voxel: unable to open %s\n", VOXEL_G);
+    if (rt_gettree(rtip, obj) < 0)
+	bu_exit(1, "rt_voxel: unable to load %s\n", obj);
+    rt_prep(rtip);
+
+    VSCALE(center, max, 0.5);
+    radius = MAGNITUDE(max) * 2.0;
+
+    RT_APPLICATION_INIT(&ap);
+    ap.a_rt_i = rtip;
+    ap.a_hit = voxel_hit;
+    ap.a_miss = voxel_miss;
+    ap.a_uptr = (void *)&got;
+
+    bn_randmt_seed(5489);
+    for (i = 0; i < nrays; i++) {
+	point_t target;
+
+	/* from a point on a sphere around the object toward a
+	 * point inside its bounding box */
+	bn_rand_sph_sample(ap.a_ray.r_pt, center, radius);
+	VSET(target, bn_randmt() * max[X], bn_randmt() * max[Y], bn_randmt() * max[Z]);
+	VSUB2(ap.a_ray.r_dir, target, ap.a_ray.r_pt);
+	VUNITIZE(ap.a_ray.r_dir);
+
+	if (voxel_reference(&ref, cells, ncells, &ap.a_ray) < 0)
+	    continue;
+	shot++;
+
+	got.n = 0;
+	(void)rt_shootray(&ap);
+
+	if (got.n != ref.n) {
+	    bu_log("rt_voxel: %s ray %zu from (%g %g %g) dir (%g %g %g): %zu partitions, expected %zu\n",
+		   obj, i, V3ARGS(ap.a_ray.r_pt), V3ARGS(ap.a_ray.r_dir), got.n, ref.n);
+	    bad++;
+	    continue;
+	}
+	for (j = 0; j < ref.n; j++) {
+	    if (!NEAR_EQUAL(got.d[j][0], ref.d[j][0], VOXEL_TOL)
+		|| !NEAR_EQUAL(got.d[j][1], ref.d[j][1], VOXEL_TOL))
+	    {
+		bu_log("rt_voxel: %s ray %zu partition %zu is %g to %g, expected %g to %g\n",
+		       obj, i, j, got.d[j][0], got.d[j][1], ref.d[j][0], ref.d[j][1]);
+		bad++;
+		break;
+	    }
+	}
+    }
+
+    bu_log("rt_voxel: %s: %zu of %zu rays compared, %zu disagree\n", obj, shot, nrays, bad);
+    rt_free_rti(rtip);
+
+    return bad;
+}
+
+
+/**
+ * A block of solid voxels with a one cell hole and a 2x2x2 cavity
+ * in it, and two lone voxels.  Empty cells hold assorted values on
+ * both sides of the threshold range, so bricks that are uniformly
+ * empty do not all have the same contents.
+ */
+static size_t
+voxel_mk_vol(struct rt_wdb *wdbp, struct voxel_box **cells)
+{
+    unsigned char *data;
+    size_t x, y, z, n = 0;
+    vect_t cellsize;
+    mat_t mat;
+    FILE *fp;
+
+    data = (unsigned char *)bu_calloc(VOL_DIM * VOL_DIM, VOL_DIM, "vol data");
+    *cells = (struct voxel_box *)bu_calloc(VOL_DIM * VOL_DIM, VOL_DIM * sizeof(struct voxel_box), "vol cells");
+    for (z = 0; z < VOL_DIM; z++) {
+	for (y = 0; y < VOL_DIM; y++) {
+	    for (x = 0; x < VOL_DIM; x++) {
+		unsigned char *v = &data[(z * VOL_DIM + y) * VOL_DIM + x];
+		int solid = 0;
+
+		if (x >= 8 && x < 40 && y >= 12 && y < 44 && z >= 4 && z < 36)
+		    solid = 1;
+		if (x == 20 && y == 21 && z == 22)
+		    solid = 0;
+		if (x >= 30 && x < 32 && y >= 30 && y < 32 && z >= 10 && z < 12)
+		    solid = 0;
+		if ((x == 50 && y == 50 && z == 50) || (x == 60 && y == 5 && z == 30))
+		    solid = 1;
+
+		if (solid) {
+		    *v = (unsigned char)(VOL_LO + (x + y + z) % (VOL_HI - VOL_LO + 1));
+		    VSET((*cells)[n].min, x, y, z);
+		    VSET((*cells)[n].max, x + 1, y + 1, z + 1);
+		    n++;
+		} else if ((x + 2 * y + 3 * z) % 7 == 0) {
+		    *v = (unsigned char)((x % 2) ? VOL_LO - 1 : VOL_HI + 1);
+		}
+	    }
+	}
+    }
+
+    fp = fopen(VOXEL_VOL, "wb");
+    if (!fp || fwrite(data, VOL_DIM * VOL_DIM, VOL_DIM, fp) != VOL_DIM)
+	bu_exit(1, "rt_voxel: unable to write %s\n", VOXEL_VOL);
+    fclose(fp);
+    bu_free(data, "vol data");
+
+    VSETALL(cellsize, 1.0);
+    MAT_IDN(mat);
+    if (mk_vol(wdbp, "vol.s", RT_VOL_SRC_FILE, VOXEL_VOL, VOL_DIM, VOL_DIM, VOL_DIM,
+	       VOL_LO, VOL_HI, cellsize, mat) < 0)
+	bu_exit(1, "rt_voxel: unable to make vol.s\n");
+
+    return n;
+}
+
+
+/**
+ * A disc with a square hole in it, and two lone pixels.
+ */
+static size_t
+voxel_mk_ebm(struct rt_wdb *wdbp, struct voxel_box **cells)
+{
+    unsigned char *data;
+    char path[MAXPATHLEN];
+    size_t x, y, n = 0;
+    mat_t mat;
+    FILE *fp;
+
+    data = (unsigned char *)bu_calloc(EBM_DIM, EBM_DIM, "ebm data");
+    *cells = (struct voxel_box *)bu_calloc(EBM_DIM * EBM_DIM, sizeof(struct voxel_box), "ebm cells");
+    for (y = 0; y < EBM_DIM; y++) {
+	for (x = 0; x < EBM_DIM; x++) {
+	    fastf_t dx = (fastf_t)x + 0.5 - 32.0;
+	    fastf_t dy = (fastf_t)y + 0.5 - 32.0;
+	    int solid = (dx * dx + dy * dy < 20.0 * 20.0);
+
+	    if (x >= 28 && x < 36 && y >= 28 && y < 36)
+		solid = 0;
+	    if ((x == 3 && y == 60) || (x == 60 && y == 3))
+		solid = 1;
+	    if (!solid)
+		continue;
+
+	    data[y * EBM_DIM + x] = (unsigned char)(1 + (x * y) % 255);
+	    VSET((*cells)[n].min, x, y, 0);
+	    VSET((*cells)[n].max, x + 1, y + 1, EBM_TALL);
+	    n++;
+	}
+    }
+
+    fp = fopen(VOXEL_EBM, "wb");
+    if (!fp || fwrite(data, EBM_DIM, EBM_DIM, fp) != EBM_DIM)
+	bu_exit(1, "rt_voxel: unable to write %s\n", VOXEL_EBM);
+    fclose(fp);
+    bu_free(data, "ebm data");
+
+    /* EBM data files are looked up relative to the database */
+    bu_dir(path, MAXPATHLEN, BU_DIR_CURR, VOXEL_EBM, NULL);
+    MAT_IDN(mat);
+    if (mk_ebm(wdbp, "ebm.s", path, EBM_DIM, EBM_DIM, EBM_TALL, mat) < 0)
+	bu_exit(1, "rt_voxel: unable to make ebm.s\n");
+
+    return n;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    struct rt_wdb *wdbp;
+    struct wmember head;
+    struct voxel_box *vol_cells, *ebm_cells;
+    size_t vol_n, ebm_n, bad = 0;
+    size_t nrays = 500;
+    point_t max;
+
+    bu_setprogname(argv[0]);
+
+    if (argc > 2) {
+	bu_log("Usage: %s [rays]\n", argv[0]);
+	return 1;
+    }
+    if (argc > 1)
+	nrays = (size_t)strtoul(argv[1], NULL, 10);
+
+    if (bu_file_exists(VOXEL_G, NULL))
+	bu_file_delete(VOXEL_G);
+    wdbp = wdb_fopen(VOXEL_G);
+    if (!wdbp)
+	bu_exit(1, "rt_voxel: unable to create %s\n", VOXEL_G);
+
+    vol_n = voxel_mk_vol(wdbp, &vol_cells);
+    ebm_n = voxel_mk_ebm(wdbp, &ebm_cells);
+
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("vol.s", &head.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, "vol.r", &head, 1, NULL, NULL, NULL, 0);
+    BU_LIST_INIT(&head.l);
+    (void)mk_addmember("ebm.s", &head.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, "ebm.r", &head, 1, NULL, NULL, NULL, 0);
+    wdb_close(wdbp);
+
+    VSETALL(max, VOL_DIM);
+    bad += voxel_shoot("vol.r", vol_cells, vol_n, max, nrays);
+    VSET(max, EBM_DIM, EBM_DIM, EBM_TALL);
+    bad += voxel_shoot("ebm.r", ebm_cells, ebm_n, max, nrays);
+
+    bu_free(vol_cells, "vol cells");
+    bu_free(ebm_cells, "ebm cells");
+    bu_file_delete(VOXEL_G);
+    bu_file_delete(VOXEL_VOL);
+    bu_file_delete(VOXEL_EBM);
+
+    return (bad) ? 1 : 0;
+}
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
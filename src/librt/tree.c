@@ -27,10 +27,12 @@
 #include "bio.h"
 
 #include "bu/parallel.h"
+#include "bu/units.h"
 #include "vmath.h"
 #include "bn.h"
 #include "rt/db4.h"
 #include "raytrace.h"
+#include "librt_private.h"
 
 #include "./cache.h"
 
@@ -385,6 +387,33 @@ rt_find_or_create_identical_solid(const matp_t mat, struct directory *dp, struct
 	stp->st_matp = (matp_t)0;
     }
 
+    /*
+     * If asked to, share the prep of an earlier placement that only
+     * differs from this one by a rigid motion.  Halfspaces are
+     * infinite and cheap to prep, so they are not worth the bother.
+     */
+    if (rtip->rti_instance_prep && rtip->rti_dont_instance == 0 &&
+	dp->d_minor_type != ID_HALF
+	) {
+	struct bu_list *mid;
+	struct soltab *proto;
+
+	for (BU_LIST_FOR(mid, bu_list, &dp->d_use_hd)) {
+	    proto = BU_LIST_MAIN_PTR(soltab, mid, l2);
+	    RT_CK_SOLTAB(proto);
+	    if (proto->st_rtip != rtip || proto->st_aradius <= -1 ||
+		proto->st_meth == &_rt_instance_functab)
+		continue;
+	    /* a placement that is not a rigid motion away from this
+	     * one may still have others that are, so keep looking */
+	    if (!_rt_instance_init(stp, proto))
+		continue;
+	    if (rtip->rti_add_to_new_solids_list)
+		bu_ptbl_ins(&rtip->rti_new_solids, (long *)stp);
+	    break;
+	}
+    }
+
     /* Add to the appropriate soltab list head */
     /* PARALLEL NOTE:  Uses critical section on rt_solidheads element */
     BU_LIST_INSERT(&(rtip->rti_solidheads[hash]), &(stp->l));
@@ -488,6 +517,7 @@ _rt_gettree_leaf(struct db_tree_state *tsp, const struct db_full_path *pathp, st
     matp_t mat;
     union tree *curtree;
     struct rt_i *rtip;
+    ssize_t prep_bytes;
     int ret;
     int i;
 
@@ -529,8 +559,9 @@ _rt_gettree_leaf(struct db_tree_state *tsp, const struct db_full_path *pathp, st
      * like before, oops), it isn't a problem.
      */
     stp = rt_find_or_create_identical_solid(mat, dp, rtip);
-    if (stp->st_id != 0) {
-	/* stp is an instance of a pre-existing solid */
+    if (stp->st_id != 0 || stp->st_meth == &_rt_instance_functab) {
+	/* stp is an instance of a pre-existing solid, or shares the
+	 * prep of one placed elsewhere */
 	if (stp->st_aradius <= -1) {
 	    /* It's dead, Jim.  st_uses was not incremented. */
 	    return TREE_NULL;	/* BAD: instance of dead solid */
@@ -551,16 +582,44 @@ _rt_gettree_leaf(struct db_tree_state *tsp, const struct db_full_path *pathp, st
     VSETALL(stp->st_max, -INFINITY);
     VSETALL(stp->st_min,  INFINITY);
 
+    /*
+     * Once the memory budget is spent, stop prepping.  The solid is
+     * marked dead like a prep failure, and rt_gettrees() reports the
+     * shortfall once the walk is done.
+     */
+    if (rtip->rti_mem_budget && rtip->rti_prep_bytes >= rtip->rti_mem_budget) {
+	int hash = db_dirhash(dp->d_namep);
+	ACQUIRE_SEMAPHORE_TREE(hash);
+	stp->st_aradius = -1;
+	stp->st_uses--;
+	RELEASE_SEMAPHORE_TREE(hash);
+	bu_semaphore_acquire(BU_SEM_GENERAL);
+	rtip->rti_mem_dropped++;
+	bu_semaphore_release(BU_SEM_GENERAL);
+	return TREE_NULL;
+    }
+
     /*
      * If prep wants to keep the internal structure, that is OK, as
      * long as idb_ptr is set to null.  Note that the prep routine may
      * have changed st_id.
+     *
+     * Prep runs on this thread, so what it holds on to shows up as
+     * the change in this thread's allocation count.
      */
+    prep_bytes = bu_malloc_bytes(bu_parallel_id());
     if (rtip->rti_dbip->dbi_version > 4) {
 	ret = rt_cache_prep(data->cache, stp, ip);
     } else {
 	ret = rt_obj_prep(stp, ip, stp->st_rtip);
     }
+    prep_bytes = bu_malloc_bytes(bu_parallel_id()) - prep_bytes;
+    if (!ret && prep_bytes > 0) {
+	stp->st_prep_bytes = (size_t)prep_bytes;
+	bu_semaphore_acquire(BU_SEM_GENERAL);
+	rtip->rti_prep_bytes += stp->st_prep_bytes;
+	bu_semaphore_release(BU_SEM_GENERAL);
+    }
     if (ret) {
 	int hash;
 	/* Error, solid no good */
@@ -675,6 +734,12 @@ rt_free_soltab(struct soltab *stp)
 	    stp->st_meth->ft_free(stp);
 	stp->st_aradius = 0;
     }
+    if (stp->st_rtip && stp->st_prep_bytes) {
+	bu_semaphore_acquire(BU_SEM_GENERAL);
+	if (stp->st_rtip->rti_prep_bytes >= stp->st_prep_bytes)
+	    stp->st_rtip->rti_prep_bytes -= stp->st_prep_bytes;
+	bu_semaphore_release(BU_SEM_GENERAL);
+    }
     if (stp->st_matp) bu_free((char *)stp->st_matp, "st_matp");
     stp->st_matp = (matp_t)0;	/* Sanity */
 
@@ -855,6 +920,14 @@ rt_gettrees_and_attrs(struct rt_i *rtip, const char **attrs, int argc, const cha
 	db_ck_tree(regp->reg_treetop);
     }
 
+    /* Placements sharing another's prep take their bounds from it,
+     * now that all the prepping is done.
+     */
+    RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
+	if (stp->st_meth == &_rt_instance_functab && ZERO(stp->st_aradius))
+	    _rt_instance_finish(stp);
+    } RT_VISIT_ALL_SOLTABS_END;
+
     /*
      * Eliminate any "dead" solids that parallel code couldn't change.
      * First remove any references from the region tree, then remove
@@ -869,8 +942,9 @@ again:
     RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
 	RT_CK_SOLTAB(stp);
 	if (stp->st_aradius <= 0) {
-	    bu_log("rt_gettrees() cleaning up dead solid '%s'\n",
-		   stp->st_dp->d_namep);
+	    if (!rtip->rti_mem_dropped)
+		bu_log("rt_gettrees() cleaning up dead solid '%s'\n",
+		       stp->st_dp->d_namep);
 	    rt_free_soltab(stp);
 	    /* Can't do rtip->nsolids--, that doubles as max bit number! */
 	    /* The macro makes it hard to regain place, punt */
@@ -929,6 +1003,15 @@ again:
 	db_ck_tree(regp->reg_treetop);
     }
 
+    if (rtip->rti_mem_dropped) {
+	char budget[8] = {0};
+	(void)bu_humanize_number(budget, sizeof(budget), (int64_t)rtip->rti_mem_budget, "B",
+				 BU_HN_AUTOSCALE, BU_HN_B | BU_HN_NOSPACE | BU_HN_DECIMAL);
+	bu_log("rt_gettrees(): memory budget of %s exceeded, %zu primitives not prepped\n",
+	       budget, rtip->rti_mem_dropped);
+	ret = -1;
+    }
+
     if (ret < 0)
 	return ret;
 
@@ -58,8 +58,8 @@ vshot_stub(struct soltab **stp, struct xray **rp, struct seg *segp, int n, struc
 	    /* skip call if solid table pointer is NULL */
 	    /* do scalar call, place results in segp array */
 	    ret = -1;
-	    if (OBJ[stp[i]->st_id].ft_shot) {
-		ret = OBJ[stp[i]->st_id].ft_shot(stp[i], rp[i], ap, &seghead);
+	    if (stp[i]->st_meth->ft_shot) {
+		ret = stp[i]->st_meth->ft_shot(stp[i], rp[i], ap, &seghead);
 	    }
 	    if (ret <= 0) {
 		segp[i].seg_stp=(struct soltab *) 0;
@@ -221,8 +221,10 @@ rt_vshootray(struct application *ap)
 	goto out;
     }
 
-    /* For each type of solid to be shot at, assemble the vectors */
-    for (id = 1; id <= ID_MAX_SOLID; id++) {
+    /* For each type of solid to be shot at, assemble the vectors.
+     * Instanced solids are filed under ID_NULL and go through the stub.
+     */
+    for (id = 0; id <= ID_MAX_SOLID; id++) {
 	register int nsol;
 
 	if ((nsol = rtip->rti_nsol_by_type[id]) <= 0) continue;
@@ -238,7 +240,7 @@ rt_vshootray(struct application *ap)
 	/* bit vector per ray check */
 	/* mark elements to be skipped with ary_stp[] = SOLTAB_NULL */
 	ap->a_rt_i->nshots += nsol;	/* later: skipped ones */
-	if (OBJ[id].ft_vshot) {
+	if (id > 0 && OBJ[id].ft_vshot) {
 	    OBJ[id].ft_vshot(ary_stp, ary_rp, ary_seg, nsol, ap);
 	} else {
 	    vshot_stub(ary_stp, ary_rp, ary_seg, nsol, ap);
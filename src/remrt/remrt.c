@@ -103,6 +103,9 @@ extern int gettimeofday(struct timeval *, void *);
 #define N_SERVER_ASSIGNMENTS	1		/* desired # of assignments */
 #define MIN_ASSIGNMENT_TIME	5		/* desired seconds/result */
 #define SERVER_CHECK_INTERVAL	(10*60)		/* seconds */
+#define TAIL_SPLIT		2		/* end-of-frame pieces per server */
+#define REISSUE_FACTOR		1.5		/* lateness before re-issuing work */
+#define REISSUE_MIN_TIME	2.0		/* seconds, never re-issue sooner */
 #ifndef RSH
 #  define RSH "/usr/ucb/rsh"
 #endif
@@ -200,7 +203,7 @@ struct servers {
     struct timeval sr_sendtime;	/* time of last sending */
     double sr_l_elapsed;	/* last: elapsed_sec */
     double sr_l_el_rate;	/* last: pix/elapsed_sec */
-    double sr_w_elapsed;	/* weighted avg: pix/elapsed_sec */
+    double sr_w_elapsed;	/* weighted avg: cost-weighted pix/elapsed_sec */
     double sr_w_rays;	/* weighted avg: rays/elapsed_sec */
     double sr_s_elapsed;	/* sum of pix/elapsed_sec */
     double sr_sq_elapsed;	/* sum of pix/elapsed_sec squared */
@@ -214,6 +217,7 @@ struct servers {
     int sr_nsamp;	/* number of samples summed over */
     double sr_prep_cpu;	/* sum of cpu time for preps */
     double sr_l_percent;	/* last: percent of CPU */
+    double sr_l_cost;	/* est. cost of last assignment, in pixels */
 } servers[MAXSERVERS];
 
 
@@ -224,6 +228,7 @@ int fbheight;			/* fb height - S command */
 
 int running = 0;		/* actually working on it */
 int detached = 0;		/* continue after EOF */
+int reissue = 1;		/* re-issue straggling work to idle servers */
 
 fd_set clients;
 int print_on = 1;
@@ -246,6 +251,9 @@ struct list {
     struct frame *li_frame;
     int li_start;
     int li_stop;
+    struct list *li_twin;	/* other copy of a re-issued span */
+    int li_cancelled;	/* result no longer wanted, discard it */
+    struct timeval li_starttime;	/* when sent, or when the server finished the one before */
 };
 
 
@@ -254,12 +262,16 @@ struct bu_list FreeList;
 #define LIST_NULL ((struct list*)0)
 #define LIST_MAGIC 0x4c494c49
 
-#define GET_LIST(p) if (BU_LIST_IS_EMPTY(&FreeList)) { \
-	BU_ALLOC((p), struct list); \
-	(p)->l.magic = LIST_MAGIC; \
-    } else { \
-	(p) = BU_LIST_FIRST(list, &FreeList); \
-	BU_LIST_DEQUEUE(&(p)->l); \
+#define GET_LIST(p) { \
+	if (BU_LIST_IS_EMPTY(&FreeList)) { \
+	    BU_ALLOC((p), struct list); \
+	    (p)->l.magic = LIST_MAGIC; \
+	} else { \
+	    (p) = BU_LIST_FIRST(list, &FreeList); \
+	    BU_LIST_DEQUEUE(&(p)->l); \
+	} \
+	(p)->li_twin = LIST_NULL; \
+	(p)->li_cancelled = 0; \
     }
 
 #define FREE_LIST(p) { BU_LIST_APPEND(&FreeList, &(p)->l); }
@@ -510,9 +522,20 @@ drop_server(struct servers *sp, char *why)
 
     /* Need to requeue any work that was in progress */
     while (BU_LIST_WHILE(lp, list, &sp->sr_work)) {
+	BU_LIST_DEQUEUE(&lp->l);
+	if (lp->li_cancelled) {
+	    /* Nobody is waiting for this one */
+	    FREE_LIST(lp);
+	    continue;
+	}
+	if (lp->li_twin != LIST_NULL) {
+	    /* Another server still has a copy of this span */
+	    lp->li_twin->li_twin = LIST_NULL;
+	    FREE_LIST(lp);
+	    continue;
+	}
 	fr = lp->li_frame;
 	CHECK_FRAME(fr);
-	BU_LIST_DEQUEUE(&lp->l);
 	bu_log("%s requeueing fr%ld %d..%d\n",
 	       stamp(),
 	       fr->fr_number,
@@ -628,6 +651,7 @@ addclient(struct pkg_conn *pc)
     BU_LIST_INIT(&sp->sr_work);
     sp->sr_curframe = FRAME_NULL;
     sp->sr_lump = 32;
+    sp->sr_l_cost = 32;
     sp->sr_host = ihp;
     statechange(sp, SRST_NEW);
 
@@ -1175,6 +1199,13 @@ destroy_frame(struct frame *fr)
 	if (sp->sr_curframe == fr) {
 	    sp->sr_curframe = FRAME_NULL;
 	}
+	/* Results still on the way for this frame get discarded */
+	for (BU_LIST_FOR(lp, list, &sp->sr_work)) {
+	    if (lp->li_frame != fr) continue;
+	    lp->li_frame = FRAME_NULL;
+	    lp->li_cancelled = 1;
+	    lp->li_twin = LIST_NULL;
+	}
     }
     DEQUEUE_FRAME(fr);
     FREE_FRAME(fr);
@@ -1354,6 +1385,171 @@ server_q_len(struct servers *sp)
 }
 
 
+/*
+ * Per-scanline cost estimates, in CPU seconds per pixel, learned from
+ * returned results.  They carry over from one frame to the next, so in
+ * an animation each frame is scheduled using what the previous one
+ * cost.  Rows not yet measured are assumed to be of average cost.
+ *
+ * Costs are handed out in units of "average pixels", so with no
+ * measurements at all every pixel costs 1 and scheduling reduces to
+ * plain pixel counting.
+ */
+struct cost_map {
+    int cm_width;
+    int cm_height;
+    double *cm_row;	/* cpu sec/pixel by scanline, 0 if unmeasured */
+    int cm_nknown;	/* number of measured rows */
+    double cm_sum;	/* sum of measured rows */
+};
+struct cost_map scan_cost = {0, 0, NULL, 0, 0.0};
+
+
+static int
+cost_valid(struct frame *fr)
+{
+    return scan_cost.cm_row != NULL && scan_cost.cm_nknown > 0 &&
+	scan_cost.cm_width == fr->fr_width &&
+	scan_cost.cm_height == fr->fr_height;
+}
+
+
+/*
+ * Relative cost of one pixel in scanline y.
+ */
+static double
+cost_row(int y)
+{
+    double mean = scan_cost.cm_sum / scan_cost.cm_nknown;
+    double r = scan_cost.cm_row[y % scan_cost.cm_height];
+
+    if (r <= 0.0 || mean <= 0.0)
+	return 1.0;
+    return r / mean;
+}
+
+
+/*
+ * Estimated cost of pixels a through b inclusive.
+ */
+static double
+cost_estimate(struct frame *fr, int a, int b)
+{
+    double sum = 0.0;
+    int w = fr->fr_width;
+    int y;
+
+    if (b < a)
+	return 0.0;
+    if (!cost_valid(fr))
+	return (double)(b - a + 1);
+
+    for (y = a / w; y <= b / w; y++) {
+	int first = (y * w > a) ? y * w : a;
+	int last = ((y + 1) * w - 1 < b) ? (y + 1) * w - 1 : b;
+	sum += (last - first + 1) * cost_row(y);
+    }
+    return sum;
+}
+
+
+/*
+ * Estimated cost of all the work not yet handed out for a frame.
+ */
+static double
+cost_todo(struct frame *fr)
+{
+    struct list *lp;
+    double sum = 0.0;
+
+    for (BU_LIST_FOR(lp, list, &fr->fr_todo))
+	sum += cost_estimate(fr, lp->li_start, lp->li_stop);
+    return sum;
+}
+
+
+/*
+ * Number of pixels, starting at pixel a and going no further than
+ * stop, that add up to about 'budget' worth of work.
+ */
+static int
+cost_span(struct frame *fr, int a, int stop, double budget)
+{
+    int w = fr->fr_width;
+    int p = a;
+
+    if (budget < 1.0)
+	budget = 1.0;
+    if (!cost_valid(fr)) {
+	if (budget > (double)(stop - a + 1))
+	    return stop - a + 1;
+	return (int)budget;
+    }
+
+    while (p <= stop) {
+	int rowend = ((p / w) + 1) * w - 1;
+	double per = cost_row(p / w);
+	double rowcost;
+
+	if (rowend > stop) rowend = stop;
+	rowcost = (rowend - p + 1) * per;
+	if (rowcost >= budget) {
+	    int n = (int)(budget / per);
+	    if (n < 1) n = 1;
+	    return p + n - a;
+	}
+	budget -= rowcost;
+	p = rowend + 1;
+    }
+    return stop - a + 1;
+}
+
+
+/*
+ * Fold a returned result into the scanline costs.  Each row covered
+ * moves toward the new measurement in proportion to how much of the
+ * row the result spans.
+ */
+static void
+cost_record(struct frame *fr, int a, int b, double cpusec)
+{
+    int w = fr->fr_width;
+    double c;
+    int y;
+
+    if (cpusec <= 0.0 || b < a)
+	return;
+
+    if (scan_cost.cm_width != fr->fr_width ||
+	scan_cost.cm_height != fr->fr_height) {
+	/* New image size, start over */
+	if (scan_cost.cm_row)
+	    bu_free(scan_cost.cm_row, "scan_cost");
+	scan_cost.cm_row = (double *)bu_calloc(fr->fr_height, sizeof(double), "scan_cost");
+	scan_cost.cm_width = fr->fr_width;
+	scan_cost.cm_height = fr->fr_height;
+	scan_cost.cm_nknown = 0;
+	scan_cost.cm_sum = 0.0;
+    }
+
+    c = cpusec / (b - a + 1);
+    for (y = a / w; y <= b / w; y++) {
+	int first = (y * w > a) ? y * w : a;
+	int last = ((y + 1) * w - 1 < b) ? (y + 1) * w - 1 : b;
+	double *rp = &scan_cost.cm_row[y % scan_cost.cm_height];
+	double old = *rp;
+
+	if (old <= 0.0) {
+	    *rp = c;
+	    scan_cost.cm_nknown++;
+	} else {
+	    *rp = old + (c - old) * (double)(last - first + 1) / w;
+	}
+	scan_cost.cm_sum += *rp - old;
+    }
+}
+
+
 static void
 send_loglvl(struct servers *sp)
 {
@@ -1491,6 +1687,7 @@ this_frame_done(struct frame *fr)
 	if (sp->sr_pc == PKC_NULL) continue;
 	for (BU_LIST_FOR(lp, list, &sp->sr_work)) {
 	    if (fr != lp->li_frame) continue;
+	    if (lp->li_cancelled) continue;
 	    return 0;		/* nope, still more work */
 	}
     }
@@ -1615,6 +1812,8 @@ task_server(struct servers *sp, struct frame *fr, struct timeval *nowp)
     int a, b;
     int lump;
     int maxlump;
+    int nready;
+    double budget;
 
     if (sp->sr_pc == PKC_NULL) return 0;
 
@@ -1700,16 +1899,31 @@ task_server(struct servers *sp, struct frame *fr, struct timeval *nowp)
      * remote processor load
      * available network bandwidth & load
      * local processing delays
+     * Pixels are weighted by the scanline cost estimates, so that
+     * an assignment in an expensive part of the image is smaller.
      */
     /* Base new assignment on desired result rate & measured speed */
-    lump = assignment_time() * sp->sr_w_elapsed;
+    budget = assignment_time() * sp->sr_w_elapsed;
+    lp = BU_LIST_FIRST(list, &fr->fr_todo);
 
     /* If each frame has a dedicated server, make lumps big */
     if (work_allocate_method == OPT_MOVIE) {
 	lump = fr->fr_width * 2;	/* 2 scanlines at a whack */
     } else {
 	/* Limit growth in assignment size to 1.5X each assignment */
-	if (lump > 1.5*sp->sr_lump) lump = 1.5*sp->sr_lump;
+	if (budget > 1.5*sp->sr_l_cost) budget = 1.5*sp->sr_l_cost;
+
+	/*
+	 * Toward the end of the frame, hand out ever smaller pieces
+	 * of what is left, so that no server is still grinding on a
+	 * big final lump while the others sit idle.
+	 */
+	nready = number_of_ready_servers();
+	if (nready > 1) {
+	    double tail = cost_todo(fr) / (TAIL_SPLIT * nready);
+	    if (budget > tail) budget = tail;
+	}
+	lump = cost_span(fr, lp->li_start, lp->li_stop, budget);
     }
     /* Provide some bounds checking */
     if (lump < 32) lump = 32;
@@ -1729,7 +1943,6 @@ task_server(struct servers *sp, struct frame *fr, struct timeval *nowp)
     if (lump > maxlump) lump=maxlump;
     sp->sr_lump = lump;
 
-    lp = BU_LIST_FIRST(list, &fr->fr_todo);
     a = lp->li_start;
     b = a+sp->sr_lump-1;	/* work increment */
     if (b >= lp->li_stop) {
@@ -1747,7 +1960,9 @@ task_server(struct servers *sp, struct frame *fr, struct timeval *nowp)
     lp->li_start = a;
     lp->li_stop = b;
     BU_LIST_INSERT(&sp->sr_work, &lp->l);
+    sp->sr_l_cost = cost_estimate(fr, a, b);
     send_do_lines(sp, a, b, fr->fr_number);
+    lp->li_starttime = sp->sr_sendtime;
 
     /* See if server will need more assignments */
     if (server_q_len(sp) < N_SERVER_ASSIGNMENTS)
@@ -1756,6 +1971,119 @@ task_server(struct servers *sp, struct frame *fr, struct timeval *nowp)
 }
 
 
+/*
+ * Servers work through their assignments in order, so once the head
+ * assignment is returned the next one starts.  Note when, so lateness
+ * is measured from the time the server could begin on it.
+ */
+static void
+start_next_assignment(struct servers *sp)
+{
+    struct list *lp;
+    struct timeval now;
+
+    if (BU_LIST_IS_EMPTY(&sp->sr_work))
+	return;
+    lp = BU_LIST_FIRST(list, &sp->sr_work);
+    (void)gettimeofday(&now, (struct timezone *)0);
+    if (tvdiff(&now, &lp->li_starttime) > 0.0)
+	lp->li_starttime = now;
+}
+
+
+/*
+ * Once a frame has nothing left to hand out, an idle server can only
+ * wait on whoever holds the last pieces.  If one of those is well
+ * past its expected finish, give the idle server a copy of it as
+ * well; whichever copy comes back first is used, and the other
+ * result is discarded when it arrives.
+ */
+static void
+reissue_stragglers(struct timeval *nowp)
+{
+    struct servers *sp;
+    struct servers *osp;
+    struct servers *best_sp;
+    struct frame *fr;
+    struct list *lp;
+    struct list *best;
+    double best_late;
+
+    if (!reissue || work_allocate_method != OPT_FRAME)
+	return;
+
+    for (sp = &servers[0]; sp < &servers[MAXSERVERS]; sp++) {
+	if (sp->sr_pc == PKC_NULL) continue;
+	if (sp->sr_state != SRST_READY) continue;
+	if (BU_LIST_NON_EMPTY(&sp->sr_work)) continue;
+
+	best = LIST_NULL;
+	best_sp = SERVERS_NULL;
+	best_late = 0.0;
+	for (osp = &servers[0]; osp < &servers[MAXSERVERS]; osp++) {
+	    double cost, elapsed, expected;
+
+	    if (osp == sp || osp->sr_pc == PKC_NULL) continue;
+	    if (osp->sr_state != SRST_READY) continue;
+	    if (BU_LIST_IS_EMPTY(&osp->sr_work)) continue;
+
+	    /* Only the assignment at the head is actually running.
+	     * With several assignments pipelined, the server's last
+	     * send says nothing about how long this one has taken.
+	     */
+	    lp = BU_LIST_FIRST(list, &osp->sr_work);
+	    if (lp->li_cancelled || lp->li_twin != LIST_NULL) continue;
+	    fr = lp->li_frame;
+	    CHECK_FRAME(fr);
+	    if (BU_LIST_NON_EMPTY(&fr->fr_todo)) continue;
+	    if (sp->sr_curframe != fr &&
+		(sp->sr_curframe != FRAME_NULL || fr->fr_needgettree))
+		continue;
+
+	    cost = cost_estimate(fr, lp->li_start, lp->li_stop);
+	    elapsed = tvdiff(nowp, &lp->li_starttime);
+	    expected = (osp->sr_w_elapsed > 0.0) ? cost / osp->sr_w_elapsed : 0.0;
+	    if (elapsed < REISSUE_MIN_TIME || elapsed < REISSUE_FACTOR * expected)
+		continue;
+
+	    /* Not worth it unless this server could redo it sooner */
+	    if (sp->sr_w_elapsed > 0.0 && cost / sp->sr_w_elapsed >= elapsed)
+		continue;
+
+	    if (best == LIST_NULL || elapsed - expected > best_late) {
+		best = lp;
+		best_sp = osp;
+		best_late = elapsed - expected;
+	    }
+	}
+	if (best == LIST_NULL) continue;
+
+	fr = best->li_frame;
+	if (sp->sr_curframe != fr) {
+	    sp->sr_curframe = fr;
+	    send_matrix(sp, fr);
+	    if (sp->sr_state != SRST_READY) continue;
+	}
+
+	bu_log("%s re-issuing fr%ld %d..%d from %s to %s\n", stamp(),
+	       fr->fr_number, best->li_start, best->li_stop,
+	       best_sp->sr_host->ht_name, sp->sr_host->ht_name);
+
+	GET_LIST(lp);
+	lp->li_frame = fr;
+	lp->li_start = best->li_start;
+	lp->li_stop = best->li_stop;
+	lp->li_twin = best;
+	best->li_twin = lp;
+	BU_LIST_INSERT(&sp->sr_work, &lp->l);
+	sp->sr_lump = lp->li_stop - lp->li_start + 1;
+	sp->sr_l_cost = cost_estimate(fr, lp->li_start, lp->li_stop);
+	send_do_lines(sp, lp->li_start, lp->li_stop, fr->fr_number);
+	lp->li_starttime = sp->sr_sendtime;
+    }
+}
+
+
 /*
  * This routine is called by the main loop, after each batch of PKGs
  * have arrived.
@@ -1889,6 +2217,10 @@ top:
 	work_allocate_method--;
 	goto top;
     }
+
+    /* Put idle servers to work on whatever is holding up a frame */
+    reissue_stragglers(nowp);
+
     /* No work remains to be assigned, or servers are stuffed full */
 out:
     scheduler_going = 0;
@@ -2281,6 +2613,25 @@ cd_allocate(const int argc, const char **argv)
 }
 
 
+static int
+cd_reissue(const int argc, const char **argv)
+{
+    if (argc < 2)
+	return 1;
+
+    if (BU_STR_EQUAL(argv[1], "on")) {
+	reissue = 1;
+    } else if (BU_STR_EQUAL(argv[1], "off")) {
+	reissue = 0;
+    } else {
+	bu_log("%s Bad reissue setting '%s'\n", stamp(), argv[1]);
+	return -1;
+    }
+
+    return 0;
+}
+
+
 static int
 cd_restart(const int argc, const char **argv)
 {
@@ -3167,6 +3518,7 @@ ph_pixels(struct pkg_conn *pc, char *buf)
     int npix;
     int fd;
     ssize_t cnt;
+    double ncost;
     struct bu_external ext;
 
     (void)gettimeofday(&tvnow, (struct timezone *)0);
@@ -3226,6 +3578,31 @@ ph_pixels(struct pkg_conn *pc, char *buf)
      * then the server is dropped.
      */
     lp = BU_LIST_FIRST(list, &sp->sr_work);
+
+    if (lp->li_cancelled) {
+	/*
+	 * Another server already returned this span (or its frame is
+	 * gone).  Still hold the reply to the assignment, but toss
+	 * the pixels.
+	 */
+	if (info.li_startpix != lp->li_start ||
+	    info.li_endpix != lp->li_stop) {
+	    bu_log("%s:  assignment mismatch, sent %d..%d, got %d..%d\n",
+		   sp->sr_host->ht_name,
+		   lp->li_start, lp->li_stop,
+		   info.li_startpix, info.li_endpix);
+	    drop_server(sp, "pixel assignment mismatch");
+	    goto out;
+	}
+	if (rem_debug)
+	    bu_log("%s %s discarding superseded %d..%d\n", stamp(),
+		   sp->sr_host->ht_name, lp->li_start, lp->li_stop);
+	BU_LIST_DEQUEUE(&lp->l);
+	FREE_LIST(lp);
+	start_next_assignment(sp);
+	goto out;
+    }
+
     fr = lp->li_frame;
     CHECK_FRAME(fr);
 
@@ -3309,6 +3686,8 @@ ph_pixels(struct pkg_conn *pc, char *buf)
     fr->fr_nrays += info.li_nrays;
     fr->fr_cpu += info.li_cpusec;
     sp->sr_l_percent = info.li_percent;
+    ncost = cost_estimate(fr, info.li_startpix, info.li_endpix);
+    cost_record(fr, info.li_startpix, info.li_endpix, info.li_cpusec);
     if (sp->sr_l_elapsed > MIN_ELAPSED_TIME) {
 	double blend1;	/* fraction of historical value to use */
 	double blend2;	/* fraction of new value to use */
@@ -3336,7 +3715,7 @@ ph_pixels(struct pkg_conn *pc, char *buf)
 	}
 	blend2 = 1 - blend1;
 
-	sp->sr_l_el_rate = npix / sp->sr_l_elapsed;
+	sp->sr_l_el_rate = ncost / sp->sr_l_elapsed;
 	sp->sr_w_elapsed = blend1 * sp->sr_w_elapsed +
 	    blend2 * sp->sr_l_el_rate;
 	sp->sr_w_rays = blend1 * sp->sr_w_rays +
@@ -3348,8 +3727,16 @@ ph_pixels(struct pkg_conn *pc, char *buf)
 	sp->sr_nsamp++;
     }
 
-    /* Remove from work list */
-    list_remove(&(sp->sr_work), info.li_startpix, info.li_endpix);
+    /* Remove from work list.  If this span was re-issued, the
+     * other copy is now moot.
+     */
+    if (lp->li_twin != LIST_NULL) {
+	lp->li_twin->li_cancelled = 1;
+	lp->li_twin->li_twin = LIST_NULL;
+    }
+    BU_LIST_DEQUEUE(&lp->l);
+    FREE_LIST(lp);
+    start_next_assignment(sp);
 
 /*
  * Check to see if this host is load limited.  If the host is loaded
@@ -3730,6 +4117,8 @@ struct command_tab cmd_tab[] = {
      cd_resume,	2, 2},
     {"allocteby", "allocateby", "Work allocation method",
      cd_allocate,	2, 2},
+    {"reissue", "on|off",	"re-issue straggling work to idle servers",
+     cd_reissue,	2, 2},
     {"restart", "[host]",	"restart one or all hosts",
      cd_restart,	1, 2},
     {"go", "",		"start scheduling frames",
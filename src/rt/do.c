@@ -44,6 +44,7 @@
 #include "bu/debug.h"
 #include "bu/getopt.h"
 #include "bu/mime.h"
+#include "bu/path.h"
 #include "bu/vls.h"
 #include "vmath.h"
 #include "raytrace.h"
@@ -78,10 +79,30 @@ void do_ae(double azim, double elev);
 void res_pr(void);
 void memory_summary(void);
 extern void worker(int cpu, void *arg);
+static void flush_clean(struct rt_i *rtip, int try_reprep);
 
 extern struct icv_image *bif;
 unsigned char *pixmap = NULL; /**< Pixel Map for rerendering of black pixels */
 
+/*
+ * Animation scripts typically "clean" and then "anim" before every
+ * frame.  With "set incremental_prep=1" the clean is held back until
+ * the frame starts, and if by then only "anim" commands have been
+ * seen, just the objects animated in this frame or the last one are
+ * unprepped and reprepped (rt_unprep()/rt_reprep()).  Their new
+ * solids are inserted into the existing space partitioning tree and
+ * the rest of the model is left alone.
+ */
+static int incremental_prep = 0;	/* re-prep only animated objects */
+static int clean_pending = 0;		/* a "clean" is waiting for the frame */
+static int trees_from_cmd = 0;		/* trees came from "tree", not objv */
+static struct bu_ptbl anim_cmds = BU_PTBL_INIT_ZERO;	/* held "anim" argv copies */
+static struct bu_ptbl anim_objs = BU_PTBL_INIT_ZERO;	/* objects animated in the prepped model */
+static size_t reprep_solids = 0;	/* solids reprepped since the tree was built */
+
+/* rebuild the tree once this fraction of the solids have moved */
+#define REPREP_REBUILD_FRACTION 0.5
+
 
 /**
  * Acquire particulars about a frame, in the old format.  Returns -1
@@ -305,6 +326,9 @@ int cm_end(const int UNUSED(argc), const char **UNUSED(argv))
 {
     struct rt_i *rtip = APP.a_rt_i;
 
+    if (rtip)
+	flush_clean(rtip, 1);
+
     if (rtip && BU_LIST_IS_EMPTY(&rtip->HeadRegion)) {
 	def_tree(rtip);		/* Load the default trees */
     }
@@ -325,6 +349,7 @@ int cm_draw(const int argc, const char **argv)
 {
     int i = 0;
     size_t j = 0;
+    flush_clean(APP.a_rt_i, 0);
     if (!cmd_objs || argc < 2) {
 	return 0;
     }
@@ -349,6 +374,7 @@ int cm_erase(const int argc, const char **argv)
 {
     int i = 0;
     size_t j = 0;
+    flush_clean(APP.a_rt_i, 0);
     if (!cmd_objs) {
 	return 0;
     }
@@ -371,6 +397,7 @@ int cm_prep(const int UNUSED(argc), const char **UNUSED(argv))
     struct bu_vls times = BU_VLS_INIT_ZERO;
     int objcnt = 0;
     const char **objargv = NULL;
+    flush_clean(rtip, 0);
     if (!cmd_objs) {
 	return 0;
     }
@@ -381,8 +408,13 @@ int cm_prep(const int UNUSED(argc), const char **UNUSED(argv))
     objargv = (const char **)cmd_objs->buffer;
 
     rt_prep_timer();
-    if (rt_gettrees(rtip, objcnt, objargv, (size_t)npsw) < 0)
+    if (rt_gettrees(rtip, objcnt, objargv, (size_t)npsw) < 0) {
 	bu_log("rt_gettrees() FAILED\n");
+	/* a partial model is no use to a render farm */
+	if (rtip->rti_mem_dropped)
+	    bu_exit(EXIT_FAILURE, "rt: prep exceeds LIBRT_MEM_BUDGET\n");
+    }
+    trees_from_cmd = 1;
     (void)rt_get_timer(&times, NULL);
 
     if (rt_verbosity & VERBOSE_STATS)
@@ -428,6 +460,8 @@ int cm_multiview(const int UNUSED(argc), const char **UNUSED(argv))
 	60, 60, 60, 60, 60, 60, 60
     };
 
+    if (rtip)
+	flush_clean(rtip, 0);
     if (rtip && BU_LIST_IS_EMPTY(&rtip->HeadRegion)) {
 	def_tree(rtip);		/* Load the default trees */
     }
@@ -439,6 +473,245 @@ int cm_multiview(const int UNUSED(argc), const char **UNUSED(argv))
 }
 
 
+/* the object whose placement an "anim" path changes, NULL for root */
+static const char *
+anim_obj(const char *path)
+{
+    const char *cp = strrchr(path, '/');
+
+    if (!cp)
+	return path;
+    if (cp == path)
+	return NULL;	/* "/obj" animates from the root */
+    return (*(cp+1)) ? cp+1 : NULL;
+}
+
+
+static void
+anim_objs_add(struct bu_ptbl *objs, const char *name)
+{
+    size_t i;
+
+    for (i = 0; i < BU_PTBL_LEN(objs); i++) {
+	if (BU_STR_EQUAL((const char *)BU_PTBL_GET(objs, i), name))
+	    return;
+    }
+    bu_ptbl_ins(objs, (long *)bu_strdup(name));
+}
+
+
+static void
+anim_objs_free(struct bu_ptbl *objs)
+{
+    size_t i;
+
+    for (i = 0; i < BU_PTBL_LEN(objs); i++)
+	bu_free((char *)BU_PTBL_GET(objs, i), "anim obj");
+    bu_ptbl_reset(objs);
+}
+
+
+/* parse the held "anim" commands, remembering what they move */
+static int
+anim_apply(struct rt_i *rtip)
+{
+    size_t i;
+    int ret = 0;
+
+    anim_objs_free(&anim_objs);
+    for (i = 0; i < BU_PTBL_LEN(&anim_cmds); i++) {
+	char **av = (char **)BU_PTBL_GET(&anim_cmds, i);
+	int ac = 0;
+	const char *obj;
+
+	while (av[ac])
+	    ac++;
+	if (db_parse_anim(rtip->rti_dbip, ac, (const char **)av) < 0) {
+	    bu_log("cm_anim:  %s %s failed\n", av[1], av[2]);
+	    ret = -1;
+	    continue;
+	}
+	obj = anim_obj(av[1]);
+	if (obj)
+	    anim_objs_add(&anim_objs, obj);
+    }
+    return ret;
+}
+
+
+static void
+anim_cmds_free(void)
+{
+    size_t i;
+
+    for (i = 0; i < BU_PTBL_LEN(&anim_cmds); i++) {
+	char **av = (char **)BU_PTBL_GET(&anim_cmds, i);
+	int ac = 0;
+
+	while (av[ac])
+	    ac++;
+	bu_argv_free((size_t)ac, av);
+    }
+    bu_ptbl_reset(&anim_cmds);
+}
+
+
+static void
+reprep_list_free(struct rt_reprep_obj_list *objs)
+{
+    size_t i;
+
+    for (i = 0; i < BU_PTBL_LEN(&objs->paths); i++) {
+	struct db_full_path *path = (struct db_full_path *)BU_PTBL_GET(&objs->paths, i);
+	db_free_full_path(path);
+	bu_free(path, "db_full_path");
+    }
+    bu_ptbl_free(&objs->paths);
+    bu_ptbl_free(&objs->unprep_regions);
+    if (objs->tsp)
+	bu_free(objs->tsp, "objs->tsp");	/* the states themselves are gone */
+    bu_free(objs->unprepped, "unprepped");
+}
+
+
+/**
+ * Re-prep the objects moved by this frame's or the previous frame's
+ * animation, with the shaders already released.  Returns 0 if the
+ * model is ready to raytrace, -1 if it needs a full clean and prep.
+ */
+static int
+anim_reprep(struct rt_i *rtip)
+{
+    struct rt_reprep_obj_list objs;
+    struct bu_ptbl names = BU_PTBL_INIT_ZERO;
+    struct bu_vls times = BU_VLS_INIT_ZERO;
+    size_t nsolids_with_pieces;
+    size_t i;
+    int ret;
+
+    if (rtip->needprep || BU_LIST_IS_EMPTY(&rtip->HeadRegion))
+	return -1;	/* nothing prepped to keep */
+    if (rtip->rti_instance_prep || rtip->rti_space_partition != RT_PART_NUBSPT)
+	return -1;
+    if (reprep_solids > rtip->nsolids * REPREP_REBUILD_FRACTION)
+	return -1;	/* the tree no longer fits the model */
+
+    /* objects that moved last frame move back, or move again */
+    bu_ptbl_init(&names, 8, "reprep names");
+    for (i = 0; i < BU_PTBL_LEN(&anim_objs); i++)
+	anim_objs_add(&names, (const char *)BU_PTBL_GET(&anim_objs, i));
+    for (i = 0; i < BU_PTBL_LEN(&anim_cmds); i++) {
+	char **av = (char **)BU_PTBL_GET(&anim_cmds, i);
+	const char *obj = anim_obj(av[1]);
+
+	if (!obj)
+	    break;
+	anim_objs_add(&names, obj);
+    }
+    if (i < BU_PTBL_LEN(&anim_cmds)) {
+	/* a root animation moves everything */
+	anim_objs_free(&names);
+	bu_ptbl_free(&names);
+	return -1;
+    }
+    if (!BU_PTBL_LEN(&names)) {
+	/* nothing moved, only the shaders need setting up again */
+	bu_ptbl_free(&names);
+	bu_ptbl_reset(&rtip->delete_regs);
+	view_setup(rtip);
+	return 0;
+    }
+
+    memset(&objs, 0, sizeof(objs));
+    if (trees_from_cmd) {
+	objs.ntopobjs = BU_PTBL_LEN(cmd_objs);
+	objs.topobjs = (char **)cmd_objs->buffer;
+    } else {
+	objs.ntopobjs = (size_t)objc;
+	objs.topobjs = objv;
+    }
+    objs.nunprepped = BU_PTBL_LEN(&names);
+    objs.unprepped = (char **)bu_calloc(objs.nunprepped, sizeof(char *), "unprepped");
+    for (i = 0; i < objs.nunprepped; i++)
+	objs.unprepped[i] = (char *)BU_PTBL_GET(&names, i);
+
+    rt_prep_timer();
+
+    /* piece state is sized to the old model and is allocated again
+     * on the next shot.  rt_res_pieces_clean() zeroes the count it
+     * walks, so hand every resource the full count and keep it for
+     * the solids that stay prepped. */
+    nsolids_with_pieces = rtip->rti_nsolids_with_pieces;
+    for (i = 0; i < BU_PTBL_LEN(&rtip->rti_resources); i++) {
+	struct resource *resp = (struct resource *)BU_PTBL_GET(&rtip->rti_resources, i);
+	if (!resp)
+	    continue;
+	rtip->rti_nsolids_with_pieces = nsolids_with_pieces;
+	rt_res_pieces_clean(resp, rtip);
+    }
+    rtip->rti_nsolids_with_pieces = nsolids_with_pieces;
+
+    /* unprep with the old animation still in place, so the matrices match */
+    ret = rt_unprep(rtip, &objs, &resource[0]);
+    if (!ret) {
+	db_free_anim(rtip->rti_dbip);
+	(void)anim_apply(rtip);
+	ret = rt_reprep(rtip, &objs, &resource[0]);
+	rtip->rti_add_to_new_solids_list = 0;
+    }
+    if (ret) {
+	bu_log("rt: unable to re-prep animated objects, re-prepping everything\n");
+	reprep_list_free(&objs);
+	anim_objs_free(&names);
+	bu_ptbl_free(&names);
+	return -1;
+    }
+
+    reprep_solids += objs.nsolids_unprepped;
+
+    /* invisible light regions are collected again by view_setup() */
+    bu_ptbl_reset(&rtip->delete_regs);
+    view_setup(rtip);
+
+    (void)rt_get_timer(&times, NULL);
+    if (rt_verbosity & VERBOSE_STATS)
+	bu_log("REPREP: %zu solids in %zu regions: %s\n",
+	       objs.nsolids_unprepped, objs.nregions_unprepped, bu_vls_addr(&times));
+    bu_vls_free(&times);
+
+    reprep_list_free(&objs);
+    anim_objs_free(&names);
+    bu_ptbl_free(&names);
+    return 0;
+}
+
+
+/**
+ * Carry out a held "clean".  With try_reprep, first see if the
+ * animated objects can be reprepped in place.
+ */
+static void
+flush_clean(struct rt_i *rtip, int try_reprep)
+{
+    if (!clean_pending)
+	return;
+    clean_pending = 0;
+
+    /* Allow lighting model clean up (e.g. lights, materials, etc.) */
+    view_cleanup(rtip);
+
+    if (!try_reprep || anim_reprep(rtip) < 0) {
+	rt_clean(rtip);	/* also drops the animation */
+	reprep_solids = 0;
+	(void)anim_apply(rtip);
+    }
+    anim_cmds_free();
+
+    if (OPTICAL_DEBUG&OPTICAL_DEBUG_RTMEM_END)
+	bu_prmem("After cm_clean");
+}
+
+
 /**
  * Experimental animation code
  *
@@ -446,6 +719,13 @@ int cm_multiview(const int UNUSED(argc), const char **UNUSED(argv))
  */
 int cm_anim(const int argc, const char **argv)
 {
+    if (clean_pending) {
+	/* applied when the frame starts, see flush_clean() */
+	if (!BU_PTBL_IS_INITIALIZED(&anim_cmds) || !anim_cmds.buffer)
+	    bu_ptbl_init(&anim_cmds, 8, "anim cmds");
+	bu_ptbl_ins(&anim_cmds, (long *)bu_argv_dup((size_t)argc, argv));
+	return 0;
+    }
 
     if (db_parse_anim(APP.a_rt_i->rti_dbip, argc, argv) < 0) {
 	bu_log("cm_anim:  %s %s failed\n", argv[1], argv[2]);
@@ -460,6 +740,13 @@ int cm_anim(const int argc, const char **argv)
  */
 int cm_clean(const int UNUSED(argc), const char **UNUSED(argv))
 {
+    if (incremental_prep) {
+	clean_pending = 1;
+	if (!BU_PTBL_IS_INITIALIZED(&anim_objs) || !anim_objs.buffer)
+	    bu_ptbl_init(&anim_objs, 8, "anim objs");
+	return 0;
+    }
+
     /* Allow lighting model clean up (e.g. lights, materials, etc.) */
     view_cleanup(APP.a_rt_i);
 
@@ -479,6 +766,7 @@ int cm_clean(const int UNUSED(argc), const char **UNUSED(argv))
  */
 int cm_closedb(const int UNUSED(argc), const char **UNUSED(argv))
 {
+    flush_clean(APP.a_rt_i, 0);
     db_close(APP.a_rt_i->rti_dbip);
     APP.a_rt_i->rti_dbip = DBI_NULL;
 
@@ -499,6 +787,7 @@ struct bu_structparse set_parse[] = {
     {"%d",	1, "width",			bu_byteoffset(width),			BU_STRUCTPARSE_FUNC_NULL, NULL, NULL },
     {"%d",	1, "height",			bu_byteoffset(height),			BU_STRUCTPARSE_FUNC_NULL, NULL, NULL },
     {"%d",	1, "save_overlaps",		bu_byteoffset(save_overlaps),		BU_STRUCTPARSE_FUNC_NULL, NULL, NULL },
+    {"%d",	1, "incremental_prep",		bu_byteoffset(incremental_prep),	BU_STRUCTPARSE_FUNC_NULL, NULL, NULL },
     {"%f",	1, "perspective",		bu_byteoffset(rt_perspective),		BU_STRUCTPARSE_FUNC_NULL, NULL, NULL },
     {"%f",	1, "angle",			bu_byteoffset(rt_perspective),		BU_STRUCTPARSE_FUNC_NULL, NULL, NULL },
 #if !defined(_WIN32) || defined(__CYGWIN__)
@@ -578,7 +867,10 @@ def_tree(register struct rt_i *rtip)
     rt_prep_timer();
     if (rt_gettrees(rtip, objc, (const char **)objv, (size_t)npsw) < 0) {
 	bu_log("rt_gettrees(%s) FAILED\n", (objv && objv[0]) ? objv[0] : "ERROR");
+	if (rtip->rti_mem_dropped)
+	    bu_exit(EXIT_FAILURE, "rt: prep exceeds LIBRT_MEM_BUDGET\n");
     }
+    trees_from_cmd = 0;
     (void)rt_get_timer(&times, NULL);
 
     if (rt_verbosity & VERBOSE_STATS)
@@ -765,6 +1057,7 @@ do_prep(struct rt_i *rtip)
     }
     memory_summary();
     if (rt_verbosity & VERBOSE_STATS) {
+	rt_pr_mem_info(rtip, 10);
 	bu_log("%s: %zu cut, %zu box (%zu empty)\n",
 	       rtip->rti_space_partition == RT_PART_NUBSPT ?
 	       "NUBSP" : "unknown",
@@ -1011,8 +1304,22 @@ do_frame(int framenumber)
 #ifndef RT_TXT_OUTPUT
 	    /* FIXME: in the case of rtxray, this is wrong.  it writes
 	     * out a bw image so depth should be just 1, not 3.
+	     *
+	     * Unless writing a dpix file, the image only ever goes out
+	     * as 8-bit values, so store it that way rather than as
+	     * doubles.
 	     */
-	    bif = icv_create(width, height, ICV_COLOR_SPACE_RGB);
+	    {
+		struct bu_vls ext = BU_VLS_INIT_ZERO;
+		ICV_DATA dtype = ICV_DATA_UCHAR;
+
+		if (bu_path_component(&ext, framename, BU_PATH_EXT)
+		    && bu_file_mime(bu_vls_cstr(&ext), BU_MIME_IMAGE) == BU_MIME_IMAGE_DPIX)
+		    dtype = ICV_DATA_DOUBLE;
+		bu_vls_free(&ext);
+
+		bif = icv_create_typed(width, height, ICV_COLOR_SPACE_RGB, dtype);
+	    }
 
 	    if (bif == NULL && (outfp = fopen(framename, "w+b")) == NULL) {
 		perror(framename);
@@ -1096,6 +1403,13 @@ do_frame(int framenumber)
 	    do_run(pix_start, pix_end);
 	}
     }
+    else if (progressive && !fullfloat_mode && !random_mode) {
+	do_progressive(pix_start, pix_end);
+
+	/* Reset values to full size, for next frame (if any) */
+	pix_start = 0;
+	pix_end = (int)(height*width - 1);
+    }
     else {
 	do_run(pix_start, pix_end);
 
@@ -129,6 +129,8 @@ extern size_t incr_level;		/* current incremental level */
 extern size_t incr_nlevel;		/* number of levels */
 extern size_t full_incr_sample;         /* current fully incremental sample */
 extern size_t full_incr_nsamples;       /* number of fully incremental samples */
+extern int progressive;			/* !0 for progressive refinement */
+extern double progressive_budget;	/* seconds to refine for, 0 for no limit */
 extern size_t width;			/* # of pixels in X */
 extern struct floatpixel *curr_float_frame;	/* buffer of full frame */
 extern struct floatpixel *prev_float_frame;
@@ -166,6 +168,7 @@ extern int pix_start;			/* pixel to start at */
 extern void def_tree(struct rt_i *rtip);
 extern void do_prep(struct rt_i *rtip);
 extern void do_run(int a, int b);
+extern void do_progressive(int a, int b);
 extern void do_ae(double azim, double elev);
 extern int old_way(FILE *fp);
 extern int do_frame(int framenumber);
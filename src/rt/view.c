@@ -117,6 +117,7 @@ static int buf_mode=0;
 #define BUFMODE_ACC       7     /* Cumulative buffer - The buffer
 				   always have the average of the
 				   colors sampled for each pixel */
+#define BUFMODE_PROG      8	/* progressive, whole frame rewritten each pass */
 
 vect_t kut_norm = VINIT_ZERO;
 struct soltab *kut_soltab = NULL;
@@ -164,6 +165,8 @@ struct bu_structparse view_parse[] = {
     {"%g", 1, "ambRadius", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
     {"%g", 1, "ambOffset", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
     {"%d", 1, "ambSlow", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
+    {"%d", 1, "progressive", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
+    {"%g", 1, "progressive_budget", 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL},
     {"", 0, (char *)0, 0, BU_STRUCTPARSE_FUNC_NULL, NULL, NULL}
 };
 
@@ -362,8 +365,10 @@ view_pixel(struct application *ap)
 
 	    /*
 	     * Only one CPU is working on this scanline, no parallel
-	     * interlock required! Much faster.
+	     * interlock required! Much faster.  Progressive passes
+	     * hand out whole scanlines too.
 	     */
+	case BUFMODE_PROG:
 	case BUFMODE_SCANLINE:
 	    slp = &scanline[ap->a_y];
 	    if (slp->sl_buf == (unsigned char *)0) {
@@ -486,6 +491,7 @@ view_pixel(struct application *ap)
 	    break;
 
 	case BUFMODE_ACC:
+	case BUFMODE_PROG:
 	case BUFMODE_SCANLINE:
 	case BUFMODE_DYNAMIC:
 	    if (fbp != FB_NULL) {
@@ -523,6 +529,10 @@ view_pixel(struct application *ap)
 	    }
 	    bu_free(scanline[ap->a_y].sl_buf, "sl_buf scanline buffer");
 	    scanline[ap->a_y].sl_buf = (unsigned char *)0;
+
+	    /* the next progressive pass writes this scanline again */
+	    if (buf_mode == BUFMODE_PROG)
+		scanline[ap->a_y].sl_left = sub_grid_mode ? sub_xmax-sub_xmin+1 : (int)width;
     }
 }
 
@@ -1551,6 +1561,8 @@ view_2init(struct application *ap, char *UNUSED(framename))
 	buf_mode = BUFMODE_INCR;
     } else if (full_incr_mode) {
 	buf_mode = BUFMODE_ACC;
+    } else if (progressive && !random_mode) {
+	buf_mode = BUFMODE_PROG;
     } else if (width <= 96 || random_mode) {
 	buf_mode = BUFMODE_UNBUF;
     } else if ((size_t)npsw <= (size_t)height/4) {
@@ -1636,8 +1648,13 @@ view_2init(struct application *ap, char *UNUSED(framename))
 		return;		 /* more res to come */
 	    break;
 
+	case BUFMODE_PROG:
+	    if (rt_verbosity & VERBOSE_INCREMENTAL)
+		bu_log("Mode: progressive refinement\n");
+	    /* Fall through... */
 	case BUFMODE_SCANLINE:
-	    bu_log("Mode: scanline-per-CPU buffering\n");
+	    if (buf_mode == BUFMODE_SCANLINE)
+		bu_log("Mode: scanline-per-CPU buffering\n");
 	    /* Fall through... */
 	case BUFMODE_DYNAMIC:
 	    if ((buf_mode == BUFMODE_DYNAMIC) && (rt_verbosity & VERBOSE_OUTPUTFILE)) {
@@ -1843,6 +1860,8 @@ application_init(void)
     view_parse[ 9].sp_offset = bu_byteoffset(ambRadius);
     view_parse[10].sp_offset = bu_byteoffset(ambOffset);
     view_parse[11].sp_offset = bu_byteoffset(ambSlow);
+    view_parse[12].sp_offset = bu_byteoffset(progressive);
+    view_parse[13].sp_offset = bu_byteoffset(progressive_budget);
 
     option("", "-A #", "Set image brightness, ambient light intensity (default: 0.4)", 0);
     option("Raytrace", "-i", "Enable incremental (progressive-style) rendering", 1);
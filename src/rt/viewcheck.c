@@ -29,6 +29,12 @@
  * can be run anywhere, and the results piped back for local viewing,
  * for example, on a workstation.
  *
+ * Overlaps are gathered per thread, keyed on the pair of region bits,
+ * and only merged at the end of the frame, so the checking itself
+ * runs without contention.  With -c "set summary=file.csv" (or
+ * file.json) the overlapping pairs are also written, sorted by region
+ * name, in a form that can be diffed between runs.
+ *
  * ToDo: It would be nice if we could pass in (1) an overlap depth
  * tolerance, (2) choose either region pair or solid pair grouping.
  *
@@ -39,7 +45,12 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "bu/bitv.h"
+#include "bu/hash.h"
 #include "bu/parallel.h"
+#include "bu/path.h"
+#include "bu/sort.h"
+#include "bu/vls.h"
 #include "vmath.h"
 #include "raytrace.h"
 #include "bv/plot3.h"
@@ -49,12 +60,19 @@
 
 #define OVLP_TOL 0.1
 
+/* plot lines a thread holds before writing them out */
+#define OVLP_PLOT_LINES 1024
+
 extern int rpt_overlap;		/* report overlapping region names */
 extern int output_is_binary;
 
 
+/* file for the sorted overlap summary, .json for JSON else CSV */
+static struct bu_vls summary_file = BU_VLS_INIT_ZERO;
+
 /* Viewing module specific "set" variables */
 struct bu_structparse view_parse[] = {
+    {"%V",	1, "summary",	bu_byteoffset(summary_file),	BU_STRUCTPARSE_FUNC_NULL, NULL, NULL },
     {"",	0, (char *)0,	0,		BU_STRUCTPARSE_FUNC_NULL, NULL, NULL }
 };
 
@@ -70,18 +88,76 @@ static size_t overlap_count;		/* Number of overlap pairs seen */
 static size_t unique_overlap_count;	/* Number of unique overlap pairs seen */
 
 /*
- * For each unique pair of regions that we find an overlap for
- * we build up one of these structures.
+ * For each ordered pair of regions that we find an overlap for we
+ * build up one of these structures.
  * Note that we could also discriminate at the solid pair level.
  */
 struct overlap_list {
-    struct overlap_list *next;	/* next one */
-    const char *reg1;		/* overlapping region 1 */
-    const char *reg2;		/* overlapping region 2 */
+    const struct region *reg1;	/* overlapping region 1 */
+    const struct region *reg2;	/* overlapping region 2 */
     size_t count;		/* number of time reported */
     double maxdepth;		/* maximum overlap depth */
 };
-static struct overlap_list *olist=NULL;	/* root of the list */
+
+/*
+ * What each thread has seen.  Only the thread itself touches its
+ * entry until view_end().
+ */
+struct overlap_state {
+    bu_hash_tbl *pairs;		/* overlap_list by region bit pair */
+    size_t noverlaps;
+    point_t *lines;		/* pending plot line end points */
+    size_t nlines;
+};
+static struct overlap_state ostate[MAX_PSW];
+
+/* numbers the verbose reports, which are serialized anyway */
+static size_t nreported;
+
+
+static void
+overlap_key(int key[2], const struct region *reg1, const struct region *reg2)
+{
+    key[0] = reg1->reg_bit;
+    key[1] = reg2->reg_bit;
+}
+
+
+/* write out a thread's buffered plot lines */
+static void
+overlap_flush(struct overlap_state *osp)
+{
+    size_t i;
+
+    if (!osp->nlines)
+	return;
+
+    bu_semaphore_acquire(BU_SEM_SYSCALL);
+    for (i = 0; i < osp->nlines; i++)
+	pdv_3line(outfp, osp->lines[2*i], osp->lines[2*i+1]);
+    bu_semaphore_release(BU_SEM_SYSCALL);
+    osp->nlines = 0;
+}
+
+
+static void
+overlap_state_free(void)
+{
+    bu_hash_entry *e;
+    int i;
+
+    for (i = 0; i < MAX_PSW; i++) {
+	struct overlap_state *osp = &ostate[i];
+	if (osp->pairs) {
+	    for (e = bu_hash_next(osp->pairs, NULL); e; e = bu_hash_next(osp->pairs, e))
+		bu_free(bu_hash_value(e, NULL), "overlap_list");
+	    bu_hash_destroy(osp->pairs);
+	}
+	if (osp->lines)
+	    bu_free(osp->lines, "overlap plot lines");
+	memset(osp, 0, sizeof(struct overlap_state));
+    }
+}
 
 
 /*
@@ -117,9 +193,13 @@ overlap(struct application *ap, struct partition *pp, struct region *reg1, struc
     register struct xray *rp = &ap->a_ray;
     register struct hit *ihitp = pp->pt_inhit;
     register struct hit *ohitp = pp->pt_outhit;
+    struct overlap_state *osp;
+    struct overlap_list *op;
     vect_t ihit;
     vect_t ohit;
     double depth;
+    int key[2];
+    int cpu;
 
     VJOIN1(ihit, rp->r_pt, ihitp->hit_dist, rp->r_dir);
     VJOIN1(ohit, rp->r_pt, ohitp->hit_dist, rp->r_dir);
@@ -127,79 +207,51 @@ overlap(struct application *ap, struct partition *pp, struct region *reg1, struc
     if (depth < OVLP_TOL)
 	return 0;
 
-    bu_semaphore_acquire(BU_SEM_SYSCALL);
-    pdv_3line(outfp, ihit, ohit);
-    noverlaps++;
-    bu_semaphore_release(BU_SEM_SYSCALL);
+    cpu = bu_parallel_id();
+    if (cpu < 0 || cpu >= MAX_PSW)
+	cpu = 0;
+    osp = &ostate[cpu];
+    osp->noverlaps++;
 
     if (!rpt_overlap) {
-	bu_log("OVERLAP %zu: %s\nOVERLAP %zu: %s\nOVERLAP %zu: depth %gmm\nOVERLAP %zu: in_hit_point (%g, %g, %g) mm\nOVERLAP %zu: out_hit_point (%g, %g, %g) mm\n------------------------------------------------------------\n",
-	       noverlaps, reg1->reg_name,
-	       noverlaps, reg2->reg_name,
-	       noverlaps, depth,
-	       noverlaps, ihit[X], ihit[Y], ihit[Z],
-	       noverlaps, ohit[X], ohit[Y], ohit[Z]);
-
-	/* If we report overlaps, don't print if already noted once.
-	 * Build up a linked list of known overlapping regions and compare
-	 * against it.
-	 */
-    } else {
-	struct overlap_list *prev_ol = (struct overlap_list *)0;
-	struct overlap_list *op;		/* overlap list */
-	struct overlap_list *new_op;
-
-	BU_ALLOC(new_op, struct overlap_list);
+	size_t n;
 
-	/* look for it in our list */
 	bu_semaphore_acquire(BU_SEM_SYSCALL);
-	for (op=olist; op; prev_ol=op, op=op->next) {
-
-	    /* if we already have an entry for this region pair,
-	     * we increase the counter and return
-	     */
-	    if ((BU_STR_EQUAL(reg1->reg_name, op->reg1)) && (BU_STR_EQUAL(reg2->reg_name, op->reg2))) {
-		op->count++;
-		if (depth > op->maxdepth)
-		    op->maxdepth = depth;
-		bu_semaphore_release(BU_SEM_SYSCALL);
-		bu_free((char *) new_op, "overlap list");
-		return 0;	/* already on list */
-	    }
-	}
-
-	for (op=olist; op; op=op->next) {
-	    /* if this pair was seen in reverse, decrease the unique counter */
-	    if ((BU_STR_EQUAL(reg1->reg_name, op->reg2)) && (BU_STR_EQUAL(reg2->reg_name, op->reg1))) {
-		unique_overlap_count--;
-		break;
-	    }
-	}
+	pdv_3line(outfp, ihit, ohit);
+	n = ++nreported;
+	bu_semaphore_release(BU_SEM_SYSCALL);
 
-	/* we have a new overlapping region pair */
-	overlap_count++;
-	unique_overlap_count++;
+	bu_log("OVERLAP %zu: %s\nOVERLAP %zu: %s\nOVERLAP %zu: depth %gmm\nOVERLAP %zu: in_hit_point (%g, %g, %g) mm\nOVERLAP %zu: out_hit_point (%g, %g, %g) mm\n------------------------------------------------------------\n",
+	       n, reg1->reg_name,
+	       n, reg2->reg_name,
+	       n, depth,
+	       n, ihit[X], ihit[Y], ihit[Z],
+	       n, ohit[X], ohit[Y], ohit[Z]);
+    } else {
+	if (!osp->lines)
+	    osp->lines = (point_t *)bu_malloc(2 * OVLP_PLOT_LINES * sizeof(point_t), "overlap plot lines");
+	VMOVE(osp->lines[2*osp->nlines], ihit);
+	VMOVE(osp->lines[2*osp->nlines+1], ohit);
+	if (++osp->nlines >= OVLP_PLOT_LINES)
+	    overlap_flush(osp);
+    }
 
-	op = new_op;
-	if (olist)		/* previous entry exists */
-	    prev_ol->next = op;
-	else
-	    olist = op;	/* finally initialize root */
-	op->reg1 = reg1->reg_name;
-	op->reg2 = reg2->reg_name;
+    /* count every region pair, whether or not we report them */
+    if (!osp->pairs)
+	osp->pairs = bu_hash_create(64);
+    overlap_key(key, reg1, reg2);
+    op = (struct overlap_list *)bu_hash_get(osp->pairs, (const uint8_t *)key, sizeof(key));
+    if (op) {
+	op->count++;
+	if (depth > op->maxdepth)
+	    op->maxdepth = depth;
+    } else {
+	BU_ALLOC(op, struct overlap_list);
+	op->reg1 = reg1;
+	op->reg2 = reg2;
 	op->maxdepth = depth;
-	op->next = NULL;
 	op->count = 1;
-	bu_semaphore_release(BU_SEM_SYSCALL);
-    }
-
-    /* useful debugging */
-    if (0) {
-	struct overlap_list *op;		/* overlap list */
-	bu_log("PRINTING LIST::reg1==%s, reg2==%s\n", reg1->reg_name, reg2->reg_name);
-	for (op=olist; op; op=op->next) {
-	    bu_log("\tpair: %s  %s  %zu matches\n", op->reg1, op->reg2, op->count);
-	}
+	bu_hash_set(osp->pairs, (const uint8_t *)key, sizeof(key), op);
     }
 
     return 0;	/* No further consideration to this partition */
@@ -238,17 +290,105 @@ view_2init(register struct application *ap, char *UNUSED(framename))
     register struct rt_i *rtip = ap->a_rt_i;
 
     pdv_3space(outfp, rtip->rti_pmin, rtip->rti_pmax);
+    overlap_state_free();
     noverlaps = 0;
+    nreported = 0;
     overlap_count = 0;
     unique_overlap_count = 0;
 }
 
 
+static int
+overlap_cmp(const void *a, const void *b, void *UNUSED(arg))
+{
+    const struct overlap_list *oa = *(const struct overlap_list * const *)a;
+    const struct overlap_list *ob = *(const struct overlap_list * const *)b;
+    int ret = bu_strcmp(oa->reg1->reg_name, ob->reg1->reg_name);
+
+    if (ret)
+	return ret;
+    return bu_strcmp(oa->reg2->reg_name, ob->reg2->reg_name);
+}
+
+
+static struct overlap_list *
+overlap_reverse(bu_hash_tbl *merged, const struct overlap_list *op)
+{
+    int key[2];
+
+    if (op->reg1 == op->reg2)
+	return NULL;
+    overlap_key(key, op->reg2, op->reg1);
+    return (struct overlap_list *)bu_hash_get(merged, (const uint8_t *)key, sizeof(key));
+}
+
+
+/*
+ * Fold the per-thread tables together.  Returns the ordered pairs
+ * sorted by region names, and the merged table to find reverses in.
+ */
+static struct overlap_list **
+overlap_merge(bu_hash_tbl **merged)
+{
+    struct overlap_list **olist;
+    bu_hash_entry *e;
+    size_t n = 0;
+    int i;
+
+    *merged = bu_hash_create(1024);
+
+    for (i = 0; i < MAX_PSW; i++) {
+	struct overlap_state *osp = &ostate[i];
+
+	noverlaps += osp->noverlaps;
+	if (!osp->pairs)
+	    continue;
+
+	for (e = bu_hash_next(osp->pairs, NULL); e; e = bu_hash_next(osp->pairs, e)) {
+	    struct overlap_list *op = (struct overlap_list *)bu_hash_value(e, NULL);
+	    struct overlap_list *mop;
+	    uint8_t *key;
+	    size_t keylen;
+
+	    bu_hash_key(e, &key, &keylen);
+	    mop = (struct overlap_list *)bu_hash_get(*merged, key, keylen);
+	    if (mop) {
+		mop->count += op->count;
+		if (op->maxdepth > mop->maxdepth)
+		    mop->maxdepth = op->maxdepth;
+	    } else {
+		BU_ALLOC(mop, struct overlap_list);
+		*mop = *op;	/* struct copy */
+		bu_hash_set(*merged, key, keylen, mop);
+		n++;
+	    }
+	}
+    }
+
+    olist = (struct overlap_list **)bu_calloc(n + 1, sizeof(struct overlap_list *), "overlap_list[]");
+    n = 0;
+    for (e = bu_hash_next(*merged, NULL); e; e = bu_hash_next(*merged, e))
+	olist[n++] = (struct overlap_list *)bu_hash_value(e, NULL);
+    bu_sort(olist, n, sizeof(struct overlap_list *), overlap_cmp, NULL);
+
+    overlap_count = n;
+    unique_overlap_count = n;
+    for (i = 0; (size_t)i < n; i++) {
+	struct overlap_list *rev = overlap_reverse(*merged, olist[i]);
+	if (rev && overlap_cmp(&rev, &olist[i], NULL) < 0)
+	    unique_overlap_count--;
+    }
+
+    return olist;
+}
+
+
 /*
  * Print out a summary of the overlaps found
  */
-static void print_overlap_summary(void) {
-    register struct overlap_list *op=0, *backop=0;
+static void
+print_overlap_summary(struct overlap_list **olist, struct rt_i *rtip)
+{
     size_t object_counter=0;
 
     /* if there are any overlaps, print out a summary report, otherwise just
@@ -262,32 +402,28 @@ static void print_overlap_summary(void) {
 	bu_log("\t%zu overlap%s detected\n", noverlaps, (noverlaps==1)?"":"s");
 	bu_log("\t%zu unique overlapping pair%s (%zu ordered pair%s)\n", unique_overlap_count, (unique_overlap_count==1)?"":"s", overlap_count, (overlap_count==1)?"":"s");
 
-	if (olist) {
-	    bu_log("\tOverlapping objects: ");
-
-	    for (op=olist; op; op=op->next) {
+	if (olist[0]) {
+	    struct bu_bitv *printed = bu_bitv_new(rtip->nregions);
+	    struct overlap_list **opp;
 
-		/* iterate over the list and see if we already printed this one */
-		for (backop=olist; (backop!=op) && (backop); backop=backop->next) {
-		    if ((BU_STR_EQUAL(op->reg1, backop->reg1)) || (BU_STR_EQUAL(op->reg1, backop->reg2))) break;
-		}
-		/* if we got to the end of the list (backop points to the match) */
-		if (!backop || (backop==op)) {
-		    bu_log("%s  ", op->reg1);
-		    object_counter++;
-		}
+	    bu_log("\tOverlapping objects: ");
 
-		/* iterate over the list again up to where we are to see if the second
-		 * region was already printed */
-		for (backop=olist; backop; backop=backop->next) {
-		    if ((BU_STR_EQUAL(op->reg2, backop->reg1)) || (BU_STR_EQUAL(op->reg2, backop->reg2))) break;
-		}
-		if (!backop || (backop==op)) {
-		    bu_log("%s  ", op->reg2);
+	    for (opp = olist; *opp; opp++) {
+		const struct region *regs[2];
+		int i;
+
+		regs[0] = (*opp)->reg1;
+		regs[1] = (*opp)->reg2;
+		for (i = 0; i < 2; i++) {
+		    if (BU_BITTEST(printed, regs[i]->reg_bit))
+			continue;
+		    BU_BITSET(printed, regs[i]->reg_bit);
+		    bu_log("%s  ", regs[i]->reg_name);
 		    object_counter++;
 		}
 	    }
 	    bu_log("\n\t%zu unique overlapping object%s detected\n", object_counter, (object_counter==1)?"":"s");
+	    bu_bitv_free(printed);
 	}
     } else {
 	bu_log("%zu overlap%s detected\n\n", noverlaps, (noverlaps==1)?"":"s");
@@ -295,86 +431,140 @@ static void print_overlap_summary(void) {
 }
 
 
+/* CSV fields are quoted when they hold a separator or a quote */
+static void
+summary_csv_name(FILE *fp, const char *name)
+{
+    const char *c;
+
+    if (!strpbrk(name, ",\"\n")) {
+	fputs(name, fp);
+	return;
+    }
+    fputc('"', fp);
+    for (c = name; *c; c++) {
+	if (*c == '"')
+	    fputc('"', fp);
+	fputc(*c, fp);
+    }
+    fputc('"', fp);
+}
+
+
+static void
+summary_json_name(FILE *fp, const char *name)
+{
+    const char *c;
+
+    fputc('"', fp);
+    for (c = name; *c; c++) {
+	if (*c == '"' || *c == '\\')
+	    fputc('\\', fp);
+	if ((unsigned char)*c < 0x20)
+	    fprintf(fp, "\\u%04x", (unsigned char)*c);
+	else
+	    fputc(*c, fp);
+    }
+    fputc('"', fp);
+}
+
+
+/*
+ * Write the overlapping pairs, one line or object per ordered pair,
+ * sorted so that runs over the same model can be compared with diff.
+ */
+static void
+write_overlap_summary(struct overlap_list **olist)
+{
+    struct bu_vls ext = BU_VLS_INIT_ZERO;
+    struct overlap_list **opp;
+    FILE *fp;
+    int json;
+
+    fp = fopen(bu_vls_cstr(&summary_file), "wb");
+    if (!fp) {
+	bu_log("rtcheck: unable to open %s for writing\n", bu_vls_cstr(&summary_file));
+	return;
+    }
+
+    json = (bu_path_component(&ext, bu_vls_cstr(&summary_file), BU_PATH_EXT) && BU_STR_EQUIV(bu_vls_cstr(&ext), "json"));
+    bu_vls_free(&ext);
+
+    if (json) {
+	fprintf(fp, "{\n  \"overlaps\": %zu,\n  \"pairs\": [", noverlaps);
+	for (opp = olist; *opp; opp++) {
+	    fprintf(fp, "%s\n    {\"region1\": ", (opp == olist) ? "" : ",");
+	    summary_json_name(fp, (*opp)->reg1->reg_name);
+	    fprintf(fp, ", \"region2\": ");
+	    summary_json_name(fp, (*opp)->reg2->reg_name);
+	    fprintf(fp, ", \"count\": %zu, \"max_depth_mm\": %.6f}", (*opp)->count, (*opp)->maxdepth);
+	}
+	fprintf(fp, "%s]\n}\n", (olist[0]) ? "\n  " : "");
+    } else {
+	fprintf(fp, "region1,region2,count,max_depth_mm\n");
+	for (opp = olist; *opp; opp++) {
+	    summary_csv_name(fp, (*opp)->reg1->reg_name);
+	    fputc(',', fp);
+	    summary_csv_name(fp, (*opp)->reg2->reg_name);
+	    fprintf(fp, ",%zu,%.6f\n", (*opp)->count, (*opp)->maxdepth);
+	}
+    }
+
+    fclose(fp);
+}
+
+
 /*
  * Called at the end of each frame
  */
 void
-view_end(struct application *UNUSED(ap)) {
+view_end(struct application *ap) {
+    struct overlap_list **olist, **opp;
+    bu_hash_tbl *merged;
+    bu_hash_entry *e;
+    int i;
+
+    for (i = 0; i < MAX_PSW; i++)
+	overlap_flush(&ostate[i]);
+
     pl_flush(outfp);
     fflush(outfp);
-    /* bu_log("%zu overlap%c detected\n\n", noverlaps, (noverlaps==1)?(char)NULL:'s'); */
 
-    /* bu_log("\nocount==%zu, unique_ocount==%zu\n\n", overlap_count, unique_overlap_count); */
+    olist = overlap_merge(&merged);
 
     if (rpt_overlap) {
-	/* using counters instead of the actual variables to be able to
-	 * summarize after checking for matching pairs
-	 */
-	size_t overlap_counter=overlap_count;
-	size_t unique_overlap_counter=unique_overlap_count;
-	register struct overlap_list *op=0, *backop=0, *nextop=0;
-
 	/* iterate over the overlap pairs and output one OVERLAP section
 	 * per unordered pair.  a summary is output at the end.
 	 */
 	bu_log("OVERLAP PAIRS\n------------------------------------------\n");
-	for (op=olist; op; op=op->next) {
-
-	    /* !!! would/should not need to do this..  need a doubly-linked
-	     * list so we can go backwards.  we look through the list and
-	     * see if we hit the reverse previously.
-	     */
-	    for (backop=olist; (backop!=op) && (backop); backop=backop->next) {
-		if ((BU_STR_EQUAL(op->reg2, backop->reg1)) && (BU_STR_EQUAL(op->reg1, backop->reg2))) break;
-	    }
-	    if (backop && (backop!=op)) continue;
-
-	    bu_log("%s and %s overlap\n", op->reg1, op->reg2);
-
-	    nextop=(struct overlap_list *)NULL;
-	    /* if there are still matching pairs to search for */
-	    if (overlap_counter > unique_overlap_counter) {
-
-		/* iterate until end of pairs or we find a
-		 * reverse matching pair (done inside loop
-		 * explicitly)*/
-		for (nextop=op; nextop; nextop=nextop->next) {
-		    if ((BU_STR_EQUAL(op->reg1, nextop->reg2)) &&
-			(BU_STR_EQUAL(op->reg2, nextop->reg1)))
-			break;
-		}
-		/* when we leave the loop, nextop is either
-		 * null (hit end of list) or the matching
-		 * reverse pair */
-	    }
-
-	    bu_log("\t<%s, %s>: %zu overlap%c detected, maximum depth is %gmm\n", op->reg1, op->reg2, op->count, op->count>1 ? 's' : (char) 0, op->maxdepth);
-	    if (nextop) {
-		bu_log("\t<%s, %s>: %zu overlap%c detected, maximum depth is %gmm\n", nextop->reg1, nextop->reg2, nextop->count, nextop->count>1 ? 's' : (char) 0, nextop->maxdepth);
-		/* counter the decrement below to account for
-		 * the matched reverse pair
-		 */
-		unique_overlap_counter++;
-	    }
-
-	    /* decrement so we may stop scanning for unique overlaps asap */
-	    unique_overlap_counter--;
-	    overlap_counter--;
+	for (opp = olist; *opp; opp++) {
+	    struct overlap_list *op = *opp;
+	    struct overlap_list *nextop = overlap_reverse(merged, op);
+
+	    /* the reverse sorted first, so this pair was already shown */
+	    if (nextop && overlap_cmp(&nextop, &op, NULL) < 0)
+		continue;
+
+	    bu_log("%s and %s overlap\n", op->reg1->reg_name, op->reg2->reg_name);
+	    bu_log("\t<%s, %s>: %zu overlap%c detected, maximum depth is %gmm\n", op->reg1->reg_name, op->reg2->reg_name, op->count, op->count>1 ? 's' : (char) 0, op->maxdepth);
+	    if (nextop)
+		bu_log("\t<%s, %s>: %zu overlap%c detected, maximum depth is %gmm\n", nextop->reg1->reg_name, nextop->reg2->reg_name, nextop->count, nextop->count>1 ? 's' : (char) 0, nextop->maxdepth);
 	}
 
 	/* print out a summary of the overlaps that were found */
-	print_overlap_summary();
-
-	/* free our structures */
-	op = olist;
-	while (op) {
-	    /* free struct */
-	    nextop = op->next;
-	    bu_free((char *)op, "overlap_list");
-	    op = nextop;
-	}
-	olist = (struct overlap_list *)NULL;
+	print_overlap_summary(olist, ap->a_rt_i);
     }
+
+    if (bu_vls_strlen(&summary_file))
+	write_overlap_summary(olist);
+
+    /* free our structures */
+    for (e = bu_hash_next(merged, NULL); e; e = bu_hash_next(merged, e))
+	bu_free(bu_hash_value(e, NULL), "overlap_list");
+    bu_hash_destroy(merged);
+    bu_free(olist, "overlap_list[]");
+    overlap_state_free();
+
     bu_log("\n");
 }
 
@@ -384,6 +574,7 @@ application_init (void)
 {
     option("", "-o file.plot3", "Specify a UNIX-plot output file", 0);
     option("", "-r", "Report only unique overlaps", 0);
+    option("", "-c \"set summary=file.csv\"", "Write overlapping pairs sorted, as CSV or (.json) JSON", 0);
 
     /* this reassignment hack ensures help is last in the first list */
     option("dummy", "-? or -h", "Display help", 1);
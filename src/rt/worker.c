@@ -31,6 +31,7 @@
 #include <math.h>
 
 #include "bu/log.h"
+#include "bu/time.h"
 #include "vmath.h"
 #include "bn.h"
 #include "raytrace.h"
@@ -79,6 +80,28 @@ int last_pixel = 0;			/* last pixel number */
 
 int stop_worker = 0;
 
+/* Progressive refinement, enabled by "set progressive=1" in rt */
+int progressive = 0;			/* !0 for progressive refinement */
+double progressive_budget = 0.0;	/* seconds to refine for, 0 for no limit */
+
+/**
+ * Samples accumulated for one pixel during a progressive frame.
+ */
+struct prog_pixel {
+    vect_t sum;		/* sum of the sample colors */
+    int nsamples;	/* samples shot in this pixel */
+    int nhits;		/* how many of them hit the model */
+};
+
+static struct prog_pixel *prog_buf = NULL;	/* full frame of samples */
+static size_t prog_stride = 0;		/* sample spacing of this pass, 0 if not progressive */
+static size_t prog_stride_max = 0;	/* sample spacing of the first pass */
+static int prog_skip = 0;		/* skip samples shot by the coarser pass */
+static int prog_first = 0;		/* first pixel of the frame */
+static int prog_last = 0;		/* last pixel of the frame */
+static int64_t prog_deadline = 0;	/* bu_gettime() to stop at, 0 for none */
+static size_t prog_row = 0;		/* next scanline for prog_fill_worker() */
+
 /**
  * For certain hypersample values there is a particular advantage to
  * subdividing the pixel and shooting a ray in each sub-pixel.  This
@@ -148,6 +171,22 @@ jitter_start_pnt(vect_t point, struct application *a, int samplenum, int pat_num
 }
 
 
+/**
+ * Add a finished sample to its pixel in the progressive frame.  Each
+ * pixel is shot by only one worker per pass, so no locking is needed.
+ */
+static void
+prog_store(const struct application *ap)
+{
+    struct prog_pixel *pp = &prog_buf[ap->a_y*width + ap->a_x];
+
+    VADD2(pp->sum, pp->sum, ap->a_color);
+    pp->nsamples++;
+    if (ap->a_user)
+	pp->nhits++;
+}
+
+
 void
 do_pixel(int cpu, int pat_num, int pixelnum)
 {
@@ -187,6 +226,17 @@ do_pixel(int cpu, int pat_num, int pixelnum)
 	}
 	a.a_x <<= (incr_nlevel-incr_level);
 	a.a_y <<= (incr_nlevel-incr_level);
+    } else if (prog_stride) {
+	size_t pw = (width + prog_stride - 1) / prog_stride;
+	a.a_y = (int)(pixelnum/pw);
+	a.a_x = (int)(pixelnum - (a.a_y * pw));
+	/* See if already done last pass */
+	if (prog_skip && ((a.a_x & 1) == 0) && ((a.a_y & 1) == 0))
+	    return;
+	a.a_x *= prog_stride;
+	a.a_y *= prog_stride;
+	if (a.a_y*(int)width + a.a_x < prog_first || a.a_y*(int)width + a.a_x > prog_last)
+	    return;
     } else {
 	a.a_y = (int)(pixelnum/width);
 	a.a_x = (int)(pixelnum - (a.a_y * width));
@@ -230,6 +280,10 @@ do_pixel(int cpu, int pat_num, int pixelnum)
 	    a.a_color[BLU]= (double)(pixmap[pindex + BLU]) * one_over_255;
 
 	    /* we're done */
+	    if (prog_buf) {
+		prog_store(&a);
+		return;
+	    }
 	    view_pixel(&a);
 	    if ((size_t)a.a_x == width-1) {
 		view_eol(&a);		/* End of scan line */
@@ -443,6 +497,10 @@ do_pixel(int cpu, int pat_num, int pixelnum)
     }
 
     /* we're done */
+    if (prog_buf) {
+	prog_store(&a);
+	return;
+    }
     view_pixel(&a);
     if ((size_t)a.a_x == width-1) {
 	view_eol(&a);		/* End of scan line */
@@ -555,6 +613,8 @@ pat_found:
 	while (1) {
 	    if (stop_worker)
 		return;
+	    if (prog_deadline && bu_gettime() >= prog_deadline)
+		return;
 
 	    bu_semaphore_acquire(RT_SEM_WORKER);
 	    pixel_start = cur_pixel;
@@ -619,6 +679,182 @@ do_run(int a, int b)
 }
 
 
+/**
+ * Color of a pixel in the progressive frame.  Pixels without samples
+ * of their own are interpolated bilinearly from the nearest samples
+ * on the grid of the current pass, falling back to the coarser grids
+ * where a pass was cut short.  Returns non-zero if the pixel should
+ * be drawn as a hit rather than as background.
+ */
+static int
+prog_lookup(size_t x, size_t y, vect_t color)
+{
+    size_t s;
+
+    for (s = prog_stride; s && s <= prog_stride_max; s <<= 1) {
+	size_t x0 = x - x % s;
+	size_t y0 = y - y % s;
+	fastf_t fx = (fastf_t)(x - x0) / s;
+	fastf_t fy = (fastf_t)(y - y0) / s;
+	fastf_t wsum = 0.0;
+	fastf_t hits = 0.0;
+	int i;
+
+	VSETALL(color, 0);
+	for (i = 0; i < 4; i++) {
+	    size_t cx = x0 + ((i & 1) ? s : 0);
+	    size_t cy = y0 + ((i & 2) ? s : 0);
+	    fastf_t w = ((i & 1) ? fx : 1.0 - fx) * ((i & 2) ? fy : 1.0 - fy);
+	    const struct prog_pixel *pp;
+
+	    if (w <= 0.0 || cx >= width || cy >= height)
+		continue;
+	    pp = &prog_buf[cy*width + cx];
+	    if (!pp->nsamples)
+		continue;
+
+	    VJOIN1(color, color, w / pp->nsamples, pp->sum);
+	    hits += w * pp->nhits / pp->nsamples;
+	    wsum += w;
+	}
+	if (wsum > 0.0) {
+	    VSCALE(color, color, 1.0 / wsum);
+	    return hits >= 0.5 * wsum;
+	}
+    }
+
+    VSETALL(color, 0);
+    return 0;
+}
+
+
+/**
+ * Hand the whole progressive frame to view_pixel(), a scanline at a
+ * time, so that the output always holds a complete image.
+ */
+static void
+prog_fill_worker(int cpu, void *UNUSED(arg))
+{
+    struct application a;
+    size_t x, y;
+    int pixelnum;
+
+    a = APP;				/* struct copy */
+    a.a_resource = &resource[cpu];
+
+    while (1) {
+	bu_semaphore_acquire(RT_SEM_WORKER);
+	y = prog_row++;
+	bu_semaphore_release(RT_SEM_WORKER);
+
+	if (y >= height)
+	    return;
+	if (sub_grid_mode && ((int)y < sub_ymin || (int)y > sub_ymax))
+	    continue;
+
+	for (x = 0; x < width; x++) {
+	    pixelnum = (int)(y*width + x);
+	    if (pixelnum < prog_first || pixelnum > prog_last)
+		continue;
+	    if (sub_grid_mode && ((int)x < sub_xmin || (int)x > sub_xmax))
+		continue;
+
+	    a.a_x = (int)x;
+	    a.a_y = (int)y;
+	    a.a_user = prog_lookup(x, y, a.a_color);
+	    view_pixel(&a);
+	    if (x == width-1)
+		view_eol(&a);	/* End of scan line */
+	}
+    }
+}
+
+
+/**
+ * Shoot one progressive pass of npix samples, then update the output.
+ * Returns non-zero once the time budget is used up.
+ */
+static int
+prog_pass(size_t npix)
+{
+    per_processor_chunk = 0;	/* re-pick the chunk size for this pass */
+    do_run(0, (int)npix - 1);
+
+    prog_row = 0;
+    if (!rtg_parallel)
+	prog_fill_worker(0, NULL);
+    else
+	bu_parallel(prog_fill_worker, (size_t)npsw, NULL);
+
+    return prog_deadline && bu_gettime() >= prog_deadline;
+}
+
+
+/**
+ * Compute a run of pixels progressively.  A sparse grid of samples is
+ * shot first and halved in spacing every pass down to one sample per
+ * pixel, after which each pass adds one more jittered sample per pixel
+ * until the hypersample count is reached.  The output is updated with
+ * an interpolated, complete image after every pass.  If
+ * progressive_budget is set, refinement stops once that many seconds
+ * have passed, keeping the image computed so far.
+ */
+void
+do_progressive(int a, int b)
+{
+    int save_hypersample = hypersample;
+    unsigned int save_jitter = jitter;
+    int save_chunk = per_processor_chunk;
+    int64_t start = bu_gettime();
+    size_t s;
+    int sample;
+
+    prog_buf = (struct prog_pixel *)bu_calloc(width*height, sizeof(struct prog_pixel), "prog_buf");
+    prog_first = a;
+    prog_last = b;
+    prog_deadline = 0;
+    if (progressive_budget > 0.0)
+	prog_deadline = start + (int64_t)(progressive_budget * 1.0e6);
+
+    /* start with about 16 samples across the frame */
+    prog_stride_max = 1;
+    while (prog_stride_max * 16 < width || prog_stride_max * 16 < height)
+	prog_stride_max <<= 1;
+
+    hypersample = 0;
+    for (s = prog_stride_max; s >= 1; s >>= 1) {
+	prog_stride = s;
+	prog_skip = (s < prog_stride_max);
+	if (rt_verbosity & VERBOSE_INCREMENTAL)
+	    bu_log("Progressive pass: 1 sample per %zux%zu pixels\n", s, s);
+	if (prog_pass(((width + s - 1) / s) * ((height + s - 1) / s)))
+	    goto out;
+    }
+
+    /* refine towards the requested hypersampling */
+    jitter |= JITTER_CELL;
+    prog_stride = 1;
+    prog_skip = 0;
+    for (sample = 1; sample <= save_hypersample; sample++) {
+	if (rt_verbosity & VERBOSE_INCREMENTAL)
+	    bu_log("Progressive pass: sample %d of %d per pixel\n", sample+1, save_hypersample+1);
+	if (prog_pass(width*height))
+	    goto out;
+    }
+
+out:
+    if (prog_deadline && bu_gettime() >= prog_deadline && (rt_verbosity & VERBOSE_INCREMENTAL))
+	bu_log("Progressive refinement stopped after %.2f seconds\n", (double)(bu_gettime() - start) / 1.0e6);
+
+    hypersample = save_hypersample;
+    jitter = save_jitter;
+    per_processor_chunk = save_chunk;
+    prog_stride = prog_stride_max = 0;
+    prog_deadline = 0;
+    bu_free(prog_buf, "prog_buf");
+    prog_buf = NULL;
+}
+
 /*
  * Local Variables:
  * mode: C
@@ -264,6 +264,26 @@ main(int ac, const char **av)
 	}
     }
 
+    /* PIX, BW and PNG files are converted a band of lines at a time,
+     * so images too large to hold in memory can still be converted.
+     * If the input can't be streamed (e.g. an interlaced PNG) fall
+     * back to reading it whole. */
+    if ((in_type == BU_MIME_IMAGE_PIX || in_type == BU_MIME_IMAGE_BW || in_type == BU_MIME_IMAGE_PNG) &&
+	(out_type == BU_MIME_IMAGE_PIX || out_type == BU_MIME_IMAGE_BW || out_type == BU_MIME_IMAGE_PNG)) {
+	icv_stream_t *in_s = icv_stream_open(bu_vls_addr(&in_path), in_type, width, height);
+	if (in_s) {
+	    size_t w, h;
+	    icv_stream_size(in_s, &w, &h, NULL);
+	    icv_stream_t *out_s = icv_stream_create(bu_vls_addr(&out_path), out_type, w, h);
+	    if (!out_s || icv_stream_copy(out_s, in_s) < 0)
+		ret = 1;
+	    if (out_s && icv_stream_close(out_s) < 0)
+		ret = 1;
+	    icv_stream_close(in_s);
+	    goto cleanup;
+	}
+    }
+
     img = icv_read(bu_vls_addr(&in_path), in_type, width, height);
     icv_write(img, bu_vls_addr(&out_path), out_type);
 
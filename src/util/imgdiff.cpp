@@ -208,6 +208,27 @@ main(int ac, const char **av)
 	}
     }
 
+    /* When only counting differences, PIX, BW and PNG files are
+     * compared a line at a time rather than loaded whole. */
+    if (!approx_diff && !out_path &&
+	(in_type_1 == BU_MIME_IMAGE_PIX || in_type_1 == BU_MIME_IMAGE_BW || in_type_1 == BU_MIME_IMAGE_PNG) &&
+	(in_type_2 == BU_MIME_IMAGE_PIX || in_type_2 == BU_MIME_IMAGE_BW || in_type_2 == BU_MIME_IMAGE_PNG)) {
+	icv_stream_t *s1 = icv_stream_open(img_path_1, in_type_1, width1, height1);
+	icv_stream_t *s2 = (s1) ? icv_stream_open(img_path_2, in_type_2, width2, height2) : NULL;
+	if (s1 && s2) {
+	    ret = icv_stream_diff(&matching, &off_by_1, &off_by_many, s1, s2);
+	    icv_stream_close(s1);
+	    icv_stream_close(s2);
+	    if (ret >= 0) {
+		bu_log("%d matching, %d off by 1, %d off by many\n", matching, off_by_1, off_by_many);
+		goto cleanup;
+	    }
+	    matching = off_by_1 = off_by_many = 0;
+	} else if (s1) {
+	    icv_stream_close(s1);
+	}
+    }
+
     img1 = icv_read(img_path_1, in_type_1, width1, height1);
     img2 = icv_read(img_path_2, in_type_2, width2, height2);
 